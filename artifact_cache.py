@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+"""Content-addressed cache for pipeline artifacts.
+
+Every artifact is fully determined by the code that made it and its inputs,
+so it is stored under
+
+  key = sha256(stage, build ID of the producing tool, seed, stage params,
+               keys of the artifacts it was made from)
+
+where a tool's build ID is the sha256 of its binary (so it tracks the
+sources and the compiler flags, and a visual-only change leaves the audio
+keys alone).  Stages:
+
+  audio     segment --repeat 6 WAV       segment build, audio seed, repeat
+  timeline  export_timeline .tl sidecar  export_timeline build, audio seed
+  feat      generate_frames .feat cache  generate_frames build, audio key
+  aac       encoded audio track          audio key, the caller's encode
+                                         params, ffmpeg version
+  video     final MP4                    generate_frames build, audio key,
+                                         tx hash (visual seed), the caller's
+                                         frame/encode params, ffmpeg version
+
+The audio seed is the argument segment was given.  That is the tx hash
+itself in generate_nft.sh, batch_steps.py and batch_daemon.py alike (the
+32-bit fold in batch_steps.py is bookkeeping only), so it defaults to the
+tx hash and generate_nft.sh and batch_daemon.py share a seed's audio and
+timeline objects.
+
+Objects live in <cache>/objects/<k[:2]>/<k>, read-only.  Both directions
+copy rather than hard-link: segment and ffmpeg -y truncate an existing
+output in place, which would rewrite a linked cache object.
+
+Usage (also imported by batch_daemon.py):
+  python3 artifact_cache.py fetch <stage> <tx_hash> <dest>   # exit 1 on miss
+  python3 artifact_cache.py store <stage> <tx_hash> <src>
+  python3 artifact_cache.py key   <stage> <tx_hash>
+  python3 artifact_cache.py stats
+Options: --cache DIR (default $NDB_CACHE or .artifact_cache), --repeat N,
+         --audio-seed S (default: the tx hash), --params STR (aac, video: how
+         the caller renders and encodes, e.g. its ffmpeg arguments)
+"""
+
+import argparse
+import hashlib
+import os
+import shutil
+import subprocess
+import sys
+import threading
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent
+TOOLS = {
+    "segment": ROOT / "src/c/bin/segment",
+    "export_timeline": ROOT / "src/c/bin/export_timeline",
+    "generate_frames": ROOT / "generate_frames",
+}
+DEFAULT_CACHE = Path(os.environ.get("NDB_CACHE", ROOT / ".artifact_cache"))
+REPEAT = 6  # loops in the shipped track (generate_nft.sh)
+STAGES = ("audio", "timeline", "feat", "aac", "video")
+
+
+def _sha256_file(path):
+    h = hashlib.sha256()
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(1 << 20), b""):
+            h.update(chunk)
+    return h.hexdigest()
+
+
+def _key(*parts):
+    h = hashlib.sha256()
+    for p in parts:
+        h.update(str(p).encode())
+        h.update(b"\0")
+    return h.hexdigest()
+
+
+class ArtifactCache:
+    def __init__(self, root=DEFAULT_CACHE, repeat=REPEAT):
+        self.root = Path(root)
+        self.repeat = repeat
+        self._ids = {}
+        self._encoder = None
+        self._lock = threading.Lock()
+
+    def build_id(self, tool):
+        """sha256 of the tool binary (None if it is not built)"""
+        with self._lock:
+            if tool not in self._ids:
+                path = TOOLS[tool]
+                self._ids[tool] = _sha256_file(path) if path.exists() else None
+            return self._ids[tool]
+
+    def encoder_id(self):
+        """ffmpeg's version line: a different encoder makes a different MP4"""
+        with self._lock:
+            if self._encoder is None:
+                try:
+                    r = subprocess.run(["ffmpeg", "-version"], capture_output=True, text=True)
+                    self._encoder = r.stdout.splitlines()[0] if r.returncode == 0 and r.stdout else ""
+                except OSError:
+                    self._encoder = ""
+            return self._encoder
+
+    def key(self, stage, tx, audio_seed=None, params=""):
+        """Cache key of `stage` for `tx`, or None when a producing tool is missing"""
+        seed = audio_seed or tx
+        if stage == "audio":
+            bid = self.build_id("segment")
+            return bid and _key("audio", bid, seed, self.repeat)
+        if stage == "timeline":
+            bid = self.build_id("export_timeline")
+            return bid and _key("timeline", bid, seed)
+        audio = self.key("audio", tx, audio_seed)
+        if stage == "aac":
+            return audio and _key("aac", audio, params, self.encoder_id())
+        bid = self.build_id("generate_frames")
+        if not (audio and bid):
+            return None
+        if stage == "feat":
+            return _key("feat", bid, audio)
+        if stage == "video":
+            return _key("video", bid, audio, tx, params, self.encoder_id())
+        raise ValueError(f"unknown stage {stage}")
+
+    def _object(self, key):
+        return self.root / "objects" / key[:2] / key
+
+    def fetch(self, stage, tx, dest, audio_seed=None, params=""):
+        """Place the cached artifact at `dest`; False on a miss"""
+        key = self.key(stage, tx, audio_seed, params)
+        if not key:
+            return False
+        obj = self._object(key)
+        if not obj.exists():
+            return False
+        dest = Path(dest)
+        dest.parent.mkdir(parents=True, exist_ok=True)
+        tmp = dest.with_name(dest.name + ".cache-part")
+        shutil.copyfile(obj, tmp)
+        os.replace(tmp, dest)
+        return True
+
+    def store(self, stage, tx, src, audio_seed=None, params=""):
+        """Add `src` as the artifact of `stage` for `tx`; returns its key"""
+        key = self.key(stage, tx, audio_seed, params)
+        if not key:
+            return None
+        obj = self._object(key)
+        if obj.exists():
+            return key
+        obj.parent.mkdir(parents=True, exist_ok=True)
+        tmp = obj.with_name(f"{obj.name}.{os.getpid()}.{threading.get_ident()}.part")
+        shutil.copyfile(src, tmp)
+        os.chmod(tmp, 0o444)
+        os.replace(tmp, obj)
+        return key
+
+    def stats(self):
+        objects = [p for p in (self.root / "objects").glob("*/*") if p.is_file()]
+        return len(objects), sum(p.stat().st_size for p in objects)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("command", choices=["fetch", "store", "key", "stats"])
+    ap.add_argument("stage", nargs="?", choices=STAGES)
+    ap.add_argument("tx", nargs="?", help="transaction hash (the seed argument)")
+    ap.add_argument("path", nargs="?", help="fetch destination / store source")
+    ap.add_argument("--cache", default=str(DEFAULT_CACHE), help="cache directory")
+    ap.add_argument("--repeat", type=int, default=REPEAT, help="loops in the audio track")
+    ap.add_argument("--audio-seed", help="seed given to segment, if not the tx hash")
+    ap.add_argument("--params", default="", help="aac, video: frame/encode settings in the key")
+    args = ap.parse_args()
+    cache = ArtifactCache(args.cache, args.repeat)
+
+    if args.command == "stats":
+        count, size = cache.stats()
+        print(f"📦 {cache.root}: {count} artifacts, {size / 1e6:.1f} MB")
+        return
+    if not args.stage or not args.tx:
+        ap.error(f"{args.command} needs <stage> <tx_hash>")
+    if args.command == "key":
+        key = cache.key(args.stage, args.tx, args.audio_seed, args.params)
+        if not key:
+            sys.exit(f"❌ {args.stage}: producing tool not built")
+        print(key)
+    elif args.command == "fetch":
+        if not args.path:
+            ap.error("fetch needs <dest>")
+        sys.exit(0 if cache.fetch(args.stage, args.tx, args.path, args.audio_seed, args.params) else 1)
+    else:
+        if not args.path:
+            ap.error("store needs <src>")
+        if not cache.store(args.stage, args.tx, args.path, args.audio_seed, args.params):
+            sys.exit(f"❌ {args.stage}: producing tool not built")
+
+
+if __name__ == "__main__":
+    main()
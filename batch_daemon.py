@@ -0,0 +1,469 @@
+#!/usr/bin/env python3
+"""Pipelined mint-run batch service with checkpoint/resume.
+
+Takes a CSV of transaction hashes (first column, as batch_steps.py; the
+seed manifest from blockchain/export_seeds.js works as is) and renders
+every token on two worker pools:
+
+  audio   segment --repeat 6 <seed> <out.wav>          (one core per job)
+  video   generate_frames --pipe-y4m | ffmpeg -> mp4   (renderer + x264)
+          then the metadata JSON (generate_frames --metadata-only:
+          durations, frame count and traits from generator/renderer state)
+
+Audio jobs are queued in CSV order and each finished WAV is handed to the
+video pool at once, so token N's frames/encode run while token N+1..N+k are
+being synthesised.  Every process writes to an explicit per-token path (no
+globbing of a shared working directory), outputs are written under a
+temporary name and renamed when complete, and each finished stage is
+appended to <out>/checkpoint.jsonl.  Re-running the same command after a
+crash or Ctrl-C skips the tokens that are done and resumes the others from
+their last completed stage.
+
+With the artifact cache (artifact_cache.py, on unless --no-cache) a stage
+whose inputs are unchanged is not run at all: the WAV, the .feat analysis
+cache and the MP4 are copied from the cache, so after a visual-only change
+only frames and encode are redone.
+
+--loop-periodic renders only the first audio loop of frames
+(generate_frames --loop-periodic), encodes it once and repeats the encoded
+clip across the track with ffmpeg -stream_loop / -c:v copy: about 1/6 of
+the frame and x264 work, at the cost of state (projectiles, hue drift)
+restarting at every loop point.
+
+--preview is the QA mode: no MP4 and no ffmpeg.  Each token gets a
+contact sheet of its beat keyframes (<tx>_sheet.ppm, only the keyframes
+are drawn) and a one-loop 400x300 / 15 fps GIF (<tx>_preview.gif), both
+from a single generate_frames run, for scrubbing a whole batch quickly.
+
+Metrics (render_metrics.py): tokens done and per minute, per-stage job
+latency histograms, pool queue depth and busy workers, cache hits, bytes
+written, and the frame pipeline's own profiler stages and counters (each
+generate_frames run reports through --metrics).  <out>/metrics.json is
+rewritten every --metrics-interval seconds; --metrics-listen also serves
+them as Prometheus text on GET /metrics.
+
+Usage:
+  python3 batch_daemon.py input/seeds.csv [--out batch_output]
+                          [--audio-workers N] [--video-workers N]
+                          [--max-count N] [--timeout SEC] [--retry-failed]
+                          [--cache DIR | --no-cache] [--loop-periodic | --preview]
+                          [--metrics-listen 127.0.0.1:9464] [--metrics-interval SEC]
+"""
+
+import argparse
+import json
+import os
+import shutil
+import signal
+import subprocess
+import sys
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from datetime import datetime, timezone
+from pathlib import Path
+
+from artifact_cache import DEFAULT_CACHE, ArtifactCache
+from batch_steps import read_tx_hashes
+from render_metrics import Metrics
+
+ROOT = Path(__file__).resolve().parent
+SEGMENT = ROOT / "src/c/bin/segment"
+GENERATE_FRAMES = ROOT / "generate_frames"
+REPEAT = 6  # loops in the shipped track (generate_nft.sh)
+ENCODE_ARGS = ["-c:v", "libx264", "-c:a", "aac", "-pix_fmt", "yuv420p", "-shortest"]
+# How the MP4 is made, for its cache key: Y4M from the renderer, these args
+VIDEO_PARAMS = " ".join(["y4m"] + ENCODE_ARGS)
+# --loop-periodic: encode one loop, then repeat the encoded clip under the track
+LOOP_ENCODE_ARGS = ["-c:v", "libx264", "-pix_fmt", "yuv420p"]
+LOOP_MUX_ARGS = ["-map", "0:v:0", "-map", "1:a:0", "-c:v", "copy", "-c:a", "aac", "-shortest"]
+LOOP_VIDEO_PARAMS = " ".join(["y4m-loop"] + LOOP_ENCODE_ARGS + LOOP_MUX_ARGS)
+# --preview: one loop at preview size and rate; the GIF takes the frames as they are
+PREVIEW_ARGS = ["--format", "400x300@15", "--preview-scale", "1", "--loop-periodic"]
+
+
+class Checkpoint:
+    """Append-only journal of finished stages, safe to share between threads"""
+
+    def __init__(self, path):
+        self.path = path
+        self.lock = threading.Lock()
+        self.state = {}  # tx -> {"audio": bool, "video": bool, "failed": stage or None}
+        if path.exists():
+            with open(path) as f:
+                for line in f:
+                    try:
+                        rec = json.loads(line)
+                    except json.JSONDecodeError:
+                        continue  # torn last line from a crash
+                    st = self.state.setdefault(rec["tx"], {"audio": False, "video": False, "failed": None})
+                    if rec.get("ok"):
+                        st[rec["stage"]] = True
+                        st["failed"] = None
+                    else:
+                        st["failed"] = rec["stage"]
+
+    def get(self, tx):
+        with self.lock:
+            return dict(self.state.get(tx, {"audio": False, "video": False, "failed": None}))
+
+    def record(self, tx, stage, ok, **extra):
+        rec = {"tx": tx, "stage": stage, "ok": ok,
+               "t": datetime.now(timezone.utc).isoformat(timespec="seconds"), **extra}
+        with self.lock:
+            st = self.state.setdefault(tx, {"audio": False, "video": False, "failed": None})
+            if ok:
+                st[stage] = True
+                st["failed"] = None
+            else:
+                st["failed"] = stage
+            with open(self.path, "a") as f:
+                f.write(json.dumps(rec) + "\n")
+                f.flush()
+                os.fsync(f.fileno())
+
+
+class Batch:
+    def __init__(self, args, out):
+        self.args = args
+        self.out = out
+        self.logs = out / "logs"
+        self.logs.mkdir(parents=True, exist_ok=True)
+        self.ckpt = Checkpoint(out / "checkpoint.jsonl")
+        self.cache = None if args.no_cache else ArtifactCache(args.cache, REPEAT)
+        self.video_params = LOOP_VIDEO_PARAMS if args.loop_periodic else VIDEO_PARAMS
+        # The stage that finishes a token, and its output
+        self.final = ("preview", "gif") if args.preview else ("video", "video")
+        self.stopping = threading.Event()
+        self.procs = set()
+        self.procs_lock = threading.Lock()
+        self.done = 0
+        self.failed = 0
+        self.total = 0
+        self.t0 = time.perf_counter()
+        self.print_lock = threading.Lock()
+        self.metrics = Metrics()
+
+    def paths(self, tx):
+        d = self.out / tx
+        return {"dir": d, "wav": d / f"{tx}_audio.wav", "video": d / f"{tx}_final.mp4",
+                "meta": d / f"{tx}_metadata.json", "gif": d / f"{tx}_preview.gif",
+                "sheet": d / f"{tx}_sheet.ppm"}
+
+    def log(self, msg):
+        with self.print_lock:
+            print(msg, flush=True)
+
+    def finish(self, tx, ok, what, sec):
+        """Count a token as done or failed and print its progress line"""
+        self.metrics.token_done(ok)
+        with self.print_lock:
+            if ok:
+                self.done += 1
+            else:
+                self.failed += 1
+            elapsed = time.perf_counter() - self.t0
+            finished = self.done + self.failed
+            eta = elapsed / finished * (self.total - finished) if finished else 0
+            print(f"   [{finished}/{self.total}] {what} {tx[:18]} ({sec:.1f}s, ETA {eta / 60:.1f} min)", flush=True)
+
+    def fetch(self, kind, tx, dest, **kw):
+        """Artifact cache lookup, counted as a hit or a miss"""
+        hit = self.cache.fetch(kind, tx, dest, **kw)
+        self.metrics.inc("cache_requests_total", artifact=kind, result="hit" if hit else "miss")
+        return hit
+
+    def wrote(self, artifact, *paths):
+        for path in paths:
+            try:
+                self.metrics.inc("bytes_written_total", path.stat().st_size, artifact=artifact)
+            except OSError:
+                pass
+
+    def submit(self, pool, name, job, tx):
+        """Queue job(tx) on a pool, tracking queue depth and busy workers"""
+        self.metrics.add("queue_depth", 1, pool=name)
+        return pool.submit(self.pooled, name, job, tx)
+
+    def pooled(self, name, job, tx):
+        m = self.metrics
+        m.add("queue_depth", -1, pool=name)
+        m.add("workers_busy", 1, pool=name)
+        t0 = time.perf_counter()
+        try:
+            return job(tx)
+        finally:
+            m.add("workers_busy", -1, pool=name)
+            m.inc("worker_busy_seconds_total", time.perf_counter() - t0, pool=name)
+
+    def run(self, cmds, log_path, timeout, append=False):
+        """Run a pipeline of commands (each stdout into the next); True if all exit 0"""
+        with open(log_path, "ab" if append else "wb") as log:
+            procs = []
+            stdin = subprocess.DEVNULL
+            for i, cmd in enumerate(cmds):
+                last = i == len(cmds) - 1
+                p = subprocess.Popen([str(c) for c in cmd], stdin=stdin,
+                                     stdout=subprocess.DEVNULL if last else subprocess.PIPE,
+                                     stderr=log, start_new_session=True)
+                if procs:
+                    procs[-1].stdout.close()  # the next stage owns the read end
+                procs.append(p)
+                stdin = p.stdout
+            with self.procs_lock:
+                self.procs.update(procs)
+            ok = True
+            deadline = time.monotonic() + timeout if timeout else None
+            try:
+                for p in procs:
+                    left = None if deadline is None else max(0.1, deadline - time.monotonic())
+                    try:
+                        if p.wait(timeout=left) != 0:
+                            ok = False
+                    except subprocess.TimeoutExpired:
+                        log.write(f"\n[batch_daemon] timeout after {timeout}s\n".encode())
+                        ok = False
+                        for q in procs:
+                            q.kill()
+                        for q in procs:
+                            q.wait()
+                        break
+            finally:
+                with self.procs_lock:
+                    self.procs.difference_update(procs)
+        return ok and not self.stopping.is_set()
+
+    def audio_job(self, tx):
+        if self.stopping.is_set():
+            return False
+        p = self.paths(tx)
+        p["dir"].mkdir(parents=True, exist_ok=True)
+        part = p["wav"].with_name(p["wav"].name + ".part")
+        t0 = time.perf_counter()
+        if self.cache and self.fetch("audio", tx, p["wav"]):
+            self.ckpt.record(tx, "audio", True, sec=round(time.perf_counter() - t0, 3), cached=True)
+            return True
+        ok = self.run([[SEGMENT, "--repeat", REPEAT, tx, part]],
+                      self.logs / f"{tx}.audio.log", self.args.timeout)
+        if ok and part.exists():
+            os.replace(part, p["wav"])
+            self.wrote("wav", p["wav"])
+            if self.cache:
+                self.cache.store("audio", tx, p["wav"])
+        else:
+            part.unlink(missing_ok=True)
+            ok = False
+        if not self.stopping.is_set():
+            sec = time.perf_counter() - t0
+            self.metrics.observe("stage_seconds", sec, stage="audio")
+            self.ckpt.record(tx, "audio", ok, sec=round(sec, 3))
+        return ok
+
+    def video_job(self, tx):
+        if self.stopping.is_set():
+            return False
+        p = self.paths(tx)
+        part = p["video"].with_name(p["video"].name + ".part")
+        feat = p["wav"].with_name(p["wav"].name + ".feat")
+        t0 = time.perf_counter()
+        log = self.logs / f"{tx}.video.log"
+        if self.cache and self.fetch("video", tx, p["video"], params=self.video_params):
+            ok = self.write_metadata(tx, p, log)
+            sec = time.perf_counter() - t0
+            self.ckpt.record(tx, "video", ok, sec=round(sec, 3), cached=True)
+            self.finish(tx, ok, "♻️ " if ok else f"❌ metadata (see logs/{tx}.video.log)", sec)
+            return ok
+
+        # Reuse the WAV analysis when cached, else have this run write it
+        metrics = self.logs / f"{tx}.frames.metrics.json"
+        frames = [GENERATE_FRAMES, p["wav"], tx, "--pipe-y4m", "--metrics", metrics]
+        have_feat = self.cache is not None and self.fetch("feat", tx, feat)
+        if self.cache and not have_feat:
+            frames.append("--dump-features")
+        ffmpeg = ["ffmpeg", "-hide_banner", "-loglevel", "error", "-y"]
+        if self.args.loop_periodic:
+            loop = p["video"].with_name(p["video"].name + ".loop.part")
+            frames.append("--loop-periodic")
+            encode = [*ffmpeg, "-f", "yuv4mpegpipe", "-i", "-", *LOOP_ENCODE_ARGS, "-f", "mp4", loop]
+            mux = [*ffmpeg, "-stream_loop", "-1", "-i", loop, "-i", p["wav"], *LOOP_MUX_ARGS, "-f", "mp4", part]
+            self.metrics.watch(tx, metrics)
+            ok = self.run([frames, encode], log, self.args.timeout)
+            self.metrics.unwatch(tx)
+            ok = ok and self.run([mux], log, self.args.timeout, append=True)
+            loop.unlink(missing_ok=True)
+        else:
+            encode = [*ffmpeg, "-f", "yuv4mpegpipe", "-i", "-", "-i", p["wav"], *ENCODE_ARGS, "-f", "mp4", part]
+            self.metrics.watch(tx, metrics)
+            ok = self.run([frames, encode], log, self.args.timeout)
+            self.metrics.unwatch(tx)
+        if ok and part.exists() and part.stat().st_size > 0:
+            os.replace(part, p["video"])
+            self.wrote("mp4", p["video"])
+            ok = self.write_metadata(tx, p, log)
+            if ok and self.cache:
+                self.cache.store("video", tx, p["video"], params=self.video_params)
+                if not have_feat and feat.exists():
+                    self.cache.store("feat", tx, feat)
+        else:
+            part.unlink(missing_ok=True)
+            ok = False
+        sec = time.perf_counter() - t0
+        if self.stopping.is_set():
+            return False
+        self.metrics.observe("stage_seconds", sec, stage="video")
+        self.ckpt.record(tx, "video", ok, sec=round(sec, 3))
+        self.finish(tx, ok, "✅" if ok else f"❌ video (see logs/{tx}.video.log)", sec)
+        return ok
+
+    def preview_job(self, tx):
+        if self.stopping.is_set():
+            return False
+        p = self.paths(tx)
+        gif = p["gif"].with_name(p["gif"].name + ".part")
+        sheet = p["sheet"].with_name(p["sheet"].name + ".part")
+        t0 = time.perf_counter()
+        metrics = self.logs / f"{tx}.frames.metrics.json"
+        frames = [GENERATE_FRAMES, p["wav"], tx, *PREVIEW_ARGS, "--preview", gif, "--contact-sheet", sheet,
+                  "--metrics", metrics]
+        self.metrics.watch(tx, metrics)
+        ok = self.run([frames], self.logs / f"{tx}.preview.log", self.args.timeout)
+        self.metrics.unwatch(tx)
+        if ok and gif.exists() and sheet.exists():
+            os.replace(sheet, p["sheet"])
+            os.replace(gif, p["gif"])
+            self.wrote("gif", p["gif"])
+            self.wrote("sheet", p["sheet"])
+        else:
+            gif.unlink(missing_ok=True)
+            sheet.unlink(missing_ok=True)
+            ok = False
+        sec = time.perf_counter() - t0
+        if self.stopping.is_set():
+            return False
+        self.metrics.observe("stage_seconds", sec, stage="preview")
+        self.ckpt.record(tx, "preview", ok, sec=round(sec, 3))
+        self.finish(tx, ok, "🖼️ " if ok else f"❌ preview (see logs/{tx}.preview.log)", sec)
+        return ok
+
+    def write_metadata(self, tx, p, log):
+        """The metadata JSON: counts and traits from the generator and renderer, no ffprobe"""
+        cmd = [GENERATE_FRAMES, p["wav"], tx, "--metadata-only", "--metadata", p["meta"],
+               "--video", p["video"]]
+        return self.run([cmd], log, self.args.timeout, append=True)
+
+    def stop(self, *_):
+        if not self.stopping.is_set():
+            self.log("🛑 Stopping: finished stages are checkpointed, re-run to resume")
+        self.stopping.set()
+        with self.procs_lock:
+            for p in self.procs:
+                try:
+                    os.killpg(p.pid, signal.SIGTERM)
+                except ProcessLookupError:
+                    pass
+
+    def go(self, tx_hashes):
+        pending_audio, pending_video = [], []
+        skipped = 0
+        for tx in tx_hashes:
+            st = self.ckpt.get(tx)
+            p = self.paths(tx)
+            if st["failed"] and not self.args.retry_failed:
+                skipped += 1
+                continue
+            stage, out = self.final
+            if st.get(stage) and p[out].exists():
+                self.done += 1
+            elif st["audio"] and p["wav"].exists():
+                pending_video.append(tx)
+            else:
+                pending_audio.append(tx)
+        self.total = len(tx_hashes) - skipped
+        self.metrics.set("tokens_planned", self.total)
+        self.metrics.set("workers", self.args.audio_workers, pool="audio")
+        self.metrics.set("workers", self.args.video_workers, pool="video")
+        self.log(f"📊 {self.total} tokens: {self.done} done, {len(pending_video)} with audio, "
+                 f"{len(pending_audio)} to synthesise" + (f", {skipped} failed earlier (--retry-failed)" if skipped else ""))
+
+        video_job = self.preview_job if self.args.preview else self.video_job
+        with ThreadPoolExecutor(self.args.audio_workers, thread_name_prefix="audio") as audio_pool, \
+             ThreadPoolExecutor(self.args.video_workers, thread_name_prefix="video") as video_pool:
+            video_futs = [self.submit(video_pool, "video", video_job, tx) for tx in pending_video]
+            audio_futs = {self.submit(audio_pool, "audio", self.audio_job, tx): tx for tx in pending_audio}
+            # Hand each WAV to the video pool as soon as it exists
+            for fut in as_completed(audio_futs):
+                tx = audio_futs[fut]
+                if self.stopping.is_set():
+                    continue
+                if fut.result():
+                    video_futs.append(self.submit(video_pool, "video", video_job, tx))
+                else:
+                    self.finish(tx, False, f"❌ audio (see logs/{tx}.audio.log)", 0.0)
+            for fut in as_completed(video_futs):
+                fut.result()
+
+
+def main():
+    cores = os.cpu_count() or 1
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("csv", help="CSV of transaction hashes (first column)")
+    ap.add_argument("--out", default="batch_output", help="output directory (one subdirectory per token)")
+    ap.add_argument("--audio-workers", type=int, default=max(1, cores // 4),
+                    help="parallel segment jobs (default: cores/4)")
+    ap.add_argument("--video-workers", type=int, default=max(1, cores // 2),
+                    help="parallel frame+encode jobs (default: cores/2; each also runs x264)")
+    ap.add_argument("--max-count", type=int, help="only the first N hashes")
+    ap.add_argument("--timeout", type=float, default=1800, help="per-job timeout in seconds (0: none)")
+    ap.add_argument("--retry-failed", action="store_true", help="retry tokens whose last attempt failed")
+    ap.add_argument("--cache", default=str(DEFAULT_CACHE), help="artifact cache directory")
+    ap.add_argument("--no-cache", action="store_true", help="always run every stage")
+    ap.add_argument("--loop-periodic", action="store_true",
+                    help="render and encode one audio loop of frames, repeat it across the track")
+    ap.add_argument("--preview", action="store_true",
+                    help="QA previews instead of MP4s: beat contact sheet + one-loop GIF, no ffmpeg")
+    ap.add_argument("--metrics-listen", metavar="HOST:PORT",
+                    help="serve Prometheus metrics on GET /metrics (e.g. 127.0.0.1:9464)")
+    ap.add_argument("--metrics-interval", type=float, default=10,
+                    help="seconds between <out>/metrics.json snapshots")
+    args = ap.parse_args()
+    if args.preview and args.loop_periodic:
+        ap.error("--preview already renders one loop; drop --loop-periodic")
+
+    for tool in (SEGMENT, GENERATE_FRAMES):
+        if not tool.exists():
+            sys.exit(f"❌ {tool} not found (make c-build generate_frames)")
+    if not args.preview and not shutil.which("ffmpeg"):
+        sys.exit("❌ ffmpeg not found")
+
+    tx_hashes = read_tx_hashes(args.csv)
+    if args.max_count:
+        tx_hashes = tx_hashes[:args.max_count]
+    out = Path(args.out)
+    out.mkdir(parents=True, exist_ok=True)
+
+    print("🎨 NotDeafBeef Batch Service")
+    print("===========================")
+    print(f"📋 Input CSV: {args.csv}")
+    print(f"📁 Output: {out}")
+    print(f"⚙️  Workers: {args.audio_workers} audio, {args.video_workers} video ({cores} cores)")
+
+    batch = Batch(args, out)
+    signal.signal(signal.SIGINT, batch.stop)
+    signal.signal(signal.SIGTERM, batch.stop)
+    if args.metrics_listen:
+        batch.metrics.serve(args.metrics_listen)
+        print(f"📈 Metrics: http://{args.metrics_listen}/metrics")
+    metrics_done = threading.Event()
+    snapshots = batch.metrics.write_every(out / "metrics.json", args.metrics_interval, metrics_done)
+    batch.go(tx_hashes)
+    metrics_done.set()
+    snapshots.join()
+
+    wall = time.perf_counter() - batch.t0
+    print(f"🎉 {batch.done} done, {batch.failed} failed in {wall / 60:.1f} min -> {out}")
+    if batch.stopping.is_set() or batch.failed:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
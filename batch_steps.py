@@ -9,37 +9,50 @@ import json
 from pathlib import Path
 from datetime import datetime
 
+import nd_api
+
+# libnotdeafbeef.so (make libnotdeafbeef.so): seeds and segments in this
+# process; without it each step runs the binaries
+IN_PROCESS = nd_api.available()
+
 def hash_to_32bit(tx_hash):
-    """Convert long transaction hash to 32-bit seed (same as C function)"""
-    hex_start = tx_hash[2:] if tx_hash.startswith('0x') else tx_hash
+    """The 32-bit visual seed of a transaction hash (ndb_seed_t.visual in
+    src/c/src/seed.c): the value's 32-bit words XORed together, 0 -> 0xDEADBEEF.
+    Only bookkeeping: every binary takes the tx hash itself."""
+    if IN_PROCESS:
+        return nd_api.visual_seed(tx_hash)
+    if tx_hash[:2] in ('0x', '0X'):
+        value = int(tx_hash[2:], 16)
+    else:
+        value = int(tx_hash) if tx_hash.isdigit() else int(tx_hash, 16)
     
     seed = 0
-    # XOR all 8-character chunks together
-    for i in range(0, len(hex_start), 8):
-        chunk = hex_start[i:i+8]
-        if chunk:
-            chunk_val = int(chunk, 16) if chunk else 0
-            seed ^= chunk_val
-    
-    # Avoid degenerate case
-    if seed == 0:
-        seed = 0xDEADBEEF
-    
-    return f"0x{seed:08x}"
-
-def step1_hash_seeds(input_csv, run_id, output_base):
-    """Step 1: Convert long hashes to 32-bit hashes"""
-    print("🔨 Step 1: Hashing transaction hashes to 32-bit seeds")
+    while value:
+        seed ^= value & 0xFFFFFFFF
+        value >>= 32
     
-    # Read input CSV
+    return f"0x{seed or 0xDEADBEEF:08x}"
+
+def read_tx_hashes(csv_path):
+    """Transaction hashes from the first CSV column (header row optional)"""
     tx_hashes = []
-    with open(input_csv, 'r') as f:
+    with open(csv_path, 'r') as f:
         reader = csv.reader(f)
         for i, row in enumerate(reader):
+            if not row:
+                continue
             if i == 0 and ('transaction' in row[0].lower() or 'hash' in row[0].lower()):
                 continue  # Skip header
-            if row and row[0].strip():
+            if row[0].strip():
                 tx_hashes.append(row[0].strip())
+    return tx_hashes
+
+def step1_hash_seeds(input_csv, run_id, output_base):
+    """Step 1: Convert long hashes to 32-bit hashes"""
+    print("🔨 Step 1: Hashing transaction hashes to 32-bit seeds")
+    
+    # Read input CSV
+    tx_hashes = read_tx_hashes(input_csv)
     
     # Create hashed CSV in output directory
     hashes_dir = output_base / "hashes"
@@ -59,60 +72,6 @@ def step1_hash_seeds(input_csv, run_id, output_base):
     print(f"   📊 Processed {len(tx_hashes)} transaction hashes")
     return hash_csv, tx_hashes
 
-def step2_generate_segments(hash_csv, run_id):
-    """Step 2: Generate audio segments"""
-    print("🎵 Step 2: Generating audio segments")
-    
-    # Read hash mapping
-    hash_mappings = []
-    with open(hash_csv, 'r') as f:
-        reader = csv.DictReader(f)
-        hash_mappings = list(reader)
-    
-    wav_run_dir = Path("wav") / f"run_{run_id}"
-    wav_run_dir.mkdir(parents=True, exist_ok=True)
-    
-    successful = 0
-    for mapping in hash_mappings:
-        original_hash = mapping['original_hash']
-        hashed_seed = mapping['hashed_seed']
-        
-        print(f"🎼 Generating segment for {original_hash} (seed: {hashed_seed})")
-        
-        # Create directory for this hash
-        hash_dir = wav_run_dir / original_hash
-        hash_dir.mkdir(exist_ok=True)
-        
-        # Generate segment
-        try:
-            result = subprocess.run(
-                ["src/c/bin/segment", original_hash],  # Use full hash for audio
-                cwd=Path.cwd(),
-                capture_output=True,
-                text=True,
-                timeout=30
-            )
-            
-            if result.returncode == 0:
-                # Find generated segment file
-                segment_files = list(Path.cwd().glob("seed_0x*.wav"))
-                if segment_files:
-                    segment_file = segment_files[0]
-                    target_file = hash_dir / f"{original_hash}-segment.wav"
-                    segment_file.rename(target_file)
-                    print(f"   ✅ {target_file}")
-                    successful += 1
-                else:
-                    print(f"   ❌ No segment file generated")
-            else:
-                print(f"   ❌ Segment generation failed: {result.stderr}")
-                
-        except Exception as e:
-            print(f"   💥 Exception: {e}")
-    
-    print(f"✅ Generated {successful}/{len(hash_mappings)} audio segments")
-    return successful
-
 def step3_concatenate_audio(run_id, output_base):
     """Step 3: Concatenate audio segments"""
     print("🔄 Step 3: Concatenating audio segments")
@@ -358,15 +317,7 @@ def main():
         sys.exit(1)
     
     # Read and limit input
-    with open(csv_file, 'r') as f:
-        reader = csv.reader(f)
-        all_hashes = []
-        for i, row in enumerate(reader):
-            if i == 0 and ('transaction' in row[0].lower() or 'hash' in row[0].lower()):
-                continue
-            if row and row[0].strip():
-                all_hashes.append(row[0].strip())
-    
+    all_hashes = read_tx_hashes(csv_file)
     tx_hashes = all_hashes[:max_count]
     print(f"📊 Processing {len(tx_hashes)} out of {len(all_hashes)} available hashes")
     print()
@@ -411,58 +362,53 @@ def step2_generate_segments(run_id, tx_hashes, output_base):
     wav_run_dir = output_base / "wav" / f"run_{run_id}"
     wav_run_dir.mkdir(parents=True, exist_ok=True)
     
-    successful = 0
-    
+    # Render every hash in this process (nd_api), else build one
+    # "<tx hash> <out.wav>" list for a single segment process
+    targets = []
+    batch_lines = []
     for original_hash in tx_hashes:
-        print(f"🎼 Generating segment for {original_hash}")
-        
-        # Create directory for this hash
         hash_dir = wav_run_dir / original_hash
         hash_dir.mkdir(exist_ok=True)
-        
+        target_file = hash_dir / f"{original_hash}-segment.wav"
+        if target_file.exists():
+            target_file.unlink()
+        targets.append((original_hash, target_file))
+        batch_lines.append(f"{original_hash} {target_file.resolve()}\n")
+    
+    if IN_PROCESS:
+        # One loop per hash straight into a reused buffer, no segment process
+        buf = bytearray()
+        for original_hash, target_file in targets:
+            try:
+                size = nd_api.plan(original_hash, 1).wav_bytes
+                if len(buf) < size:
+                    buf = bytearray(size)
+                target_file.write_bytes(nd_api.render_audio(original_hash, 1, out=buf))
+            except (ValueError, RuntimeError) as e:
+                print(f"   💥 Exception: {e}")
+    else:
         try:
-            # Generate segment using 32-bit hashed seed (C can't parse long hex strings)
-            hashed_seed = hash_to_32bit(original_hash)
             result = subprocess.run(
-                ["src/c/bin/segment", hashed_seed],
+                ["src/c/bin/segment", "--batch", "-"],
                 cwd=Path.cwd(),
+                input="".join(batch_lines),
                 capture_output=True,
                 text=True,
-                timeout=30
+                timeout=30 * max(1, len(tx_hashes))
             )
-            
-            if result.returncode == 0:
-                # Find the specific segment file generated for this hashed seed
-                # Use the 32-bit hashed seed for filename (what the C program actually creates)
-                expected_seed = hashed_seed.lower()
-                if expected_seed.startswith('0x'):
-                    expected_seed = expected_seed[2:]  # Remove 0x prefix
-                
-                expected_filename = f"seed_0x{expected_seed}.wav"
-                segment_file = Path.cwd() / expected_filename
-                
-                if segment_file.exists():
-                    target_file = hash_dir / f"{original_hash}-segment.wav"
-                    segment_file.rename(target_file)
-                    print(f"   ✅ {target_file}")
-                    successful += 1
-                else:
-                    # Fallback: look for any seed file (but this indicates a problem)
-                    segment_files = list(Path.cwd().glob("seed_0x*.wav"))
-                    if segment_files:
-                        print(f"   ⚠️  Expected {expected_filename}, found {segment_files[0].name}")
-                        segment_file = segment_files[0]
-                        target_file = hash_dir / f"{original_hash}-segment.wav"
-                        segment_file.rename(target_file)
-                        successful += 1
-                    else:
-                        print(f"   ❌ No segment file generated")
-            else:
+            if result.returncode != 0:
                 print(f"   ❌ Generation failed: {result.stderr[:100]}...")
-                
         except Exception as e:
             print(f"   💥 Exception: {e}")
     
+    successful = 0
+    for original_hash, target_file in targets:
+        if target_file.exists():
+            print(f"   ✅ {target_file}")
+            successful += 1
+        else:
+            print(f"   ❌ No segment file generated for {original_hash}")
+    
     print(f"✅ Generated {successful}/{len(tx_hashes)} segments")
     return successful
 
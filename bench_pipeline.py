@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+"""End-to-end pipeline benchmark and regression gate.
+
+Runs the generate_nft.sh pipeline for a fixed set of seeds and records, for
+every stage, wall time, CPU time, peak RSS and bytes written to disk:
+
+  plan      transaction hash -> 32-bit seed (batch_steps.hash_to_32bit)
+  audio     segment: one loop
+  extend    segment --repeat 6: the full track generate_nft.sh ships
+  timeline  export_timeline: the event sidecar
+  frames    generate_frames over the full track
+  encode    ffmpeg libx264/aac, as in generate_nft.sh (skipped without ffmpeg)
+  metadata  the NFT metadata JSON
+
+Each external stage runs as one child process and is measured with
+os.wait4, so the RSS and CPU figures are that process's alone.  Results go
+to a JSON file; with --baseline the run fails (exit 1) when a stage's median
+wall time or the seeds per core-hour regress by more than --tolerance.
+
+Usage:
+  python3 bench_pipeline.py [--seeds S1,S2,...] [--out bench.json]
+                            [--baseline old.json] [--tolerance 0.10]
+                            [--frames N] [--threads N] [--keep DIR]
+"""
+
+import argparse
+import json
+import os
+import platform
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from datetime import datetime, timezone
+from pathlib import Path
+
+from batch_steps import hash_to_32bit
+
+ROOT = Path(__file__).resolve().parent
+SEGMENT = ROOT / "src/c/bin/segment"
+EXPORT_TIMELINE = ROOT / "src/c/bin/export_timeline"
+GENERATE_FRAMES = ROOT / "generate_frames"
+DEFAULT_SEEDS = ["0xcafebabe", "0xdeadbeef", "0x1", "12345"]
+STAGES = ["plan", "audio", "extend", "timeline", "frames", "encode", "metadata"]
+REPEAT = 6  # loops in the shipped track (generate_nft.sh)
+
+
+def dir_bytes(path):
+    """Total size of the regular files under `path`"""
+    return sum(p.stat().st_size for p in Path(path).rglob("*") if p.is_file())
+
+
+def run_stage(cmd, cwd, out_dir):
+    """Run one stage as a child process; return its measurements"""
+    before = dir_bytes(out_dir)
+    t0 = time.perf_counter()
+    with open(os.devnull, "wb") as devnull, tempfile.TemporaryFile() as errf:
+        proc = subprocess.Popen([str(c) for c in cmd], cwd=cwd, stdout=devnull, stderr=errf)
+        _, status, usage = os.wait4(proc.pid, 0)
+        proc.returncode = os.waitstatus_to_exitcode(status)
+        errf.seek(0)
+        err = errf.read().decode(errors="replace")
+    wall = time.perf_counter() - t0
+    if proc.returncode != 0:
+        raise RuntimeError(f"{Path(str(cmd[0])).name} exited {proc.returncode}: {err.strip()[-400:]}")
+    # ru_maxrss is KiB on Linux, bytes on macOS
+    rss_kb = usage.ru_maxrss // 1024 if sys.platform == "darwin" else usage.ru_maxrss
+    return {
+        "wall_sec": round(wall, 4),
+        "cpu_sec": round(usage.ru_utime + usage.ru_stime, 4),
+        "peak_rss_kb": rss_kb,
+        "bytes_written": dir_bytes(out_dir) - before,
+    }
+
+
+def probe_duration(path):
+    """Media duration in seconds via ffprobe, or None"""
+    if not shutil.which("ffprobe"):
+        return None
+    r = subprocess.run(["ffprobe", "-v", "quiet", "-show_entries", "format=duration",
+                        "-of", "csv=p=0", str(path)], capture_output=True, text=True)
+    try:
+        return float(r.stdout.strip())
+    except ValueError:
+        return None
+
+
+def bench_seed(seed, work, args):
+    """All stages for one seed in its own directory under `work`"""
+    out = work / seed
+    out.mkdir(parents=True)
+    stages = {}
+
+    t0 = time.perf_counter()
+    hashed = hash_to_32bit(seed)
+    stages["plan"] = {"wall_sec": round(time.perf_counter() - t0, 6), "cpu_sec": None,
+                      "peak_rss_kb": None, "bytes_written": 0}
+
+    loop_wav = out / f"{seed}_segment.wav"
+    long_wav = out / f"{seed}_audio.wav"
+    stages["audio"] = run_stage([SEGMENT, seed, loop_wav], out, out)
+    stages["extend"] = run_stage([SEGMENT, "--repeat", REPEAT, seed, long_wav], out, out)
+    # Not <audio>.tl: generate_frames would pick it up and the frames stage
+    # would no longer match what generate_nft.sh renders
+    stages["timeline"] = run_stage([EXPORT_TIMELINE, seed, out / f"{seed}.tl"], out, out)
+
+    frames_dir = out / "frames"
+    frames_dir.mkdir()
+    cmd = [args.generate_frames, long_wav, seed]
+    if args.frames:
+        cmd.append(args.frames)
+    if args.threads:
+        cmd += ["--threads", args.threads]
+    stages["frames"] = run_stage(cmd, frames_dir, out)
+    frame_count = len(list(frames_dir.glob("frame_*.ppm")))
+
+    video = out / f"{seed}_final.mp4"
+    if shutil.which("ffmpeg"):
+        stages["encode"] = run_stage(["ffmpeg", "-y", "-r", "60", "-i", "frame_%04d.ppm", "-i", long_wav,
+                                      "-c:v", "libx264", "-c:a", "aac", "-pix_fmt", "yuv420p",
+                                      "-shortest", video], frames_dir, out)
+    else:
+        stages["encode"] = {"skipped": "ffmpeg not found"}
+
+    t0 = time.perf_counter()
+    metadata = {
+        "transaction_hash": seed,
+        "hashed_seed": hashed,
+        "audio_duration": probe_duration(long_wav),
+        "video_duration": probe_duration(video) if video.exists() else None,
+        "video_resolution": "800x600",
+        "frame_rate": 60,
+        "frame_count": frame_count,
+        "reproducible": True,
+    }
+    meta_path = out / f"{seed}_metadata.json"
+    meta_path.write_text(json.dumps(metadata, indent=2))
+    stages["metadata"] = {"wall_sec": round(time.perf_counter() - t0, 6), "cpu_sec": None,
+                          "peak_rss_kb": None, "bytes_written": meta_path.stat().st_size}
+
+    if not args.keep:
+        shutil.rmtree(frames_dir)
+    return {"seed": seed, "hashed_seed": hashed, "frame_count": frame_count, "stages": stages}
+
+
+def summarize(runs):
+    """Per-stage medians and pipeline throughput over all seeds"""
+    summary = {"stages": {}}
+    for name in STAGES:
+        rows = [r["stages"][name] for r in runs if "wall_sec" in r["stages"].get(name, {})]
+        if not rows:
+            continue
+        rss = [row["peak_rss_kb"] for row in rows if row["peak_rss_kb"] is not None]
+        summary["stages"][name] = {
+            "median_wall_sec": round(statistics.median(row["wall_sec"] for row in rows), 4),
+            "max_peak_rss_kb": max(rss) if rss else None,
+            "median_bytes_written": int(statistics.median(row["bytes_written"] for row in rows)),
+        }
+    wall = sum(row.get("wall_sec", 0) for r in runs for row in r["stages"].values())
+    cpu = sum(row.get("cpu_sec") or 0 for r in runs for row in r["stages"].values())
+    summary["total_wall_sec"] = round(wall, 3)
+    summary["total_cpu_sec"] = round(cpu, 3)
+    summary["seeds_per_hour"] = round(len(runs) * 3600 / wall, 3) if wall else None
+    summary["seeds_per_core_hour"] = round(len(runs) * 3600 / cpu, 3) if cpu else None
+    return summary
+
+
+def compare(result, baseline, tolerance):
+    """Regressions of `result` against `baseline` beyond `tolerance`"""
+    problems = []
+    old_stages = baseline.get("summary", {}).get("stages", {})
+    for name, now in result["summary"]["stages"].items():
+        old = old_stages.get(name)
+        if not old or name in ("plan", "metadata"):
+            continue  # sub-millisecond bookkeeping: too noisy to gate on
+        if old["median_wall_sec"] > 0 and now["median_wall_sec"] > old["median_wall_sec"] * (1 + tolerance):
+            problems.append(f"{name}: median wall {old['median_wall_sec']:.3f}s -> {now['median_wall_sec']:.3f}s")
+    old_tp = baseline.get("summary", {}).get("seeds_per_core_hour")
+    now_tp = result["summary"]["seeds_per_core_hour"]
+    if old_tp and now_tp and now_tp < old_tp * (1 - tolerance):
+        problems.append(f"seeds per core-hour {old_tp:.1f} -> {now_tp:.1f}")
+    return problems
+
+
+def git_revision():
+    r = subprocess.run(["git", "rev-parse", "--short", "HEAD"], cwd=ROOT, capture_output=True, text=True)
+    return r.stdout.strip() if r.returncode == 0 else None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("--seeds", default=",".join(DEFAULT_SEEDS), help="comma-separated seeds")
+    ap.add_argument("--out", default="bench_pipeline.json", help="result JSON")
+    ap.add_argument("--baseline", help="earlier result JSON to gate against")
+    ap.add_argument("--tolerance", type=float, default=0.10, help="allowed slowdown (0.10 = 10%%)")
+    ap.add_argument("--frames", type=int, help="cap frames per seed (generate_frames max_frames)")
+    ap.add_argument("--threads", type=int, help="generate_frames --threads")
+    ap.add_argument("--generate-frames", default=str(GENERATE_FRAMES), help="frame generator binary")
+    ap.add_argument("--keep", help="keep every output under this directory")
+    args = ap.parse_args()
+
+    for tool in (SEGMENT, EXPORT_TIMELINE, Path(args.generate_frames)):
+        if not tool.exists():
+            sys.exit(f"❌ {tool} not found (make c-build generate_frames)")
+
+    seeds = [s.strip() for s in args.seeds.split(",") if s.strip()]
+    work = Path(args.keep) if args.keep else Path(tempfile.mkdtemp(prefix="bench_pipeline_"))
+    work.mkdir(parents=True, exist_ok=True)
+    runs = []
+    try:
+        for seed in seeds:
+            print(f"⏱️  {seed}", file=sys.stderr)
+            runs.append(bench_seed(seed, work, args))
+    finally:
+        if not args.keep:
+            shutil.rmtree(work, ignore_errors=True)
+
+    result = {
+        "schema": 1,
+        "generated_at": datetime.now(timezone.utc).isoformat(timespec="seconds"),
+        "git_revision": git_revision(),
+        "host": {"machine": platform.machine(), "system": platform.system(),
+                 "cpu_count": os.cpu_count(), "python": platform.python_version()},
+        "config": {"seeds": seeds, "repeat": REPEAT, "frames": args.frames, "threads": args.threads},
+        "runs": runs,
+    }
+    result["summary"] = summarize(runs)
+    Path(args.out).write_text(json.dumps(result, indent=2) + "\n")
+
+    print(f"{'stage':<10} {'median s':>10} {'peak RSS MB':>12} {'written MB':>11}", file=sys.stderr)
+    for name, s in result["summary"]["stages"].items():
+        rss = f"{s['max_peak_rss_kb'] / 1024:.1f}" if s["max_peak_rss_kb"] is not None else "-"
+        print(f"{name:<10} {s['median_wall_sec']:>10.3f} {rss:>12} {s['median_bytes_written'] / 1e6:>11.2f}",
+              file=sys.stderr)
+    print(f"📊 {result['summary']['seeds_per_core_hour']} seeds per core-hour -> {args.out}", file=sys.stderr)
+
+    if args.baseline:
+        problems = compare(result, json.loads(Path(args.baseline).read_text()), args.tolerance)
+        for p in problems:
+            print(f"❌ regression: {p}", file=sys.stderr)
+        if problems:
+            sys.exit(1)
+        print(f"✅ within {args.tolerance:.0%} of {args.baseline}", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
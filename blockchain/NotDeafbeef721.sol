@@ -11,7 +11,7 @@ import "@openzeppelin/contracts/access/AccessControl.sol";
  *         using the on-chain code + per-token seed.
  *         
  *         Features:
- *         - 512 free mints (gas only) 
+ *         - 512 free mints (gas only), or minter batches via mintBatch
  *         - Pure ARM64 assembly audio + visual generation
  *         - Deterministic reproduction from transaction hashes
  *         - Complete source code transparency on-chain
@@ -21,28 +21,37 @@ contract NotDeafbeef721 is ERC721, AccessControl {
     // --- Roles ---
     bytes32 public constant MINTER_ROLE = keccak256("MINTER_ROLE");
 
+    // Everything a mint reads or writes (counts, cap, flags) shares the
+    // slot after p, so a mint touches one series slot.
     struct SeriesStruct {
         bytes32[25] codeLocations;        // TX hashes containing UTF-8 source chunks
+        uint32[8]   p;                    // Series parameters (one slot)
         uint32      numCodeLocations;     // Number of chunks used (≤25)
-        uint32[8]   p;                    // Series parameters
-        uint256     numMint;              // Current minted count
-        uint256     maxMint;              // Hard cap (512 for NotDeafbeef)
+        uint32      numMint;              // Current minted count
+        uint32      maxMint;              // Hard cap (512 for NotDeafbeef), 0 = none
         bool        paused;               // Blocks minting if true
         bool        locked;               // Blocks code changes if true
         bool        publicMintEnabled;    // Allow free public minting
     }
 
-    struct TokenParamsStruct {
-        bytes32   seed;                   // 32-byte deterministic seed (immutable)
-        uint32[8] p;                      // Token-specific parameters
+    // One record per mint call: tokens [firstTokenId, firstTokenId + count)
+    // share a series and an entropy word, and each token's seed is derived
+    // from the two on read (_seed) instead of being stored per token.  A
+    // batch of one is a single mint, whose seed is the entropy word itself
+    // as before batches existed.
+    struct BatchStruct {
+        uint64  firstTokenId;
+        uint32  count;
+        uint64  seriesId;                 // first slot ends here
+        bytes32 entropy;                  // keccak of block state + recipient
     }
 
     // --- Storage ---
-    mapping(uint256 => SeriesStruct) public series;
+    mapping(uint256 => SeriesStruct) private _series;   // getters: series, getSeries
     uint256 public numSeries;
 
-    mapping(uint256 => TokenParamsStruct) public tokenParams;
-    mapping(uint256 => uint256) public token2series;
+    BatchStruct[] private _batches;       // ascending firstTokenId
+    mapping(uint256 => uint256) private _tokenP;  // 8 x uint32 token params, packed
 
     uint256 private _nextTokenId = 1;
     string  private _baseTokenURI;
@@ -56,6 +65,9 @@ contract NotDeafbeef721 is ERC721, AccessControl {
     event SeriesCodeLocationSet(uint256 indexed seriesId, uint32 indexed index, bytes32 txHash);
     event SeriesNumCodeLocationsSet(uint256 indexed seriesId, uint32 count);
     event NFTGenerated(address indexed to, uint256 indexed tokenId, uint256 indexed seriesId, bytes32 seed);
+    // mintBatch: seeds are seedOf(firstTokenId + i, entropy) for i < count
+    event BatchMinted(address indexed to, uint256 indexed firstTokenId, uint256 indexed seriesId,
+                      uint256 count, bytes32 entropy);
 
     constructor(string memory name_, string memory symbol_) ERC721(name_, symbol_) {
         _grantRole(DEFAULT_ADMIN_ROLE, _msgSender());
@@ -63,8 +75,8 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         
         // Initialize Series 0 for NotDeafbeef with 512 max supply
         uint256 s0 = _addSeries();
-        series[s0].maxMint = 512;
-        series[s0].publicMintEnabled = false; // Start disabled until code is set
+        _series[s0].maxMint = 512;
+        _series[s0].publicMintEnabled = false; // Start disabled until code is set
     }
 
     // --- Modifiers ---
@@ -74,7 +86,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
     }
 
     modifier seriesUnlocked(uint256 seriesId) {
-        require(!series[seriesId].locked, "Series: locked");
+        require(!_series[seriesId].locked, "Series: locked");
         _;
     }
 
@@ -86,7 +98,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
 
     function _addSeries() internal returns (uint256 seriesId) {
         seriesId = numSeries;
-        SeriesStruct storage s = series[seriesId];
+        SeriesStruct storage s = _series[seriesId];
         s.paused = true;                   // Start paused
         s.locked = false;
         s.publicMintEnabled = false;       // Start disabled
@@ -101,7 +113,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         onlyRole(DEFAULT_ADMIN_ROLE)
         seriesExists(seriesId)
     {
-        series[seriesId].locked = true;
+        _series[seriesId].locked = true;
         emit SeriesLocked(seriesId);
     }
 
@@ -110,7 +122,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         onlyRole(DEFAULT_ADMIN_ROLE)
         seriesExists(seriesId)
     {
-        series[seriesId].paused = paused_;
+        _series[seriesId].paused = paused_;
         emit SeriesPaused(seriesId, paused_);
     }
 
@@ -120,7 +132,8 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         seriesExists(seriesId)
         seriesUnlocked(seriesId)
     {
-        series[seriesId].maxMint = maxMint_;
+        require(maxMint_ <= type(uint32).max, "Max mint out of range");
+        _series[seriesId].maxMint = uint32(maxMint_);
         emit SeriesMaxMintSet(seriesId, maxMint_);
     }
 
@@ -129,7 +142,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         onlyRole(DEFAULT_ADMIN_ROLE)
         seriesExists(seriesId)
     {
-        series[seriesId].publicMintEnabled = enabled;
+        _series[seriesId].publicMintEnabled = enabled;
         emit SeriesPublicMintSet(seriesId, enabled);
     }
 
@@ -140,7 +153,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         seriesUnlocked(seriesId)
     {
         require(count <= 25, "Max 25 code chunks");
-        series[seriesId].numCodeLocations = count;
+        _series[seriesId].numCodeLocations = count;
         emit SeriesNumCodeLocationsSet(seriesId, count);
     }
 
@@ -150,7 +163,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         seriesExists(seriesId)
         seriesUnlocked(seriesId)
     {
-        SeriesStruct storage s = series[seriesId];
+        SeriesStruct storage s = _series[seriesId];
         require(index < s.numCodeLocations, "Index out of bounds");
         s.codeLocations[index] = txHash;
         emit SeriesCodeLocationSet(seriesId, index, txHash);
@@ -163,7 +176,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         seriesUnlocked(seriesId)
     {
         require(i < 8, "Parameter index out of range");
-        series[seriesId].p[i] = value;
+        _series[seriesId].p[i] = value;
     }
 
     function setTokenParam(uint256 tokenId, uint32 i, uint32 value)
@@ -172,7 +185,9 @@ contract NotDeafbeef721 is ERC721, AccessControl {
     {
         require(_exists(tokenId), "Token does not exist");
         require(i < 8, "Parameter index out of range");
-        tokenParams[tokenId].p[i] = value;
+        uint256 shift = uint256(i) * 32;
+        _tokenP[tokenId] = (_tokenP[tokenId] & ~(uint256(type(uint32).max) << shift))
+                         | (uint256(value) << shift);
     }
 
     // --- Public Free Mint (Gas Only) ---
@@ -186,7 +201,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         seriesExists(seriesId)
         returns (uint256 tokenId)
     {
-        SeriesStruct storage s = series[seriesId];
+        SeriesStruct storage s = _series[seriesId];
         require(!s.paused, "Series is paused");
         require(s.publicMintEnabled, "Public mint disabled");
         require(s.numCodeLocations > 0, "Code not set");
@@ -195,7 +210,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
             require(s.numMint < s.maxMint, "Maximum mint reached");
         }
 
-        tokenId = _mintInternal(_msgSender(), seriesId);
+        tokenId = _mintInternal(_msgSender(), seriesId, 1);
     }
 
     // --- Admin/Minter Functions ---
@@ -206,35 +221,85 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         seriesExists(seriesId)
         returns (uint256 tokenId)
     {
-        SeriesStruct storage s = series[seriesId];
+        SeriesStruct storage s = _series[seriesId];
         require(!s.paused, "Series is paused");
         require(s.numCodeLocations > 0, "Code not set");
         if (s.maxMint != 0) {
             require(s.numMint < s.maxMint, "Maximum mint reached");
         }
-        tokenId = _mintInternal(to, seriesId);
+        tokenId = _mintInternal(to, seriesId, 1);
     }
 
-    function _mintInternal(address to, uint256 seriesId) internal returns (uint256 tokenId) {
-        tokenId = _nextTokenId++;
-        _safeMint(to, tokenId);
+    /**
+     * @notice Mint `count` consecutive tokens to `to` in one call. Storage
+     *         per batch, not per token: one batch record, one series slot
+     *         update and one BatchMinted event; the seeds follow from the
+     *         batch entropy (seedOf).
+     */
+    function mintBatch(address to, uint256 seriesId, uint256 count)
+        external
+        onlyRole(MINTER_ROLE)
+        seriesExists(seriesId)
+        returns (uint256 firstTokenId)
+    {
+        SeriesStruct storage s = _series[seriesId];
+        require(!s.paused, "Series is paused");
+        require(s.numCodeLocations > 0, "Code not set");
+        require(count > 0 && count <= type(uint32).max, "Batch size out of range");
+        if (s.maxMint != 0) {
+            require(s.numMint + count <= s.maxMint, "Maximum mint reached");
+        }
+        firstTokenId = _mintInternal(to, seriesId, count);
+    }
+
+    function _mintInternal(address to, uint256 seriesId, uint256 count) internal returns (uint256 firstTokenId) {
+        firstTokenId = _nextTokenId;
+        _nextTokenId = firstTokenId + count;
 
-        // Generate pseudo-random seed for NFT uniqueness
-        // Same as deafbeef: combines token ID + blockchain state
-        bytes32 seed = keccak256(
+        // Pseudo-random entropy for NFT uniqueness, as deafbeef: first token
+        // ID + blockchain state.  A single mint's seed is this word, a
+        // batch token's seed hashes in its own ID (_seed).
+        bytes32 entropy = keccak256(
             abi.encodePacked(
-                tokenId,
+                firstTokenId,
                 block.prevrandao,    // Randomness beacon (post-merge)
                 block.timestamp,
                 to
             )
         );
+        _batches.push(BatchStruct(uint64(firstTokenId), uint32(count), uint64(seriesId), entropy));
+        _series[seriesId].numMint += uint32(count);
+
+        for (uint256 i = 0; i < count; i++) {
+            _safeMint(to, firstTokenId + i);
+        }
+        if (count == 1) {
+            emit NFTGenerated(to, firstTokenId, seriesId, entropy);
+        } else {
+            emit BatchMinted(to, firstTokenId, seriesId, count, entropy);
+        }
+    }
 
-        tokenParams[tokenId].seed = seed;
-        token2series[tokenId] = seriesId;
+    /// @notice Seed of `tokenId` minted by mintBatch (count > 1) with `entropy`
+    function seedOf(uint256 tokenId, bytes32 entropy) public pure returns (bytes32) {
+        return keccak256(abi.encodePacked(tokenId, entropy));
+    }
 
-        series[seriesId].numMint += 1;
-        emit NFTGenerated(to, tokenId, seriesId, seed);
+    /// @dev Seed of `tokenId` in batch `b`: single mints keep their entropy word
+    function _seed(BatchStruct storage b, uint256 tokenId) internal view returns (bytes32) {
+        return b.count == 1 ? b.entropy : seedOf(tokenId, b.entropy);
+    }
+
+    /// @dev Batch holding an existing `tokenId`: binary search on firstTokenId
+    function _batchOf(uint256 tokenId) internal view returns (BatchStruct storage) {
+        uint256 lo = 0;
+        uint256 hi = _batches.length;
+        while (hi - lo > 1) {
+            uint256 mid = (lo + hi) / 2;
+            if (_batches[mid].firstTokenId <= tokenId) lo = mid;
+            else hi = mid;
+        }
+        return _batches[lo];
     }
 
     // --- Reconstruction Interface (Public Getters) ---
@@ -252,11 +317,15 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         )
     {
         require(_exists(tokenId), "Token does not exist");
-        seed = tokenParams[tokenId].seed;
-        tokenP = tokenParams[tokenId].p;
+        BatchStruct storage b = _batchOf(tokenId);
+        seed = _seed(b, tokenId);
+        uint256 packed = _tokenP[tokenId];
+        for (uint256 i = 0; i < 8; i++) {
+            tokenP[i] = uint32(packed >> (i * 32));
+        }
 
-        seriesId = token2series[tokenId];
-        SeriesStruct storage s = series[seriesId];
+        seriesId = b.seriesId;
+        SeriesStruct storage s = _series[seriesId];
         seriesP = s.p;
         numCodeLocations = s.numCodeLocations;
         codeLocation0 = (numCodeLocations > 0) ? s.codeLocations[0] : bytes32(0);
@@ -277,7 +346,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
             bool publicMintEnabled
         )
     {
-        SeriesStruct storage s = series[seriesId];
+        SeriesStruct storage s = _series[seriesId];
         numCodeLocations = s.numCodeLocations;
         codeLocations    = s.codeLocations;
         p                = s.p;
@@ -294,23 +363,53 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         seriesExists(seriesId)
         returns (bytes32)
     {
-        SeriesStruct storage s = series[seriesId];
+        SeriesStruct storage s = _series[seriesId];
         require(index < s.numCodeLocations, "Index out of bounds");
         return s.codeLocations[index];
     }
 
     function getSeed(uint256 tokenId) external view returns (bytes32) {
         require(_exists(tokenId), "Token does not exist");
-        return tokenParams[tokenId].seed;
+        return _seed(_batchOf(tokenId), tokenId);
     }
 
     function tokenSeries(uint256 tokenId) external view returns (uint256) {
         require(_exists(tokenId), "Token does not exist");
-        return token2series[tokenId];
+        return _batchOf(tokenId).seriesId;
+    }
+
+    // --- Getters of the earlier storage layout (same ABI) ---
+
+    /// @notice The former public `series` mapping getter: scalar fields, counts as uint256
+    function series(uint256 seriesId)
+        external
+        view
+        returns (
+            uint32 numCodeLocations,
+            uint256 numMint,
+            uint256 maxMint,
+            bool paused,
+            bool locked,
+            bool publicMintEnabled
+        )
+    {
+        SeriesStruct storage s = _series[seriesId];
+        return (s.numCodeLocations, s.numMint, s.maxMint, s.paused, s.locked, s.publicMintEnabled);
+    }
+
+    /// @notice The former `tokenParams` mapping getter: the seed, zero for no token
+    function tokenParams(uint256 tokenId) external view returns (bytes32 seed) {
+        if (_exists(tokenId)) seed = _seed(_batchOf(tokenId), tokenId);
+    }
+
+    /// @notice The former `token2series` mapping getter: zero for no token
+    function token2series(uint256 tokenId) external view returns (uint256 seriesId) {
+        if (_exists(tokenId)) seriesId = _batchOf(tokenId).seriesId;
     }
 
     // --- Optional: Transfer Counter (Deafbeef "Entropy" Style) ---
-    // Uncomment to track transfers in p[7] for artistic degradation effects
+    // Uncomment to track transfers in p[7] (bits 224..255 of _tokenP) for
+    // artistic degradation effects
     /*
     function _beforeTokenTransfer(
         address from, 
@@ -323,7 +422,7 @@ contract NotDeafbeef721 is ERC721, AccessControl {
         // Increment transfer counter on each transfer (not mint/burn)
         if (from != address(0) && to != address(0)) {
             unchecked { 
-                tokenParams[tokenId].p[7] += 1; 
+                _tokenP[tokenId] += uint256(1) << 224; 
             }
         }
     }
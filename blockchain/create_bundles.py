@@ -4,9 +4,19 @@ NotDeafBeef Blockchain Bundle Creator
 =====================================
 Organizes ARM64 assembly files into logical bundles for on-chain storage.
 Following deafbeef methodology: UTF-8 source code in transaction input data.
+
+With --packed, all bundles go into one stream instead: assembly comments and
+redundant whitespace are stripped (deterministically, tokens untouched), the
+stream is deflate-compressed unless --no-compress is given, and it is split
+into as few chunks as --max-chunk allows.  Chunk 0 is then unpack_bundle.py,
+the stdlib-only script that reassembles, checks and extracts the rest.
 """
 
+import argparse
+import hashlib
 import os
+import re
+import zlib
 from pathlib import Path
 
 # File organization by logical modules
@@ -146,8 +156,122 @@ Concatenate all chunks in order to reconstruct.
     
     return chunks
 
+def minify_asm(source):
+    """Strip `//` and `/* */` comments, indentation, blank lines and spaces
+    around commas from ARM64 assembly.  String literals and preprocessor
+    lines (#define, #ifndef...) are kept byte for byte, so the assembler
+    sees the same tokens."""
+    lines = []
+    in_block = False
+    for line in source.splitlines():
+        if not in_block and line.lstrip().startswith('#'):
+            lines.append(line.strip())
+            continue
+        parts = []      # (is_string, text)
+        i, n = 0, len(line)
+        while i < n:
+            if in_block:
+                end = line.find('*/', i)
+                if end < 0:
+                    break
+                in_block = False
+                parts.append((False, ' '))
+                i = end + 2
+            elif line[i] == '"':
+                j = i + 1
+                while j < n and line[j] != '"':
+                    j += 2 if line[j] == '\\' else 1
+                parts.append((True, line[i:j + 1]))
+                i = j + 1
+            elif line.startswith('//', i):
+                break
+            elif line.startswith('/*', i):
+                in_block = True
+                i += 2
+            else:
+                j = i
+                while j < n and line[j] != '"' and not line.startswith('//', j) and not line.startswith('/*', j):
+                    j += 1
+                parts.append((False, line[i:j]))
+                i = j
+        text = ''.join(t if is_str else re.sub(r'\s*,\s*', ',', re.sub(r'[ \t]+', ' ', t))
+                       for is_str, t in parts).strip()
+        if text:
+            lines.append(text)
+    return '\n'.join(lines) + '\n'
+
+def create_packed_bundle():
+    """All bundles as one minified stream, each file length-prefixed."""
+    content = "[NOTDEAFBEEF PACKED BUNDLE]\n"
+    for bundle_name, bundle_info in BUNDLE_ORGANIZATION.items():
+        content += f"# {bundle_name}: {bundle_info['description']}\n"
+    for bundle_info in BUNDLE_ORGANIZATION.values():
+        for source_path, bundle_path in bundle_info['files']:
+            text = read_file_content(source_path)
+            if bundle_path.endswith('.s'):
+                text = minify_asm(text)
+            data = text.encode('utf-8')
+            content += f"=== FILE: {bundle_path} {len(data)} ===\n{text}\n"
+    return content.encode('utf-8')
+
+def calldata_gas(data):
+    """EIP-2028 input data cost: 4 gas per zero byte, 16 per non-zero byte."""
+    zeros = data.count(0)
+    return 4 * zeros + 16 * (len(data) - zeros)
+
+def create_packed_chunks(compress, max_size):
+    """Chunk 0 = unpacker, then the (compressed) stream in max_size pieces."""
+    bundle = create_packed_bundle()
+    stream = zlib.compress(bundle, 9) if compress else bundle
+    with open("unpack_bundle.py", 'r', encoding='utf-8') as f:
+        unpacker = f.read()
+    unpacker = unpacker.replace('FORMAT = "zlib"', f'FORMAT = "{"zlib" if compress else "text"}"', 1)
+    unpacker = unpacker.replace('SHA256 = ""', f'SHA256 = "{hashlib.sha256(bundle).hexdigest()}"', 1)
+
+    chunks = [("packed_00_unpack_bundle.py", unpacker.encode('utf-8'))]
+    ext = "bin" if compress else "txt"
+    for n, i in enumerate(range(0, len(stream), max_size), start=1):
+        chunks.append((f"packed_{n:02d}.{ext}", stream[i:i + max_size]))
+    return bundle, chunks
+
+def main_packed(compress, max_size):
+    """Write blockchain/packed/ and report calldata against the plain bundles."""
+    os.makedirs("blockchain/packed", exist_ok=True)
+    for old in Path("blockchain/packed").glob("packed_*"):
+        old.unlink()
+
+    bundle, chunks = create_packed_chunks(compress, max_size)
+    total_bytes = total_gas = 0
+    for name, data in chunks:
+        with open(f"blockchain/packed/{name}", 'wb') as f:
+            f.write(data)
+        gas = calldata_gas(data)
+        total_bytes += len(data)
+        total_gas += gas
+        print(f"  {name}: {len(data):,} bytes, {gas:,} calldata gas")
+
+    plain = [create_bundle(n, info).encode('utf-8') for n, info in BUNDLE_ORGANIZATION.items()]
+    plain_gas = sum(calldata_gas(b) for b in plain)
+    print(f"\n✅ {len(chunks)} chunks, {total_bytes:,} bytes "
+          f"({len(bundle):,} minified{', deflated' if compress else ''})")
+    print(f"   calldata gas {total_gas:,} + {21000 * len(chunks):,} base "
+          f"vs {plain_gas:,} + 21,000 per chunk for the plain bundles")
+    print("📦 Next: ./create_hex_chunks.sh --packed && node deploy_to_blockchain.js")
+
 def main():
     """Create all bundles for blockchain deployment."""
+    parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0])
+    parser.add_argument('--packed', action='store_true',
+                        help='one minified, compressed stream in blockchain/packed/')
+    parser.add_argument('--no-compress', action='store_true',
+                        help='with --packed: keep the stream as readable UTF-8')
+    parser.add_argument('--max-chunk', type=int, default=None,
+                        help='chunk size in bytes (default 24000, 96000 with --packed)')
+    args = parser.parse_args()
+    if args.packed:
+        main_packed(not args.no_compress, args.max_chunk or 96000)
+        return
+
     os.makedirs("blockchain", exist_ok=True)
     
     total_chunks = 0
@@ -162,7 +286,7 @@ def main():
         bundle_content = create_bundle(bundle_name, bundle_info)
         
         # Split if needed  
-        chunks = split_bundle_if_needed(bundle_content, bundle_name)
+        chunks = split_bundle_if_needed(bundle_content, bundle_name, args.max_chunk or 24000)
         
         for chunk_name, chunk_content in chunks:
             chunk_path = f"blockchain/{chunk_name}"
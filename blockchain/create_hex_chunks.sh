@@ -2,17 +2,41 @@
 # NotDeafBeef Hex Chunk Creator
 # =============================
 # Converts UTF-8 bundle files to hex-encoded chunks ready for blockchain deployment
+#
+# Usage: ./create_hex_chunks.sh            the 15 plain bundles (create_bundles.py)
+#        ./create_hex_chunks.sh --packed   blockchain/packed/ (create_bundles.py --packed)
 
 set -e
 
+PACKED=0
+[[ "$1" == "--packed" ]] && PACKED=1
+
 echo "🔧 Creating hex-encoded chunks for blockchain deployment..."
 echo ""
 
 # Clean up any existing hex files
 rm -f *.hex
-rm -f deployment_chunks/
-
 mkdir -p deployment_chunks
+rm -f deployment_chunks/*.hex
+
+if [[ $PACKED == 1 ]]; then
+    # Chunk 0 is the unpacker, the rest the compressed stream, all in name order
+    CHUNK_INDEX=0
+    for chunk_path in blockchain/packed/packed_*; do
+        [[ -f "$chunk_path" ]] || { echo "⚠️  No packed chunks: run ./create_bundles.py --packed"; exit 1; }
+        chunk_file=$(basename "$chunk_path")
+        hex_file="deployment_chunks/chunk_$(printf "%02d" $CHUNK_INDEX)_${chunk_file%.*}.hex"
+        echo -n "0x" > "$hex_file"
+        xxd -p -c 0 "$chunk_path" >> "$hex_file"
+        printf "%2d. %-35s %6s bytes\n" $CHUNK_INDEX "$chunk_file" "$(wc -c < "$chunk_path" | tr -d ' ')"
+        CHUNK_INDEX=$((CHUNK_INDEX + 1))
+    done
+    echo ""
+    echo "🚀 $CHUNK_INDEX packed chunks in deployment_chunks/ - run: node deploy_to_blockchain.js"
+    echo "   Reconstruction: save chunk 0 as unpack_bundle.py, then"
+    echo "   python3 unpack_bundle.py ./source chunk_01.hex chunk_02.hex ..."
+    exit 0
+fi
 
 # Get all chunk files in logical order
 CHUNKS=(
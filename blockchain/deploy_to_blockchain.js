@@ -1,7 +1,8 @@
 /**
  * NotDeafbeef Blockchain Deployment Script
  * ========================================
- * Deploys all 15 code chunks to Ethereum as transaction input data.
+ * Deploys every code chunk in deployment_chunks/ (15 plain bundles, or the
+ * packed set from create_bundles.py --packed) as transaction input data.
  * Run this script to upload your complete assembly pipeline to the blockchain.
  */
 
@@ -36,53 +37,72 @@ async function deployChunksToBlockchain() {
     console.log(`📦 Found ${hexFiles.length} chunks to deploy`);
     console.log('');
 
-    const transactionHashes = [];
+    // Pipelined: every chunk is signed with an explicit nonce and sent without
+    // waiting for the previous one to be mined.  At most MAX_IN_FLIGHT are
+    // pending at once (node txpools cap pending transactions per account).
+    const MAX_IN_FLIGHT = Number(process.env.MAX_IN_FLIGHT || 8);
+    const baseNonce = await wallet.getTransactionCount('pending');
+    const feeData = await provider.getFeeData();
+    const fees = feeData.maxFeePerGas
+        ? { maxFeePerGas: feeData.maxFeePerGas, maxPriorityFeePerGas: feeData.maxPriorityFeePerGas }
+        : { gasPrice: feeData.gasPrice };
+    const { chainId } = await provider.getNetwork();
+
+    const transactionHashes = new Array(hexFiles.length);
+    const pending = [];
     let totalGasUsed = 0;
 
-    // Deploy each chunk as transaction input data
+    async function confirm(i, tx) {
+        const receipt = await tx.wait();
+        totalGasUsed += receipt.gasUsed.toNumber();
+        console.log(`   ✅ Chunk ${i} confirmed in block ${receipt.blockNumber} (gas ${receipt.gasUsed.toLocaleString()})`);
+    }
+
     for (let i = 0; i < hexFiles.length; i++) {
         const hexFile = hexFiles[i];
         const hexPath = path.join(chunkDir, hexFile);
-        
-        console.log(`📤 Deploying chunk ${i}: ${hexFile}`);
-        
+
         try {
             // Read hex data (already has 0x prefix)
             const hexData = fs.readFileSync(hexPath, 'utf8').trim();
-            const dataSize = (hexData.length - 2) / 2; // Remove 0x and convert to bytes
-            
-            console.log(`   Size: ${dataSize.toLocaleString()} bytes`);
-            
-            // Send transaction with chunk data
+            const bytes = ethers.utils.arrayify(hexData);
+            const zeros = bytes.filter(b => b === 0).length;
+            // EIP-2028 calldata: 4 gas per zero byte, 16 per non-zero byte
+            const gasLimit = 21000 + zeros * 4 + (bytes.length - zeros) * 16;
+
+            if (pending.length >= MAX_IN_FLIGHT)
+                await pending.shift();
+
             const tx = await wallet.sendTransaction({
                 to: wallet.address, // Send to self
                 value: 0,           // 0 ETH
                 data: hexData,      // Our source code
-                gasLimit: Math.min(30000000, 21000 + (dataSize * 16)) // Estimate gas
+                nonce: baseNonce + i,
+                gasLimit,
+                chainId,
+                ...fees
             });
-            
+            transactionHashes[i] = tx.hash;
+            console.log(`📤 Chunk ${i}: ${hexFile} (${bytes.length.toLocaleString()} bytes, nonce ${baseNonce + i})`);
             console.log(`   TX: ${tx.hash}`);
-            console.log(`   Waiting for confirmation...`);
-            
-            // Wait for confirmation
-            const receipt = await tx.wait();
-            totalGasUsed += receipt.gasUsed.toNumber();
-            
-            console.log(`   ✅ Confirmed in block ${receipt.blockNumber}`);
-            console.log(`   Gas used: ${receipt.gasUsed.toLocaleString()}`);
-            console.log('');
-            
-            transactionHashes.push(tx.hash);
-            
-            // Small delay to avoid nonce issues
-            await new Promise(resolve => setTimeout(resolve, 2000));
-            
+            const confirmed = confirm(i, tx);
+            confirmed.catch(() => {});   // reported where it is awaited
+            pending.push(confirmed);
         } catch (error) {
             console.error(`❌ Failed to deploy chunk ${i}: ${error.message}`);
+            console.error(`   Chunks ${i}.. were not sent; earlier ones may still be pending`);
             process.exit(1);
         }
     }
 
+    try {
+        await Promise.all(pending);
+    } catch (error) {
+        console.error(`❌ A chunk transaction failed: ${error.message}`);
+        process.exit(1);
+    }
+    console.log('');
+
     console.log('🎉 All chunks deployed successfully!');
     console.log('===================================');
     console.log('');
@@ -0,0 +1,109 @@
+/**
+ * NotDeafbeef Seed Export
+ * =======================
+ * Writes every minted token's seed to a manifest CSV for batch_daemon.py,
+ * from the contract's mint events instead of one getSeed(tokenId) call per
+ * token.  NFTGenerated (single mints) and BatchMinted (mintBatch) logs are
+ * fetched together in block-range pages, so 512 tokens cost a handful of
+ * eth_getLogs requests; batch seeds are seedOf(tokenId, entropy), hashed
+ * locally.
+ *
+ *   RPC_URL=... CONTRACT_ADDRESS=0x... FROM_BLOCK=<deploy block> \
+ *       node export_seeds.js [seeds.csv]
+ *   python3 ../batch_daemon.py seeds.csv
+ *
+ * PAGE_BLOCKS (default 10000) is the range per request; a page the node
+ * rejects (too many results or too wide) is split in half and retried.
+ * MAX_IN_FLIGHT (default 4) pages are requested at once.
+ */
+
+const { ethers } = require('ethers');
+const fs = require('fs');
+
+const ABI = [
+    'event NFTGenerated(address indexed to, uint256 indexed tokenId, uint256 indexed seriesId, bytes32 seed)',
+    'event BatchMinted(address indexed to, uint256 indexed firstTokenId, uint256 indexed seriesId, uint256 count, bytes32 entropy)'
+];
+
+// Same derivation as NotDeafbeef721.seedOf
+function seedOf(tokenId, entropy) {
+    return ethers.utils.solidityKeccak256(['uint256', 'bytes32'], [tokenId, entropy]);
+}
+
+// Logs in [from, to], halving the range until the node accepts it
+async function fetchLogs(provider, filter, from, to) {
+    try {
+        return await provider.getLogs({ ...filter, fromBlock: from, toBlock: to });
+    } catch (error) {
+        if (from === to) throw error;
+        const mid = Math.floor((from + to) / 2);
+        const left = await fetchLogs(provider, filter, from, mid);
+        const right = await fetchLogs(provider, filter, mid + 1, to);
+        return left.concat(right);
+    }
+}
+
+async function exportSeeds(outPath) {
+    const provider = new ethers.providers.JsonRpcProvider(process.env.RPC_URL);
+    const address = process.env.CONTRACT_ADDRESS;
+    const fromBlock = Number(process.env.FROM_BLOCK || 0);
+    const toBlock = process.env.TO_BLOCK ? Number(process.env.TO_BLOCK) : await provider.getBlockNumber();
+    const PAGE_BLOCKS = Number(process.env.PAGE_BLOCKS || 10000);
+    const MAX_IN_FLIGHT = Number(process.env.MAX_IN_FLIGHT || 4);
+
+    const iface = new ethers.utils.Interface(ABI);
+    // One topic slot with both event IDs: either event matches
+    const filter = {
+        address,
+        topics: [[iface.getEventTopic('NFTGenerated'), iface.getEventTopic('BatchMinted')]]
+    };
+
+    const pages = [];
+    for (let b = fromBlock; b <= toBlock; b += PAGE_BLOCKS)
+        pages.push([b, Math.min(b + PAGE_BLOCKS - 1, toBlock)]);
+
+    const logs = [];
+    let next = 0;
+    async function worker() {
+        while (next < pages.length) {
+            const [from, to] = pages[next++];
+            logs.push(...await fetchLogs(provider, filter, from, to));
+        }
+    }
+    await Promise.all(Array.from({ length: Math.min(MAX_IN_FLIGHT, pages.length) }, worker));
+
+    const tokens = [];
+    for (const log of logs) {
+        const ev = iface.parseLog(log);
+        if (ev.name === 'NFTGenerated') {
+            tokens.push({ id: ev.args.tokenId, series: ev.args.seriesId, seed: ev.args.seed, block: log.blockNumber });
+        } else {
+            const count = ev.args.count.toNumber();
+            for (let i = 0; i < count; i++) {
+                const id = ev.args.firstTokenId.add(i);
+                tokens.push({ id, series: ev.args.seriesId, seed: seedOf(id, ev.args.entropy), block: log.blockNumber });
+            }
+        }
+    }
+    tokens.sort((a, b) => (a.id.lt(b.id) ? -1 : a.id.gt(b.id) ? 1 : 0));
+
+    // First column is what batch_daemon.py renders; its header row is skipped
+    const rows = ['seed_hash,token_id,series_id,block'];
+    for (const t of tokens)
+        rows.push(`${t.seed},${t.id.toString()},${t.series.toString()},${t.block}`);
+    fs.writeFileSync(outPath, rows.join('\n') + '\n');
+
+    console.log(`💾 ${outPath}: ${tokens.length} seeds from ${logs.length} mint events ` +
+                `(blocks ${fromBlock}..${toBlock}, ${pages.length} pages)`);
+    return tokens.length;
+}
+
+// Handle command line execution
+if (require.main === module) {
+    exportSeeds(process.argv[2] || 'seeds.csv').catch(error => {
+        console.error(`❌ Seed export failed: ${error.message}`);
+        process.exit(1);
+    });
+}
+
+module.exports = { exportSeeds, seedOf };
@@ -0,0 +1,197 @@
+/**
+ * NotDeafbeef721 Seed Test
+ * ========================
+ * Compiles the contract, deploys it on an in-process ganache chain and
+ * mints single tokens and batches into two series, then checks every
+ * token's getSeed against export_seeds.js: the seed in NFTGenerated,
+ * seedOf(tokenId, entropy) for BatchMinted, and the CSV exportSeeds writes
+ * from the logs.  The first and last token of each batch are looked up on
+ * their own (the _batchOf search boundaries).  The getters of the earlier
+ * storage layout (series, tokenParams, token2series) are checked against
+ * the ABI and values of the old public mappings: a single mint's seed is
+ * still keccak256(tokenId, prevrandao, timestamp, to).
+ *
+ *   npm install ethers@5 solc@0.8.24 ganache@7 @openzeppelin/contracts@4.9
+ *   node test_mint_seeds.js
+ *
+ * Exits 1 on the first mismatch.
+ */
+
+const { ethers } = require('ethers');
+const solc = require('solc');
+const ganache = require('ganache');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { exportSeeds, seedOf } = require('./export_seeds');
+
+const PORT = Number(process.env.PORT || 8547);
+// Mint calls in order, [seriesId, count]: 1 = mint(), more = mintBatch(count)
+const MINTS = [[0, 1], [0, 1], [0, 5], [1, 2], [0, 1], [1, 1], [0, 3], [1, 64], [0, 1]];
+
+// The public mapping getters before batches, as solc generated them
+const OLD_GETTERS = {
+    series: ['uint32', 'uint256', 'uint256', 'bool', 'bool', 'bool'],
+    tokenParams: ['bytes32'],
+    token2series: ['uint256']
+};
+
+function compile() {
+    const source = fs.readFileSync(path.join(__dirname, 'NotDeafbeef721.sol'), 'utf8');
+    const input = {
+        language: 'Solidity',
+        sources: { 'NotDeafbeef721.sol': { content: source } },
+        settings: {
+            optimizer: { enabled: true, runs: 200 },
+            evmVersion: 'shanghai',
+            outputSelection: { '*': { '*': ['abi', 'evm.bytecode.object'] } }
+        }
+    };
+    // @openzeppelin/... imports resolve from node_modules
+    const findImports = (p) => {
+        try {
+            return { contents: fs.readFileSync(require.resolve(p), 'utf8') };
+        } catch (error) {
+            return { error: `${p}: ${error.message}` };
+        }
+    };
+    const out = JSON.parse(solc.compile(JSON.stringify(input), { import: findImports }));
+    const errors = (out.errors || []).filter(e => e.severity === 'error');
+    if (errors.length) throw new Error(errors.map(e => e.formattedMessage).join('\n'));
+    const c = out.contracts['NotDeafbeef721.sol'].NotDeafbeef721;
+    return { abi: c.abi, bytecode: c.evm.bytecode.object };
+}
+
+function expect(cond, what) {
+    if (!cond) throw new Error(what);
+}
+
+// The entropy word of a mint: the old per-token seed formula, keyed by the first token
+async function entropyOf(provider, receipt, firstTokenId, to) {
+    const block = await provider.send('eth_getBlockByHash', [receipt.blockHash, false]);
+    return ethers.utils.solidityKeccak256(['uint256', 'uint256', 'uint256', 'address'],
+                                          [firstTokenId, block.mixHash, block.timestamp, to]);
+}
+
+async function run() {
+    const { abi, bytecode } = compile();
+    console.log(`🔨 Compiled NotDeafbeef721 with solc ${solc.version()}`);
+
+    for (const [name, outputs] of Object.entries(OLD_GETTERS)) {
+        const f = abi.find(e => e.type === 'function' && e.name === name);
+        expect(f && f.stateMutability === 'view' && f.inputs.length === 1 && f.inputs[0].type === 'uint256' &&
+               JSON.stringify(f.outputs.map(o => o.type)) === JSON.stringify(outputs),
+               `${name}(uint256) ABI differs from the old getter: ${JSON.stringify(f)}`);
+    }
+
+    const server = ganache.server({ logging: { quiet: true }, chain: { hardfork: 'shanghai' } });
+    await server.listen(PORT);
+    try {
+        const provider = new ethers.providers.JsonRpcProvider(`http://127.0.0.1:${PORT}`);
+        const admin = provider.getSigner(0);
+        const to = await provider.getSigner(1).getAddress();
+
+        const contract = await new ethers.ContractFactory(abi, bytecode, admin).deploy('NotDeafbeef', 'NDB');
+        await contract.deployed();
+        await (await contract.addSeries()).wait();
+        for (const id of [0, 1]) {
+            await (await contract.setNumCodeLocations(id, 1)).wait();
+            await (await contract.setCodeLocation(id, 0, ethers.utils.id(`series ${id} chunk 0`))).wait();
+            await (await contract.setMaxMint(id, 512)).wait();
+            await (await contract.setPaused(id, false)).wait();
+        }
+
+        // Expected seed and series per token, from the mint events as
+        // export_seeds.js reads them; the first and last of each batch
+        const expected = new Map();
+        const edges = [];
+        const minted = [0, 0];
+        for (const [sid, n] of MINTS) {
+            const tx = n === 1 ? await contract.mint(to, sid) : await contract.mintBatch(to, sid, n);
+            const receipt = await tx.wait();
+            const events = receipt.logs.map(log => {
+                try { return contract.interface.parseLog(log); } catch (error) { return null; }
+            }).filter(ev => ev && (ev.name === 'NFTGenerated' || ev.name === 'BatchMinted'));
+            expect(events.length === 1, `${events.length} mint events for one call`);
+            const ev = events[0];
+            expect(ev.args.seriesId.eq(sid), `event series ${ev.args.seriesId} != ${sid}`);
+            if (n === 1) {
+                expect(ev.name === 'NFTGenerated', `single mint emitted ${ev.name}`);
+                const id = ev.args.tokenId;
+                expect(ev.args.seed === await entropyOf(provider, receipt, id, to),
+                       `token ${id}: NFTGenerated seed is not the pre-batch formula`);
+                expected.set(id.toString(), { seed: ev.args.seed, series: sid });
+                edges.push(id.toString());
+            } else {
+                expect(ev.name === 'BatchMinted' && ev.args.count.eq(n), `mintBatch(${n}) emitted ${ev.name}`);
+                const first = ev.args.firstTokenId;
+                expect(ev.args.entropy === await entropyOf(provider, receipt, first, to),
+                       `batch at ${first}: entropy is not keccak(first, prevrandao, timestamp, to)`);
+                for (let i = 0; i < n; i++) {
+                    const id = first.add(i);
+                    expected.set(id.toString(), { seed: seedOf(id, ev.args.entropy), series: sid });
+                }
+                edges.push(first.toString(), first.add(n - 1).toString());
+            }
+            minted[sid] += n;
+        }
+        const total = minted[0] + minted[1];
+        expect(expected.size === total, `${expected.size} seeds in mint events, ${total} tokens minted`);
+        expect(new Set([...expected.values()].map(t => t.seed)).size === total, 'two tokens share a seed');
+
+        // Batch boundaries first, then every token
+        for (const id of edges.concat([...expected.keys()])) {
+            const { seed, series } = expected.get(id);
+            expect(await contract.getSeed(id) === seed, `getSeed(${id}) != event seed ${seed}`);
+            expect(await contract.tokenParams(id) === seed, `tokenParams(${id}) != event seed`);
+            expect((await contract.getTokenParams(id)).seed === seed, `getTokenParams(${id}).seed != event seed`);
+            expect((await contract.token2series(id)).eq(series), `token2series(${id}) != ${series}`);
+            expect((await contract.tokenSeries(id)).eq(series), `tokenSeries(${id}) != ${series}`);
+        }
+
+        // Unminted tokens and series read as zero, as the old mappings did
+        expect(await contract.tokenParams(0) === ethers.constants.HashZero, 'tokenParams(0) != 0');
+        expect(await contract.tokenParams(total + 1) === ethers.constants.HashZero, 'tokenParams of an unminted token != 0');
+        expect((await contract.token2series(total + 1)).eq(0), 'token2series of an unminted token != 0');
+        const none = await contract.series(7);
+        expect(none.numCodeLocations === 0 && none.numMint.eq(0) && none.maxMint.eq(0) &&
+               !none.paused && !none.locked && !none.publicMintEnabled, `series(7) = ${none}`);
+
+        for (const id of [0, 1]) {
+            const s = await contract.series(id);
+            const g = await contract.getSeries(id);
+            expect(s.numMint.eq(minted[id]) && s.maxMint.eq(512) && s.numCodeLocations === 1 &&
+                   !s.paused && !s.locked && !s.publicMintEnabled, `series(${id}) = ${s}`);
+            expect(s.numMint.eq(g.numMint) && s.maxMint.eq(g.maxMint) && s.numCodeLocations === g.numCodeLocations &&
+                   s.paused === g.paused && s.locked === g.locked && s.publicMintEnabled === g.publicMintEnabled,
+                   `series(${id}) != getSeries(${id})`);
+        }
+
+        // The manifest export_seeds.js writes from the same logs
+        const csv = path.join(fs.mkdtempSync(path.join(os.tmpdir(), 'ndb-seeds-')), 'seeds.csv');
+        process.env.RPC_URL = `http://127.0.0.1:${PORT}`;
+        process.env.CONTRACT_ADDRESS = contract.address;
+        process.env.FROM_BLOCK = '0';
+        expect(await exportSeeds(csv) === total, 'exportSeeds token count');
+        const rows = fs.readFileSync(csv, 'utf8').trim().split('\n').slice(1);
+        expect(rows.length === total, `seeds.csv has ${rows.length} rows, ${total} tokens minted`);
+        for (const row of rows) {
+            const [seed, id, series] = row.split(',');
+            expect(expected.get(id).seed === seed && await contract.getSeed(id) === seed,
+                   `seeds.csv token ${id}: ${seed} != getSeed`);
+            expect(Number(series) === expected.get(id).series, `seeds.csv token ${id}: series ${series}`);
+        }
+
+        console.log(`✅ ${total} tokens from ${MINTS.length} mint calls in 2 series (${edges.length} batch edges): ` +
+                    'getSeed, the old getters and seeds.csv agree with the mint events');
+    } finally {
+        await server.close();
+    }
+}
+
+if (require.main === module) {
+    run().catch(error => {
+        console.error(`❌ Seed test failed: ${error.message}`);
+        process.exit(1);
+    });
+}
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""
+NotDeafBeef packed bundle unpacker
+==================================
+Stored on-chain as chunk 0 of a packed deployment (create_bundles.py --packed).
+Python 3 standard library only.
+
+Usage: python3 unpack_bundle.py OUTPUT_DIR CHUNK_01 CHUNK_02 ...
+
+Each CHUNK is the input data of one code transaction after chunk 0, in
+order: a 0x-prefixed hex dump (Etherscan "View Input As Original") or the
+raw bytes.  The chunks are concatenated, inflated when compressed, checked
+against SHA256 and split into files.
+"""
+
+import hashlib
+import os
+import sys
+import zlib
+
+# Filled in by create_bundles.py
+FORMAT = "zlib"     # "zlib" (deflate stream) or "text" (minified bundle as is)
+SHA256 = ""         # of the unpacked bundle text
+
+def load_chunk(path):
+    data = open(path, 'rb').read()
+    text = data.strip()
+    if text.startswith(b'0x'):
+        return bytes.fromhex(text[2:].decode('ascii'))
+    return data
+
+def split_files(bundle):
+    """Files follow the header as `=== FILE: <path> <size> ===\\n<size bytes>\\n`."""
+    pos = bundle.index(b'=== FILE: ')
+    while pos < len(bundle):
+        end = bundle.index(b' ===\n', pos)
+        path, size = bundle[pos + 10:end].decode('utf-8').rsplit(' ', 1)
+        start = end + 5
+        yield path, bundle[start:start + int(size)]
+        pos = start + int(size) + 1
+
+def main(argv):
+    if len(argv) < 3:
+        sys.exit(__doc__)
+    stream = b''.join(load_chunk(p) for p in argv[2:])
+    bundle = zlib.decompress(stream) if FORMAT == "zlib" else stream
+    if SHA256 and hashlib.sha256(bundle).hexdigest() != SHA256:
+        sys.exit("checksum mismatch: missing, extra or misordered chunks")
+    for path, content in split_files(bundle):
+        out = os.path.join(argv[1], path)
+        os.makedirs(os.path.dirname(out) or '.', exist_ok=True)
+        with open(out, 'wb') as f:
+            f.write(content)
+        print(f"{path} ({len(content)} bytes)")
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""Encode a token's video in loop-aligned chunks, one x264 per core.
+
+One ffmpeg over the whole clip keeps a single encoder busy: x264's
+lookahead and frame threads only scale so far.  The track is --repeat
+loops of one segment, so the clip is cut at the loop points (and, with
+more cores than loops, evenly inside each loop).  Every chunk renders
+with generate_frames --range --pipe-y4m into its own x264, so each one
+starts on an IDR frame and needs nothing before it (a closed GOP).  The
+chunks are then joined with ffmpeg's concat demuxer and -c:v copy.  The
+WAV is encoded to AAC once, by its own ffmpeg next to the chunks, and
+copied into the final mux.  --aac keeps that encode: an existing file is
+muxed as it is (generate_nft.sh takes it from the artifact cache, since
+re-rendering the visuals leaves the audio alone), a missing one is
+written there.
+
+--loop-periodic encodes the first loop's chunks only and lists them once
+per loop.  This matches batch_daemon.py --loop-periodic: state restarts
+at every loop point.
+
+--digest writes the frames manifest verify_nft.sh compares.  It joins the
+chunks' own manifests (generate_frames --digest next to the pipe), so it
+matches a one-process render.
+
+Usage:
+  python3 chunk_encode.py <audio.wav> <seed> <out.mp4> [--jobs N] [--chunks-per-loop K]
+                          [--loop-periodic] [--digest frames.digest] [--dump-features]
+                          [--aac audio.m4a] [--timeout SEC]
+"""
+
+import argparse
+import json
+import math
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent
+GENERATE_FRAMES = ROOT / "generate_frames"
+VIS_FPS = 60
+FFMPEG = ["ffmpeg", "-hide_banner", "-loglevel", "error", "-y"]
+# Per chunk: the shipped encode (generate_nft.sh), video only
+CHUNK_ARGS = ["-an", "-c:v", "libx264", "-pix_fmt", "yuv420p"]
+# The audio track, encoded once from the WAV
+AUDIO_ARGS = ["-vn", "-c:a", "aac"]
+MUX_ARGS = ["-map", "0:v:0", "-map", "1:a:0", "-c:v", "copy", "-c:a", "copy", "-shortest"]
+# How the MP4 and the AAC are made, for artifact cache keys
+AUDIO_PARAMS = " ".join(AUDIO_ARGS)
+VIDEO_PARAMS = " ".join(["y4m-chunked"] + CHUNK_ARGS + AUDIO_ARGS + MUX_ARGS)
+
+
+# ---- XXH64 for the manifest's total line (digest.h) ----------------------
+
+P1, P2, P3, P4, P5 = (0x9E3779B185EBCA87, 0xC2B2AE3D27D4EB4F, 0x165667B19E3779F9,
+                      0x85EBCA77C2B2AE63, 0x27D4EB2F165667C5)
+M64 = (1 << 64) - 1
+
+
+def _rotl(x, r):
+    return ((x << r) | (x >> (64 - r))) & M64
+
+
+def _round(acc, lane):
+    return _rotl((acc + lane * P2) & M64, 31) * P1 & M64
+
+
+def xxh64(data, seed=0):
+    n, i = len(data), 0
+    if n >= 32:
+        v = [(seed + P1 + P2) & M64, (seed + P2) & M64, seed, (seed - P1) & M64]
+        while i + 32 <= n:
+            for k, lane in enumerate(struct.unpack_from("<4Q", data, i)):
+                v[k] = _round(v[k], lane)
+            i += 32
+        h = (_rotl(v[0], 1) + _rotl(v[1], 7) + _rotl(v[2], 12) + _rotl(v[3], 18)) & M64
+        for x in v:
+            h = ((h ^ _round(0, x)) * P1 + P4) & M64
+    else:
+        h = (seed + P5) & M64
+    h = (h + n) & M64
+    while i + 8 <= n:
+        h = (_rotl(h ^ _round(0, struct.unpack_from("<Q", data, i)[0]), 27) * P1 + P4) & M64
+        i += 8
+    if i + 4 <= n:
+        h = (_rotl(h ^ (struct.unpack_from("<I", data, i)[0] * P1 & M64), 23) * P2 + P3) & M64
+        i += 4
+    while i < n:
+        h = _rotl(h ^ (data[i] * P5 & M64), 11) * P1 & M64
+        i += 1
+    h = (h ^ (h >> 33)) * P2 & M64
+    h = (h ^ (h >> 29)) * P3 & M64
+    return h ^ (h >> 32)
+
+
+def join_manifests(paths, out):
+    """One manifest from consecutive chunks' (digest.h): their part lines
+    under the first header, and the total line recomputed"""
+    header, parts, nbytes = None, [], 0
+    for p in paths:
+        lines = Path(p).read_text().splitlines()
+        header = header or lines[0]
+        parts += lines[1:-1]
+        nbytes += int(lines[-1].split()[2])
+    hashes = b"".join(struct.pack("<Q", int(line.split()[2], 16)) for line in parts)
+    with open(out, "w") as f:
+        f.write("\n".join([header, *parts]) + "\n")
+        f.write(f"total {len(parts)} {nbytes} {xxh64(hashes):016x}\n")
+
+
+# ---- planning and encoding -----------------------------------------------
+
+def probe(wav, seed, tmp, dump_features, timeout):
+    """(frame count, frames per loop) from generate_frames --metadata-only"""
+    meta = tmp / "meta.json"
+    cmd = [GENERATE_FRAMES, wav, seed, "--metadata-only", "--metadata", meta]
+    if dump_features:
+        cmd.append("--dump-features")  # written once here, read by every chunk
+    subprocess.run([str(c) for c in cmd], cwd=tmp, stdout=subprocess.DEVNULL, check=True,
+                   timeout=timeout or None)
+    with open(meta) as f:
+        m = json.load(f)
+    # rounded as generate_frames --loop-periodic rounds the WAV's loop
+    return int(m["frame_count"]), int(m["traits"]["loop_duration"] * VIS_FPS + 0.5)
+
+
+def plan_chunks(frames, loop_frames, per_loop):
+    """[start, end) ranges: loop points always cut, `per_loop` pieces per loop"""
+    if loop_frames <= 0 or loop_frames >= frames:
+        loop_frames = frames
+    cuts = set()
+    for base in range(0, frames, loop_frames):
+        span = min(loop_frames, frames - base)
+        cuts.update(base + span * j // per_loop for j in range(per_loop))
+    cuts = sorted(cuts) + [frames]
+    return [(a, b) for a, b in zip(cuts, cuts[1:]) if b > a]
+
+
+def encode_chunk(wav, seed, chunk, path, x264_threads, digest, timeout):
+    a, b = chunk
+    frames = [GENERATE_FRAMES, wav, seed, "--range", a, b, "--pipe-y4m"]
+    if digest:
+        frames += ["--digest", digest]
+    enc = FFMPEG + ["-f", "yuv4mpegpipe", "-i", "-"] + CHUNK_ARGS + ["-threads", x264_threads, path]
+    log = open(path.with_suffix(".log"), "wb")
+    with log:
+        gen = subprocess.Popen([str(c) for c in frames], cwd=path.parent, stdin=subprocess.DEVNULL,
+                               stdout=subprocess.PIPE, stderr=log)
+        ffm = subprocess.Popen([str(c) for c in enc], stdin=gen.stdout, stdout=subprocess.DEVNULL, stderr=log)
+        gen.stdout.close()  # ffmpeg owns the read end
+        try:
+            ok = ffm.wait(timeout=timeout or None) == 0
+            ok = gen.wait(timeout=timeout or None) == 0 and ok
+        except subprocess.TimeoutExpired:
+            gen.kill()
+            ffm.kill()
+            gen.wait()
+            ffm.wait()
+            ok = False
+    return ok
+
+
+def encode_audio(wav, path, timeout):
+    """The WAV to AAC at `path` (by way of a .part file)"""
+    part = path.with_name(path.name + ".part.m4a")
+    cmd = FFMPEG + ["-i", wav] + AUDIO_ARGS + [part]
+    try:
+        ok = subprocess.run([str(c) for c in cmd], stdin=subprocess.DEVNULL,
+                            timeout=timeout or None).returncode == 0
+    except subprocess.TimeoutExpired:
+        ok = False
+    if ok:
+        os.replace(part, path)
+    else:
+        part.unlink(missing_ok=True)
+    return ok
+
+
+def main():
+    cores = os.cpu_count() or 1
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("wav", help="the token's audio (segment --repeat 6)")
+    ap.add_argument("seed", help="transaction hash / seed")
+    ap.add_argument("out", help="output MP4")
+    ap.add_argument("--jobs", type=int, default=cores, help="chunks encoded at once (default: cores)")
+    ap.add_argument("--chunks-per-loop", type=int,
+                    help="pieces each loop is cut into (default: enough for --jobs)")
+    ap.add_argument("--loop-periodic", action="store_true",
+                    help="encode the first loop only and repeat its chunks")
+    ap.add_argument("--digest", help="frames manifest of the whole clip (not with --loop-periodic)")
+    ap.add_argument("--dump-features", action="store_true", help="write the WAV's .feat analysis cache")
+    ap.add_argument("--aac", help="encoded audio: muxed if it exists, else encoded from the WAV to here")
+    ap.add_argument("--timeout", type=float, default=1800, help="per-chunk timeout in seconds (0: none)")
+    args = ap.parse_args()
+    if args.digest and args.loop_periodic:
+        ap.error("--loop-periodic renders one loop; its frames are not the clip's (drop --digest)")
+    if args.jobs < 1:
+        ap.error("--jobs must be at least 1")
+    if not GENERATE_FRAMES.exists():
+        sys.exit(f"❌ {GENERATE_FRAMES} not found (make generate_frames)")
+    if not shutil.which("ffmpeg"):
+        sys.exit("❌ ffmpeg not found")
+
+    wav, out = Path(args.wav).resolve(), Path(args.out).resolve()
+    tmp = Path(tempfile.mkdtemp(prefix="chunk_encode.", dir=out.parent))
+    t0 = time.perf_counter()
+    try:
+        frames, loop_frames = probe(wav, args.seed, tmp, args.dump_features, args.timeout)
+        loops = math.ceil(frames / loop_frames) if 0 < loop_frames < frames else 1
+        encoded_loops = 1 if args.loop_periodic else loops
+        per_loop = args.chunks_per_loop or max(1, math.ceil(args.jobs / encoded_loops))
+        chunks = plan_chunks(frames, loop_frames, per_loop)
+        if args.loop_periodic and loops > 1:
+            chunks = [c for c in chunks if c[1] <= loop_frames]
+        x264_threads = max(1, cores // min(args.jobs, len(chunks)))
+        print(f"🎬 {frames} frames, {loops} loop(s) of {loop_frames}: {len(chunks)} chunks, "
+              f"{min(args.jobs, len(chunks))} at once, x264 threads {x264_threads}", flush=True)
+
+        paths = [tmp / f"chunk_{i:03d}.mp4" for i in range(len(chunks))]
+        digests = [p.with_suffix(".digest") if args.digest else None for p in paths]
+        aac = Path(args.aac).resolve() if args.aac else tmp / "audio.m4a"
+        reuse_aac = aac.exists()
+        if reuse_aac:
+            print(f"♻️  Encoded audio unchanged: {aac}", flush=True)
+        with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+            # The AAC is one more small job next to the chunks
+            audio_ok = pool.submit(lambda: reuse_aac or encode_audio(wav, aac, args.timeout))
+            oks = list(pool.map(lambda i: encode_chunk(wav, args.seed, chunks[i], paths[i], x264_threads,
+                                                      digests[i], args.timeout), range(len(chunks))))
+        for (a, b), p, ok in zip(chunks, paths, oks):
+            if not ok:
+                sys.exit(f"❌ Chunk {a}-{b - 1} failed (see {p.with_suffix('.log')})")
+        if not audio_ok.result():
+            sys.exit("❌ Audio encode failed")
+
+        # Every loop of a --loop-periodic clip is the same chunk files
+        listing = tmp / "chunks.txt"
+        with open(listing, "w") as f:
+            for _ in range(loops if args.loop_periodic else 1):
+                f.writelines(f"file '{p.name}'\n" for p in paths)
+        part = out.with_name(out.name + ".part.mp4")
+        mux = FFMPEG + ["-f", "concat", "-safe", "0", "-i", listing, "-i", aac] + MUX_ARGS + [part]
+        if subprocess.run([str(c) for c in mux], stdin=subprocess.DEVNULL).returncode != 0:
+            part.unlink(missing_ok=True)
+            sys.exit("❌ Concat/mux failed")
+        os.replace(part, out)
+        if args.digest:
+            join_manifests(digests, args.digest)
+    except subprocess.SubprocessError as e:
+        sys.exit(f"❌ {e}")
+    finally:
+        shutil.rmtree(tmp, ignore_errors=True)
+    print(f"🎉 {out} in {time.perf_counter() - t0:.1f}s", flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -5,46 +5,32 @@
 #include <math.h>
 #include <string.h>
 #include <ctype.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/wait.h>
 #include "src/include/visual_types.h"
 #include "src/include/deterministic_prng.h"
-
-// Deterministically hash a transaction hash to a 32-bit seed
-// Preserves deafbeef-style reproducibility while handling long hashes
-uint32_t hash_transaction_to_seed(const char* tx_hash) {
-    uint32_t seed = 0;
-    const char* hex_start = tx_hash;
-    
-    // Skip "0x" prefix if present
-    if (tx_hash[0] == '0' && (tx_hash[1] == 'x' || tx_hash[1] == 'X')) {
-        hex_start += 2;
-    }
-    
-    size_t len = strlen(hex_start);
-    
-    // XOR all 8-character chunks together for good distribution
-    for (int i = 0; i < len; i += 8) {
-        char chunk[9] = {0};
-        int chunk_len = (len - i >= 8) ? 8 : (len - i);
-        strncpy(chunk, hex_start + i, chunk_len);
-        
-        // Convert hex chunk to uint32_t and XOR into seed
-        uint32_t chunk_val = (uint32_t)strtoul(chunk, NULL, 16);
-        seed ^= chunk_val;
-    }
-    
-    // If seed is 0, use a fallback to avoid degenerate case
-    if (seed == 0) {
-        seed = 0xDEADBEEF;
-    }
-    
-    return seed;
-}
+#include "src/include/vis_color.h"
+#include "src/include/vis_ctx.h"
+#include "src/include/frame_writer.h"
+#include "src/include/vis_trig.h"
+#include "src/include/generate_frames.h"
+#include "src/include/av_encoder.h"
+#include "src/include/frame_palette.h"
+#include "src/include/gif_writer.h"
+#include "src/include/frame_delta.h"
+#include "src/c/include/crt_fx.h"
+#include "src/c/include/prof.h"
+#include "src/c/include/digest.h"
+#include "src/c/include/seed.h"
+#include "src/c/include/cpu_dispatch.h"
+#include "src/c/include/buf_alloc.h"
 
 // Forward declarations for ASM visual functions
-extern void clear_frame_asm(uint32_t *pixels, uint32_t color);
 extern void init_terrain_asm(uint32_t seed, float base_hue);
 extern void draw_terrain_asm(uint32_t *pixels, int frame);
-extern void draw_terrain_enhanced_asm(uint32_t *pixels, int frame, float audio_level);
 // Particles removed for now
 // extern void init_particles_asm(void);
 // extern void update_particles_asm(float elapsed_ms, float step_sec, float base_hue);
@@ -52,28 +38,16 @@ extern void draw_terrain_enhanced_asm(uint32_t *pixels, int frame, float audio_l
 extern void init_glitch_system_asm(uint32_t seed, float intensity);
 extern void update_glitch_intensity_asm(float new_intensity);
 extern void init_bass_hits_asm(void);
-extern void draw_bass_hits_asm(uint32_t *pixels, int frame);
-extern void update_bass_hits_asm(float elapsed_ms);
-extern uint32_t circle_color_asm(float hue, float saturation, float value);
+extern void update_bass_hits_asm(float elapsed_ms, float step_sec, float base_hue, uint32_t seed);
+extern int *get_last_bass_step_ptr_asm(void);
 extern void draw_circle_filled_asm(uint32_t *pixels, int cx, int cy, int radius, uint32_t color);
-extern void draw_ascii_char_asm(uint32_t *pixels, int x, int y, char c, uint32_t color, int bg_alpha);
-
-// Global pixels buffer for shape drawing
-static uint32_t *g_current_pixels = NULL;
-void set_current_pixels(uint32_t *pixels) { g_current_pixels = pixels; }
-
-// Workload budget system for 60 FPS stability
-typedef struct {
-    int max_projectiles;      // Dynamic cap on active projectiles
-    int max_boss_shapes;      // Dynamic cap on boss formation complexity
-    int min_firing_cooldown;  // Dynamic minimum between shots
-    float complexity_factor;  // 0.0-1.0 based on audio intensity
-} workload_budget_t;
-
-static workload_budget_t g_budget = {0};
+extern uint32_t *vis_dirty_tiles; // frame_tiles_t rows of the frame being drawn
 
 // Workload budget management
-void update_workload_budget(float audio_level) {
+#define BUDGET_MAX_PROJECTILES 24   // VIS_BUDGET_MAX: roomier than the 60 fps caps
+#define BUDGET_ADAPTIVE_GAIN   0.05f
+
+void update_workload_budget(vis_ctx_t *ctx, float audio_level) {
     // AGGRESSIVE budget to maintain 60 FPS - performance over visual complexity
     
     // Drastically reduced base budgets for 60 FPS stability
@@ -82,138 +56,119 @@ void update_workload_budget(float audio_level) {
     int base_cooldown = 10;    // Reduced from 15
     
     // Audio intensity factor (0.0 = quiet, 1.0 = loud)
-    g_budget.complexity_factor = audio_level;
+    ctx->budget.complexity_factor = audio_level;
+    
+    // Offline renders have no frame deadline: largest caps on every frame
+    if (ctx->budget_policy.mode == VIS_BUDGET_MAX) {
+        ctx->budget.max_projectiles = BUDGET_MAX_PROJECTILES;
+        ctx->budget.max_boss_shapes = 4;
+        ctx->budget.min_firing_cooldown = 5;
+        ctx->budget.draw_ship_boss = true;
+        return;
+    }
+    
+    // Adaptive mode shrinks the audio-driven headroom when frames run long;
+    // at quality 1 it matches the audio policy exactly
+    float q = ctx->budget_policy.mode == VIS_BUDGET_ADAPTIVE ? ctx->budget_policy.quality : 1.0f;
     
     // Scale projectiles: 2-6 based on audio, capped at 6 for performance
-    g_budget.max_projectiles = base_projectiles + (int)(audio_level * 4);
-    if (g_budget.max_projectiles > 6) g_budget.max_projectiles = 6;
+    ctx->budget.max_projectiles = base_projectiles + (int)(audio_level * 4 * q);
+    if (ctx->budget.max_projectiles > 6) ctx->budget.max_projectiles = 6;
     
     // Scale boss complexity: 2-4 shapes max, very conservative
-    g_budget.max_boss_shapes = base_boss_shapes + (int)(audio_level * 2);
-    if (g_budget.max_boss_shapes > 4) g_budget.max_boss_shapes = 4;
+    ctx->budget.max_boss_shapes = base_boss_shapes + (int)(audio_level * 2 * q);
+    if (ctx->budget.max_boss_shapes > 4) ctx->budget.max_boss_shapes = 4;
     
     // Faster firing on loud sections, but not too fast
-    g_budget.min_firing_cooldown = base_cooldown - (int)(audio_level * 6);
-    if (g_budget.min_firing_cooldown < 5) g_budget.min_firing_cooldown = 5;
+    ctx->budget.min_firing_cooldown = base_cooldown - (int)(audio_level * 6 * q);
+    if (ctx->budget.min_firing_cooldown < 5) ctx->budget.min_firing_cooldown = 5;
+    
+    // Skip ship and boss on intense frames (on more of them when slow)
+    ctx->budget.draw_ship_boss = audio_level < 0.8f * q;
 }
 
-// Projectile system for ship firing
-typedef struct {
-    float x, y;           // Position
-    float vx, vy;         // Velocity
-    char character;       // ASCII character ('o', 'x', '-', '0', etc.)
-    uint32_t color;       // Projectile color
-    int life;             // Remaining life frames
-    bool active;          // Is this projectile active?
-} projectile_t;
-
-#define MAX_PROJECTILES 32
-#define VIS_WIDTH 800
-#define VIS_HEIGHT 600
-static projectile_t projectiles[MAX_PROJECTILES] = {0};
-static int last_shot_frame = -100; // Frame when last shot was fired
-
-// Enhanced boss shape system using all 5 ASM shapes with diversity
-extern void draw_ascii_triangle_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
-extern void draw_ascii_diamond_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
-extern void draw_ascii_hexagon_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
-extern void draw_ascii_star_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
-extern void draw_ascii_square_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
-
-void draw_boss_shape(float cx, float cy, int shape_type, int size, float rotation, float hue, float saturation, float value, int frame) {
-    if (!g_current_pixels) return; // Safety check
-    
-    uint32_t color = circle_color_asm(hue, saturation, value);
-    int alpha = 255; // Full opacity for boss shapes
-    
-    // Use all 5 ASM shapes with proper parameters
-    switch(shape_type) {
-        case 0: // Triangle
-            draw_ascii_triangle_asm(g_current_pixels, (int)cx, (int)cy, size, rotation, color, alpha, frame);
-            break;
-        case 1: // Diamond  
-            draw_ascii_diamond_asm(g_current_pixels, (int)cx, (int)cy, size, rotation, color, alpha, frame);
-            break;
-        case 2: // Hexagon
-            draw_ascii_hexagon_asm(g_current_pixels, (int)cx, (int)cy, size, rotation, color, alpha, frame);
-            break;
-        case 3: // Star
-            draw_ascii_star_asm(g_current_pixels, (int)cx, (int)cy, size, rotation, color, alpha, frame);
-            break;
-        case 4: // Square
-            draw_ascii_square_asm(g_current_pixels, (int)cx, (int)cy, size, rotation, color, alpha, frame);
-            break;
-    }
+// Feedback for VIS_BUDGET_ADAPTIVE: nudge quality towards the render time
+// budget after each frame.  Timing-driven, so adaptive renders are not
+// reproducible; use it for previews, not for slices or final output.
+void workload_budget_feedback(vis_ctx_t *ctx, double frame_ms) {
+    vis_budget_policy_t *bp = &ctx->budget_policy;
+    if (bp->mode != VIS_BUDGET_ADAPTIVE) return;
+    
+    bp->avg_ms = bp->avg_ms > 0.0f ? bp->avg_ms * 0.9f + (float)frame_ms * 0.1f : (float)frame_ms;
+    bp->quality += BUDGET_ADAPTIVE_GAIN * (bp->target_ms - bp->avg_ms) / bp->target_ms;
+    if (bp->quality < 0.0f) bp->quality = 0.0f;
+    if (bp->quality > 1.0f) bp->quality = 1.0f;
+}
+
+// One boss shape through its asm kernel: the spiral and pulsing formations,
+// whose shapes change size and rotation every frame
+void emit_boss_shape(vis_ctx_t *ctx, float cx, float cy, int shape_type, int size, float rotation, float hue, float saturation, float value) {
+    uint32_t color = vis_hsv_pixel(hue, saturation, value);
+    vis_dl_shape(&ctx->dl, (int)cx, (int)cy, shape_type, size, rotation, color);
 }
 
 // Projectile system functions
-void spawn_projectile(float ship_x, float ship_y, float boss_x, float boss_y, uint32_t seed) {
-    // Count active projectiles first
-    int active_count = 0;
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        if (projectiles[i].active) active_count++;
-    }
+void spawn_projectile(vis_ctx_t *ctx, float ship_x, float ship_y, float boss_x, float boss_y, int frame) {
+    projectile_pool_t *pool = &ctx->projectiles;
     
     // Respect workload budget - don't spawn if at cap
-    if (active_count >= g_budget.max_projectiles) {
+    if (pool->count >= ctx->budget.max_projectiles) {
         return; // Budget exceeded, skip this projectile
     }
     
-    // Find an inactive projectile slot
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        if (!projectiles[i].active) {
-            // Seed-based projectile type selection
-            prng_seed(&g_projectile_prng, seed + i);
-            char projectile_chars[] = {'o', 'x', '-', '0', '*', '+', '>', '=', '~'};
-            int char_count = sizeof(projectile_chars) / sizeof(projectile_chars[0]);
-            
-            projectiles[i].x = ship_x + 20; // Start slightly ahead of ship
-            projectiles[i].y = ship_y;
-            
-            // Calculate velocity towards boss
-            float dx = boss_x - ship_x;
-            float dy = boss_y - ship_y;
-            float distance = sqrt(dx*dx + dy*dy);
-            float speed = 8.0f; // Pixels per frame
-            
-            projectiles[i].vx = (dx / distance) * speed;
-            projectiles[i].vy = (dy / distance) * speed;
-            projectiles[i].character = projectile_chars[prng_range(&g_projectile_prng, char_count)];
-            projectiles[i].color = circle_color_asm(0.1f + prng_range(&g_projectile_prng, 100) / 1000.0f, 1.0f, 1.0f); // Yellowish
-            projectiles[i].life = 120; // 2 seconds at 60fps
-            projectiles[i].active = true;
-            break;
-        }
-    }
+    int i = projectile_pool_alloc(pool);
+    if (i < 0) return;
+    projectile_t *p = &pool->slots[i];
+    
+    // Seed-based projectile type selection: at most one shot per frame
+    char projectile_chars[] = {'o', 'x', '-', '0', '*', '+', '>', '=', '~'};
+    int char_count = sizeof(projectile_chars) / sizeof(projectile_chars[0]);
+    
+    p->x = ship_x + 20; // Start slightly ahead of ship
+    p->y = ship_y;
+    
+    // Calculate velocity towards boss
+    float dx = boss_x - ship_x;
+    float dy = boss_y - ship_y;
+    float distance = sqrt(dx*dx + dy*dy);
+    float speed = 8.0f; // Pixels per frame
+    
+    p->vx = (dx / distance) * speed;
+    p->vy = (dy / distance) * speed;
+    p->character = projectile_chars[prng_at_range(ctx->prng.seed, PRNG_STREAM_PROJECTILE, frame, 0, char_count)];
+    p->color = vis_hsv_pixel(0.1f + prng_at_range(ctx->prng.seed, PRNG_STREAM_PROJECTILE, frame, 1, 100) / 1000.0f, 1.0f, 1.0f); // Yellowish
+    p->life = 120; // 2 seconds at 60fps
 }
 
-void update_projectiles(void) {
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        if (projectiles[i].active) {
-            // Move projectile
-            projectiles[i].x += projectiles[i].vx;
-            projectiles[i].y += projectiles[i].vy;
-            projectiles[i].life--;
-            
-            // Deactivate if off screen or life expired
-            if (projectiles[i].x < 0 || projectiles[i].x >= VIS_WIDTH ||
-                projectiles[i].y < 0 || projectiles[i].y >= VIS_HEIGHT ||
-                projectiles[i].life <= 0) {
-                projectiles[i].active = false;
-            }
+void update_projectiles(vis_ctx_t *ctx) {
+    projectile_pool_t *pool = &ctx->projectiles;
+    int kept = 0;
+    for (int n = 0; n < pool->count; n++) {
+        int i = pool->live[n];
+        projectile_t *p = &pool->slots[i];
+        
+        // Move projectile
+        p->x += p->vx;
+        p->y += p->vy;
+        p->life--;
+        
+        // Deactivate if off screen or life expired
+        if (p->x < 0 || p->x >= VIS_WIDTH ||
+            p->y < 0 || p->y >= VIS_HEIGHT ||
+            p->life <= 0) {
+            projectile_pool_release(pool, i);
+        } else {
+            pool->live[kept++] = (uint16_t)i;
         }
     }
+    pool->count = kept;
 }
 
-void draw_projectiles(void) {
-    if (!g_current_pixels) return;
-    
-    for (int i = 0; i < MAX_PROJECTILES; i++) {
-        if (projectiles[i].active) {
-            draw_ascii_char_asm(g_current_pixels, 
-                (int)projectiles[i].x, (int)projectiles[i].y,
-                projectiles[i].character, projectiles[i].color, 255);
-        }
+void emit_projectiles(vis_ctx_t *ctx) {
+    const projectile_pool_t *pool = &ctx->projectiles;
+    for (int n = 0; n < pool->count; n++) {
+        const projectile_t *p = &pool->slots[pool->live[n]];
+        vis_dl_glyph(&ctx->dl, (int)p->x, (int)p->y, p->character, p->color);
     }
 }
 
@@ -222,77 +177,190 @@ void draw_projectiles(void) {
 void init_audio_visual_mapping(void);
 float get_smoothed_audio_level(int frame);
 void update_audio_visual_effects(int frame, float base_hue);
+void set_audio_visual_event_triggers(bool on);
 float get_audio_driven_glitch_intensity(int frame);
 float get_audio_driven_hue_shift(int frame);
+size_t audio_visual_state_bytes(void);
+void audio_visual_state_save(void *dst);
+void audio_visual_state_load(const void *src);
 
 // Audio functions
 bool load_wav_file(const char *filename);
+bool load_wav_memory(const void *data, size_t len, const char *name);
+bool attach_audio_features(const char *wav_path, bool dump);
+bool analyse_audio_features(void);
 float get_audio_rms_for_frame(int frame);
 float get_audio_bpm(void);
 float get_max_rms(void);
 float get_audio_duration(void); // Get actual audio duration in seconds
+float get_audio_loop_period(void); // One loop of a --repeat track, 0 if untagged
+const int16_t *get_audio_samples(uint32_t *frames, uint32_t *sample_rate, int *channels);
 bool is_audio_finished(int frame);
 void print_audio_info(void);
 void cleanup_audio_data(void);
 
 #define FRAME_TIME_MS (1000 / VIS_FPS)
 
-// PPM image output helpers
-static inline void write_frame_ppm(FILE *out, uint32_t *pixels) {
-    // Each frame carries its own header (PPM P6) for ffmpeg image2pipe
-    fprintf(out, "P6\n%d %d\n255\n", VIS_WIDTH, VIS_HEIGHT);
-    for (int y = 0; y < VIS_HEIGHT; y++) {
-        for (int x = 0; x < VIS_WIDTH; x++) {
-            uint32_t pixel = pixels[y * VIS_WIDTH + x];
-            uint8_t r = (pixel >> 16) & 0xFF;
-            uint8_t g = (pixel >> 8) & 0xFF;
-            uint8_t b = pixel & 0xFF;
-            fwrite(&r, 1, 1, out);
-            fwrite(&g, 1, 1, out);
-            fwrite(&b, 1, 1, out);
+// PPM image output: a writer thread packs and emits finished frames
+// (src/frame_writer.c) while the loop below renders the next one
+#define FRAME_QUEUE_DEPTH 4
+static frame_writer_t g_frame_writer;
+static frame_queue_t g_frame_queue;
+
+// --crt: phosphor trails, scanlines, chroma shift, bleed and noise
+// (src/c/src/crt_fx.c) on every frame before it is queued.  Trails carry
+// over between frames, so a slice renders CRT_WARMUP_FRAMES frames before
+// its first one into a scratch buffer; after that the trail differs from a
+// full render by at most one step per channel.  Jitter and frame drops are
+// realtime-only.
+#define CRT_WARMUP_FRAMES 240
+static crt_fx_t g_crt_fx;
+
+// --threads N: one forked worker per contiguous slice of the frame range.
+// The visual asm modules keep their state in __DATA globals, so workers are
+// processes rather than threads; each starts from a copy of the fully set up
+// parent (WAV mapping, sidecar, timeline signals) instead of reloading it,
+// and renders exactly what `--range <slice>` would.  The parent is the
+// reorder stage: worker 0 streams straight to the pipe, later workers spool
+// to unlinked temp files that are appended in slice order.
+#define MAX_FRAME_WORKERS 64
+
+typedef struct {
+    pid_t pid;
+    int start, end;       // frames [start, end)
+    int spool_fd;         // pipe mode, workers > 0
+} frame_worker_t;
+
+static frame_worker_t g_workers[MAX_FRAME_WORKERS];
+
+static int open_spool(void) {
+    const char *dir = getenv("TMPDIR");
+    char path[512];
+    snprintf(path, sizeof(path), "%s/generate_frames.XXXXXX", dir && *dir ? dir : "/tmp");
+    int fd = mkstemp(path);
+    if (fd >= 0) unlink(path);
+    return fd;
+}
+
+// Fork `n` workers over [start, end); returns the worker index in a child
+// and -1 in the parent (which must then call join_frame_workers)
+static int fork_frame_workers(int n, int start, int end, bool pipe_out, bool *failed) {
+    *failed = false;
+    int total = end - start;
+    for (int i = 0; i < n; i++) {
+        frame_worker_t *w = &g_workers[i];
+        w->start = start + (int)((long)total * i / n);
+        w->end = start + (int)((long)total * (i + 1) / n);
+        w->spool_fd = -1;
+        w->pid = -1;
+        if (pipe_out && i > 0 && (w->spool_fd = open_spool()) < 0) {
+            fprintf(stderr, "❌ Could not create a spool file for worker %d\n", i);
+            *failed = true;
+            return -1;
         }
     }
-    fflush(out);
+    fflush(NULL); // children must not replay buffered parent output
+    for (int i = 0; i < n; i++) {
+        pid_t pid = fork();
+        if (pid == 0) return i;
+        if (pid < 0) {
+            fprintf(stderr, "❌ Could not start worker %d\n", i);
+            *failed = true;
+            return -1;
+        }
+        g_workers[i].pid = pid;
+    }
+    return -1;
 }
 
-void save_frame_as_ppm(uint32_t *pixels, int frame_num) {
-    char filename[256];
-    snprintf(filename, sizeof(filename), "frame_%04d.ppm", frame_num);
-    FILE *f = fopen(filename, "wb");
-    if (!f) { fprintf(stderr, "Could not create %s\n", filename); return; }
-    write_frame_ppm(f, pixels);
-    fclose(f);
-    fprintf(stderr, "✅ Generated frame_%04d.ppm\n", frame_num);
+static int copy_spool(int from, int to) {
+    static uint8_t chunk[1 << 20];
+    if (lseek(from, 0, SEEK_SET) != 0) return -1;
+    for (;;) {
+        ssize_t n = read(from, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return (int)n;
+        for (ssize_t off = 0; off < n; ) {
+            ssize_t m = write(to, chunk + off, (size_t)(n - off));
+            if (m < 0 && errno == EINTR) continue;
+            if (m < 0) return -1;
+            off += m;
+        }
+    }
+}
+
+// Wait for the workers in slice order, appending spools to `out_fd`; on the
+// first failure the remaining workers are stopped.  0 if every slice made it.
+static int join_frame_workers(int n, int out_fd) {
+    int rc = 0;
+    for (int i = 0; i < n; i++) {
+        frame_worker_t *w = &g_workers[i];
+        if (w->pid > 0) {
+            if (rc != 0) kill(w->pid, SIGTERM);
+            int status = 0;
+            while (waitpid(w->pid, &status, 0) < 0 && errno == EINTR) {}
+            if (rc == 0 && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+                fprintf(stderr, "❌ Worker %d (frames %d-%d) failed\n", i, w->start, w->end - 1);
+                rc = -1;
+            }
+        } else {
+            rc = -1;
+        }
+        if (w->spool_fd >= 0) {
+            if (rc == 0 && copy_spool(w->spool_fd, out_fd) != 0) {
+                fprintf(stderr, "❌ Could not forward frames %d-%d\n", w->start, w->end - 1);
+                rc = -1;
+            }
+            close(w->spool_fd);
+        }
+    }
+    return rc;
 }
 
 // Custom top terrain drawing function
-void draw_top_terrain(uint32_t *pixels, int frame, float hue, float audio_level) {
+// Phase per pixel of the top terrain swell: 0.03 rad as a binary angle
+#define TOP_TERRAIN_PHASE_STEP 20506958u
+
+void emit_top_terrain(vis_dlist_t *dl, int frame, float hue, float audio_level) {
     // Simple procedural top terrain using different algorithm
     const int char_width = 8; // Use proper 8x12 glyph spacing
     const int char_height = 12;
     const char terrain_chars[] = "^^^^====~~~~----____";
     const int num_chars = 20;
-    const int char_alpha = 255; // Fully opaque - this was the bug!
+    const int columns = VIS_WIDTH / char_width;
     
     // Create brighter color based on hue
-    uint32_t color = circle_color_asm(hue, 1.0f, 1.0f); // Full brightness and saturation
+    uint32_t color = vis_hsv_pixel(hue, 1.0f, 1.0f); // Full brightness and saturation
+    
+    // Audio-reactive height - different response than bottom
+    int height_variation = (int)(audio_level * 8) + 3; // Audio variation
     
-    // Generate terrain from top down - make it much more visible
-    for (int x = 0; x < VIS_WIDTH; x += char_width) {
+    // One glyph and one height per column
+    char glyphs[VIS_WIDTH / 8];
+    int y_offsets[VIS_WIDTH / 8];
+    for (int col = 0; col < columns; col++) {
+        int x = col * char_width;
         // Use different pattern than bottom terrain
         int pattern = (x / char_width + frame / 2) % num_chars;
-        char c = terrain_chars[pattern];
-        
-        // Audio-reactive height - different response than bottom
-        int height_variation = (int)(audio_level * 8) + 3; // Audio variation
-        int y_offset = (int)(sin((x + frame * 3) * 0.03f) * height_variation);
-        
-        // Draw multiple rows for thickness, from top down
-        for (int row = 0; row < 6 + height_variation; row++) {
-            int y = row * char_height + y_offset + 10; // Start 10 pixels from top
+        glyphs[col] = terrain_chars[pattern];
+        y_offsets[col] = vis_sin_q16((vis_angle_t)(x + frame * 3) * TOP_TERRAIN_PHASE_STEP) * height_variation / 65536;
+    }
+    
+    int text = vis_dl_text(dl, glyphs, columns);
+    if (text < 0) return;
+    
+    // Draw multiple rows for thickness, from top down; neighbouring columns
+    // at the same height share a glyph run
+    for (int row = 0; row < 6 + height_variation; row++) {
+        for (int start = 0; start < columns; ) {
+            int end = start + 1;
+            while (end < columns && y_offsets[end] == y_offsets[start]) end++;
+            
+            int y = row * char_height + y_offsets[start] + 10; // Start 10 pixels from top
             if (y >= 0 && y < VIS_HEIGHT / 2) { // Use top half
-                draw_ascii_char_asm(pixels, x, y, c, color, char_alpha);
+                vis_dl_glyph_run(dl, start * char_width, y, text + start, end - start, color);
             }
+            start = end;
         }
     }
 }
@@ -331,265 +399,232 @@ ship_components_t ship_parts = {
         " *** ", // Stars
         " ... "  // Dots
     },
-    .sizes = {1, 2, 3} // Size multipliers
+    .sizes = SHIP_SIZES // Size multipliers
 };
 
 // Ship flying through the terrain corridor
-void draw_ship(uint32_t *pixels, int frame, float hue, float audio_level, uint32_t seed) {
-    // Ship position on LEFT side of screen (leaving room for enemies)
+// Ship position on LEFT side of screen (leaving room for enemies)
+static void ship_position(int frame, float audio_level, int *x, int *y) {
     float base_x = VIS_WIDTH * 0.15f; // 15% from left (moved further left)
     float center_y = VIS_HEIGHT / 2.0f;
     
     // Audio-reactive movement - enhanced for bigger ship
-    float sway = sin(frame * 0.05f) * 40.0f; // Side-to-side movement  
-    float bob = sin(frame * 0.08f) * 30.0f;  // Up-down movement
+    float sway = vis_sinf(frame * 0.05f) * 40.0f; // Side-to-side movement  
+    float bob = vis_sinf(frame * 0.08f) * 30.0f;  // Up-down movement
     float audio_dodge = audio_level * 35.0f; // React to audio
     
-    // Calculate final position
-    int ship_x = (int)(base_x + sway + audio_dodge);
-    int ship_y = (int)(center_y + bob);
-    
-    // Calculate boss position for targeting (using same logic as draw_enemy_boss)
-    float boss_base_x = VIS_WIDTH * 0.75f;
-    float boss_center_y = VIS_HEIGHT / 2.0f;
-    float boss_hover = sin(frame * 0.03f) * 20.0f;
-    float boss_pulse = sin(frame * 0.12f) * 15.0f;
-    float boss_audio_react = audio_level * 25.0f;
-    int boss_x = (int)(boss_base_x + boss_hover - boss_audio_react);
-    int boss_y = (int)(boss_center_y + boss_pulse);
-    
-    // Ship firing logic - budget-aware firing rate
-    if (frame - last_shot_frame >= g_budget.min_firing_cooldown) {
-        spawn_projectile(ship_x, ship_y, boss_x, boss_y, seed + frame);
-        last_shot_frame = frame;
-    }
-    
-    // Seed-based ship design selection
-    prng_seed(&g_ship_prng, seed);
-    int nose_type = prng_range(&g_ship_prng, 4);
-    int body_type = prng_range(&g_ship_prng, 4);
-    int wing_type = prng_range(&g_ship_prng, 4); 
-    int trail_type = prng_range(&g_ship_prng, 4);
-    int size = ship_parts.sizes[prng_range(&g_ship_prng, 3)];
+    *x = (int)(base_x + sway + audio_dodge);
+    *y = (int)(center_y + bob);
+}
+
+// Boss position on RIGHT side of screen (75% from left)
+static void boss_position(int frame, float audio_level, int *x, int *y) {
+    float base_x = VIS_WIDTH * 0.75f;
+    float center_y = VIS_HEIGHT / 2.0f;
+    
+    // Audio-reactive movement - different pattern from ship
+    float hover = vis_sinf(frame * 0.03f) * 20.0f; // Slower hovering movement
+    float pulse = vis_sinf(frame * 0.12f) * 15.0f; // Pulsing motion
+    float audio_react = audio_level * 25.0f; // React to audio differently
+    
+    *x = (int)(base_x + hover - audio_react); // Move left on audio hits
+    *y = (int)(center_y + pulse);
+}
+
+// Ship firing logic - budget-aware firing rate, aimed at the boss
+void ship_fire(vis_ctx_t *ctx, int frame, float audio_level) {
+    if (frame - ctx->last_shot_frame < ctx->budget.min_firing_cooldown) return;
+    
+    int ship_x, ship_y, boss_x, boss_y;
+    ship_position(frame, audio_level, &ship_x, &ship_y);
+    boss_position(frame, audio_level, &boss_x, &boss_y);
+    spawn_projectile(ctx, ship_x, ship_y, boss_x, boss_y, frame);
+    ctx->last_shot_frame = frame;
+}
+
+// Seed-based ship design selection and palette, once per render
+void ship_template_init(ship_template_t *t, uint32_t seed) {
+    prng_t rng;
+    prng_seed(&rng, seed);
+    int size_pick;
+    ship_design_pick(&rng, t->parts, &size_pick);
+    t->size = ship_parts.sizes[size_pick];
     
     // Seed-based colors - create unique palette
-    float primary_hue = prng_float(&g_ship_prng);
+    float primary_hue = prng_float(&rng);
     float secondary_hue = primary_hue + 0.3f;
     if (secondary_hue > 1.0f) secondary_hue -= 1.0f;
     
-    uint32_t primary_color = circle_color_asm(primary_hue, 1.0f, 1.0f);
-    uint32_t secondary_color = circle_color_asm(secondary_hue, 0.8f, 0.9f);
+    t->primary_color = vis_hsv_pixel(primary_hue, 1.0f, 1.0f);
+    t->secondary_color = vis_hsv_pixel(secondary_hue, 0.8f, 0.9f);
     
-    // Selected ship components
-    const char* nose = ship_parts.nose_patterns[nose_type];
-    const char* body = ship_parts.body_patterns[body_type];
-    const char* wings = ship_parts.wing_patterns[wing_type];
-    const char* trail = ship_parts.trail_patterns[trail_type];
+    // Selected ship components, spread to the ship's glyph spacing
+    const char *parts[4] = {
+        ship_parts.nose_patterns[t->parts[0]],
+        ship_parts.wing_patterns[t->parts[1]],
+        ship_parts.body_patterns[t->parts[2]],
+        ship_parts.trail_patterns[t->parts[3]]
+    };
+    t->row_len = 5 * t->size;
+    for (int r = 0; r < 4; r++) {
+        memset(t->rows[r], ' ', sizeof(t->rows[r]));
+        for (int i = 0; i < 5; i++) {
+            t->rows[r][i * t->size] = parts[r][i];
+        }
+    }
+}
+
+void emit_ship(vis_ctx_t *ctx, int frame, float audio_level) {
+    int ship_x, ship_y;
+    ship_position(frame, audio_level, &ship_x, &ship_y);
     
+    const ship_template_t *t = &ctx->ship;
+    int size = t->size;
     int char_spacing = 8 * size;
     int line_spacing = 12 * size;
+    int text[4];
+    for (int r = 0; r < 4; r++) {
+        text[r] = vis_dl_text(&ctx->dl, t->rows[r], t->row_len);
+        if (text[r] < 0) return;
+    }
     
-    // Draw ship layers (bigger and more detailed)
+    // Draw ship layers (bigger and more detailed): nose, wings, body, trail
     for (int layer = 0; layer < size; layer++) {
         int offset_y = layer * 2; // Slight layer offset
         
-        // Nose (top)
-        for (int i = 0; i < 5; i++) {
-            if (nose[i] != ' ') {
-                for (int s = 0; s < size; s++) {
-                    draw_ascii_char_asm(pixels, 
-                        ship_x + (i-2)*char_spacing + s*4, 
-                        ship_y - line_spacing*2 + offset_y, 
-                        nose[i], primary_color, 255);
-                }
-            }
-        }
-        
-        // Wings (upper middle)
-        for (int i = 0; i < 5; i++) {
-            if (wings[i] != ' ') {
-                for (int s = 0; s < size; s++) {
-                    draw_ascii_char_asm(pixels, 
-                        ship_x + (i-2)*char_spacing + s*4, 
-                        ship_y - line_spacing + offset_y, 
-                        wings[i], secondary_color, 255);
-                }
-            }
-        }
-        
-        // Body (center) 
-        for (int i = 0; i < 5; i++) {
-            if (body[i] != ' ') {
-                for (int s = 0; s < size; s++) {
-                    draw_ascii_char_asm(pixels, 
-                        ship_x + (i-2)*char_spacing + s*4, 
-                        ship_y + offset_y, 
-                        body[i], primary_color, 255);
-                }
-            }
-        }
-        
-        // Trail (bottom)
-        for (int i = 0; i < 5; i++) {
-            if (trail[i] != ' ') {
-                for (int s = 0; s < size; s++) {
-                    draw_ascii_char_asm(pixels, 
-                        ship_x + (i-2)*char_spacing + s*4, 
-                        ship_y + line_spacing + offset_y, 
-                        trail[i], secondary_color, 255);
-                }
+        for (int r = 0; r < 4; r++) {
+            uint32_t color = (r % 2) ? t->secondary_color : t->primary_color;
+            int y = ship_y + (r - 2) * line_spacing + offset_y;
+            for (int s = 0; s < size; s++) {
+                vis_dl_glyph_run(&ctx->dl, ship_x - 2*char_spacing + s*4, y, text[r], t->row_len, color);
             }
         }
     }
 }
 
 // Enhanced boss system with massive diversity - mix and match shapes, sizes, colors
-void draw_enemy_boss(uint32_t *pixels, int frame, float hue, float audio_level, uint32_t seed) {
-    // Boss position on RIGHT side of screen (75% from left)
-    float base_x = VIS_WIDTH * 0.75f; // 75% from left
-    float center_y = VIS_HEIGHT / 2.0f;
-    
-    // Audio-reactive movement - different pattern from ship
-    float hover = sin(frame * 0.03f) * 20.0f; // Slower hovering movement
-    float pulse = sin(frame * 0.12f) * 15.0f; // Pulsing motion
-    float audio_react = audio_level * 25.0f; // React to audio differently
-    
-    // Calculate final position
-    int boss_x = (int)(base_x + hover - audio_react); // Move left on audio hits
-    int boss_y = (int)(center_y + pulse);
-    
-    // Seed-based boss design with MASSIVE DIVERSITY
-    prng_seed(&g_boss_prng, seed + 0x1000); // Different seed offset for boss variety
+
+static boss_part_t *boss_add_part(boss_layout_t *l, int shape, int size, int dx, int dy, float rotation,
+                                  float hue_offset, float sat, float val) {
+    boss_part_t *p = &l->parts[l->num_parts++];
+    *p = (boss_part_t){ .shape = shape, .size = size, .dx = dx, .dy = dy, .rotation = rotation,
+                        .hue_offset = { hue_offset, 0.0f }, .sat = sat, .val = val };
+    return p;
+}
+
+// Lay out the static formations for one budget variant.  Every variant
+// replays the same PRNG stream from the top, so the draws a shape gets do
+// not depend on how many shapes follow it.
+static void boss_layout_build(boss_template_t *t, boss_layout_t *l, int variant, uint32_t seed) {
+    prng_t rng;
+    prng_seed(&rng, seed + BOSS_SEED_OFFSET); // Different seed offset for boss variety
     
     // 1. Random formation type (8 different formation patterns)
-    int formation_type = prng_range(&g_boss_prng, 8);
-    
     // 2. Budget-aware number of components (respects workload cap)
-    int max_shapes = (g_budget.max_boss_shapes > 3) ? g_budget.max_boss_shapes : 3;
-    int num_components = 3 + prng_range(&g_boss_prng, max_shapes - 2);
+    int num_components;
+    boss_design_pick(&rng, variant, &t->formation, &num_components);
     
     // 3. Base boss hue with variety
-    float boss_base_hue = hue + prng_float(&g_boss_prng); // More hue variety
-    if (boss_base_hue > 1.0f) boss_base_hue -= 1.0f;
+    t->hue_offset = prng_float(&rng); // More hue variety
     
     // 4. Size variety (small to massive)
-    int base_size = 15 + prng_range(&g_boss_prng, 25); // Size range: 15-40
+    int base_size = 15 + prng_range(&rng, 25); // Size range: 15-40
     
     // 5. Rotation variety
-    float base_rotation = prng_range(&g_boss_prng, 360) * M_PI / 180.0f;
+    float base_rotation = prng_range(&rng, 360) * M_PI / 180.0f;
+    
+    t->base_size = base_size;
+    t->base_rotation = base_rotation;
+    l->num_components = num_components;
+    l->num_parts = 0;
     
-    // Draw diverse boss formations
-    switch(formation_type) {
+    switch(t->formation) {
         case 0: // Star Burst Formation - mixed shapes radiating outward
             for (int i = 0; i < num_components; i++) {
                 float angle = (2.0f * M_PI * i) / num_components;
                 float radius = 30 + (i * 15); // Expanding radius
-                int shape = prng_range(&g_boss_prng, 5); // All 5 shapes
-                int size = base_size + prng_range(&g_boss_prng, 15) - 7; // Size variety ±7
-                float shape_hue = boss_base_hue + (i * 0.1f); 
-                if (shape_hue > 1.0f) shape_hue -= 1.0f;
-                float sat = 0.7f + prng_range(&g_boss_prng, 30) / 100.0f; // Saturation variety
-                float val = 0.8f + prng_range(&g_boss_prng, 20) / 100.0f; // Brightness variety
+                int shape = prng_range(&rng, 5); // All 5 shapes
+                int size = base_size + prng_range(&rng, 15) - 7; // Size variety ±7
+                float sat = 0.7f + prng_range(&rng, 30) / 100.0f; // Saturation variety
+                float val = 0.8f + prng_range(&rng, 20) / 100.0f; // Brightness variety
                 float rotation = base_rotation + (i * 0.3f);
                 
-                int x = boss_x + (int)(cos(angle) * radius);
-                int y = boss_y + (int)(sin(angle) * radius);
-                draw_boss_shape(x, y, shape, size, rotation, shape_hue, sat, val, frame);
+                boss_add_part(l, shape, size, (int)(vis_cosf(angle) * radius), (int)(vis_sinf(angle) * radius),
+                              rotation, i * 0.1f, sat, val);
             }
             break;
             
         case 1: // Cluster Formation - tight group with mixed shapes
             for (int i = 0; i < num_components; i++) {
-                int shape = prng_range(&g_boss_prng, 5);
-                int size = base_size + prng_range(&g_boss_prng, 10) - 5;
-                float cluster_radius = 20 + prng_range(&g_boss_prng, 30);
-                float angle = prng_range(&g_boss_prng, 360) * M_PI / 180.0f;
-                float shape_hue = boss_base_hue + prng_range(&g_boss_prng, 30) / 100.0f;
-                if (shape_hue > 1.0f) shape_hue -= 1.0f;
-                float sat = 0.6f + prng_range(&g_boss_prng, 40) / 100.0f;
-                float val = 0.7f + prng_range(&g_boss_prng, 30) / 100.0f;
-                float rotation = base_rotation + prng_range(&g_boss_prng, 360) * M_PI / 180.0f;
+                int shape = prng_range(&rng, 5);
+                int size = base_size + prng_range(&rng, 10) - 5;
+                float cluster_radius = 20 + prng_range(&rng, 30);
+                float angle = prng_range(&rng, 360) * M_PI / 180.0f;
+                float hue_offset = prng_range(&rng, 30) / 100.0f;
+                float sat = 0.6f + prng_range(&rng, 40) / 100.0f;
+                float val = 0.7f + prng_range(&rng, 30) / 100.0f;
+                float rotation = base_rotation + prng_range(&rng, 360) * M_PI / 180.0f;
                 
-                int x = boss_x + (int)(cos(angle) * cluster_radius);
-                int y = boss_y + (int)(sin(angle) * cluster_radius);
-                draw_boss_shape(x, y, shape, size, rotation, shape_hue, sat, val, frame);
+                boss_add_part(l, shape, size, (int)(vis_cosf(angle) * cluster_radius), (int)(vis_sinf(angle) * cluster_radius),
+                              rotation, hue_offset, sat, val);
             }
             break;
             
-        case 2: // Wing Formation - symmetrical left/right
+        case 2: { // Wing Formation - symmetrical left/right
             int wing_shapes = num_components / 2;
             for (int i = 0; i < wing_shapes; i++) {
-                int shape = prng_range(&g_boss_prng, 5);
-                int size = base_size + prng_range(&g_boss_prng, 12) - 6;
-                float wing_distance = 40 + (i * 20);
-                float y_offset = (i - wing_shapes/2) * 25;
-                float shape_hue = boss_base_hue + (i * 0.15f);
-                if (shape_hue > 1.0f) shape_hue -= 1.0f;
-                float sat = 0.8f + prng_range(&g_boss_prng, 20) / 100.0f;
-                float val = 0.9f + prng_range(&g_boss_prng, 10) / 100.0f;
+                int shape = prng_range(&rng, 5);
+                int size = base_size + prng_range(&rng, 12) - 6;
+                int wing_distance = 40 + (i * 20);
+                int y_offset = (i - wing_shapes/2) * 25;
+                float sat = 0.8f + prng_range(&rng, 20) / 100.0f;
+                float val = 0.9f + prng_range(&rng, 10) / 100.0f;
                 float rotation = base_rotation + (i * 0.2f);
                 
                 // Left wing
-                draw_boss_shape(boss_x - wing_distance, boss_y + y_offset, shape, size, rotation, shape_hue, sat, val, frame);
+                boss_add_part(l, shape, size, -wing_distance, y_offset, rotation, i * 0.15f, sat, val);
                 // Right wing (different shape)
-                int right_shape = (shape + 1 + prng_range(&g_boss_prng, 4)) % 5;
-                draw_boss_shape(boss_x + wing_distance, boss_y + y_offset, right_shape, size, -rotation, shape_hue + 0.1f, sat, val, frame);
-            }
-            break;
-            
-        case 3: // Spiral Formation - shapes in rotating spiral
-            for (int i = 0; i < num_components; i++) {
-                float spiral_angle = (i * 0.6f) + (frame * 0.02f); // Rotating spiral
-                float spiral_radius = 10 + (i * 8);
-                int shape = (i + seed) % 5; // Sequential shapes
-                int size = base_size + (i % 8) - 4;
-                float shape_hue = boss_base_hue + (i * 0.08f);
-                if (shape_hue > 1.0f) shape_hue -= 1.0f;
-                float sat = 0.7f + ((i * 13) % 30) / 100.0f;
-                float val = 0.8f + ((i * 17) % 20) / 100.0f;
-                float rotation = spiral_angle + base_rotation;
-                
-                int x = boss_x + (int)(cos(spiral_angle) * spiral_radius);
-                int y = boss_y + (int)(sin(spiral_angle) * spiral_radius);
-                draw_boss_shape(x, y, shape, size, rotation, shape_hue, sat, val, frame);
+                int right_shape = (shape + 1 + prng_range(&rng, 4)) % 5;
+                boss_add_part(l, right_shape, size, wing_distance, y_offset, -rotation, i * 0.15f, sat, val)->hue_tint = 0.1f;
             }
             break;
+        }
             
-        case 4: // Grid Formation - organized rectangular pattern
+        case 4: { // Grid Formation - organized rectangular pattern
             int grid_size = (int)sqrt(num_components);
             for (int i = 0; i < num_components; i++) {
                 int grid_x = i % grid_size;
                 int grid_y = i / grid_size;
                 int shape = (grid_x + grid_y + seed) % 5; // Pattern-based shapes
                 int size = base_size + ((grid_x + grid_y) % 6) - 3;
-                float shape_hue = boss_base_hue + ((grid_x + grid_y) * 0.12f);
-                if (shape_hue > 1.0f) shape_hue -= 1.0f;
                 float sat = 0.6f + ((grid_x * 7 + grid_y * 11) % 40) / 100.0f;
                 float val = 0.7f + ((grid_x * 5 + grid_y * 13) % 30) / 100.0f;
                 float rotation = base_rotation + (grid_x + grid_y) * 0.25f;
                 
-                int x = boss_x + (grid_x - grid_size/2) * 30;
-                int y = boss_y + (grid_y - grid_size/2) * 30;
-                draw_boss_shape(x, y, shape, size, rotation, shape_hue, sat, val, frame);
+                boss_add_part(l, shape, size, (grid_x - grid_size/2) * 30, (grid_y - grid_size/2) * 30,
+                              rotation, (grid_x + grid_y) * 0.12f, sat, val);
             }
             break;
+        }
             
         case 5: // Random Chaos Formation - completely random placement
             for (int i = 0; i < num_components; i++) {
-                int shape = prng_range(&g_boss_prng, 5);
-                int size = 10 + prng_range(&g_boss_prng, 30); // Wide size range
-                float random_x = boss_x + prng_range(&g_boss_prng, 120) - 60; // ±60 pixel spread
-                float random_y = boss_y + prng_range(&g_boss_prng, 120) - 60;
-                float shape_hue = prng_range(&g_boss_prng, 100) / 100.0f; // Completely random hue
-                float sat = 0.5f + prng_range(&g_boss_prng, 50) / 100.0f;
-                float val = 0.6f + prng_range(&g_boss_prng, 40) / 100.0f;
-                float rotation = prng_range(&g_boss_prng, 360) * M_PI / 180.0f;
+                int shape = prng_range(&rng, 5);
+                int size = 10 + prng_range(&rng, 30); // Wide size range
+                int dx = prng_range(&rng, 120) - 60; // ±60 pixel spread
+                int dy = prng_range(&rng, 120) - 60;
+                float shape_hue = prng_range(&rng, 100) / 100.0f; // Completely random hue
+                float sat = 0.5f + prng_range(&rng, 50) / 100.0f;
+                float val = 0.6f + prng_range(&rng, 40) / 100.0f;
+                float rotation = prng_range(&rng, 360) * M_PI / 180.0f;
                 
-                draw_boss_shape(random_x, random_y, shape, size, rotation, shape_hue, sat, val, frame);
+                boss_part_t *p = boss_add_part(l, shape, size, dx, dy, rotation, shape_hue, sat, val);
+                p->fixed_hue = true;
+                p->color = vis_hsv_pixel(shape_hue, sat, val);
             }
             break;
             
-        case 6: // Layered Formation - concentric circles of different shapes
+        case 6: { // Layered Formation - concentric circles of different shapes
             int layers = 1 + (num_components / 4);
             for (int layer = 0; layer < layers; layer++) {
                 int shapes_in_layer = 3 + layer * 2;
@@ -598,67 +633,804 @@ void draw_enemy_boss(uint32_t *pixels, int frame, float hue, float audio_level,
                     float angle = (2.0f * M_PI * i) / shapes_in_layer;
                     int shape = (layer + i) % 5;
                     int size = base_size - layer * 3; // Smaller shapes in outer layers
-                    float shape_hue = boss_base_hue + layer * 0.2f + i * 0.1f;
-                    if (shape_hue > 1.0f) shape_hue -= 1.0f;
                     float sat = 0.8f - layer * 0.1f;
                     float val = 0.9f - layer * 0.1f;
                     float rotation = base_rotation + layer * 0.5f + i * 0.3f;
                     
-                    int x = boss_x + (int)(cos(angle) * layer_radius);
-                    int y = boss_y + (int)(sin(angle) * layer_radius);
-                    draw_boss_shape(x, y, shape, size, rotation, shape_hue, sat, val, frame);
+                    boss_add_part(l, shape, size, (int)(vis_cosf(angle) * layer_radius), (int)(vis_sinf(angle) * layer_radius),
+                                  rotation, layer * 0.2f, sat, val)->hue_offset[1] = i * 0.1f;
                 }
             }
             break;
+        }
+            
+        default: // 3 and 7 move every frame, see draw_enemy_boss
+            break;
+    }
+}
+
+void boss_template_init(boss_template_t *t, uint32_t seed) {
+    for (int v = 0; v < 2; v++) {
+        boss_layout_build(t, &t->layout[v], v, seed);
+    }
+}
+
+// Sprites of the static formations' parts, once per seed (see vis_boss.h)
+static void boss_sprites_init(vis_ctx_t *ctx) {
+    uint32_t *scratch = calloc(2 * (size_t)VIS_WIDTH * VIS_HEIGHT, sizeof(uint32_t));
+    for (int v = 0; v < 2; v++) {
+        const boss_layout_t *l = &ctx->boss.layout[v];
+        for (int i = 0; i < BOSS_MAX_PARTS; i++) {
+            vis_boss_sprite_t *sp = &ctx->boss_sprites[v][i];
+            if (i < l->num_parts) {
+                const boss_part_t *p = &l->parts[i];
+                vis_boss_sprite_build(sp, p->shape, p->size, p->rotation, scratch);
+            } else {
+                vis_boss_sprite_free(sp);
+            }
+        }
+    }
+    free(scratch);
+}
+
+void emit_enemy_boss(vis_ctx_t *ctx, int frame, float hue, float audio_level, uint32_t seed) {
+    int boss_x, boss_y;
+    boss_position(frame, audio_level, &boss_x, &boss_y);
+    
+    const boss_template_t *t = &ctx->boss;
+    int variant = ctx->budget.max_boss_shapes > 3;
+    const boss_layout_t *l = &t->layout[variant];
+    int num_components = l->num_components;
+    int base_size = t->base_size;
+    float base_rotation = t->base_rotation;
+    
+    float boss_base_hue = hue + t->hue_offset;
+    if (boss_base_hue > 1.0f) boss_base_hue -= 1.0f;
+    
+    switch(t->formation) {
+        case 3: // Spiral Formation - shapes in rotating spiral
+            for (int i = 0; i < num_components; i++) {
+                float spiral_angle = (i * 0.6f) + (frame * 0.02f); // Rotating spiral
+                float spiral_radius = 10 + (i * 8);
+                int shape = (i + seed) % 5; // Sequential shapes
+                int size = base_size + (i % 8) - 4;
+                float shape_hue = boss_base_hue + (i * 0.08f);
+                if (shape_hue > 1.0f) shape_hue -= 1.0f;
+                float sat = 0.7f + ((i * 13) % 30) / 100.0f;
+                float val = 0.8f + ((i * 17) % 20) / 100.0f;
+                float rotation = spiral_angle + base_rotation;
+                
+                int x = boss_x + (int)(vis_cosf(spiral_angle) * spiral_radius);
+                int y = boss_y + (int)(vis_sinf(spiral_angle) * spiral_radius);
+                emit_boss_shape(ctx, x, y, shape, size, rotation, shape_hue, sat, val);
+            }
+            break;
             
         case 7: // Pulsing Formation - sizes vary with audio and frame
             for (int i = 0; i < num_components; i++) {
                 float pulse_phase = (i * 0.5f) + (frame * 0.08f);
-                float pulse_factor = 0.7f + 0.3f * sin(pulse_phase) + audio_level * 0.4f;
+                float pulse_factor = 0.7f + 0.3f * vis_sinf(pulse_phase) + audio_level * 0.4f;
                 int shape = i % 5;
                 int size = (int)(base_size * pulse_factor);
                 float angle = (2.0f * M_PI * i) / num_components;
-                float radius = 35 + sin(frame * 0.05f + i) * 15; // Varying radius
-                float shape_hue = boss_base_hue + sin(pulse_phase) * 0.2f;
+                float radius = 35 + vis_sinf(frame * 0.05f + i) * 15; // Varying radius
+                float shape_hue = boss_base_hue + vis_sinf(pulse_phase) * 0.2f;
                 if (shape_hue > 1.0f) shape_hue -= 1.0f;
                 if (shape_hue < 0.0f) shape_hue += 1.0f;
                 float sat = 0.7f + audio_level * 0.3f;
-                float val = 0.8f + sin(pulse_phase) * 0.2f;
+                float val = 0.8f + vis_sinf(pulse_phase) * 0.2f;
                 float rotation = base_rotation + pulse_phase;
                 
-                int x = boss_x + (int)(cos(angle) * radius);
-                int y = boss_y + (int)(sin(angle) * radius);
-                draw_boss_shape(x, y, shape, size, rotation, shape_hue, sat, val, frame);
+                int x = boss_x + (int)(vis_cosf(angle) * radius);
+                int y = boss_y + (int)(vis_sinf(angle) * radius);
+                emit_boss_shape(ctx, x, y, shape, size, rotation, shape_hue, sat, val);
+            }
+            break;
+            
+        default: // Static formations: only the boss position and hue move
+            // This frame's colours in one batch, then the shapes from their sprites
+            float hue[BOSS_MAX_PARTS], sat[BOSS_MAX_PARTS], val[BOSS_MAX_PARTS];
+            uint32_t color[BOSS_MAX_PARTS];
+            for (int i = 0; i < l->num_parts; i++) {
+                const boss_part_t *p = &l->parts[i];
+                float shape_hue = boss_base_hue + p->hue_offset[0] + p->hue_offset[1];
+                if (shape_hue > 1.0f) shape_hue -= 1.0f;
+                hue[i] = shape_hue + p->hue_tint;
+                sat[i] = p->sat;
+                val[i] = p->val;
+            }
+            vis_hsv_pixels(hue, sat, val, color, l->num_parts);
+            for (int i = 0; i < l->num_parts; i++) {
+                const boss_part_t *p = &l->parts[i];
+                vis_dl_sprite(&ctx->dl, &ctx->boss_sprites[variant][i], boss_x + p->dx, boss_y + p->dy,
+                              p->fixed_hue ? p->color : color[i]);
             }
             break;
     }
 }
 
-int main(int argc, char *argv[]) {
-    // CLI: <audio.wav> [seed_hex] [max_frames] [--pipe-ppm] [--range start end]
-    bool pipe_ppm = false;
+// Audio-driven parameters for one frame
+typedef struct {
+    float hue, level, glitch;
+} frame_params_t;
+
+// Sidecar signals when built, else the timeline, else WAV analysis.  The WAV
+// path smooths across calls, so frames must be sampled in order from 0.
+static frame_params_t sample_frame_params(int frame, const timeline_signals_t *sig, const timeline_t *tl) {
+    frame_params_t p;
+    if (sig && frame < sig->frames) {
+        p.hue = sig->hue[frame];
+        p.level = sig->level[frame];
+        p.glitch = sig->glitch[frame];
+    } else if (tl) {
+        p.hue = timeline_compute_hue(tl, frame, VIS_FPS);
+        p.level = timeline_compute_level(tl, frame, VIS_FPS);
+        p.glitch = timeline_compute_glitch(tl, frame, VIS_FPS);
+    } else {
+        p.hue = get_audio_driven_hue_shift(frame);
+        p.level = get_smoothed_audio_level(frame);
+        p.glitch = get_audio_driven_glitch_intensity(frame);
+    }
+    return p;
+}
+
+// Everything a frame carries over to the next one: budget, spawned effects,
+// bass hit animation, ship fire and projectile motion.  Drawing only reads
+// this state, so running just this step replays a frame without pixels.
+static void advance_frame_state(const frames_core_t *core, int frame, const frame_params_t *p) {
+    vis_ctx_t *ctx = core->ctx;
+    update_workload_budget(ctx, p->level);
+    update_audio_visual_effects(frame, p->hue);
+    update_glitch_intensity_asm(p->glitch);
+    if (core->triggers) {
+        // Hits on this frame's events; the step clock only animates them
+        // (it spawns on step 0 only when last_bass_step isn't already 0)
+        vis_triggers_frame(core->triggers, frame, VIS_FPS, p->level, p->hue);
+        *get_last_bass_step_ptr_asm() = 0;
+    }
+    update_bass_hits_asm(frame * FRAME_TIME_MS, core->step_sec, p->hue, core->seed);
+    
+    // The ship only fires on frames where it is drawn
+    if (ctx->budget.draw_ship_boss) {
+        ship_fire(ctx, frame, p->level);
+    }
+    update_projectiles(ctx);
+}
+
+void frames_core_bind_triggers(frames_core_t *core, vis_triggers_t *vt) {
+    core->triggers = vis_triggers_init(vt, core->tl, core->seed) ? vt : NULL;
+    set_audio_visual_event_triggers(core->triggers != NULL);
+}
+
+void frames_core_advance(const frames_core_t *core, int frame) {
+    frame_params_t p = sample_frame_params(frame, core->sig, core->tl);
+    advance_frame_state(core, frame, &p);
+}
+
+// Bring a fresh context up to the state a full render has when it reaches
+// `frame`, so a slice starting there renders exactly the same pixels
+static void fast_forward(const frames_core_t *core, int frame) {
+    for (int f = 0; f < frame; f++) frames_core_advance(core, f);
+}
+
+// Draw one frame into `pixels` (already cleared) and step the frame state
+void frames_core_render(const frames_core_t *core, uint32_t *pixels, int frame) {
+    vis_ctx_t *ctx = core->ctx;
+    uint32_t seed = core->seed;
+
+    // Get audio-driven parameters (from sidecar if available) and step the frame state
+    PROF_BEGIN(state, "frame_state");
+    frame_params_t params = sample_frame_params(frame, core->sig, core->tl);
+    advance_frame_state(core, frame, &params);
+    PROF_END(state);
+    float audio_hue = params.hue;
+    float audio_level = params.level;
+
+    // The frame's records go into the display list, drawn in one pass below
+    PROF_BEGIN(emit, "dl_emit");
+    vis_dlist_t *dl = &ctx->dl;
+    vis_dl_reset(dl, frame);
+
+    // Calculate different audio responses for each terrain
+    float bottom_speed_multiplier = 1.0f + audio_level * 3.0f; // 1x to 4x speed
+    float top_hue = audio_hue + 0.3f; // Different hue for top terrain
+    if (top_hue > 1.0f) top_hue -= 1.0f;
+
+    // Bottom terrain (enhanced system) - moderate speed with dynamic colors
+    int bottom_frame = (int)(frame * bottom_speed_multiplier);
+    vis_dl_terrain(dl, ctx->terrain_mode == VIS_TERRAIN_ASM ? NULL : &ctx->terrain, bottom_frame, audio_level);
+
+    // Top terrain (new system) - different pattern and color
+    emit_top_terrain(dl, frame, top_hue, audio_level);
+
+    // Budget-aware visual rendering - skip expensive elements on heavy frames
+    if (ctx->budget.draw_ship_boss) {  // Only render complex elements when audio is not too intense
+        // Ship flying through the corridor, enemy boss on the right side
+        emit_ship(ctx, frame, audio_level);
+        emit_enemy_boss(ctx, frame, audio_hue, audio_level, seed);
+    }
+    // High intensity frames still draw the projectiles already in flight
+    emit_projectiles(ctx);
+
+    // The bass hits (this renders the ship and any other shapes)
+    vis_dl_bass_hits(dl);
+    PROF_END(emit);
+
+    vis_dl_draw(dl, pixels);
+}
+
+bool frames_core_load_timeline(const char *audio_path, timeline_t *tl, char *path, size_t path_len) {
+    snprintf(path, path_len, "%s.tl", audio_path);
+    if (timeline_load(path, tl)) return true;
+    snprintf(path, path_len, "%s.json", audio_path);
+    return timeline_load(path, tl);
+}
+
+void frames_core_init_scene(vis_ctx_t *ctx, uint32_t seed) {
+    ship_template_init(&ctx->ship, seed);
+    boss_template_init(&ctx->boss, seed);
+    boss_sprites_init(ctx);
+    init_terrain_asm(seed, 0.5f);
+    vis_terrain_strip_init(&ctx->terrain);
+    // init_particles_asm(); // Removed for now
+    init_glitch_system_asm(seed, 0.5f);
+    init_bass_hits_asm();
+}
+
+float frames_core_bpm(const timeline_t *tl) {
+    float bpm = (tl && tl->bpm > 0.0f) ? tl->bpm : get_audio_bpm();
+    return bpm > 0.0f ? bpm : 120.0f;
+}
+
+void generate_frames_traits(uint32_t seed, nft_traits_t *t) {
+    nft_visual_traits(seed, t);   // the templates' own picks, without the layouts
+}
+
+// --preview out.gif: every preview_step-th frame, palette-indexed and
+// downscaled, goes from the writer thread straight into an animated GIF
+typedef struct {
+    gif_writer_t gif;
+    int width, height;     // frames handed to the sink (the output format)
+    int scale;
+    uint8_t *indices;
+    frame_palette_t pal;
+    int overflow_frames;   // frames with more than 256 colors
+} gif_preview_t;
+static gif_preview_t g_preview;
+
+static int gif_preview_sink(void *ctx, const uint32_t *pixels, const frame_tiles_t *tiles) {
+    gif_preview_t *p = (gif_preview_t *)ctx;
+    frame_index(pixels, tiles, p->width, p->height, p->scale, p->indices, &p->pal);
+    if (p->pal.overflow) p->overflow_frames++;
+    return gif_writer_frame(&p->gif, p->indices, &p->pal);
+}
+
+// --delta-out: lossless archive of every frame, written alongside the output
+static frame_delta_writer_t g_delta;
+
+static int delta_tap(void *ctx, const uint32_t *pixels, const frame_tiles_t *tiles) {
+    return frame_delta_writer_frame((frame_delta_writer_t *)ctx, pixels, tiles);
+}
+
+// --digest out.txt: XXH64 of every output framebuffer, one manifest line per
+// frame (digest.h); a tap next to the output, or with --digest-only the sink
+typedef struct {
+    digest_t d;
+    size_t frame_bytes;
+} frame_digest_t;
+static frame_digest_t g_digest;
+
+static int digest_frame(void *ctx, const uint32_t *pixels, const frame_tiles_t *tiles) {
+    (void)tiles;   // untouched tiles are already black, hash the whole buffer
+    frame_digest_t *fd = (frame_digest_t *)ctx;
+    digest_update(&fd->d, pixels, fd->frame_bytes);
+    digest_part_end(&fd->d);
+    return 0;
+}
+
+// --checkpoint path: every CHECKPOINT_EVERY output frames (--checkpoint-every)
+// the render's state is written once the frames before it are on disk, and
+// a run that finds a checkpoint of the same render carries on from it.  The
+// state is taken on a keyframe of --delta-out, so the archive goes on with
+// a frame that needs nothing before it.
+#define CHECKPOINT_EVERY 600
+
+typedef struct {
+    int frame;                // Next native frame
+    int frames_out;
+    uint32_t delta_frames;    // --delta-out records and bytes written
+    uint64_t delta_bytes;
+    int64_t digest_offset;    // --digest manifest length
+} checkpoint_pos_t;
+
+// What makes two runs the same render: the command line less the
+// checkpoint options, and the track
+static uint64_t checkpoint_fingerprint(int argc, char *argv[]) {
+    xxh64_state_t h;
+    xxh64_reset(&h, 0);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--checkpoint") == 0 || strcmp(argv[i], "--checkpoint-every") == 0) {
+            i++;
+            continue;
+        }
+        xxh64_update(&h, argv[i], strlen(argv[i]) + 1);
+    }
+    uint32_t pcm_frames = 0, sample_rate = 0;
+    int channels = 0;
+    const int16_t *pcm = get_audio_samples(&pcm_frames, &sample_rate, &channels);
+    if (pcm) xxh64_update(&h, pcm, (size_t)pcm_frames * channels * sizeof(int16_t));
+    xxh64_update(&h, &sample_rate, sizeof(sample_rate));
+    return xxh64_digest(&h);
+}
+
+// The state before `frame`, after waiting for the writer to finish every
+// frame before it; 0 on success
+static int checkpoint_save(const char *path, uint64_t fingerprint, const vis_ctx_t *ctx, int frame, int frames_out,
+                           bool crt, bool delta, bool digest) {
+    if (frame_queue_drain(&g_frame_queue) != 0) return -1;
+    checkpoint_pos_t pos;
+    memset(&pos, 0, sizeof(pos));
+    pos.frame = frame;
+    pos.frames_out = frames_out;
+    if (delta) {
+        if (fflush(g_delta.f) != 0 || fsync(fileno(g_delta.f)) != 0) return -1;
+        pos.delta_frames = g_delta.frames;
+        pos.delta_bytes = g_delta.bytes;
+    }
+    digest_t d;
+    memset(&d, 0, sizeof(d));
+    if (digest) {
+        if (fflush(g_digest.d.out) != 0 || fsync(fileno(g_digest.d.out)) != 0) return -1;
+        pos.digest_offset = ftell(g_digest.d.out);
+        d = g_digest.d;
+        d.out = NULL;
+    }
+
+    vis_checkpoint_t c;
+    vis_checkpoint_init(&c, fingerprint);
+    size_t av_bytes = audio_visual_state_bytes();
+    void *av = malloc(av_bytes);
+    bool ok = av != NULL;
+    if (ok) audio_visual_state_save(av);
+    ok = ok && vis_checkpoint_put(&c, "POS ", &pos, sizeof(pos)) &&
+         vis_checkpoint_put(&c, "AVST", av, av_bytes) &&
+         vis_ctx_checkpoint(ctx, &c);
+    if (ok && crt) {
+        ok = vis_checkpoint_put(&c, "CRTR", &g_crt_fx.rng, sizeof(g_crt_fx.rng)) &&
+             vis_checkpoint_put(&c, "CRTP", g_crt_fx.prev_frame, (size_t)VIS_WIDTH * VIS_HEIGHT * sizeof(uint32_t));
+    }
+    if (ok && digest) ok = vis_checkpoint_put(&c, "DGST", &d, sizeof(d));
+    int rc = ok ? vis_checkpoint_save(&c, path) : -1;
+    free(av);
+    vis_checkpoint_free(&c);
+    return rc;
+}
+
+// The frame state of a loaded checkpoint into `ctx` (set up for the seed)
+// and the CRT pass (initialized); false if a section is missing
+static bool checkpoint_restore(const vis_checkpoint_t *c, vis_ctx_t *ctx, bool crt) {
+    const void *av = vis_checkpoint_get(c, "AVST", audio_visual_state_bytes());
+    if (!av || !vis_ctx_restore(ctx, c)) return false;
+    audio_visual_state_load(av);
+    if (crt) {
+        size_t prev_bytes = (size_t)VIS_WIDTH * VIS_HEIGHT * sizeof(uint32_t);
+        const rng_t *rng = vis_checkpoint_get(c, "CRTR", sizeof(rng_t));
+        const void *prev = vis_checkpoint_get(c, "CRTP", prev_bytes);
+        if (!rng || !prev) return false;
+        g_crt_fx.rng = *rng;
+        memcpy(g_crt_fx.prev_frame, prev, prev_bytes);
+    }
+    return true;
+}
+
+// --metrics out.json: the stage histograms and counters (frames_out,
+// bytes_out) rewritten every METRICS_INTERVAL_MS for a scraper
+// (batch_daemon.py); one clock read per output frame between snapshots
+#define METRICS_INTERVAL_MS 1000
+
+// A file of this process: --threads workers put their index ahead of the
+// extension (trace.w1.json)
+static void worker_path(char *out, size_t size, const char *path, int worker) {
+    const char *ext = strrchr(path, '.');
+    if (worker < 0) snprintf(out, size, "%s", path);
+    else if (ext) snprintf(out, size, "%.*s.w%d%s", (int)(ext - path), path, worker, ext);
+    else snprintf(out, size, "%s.w%d", path, worker);
+}
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+// --contact-sheet sheet.ppm: keyframes on the beat grid as native/4
+// thumbnails, SHEET_COLUMNS to a row, in one PPM
+#define SHEET_COLUMNS 4
+#define SHEET_SCALE   4
+typedef struct {
+    int *frames;          // keyframe numbers, ascending
+    int count, next;      // next: index of the keyframe still to render
+    int thumb_w, thumb_h;
+    uint32_t *pixels;     // the sheet, ARGB
+} contact_sheet_t;
+static contact_sheet_t g_sheet;
+
+// Spread `want` keyframes evenly over the beats in [start, end): the
+// timeline's beats[] when there is one, else the BPM grid
+static bool contact_sheet_plan(contact_sheet_t *cs, int want, int start, int end, const timeline_t *tl, float bpm) {
+    int beats = 0, *beat = malloc(sizeof(int) * (size_t)(end - start + 1));
+    if (!beat) return false;
+    if (tl && tl->beats_count && tl->sample_rate) {
+        // One segment's beats, repeated with the track
+        uint32_t seg = tl->total_samples ? tl->total_samples : tl->beats[tl->beats_count - 1] + 1;
+        for (uint64_t loop = 0;; loop++) {
+            uint32_t b = 0;
+            for (; b < tl->beats_count; b++) {
+                int f = (int)(((uint64_t)loop * seg + tl->beats[b]) * VIS_FPS / tl->sample_rate);
+                if (f >= end) break;
+                if (f >= start && (!beats || f > beat[beats - 1])) beat[beats++] = f;
+            }
+            if (b < tl->beats_count) break;
+        }
+    } else {
+        double period = 60.0 / bpm * VIS_FPS;
+        for (int k = (int)ceil(start / period); k * period < end; k++) {
+            int f = (int)(k * period);
+            if (f >= start && (!beats || f > beat[beats - 1])) beat[beats++] = f;
+        }
+    }
+    if (!beats) beat[beats++] = start;
+    if (want > beats) want = beats;
+    cs->frames = malloc(sizeof(int) * (size_t)want);
+    if (!cs->frames) {
+        free(beat);
+        return false;
+    }
+    for (int i = 0; i < want; i++) cs->frames[i] = beat[(int)((int64_t)i * beats / want)];
+    free(beat);
+    cs->count = want;
+    cs->next = 0;
+    cs->thumb_w = VIS_WIDTH / SHEET_SCALE;
+    cs->thumb_h = VIS_HEIGHT / SHEET_SCALE;
+    int cols = want < SHEET_COLUMNS ? want : SHEET_COLUMNS, rows = (want + SHEET_COLUMNS - 1) / SHEET_COLUMNS;
+    cs->pixels = calloc((size_t)cols * cs->thumb_w * rows * cs->thumb_h, sizeof(uint32_t));
+    return cs->pixels != NULL;
+}
+
+// Thumbnail of the next keyframe (a native frame) into its cell
+static void contact_sheet_add(contact_sheet_t *cs, const uint32_t *pixels, const frame_tiles_t *tiles) {
+    int cols = cs->count < SHEET_COLUMNS ? cs->count : SHEET_COLUMNS;
+    int cell = cs->next++;
+    uint32_t *thumb = malloc((size_t)cs->thumb_w * cs->thumb_h * sizeof(uint32_t));
+    if (!thumb) return;   // the cell stays black
+    frame_downscale(pixels, tiles, VIS_WIDTH, VIS_HEIGHT, SHEET_SCALE, thumb);
+    size_t stride = (size_t)cols * cs->thumb_w;
+    uint32_t *dst = cs->pixels + (size_t)(cell / cols) * cs->thumb_h * stride + (size_t)(cell % cols) * cs->thumb_w;
+    for (int y = 0; y < cs->thumb_h; y++)
+        memcpy(dst + y * stride, thumb + (size_t)y * cs->thumb_w, (size_t)cs->thumb_w * sizeof(uint32_t));
+    free(thumb);
+}
+
+static int contact_sheet_write(contact_sheet_t *cs, const char *path) {
+    int cols = cs->count < SHEET_COLUMNS ? cs->count : SHEET_COLUMNS, rows = (cs->count + SHEET_COLUMNS - 1) / SHEET_COLUMNS;
+    frame_writer_t fw;
+    int rc = -1;
+    if (frame_writer_init(&fw, FRAME_FMT_PPM, cols * cs->thumb_w, rows * cs->thumb_h, VIS_FPS)) {
+        rc = frame_writer_save(&fw, path, cs->pixels, NULL);
+        frame_writer_free(&fw);
+    }
+    free(cs->frames);
+    free(cs->pixels);
+    memset(cs, 0, sizeof(*cs));
+    return rc;
+}
+
+// --metadata out.json: the token metadata from this run's own numbers
+static int write_token_metadata(const char *path, const char *tx_hash, uint32_t seed, uint64_t audio_seed,
+                                int frame_count, const vis_format_t *format, const char *video,
+                                const char *audio) {
+    nft_metadata_t m = {0};
+    m.tx_hash = tx_hash;
+    m.visual_seed = seed;
+    m.audio_seed = audio_seed;
+    m.audio_sec = get_audio_duration();
+    m.frame_count = frame_count;
+    m.width = format->width;
+    m.height = format->height;
+    m.fps = format->fps;
+    m.video_path = video;
+    m.audio_name = audio;
+    nft_audio_traits(audio_seed, &m.traits);
+    generate_frames_traits(seed, &m.traits);
+    if (nft_metadata_write(path, &m) != 0) {
+        fprintf(stderr, "❌ Could not write %s\n", path);
+        return -1;
+    }
+    printf("📋 Metadata: %s (%d frames, %.2f bpm)\n", path, frame_count, m.traits.bpm);
+    return 0;
+}
+
+// Startup runs on three threads: the WAV (map, hash, then its .feat cache
+// or the per-frame analysis) and the timeline sidecar load on their own
+// while the calling thread builds the seed's tables (templates, sprites,
+// the asm terrain, glitch and bass hit state).  None of them shares state
+// with another until the joins.  The spans become profiler stages
+// ("startup_*") once --profile starts, next to the frame stages.
+typedef struct {
+    const char *name;
+    uint64_t t0, t1;
+} startup_span_t;
+
+typedef struct {
+    const char *path;
+    const frames_source_t *src;
+    bool dump_features;
+    bool analyse;             // false: nothing is drawn, no analysis
+    bool ok, cached;
+    startup_span_t load, features;
+} startup_audio_t;
+
+static void *startup_audio_main(void *arg) {
+    startup_audio_t *a = (startup_audio_t *)arg;
+    a->load = (startup_span_t){ "startup_wav", prof_ticks(), 0 };
+    a->ok = a->src ? load_wav_memory(a->src->wav, a->src->wav_len, a->path) : load_wav_file(a->path);
+    a->load.t1 = prof_ticks();
+    a->features = (startup_span_t){ "startup_features", a->load.t1, a->load.t1 };
+    if (!a->ok) return NULL;
+    // WAV-analysis fallback: per-frame features from <audio>.feat when cached
+    a->cached = !a->src && attach_audio_features(a->path, a->dump_features);
+    if (a->analyse) a->ok = analyse_audio_features();
+    a->features.t1 = prof_ticks();
+    return NULL;
+}
+
+typedef struct {
+    const char *audio_path;
+    timeline_t *tl;
+    char *path;
+    size_t path_len;
+    bool ok;
+    startup_span_t span;
+} startup_sidecar_t;
+
+static void *startup_sidecar_main(void *arg) {
+    startup_sidecar_t *c = (startup_sidecar_t *)arg;
+    c->span = (startup_span_t){ "startup_sidecar", prof_ticks(), 0 };
+    c->ok = frames_core_load_timeline(c->audio_path, c->tl, c->path, c->path_len);
+    c->span.t1 = prof_ticks();
+    return NULL;
+}
+
+// Run fn on a thread of its own, or here when none can be started
+static bool startup_spawn(pthread_t *t, void *(*fn)(void *), void *arg) {
+    if (pthread_create(t, NULL, fn, arg) == 0) return true;
+    fn(arg);
+    return false;
+}
+
+int generate_frames_run(int argc, char *argv[], const frames_source_t *src) {
+    const uint64_t run_t0 = prof_ticks();
+    // CLI: <audio.wav> [seed_hex] [max_frames] [--pipe-ppm|--pipe-raw[=bgra]|--pipe-y4m] [--range start end] [--threads N] [--dump-features] [--crt] [--budget audio|max|adaptive] [--terrain strip|asm] [--kernels ISA] [--profile out.json|out.csv] [--loop-periodic] [--encode out.mp4 [--preset P] [--crf N] [--x264-threads N]] [--preview out.gif [--preview-fps N] [--preview-scale N]] [--delta-out frames.ndfd [--keyint N]] [--format WxH@FPS|full|preview] [--contact-sheet sheet.ppm [--sheet-frames N]] [--metadata out.json [--metadata-only] [--video out.mp4] [--audio-seed S]] [--digest out.txt [--digest-only]] [--checkpoint state.ckpt [--checkpoint-every N]] [--metrics out.json]
+    bool pipe_out = false;
+    int threads = 1;
+    frame_format_t pipe_fmt = FRAME_FMT_PPM;
+    bool dump_features = false;
     int range_start = -1, range_end = -1;
+    bool crt = false;
+    vis_budget_mode_t budget_mode = VIS_BUDGET_AUDIO;
+    vis_terrain_mode_t terrain_mode = VIS_TERRAIN_STRIP;
+    const char *profile_path = NULL;
+    const char *metrics_path = NULL;
+    bool loop_periodic = false;
+    const char *encode_path = NULL;
+    av_encoder_opts_t encode_opts = AV_ENCODER_OPTS_DEFAULT;
+    const char *preview_path = NULL;
+    int preview_fps = 15, preview_scale = 2;
+    const char *delta_path = NULL;
+    int delta_keyint = VIS_FPS;
+    vis_format_t format;
+    vis_format_init(&format, VIS_FORMAT_FULL);
+    const char *sheet_path = NULL;
+    int sheet_frames = 12;
+    const char *metadata_path = NULL, *metadata_video = NULL;
+    ndb_seed_t audio_seed_arg;
+    bool have_audio_seed_arg = false;
+    bool metadata_only = false;
+    const char *digest_path = NULL;
+    bool digest_only = false;
+    const char *ckpt_path = NULL;
+    int ckpt_every = CHECKPOINT_EVERY;
+    int full_argc = argc;   // argc shrinks as the options are parsed
     
-    if (argc < 2 || argc > 8) {
+    if (argc < 2 || argc > 50) {
         printf("🎬 NotDeafBeef Frame Generator\n");
-        printf("Usage: %s <audio_file.wav> [seed_hex] [max_frames] [--pipe-ppm] [--range start end]\n", argv[0]);
+        printf("Usage: %s <audio_file.wav> [seed_hex] [max_frames] [--pipe-ppm|--pipe-raw[=bgra]|--pipe-y4m] [--range start end] [--threads N] [--dump-features] [--crt] [--budget audio|max|adaptive] [--terrain strip|asm] [--kernels ISA] [--profile out.json|out.csv] [--loop-periodic] [--encode out.mp4 [--preset P] [--crf N] [--x264-threads N]] [--preview out.gif [--preview-fps N] [--preview-scale N]] [--delta-out frames.ndfd [--keyint N]] [--format WxH@FPS|full|preview] [--contact-sheet sheet.ppm [--sheet-frames N]] [--metadata out.json [--metadata-only] [--video out.mp4] [--audio-seed S]] [--digest out.txt [--digest-only]] [--checkpoint state.ckpt [--checkpoint-every N]] [--metrics out.json]\n", argv[0]);
         printf("Example: %s audio.wav 0xDEADBEEF\n", argv[0]);
         printf("Example: %s audio.wav 0xDEADBEEF 24 --pipe-ppm  # Stream frames to stdout\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --pipe-y4m | ffmpeg -i - ...  # YUV 4:2:0, no per-frame parsing\n", argv[0]);
         printf("Example: %s audio.wav 0xDEADBEEF 0 --range 100 200  # Render frames 100-199\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --pipe-y4m --threads 4  # 4 slices in parallel, emitted in order\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --dump-features  # Cache WAV analysis in audio.wav.feat\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --pipe-y4m --crt  # CRT post-processing\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --budget max  # Largest workload caps on every frame\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --terrain asm  # Per-cell terrain kernel instead of the precomputed strip\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --pipe-y4m --kernels scalar  # Plain C kernels: the same frames, for A/B timing\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --pipe-y4m --loop-periodic  # One audio loop of frames, for ffmpeg -stream_loop\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --encode out.mp4 --preset veryfast  # libx264/AAC in process (make LIBAV=1)\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --preview preview.gif --loop-periodic  # 15 fps, 400x300 looping GIF, no ffmpeg\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --pipe-y4m --delta-out frames.ndfd  # Also archive every frame (bin/delta_decode)\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --pipe-y4m --format preview  # 400x300 at 30 fps (any 800x600/N at 60/N)\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --contact-sheet sheet.ppm --sheet-frames 8  # 8 beat keyframes, no other frames drawn\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --metadata-only --metadata meta.json --video out.mp4  # Traits and counts, no frames\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --digest frames.txt --digest-only  # Per-frame hashes, no frame output (verify_nft.sh)\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --pipe-y4m --profile trace.json  # Stage timings (make PROF=1)\n", argv[0]);
+        printf("Example: %s audio.wav 0xDEADBEEF --delta-out frames.ndfd --checkpoint frames.ckpt  # Rerun to resume after a kill\n", argv[0]);
         return 1;
     }
     
     // Parse flags and options
     int arg_idx = argc - 1;
     while (arg_idx >= 2) {
-        if (strcmp(argv[arg_idx], "--pipe-ppm") == 0) {
-            pipe_ppm = true;
+        const char *flag = argv[arg_idx];
+        if (strcmp(flag, "--pipe-ppm") == 0 || strcmp(flag, "--pipe-y4m") == 0 ||
+            strcmp(flag, "--pipe-raw") == 0 || strcmp(flag, "--pipe-raw=rgb24") == 0 ||
+            strcmp(flag, "--pipe-raw=bgra") == 0) {
+            pipe_out = true;
+            if (strcmp(flag, "--pipe-y4m") == 0) pipe_fmt = FRAME_FMT_Y4M;
+            else if (strcmp(flag, "--pipe-raw=bgra") == 0) pipe_fmt = FRAME_FMT_BGRA;
+            else if (strncmp(flag, "--pipe-raw", 10) == 0) pipe_fmt = FRAME_FMT_RGB24;
+            else pipe_fmt = FRAME_FMT_PPM;
+            argc--;
+            arg_idx--;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--threads") == 0) {
+            threads = atoi(argv[arg_idx]);
+            if (threads < 1) threads = 1;
+            if (threads > MAX_FRAME_WORKERS) threads = MAX_FRAME_WORKERS;
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--encode") == 0) {
+            encode_path = argv[arg_idx];
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--delta-out") == 0) {
+            delta_path = argv[arg_idx];
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--keyint") == 0) {
+            delta_keyint = atoi(argv[arg_idx]);
+            if (delta_keyint < 1) delta_keyint = 1;
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--format") == 0) {
+            if (!vis_format_init(&format, argv[arg_idx])) return 1;
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--metadata") == 0) {
+            metadata_path = argv[arg_idx];
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--video") == 0) {
+            metadata_video = argv[arg_idx];
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--audio-seed") == 0) {
+            if (ndb_seed_parse(argv[arg_idx], &audio_seed_arg) != 0) {
+                fprintf(stderr, "❌ Bad --audio-seed: %s\n", argv[arg_idx]);
+                return 1;
+            }
+            have_audio_seed_arg = true;
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--digest") == 0) {
+            digest_path = argv[arg_idx];
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--checkpoint") == 0) {
+            ckpt_path = argv[arg_idx];
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--checkpoint-every") == 0) {
+            ckpt_every = atoi(argv[arg_idx]);
+            if (ckpt_every < 1) ckpt_every = 1;
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (strcmp(argv[arg_idx], "--digest-only") == 0) {
+            digest_only = true;
+            argc--;
+            arg_idx--;
+        } else if (strcmp(argv[arg_idx], "--metadata-only") == 0) {
+            metadata_only = true;
+            argc--;
+            arg_idx--;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--contact-sheet") == 0) {
+            sheet_path = argv[arg_idx];
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--sheet-frames") == 0) {
+            sheet_frames = atoi(argv[arg_idx]);
+            if (sheet_frames < 1) sheet_frames = 1;
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--preview") == 0) {
+            preview_path = argv[arg_idx];
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--preview-fps") == 0) {
+            preview_fps = atoi(argv[arg_idx]);
+            if (preview_fps < 1) preview_fps = 1;
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--preview-scale") == 0) {
+            preview_scale = atoi(argv[arg_idx]);
+            if (preview_scale < 1) preview_scale = 1;
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--preset") == 0) {
+            encode_opts.preset = argv[arg_idx];
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--crf") == 0) {
+            encode_opts.crf = atoi(argv[arg_idx]);
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--x264-threads") == 0) {
+            encode_opts.threads = atoi(argv[arg_idx]);
+            if (encode_opts.threads < 0) encode_opts.threads = 0;
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--profile") == 0) {
+            profile_path = argv[arg_idx];
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--metrics") == 0) {
+            metrics_path = argv[arg_idx];
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--budget") == 0) {
+            const char *mode = argv[arg_idx];
+            if (strcmp(mode, "max") == 0) budget_mode = VIS_BUDGET_MAX;
+            else if (strcmp(mode, "adaptive") == 0) budget_mode = VIS_BUDGET_ADAPTIVE;
+            else if (strcmp(mode, "audio") == 0) budget_mode = VIS_BUDGET_AUDIO;
+            else {
+                fprintf(stderr, "❌ Unknown --budget mode: %s (audio, max or adaptive)\n", mode);
+                return 1;
+            }
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--terrain") == 0) {
+            const char *mode = argv[arg_idx];
+            if (strcmp(mode, "strip") == 0) terrain_mode = VIS_TERRAIN_STRIP;
+            else if (strcmp(mode, "asm") == 0) terrain_mode = VIS_TERRAIN_ASM;
+            else {
+                fprintf(stderr, "❌ Unknown --terrain mode: %s (strip or asm)\n", mode);
+                return 1;
+            }
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (arg_idx >= 3 && strcmp(argv[arg_idx - 1], "--kernels") == 0) {
+            // Cap the run-time kernel pick (cpu_dispatch.h), e.g. scalar for A/B checks
+            if (cpu_isa_set(argv[arg_idx]) != 0) {
+                fprintf(stderr, "❌ --kernels %s: unknown, or not supported by this CPU\n", argv[arg_idx]);
+                return 1;
+            }
+            argc -= 2;
+            arg_idx -= 2;
+        } else if (strcmp(argv[arg_idx], "--dump-features") == 0) {
+            dump_features = true;
+            argc--;
+            arg_idx--;
+        } else if (strcmp(argv[arg_idx], "--crt") == 0) {
+            crt = true;
+            argc--;
+            arg_idx--;
+        } else if (strcmp(argv[arg_idx], "--loop-periodic") == 0) {
+            loop_periodic = true;
             argc--;
             arg_idx--;
-        } else if (strcmp(argv[arg_idx], "--range") == 0 && arg_idx >= 3) {
-            // --range start end
-            range_end = atoi(argv[arg_idx + 1]);
-            range_start = atoi(argv[arg_idx]);
+        } else if (arg_idx >= 4 && strcmp(argv[arg_idx - 2], "--range") == 0) {
+            // --range start end (scanning from the back, arg_idx is `end`)
+            range_end = atoi(argv[arg_idx]);
+            range_start = atoi(argv[arg_idx - 1]);
             argc -= 3; // Remove --range start end
             arg_idx -= 3;
         } else {
@@ -666,81 +1438,203 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    printf("🎨 Generating visual frames from audio: %s\n", argv[1]);
+    // --encode muxes the MP4 itself, from the unsplit render of the whole track
+    if (encode_path) {
+#ifndef NDB_LIBAV
+        fprintf(stderr, "❌ --encode needs a build with libavcodec (make generate_frames LIBAV=1)\n");
+        return 1;
+#endif
+        if (pipe_out || threads > 1 || range_start >= 0 || loop_periodic) {
+            fprintf(stderr, "❌ --encode renders the whole track in one process: drop --pipe-*, --threads, --range and --loop-periodic (x264 threads: --x264-threads)\n");
+            return 1;
+        }
+    }
+
+    // --preview replaces the frame output the same way
+    if (preview_path && (encode_path || pipe_out || threads > 1 || range_start >= 0)) {
+        fprintf(stderr, "❌ --preview writes the GIF from one process: drop --encode, --pipe-*, --threads and --range\n");
+        return 1;
+    }
     
-    // Load audio file
-    if (!load_wav_file(argv[1])) {
-        fprintf(stderr, "❌ Failed to load audio file: %s\n", argv[1]);
+    // The archive holds every frame of one continuous render
+    if (delta_path && (threads > 1 || preview_path)) {
+        fprintf(stderr, "❌ --delta-out archives the frames of one process: drop --threads and --preview\n");
         return 1;
     }
     
-    print_audio_info();
+    if (metadata_only && !metadata_path) {
+        fprintf(stderr, "❌ --metadata-only needs --metadata out.json\n");
+        return 1;
+    }
     
-    // Initialize audio-visual mapping
-    init_audio_visual_mapping();
+    // The digest follows one process's frames in order, as a tap or the sink
+    if (digest_only && !digest_path) {
+        fprintf(stderr, "❌ --digest-only needs --digest out.txt\n");
+        return 1;
+    }
+    if (digest_path && (threads > 1 || preview_path || (!digest_only && delta_path))) {
+        fprintf(stderr, "❌ --digest hashes the frames of one process: drop --threads and --preview (and --delta-out, or add --digest-only)\n");
+        return 1;
+    }
+    // --delta-out stays a tap next to the digest sink (a shard_render.py worker)
+    if (digest_only && (pipe_out || encode_path || preview_path)) {
+        fprintf(stderr, "❌ --digest-only replaces the frame output: drop --pipe-*, --encode and --preview\n");
+        return 1;
+    }
+    
+    // The sheet's keyframes come from one process's frames
+    if (sheet_path && threads > 1) {
+        fprintf(stderr, "❌ --contact-sheet is built by one process: drop --threads\n");
+        return 1;
+    }
+    // Only file output can be cut back to a checkpoint and carried on
+    if (ckpt_path && (pipe_out || encode_path || preview_path || sheet_path || threads > 1)) {
+        fprintf(stderr, "❌ --checkpoint resumes frame files, --delta-out and --digest: drop --pipe-*, --encode, --preview, --contact-sheet and --threads\n");
+        return 1;
+    }
+    // Checkpoints fall on keyframes of the archive
+    if (ckpt_path && delta_path) ckpt_every = (ckpt_every + delta_keyint - 1) / delta_keyint * delta_keyint;
+    
+    // On its own, the sheet is the only output: no other frame is drawn
+    bool emit_frames = !sheet_path || pipe_out || encode_path || preview_path || delta_path || digest_path;
+    
+    // Frames own the real stdout in pipe mode; every log line goes to stderr
+    int frame_fd = STDOUT_FILENO;
+    if (pipe_out) {
+        fflush(stdout);
+        frame_fd = dup(STDOUT_FILENO);
+        if (frame_fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+            fprintf(stderr, "❌ Could not set up the frame pipe\n");
+            return 1;
+        }
+    }
+    frame_format_t out_fmt = encode_path ? FRAME_FMT_Y4M : pipe_out ? pipe_fmt : FRAME_FMT_PPM;
+    if (!frame_writer_init(&g_frame_writer, out_fmt, format.width, format.height, format.fps) ||
+        !frame_writer_set_source_scale(&g_frame_writer, format.scale)) return 1;
+
+    printf("🎨 Generating visual frames from audio: %s\n", argv[1]);
     
     // Initialize visual systems with seed from audio
-    uint32_t seed = 0xCAFEBABE; // Could be derived from audio file hash  
+    ndb_seed_t tx_seed;
+    ndb_seed_from_u64(0xCAFEBABE, &tx_seed);
     
-    // For testing: allow command line seed override
+    // Seed argument: the transaction hash, folded to the 32-bit visual seed
     if (argc >= 3) {
-        // OPTIMIZATION: Hash long transaction hashes to 32-bit seeds
-        seed = hash_transaction_to_seed(argv[2]);
-        printf("🎲 Using hashed seed: 0x%08X (from %s)\n", seed, argv[2]);
+        if (ndb_seed_parse(argv[2], &tx_seed) != 0) {
+            fprintf(stderr, "❌ Bad seed: %s\n", argv[2]);
+            return 1;
+        }
+        printf("🎲 Using hashed seed: 0x%08X (from %s)\n", tx_seed.visual, argv[2]);
     }
+    uint32_t seed = tx_seed.visual;
     
-    // Initialize PRNG streams
-    init_visual_prng_streams(seed);
+    // Load audio file (or the caller's in-memory track) and, for a render,
+    // its per-frame features
+    startup_audio_t audio = { argv[1], src, dump_features, !metadata_only, false, false, {0}, {0} };
+    pthread_t audio_thread;
+    bool audio_threaded = startup_spawn(&audio_thread, startup_audio_main, &audio);
     
-    // Allocate pixel buffer
-    uint32_t *pixels = calloc(VIS_WIDTH * VIS_HEIGHT, sizeof(uint32_t));
-    if (!pixels) {
-        fprintf(stderr, "❌ Failed to allocate pixel buffer\n");
+    // Prefer timeline sidecar if present to drive visuals deterministically:
+    // the binary <audio>.tl (mapped in place), else the <audio>.json debug export
+    timeline_t tl = {0};
+    char sidecar_path[512];
+    startup_sidecar_t sidecar = { argv[1], &tl, sidecar_path, sizeof(sidecar_path), false, {0} };
+    pthread_t sidecar_thread;
+    bool sidecar_threaded = false;
+    if (src) {
+        // In-memory callers hand over the timeline or nothing; no sidecar lookup
+        snprintf(sidecar_path, sizeof(sidecar_path), "in-memory timeline");
+        sidecar.ok = src->timeline && timeline_load_memory(src->timeline, src->timeline_len, &tl);
+    } else {
+        sidecar_threaded = startup_spawn(&sidecar_thread, startup_sidecar_main, &sidecar);
+    }
+    
+    // Render context: PRNG streams, budget, projectiles and the asm module
+    // state, and the seed's tables; metadata alone draws nothing
+    startup_span_t tables = { "startup_tables", prof_ticks(), 0 };
+    vis_ctx_t vis;
+    bool vis_ok = vis_ctx_init(&vis, seed);
+    if (vis_ok) {
+        vis_ctx_bind(&vis);
+        vis.budget_policy.mode = budget_mode;
+        vis.terrain_mode = terrain_mode;
+        vis.format = format;
+        vis.budget_policy.target_ms = 1000.0f / format.fps;
+        if (!metadata_only) {
+            printf("🚀 Initializing visual systems...\n");
+            frames_core_init_scene(&vis, seed);
+        }
+    }
+    tables.t1 = prof_ticks();
+    
+    if (audio_threaded) pthread_join(audio_thread, NULL);
+    if (sidecar_threaded) pthread_join(sidecar_thread, NULL);
+    bool have_timeline = sidecar.ok;
+    if (!vis_ok || !audio.ok) {
+        if (!vis_ok) fprintf(stderr, "❌ Failed to allocate the render context\n");
+        else fprintf(stderr, "❌ Failed to load audio file: %s\n", argv[1]);
+        if (vis_ok) vis_ctx_free(&vis);
+        if (have_timeline) timeline_free(&tl);
+        cleanup_audio_data();
         return 1;
     }
     
-    printf("🚀 Initializing visual systems...\n");
+    print_audio_info();
+    if (audio.cached) printf("📦 Using feature cache: %s.feat\n", argv[1]);
+    
+    // Initialize audio-visual mapping
+    init_audio_visual_mapping();
     
     float base_hue = 0.5f;
-
-    // Prefer timeline sidecar if present (<audio>.json) to drive visuals deterministically
-    timeline_t tl = {0};
-    char sidecar_path[512];
-    snprintf(sidecar_path, sizeof(sidecar_path), "%s.json", argv[1]);
-    bool have_timeline = timeline_load(sidecar_path, &tl);
+    
     if (have_timeline) {
         printf("🧭 Using timeline sidecar: %s\n", sidecar_path);
     } else {
         printf("ℹ️  No timeline sidecar found (%s). Falling back to WAV analysis.\n", sidecar_path);
     }
     
-    init_terrain_asm(seed, base_hue);
-    // init_particles_asm(); // Removed for now
-    init_glitch_system_asm(seed, 0.5f);
-    init_bass_hits_asm();
-    
     // Initialize second terrain system for top with different color
     uint32_t top_seed = seed ^ 0x12345678; // Different seed for variation
     float top_hue = base_hue + 0.3f; // Shift hue for different color
     if (top_hue > 1.0f) top_hue -= 1.0f; // Wrap around
     // We'll call init_terrain_asm again but we need a way to have two terrains
     
-    printf("🎬 Generating frames at 60 FPS...\n");
+    printf("🎬 Generating %dx%d frames at %d FPS...\n", format.width, format.height, format.fps);
     
     int frame = 0;
     int total_frames = 0;
+    int frames_out = 0;   // frames emitted, one per format.step of `frame`
     
     // Calculate total frames needed (audio duration * FPS)
     // Get actual audio duration from loaded WAV file instead of hardcoded 5.0s
     float audio_duration = get_audio_duration(); // Use actual audio duration
     total_frames = (int)(audio_duration * VIS_FPS);
+    int track_frames = total_frames;   // --loop-periodic: what the encoder repeats the loop to
+    
+    // --loop-periodic: the track repeats one segment, and the timeline/RMS
+    // signals repeat with it, so render a single loop (visual clock
+    // 0..period) for the encoder to repeat.  The period is rounded to whole
+    // frames, so the picture drifts at most half a frame per loop.
+    if (loop_periodic) {
+        float period = get_audio_loop_period();
+        int period_frames = (int)lroundf(period * VIS_FPS);
+        if (period_frames <= 0) {
+            fprintf(stderr, "⚠️  --loop-periodic: no loop in %s (not a --repeat render), rendering every frame\n", argv[1]);
+        } else if (period_frames < total_frames) {
+            fprintf(pipe_out ? stderr : stdout,
+                    "🔁 Loop-periodic: %d-frame loop (%.3fs), %.2f loops in the track\n",
+                    period_frames, period, (float)total_frames / period_frames);
+            total_frames = period_frames;
+        }
+    }
     
     // Allow frame limit override for quick testing
     if (argc == 4) {
         int max_frames = atoi(argv[3]);
+        if (max_frames > 0 && max_frames < track_frames) track_frames = max_frames;
         if (max_frames > 0 && max_frames < total_frames) {
             total_frames = max_frames;
-            fprintf(pipe_ppm ? stderr : stdout, "🎯 Limiting to %d frames for quick test\n", total_frames);
+            fprintf(pipe_out ? stderr : stdout, "🎯 Limiting to %d frames for quick test\n", total_frames);
         }
     }
     
@@ -754,99 +1648,324 @@ int main(int argc, char *argv[]) {
         }
         start_frame = range_start;
         end_frame = (range_end > total_frames) ? total_frames : range_end;
-        fprintf(pipe_ppm ? stderr : stdout, "🎯 Rendering slice: frames %d-%d\n", start_frame, end_frame-1);
+        fprintf(pipe_out ? stderr : stdout, "🎯 Rendering slice: frames %d-%d\n", start_frame, end_frame-1);
     }
     
-    fprintf(pipe_ppm ? stderr : stdout,
+    fprintf(pipe_out ? stderr : stdout,
             "📽️  Total frames to generate: %d (%.1f seconds at %d FPS)\n",
-            end_frame - start_frame, audio_duration, VIS_FPS);
+            (end_frame + format.step - 1) / format.step - (start_frame + format.step - 1) / format.step,
+            audio_duration, format.fps);
     
-    frame = start_frame; // Start from specified frame
-    while (frame < end_frame && !is_audio_finished(frame)) {
-        // Clear frame
-        clear_frame_asm(pixels, 0x000000); // Black background
-        
-        // Set current pixels for shape drawing functions
-        set_current_pixels(pixels);
-        
-        // Get audio-driven parameters (from sidecar if available)
-        float audio_hue = have_timeline ? timeline_compute_hue(&tl, frame, VIS_FPS)
-                                        : get_audio_driven_hue_shift(frame);
-        float audio_level = have_timeline ? timeline_compute_level(&tl, frame, VIS_FPS)
-                                          : get_smoothed_audio_level(frame);
-        float glitch_intensity = have_timeline ? timeline_compute_glitch(&tl, frame, VIS_FPS)
-                                               : get_audio_driven_glitch_intensity(frame);
-        
-        // Update workload budget based on current audio intensity
-        update_workload_budget(audio_level);
-        
-        // Update audio-visual effects
-        update_audio_visual_effects(frame, audio_hue);
-        
-        // Update glitch intensity
-        update_glitch_intensity_asm(glitch_intensity);
-        
-        // Focus on terrain systems
-        
-        // Calculate different audio responses for each terrain
-        float bottom_speed_multiplier = 1.0f + audio_level * 3.0f; // 1x to 4x speed
-        float top_hue = audio_hue + 0.3f; // Different hue for top terrain
-        if (top_hue > 1.0f) top_hue -= 1.0f;
-        
-        // Draw bottom terrain (enhanced system) - moderate speed with dynamic colors
-        int bottom_frame = (int)(frame * bottom_speed_multiplier);
-        draw_terrain_enhanced_asm(pixels, bottom_frame, audio_level);
+    // Timeline signals for every frame up front: the loop below only indexes them
+    timeline_signals_t sig = {0};
+    bool have_signals = have_timeline && timeline_signals_build(&tl, end_frame, VIS_FPS, &sig);
+    const timeline_signals_t *sig_src = have_signals ? &sig : NULL;
+    const timeline_t *tl_src = have_timeline ? &tl : NULL;
+    
+    // Bass hit sequencer step: one 16th note at the track tempo
+    float bpm = frames_core_bpm(tl_src);
+    float step_sec = 60.0f / bpm / 4.0f;
+    frames_core_t core = { &vis, sig_src, tl_src, step_sec, seed, NULL };
+    vis_triggers_t triggers;
+    frames_core_bind_triggers(&core, &triggers);
+    
+    // Token metadata: the audio seed is the one the WAV was rendered from
+    // (--audio-seed, else the timeline's, else the seed argument as segment reads it)
+    uint64_t audio_seed = have_audio_seed_arg ? audio_seed_arg.audio
+                        : have_timeline ? tl.seed : tx_seed.audio;
+    const char *tx_hash = argc >= 3 ? argv[2] : "0xCAFEBABE";
+    const char *audio_name = src ? NULL : argv[1];
+    if (metadata_only) {
+        int frames = loop_periodic ? track_frames : end_frame - start_frame;
+        frames = (frames + format.step - 1) / format.step;
+        int rc = write_token_metadata(metadata_path, tx_hash, seed, audio_seed, frames, &format,
+                                      metadata_video, audio_name) == 0 ? 0 : 1;
+        frame_writer_free(&g_frame_writer);
+        cleanup_audio_data();
+        timeline_signals_free(&sig);
+        vis_ctx_free(&vis);
+        if (have_timeline) timeline_free(&tl);
+        return rc;
+    }
+    
+    if (sheet_path) {
+        if (!contact_sheet_plan(&g_sheet, sheet_frames, start_frame, end_frame, tl_src, bpm)) {
+            fprintf(stderr, "❌ Failed to allocate the contact sheet\n");
+            return 1;
+        }
+        // Nothing after the last keyframe is needed when only the sheet is made
+        if (!emit_frames) end_frame = g_sheet.frames[g_sheet.count - 1] + 1;
+        fprintf(pipe_out ? stderr : stdout, "🗂️  Contact sheet: %d keyframes (%dx%d) into %s\n",
+                g_sheet.count, g_sheet.thumb_w, g_sheet.thumb_h, sheet_path);
+    }
+    
+    // Split across workers; the parent only reorders their output
+    int worker = -1;
+    if (threads > end_frame - start_frame) threads = end_frame - start_frame;
+    if (threads > 1) {
+        bool failed;
+        worker = fork_frame_workers(threads, start_frame, end_frame, pipe_out, &failed);
+        if (worker < 0) {
+            int rc = failed ? -1 : 0;
+            if (join_frame_workers(threads, frame_fd) != 0) rc = -1;
+            if (rc != 0) return 1;
+            frame = end_frame;
+            frames_out = (end_frame + format.step - 1) / format.step - (start_frame + format.step - 1) / format.step;
+        } else {
+            start_frame = g_workers[worker].start;
+            end_frame = g_workers[worker].end;
+            if (g_workers[worker].spool_fd >= 0) frame_fd = g_workers[worker].spool_fd;
+            g_frame_writer.started = worker > 0; // one Y4M stream header, from worker 0
+        }
+    }
+    bool render_here = threads <= 1 || worker >= 0;
+    
+    // Stage profile of this process; --threads workers each write their own
+    // file, with the worker index ahead of the extension (trace.w1.json)
+    if (render_here && profile_path) {
+#ifndef PROF_ENABLE
+        fprintf(stderr, "⚠️  Built without PROF=1: --profile records only the startup stages\n");
+#endif
+        char path[FRAME_QUEUE_PATH_MAX];
+        worker_path(path, sizeof(path), profile_path, worker);
+        prof_start(path);
+    }
+    // Startup as it ran, on the loading threads' behalf (a handful of
+    // samples, so every build records them)
+    if (render_here && prof_running()) {
+        const startup_span_t spans[] = { audio.load, audio.features, sidecar.span, tables };
+        for (size_t i = 0; i < sizeof(spans) / sizeof(spans[0]); i++)
+            if (spans[i].name) prof_record(prof_stage(spans[i].name), spans[i].t0, spans[i].t1);
+    }
+    // Metrics read the same counters; without --profile only the summary is kept
+    char metrics_file[FRAME_QUEUE_PATH_MAX];
+    uint64_t metrics_due = 0;
+    if (render_here && metrics_path) {
+        worker_path(metrics_file, sizeof(metrics_file), metrics_path, worker);
+        if (!prof_running()) prof_start(NULL);
+    }
+    
+    // A checkpoint of this render: carry on from it instead of from start_frame
+    vis_checkpoint_t ckpt = {0};
+    const checkpoint_pos_t *resume = NULL;
+    uint64_t ckpt_fingerprint = 0;
+    if (ckpt_path) {
+        ckpt_fingerprint = checkpoint_fingerprint(full_argc, argv);
+        vis_checkpoint_init(&ckpt, ckpt_fingerprint);
+        if (vis_checkpoint_load(&ckpt, ckpt_path)) {
+            resume = vis_checkpoint_get(&ckpt, "POS ", sizeof(checkpoint_pos_t));
+            if (resume && (resume->frame <= start_frame || resume->frame >= end_frame ||
+                           (digest_path && !vis_checkpoint_get(&ckpt, "DGST", sizeof(digest_t))))) resume = NULL;
+            if (resume) printf("⏯️  Resuming from %s at frame %d\n", ckpt_path, resume->frame);
+            else fprintf(stderr, "⚠️  %s doesn't fit this render, starting over\n", ckpt_path);
+        }
+    }
+    
+    // In-process encoder: the writer thread hands it each framebuffer
+    av_encoder_t *encoder = NULL;
+#ifdef NDB_LIBAV
+    if (encode_path) {
+        uint32_t pcm_frames, sample_rate;
+        int channels;
+        const int16_t *pcm = get_audio_samples(&pcm_frames, &sample_rate, &channels);
+        encoder = av_encoder_open(encode_path, &g_frame_writer, format.fps, pcm, pcm_frames, sample_rate, channels, &encode_opts);
+        if (!encoder) {
+            fprintf(stderr, "❌ Could not open the encoder for %s\n", encode_path);
+            return 1;
+        }
+        printf("🎞️  Encoding in process: %s (preset %s, crf %d)\n", encode_path,
+               encode_opts.preset ? encode_opts.preset : "medium", encode_opts.crf >= 0 ? encode_opts.crf : 23);
+    }
+#endif
+    
+    if (delta_path) {
+        if (resume ? !frame_delta_writer_resume(&g_delta, delta_path, format.width, format.height, format.fps,
+                                                delta_keyint, start_frame / format.step,
+                                                resume->delta_frames, resume->delta_bytes)
+                   : !frame_delta_writer_open(&g_delta, delta_path, format.width, format.height, format.fps,
+                                              delta_keyint, start_frame / format.step)) return 1;
+        g_frame_writer.tap = delta_tap;
+        g_frame_writer.tap_ctx = &g_delta;
+    }
+    
+    if (digest_path) {
+        char header[64];
+        snprintf(header, sizeof(header), "video %d %d %d", format.width, format.height, format.fps);
+        if (resume) {
+            g_digest.d = *(const digest_t *)vis_checkpoint_get(&ckpt, "DGST", sizeof(digest_t));
+            if (digest_resume(&g_digest.d, digest_path, (long)resume->digest_offset) != 0) return 1;
+        } else if (digest_open(&g_digest.d, digest_path, header, 'f', (start_frame + format.step - 1) / format.step, 0) != 0) {
+            return 1;
+        }
+        g_digest.frame_bytes = (size_t)format.width * format.height * sizeof(uint32_t);
+        if (digest_only) {
+            g_frame_writer.sink = digest_frame;
+            g_frame_writer.sink_ctx = &g_digest;
+        } else {
+            g_frame_writer.tap = digest_frame;
+            g_frame_writer.tap_ctx = &g_digest;
+        }
+    }
+    
+    // Native frames per output frame: the --format rate, and for a GIF
+    // preview further decimated to about preview_fps
+    int frame_step = format.step;
+    if (preview_path) {
+        if (preview_fps > format.fps) preview_fps = format.fps;
+        int preview_step = (format.fps + preview_fps / 2) / preview_fps;
+        frame_step = format.step * preview_step;
+        g_preview.width = format.width;
+        g_preview.height = format.height;
+        g_preview.scale = preview_scale;
+        g_preview.overflow_frames = 0;
+        g_preview.indices = malloc((size_t)(format.width / preview_scale) * (format.height / preview_scale) + 1);
+        if (!g_preview.indices || !gif_writer_open(&g_preview.gif, preview_path, format.width / preview_scale,
+                                                   format.height / preview_scale, format.fps / preview_step)) {
+            fprintf(stderr, "❌ Could not start the preview %s\n", preview_path);
+            return 1;
+        }
+        g_frame_writer.sink = gif_preview_sink;
+        g_frame_writer.sink_ctx = &g_preview;
+        printf("🖼️  GIF preview: %s (%dx%d, %d fps)\n", preview_path,
+               format.width / preview_scale, format.height / preview_scale, VIS_FPS / frame_step);
+    }
+    
+    // Framebuffer ring shared with the output thread (started after fork)
+    if (render_here && !frame_queue_init(&g_frame_queue, &g_frame_writer, FRAME_QUEUE_DEPTH)) {
+        fprintf(stderr, "❌ Failed to allocate pixel buffers\n");
+        return 1;
+    }
+    
+    // Slices replay the frames before them without drawing, so any slice
+    // (a --range or a --threads worker) matches the same frames of a full render
+    if (render_here && crt) {
+        crt_fx_init(&g_crt_fx, seed, VIS_WIDTH, VIS_HEIGHT);
+        crt_fx_set_layout(&g_crt_fx, CRT_FX_ARGB);
+    }
+    if (render_here && resume) {
+        if (!checkpoint_restore(&ckpt, &vis, crt)) {
+            fprintf(stderr, "❌ %s is incomplete; delete it to start over\n", ckpt_path);
+            return 1;
+        }
+        start_frame = resume->frame;
+        frames_out = resume->frames_out;
+    } else if (render_here && start_frame > 0) {
+        int warm_start = start_frame;
+        if (crt) warm_start = start_frame > CRT_WARMUP_FRAMES ? start_frame - CRT_WARMUP_FRAMES : 0;
+        fast_forward(&core, warm_start);
+        if (crt) {
+            // Build up the trail the slice's first frame blends with
+            uint32_t *scratch = buf_alloc(0, (size_t)VIS_WIDTH * VIS_HEIGHT * sizeof(uint32_t), 0);
+            if (!scratch) {
+                fprintf(stderr, "❌ Failed to allocate pixel buffers\n");
+                return 1;
+            }
+            crt_fx_skip(&g_crt_fx, warm_start);
+            vis_dirty_tiles = NULL;
+            for (int f = warm_start; f < start_frame; f++) {
+                frame_tiles_clear(NULL, scratch, VIS_WIDTH, VIS_HEIGHT);
+                frames_core_render(&core, scratch, f);
+                crt_fx_apply(&g_crt_fx, scratch, VIS_WIDTH, VIS_HEIGHT, f);
+            }
+            buf_free(scratch);
+        }
+    }
+    if (render_here) frame = start_frame; // Start from specified frame
+    // Time to the first frame: startup, the replay to start_frame or the restore
+    if (render_here) prof_record(prof_stage("startup_total"), run_t0, prof_ticks());
+    uint32_t *crt_scratch = NULL;
+    int ckpt_frame = frame;
+    while (render_here && frame < end_frame && !is_audio_finished(frame)) {
+        // Frames between output frames only step the state (and, with
+        // --crt, build the trail off-screen); keyframes of a contact sheet
+        // are drawn off-screen too
+        bool key_frame = g_sheet.next < g_sheet.count && g_sheet.frames[g_sheet.next] == frame;
+        if (!emit_frames || (frame_step > 1 && frame % frame_step != 0)) {
+            if (!crt && !key_frame) {
+                frames_core_advance(&core, frame);
+            } else {
+                if (!crt_scratch && !(crt_scratch = buf_alloc(0, (size_t)VIS_WIDTH * VIS_HEIGHT * sizeof(uint32_t), 0))) {
+                    fprintf(stderr, "❌ Failed to allocate pixel buffers\n");
+                    return 1;
+                }
+                frame_tiles_clear(NULL, crt_scratch, VIS_WIDTH, VIS_HEIGHT);
+                vis_dirty_tiles = NULL;
+                frames_core_render(&core, crt_scratch, frame);
+                if (crt) crt_fx_apply(&g_crt_fx, crt_scratch, VIS_WIDTH, VIS_HEIGHT, frame);
+                if (key_frame) contact_sheet_add(&g_sheet, crt_scratch, NULL);
+            }
+            frame++;
+            continue;
+        }
         
-        // Draw top terrain (new system) - different pattern and color
-        draw_top_terrain(pixels, frame, top_hue, audio_level);
+        // Every ckpt_every output frames, before drawing the next one
+        if (ckpt_path && frames_out > 0 && frames_out % ckpt_every == 0 && frame != ckpt_frame) {
+            PROF_BEGIN(ckpt, "checkpoint");
+            if (checkpoint_save(ckpt_path, ckpt_fingerprint, &vis, frame, frames_out, crt,
+                                delta_path != NULL, digest_path != NULL) != 0)
+                fprintf(stderr, "⚠️  Checkpoint at frame %d failed, rendering on\n", frame);
+            PROF_END(ckpt);
+            ckpt_frame = frame;
+        }
         
-        // Update bass hits animation (needed for proper rendering)
-        float elapsed_ms = frame * FRAME_TIME_MS;
-        update_bass_hits_asm(elapsed_ms);
+        // Next free framebuffer; blocks while the writer is a full ring behind
+        PROF_BEGIN(wait, "queue_wait");
+        uint32_t *pixels = frame_queue_acquire(&g_frame_queue);
+        PROF_END(wait);
+        if (!pixels) break;
+
+        // Clear frame: black background, touching only the tiles this
+        // buffer was drawn into last time; the glyph primitives mark new ones
+        frame_tiles_t *tiles = frame_queue_tiles(&g_frame_queue);
+        PROF_BEGIN(clear, "clear_frame");
+        frame_tiles_clear(tiles, pixels, VIS_WIDTH, VIS_HEIGHT);
+        PROF_END(clear);
+        vis_dirty_tiles = tiles ? tiles->rows : NULL;
         
-        // Budget-aware visual rendering - skip expensive elements on heavy frames
-        if (g_budget.complexity_factor < 0.8f) {  // Only render complex elements when audio is not too intense
-            // Draw ship flying through the corridor (pass seed for unique design)
-            draw_ship(pixels, frame, audio_hue, audio_level, seed);
-            
-            // Draw enemy boss on the right side
-            draw_enemy_boss(pixels, frame, audio_hue, audio_level, seed);
-            
-            // Update and draw projectiles (ship firing at boss)
-            update_projectiles();
-            draw_projectiles();
-        } else {
-            // High intensity - only update projectiles, don't render ship/boss
-            update_projectiles();
-            draw_projectiles();
+        struct timespec t0, t1;
+        if (budget_mode == VIS_BUDGET_ADAPTIVE) clock_gettime(CLOCK_MONOTONIC, &t0);
+        frames_core_render(&core, pixels, frame);
+        if (crt) {
+            // Trails and noise reach every tile
+            PROF_BEGIN(crt, "crt_fx");
+            crt_fx_apply(&g_crt_fx, pixels, VIS_WIDTH, VIS_HEIGHT, frame);
+            PROF_END(crt);
+            frame_tiles_mark_all(tiles);
         }
+        if (budget_mode == VIS_BUDGET_ADAPTIVE) {
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            workload_budget_feedback(&vis, (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) * 1e-6);
+        }
+        if (key_frame) contact_sheet_add(&g_sheet, pixels, tiles);
         
-        // Draw the bass hits (this renders the ship and any other shapes)
-        draw_bass_hits_asm(pixels, frame);
-        
-        // Output frame (with slice-aware naming)
-        if (pipe_ppm) {
-            write_frame_ppm(stdout, pixels);
+        // Output frame (with slice-aware naming); the writer thread emits it
+        if (pipe_out || encoder || preview_path || digest_only) {
+            frame_queue_submit(&g_frame_queue, frame_fd, NULL);
         } else {
+            char filename[FRAME_QUEUE_PATH_MAX];
             // Include range info in filename for parallel slice rendering
             if (range_start >= 0 && range_end >= 0) {
-                char filename[256];
-                snprintf(filename, sizeof(filename), "frame_%04d_slice_%d_%d.ppm", frame, range_start, range_end-1);
-                FILE *f = fopen(filename, "wb");
-                if (!f) { fprintf(stderr, "Could not create %s\n", filename); return 1; }
-                write_frame_ppm(f, pixels);
-                fclose(f);
-                fprintf(stderr, "✅ Generated %s\n", filename);
+                snprintf(filename, sizeof(filename), "frame_%04d_slice_%d_%d.ppm", frame / frame_step, range_start, range_end-1);
             } else {
-                save_frame_as_ppm(pixels, frame);
+                snprintf(filename, sizeof(filename), "frame_%04d.ppm", frame / frame_step);
+            }
+            frame_queue_submit(&g_frame_queue, -1, filename);
+        }
+        frames_out++;
+        
+        if (metrics_path) {
+            uint64_t now = monotonic_ms();
+            if (now >= metrics_due) {
+                prof_snapshot(metrics_file);
+                metrics_due = now + METRICS_INTERVAL_MS;
             }
         }
         
         // Progress indicator
-        if (!pipe_ppm && frame % 30 == 0) {
+        if (!pipe_out && frame % 30 == 0) {
             printf("🎬 Frame %d/%d (%.1f%% complete)\n",
                    frame, end_frame, ((frame - start_frame) * 100.0f) / (end_frame - start_frame));
-        } else if (pipe_ppm && frame % 120 == 0) {
+        } else if (pipe_out && frame % 120 == 0) {
             fprintf(stderr, "🎬 Frame %d/%d (%.1f%%)\n",
                     frame, end_frame, ((frame - start_frame) * 100.0f) / (end_frame - start_frame));
         }
@@ -854,26 +1973,131 @@ int main(int argc, char *argv[]) {
         frame++;
     }
     
-    if (!pipe_ppm) {
-        printf("🎉 Frame generation complete! Generated %d frames\n", frame - start_frame);
+    buf_free(crt_scratch);
+    
+    // Flush the frames still in the ring
+    if (render_here && frame_queue_finish(&g_frame_queue) != 0) {
+        fprintf(stderr, "❌ Frame output failed%s\n", pipe_out ? " (pipe closed?)" : "");
+#ifdef NDB_LIBAV
+        if (encoder) av_encoder_close(encoder);
+#endif
+        return 1;
+    }
+#ifdef NDB_LIBAV
+    if (encoder && av_encoder_close(encoder) != 0) {
+        fprintf(stderr, "❌ Encoding %s failed\n", encode_path);
+        return 1;
+    }
+#endif
+    if (delta_path) {
+        g_frame_writer.tap = NULL;
+        unsigned archived = g_delta.frames;
+        double mb = g_delta.bytes / 1e6;
+        if (frame_delta_writer_close(&g_delta) != 0) {
+            fprintf(stderr, "❌ Writing %s failed\n", delta_path);
+            return 1;
+        }
+        printf("📼 Archived %u frames in %s: %.1f MB (%.1f MB as PPM)\n", archived, delta_path, mb,
+               archived * ((double)format.width * format.height * 3) / 1e6);
+    }
+    if (digest_path) {
+        g_frame_writer.sink = NULL;
+        g_frame_writer.tap = NULL;
+        unsigned hashed = g_digest.d.parts;
+        uint64_t total;
+        if (digest_close(&g_digest.d, &total) != 0) {
+            fprintf(stderr, "❌ Writing %s failed\n", digest_path);
+            return 1;
+        }
+        fprintf(pipe_out ? stderr : stdout, "🔏 Digest %s: %u frames, xxh64 %016llx\n",
+                digest_path, hashed, (unsigned long long)total);
+    }
+    if (preview_path) {
+        g_frame_writer.sink = NULL;
+        int rc = gif_writer_close(&g_preview.gif);
+        free(g_preview.indices);
+        g_preview.indices = NULL;
+        if (rc != 0) {
+            fprintf(stderr, "❌ Writing %s failed\n", preview_path);
+            return 1;
+        }
+        if (g_preview.overflow_frames)
+            printf("⚠️  %d preview frames had more than %d colors (mapped to the nearest)\n",
+                   g_preview.overflow_frames, FRAME_PALETTE_MAX);
+    }
+    if (sheet_path) {
+        int rendered = g_sheet.next;
+        if (contact_sheet_write(&g_sheet, sheet_path) != 0) {
+            fprintf(stderr, "❌ Writing %s failed\n", sheet_path);
+            return 1;
+        }
+        fprintf(pipe_out ? stderr : stdout, "🗂️  Wrote %s (%d keyframes)\n", sheet_path, rendered);
+    }
+    if (render_here && metrics_path && prof_snapshot(metrics_file) != 0) {
+        fprintf(stderr, "❌ Writing %s failed\n", metrics_file);
+        return 1;
+    }
+    if (render_here && prof_finish() != 0) return 1;
+    // Finished: the next run starts over
+    if (ckpt_path) {
+        unlink(ckpt_path);
+        vis_checkpoint_free(&ckpt);
+    }
+    if (metadata_path && worker < 0) {
+        int frames = loop_periodic ? (track_frames + format.step - 1) / format.step : frames_out;
+        if (write_token_metadata(metadata_path, tx_hash, seed, audio_seed, frames, &format,
+                                 metadata_video ? metadata_video : encode_path, audio_name) != 0) return 1;
+    }
+    if (worker >= 0) {
+        fprintf(stderr, "✅ Worker %d rendered frames %d-%d\n", worker, start_frame, frame - 1);
+        return 0;
+    }
+    
+    if (digest_only) {
+        printf("🎉 Digest complete: %d frames hashed into %s\n", frames_out, digest_path);
+    } else if (preview_path) {
+        printf("🎉 Preview complete: %u frames in %s\n", g_preview.gif.frames, preview_path);
+    } else if (!emit_frames) {
+        printf("🎉 Contact sheet complete: %s\n", sheet_path);
+    } else if (encode_path) {
+        printf("🎉 Encoded %d frames with audio into %s\n", frames_out, encode_path);
+    } else if (!pipe_out) {
+        printf("🎉 Frame generation complete! Generated %d frames\n", frames_out);
         if (range_start >= 0 && range_end >= 0) {
             printf("📽️  Slice complete: frames %d-%d\n", range_start, range_end-1);
             printf("📽️  To merge slices: use parallel_render_coordinator.sh\n");
         } else {
-            printf("📽️  To create video: ffmpeg -r 60 -i frame_%%04d.ppm -c:v libx264 -pix_fmt yuv420p output.mp4\n");
+            printf("📽️  To create video: ffmpeg -r %d -i frame_%%04d.ppm -c:v libx264 -pix_fmt yuv420p output.mp4\n", format.fps);
         }
     } else {
-        fprintf(stderr, "🎉 Frame piping complete! Sent %d frames to stdout.\n", frame - start_frame);
-        fprintf(stderr, "💡 Example: ./generate_frames audio.wav 0xSEED --pipe-ppm | ffmpeg -r 60 -f image2pipe -vcodec ppm -i - -i audio.wav -c:v libx264 -pix_fmt yuv420p -shortest output.mp4\n");
+        fprintf(stderr, "🎉 Frame piping complete! Sent %d frames to stdout.\n", frames_out);
+        if (pipe_fmt == FRAME_FMT_Y4M) {
+            fprintf(stderr, "💡 Example: ./generate_frames audio.wav 0xSEED --pipe-y4m | ffmpeg -i - -i audio.wav -c:v libx264 -shortest output.mp4\n");
+        } else if (pipe_fmt != FRAME_FMT_PPM) {
+            fprintf(stderr, "💡 Example: ./generate_frames audio.wav 0xSEED --pipe-raw | ffmpeg -f rawvideo -pix_fmt %s -s %dx%d -r %d -i - -i audio.wav -c:v libx264 -pix_fmt yuv420p -shortest output.mp4\n",
+                    pipe_fmt == FRAME_FMT_BGRA ? "bgra" : "rgb24", format.width, format.height, format.fps);
+        } else {
+            fprintf(stderr, "💡 Example: ./generate_frames audio.wav 0xSEED --pipe-ppm | ffmpeg -r 60 -f image2pipe -vcodec ppm -i - -i audio.wav -c:v libx264 -pix_fmt yuv420p -shortest output.mp4\n");
+        }
     }
     
     // Cleanup
-    free(pixels);
+    if (render_here && crt) crt_fx_cleanup(&g_crt_fx);
+    frame_writer_free(&g_frame_writer);
     cleanup_audio_data();
+    timeline_signals_free(&sig);
+    vis_ctx_free(&vis);
     if (have_timeline) timeline_free(&tl);
+    if (pipe_out) close(frame_fd);   // EOF for an encoder reading the pipe
     
     return 0;
 }
 
+#ifndef GENERATE_FRAMES_NO_MAIN
+int main(int argc, char *argv[]) {
+    return generate_frames_run(argc, argv, NULL);
+}
+#endif
+
 
 
@@ -15,6 +15,15 @@ SEED="$TX_HASH"  # Use full transaction hash as seed
 TIMESTAMP=$(date +"%Y%m%d_%H%M%S")
 SCRIPT_DIR=$(pwd)  # Store script directory for absolute paths
 
+# Artifact cache (artifact_cache.py): unchanged stages are copied, not rerun.
+# NDB_NO_CACHE=1 always runs every stage.
+CACHE="python3 $SCRIPT_DIR/artifact_cache.py"
+# How chunk_encode.py makes the MP4, for the cache key
+VIDEO_PARAMS=$(cd "$SCRIPT_DIR" && python3 -B -c "import chunk_encode; print(chunk_encode.VIDEO_PARAMS)")
+AUDIO_PARAMS=$(cd "$SCRIPT_DIR" && python3 -B -c "import chunk_encode; print(chunk_encode.AUDIO_PARAMS)")
+cache_fetch() { [ "${NDB_NO_CACHE:-0}" != 1 ] && $CACHE fetch "$@"; }
+cache_store() { [ "${NDB_NO_CACHE:-0}" != 1 ] && $CACHE store "$@" || true; }
+
 # Colors for output
 RED='\033[0;31m'
 GREEN='\033[0;32m'
@@ -50,17 +59,21 @@ mkdir -p "$OUTPUT_DIR"
 mkdir -p "$OUTPUT_DIR/temp"
 
 # File names
-AUDIO_BASE="$OUTPUT_DIR/temp/${SEED}_base.wav"
 AUDIO_LONG="$OUTPUT_DIR/${TX_HASH}_audio.wav"
 VIDEO_FINAL="$OUTPUT_DIR/${TX_HASH}_final.mp4"
 METADATA_FILE="$OUTPUT_DIR/${TX_HASH}_metadata.json"
+# Digest manifests of the PCM and of every frame (verify_nft.sh compares them)
+AUDIO_DIGEST="$OUTPUT_DIR/${TX_HASH}_audio.digest"
+FRAMES_DIGEST="$OUTPUT_DIR/${TX_HASH}_frames.digest"
 
 log "🎨 Starting NFT generation for transaction: $TX_HASH"
 log "   Seed: $SEED"
 log "   Output: $OUTPUT_DIR"
 
-# Step 1: Generate base audio segment
-log "🎵 Step 1: Generating base audio segment..."
+# Step 1: Generate the extended audio track (6 loops ≈ 25 seconds)
+# segment renders all six loops in one pass, carrying voice tails across
+# each loop point, so no temp copies or sox/ffmpeg concat are needed.
+log "🎵 Step 1: Generating extended audio track..."
 cd src/c
 
 # Build if necessary
@@ -69,53 +82,23 @@ if [ ! -f bin/segment ]; then
     make segment USE_ASM=1 VOICE_ASM="GENERATOR_ASM KICK_ASM SNARE_ASM HAT_ASM MELODY_ASM LIMITER_ASM FM_VOICE_ASM" || error "Failed to build audio engine"
 fi
 
-# Generate base segment
-log "   Synthesizing audio with seed $SEED..."
-./bin/segment "$SEED" > /dev/null 2>&1
-
-# Find generated file
-SEGMENT_FILE=$(ls seed_0x*.wav 2>/dev/null | head -1)
-if [ ! -f "$SEGMENT_FILE" ]; then
-    error "Audio generation failed - no output file found"
+if cache_fetch audio "$SEED" "$SCRIPT_DIR/$AUDIO_LONG"; then
+    log "   ♻️  Audio unchanged, taken from the artifact cache"
+else
+    log "   Synthesizing audio with seed $SEED..."
+    ./bin/segment --repeat 6 --digest "$SCRIPT_DIR/$AUDIO_DIGEST" "$SEED" "$SCRIPT_DIR/$AUDIO_LONG" > /dev/null 2>&1 || error "Audio generation failed"
+    cache_store audio "$SEED" "$SCRIPT_DIR/$AUDIO_LONG"
 fi
-
-# Move to our naming convention
-mv "$SEGMENT_FILE" "../../$AUDIO_BASE"
 cd ../..
 
-AUDIO_DURATION=$(ffprobe -v quiet -show_entries format=duration -of csv=p=0 "$AUDIO_BASE" 2>/dev/null)
-success "Generated base audio: ${AUDIO_DURATION}s"
-
-# Step 2: Create extended audio (6x concatenation ≈ 25 seconds)
-log "🔄 Step 2: Creating extended audio track..."
-
-# Create temp directory for concatenation
-TEMP_CONCAT="$OUTPUT_DIR/temp/concat"
-mkdir -p "$TEMP_CONCAT"
-
-# Create 6 copies for concatenation
-for i in {1..6}; do
-    cp "$AUDIO_BASE" "$TEMP_CONCAT/segment_$i.wav"
-done
-
-# Concatenate with sox (fallback to ffmpeg if sox not available)
-if command -v sox >/dev/null 2>&1; then
-    log "   Using sox for concatenation..."
-    sox "$TEMP_CONCAT"/segment_*.wav "$AUDIO_LONG" 2>/dev/null || error "Sox concatenation failed"
-else
-    log "   Using ffmpeg for concatenation..."
-    # Create file list for ffmpeg
-    for i in {1..6}; do
-        echo "file '$TEMP_CONCAT/segment_$i.wav'" >> "$TEMP_CONCAT/filelist.txt"
-    done
-    ffmpeg -f concat -safe 0 -i "$TEMP_CONCAT/filelist.txt" -c copy "$AUDIO_LONG" -y >/dev/null 2>&1 || error "FFmpeg concatenation failed"
+if [ ! -f "$AUDIO_LONG" ]; then
+    error "Audio generation failed - no output file found"
 fi
 
-EXTENDED_DURATION=$(ffprobe -v quiet -show_entries format=duration -of csv=p=0 "$AUDIO_LONG" 2>/dev/null)
-success "Created extended audio: ${EXTENDED_DURATION}s"
+success "Created extended audio: $AUDIO_LONG"
 
-# Step 3: Generate visual frames
-log "🖼️  Step 3: Generating visual frames..."
+# Step 2: Generate visual frames and the video
+log "🖼️  Step 2: Generating visual frames and video..."
 
 # Build frame generator if needed
 if [ ! -f generate_frames ]; then
@@ -123,72 +106,58 @@ if [ ! -f generate_frames ]; then
     make generate_frames || error "Failed to build frame generator"
 fi
 
-# Generate frames (change to output directory to ensure frames are created in the right place)
-log "   Rendering frames with seed $SEED..."
 AUDIO_LONG_ABS="$SCRIPT_DIR/$AUDIO_LONG"  # Convert to absolute path
-cd "$OUTPUT_DIR"
-"$SCRIPT_DIR/generate_frames" "$AUDIO_LONG_ABS" "$SEED" > "temp/frame_log.txt" 2>&1
-cd "$SCRIPT_DIR"
-
-# Check if frames were generated
-FRAME_COUNT=$(ls "$OUTPUT_DIR"/frame_*.ppm 2>/dev/null | wc -l)
-if [ "$FRAME_COUNT" -eq 0 ]; then
-    error "Frame generation failed - no frames found"
+if cache_fetch video "$SEED" "$SCRIPT_DIR/$VIDEO_FINAL" --params "$VIDEO_PARAMS"; then
+    log "   ♻️  Frames and video unchanged, taken from the artifact cache"
+else
+    # Frames and encode in loop-aligned chunks, one x264 per core, joined
+    # with the concat demuxer; the AAC is encoded once next to them and
+    # copied in.  Each chunk's frames are hashed on the way, joined into the
+    # frames digest.  The .feat analysis cache next to the WAV and the AAC
+    # are reused across visual changes
+    log "   Rendering and encoding chunks with seed $SEED..."
+    FEAT="$AUDIO_LONG_ABS.feat"
+    FEAT_ARGS="--dump-features"
+    if cache_fetch feat "$SEED" "$FEAT"; then
+        FEAT_ARGS=""
+    fi
+    AAC="$SCRIPT_DIR/$OUTPUT_DIR/temp/audio.m4a"
+    rm -f "$AAC"
+    AAC_CACHED=0
+    if cache_fetch aac "$SEED" "$AAC" --params "$AUDIO_PARAMS"; then
+        AAC_CACHED=1
+    fi
+    python3 "$SCRIPT_DIR/chunk_encode.py" "$AUDIO_LONG_ABS" "$SEED" "$SCRIPT_DIR/$VIDEO_FINAL" $FEAT_ARGS \
+        --aac "$AAC" --digest "$SCRIPT_DIR/$FRAMES_DIGEST" > "$OUTPUT_DIR/temp/frame_log.txt" 2>&1 \
+        || error "Video creation failed (see $OUTPUT_DIR/temp/frame_log.txt)"
+    if [ -n "$FEAT_ARGS" ] && [ -f "$FEAT" ]; then
+        cache_store feat "$SEED" "$FEAT"
+    fi
+    if [ "$AAC_CACHED" = 0 ]; then
+        cache_store aac "$SEED" "$AAC" --params "$AUDIO_PARAMS"
+    fi
+    cache_store video "$SEED" "$SCRIPT_DIR/$VIDEO_FINAL" --params "$VIDEO_PARAMS"
 fi
 
-success "Generated $FRAME_COUNT frames"
-
-# Step 4: Create final video (run from output directory where frames are)
-log "🎬 Step 4: Creating final video..."
-AUDIO_LONG_ABS="$SCRIPT_DIR/$AUDIO_LONG"  # Convert to absolute path
-cd "$OUTPUT_DIR"
-
-ffmpeg -r 60 -i frame_%04d.ppm \
-       -i "$AUDIO_LONG_ABS" \
-       -c:v libx264 -c:a aac \
-       -pix_fmt yuv420p \
-       -shortest "$VIDEO_FINAL" \
-       -y >/dev/null 2>&1 || error "Video creation failed"
-
-cd "$SCRIPT_DIR"
-
 # Verify video was created
 if [ ! -f "$VIDEO_FINAL" ]; then
     error "Video file was not created"
 fi
 
-VIDEO_SIZE=$(du -h "$VIDEO_FINAL" | cut -f1)
-VIDEO_DURATION=$(ffprobe -v quiet -show_entries format=duration -of csv=p=0 "$VIDEO_FINAL" 2>/dev/null)
-success "Created final video: ${VIDEO_DURATION}s, $VIDEO_SIZE"
-
-# Step 5: Generate metadata
-log "📋 Step 5: Generating metadata..."
-
-cat > "$METADATA_FILE" << EOF
-{
-  "transaction_hash": "$TX_HASH",
-  "seed": "$SEED", 
-  "audio_duration": $EXTENDED_DURATION,
-  "video_duration": $VIDEO_DURATION,
-  "video_size": "$VIDEO_SIZE",
-  "video_resolution": "800x600",
-  "frame_rate": 60,
-  "frame_count": $FRAME_COUNT,
-  "generated_at": "$(date -u +"%Y-%m-%dT%H:%M:%SZ")",
-  "assembly_version": "v1.0",
-  "reproducible": true,
-  "files": {
-    "video": "$(basename "$VIDEO_FINAL")",
-    "audio": "$(basename "$AUDIO_LONG")", 
-    "metadata": "$(basename "$METADATA_FILE")"
-  }
-}
-EOF
+success "Created final video: $VIDEO_FINAL"
+
+# Step 3: Generate metadata
+# Durations, the frame count and the traits (tempo, key, scale, ship and
+# boss designs) come from the generator and renderer state, not from
+# probing the files: no ffprobe, du or frame listing
+log "📋 Step 3: Generating metadata..."
+"$SCRIPT_DIR/generate_frames" "$AUDIO_LONG_ABS" "$SEED" --metadata-only --metadata "$METADATA_FILE" \
+    --video "$VIDEO_FINAL" | grep "📋" || error "Metadata generation failed"
 
 success "Generated metadata"
 
-# Step 6: Cleanup temporary files
-log "🧹 Step 6: Cleaning up..."
+# Step 4: Cleanup temporary files
+log "🧹 Step 4: Cleaning up..."
 rm -f frame_*.ppm
 rm -rf "$OUTPUT_DIR/temp"
 
@@ -203,12 +172,15 @@ echo ""
 echo "🔍 NFT Details:"
 echo "   📝 Transaction: $TX_HASH"
 echo "   🎲 Seed: $SEED"
-echo "   ⏱️  Duration: ${VIDEO_DURATION}s"
-echo "   📦 Size: $VIDEO_SIZE"
 echo ""
 echo "✅ Ready for NFT marketplace upload!"
 echo ""
 
-# Verification hint
-echo "🔄 To verify reproducibility, run:"
-echo "   ./verify_nft.sh $TX_HASH $VIDEO_FINAL"
+# Verification hint (cache hits skip the renders that write the digests)
+echo "🔄 To verify reproducibility (digests, no encode), run:"
+if [ -f "$AUDIO_DIGEST" ] && [ -f "$FRAMES_DIGEST" ]; then
+    echo "   ./verify_nft.sh $TX_HASH $OUTPUT_DIR"
+else
+    echo "   ./verify_nft.sh $TX_HASH $OUTPUT_DIR --record   # once, to write the reference digests"
+    echo "   ./verify_nft.sh $TX_HASH $OUTPUT_DIR"
+fi
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""ctypes binding of libnotdeafbeef.so (src/include/nd_api.h).
+
+Plans, renders audio, exports timelines and draws frames in this process,
+one library call per step instead of a segment / export_timeline /
+generate_frames process.  Outputs land in the caller's buffer: anything
+writable with the buffer protocol (bytearray, numpy array, mmap) is handed
+to C as-is, and the functions return a memoryview of the part written.
+Without `out`, a bytearray of exactly the right size is allocated.
+
+    import nd_api
+    p = nd_api.plan("0xDEADBEEF")            # bpm, seeds, output sizes
+    wav = nd_api.render_audio("0xDEADBEEF")  # segment --repeat 6, as a WAV image
+    tl = nd_api.export_timeline("0xDEADBEEF")
+    px = nd_api.render_frames("0xDEADBEEF", wav, tl, first=0, count=60)
+
+Build the library with `make libnotdeafbeef.so`; NDB_LIB points at
+another copy.  The renderers keep static state: use one thread per process.
+"""
+
+import ctypes
+import os
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent
+LIB_PATH = Path(os.environ.get("NDB_LIB", ROOT / "libnotdeafbeef.so"))
+API_VERSION = 1
+REPEAT = 6  # loops in the shipped track (generate_nft.sh)
+VIS_WIDTH, VIS_HEIGHT = 800, 600  # native frame, src/include/visual_types.h
+
+
+class Plan(ctypes.Structure):
+    """nd_plan_t"""
+    _fields_ = [
+        ("audio_seed", ctypes.c_uint64),
+        ("visual_seed", ctypes.c_uint32),
+        ("sample_rate", ctypes.c_uint32),
+        ("bpm", ctypes.c_float),
+        ("root_freq", ctypes.c_float),
+        ("step_samples", ctypes.c_uint32),
+        ("seg_frames", ctypes.c_uint32),
+        ("event_count", ctypes.c_uint32),
+        ("track_frames", ctypes.c_uint32),
+        ("loop_start", ctypes.c_uint32),
+        ("loop_end", ctypes.c_uint32),
+        ("wav_bytes", ctypes.c_size_t),
+        ("timeline_bytes", ctypes.c_size_t),
+        ("video_frames", ctypes.c_uint32),
+    ]
+
+
+_lib = None
+
+
+def _load():
+    global _lib
+    if _lib is None:
+        lib = ctypes.CDLL(str(LIB_PATH))
+        lib.nd_api_version.restype = ctypes.c_int
+        lib.nd_plan.argtypes = [ctypes.c_char_p, ctypes.c_uint32, ctypes.POINTER(Plan)]
+        lib.nd_plan.restype = ctypes.c_int
+        lib.nd_render_audio.argtypes = [ctypes.c_char_p, ctypes.c_uint32, ctypes.c_void_p, ctypes.c_size_t]
+        lib.nd_render_audio.restype = ctypes.c_int64
+        lib.nd_export_timeline.argtypes = [ctypes.c_char_p, ctypes.c_void_p, ctypes.c_size_t]
+        lib.nd_export_timeline.restype = ctypes.c_int64
+        lib.nd_render_frames.argtypes = [ctypes.c_char_p, ctypes.c_void_p, ctypes.c_size_t, ctypes.c_void_p,
+                                         ctypes.c_size_t, ctypes.c_int, ctypes.c_int, ctypes.c_void_p]
+        lib.nd_render_frames.restype = ctypes.c_int
+        if lib.nd_api_version() != API_VERSION:
+            raise OSError(f"{LIB_PATH}: nd_api version {lib.nd_api_version()}, expected {API_VERSION}")
+        _lib = lib
+    return _lib
+
+
+def available():
+    """True when the library loads (batch_steps.py falls back to the binaries)"""
+    try:
+        _load()
+        return True
+    except OSError:
+        return False
+
+
+def _writable(buf, size):
+    """(pointer, memoryview) of a writable buffer of at least `size` bytes"""
+    view = memoryview(buf).cast("B")
+    if view.readonly or view.nbytes < size:
+        raise ValueError(f"need a writable buffer of {size} bytes, got {view.nbytes}")
+    return ctypes.addressof(ctypes.c_char.from_buffer(view)), view
+
+
+def _readable(buf):
+    """(pointer, length, keepalive) of an input buffer without copying it"""
+    if buf is None:
+        return None, 0, None
+    view = memoryview(buf).cast("B")
+    if isinstance(buf, bytes):
+        return ctypes.cast(ctypes.c_char_p(buf), ctypes.c_void_p).value, view.nbytes, buf
+    if view.readonly:   # no address for read-only exporters other than bytes
+        data = view.tobytes()
+        return ctypes.cast(ctypes.c_char_p(data), ctypes.c_void_p).value, len(data), data
+    return ctypes.addressof(ctypes.c_char.from_buffer(view)), view.nbytes, view
+
+
+def plan(seed, repeat=REPEAT):
+    """The seed's Plan for a `repeat`-loop track"""
+    p = Plan()
+    if _load().nd_plan(seed.encode(), repeat, ctypes.byref(p)) != 0:
+        raise ValueError(f"bad seed: {seed}")
+    return p
+
+
+def visual_seed(seed):
+    """The 32-bit visual seed as batch_steps.py prints it ("0x%08x")"""
+    return f"0x{plan(seed, 1).visual_seed:08x}"
+
+
+def render_audio(seed, repeat=REPEAT, out=None):
+    """segment --repeat `repeat` as a complete WAV image"""
+    size = plan(seed, repeat).wav_bytes
+    out = bytearray(size) if out is None else out
+    ptr, view = _writable(out, size)
+    n = _load().nd_render_audio(seed.encode(), repeat, ptr, view.nbytes)
+    if n < 0:
+        raise RuntimeError(f"audio render failed: {seed}")
+    return view[:n]
+
+
+def export_timeline(seed, out=None):
+    """The binary timeline sidecar (export_timeline <seed> out.tl)"""
+    lib = _load()
+    size = lib.nd_export_timeline(seed.encode(), None, 0)
+    if size < 0:
+        raise ValueError(f"bad seed: {seed}")
+    out = bytearray(size) if out is None else out
+    ptr, view = _writable(out, size)
+    lib.nd_export_timeline(seed.encode(), ptr, view.nbytes)
+    return view[:size]
+
+
+def render_frames(seed, wav, timeline=None, first=0, count=None, out=None):
+    """Frames [first, first + count) of the track `wav` as 0xAARRGGBB
+    pixels, VIS_WIDTH * VIS_HEIGHT per frame; a memoryview of uint32 (so
+    numpy.frombuffer(...).reshape(-1, VIS_HEIGHT, VIS_WIDTH) views it)"""
+    if count is None:
+        count = plan(seed).video_frames - first
+    frame_bytes = VIS_WIDTH * VIS_HEIGHT * 4
+    out = bytearray(count * frame_bytes) if out is None else out
+    ptr, view = _writable(out, count * frame_bytes)
+    wav_ptr, wav_len, wav_keep = _readable(wav)
+    tl_ptr, tl_len, tl_keep = _readable(timeline)
+    n = _load().nd_render_frames(seed.encode(), wav_ptr, wav_len, tl_ptr, tl_len, first, count, ptr)
+    del wav_keep, tl_keep
+    if n < 0:
+        raise RuntimeError(f"frame render failed: {seed}")
+    return view[:n * frame_bytes].cast("I")
+
+
+if __name__ == "__main__":
+    import sys
+    for s in sys.argv[1:] or ["0xCAFEBABE"]:
+        p = plan(s)
+        print(f"{s}: audio 0x{p.audio_seed:x} visual 0x{p.visual_seed:08x} {p.bpm:.2f} bpm, "
+              f"{p.track_frames} frames ({p.wav_bytes} WAV bytes), {p.event_count} events, "
+              f"{p.video_frames} video frames")
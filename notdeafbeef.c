@@ -0,0 +1,362 @@
+// notdeafbeef - single-binary NFT pipeline
+//
+// One process does what generate_nft.sh does with four tools and a
+// directory of temp files: plan the seed, render the extended track,
+// render the frames and encode the MP4.  The track is rendered into memory
+// (track_render into a memory wav_stream_t) and handed to generate_frames_run
+// as an in-memory WAV.  The audio sink pipes the same WAV image into an
+// AAC-only ffmpeg before any frame is drawn; frames then leave as Y4M on
+// the muxing ffmpeg's stdin, which copies that AAC in.  The encoded track
+// is cached per PCM hash (--audio-cache, default $NDB_CACHE/aac or
+// .artifact_cache/aac), so re-rendering the visuals encodes no audio.  No
+// PPM frames, no intermediate WAV and no ffprobe: the only files written
+// are the deliverables (MP4, the audio WAV unless --no-wav, the metadata
+// JSON with the plan's audio traits and the seed's ship and boss traits).
+//
+// Output matches generate_nft.sh: same audio (segment --repeat 6 of the same
+// seed), same frames (no timeline sidecar, WAV analysis) unless --timeline
+// asks for the plan's timeline to drive the visuals.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "src/include/visual_types.h"
+#include "src/include/generate_frames.h"
+#include "src/include/nft_metadata.h"
+#include "src/c/include/generator_plan.h"
+#include "src/c/include/timeline_export.h"
+#include "src/c/include/track_render.h"
+#include "src/c/include/seed.h"
+#include "src/c/include/digest.h"
+
+extern char **environ;
+
+#define NDB_PATH_MAX 1024
+#define NDB_REPEAT 6   // loops in the shipped track (generate_nft.sh)
+// The audio encode, as generate_nft.sh's mux does it
+#define AUDIO_CODEC_ARGS "-c:a", "aac"
+
+static int write_all(int fd, const uint8_t *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static int write_file(const char *path, const void *data, size_t len) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    int ok = fwrite(data, 1, len, f) == len;
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+static int wait_child(pid_t pid) {
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return -1;
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Start ffmpeg with `in_fd` on its stdin; returns its pid
+static pid_t spawn_ffmpeg(char *const args[], int in_fd) {
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_adddup2(&fa, in_fd, STDIN_FILENO);
+    pid_t pid = -1;
+    int err = posix_spawnp(&pid, "ffmpeg", &fa, NULL, args, environ);
+    posix_spawn_file_actions_destroy(&fa);
+    if (err != 0) {
+        fprintf(stderr, "❌ Could not start ffmpeg: %s\n", strerror(err));
+        return -1;
+    }
+    return pid;
+}
+
+// Y4M video on stdin, muxed with the already encoded audio track
+static pid_t spawn_encoder(const char *out_path, int video_fd, const char *audio_path) {
+    char *args[] = {
+        "ffmpeg", "-hide_banner", "-loglevel", "error", "-y",
+        "-f", "yuv4mpegpipe", "-i", "pipe:0", "-i", (char *)audio_path,
+        "-map", "0:v:0", "-map", "1:a:0",
+        "-c:v", "libx264", "-c:a", "copy", "-pix_fmt", "yuv420p",
+        "-shortest", (char *)out_path, NULL
+    };
+    return spawn_ffmpeg(args, video_fd);
+}
+
+// Audio sink: the in-memory WAV image through a pipe into ffmpeg's AAC
+// encoder, written to `path` by way of a .part file
+static int encode_audio(const char *path, const uint8_t *wav, size_t len) {
+    char part[NDB_PATH_MAX * 2 + 32];
+    snprintf(part, sizeof(part), "%s.%d.part.m4a", path, (int)getpid());
+    char *args[] = {
+        "ffmpeg", "-hide_banner", "-loglevel", "error", "-y",
+        "-f", "wav", "-i", "pipe:0", AUDIO_CODEC_ARGS, part, NULL
+    };
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    pid_t pid = spawn_ffmpeg(args, fds[0]);
+    close(fds[0]);
+    int ok = pid > 0 && write_all(fds[1], wav, len) == 0;
+    close(fds[1]);
+    if (pid > 0 && wait_child(pid) != 0) ok = 0;
+    if (ok && rename(part, path) != 0) ok = 0;
+    if (!ok) unlink(part);
+    return ok ? 0 : -1;
+}
+
+// mkdir -p
+static int make_dirs(const char *path) {
+    char buf[NDB_PATH_MAX];
+    if (snprintf(buf, sizeof(buf), "%s", path) >= (int)sizeof(buf)) return -1;
+    for (char *p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buf, 0755) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    return mkdir(buf, 0755) != 0 && errno != EEXIST ? -1 : 0;
+}
+
+// Cache key of the encoded track: the PCM it was made from, the encoder
+// arguments and ffmpeg's version line (a different encoder, a different AAC)
+static uint64_t audio_cache_key(const uint8_t *wav, size_t len) {
+    static const char *const codec[] = { AUDIO_CODEC_ARGS };
+    xxh64_state_t h;
+    xxh64_reset(&h, 0);
+    xxh64_update(&h, wav, len);
+    for (size_t i = 0; i < sizeof(codec) / sizeof(codec[0]); i++)
+        xxh64_update(&h, codec[i], strlen(codec[i]) + 1);
+    char version[256] = "";
+    FILE *p = popen("ffmpeg -version 2>/dev/null", "r");
+    if (p) {
+        if (!fgets(version, sizeof(version), p)) version[0] = '\0';
+        pclose(p);
+    }
+    xxh64_update(&h, version, strlen(version));
+    return xxh64_digest(&h);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "🎨 NotDeafBeef single-binary pipeline\n");
+    fprintf(stderr, "Usage: %s <tx_hash> [output_dir] [--threads N] [--frames N] [--timeline] [--crt] [--no-wav]\n"
+                    "          [--audio-cache DIR | --no-audio-cache]\n", prog);
+    fprintf(stderr, "Example: %s 0xDEADBEEF nft_output  # like ./generate_nft.sh 0xDEADBEEF nft_output\n", prog);
+    fprintf(stderr, "Example: %s 0xDEADBEEF --threads 4 --frames 120  # quick parallel preview\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    const char *tx_hash = NULL;
+    const char *out_dir = "./nft_output";
+    int threads = 1;
+    int max_frames = 0;
+    bool use_timeline = false, crt = false, write_wav = true;
+    // Encoded audio is cached per track: visual changes leave it alone
+    char audio_cache[NDB_PATH_MAX];
+    const char *cache_env = getenv("NDB_CACHE");
+    snprintf(audio_cache, sizeof(audio_cache), "%s/aac", cache_env && *cache_env ? cache_env : ".artifact_cache");
+    int npos = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            max_frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--timeline") == 0) {
+            use_timeline = true;
+        } else if (strcmp(argv[i], "--crt") == 0) {
+            crt = true;
+        } else if (strcmp(argv[i], "--no-wav") == 0) {
+            write_wav = false;
+        } else if (strcmp(argv[i], "--audio-cache") == 0 && i + 1 < argc) {
+            snprintf(audio_cache, sizeof(audio_cache), "%s", argv[++i]);
+        } else if (strcmp(argv[i], "--no-audio-cache") == 0) {
+            audio_cache[0] = '\0';
+        } else if (argv[i][0] == '-' && argv[i][1] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else if (npos == 0) {
+            tx_hash = argv[i];
+            npos++;
+        } else if (npos == 1) {
+            out_dir = argv[i];
+            npos++;
+        }
+    }
+    if (!tx_hash) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (mkdir(out_dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "❌ Could not create %s\n", out_dir);
+        return 1;
+    }
+    // A dead encoder must show up as a write error, not kill us mid-frame
+    signal(SIGPIPE, SIG_IGN);
+    // Data only ever leaves through the encoder pipes: keep stdout for logs
+    // and send the audio engine's debug chatter to stderr with them
+    fflush(stdout);
+    int log_fd = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    fcntl(log_fd, F_SETFD, FD_CLOEXEC);
+
+    char video_name[NDB_PATH_MAX], wav_name[NDB_PATH_MAX], meta_name[NDB_PATH_MAX];
+    char video_path[NDB_PATH_MAX * 2], wav_path[NDB_PATH_MAX * 2], meta_path[NDB_PATH_MAX * 2];
+    snprintf(video_name, sizeof(video_name), "%s_final.mp4", tx_hash);
+    snprintf(wav_name, sizeof(wav_name), "%s_audio.wav", tx_hash);
+    snprintf(meta_name, sizeof(meta_name), "%s_metadata.json", tx_hash);
+    snprintf(video_path, sizeof(video_path), "%s/%s", out_dir, video_name);
+    snprintf(wav_path, sizeof(wav_path), "%s/%s", out_dir, wav_name);
+    snprintf(meta_path, sizeof(meta_path), "%s/%s", out_dir, meta_name);
+
+    // Plan: the same seeds segment and generate_frames derive from the hash
+    ndb_seed_t seed;
+    if (ndb_seed_parse(tx_hash, &seed) != 0) {
+        fprintf(stderr, "❌ Bad transaction hash: %s\n", tx_hash);
+        return 1;
+    }
+    uint64_t audio_seed = seed.audio;
+    generator_plan_t plan;
+    generator_plan(audio_seed, &plan);
+    fprintf(stderr, "🎲 %s: audio seed 0x%llx, visual seed 0x%08X, %.2f bpm\n", tx_hash,
+            (unsigned long long)audio_seed, seed.visual, plan.mt.bpm);
+
+    // Audio: the extended track in one pass, straight into memory
+    wav_stream_t wav;
+    if (wav_stream_open_mem(&wav, 2, SR, plan.mt.seg_frames * NDB_REPEAT) != 0) return 1;
+    track_opts_t opt = { .repeat = NDB_REPEAT };
+    track_info_t info;
+    if (track_render(audio_seed, &wav, &opt, &info) != 0 || wav_stream_close(&wav) != 0) {
+        fprintf(stderr, "❌ Audio render failed\n");
+        free(wav.mem);
+        return 1;
+    }
+    float audio_sec = (float)info.total_frames / SR;
+    fprintf(stderr, "🎵 Rendered %u frames (%.2fs) in memory\n", info.total_frames, audio_sec);
+    if (write_wav && write_file(wav_path, wav.mem, wav.mem_len) != 0) {
+        fprintf(stderr, "❌ Could not write %s\n", wav_path);
+        free(wav.mem);
+        return 1;
+    }
+
+    // Timeline: the binary sidecar image, only when asked to drive visuals
+    uint8_t *tl_image = NULL;
+    size_t tl_len = 0;
+    if (use_timeline) {
+        tl_len = timeline_export_bin_mem(&plan, NULL, 0);
+        tl_image = malloc(tl_len);
+        if (!tl_image) return 1;
+        timeline_export_bin_mem(&plan, tl_image, tl_len);
+    }
+
+    // Audio sink: AAC straight from the PCM in memory, once per track
+    char aac_path[NDB_PATH_MAX * 2];
+    bool aac_cached = false, aac_temp = false;
+    if (audio_cache[0] && make_dirs(audio_cache) == 0) {
+        snprintf(aac_path, sizeof(aac_path), "%s/%016llx.m4a", audio_cache,
+                 (unsigned long long)audio_cache_key(wav.mem, wav.mem_len));
+        aac_cached = access(aac_path, R_OK) == 0;
+    } else {
+        snprintf(aac_path, sizeof(aac_path), "%s/.%s_audio.m4a", out_dir, tx_hash);
+        aac_temp = true;
+    }
+    if (aac_cached) {
+        fprintf(stderr, "♻️  Encoded audio unchanged: %s\n", aac_path);
+    } else if (encode_audio(aac_path, wav.mem, wav.mem_len) != 0) {
+        fprintf(stderr, "❌ Audio encode failed\n");
+        free(wav.mem);
+        return 1;
+    }
+
+    // Encoder: Y4M video on its stdin, the encoded audio copied in
+    int video_pipe[2];
+    if (pipe(video_pipe) != 0) {
+        fprintf(stderr, "❌ Could not create the encoder pipe\n");
+        return 1;
+    }
+    // ffmpeg must not inherit our write end, or it never sees EOF
+    fcntl(video_pipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(video_pipe[1], F_SETFD, FD_CLOEXEC);
+    pid_t encoder = spawn_encoder(video_path, video_pipe[0], aac_path);
+    close(video_pipe[0]);
+    if (encoder < 0) return 1;
+    fflush(NULL);
+
+    // Frames: generate_frames in-process, its pipe output bound to the encoder
+    char threads_arg[16], frames_arg[16];
+    snprintf(threads_arg, sizeof(threads_arg), "%d", threads > 1 ? threads : 1);
+    snprintf(frames_arg, sizeof(frames_arg), "%d", max_frames > 0 ? max_frames : 0);
+    char label[NDB_PATH_MAX];
+    snprintf(label, sizeof(label), "%s (in memory)", wav_name);
+    char *gf_argv[16];
+    int gf_argc = 0;
+    gf_argv[gf_argc++] = argv[0];
+    gf_argv[gf_argc++] = label;
+    gf_argv[gf_argc++] = (char *)tx_hash;
+    gf_argv[gf_argc++] = frames_arg;
+    gf_argv[gf_argc++] = "--pipe-y4m";
+    gf_argv[gf_argc++] = "--threads";
+    gf_argv[gf_argc++] = threads_arg;
+    if (crt) gf_argv[gf_argc++] = "--crt";
+    gf_argv[gf_argc] = NULL;
+
+    frames_source_t src = { wav.mem, wav.mem_len, tl_image, tl_len };
+    pid_t self = getpid();
+    dup2(video_pipe[1], STDOUT_FILENO);
+    close(video_pipe[1]);
+    int frames_rc = generate_frames_run(gf_argc, gf_argv, &src);
+    if (getpid() != self) {
+        fflush(NULL);
+        _exit(frames_rc);   // a --threads worker: its slice is done
+    }
+    close(STDOUT_FILENO);   // early error paths return with the pipe still bound
+    dup2(log_fd, STDOUT_FILENO);
+    // Later ones leave a copy open: stop the encoder instead of waiting on it
+    if (frames_rc != 0) kill(encoder, SIGTERM);
+
+    int encoder_rc = wait_child(encoder);
+    if (aac_temp) unlink(aac_path);
+    free(tl_image);
+    free(wav.mem);
+    if (frames_rc != 0 || encoder_rc != 0) {
+        fprintf(stderr, "❌ Pipeline failed (frames %d, encoder %d)\n", frames_rc, encoder_rc);
+        return 1;
+    }
+
+    // Same frame count generate_frames settles on for this track
+    int frame_count = (int)(audio_sec * VIS_FPS);
+    if (max_frames > 0 && max_frames < frame_count) frame_count = max_frames;
+    nft_metadata_t meta = {
+        .tx_hash = tx_hash, .visual_seed = seed.visual, .audio_seed = audio_seed,
+        .audio_sec = audio_sec, .frame_count = frame_count, .width = VIS_WIDTH, .height = VIS_HEIGHT,
+        .fps = VIS_FPS, .video_path = video_path, .audio_name = write_wav ? wav_name : NULL,
+        .metadata_name = meta_name,
+    };
+    nft_audio_traits(audio_seed, &meta.traits);
+    generate_frames_traits(meta.visual_seed, &meta.traits);
+    if (nft_metadata_write(meta_path, &meta) != 0) {
+        fprintf(stderr, "❌ Could not write %s\n", meta_path);
+        return 1;
+    }
+
+    printf("✨ NFT Generation Complete!\n");
+    printf("   🎬 Video: %s\n", video_path);
+    if (write_wav) printf("   🎵 Audio: %s\n", wav_path);
+    printf("   📋 Metadata: %s\n", meta_path);
+    return 0;
+}
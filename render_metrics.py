@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+"""Metrics of the render services: Prometheus text and JSON snapshots.
+
+batch_daemon.py counts its own work here (tokens, per-stage job latency,
+pool queue depth and busy workers, artifact cache hits, bytes written) and
+folds in the native pipeline's numbers: every generate_frames it starts
+writes the profiler's stages and counters to a file (--metrics, rewritten
+once a second by prof_snapshot in src/c/src/prof.c), and the latest file
+of every run, live or finished, is summed into the ndb_native_* series.
+Nothing is sampled on the render path: the native side is the profiler's
+existing relaxed-atomic counters, the Python side a lock per job.
+
+  GET /metrics        Prometheus text exposition format 0.0.4
+  <out>/metrics.json  the same families, rewritten every --metrics-interval
+
+Usage (imported by batch_daemon.py):
+  python3 render_metrics.py <snapshot.json>   # print a native snapshot as Prometheus text
+"""
+
+import json
+import os
+import sys
+import threading
+import time
+from collections import deque
+from datetime import datetime, timezone
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+
+PREFIX = "ndb"
+# Job latency buckets, seconds: an audio job is ~10 s, a video job minutes
+JOB_BUCKETS = (1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000, 2500)
+RATE_WINDOW = 300.0  # seconds of finished tokens behind tokens_per_minute
+
+# name -> (type, help)
+FAMILIES = {
+    "tokens_total": ("counter", "Tokens finished, by result"),
+    "tokens_planned": ("gauge", "Tokens this run renders (less those failed earlier)"),
+    "tokens_per_minute": ("gauge", f"Tokens finished per minute over the last {RATE_WINDOW:.0f} s"),
+    "stage_seconds": ("histogram", "Wall time of a token's stage job"),
+    "queue_depth": ("gauge", "Jobs submitted to a pool and not started"),
+    "workers_busy": ("gauge", "Pool workers running a job"),
+    "workers": ("gauge", "Pool size"),
+    "worker_busy_seconds_total": ("counter", "Seconds pool workers spent in jobs (rate / workers = utilization)"),
+    "cache_requests_total": ("counter", "Artifact cache lookups, by artifact and result"),
+    "bytes_written_total": ("counter", "Bytes of finished artifacts, by artifact"),
+    "native_runs": ("gauge", "generate_frames runs reporting, live and finished"),
+    "native_stage_seconds": ("histogram", "generate_frames profiler stages (make PROF=1 builds only)"),
+    "native_counter_total": ("counter", "generate_frames profiler counters (frames_out, bytes_out, ...)"),
+}
+
+
+def _labels(labels):
+    return tuple(sorted(labels.items()))
+
+
+def _fmt(v):
+    if isinstance(v, float):
+        return repr(v) if v != int(v) or abs(v) >= 1e15 else str(int(v))
+    return str(v)
+
+
+def _prom_labels(labels, extra=()):
+    items = list(labels) + list(extra)
+    if not items:
+        return ""
+    esc = (str(v).replace("\\", "\\\\").replace('"', '\\"').replace("\n", "\\n") for _, v in items)
+    return "{" + ",".join(f'{k}="{v}"' for (k, _), v in zip(items, esc)) + "}"
+
+
+def read_snapshot(path):
+    """A prof_snapshot file, or None while it doesn't exist yet"""
+    try:
+        with open(path) as f:
+            return json.load(f)
+    except (OSError, ValueError):
+        return None
+
+
+class Metrics:
+    """Counters, gauges and histograms keyed by name and labels; thread safe"""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.values = {}       # (name, labels) -> number: counters and gauges
+        self.hists = {}        # (name, labels) -> [bucket counts..., sum, count]
+        self.finished = deque()
+        self.native_live = {}  # run -> snapshot path
+        self.native_done = {}  # stages and counters of finished runs, summed
+        self.native_runs = 0
+        self.t0 = time.time()
+
+    def inc(self, name, n=1, **labels):
+        with self.lock:
+            k = (name, _labels(labels))
+            self.values[k] = self.values.get(k, 0) + n
+
+    add = inc  # gauges move both ways
+
+    def set(self, name, v, **labels):
+        with self.lock:
+            self.values[(name, _labels(labels))] = v
+
+    def observe(self, name, v, **labels):
+        with self.lock:
+            h = self.hists.setdefault((name, _labels(labels)), [0] * (len(JOB_BUCKETS) + 2))
+            for i, le in enumerate(JOB_BUCKETS):
+                if v <= le:
+                    h[i] += 1
+            h[-2] += v
+            h[-1] += 1
+
+    def token_done(self, ok):
+        self.inc("tokens_total", result="done" if ok else "failed")
+        with self.lock:
+            self.finished.append(time.monotonic())
+
+    # ---- native runs ----------------------------------------------------
+
+    def watch(self, run, path):
+        """Report generate_frames run `run` from its --metrics file"""
+        with self.lock:
+            self.native_live[run] = Path(path)
+            self.native_runs += 1
+
+    def unwatch(self, run):
+        """The run has exited: fold its last snapshot into the totals"""
+        with self.lock:
+            path = self.native_live.pop(run, None)
+        snap = read_snapshot(path) if path else None
+        with self.lock:
+            if snap:
+                _merge(self.native_done, snap)
+            else:
+                self.native_runs -= 1
+        if path:
+            path.unlink(missing_ok=True)
+
+    def _native(self):
+        with self.lock:
+            live = list(self.native_live.values())
+            total = json.loads(json.dumps(self.native_done)) if self.native_done else {}
+        for path in live:
+            snap = read_snapshot(path)
+            if snap:
+                _merge(total, snap)
+        return total
+
+    # ---- exposition -----------------------------------------------------
+
+    def collect(self):
+        """[(name, type, help, samples)], samples [(suffix, labels, value)]"""
+        native = self._native()
+        now = time.monotonic()
+        with self.lock:
+            while self.finished and now - self.finished[0] > RATE_WINDOW:
+                self.finished.popleft()
+            window = min(RATE_WINDOW, time.time() - self.t0) or 1.0
+            values = dict(self.values)
+            values[("tokens_per_minute", ())] = round(len(self.finished) * 60.0 / window, 3)
+            values[("native_runs", ())] = self.native_runs
+            hists = {k: list(v) for k, v in self.hists.items()}
+
+        samples = {}
+        for (name, labels), v in values.items():
+            samples.setdefault(name, []).append(("", labels, v))
+        for (name, labels), h in hists.items():
+            out = samples.setdefault(name, [])
+            for i, le in enumerate(JOB_BUCKETS):
+                out.append(("_bucket", labels + (("le", _fmt(float(le))),), h[i]))
+            out.append(("_bucket", labels + (("le", "+Inf"),), h[-1]))
+            out.append(("_sum", labels, round(h[-2], 6)))
+            out.append(("_count", labels, h[-1]))
+        le_us = native.get("le_us", [])
+        for stage, st in sorted(native.get("stages", {}).items()):
+            labels = (("stage", stage),)
+            out = samples.setdefault("native_stage_seconds", [])
+            for le, n in zip(le_us, st["le"]):
+                out.append(("_bucket", labels + (("le", _fmt(le / 1e6)),), n))
+            out.append(("_bucket", labels + (("le", "+Inf"),), st["count"]))
+            out.append(("_sum", labels, round(st["sum_us"] / 1e6, 6)))
+            out.append(("_count", labels, st["count"]))
+        for counter, v in sorted(native.get("counters", {}).items()):
+            samples.setdefault("native_counter_total", []).append(("", (("counter", counter),), v))
+
+        return [(name, typ, help_, samples[name]) for name, (typ, help_) in FAMILIES.items() if name in samples]
+
+    def prometheus(self):
+        lines = []
+        for name, typ, help_, samples in self.collect():
+            full = f"{PREFIX}_{name}"
+            lines.append(f"# HELP {full} {help_}")
+            lines.append(f"# TYPE {full} {typ}")
+            for suffix, labels, v in samples:
+                extra = ()
+                if suffix == "_bucket":  # le goes last, as exporters print it
+                    extra = tuple(kv for kv in labels if kv[0] == "le")
+                    labels = tuple(kv for kv in labels if kv[0] != "le")
+                lines.append(f"{full}{suffix}{_prom_labels(labels, extra)} {_fmt(v)}")
+        return "\n".join(lines) + "\n"
+
+    def snapshot(self):
+        fams = {}
+        for name, typ, _, samples in self.collect():
+            fams[f"{PREFIX}_{name}"] = {"type": typ, "samples": [
+                {"name": f"{PREFIX}_{name}{suffix}", "labels": dict(labels), "value": v}
+                for suffix, labels, v in samples]}
+        return {"t": datetime.now(timezone.utc).isoformat(timespec="seconds"),
+                "uptime_s": round(time.time() - self.t0, 3), "metrics": fams}
+
+    def write(self, path):
+        """metrics.json through a temporary name, so readers never see half"""
+        path = Path(path)
+        tmp = path.with_name(path.name + ".tmp")
+        with open(tmp, "w") as f:
+            json.dump(self.snapshot(), f, indent=1)
+            f.write("\n")
+        os.replace(tmp, path)
+
+    def write_every(self, path, interval, stop):
+        """Rewrite `path` every `interval` seconds until `stop` is set, then once more"""
+        def loop():
+            while not stop.wait(interval):
+                self.write(path)
+            self.write(path)
+        t = threading.Thread(target=loop, name="metrics-json", daemon=True)
+        t.start()
+        return t
+
+    def serve(self, listen):
+        """GET /metrics on host:port in a daemon thread; returns the server"""
+        host, _, port = listen.rpartition(":")
+        metrics = self
+
+        class Handler(BaseHTTPRequestHandler):
+            def do_GET(self):
+                if self.path.split("?")[0] != "/metrics":
+                    self.send_error(404)
+                    return
+                body = metrics.prometheus().encode()
+                self.send_response(200)
+                self.send_header("Content-Type", "text/plain; version=0.0.4; charset=utf-8")
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+
+            def log_message(self, fmt, *args):
+                pass  # scrapes every few seconds would drown the progress lines
+
+        httpd = ThreadingHTTPServer((host or "127.0.0.1", int(port)), Handler)
+        httpd.daemon_threads = True
+        threading.Thread(target=httpd.serve_forever, name="metrics-http", daemon=True).start()
+        return httpd
+
+
+def _merge(total, snap):
+    """Add prof_snapshot `snap` into `total` (same le_us in every build)"""
+    total.setdefault("le_us", snap.get("le_us", []))
+    stages = total.setdefault("stages", {})
+    for name, st in snap.get("stages", {}).items():
+        acc = stages.setdefault(name, {"count": 0, "sum_us": 0.0, "le": [0] * len(st["le"])})
+        acc["count"] += st["count"]
+        acc["sum_us"] += st["sum_us"]
+        acc["le"] = [a + b for a, b in zip(acc["le"], st["le"])]
+    counters = total.setdefault("counters", {})
+    for name, v in snap.get("counters", {}).items():
+        counters[name] = counters.get(name, 0) + v
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit(__doc__.split("Usage")[1].strip())
+    m = Metrics()
+    snap = read_snapshot(sys.argv[1])
+    if snap is None:
+        sys.exit(f"❌ {sys.argv[1]}: not a generate_frames --metrics snapshot")
+    _merge(m.native_done, snap)
+    m.native_runs = 1
+    sys.stdout.write(m.prometheus())
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,479 @@
+#!/usr/bin/env python3
+"""On-demand token render server (notdeafbeef-serve) with an LRU of MP4s.
+
+Marketplaces and the gallery ask for tokens in no particular order, so
+instead of pre-rendering every token at every tier this serves
+
+  GET /token/<seed>.mp4[?tier=full|preview]    the token's video
+  GET /stats                                   cache and queue counters (JSON)
+
+A miss renders the token while the client waits: generate_frames
+--pipe-y4m --format <tier> into x264, written as fragmented MP4 (moov
+first, a fragment per keyframe), so the response streams as the encoder
+produces it.  The same bytes go to the cache file; a second client asking
+for a token that is being rendered follows that file as it grows instead
+of starting another render.  A client that hangs up does not stop the
+render: the finished file still lands in the cache.
+
+What stays warm between requests:
+
+  templates  per seed: the WAV (segment --repeat 6), its .feat analysis
+             cache and the AAC track (chunk_encode.encode_audio), made on
+             the seed's first request at any tier and kept for the last
+             --templates seeds.  With the artifact cache (on unless
+             --no-cache) they come from and go to it, as generate_nft.sh's.
+  artifacts  finished MP4s in <work>/lru, least recently served evicted
+             first once they pass --max-cache-mb.  Served from disk with
+             Range support, so players can seek.
+
+Kernels resolve once per process (cpu_dispatch.c) in microseconds, and the
+binaries stay in the page cache; the expensive per-token state is the
+templates, which is what is kept.
+
+Concurrency: --jobs renders at once (default: cores / --threads), each
+with generate_frames --threads and x264 -threads of --threads; up to
+--queue more wait for a slot, beyond that a miss is answered 503 with
+Retry-After.  Cache hits never wait.
+
+Usage:
+  python3 render_server.py [--listen 127.0.0.1:8787] [--work serve_work]
+                           [--max-cache-mb 2048] [--templates 32]
+                           [--jobs N] [--threads 2] [--queue N] [--timeout SEC]
+                           [--cache DIR | --no-cache]
+  curl -o token.mp4 http://127.0.0.1:8787/token/0xDEADBEEF.mp4?tier=preview
+"""
+
+import argparse
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+import threading
+import time
+from collections import OrderedDict
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+from urllib.parse import parse_qs, urlsplit
+
+from artifact_cache import DEFAULT_CACHE, ArtifactCache
+from chunk_encode import AUDIO_PARAMS, encode_audio
+
+ROOT = Path(__file__).resolve().parent
+SEGMENT = ROOT / "src/c/bin/segment"
+GENERATE_FRAMES = ROOT / "generate_frames"
+REPEAT = 6  # loops in the shipped track (generate_nft.sh)
+FFMPEG = ["ffmpeg", "-hide_banner", "-loglevel", "error", "-y"]
+# generate_frames --format of each tier
+TIERS = {"full": "full", "preview": "preview"}
+# Fragmented MP4 on stdout: playable from the first fragment
+STREAM_ARGS = ["-map", "0:v:0", "-map", "1:a:0", "-c:v", "libx264", "-pix_fmt", "yuv420p",
+               "-c:a", "copy", "-shortest", "-movflags", "frag_keyframe+empty_moov+default_base_moof",
+               "-f", "mp4"]
+# What a seed argument may be (seed.h): nothing that could name another path
+SEED_RE = re.compile(r"^(0[xX])?[0-9a-fA-F]{1,64}$")
+TOKEN_RE = re.compile(r"^/token/([^/]+)\.mp4$")
+CHUNK = 1 << 16
+
+
+class Busy(Exception):
+    """Every render slot and queue place is taken"""
+
+
+class Lru:
+    """Finished artifacts in one directory, bounded by their total size"""
+
+    def __init__(self, root, max_bytes):
+        self.root = Path(root)
+        self.root.mkdir(parents=True, exist_ok=True)
+        self.max_bytes = max_bytes
+        self.lock = threading.Lock()
+        # name -> size, least recently used first (mtime order from a previous run)
+        self.entries = OrderedDict()
+        for p in sorted((p for p in self.root.iterdir() if p.suffix == ".mp4"), key=lambda p: p.stat().st_mtime):
+            self.entries[p.name] = p.stat().st_size
+        self.bytes = sum(self.entries.values())
+        self.hits = self.misses = self.evictions = 0
+
+    def get(self, name):
+        """Path of a cached artifact (now the most recent), or None"""
+        with self.lock:
+            if name not in self.entries:
+                self.misses += 1
+                return None
+            self.entries.move_to_end(name)
+            self.hits += 1
+            path = self.root / name
+            os.utime(path)  # keeps the order across restarts
+            return path
+
+    def put(self, name, src):
+        """Move `src` in as `name`, evicting the least recently used to fit"""
+        with self.lock:
+            size = src.stat().st_size
+            os.replace(src, self.root / name)
+            self.bytes += size - self.entries.pop(name, 0)
+            self.entries[name] = size
+            while self.bytes > self.max_bytes and len(self.entries) > 1:
+                old, old_size = self.entries.popitem(last=False)
+                # an open response keeps reading the unlinked file
+                (self.root / old).unlink(missing_ok=True)
+                self.bytes -= old_size
+                self.evictions += 1
+
+    def stats(self):
+        with self.lock:
+            return {"entries": len(self.entries), "bytes": self.bytes, "max_bytes": self.max_bytes,
+                    "hits": self.hits, "misses": self.misses, "evictions": self.evictions}
+
+
+class Render:
+    """One artifact being rendered: its growing file, followed by every client"""
+
+    def __init__(self, part, final):
+        self.part = part
+        self.final = final  # where the finished file is moved
+        self.size = 0
+        self.done = False
+        self.ok = False
+        self.cond = threading.Condition()
+
+    def grew(self, n):
+        with self.cond:
+            self.size += n
+            self.cond.notify_all()
+
+    def finish(self, ok):
+        with self.cond:
+            self.done, self.ok = True, ok
+            self.cond.notify_all()
+
+    def follow(self):
+        """The file's bytes as they are written; raises when the render fails"""
+        try:
+            f = open(self.part, "rb")
+        except FileNotFoundError:  # finished and moved since the lookup
+            f = open(self.final, "rb")
+        with f:
+            sent = 0
+            while True:
+                with self.cond:
+                    while self.size == sent and not self.done:
+                        self.cond.wait()
+                    size, done, ok = self.size, self.done, self.ok
+                while sent < size:
+                    b = f.read(min(CHUNK, size - sent))
+                    if not b:
+                        break
+                    sent += len(b)
+                    yield b
+                if done:
+                    if not ok:
+                        raise RuntimeError("render failed")
+                    return
+
+
+class Server:
+    def __init__(self, args):
+        self.work = Path(args.work).resolve()
+        self.lru = Lru(self.work / "lru", args.max_cache_mb << 20)
+        self.tmp = self.work / "rendering"
+        shutil.rmtree(self.tmp, ignore_errors=True)  # parts of a previous run
+        self.tmp.mkdir(parents=True)
+        self.cache = None if args.no_cache else ArtifactCache(args.cache, REPEAT)
+        self.threads = args.threads
+        self.timeout = args.timeout
+        self.slots = threading.Semaphore(args.jobs)
+        self.queue_max = args.jobs + args.queue
+        self.lock = threading.Lock()
+        self.waiting = 0
+        self.renders = {}  # artifact name -> Render in progress
+        self.max_templates = args.templates
+        self.templates = OrderedDict()  # seed -> lock; the directory once made
+        self.t0 = time.time()
+
+    # ---- per-seed templates ------------------------------------------------
+
+    def template(self, seed):
+        """WAV, .feat and AAC of the seed, made on its first request"""
+        with self.lock:
+            lock = self.templates.setdefault(seed, threading.Lock())
+            self.templates.move_to_end(seed)
+            # oldest first; one still in use goes on a later request
+            for old in list(self.templates)[:max(0, len(self.templates) - self.max_templates)]:
+                old_lock = self.templates[old]
+                if old_lock.acquire(blocking=False):
+                    del self.templates[old]
+                    shutil.rmtree(self.work / "templates" / old, ignore_errors=True)
+                    old_lock.release()
+        d = self.work / "templates" / seed
+        wav, feat, aac = d / "audio.wav", d / "audio.wav.feat", d / "audio.m4a"
+        with lock:
+            d.mkdir(parents=True, exist_ok=True)
+            with open(d / "log.txt", "ab") as log:
+                if not wav.exists() and not (self.cache and self.cache.fetch("audio", seed, wav)):
+                    part = d / "audio.part.wav"
+                    if not run([SEGMENT, "--repeat", REPEAT, seed, part], log, self.timeout):
+                        part.unlink(missing_ok=True)
+                        raise RuntimeError("audio render failed")
+                    os.replace(part, wav)
+                    if self.cache:
+                        self.cache.store("audio", seed, wav)
+                if not feat.exists() and not (self.cache and self.cache.fetch("feat", seed, feat)):
+                    if not run([GENERATE_FRAMES, wav, seed, "--metadata-only", "--metadata", d / "meta.json",
+                                "--dump-features"], log, self.timeout, cwd=d):
+                        raise RuntimeError("audio analysis failed")
+                    if self.cache and feat.exists():
+                        self.cache.store("feat", seed, feat)
+                if not aac.exists() and not (self.cache and self.cache.fetch("aac", seed, aac,
+                                                                             params=AUDIO_PARAMS)):
+                    if not encode_audio(wav, aac, self.timeout):
+                        raise RuntimeError("audio encode failed")
+                    if self.cache:
+                        self.cache.store("aac", seed, aac, params=AUDIO_PARAMS)
+        return wav, aac
+
+    # ---- renders -----------------------------------------------------------
+
+    def slot(self):
+        """Take a render slot, or raise Busy when the queue is full"""
+        with self.lock:
+            if self.waiting >= self.queue_max:
+                raise Busy()
+            self.waiting += 1
+        self.slots.acquire()
+
+    def release(self):
+        self.slots.release()
+        with self.lock:
+            self.waiting -= 1
+
+    def start(self, seed, tier, name):
+        """The Render of `name`, started unless one is already running"""
+        with self.lock:
+            r = self.renders.get(name)
+            if r:
+                return r
+        self.slot()
+        with self.lock:
+            r = self.renders.get(name)
+            if r:  # another request started it while this one queued
+                self.release()
+                return r
+            r = Render(self.tmp / f"{name}.{threading.get_ident()}.part", self.lru.root / name)
+            r.part.touch()
+            self.renders[name] = r
+        threading.Thread(target=self.render, args=(seed, tier, name, r), daemon=True).start()
+        return r
+
+    def render(self, seed, tier, name, r):
+        ok = False
+        log_path = r.part.with_suffix(".log")
+        try:
+            with open(log_path, "wb") as log:
+                try:
+                    wav, aac = self.template(seed)
+                except (RuntimeError, OSError) as e:
+                    log.write(f"[render_server] {e}\n".encode())
+                    raise
+                ok = self.encode(seed, tier, wav, aac, r, log)
+            if ok:
+                self.lru.put(name, r.part)
+        except (RuntimeError, OSError):
+            ok = False
+        finally:
+            if not ok:
+                tail = log_path.read_bytes()[-2000:].decode(errors="replace") if log_path.exists() else ""
+                print(f"❌ {name} failed\n{tail}".rstrip(), file=sys.stderr, flush=True)
+            with self.lock:
+                del self.renders[name]
+            r.finish(ok)  # followers keep their open handle after the move
+            r.part.unlink(missing_ok=True)
+            log_path.unlink(missing_ok=True)
+            self.release()
+            print(f"{'🎬' if ok else '⚠️ '} {name} {'rendered' if ok else 'failed'}", flush=True)
+
+    def encode(self, seed, tier, wav, aac, r, log):
+        frames = [GENERATE_FRAMES, wav, seed, "--pipe-y4m", "--format", TIERS[tier], "--threads", self.threads]
+        enc = FFMPEG + ["-f", "yuv4mpegpipe", "-i", "-", "-i", aac] + STREAM_ARGS + ["-threads", self.threads,
+                                                                                    "pipe:1"]
+        gen = subprocess.Popen([str(c) for c in frames], cwd=wav.parent, stdin=subprocess.DEVNULL,
+                               stdout=subprocess.PIPE, stderr=log)
+        ffm = subprocess.Popen([str(c) for c in enc], stdin=gen.stdout, stdout=subprocess.PIPE, stderr=log)
+        gen.stdout.close()  # ffmpeg owns the read end
+        # A hung render is killed; reading the pipe can't time out by itself
+        timer = threading.Timer(self.timeout, lambda: (gen.kill(), ffm.kill())) if self.timeout else None
+        if timer:
+            timer.start()
+        try:
+            with open(r.part, "ab") as out:
+                for b in iter(lambda: ffm.stdout.read1(CHUNK), b""):
+                    out.write(b)
+                    out.flush()
+                    r.grew(len(b))
+            ffm.stdout.close()
+            return ffm.wait() == 0 and gen.wait() == 0
+        finally:
+            if timer:
+                timer.cancel()
+            for p in (gen, ffm):
+                if p.poll() is None:
+                    p.kill()
+                    p.wait()
+
+    def stats(self):
+        with self.lock:
+            rendering, waiting = sorted(self.renders), self.waiting
+        return {"cache": self.lru.stats(), "rendering": rendering, "waiting": max(0, waiting - len(rendering)),
+                "templates": len(self.templates), "uptime_sec": round(time.time() - self.t0)}
+
+
+def run(cmd, log, timeout, cwd=None):
+    """True if `cmd` exits 0 within `timeout` seconds; its stderr goes to `log`"""
+    try:
+        p = subprocess.run([str(c) for c in cmd], stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL,
+                           stderr=log, cwd=cwd, timeout=timeout or None)
+    except subprocess.TimeoutExpired:
+        log.write(f"\n[render_server] timeout after {timeout}s\n".encode())
+        return False
+    return p.returncode == 0
+
+
+def parse_range(header, size):
+    """(start, end) of a single "bytes=a-b" range, None for the whole file"""
+    m = re.match(r"^bytes=(\d*)-(\d*)$", header or "")
+    if not m or not (m[1] or m[2]):
+        return None
+    if m[1]:
+        start, end = int(m[1]), int(m[2]) if m[2] else size - 1
+    else:
+        start, end = max(0, size - int(m[2])), size - 1
+    return (start, min(end, size - 1)) if start < size else (size, size - 1)
+
+
+class Handler(BaseHTTPRequestHandler):
+    server_version = "notdeafbeef-serve"
+    protocol_version = "HTTP/1.1"
+
+    def do_GET(self):
+        url = urlsplit(self.path)
+        if url.path == "/stats":
+            self.reply(200, "application/json", json.dumps(self.server.app.stats()).encode() + b"\n")
+            return
+        m = TOKEN_RE.match(url.path)
+        tier = parse_qs(url.query).get("tier", ["full"])[0]
+        if not m or not SEED_RE.match(m[1]) or tier not in TIERS:
+            self.reply(404, "text/plain", b"not found\n")
+            return
+        seed = m[1]
+        name = f"{seed}_{tier}.mp4"
+        app = self.server.app
+        path = app.lru.get(name)
+        if path:
+            self.send_file(path)
+            return
+        try:
+            r = app.start(seed, tier, name)
+        except Busy:
+            self.reply(503, "text/plain", b"busy, try again\n", {"Retry-After": "30"})
+            return
+        self.stream(r)
+
+    def reply(self, code, ctype, body, headers=None):
+        self.send_response(code)
+        self.send_header("Content-Type", ctype)
+        self.send_header("Content-Length", str(len(body)))
+        for k, v in (headers or {}).items():
+            self.send_header(k, v)
+        self.end_headers()
+        self.wfile.write(body)
+
+    def send_file(self, path):
+        try:
+            f = open(path, "rb")
+        except FileNotFoundError:  # evicted since the lookup
+            self.reply(503, "text/plain", b"evicted, try again\n", {"Retry-After": "1"})
+            return
+        with f:
+            size = os.fstat(f.fileno()).st_size
+            rng = parse_range(self.headers.get("Range"), size)
+            if rng and rng[0] >= size:
+                self.reply(416, "text/plain", b"bad range\n", {"Content-Range": f"bytes */{size}"})
+                return
+            start, end = rng or (0, size - 1)
+            self.send_response(206 if rng else 200)
+            self.send_header("Content-Type", "video/mp4")
+            self.send_header("Accept-Ranges", "bytes")
+            self.send_header("Content-Length", str(end - start + 1))
+            if rng:
+                self.send_header("Content-Range", f"bytes {start}-{end}/{size}")
+            self.end_headers()
+            f.seek(start)
+            left = end - start + 1
+            while left > 0:
+                b = f.read(min(CHUNK, left))
+                if not b:
+                    break
+                self.wfile.write(b)
+                left -= len(b)
+
+    def stream(self, r):
+        """The render's bytes as they come, chunked (the length isn't known yet)"""
+        self.send_response(200)
+        self.send_header("Content-Type", "video/mp4")
+        self.send_header("Transfer-Encoding", "chunked")
+        self.end_headers()
+        try:
+            for b in r.follow():
+                self.wfile.write(b"%x\r\n%s\r\n" % (len(b), b))
+        except (RuntimeError, FileNotFoundError):
+            self.close_connection = True  # no terminating chunk: the client sees a cut response
+            return
+        self.wfile.write(b"0\r\n\r\n")
+
+    def log_message(self, fmt, *args):
+        print(f"🌐 {self.address_string()} {fmt % args}", flush=True)
+
+
+def main():
+    cores = os.cpu_count() or 1
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("--listen", default="127.0.0.1:8787", help="host:port to serve on")
+    ap.add_argument("--work", default="serve_work", help="templates, renders in progress and the LRU")
+    ap.add_argument("--max-cache-mb", type=int, default=2048, help="disk the finished MP4s may use")
+    ap.add_argument("--templates", type=int, default=32, help="seeds whose WAV/.feat/AAC are kept")
+    ap.add_argument("--threads", type=int, default=2, help="renderer and x264 threads per render")
+    ap.add_argument("--jobs", type=int, help="renders at once (default: cores / --threads)")
+    ap.add_argument("--queue", type=int, help="renders that may wait for a slot (default: 4 x --jobs)")
+    ap.add_argument("--timeout", type=float, default=1800, help="per-render timeout in seconds (0: none)")
+    ap.add_argument("--cache", default=str(DEFAULT_CACHE), help="artifact cache for the templates")
+    ap.add_argument("--no-cache", action="store_true", help="always make templates from scratch")
+    args = ap.parse_args()
+    if args.threads < 1 or args.templates < 1:
+        ap.error("--threads and --templates must be at least 1")
+    args.jobs = args.jobs or max(1, cores // args.threads)
+    args.queue = 4 * args.jobs if args.queue is None else args.queue
+    for tool in (SEGMENT, GENERATE_FRAMES):
+        if not tool.exists():
+            sys.exit(f"❌ {tool} not found (make c-build generate_frames)")
+    if not shutil.which("ffmpeg"):
+        sys.exit("❌ ffmpeg not found")
+
+    host, _, port = args.listen.rpartition(":")
+    httpd = ThreadingHTTPServer((host or "127.0.0.1", int(port)), Handler)
+    httpd.daemon_threads = True
+    httpd.app = Server(args)
+    print(f"🚀 notdeafbeef-serve on http://{host or '127.0.0.1'}:{port}/token/<seed>.mp4 "
+          f"({args.jobs} renders x {args.threads} threads, queue {args.queue}, "
+          f"cache {args.max_cache_mb} MB in {httpd.app.lru.root})", flush=True)
+    try:
+        httpd.serve_forever()
+    except KeyboardInterrupt:
+        print("\n👋 Stopping", flush=True)
+    finally:
+        httpd.server_close()
+
+
+if __name__ == "__main__":
+    main()
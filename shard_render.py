@@ -0,0 +1,398 @@
+#!/usr/bin/env python3
+"""Render one token's frames across machines and stitch the archive.
+
+Frame rendering is seekable: generate_frames --range replays the frames
+before a slice without drawing them and then renders exactly the frames
+a full run would.  So a token's frames split into ranges that render on
+separate hosts, and the lossless delta archive (--delta-out, .ndfd)
+joins them without re-encoding.  Each range starts on a multiple of the
+keyframe interval, so its first frame is the keyframe the full archive
+has there; the stitched file is byte-identical to a single-process
+--delta-out render.
+
+  worker       serves render requests on a TCP port.  Each machine renders
+               the token's audio itself (segment --repeat 6, kept per seed
+               in --work), then a range with generate_frames --range
+               --delta-out --digest --digest-only.
+  coordinator  asks a worker for the token's frame count and splits the
+               frames into GOP-aligned ranges.  It keeps every worker busy
+               with ranges and checks each segment as it arrives: the
+               header must match the range, and its frames, decoded with
+               bin/delta_decode --digest, must hash to the worker's
+               manifest.  A range that fails or does not verify is retried
+               on the next free worker, up to --retries times.  The checked
+               segments are then concatenated: the first header, then
+               every segment's records.  The stitched archive is decoded
+               once more and its manifest (--digest) must equal the
+               shards' manifests joined.  That is the file verify_nft.sh
+               compares against a full render.
+
+Protocol (one request per connection): a JSON line, answered by a JSON
+line whose "blobs" lists the byte counts of the raw payloads after it.
+
+  {"op": "probe", "seed": S}                        -> {"ok", "frames"}
+  {"op": "render", "seed": S, "start": A, "end": B, "keyint": K}
+                         -> {"ok", "blobs": [n, m]} + segment.ndfd + manifest
+  failures               -> {"ok": false, "error": "..."}
+
+Usage:
+  python3 shard_render.py worker [--listen 0.0.0.0:7878] [--jobs N] [--work DIR]
+  python3 shard_render.py coordinator <seed> --workers host:port[,host:port...]
+                          [--out <seed>_frames.ndfd] [--digest out.digest]
+                          [--keyint 60] [--gops 5] [--retries 3] [--timeout SEC]
+  ./bin/delta_decode <seed>_frames.ndfd --y4m | ffmpeg -i - -i audio.wav ...
+"""
+
+import argparse
+import json
+import os
+import queue
+import re
+import shutil
+import socket
+import socketserver
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent
+SEGMENT = ROOT / "src/c/bin/segment"
+GENERATE_FRAMES = ROOT / "generate_frames"
+DELTA_DECODE = ROOT / "bin/delta_decode"
+REPEAT = 6            # loops in the shipped track (generate_nft.sh)
+VIS_FPS = 60          # generate_frames' native rate: one keyframe a second by default
+FD_HEADER = struct.Struct("<4s6I")   # fd_header_t (src/include/frame_delta.h)
+FD_MAGIC = b"NDFD"
+# What a seed argument may be (seed.h): nothing that could name another path
+SEED_RE = re.compile(r"^(0[xX])?[0-9a-fA-F]{1,64}$")
+
+
+# ---- wire format -----------------------------------------------------------
+
+def send_msg(sock, msg, blobs=()):
+    msg = dict(msg, blobs=[len(b) for b in blobs])
+    sock.sendall(json.dumps(msg).encode() + b"\n")
+    for b in blobs:
+        sock.sendall(b)
+
+
+def recv_msg(f):
+    """One JSON line and its blobs from a socket file; ConnectionError if cut short"""
+    line = f.readline()
+    if not line.endswith(b"\n"):
+        raise ConnectionError("connection closed")
+    msg = json.loads(line)
+    blobs = []
+    for n in msg.get("blobs", []):
+        b = f.read(n)
+        if len(b) != n:
+            raise ConnectionError(f"short payload ({len(b)} of {n} bytes)")
+        blobs.append(b)
+    return msg, blobs
+
+
+def parse_addr(s, default_host="127.0.0.1"):
+    host, _, port = s.rpartition(":")
+    return (host or default_host, int(port))
+
+
+def fd_header(data):
+    """fd_header_t fields of an archive, or None if it is not one"""
+    if len(data) < FD_HEADER.size:
+        return None
+    magic, version, width, height, fps, keyint, first = FD_HEADER.unpack_from(data)
+    if magic != FD_MAGIC:
+        return None
+    return {"version": version, "width": width, "height": height, "fps": fps,
+            "keyint": keyint, "first_frame": first}
+
+
+def run(cmd, log, timeout, cwd=None):
+    """True if `cmd` exits 0 within `timeout` seconds; its stderr goes to `log`"""
+    try:
+        p = subprocess.run([str(c) for c in cmd], stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL,
+                           stderr=log, cwd=cwd, timeout=timeout or None)
+    except subprocess.TimeoutExpired:
+        log.write(f"\n[shard_render] timeout after {timeout}s\n".encode())
+        return False
+    return p.returncode == 0
+
+
+# ---- worker ----------------------------------------------------------------
+
+class Worker:
+    def __init__(self, args):
+        self.work = Path(args.work)
+        self.work.mkdir(parents=True, exist_ok=True)
+        self.timeout = args.timeout
+        self.slots = threading.Semaphore(args.jobs)
+        self.lock = threading.Lock()
+        self.seed_locks = {}
+
+    def audio(self, seed, log):
+        """The token's WAV on this machine, rendered on first use"""
+        with self.lock:
+            seed_lock = self.seed_locks.setdefault(seed, threading.Lock())
+        wav = self.work / seed / "audio.wav"
+        with seed_lock:
+            if not wav.exists():
+                wav.parent.mkdir(parents=True, exist_ok=True)
+                part = wav.with_name(wav.name + ".part")
+                if not run([SEGMENT, "--repeat", REPEAT, seed, part], log, self.timeout):
+                    part.unlink(missing_ok=True)
+                    raise RuntimeError("audio render failed")
+                os.replace(part, wav)
+        return wav
+
+    def probe(self, req, tmp, log):
+        wav = self.audio(req["seed"], log)
+        meta = tmp / "meta.json"
+        if not run([GENERATE_FRAMES, wav, req["seed"], "--metadata-only", "--metadata", meta],
+                   log, self.timeout, cwd=tmp):
+            raise RuntimeError("metadata failed")
+        with open(meta) as f:
+            return {"ok": True, "frames": json.load(f)["frame_count"]}, ()
+
+    def render(self, req, tmp, log):
+        start, end, keyint = int(req["start"]), int(req["end"]), int(req["keyint"])
+        if start < 0 or end <= start or keyint < 1 or start % keyint:
+            raise ValueError(f"bad range {start}-{end} (keyint {keyint})")
+        wav = self.audio(req["seed"], log)
+        seg, manifest = tmp / "segment.ndfd", tmp / "segment.digest"
+        if not run([GENERATE_FRAMES, wav, req["seed"], "--range", start, end, "--delta-out", seg,
+                    "--keyint", keyint, "--digest", manifest, "--digest-only"], log, self.timeout, cwd=tmp):
+            raise RuntimeError(f"frames {start}-{end - 1} failed")
+        return {"ok": True}, (seg.read_bytes(), manifest.read_bytes())
+
+    def handle(self, sock):
+        f = sock.makefile("rb")
+        try:
+            req, _ = recv_msg(f)
+            op = {"probe": self.probe, "render": self.render}.get(req.get("op"))
+            if op is None or not SEED_RE.match(str(req.get("seed", ""))):
+                send_msg(sock, {"ok": False, "error": "bad request"})
+                return
+            with self.slots, tempfile.TemporaryDirectory(dir=self.work) as tmp:
+                log_path = Path(tmp) / "log.txt"
+                try:
+                    with open(log_path, "wb") as log:
+                        reply, blobs = op(req, Path(tmp), log)
+                except (RuntimeError, ValueError, OSError, KeyError) as e:
+                    tail = log_path.read_bytes()[-2000:].decode(errors="replace") if log_path.exists() else ""
+                    send_msg(sock, {"ok": False, "error": f"{e}\n{tail}".strip()})
+                    return
+            send_msg(sock, reply, blobs)
+        except (ConnectionError, json.JSONDecodeError, OSError) as e:
+            print(f"⚠️  Request dropped: {e}", file=sys.stderr, flush=True)
+        finally:
+            f.close()
+
+
+def serve(args):
+    for tool in (SEGMENT, GENERATE_FRAMES):
+        if not tool.exists():
+            sys.exit(f"❌ {tool} not found (make c-build generate_frames)")
+    worker = Worker(args)
+
+    class Handler(socketserver.BaseRequestHandler):
+        def handle(self):
+            worker.handle(self.request)
+
+    socketserver.ThreadingTCPServer.allow_reuse_address = True
+    with socketserver.ThreadingTCPServer(parse_addr(args.listen, "0.0.0.0"), Handler) as srv:
+        srv.daemon_threads = True
+        print(f"🛰️  Shard worker on {args.listen}: {args.jobs} job(s) at a time, work dir {args.work}", flush=True)
+        try:
+            srv.serve_forever()
+        except KeyboardInterrupt:
+            pass
+
+
+# ---- coordinator -----------------------------------------------------------
+
+def request(addr, msg, timeout):
+    with socket.create_connection(addr, timeout=timeout or None) as sock:
+        send_msg(sock, msg)
+        with sock.makefile("rb") as f:
+            reply, blobs = recv_msg(f)
+    if not reply.get("ok"):
+        raise RuntimeError(reply.get("error", "worker error"))
+    return reply, blobs
+
+
+def manifest_parts(text):
+    """The part lines of a digest manifest (digest.h), and its header line"""
+    lines = text.splitlines()
+    if len(lines) < 2 or not lines[0].startswith("ndb-digest ") or not lines[-1].startswith("total "):
+        raise ValueError("not a digest manifest")
+    return lines[0], lines[1:-1]
+
+
+class Coordinator:
+    def __init__(self, args):
+        self.args = args
+        self.workers = [parse_addr(w.strip()) for w in args.workers.split(",") if w.strip()]
+        self.tmp = Path(tempfile.mkdtemp(prefix="shard_render."))
+        self.print_lock = threading.Lock()
+        self.failed = threading.Event()
+
+    def log(self, msg):
+        with self.print_lock:
+            print(msg, flush=True)
+
+    def probe(self):
+        for addr in self.workers:
+            try:
+                reply, _ = request(addr, {"op": "probe", "seed": self.args.seed}, self.args.timeout)
+                return int(reply["frames"])
+            except (OSError, RuntimeError, ValueError, KeyError) as e:
+                self.log(f"⚠️  {addr[0]}:{addr[1]}: probe failed: {e}")
+        sys.exit("❌ No worker answered the probe")
+
+    def verify(self, shard, seg, manifest):
+        """Raise ValueError unless the segment is the range and decodes to the manifest"""
+        start, end = shard
+        hdr = fd_header(seg)
+        if hdr is None or hdr["first_frame"] != start or hdr["keyint"] != self.args.keyint:
+            raise ValueError("segment header does not match the range")
+        header, parts = manifest_parts(manifest.decode())
+        if len(parts) != end - start or not parts[0].startswith(f"f {start} "):
+            raise ValueError(f"manifest has {len(parts)} frames, expected {end - start} from {start}")
+        seg_path = self.tmp / f"{start:06d}.ndfd"
+        seg_path.write_bytes(seg)
+        check = seg_path.with_suffix(".digest")
+        with open(self.tmp / f"{start:06d}.log", "wb") as log:
+            if not run([DELTA_DECODE, seg_path, "--digest", check], log, self.args.timeout):
+                raise ValueError("segment does not decode")
+        if check.read_bytes() != manifest:
+            raise ValueError("decoded frames do not match the worker's digest")
+        return hdr, header, parts
+
+    def worker_loop(self, addr, todo, done):
+        name = f"{addr[0]}:{addr[1]}"
+        while not self.failed.is_set() and len(done) < len(self.shards):
+            try:
+                shard, attempt = todo.get(timeout=0.2)
+            except queue.Empty:
+                continue
+            start, end = shard
+            t0 = time.perf_counter()
+            try:
+                _, (seg, manifest) = request(addr, {"op": "render", "seed": self.args.seed, "start": start,
+                                                    "end": end, "keyint": self.args.keyint}, self.args.timeout)
+                done[shard] = self.verify(shard, seg, manifest)
+                self.log(f"   ✅ frames {start}-{end - 1} from {name} "
+                         f"({len(seg) / 1e6:.1f} MB, {time.perf_counter() - t0:.1f}s)")
+            except (OSError, RuntimeError, ValueError) as e:
+                reason = str(e).splitlines()[0] if str(e) else type(e).__name__
+                if attempt >= self.args.retries:
+                    self.log(f"   ❌ frames {start}-{end - 1}: {reason} (gave up after {attempt + 1} tries)")
+                    self.failed.set()
+                else:
+                    self.log(f"   🔁 frames {start}-{end - 1} on {name}: {reason}, retrying")
+                    todo.put((shard, attempt + 1))
+                    time.sleep(min(2.0 ** attempt, 10.0))  # a dead host stops claiming work
+
+    def go(self):
+        args = self.args
+        total = self.probe()
+        span = args.keyint * args.gops
+        self.shards = [(s, min(s + span, total)) for s in range(0, total, span)]
+        self.log(f"🧩 {total} frames in {len(self.shards)} ranges of {span}, "
+                 f"on {len(self.workers)} worker(s)")
+        todo = queue.Queue()
+        for shard in self.shards:
+            todo.put((shard, 0))
+        done = {}
+        threads = [threading.Thread(target=self.worker_loop, args=(addr, todo, done), daemon=True)
+                   for addr in self.workers for _ in range(args.jobs)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        if self.failed.is_set() or len(done) != len(self.shards):
+            return False
+        return self.stitch(done, total)
+
+    def stitch(self, done, total):
+        args = self.args
+        hdrs = [done[s][0] for s in self.shards]
+        if any((h["width"], h["height"], h["fps"]) != (hdrs[0]["width"], hdrs[0]["height"], hdrs[0]["fps"])
+               for h in hdrs):
+            self.log("❌ Workers rendered different frame formats")
+            return False
+        out = Path(args.out)
+        part = out.with_name(out.name + ".part")
+        with open(part, "wb") as f:
+            for i, (start, _) in enumerate(self.shards):
+                seg = (self.tmp / f"{start:06d}.ndfd").read_bytes()
+                f.write(seg if i == 0 else seg[FD_HEADER.size:])
+        # The whole archive decodes to the shards' frames, in order
+        digest = Path(args.digest) if args.digest else out.with_name(out.name + ".digest")
+        with open(self.tmp / "stitched.log", "wb") as log:
+            ok = run([DELTA_DECODE, part, "--digest", digest], log, args.timeout)
+        header, parts = manifest_parts(digest.read_text()) if ok else (None, None)
+        want = [p for s in self.shards for p in done[s][2]]
+        if not ok or header != done[self.shards[0]][1] or parts != want or len(parts) != total:
+            self.log(f"❌ The stitched archive does not decode to the shards' frames (kept {part})")
+            return False
+        os.replace(part, out)
+        self.log(f"📼 {out}: {total} frames, {out.stat().st_size / 1e6:.1f} MB; manifest {digest}")
+        return True
+
+
+def coordinate(args):
+    if not SEED_RE.match(args.seed):
+        sys.exit(f"❌ Bad seed '{args.seed}'")
+    if not DELTA_DECODE.exists():
+        sys.exit(f"❌ {DELTA_DECODE} not found (make bin/delta_decode)")
+    if not args.out:
+        args.out = f"{args.seed}_frames.ndfd"
+    c = Coordinator(args)
+    if not c.workers:
+        sys.exit("❌ No workers given")
+    t0 = time.perf_counter()
+    try:
+        ok = c.go()
+    finally:
+        shutil.rmtree(c.tmp, ignore_errors=True)
+    print(f"{'🎉' if ok else '❌'} {'Done' if ok else 'Failed'} in {time.perf_counter() - t0:.1f}s")
+    sys.exit(0 if ok else 1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    sub = ap.add_subparsers(dest="mode", required=True)
+    w = sub.add_parser("worker", help="serve range renders over TCP")
+    w.add_argument("--listen", default="0.0.0.0:7878", help="host:port to listen on")
+    w.add_argument("--jobs", type=int, default=max(1, (os.cpu_count() or 1) // 2),
+                   help="ranges rendered at once (default: cores/2)")
+    w.add_argument("--work", default="shard_work", help="audio cache and scratch directory")
+    w.add_argument("--timeout", type=float, default=1800, help="per-render timeout in seconds (0: none)")
+    c = sub.add_parser("coordinator", help="shard one token's frames across workers")
+    c.add_argument("seed", help="transaction hash / seed")
+    c.add_argument("--workers", required=True, help="comma-separated host:port list")
+    c.add_argument("--jobs", type=int, default=1, help="ranges in flight per worker (match its --jobs)")
+    c.add_argument("--out", help="stitched archive (default: <seed>_frames.ndfd)")
+    c.add_argument("--digest", help="frame manifest of the archive (default: <out>.digest)")
+    c.add_argument("--keyint", type=int, default=VIS_FPS, help="frames between keyframes")
+    c.add_argument("--gops", type=int, default=5, help="keyframe intervals per range")
+    c.add_argument("--retries", type=int, default=3, help="extra tries per range")
+    c.add_argument("--timeout", type=float, default=1800, help="per-request timeout in seconds (0: none)")
+    args = ap.parse_args()
+    if args.mode == "worker":
+        if args.jobs < 1:
+            ap.error("--jobs must be at least 1")
+        serve(args)
+    else:
+        if args.keyint < 1 or args.gops < 1 or args.jobs < 1 or args.retries < 0:
+            ap.error("--keyint, --gops and --jobs must be at least 1, --retries at least 0")
+        coordinate(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -4,34 +4,27 @@
 #include <stdbool.h>
 #include <string.h>
 #include <math.h>
-
-// WAV file header structure
-typedef struct {
-    char riff[4];           // "RIFF"
-    uint32_t chunk_size;    // File size - 8
-    char wave[4];           // "WAVE"
-    char fmt[4];            // "fmt "
-    uint32_t fmt_size;      // Format chunk size
-    uint16_t audio_format;  // Audio format (1 = PCM)
-    uint16_t num_channels;  // Number of channels
-    uint32_t sample_rate;   // Sample rate
-    uint32_t byte_rate;     // Byte rate
-    uint16_t block_align;   // Block align
-    uint16_t bits_per_sample; // Bits per sample
-    char data[4];           // "data"
-    uint32_t data_size;     // Data size
-} wav_header_t;
+#include <unistd.h>
+#include "src/include/visual_types.h"
+#include "src/include/audio_features.h"
+#include "src/include/wav_map.h"
+#include "src/c/include/pcm16.h"
 
 // Audio analysis data
 typedef struct {
-    int16_t *samples;       // Raw audio samples (stereo interleaved)
+    const int16_t *samples; // Raw audio samples (stereo interleaved), view into `wav`
     uint32_t sample_count;  // Total samples (left + right)
     uint32_t frame_count;   // Number of stereo frames
     uint32_t sample_rate;   // Sample rate (Hz)
     float duration;         // Duration in seconds
+    uint64_t hash;          // audio_features_hash of the PCM data (cache key), once hashed
+    bool hashed;
 } audio_data_t;
 
 static audio_data_t audio_data = {0};
+static wav_map_t wav = {0};               // mapped file backing audio_data.samples
+static audio_features_t features = {0};   // per-frame cache, when attached
+static bool have_features = false;
 
 // Simple audio level calculation (RMS)
 float calculate_audio_level_at_frame(int frame_number, float fps) {
@@ -55,80 +48,70 @@ float calculate_audio_level_at_frame(int frame_number, float fps) {
         start_sample = (end_sample > window_size) ? end_sample - window_size : 0;
     }
     
-    float sum_squares = 0.0f;
-    uint32_t count = 0;
-    
-    for (uint32_t i = start_sample; i < end_sample; i++) {
-        float left = audio_data.samples[i * 2] / 32768.0f;
-        float right = audio_data.samples[i * 2 + 1] / 32768.0f;
-        float mono = (left + right) * 0.5f;
-        sum_squares += mono * mono;
-        count++;
-    }
-    
+    uint32_t count = end_sample - start_sample;
     if (count == 0) return 0.2f;
+    float sum_squares = pcm16_mono_sumsq(audio_data.samples + (size_t)start_sample * 2, count);
     
     float rms = sqrtf(sum_squares / count);
     return fminf(1.0f, fmaxf(0.0f, rms * 3.0f)); // Scale and clamp
 }
 
+// Point audio_data at the samples of the attached `wav`.  The per-frame
+// analysis waits for analyse_audio_features: a .feat cache may replace it,
+// and a run that draws nothing never needs it.
+static void audio_data_from_wav(void) {
+    audio_data.samples = wav.samples;
+    audio_data.sample_count = wav.sample_count;
+    audio_data.hashed = false;
+    audio_data.frame_count = wav.frames;
+    audio_data.sample_rate = wav.sample_rate;
+    audio_data.duration = (float)audio_data.frame_count / wav.sample_rate;
+    
+    printf("Loaded WAV: %d samples, %.2f seconds, %d Hz\n", 
+           audio_data.frame_count, audio_data.duration, audio_data.sample_rate);
+
+    audio_features_free(&features);
+    have_features = false;
+}
+
+// The .feat cache key, hashed on first use: a track without a cache is
+// never read for it
+static uint64_t audio_data_hash(void) {
+    if (!audio_data.hashed) {
+        audio_data.hash = audio_features_hash(wav.samples, (size_t)wav.sample_count * sizeof(int16_t));
+        audio_data.hashed = true;
+    }
+    return audio_data.hash;
+}
+
+// Every frame's level and bands in one pass, unless a cache is attached
+bool analyse_audio_features(void) {
+    if (have_features) return true;
+    if (!audio_data.samples) return false;
+    have_features = audio_features_from_pcm(wav.samples, wav.frames, wav.channels, wav.sample_rate, VIS_FPS,
+                                            (uint32_t)(audio_data.duration * VIS_FPS), &features);
+    return have_features;
+}
+
 // Load WAV file
 bool load_wav_file(const char* filename) {
-    FILE* file = fopen(filename, "rb");
-    if (!file) {
+    // Map the file and walk its chunks; samples stay in the page cache
+    if (!wav_map_open(filename, &wav)) {
         printf("Failed to open WAV file: %s\n", filename);
         return false;
     }
-    
-    wav_header_t header;
-    if (fread(&header, sizeof(header), 1, file) != 1) {
-        printf("Failed to read WAV header\n");
-        fclose(file);
-        return false;
-    }
-    
-    // Basic validation
-    if (strncmp(header.riff, "RIFF", 4) != 0 || 
-        strncmp(header.wave, "WAVE", 4) != 0 ||
-        strncmp(header.data, "data", 4) != 0) {
-        printf("Invalid WAV file format\n");
-        fclose(file);
-        return false;
-    }
-    
-    if (header.audio_format != 1 || header.bits_per_sample != 16) {
-        printf("Unsupported WAV format (need 16-bit PCM)\n");
-        fclose(file);
-        return false;
-    }
-    
-    // Allocate and read sample data
-    uint32_t sample_count = header.data_size / 2; // 16-bit samples
-    audio_data.samples = malloc(header.data_size);
-    if (!audio_data.samples) {
-        printf("Failed to allocate memory for samples\n");
-        fclose(file);
-        return false;
-    }
-    
-    if (fread(audio_data.samples, header.data_size, 1, file) != 1) {
-        printf("Failed to read sample data\n");
-        free(audio_data.samples);
-        audio_data.samples = NULL;
-        fclose(file);
+    audio_data_from_wav();
+    return true;
+}
+
+// Same from a WAV image the caller keeps alive until cleanup_audio_data
+// (the notdeafbeef driver renders the track in memory)
+bool load_wav_memory(const void *data, size_t len, const char *name) {
+    if (!wav_map_memory(data, len, name, &wav)) {
+        printf("Failed to parse WAV image: %s\n", name);
         return false;
     }
-    
-    audio_data.sample_count = sample_count;
-    audio_data.frame_count = sample_count / header.num_channels;
-    audio_data.sample_rate = header.sample_rate;
-    audio_data.duration = (float)audio_data.frame_count / header.sample_rate;
-    
-    fclose(file);
-    
-    printf("Loaded WAV: %d samples, %.2f seconds, %d Hz\n", 
-           audio_data.frame_count, audio_data.duration, audio_data.sample_rate);
-    
+    audio_data_from_wav();
     return true;
 }
 
@@ -137,6 +120,21 @@ float get_audio_duration() {
     return audio_data.duration;
 }
 
+// The loaded PCM, interleaved 16-bit (the generate_frames --encode audio)
+const int16_t *get_audio_samples(uint32_t *frames, uint32_t *sample_rate, int *channels) {
+    *frames = audio_data.frame_count;
+    *sample_rate = audio_data.sample_rate;
+    *channels = wav.channels;
+    return audio_data.samples;
+}
+
+// Length of one loop of the track in seconds: the first seam of the smpl
+// loop segment writes for --repeat/--bars renders (0 when there is none)
+float get_audio_loop_period() {
+    if (!wav.has_loop || wav.loop_start == 0 || !audio_data.sample_rate) return 0.0f;
+    return (float)wav.loop_start / audio_data.sample_rate;
+}
+
 bool is_audio_finished() {
     return false; // For frame generation, never consider audio "finished"
 }
@@ -146,8 +144,42 @@ void print_audio_info() {
            audio_data.duration, audio_data.sample_rate, audio_data.frame_count);
 }
 
-float get_audio_rms_for_frame(int frame_number, float fps) {
-    return calculate_audio_level_at_frame(frame_number, fps);
+float get_audio_rms_for_frame(int frame_number) {
+    if (have_features && frame_number >= 0 && (uint32_t)frame_number < features.frames) {
+        return fminf(1.0f, fmaxf(0.0f, features.rms[frame_number] * 3.0f)); // as calculate_audio_level_at_frame
+    }
+    return calculate_audio_level_at_frame(frame_number, (float)VIS_FPS);
+}
+
+// Bass/treble band levels (0..1) for get_bass_energy/get_treble_energy;
+// false past the analysed frames
+bool get_audio_bands_for_frame(int frame_number, float *bass, float *treble) {
+    if (!have_features || frame_number < 0 || (uint32_t)frame_number >= features.frames) return false;
+    *bass = features.bass[frame_number];
+    *treble = features.treble[frame_number];
+    return true;
+}
+
+// Attach the per-frame feature cache <wav_path>.feat.  With dump, the
+// features are analysed and (re)written; otherwise a cache is used only
+// if it was made from this exact audio.
+bool attach_audio_features(const char *wav_path, bool dump) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s.feat", wav_path);
+
+    if (!dump) {
+        audio_features_t cached;
+        if (access(path, R_OK) != 0 || !audio_features_load(path, audio_data_hash(), VIS_FPS, &cached)) return false;
+        audio_features_free(&features);
+        features = cached;
+        have_features = true;
+        return true;
+    }
+
+    if (analyse_audio_features() && audio_features_save(path, &features, audio_data_hash()) == 0) {
+        printf("Wrote feature cache %s (%u frames)\n", path, features.frames);
+    }
+    return have_features;
 }
 
 float get_max_rms() {
@@ -160,12 +192,13 @@ float get_audio_bpm() {
 
 // Cleanup
 void cleanup_audio_data() {
-    if (audio_data.samples) {
-        free(audio_data.samples);
-        audio_data.samples = NULL;
-    }
+    audio_features_free(&features);
+    have_features = false;
+    wav_map_close(&wav);
+    audio_data.samples = NULL;
     audio_data.sample_count = 0;
     audio_data.frame_count = 0;
     audio_data.sample_rate = 0;
     audio_data.duration = 0.0f;
+    audio_data.hashed = false;
 }
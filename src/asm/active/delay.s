@@ -1,6 +1,7 @@
 .text
 .align 2
 .globl _delay_process_block
+.include "offsets.inc"   // D_* offsets of delay_t
 
 // -----------------------------------------------------------------------------
 // void delay_process_block(delay_t *d, float *L, float *R, uint32_t n, float feedback)
@@ -28,12 +29,14 @@ _delay_process_block:
     stp x27, x28, [sp, #480]
 
     // Load struct members (buf,size,idx) into convenient regs
-    ldr x4, [x0]       // buf*
-    ldr w5, [x0, #8]   // size
-    ldr w6, [x0, #12]  // idx
+    ldr x4, [x0, #D_BUF]       // buf*
+    ldr w5, [x0, #D_SIZE]   // size
+    ldr w6, [x0, #D_IDX]  // idx
 
-    // Early-out if n==0
+    // Early-out if n==0 or the delay has no storage (GEN_INIT_NO_DELAY)
     cbz w3, Ldone
+    cbz x4, Ldone
+    cbz w5, Ldone
 
     // --- PRE-WRAP BUG FIX ----------------------------------------------------
     // Make absolutely sure idx is in range BEFORE first buffer access.
@@ -84,7 +87,7 @@ Lloop:
 
 Lstore_idx:
     // Store updated idx back to struct
-    str w6, [x0, #12]
+    str w6, [x0, #D_IDX]
 
 Ldone:
     // Epilogue – mirror prologue order
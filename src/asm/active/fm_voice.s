@@ -9,31 +9,32 @@
 .L_onehundredtwenty:
 	.float 120.0
 
+	.include "offsets.inc"
+
 	.text
 	.align 2
 	.globl _fm_voice_process
 
 // fm_voice_process(fm_voice_t *v, float32_t *L, float32_t *R, uint32_t n)
-// Struct offsets: sr=0, carrier_freq=4, ratio=8, index0=12, amp=16, decay=20
-// len=24, pos=28, carrier_phase=32, mod_phase=36
+// Struct offsets: FM_* in offsets.inc (generated from fm_voice.h)
 _fm_voice_process:
     // x0 = fm_voice_t *v, x1 = L, x2 = R, x3 = n
     
     // Early exit if pos >= len
-    ldr w4, [x0, #28]   // v->pos
-    ldr w5, [x0, #24]   // v->len  
+    ldr w4, [x0, #FM_POS]   // v->pos
+    ldr w5, [x0, #FM_LEN]   // v->len  
     cmp w4, w5
     b.ge .fm_exit
     
     // Load parameters
-    ldr s16, [x0, #0]   // v->sr
-    ldr s17, [x0, #4]   // v->carrier_freq
-    ldr s18, [x0, #8]   // v->ratio
-    ldr s19, [x0, #12]  // v->index0
-    ldr s20, [x0, #16]  // v->amp
-    ldr s21, [x0, #20]  // v->decay
-    ldr s22, [x0, #32]  // v->carrier_phase
-    ldr s23, [x0, #36]  // v->mod_phase
+    ldr s16, [x0, #FM_SR]   // v->sr
+    ldr s17, [x0, #FM_CARRIER_FREQ]   // v->carrier_freq
+    ldr s18, [x0, #FM_RATIO]   // v->ratio
+    ldr s19, [x0, #FM_INDEX0]  // v->index0
+    ldr s20, [x0, #FM_AMP]  // v->amp
+    ldr s21, [x0, #FM_DECAY]  // v->decay
+    ldr s22, [x0, #FM_CARRIER_PHASE]  // v->carrier_phase
+    ldr s23, [x0, #FM_MOD_PHASE]  // v->mod_phase
     
     // Calculate increments: c_inc = TAU * carrier_freq / sr
     adrp x7, .L_tau@PAGE
@@ -52,8 +53,8 @@ _fm_voice_process:
     b.ge .fm_loop_end
     
     // Check if pos >= len
-    ldr w4, [x0, #28]      // v->pos
-    ldr w5, [x0, #24]      // v->len
+    ldr w4, [x0, #FM_POS]      // v->pos
+    ldr w5, [x0, #FM_LEN]      // v->len
     cmp w4, w5
     b.ge .fm_loop_end
     
@@ -223,14 +224,14 @@ _fm_voice_process:
     // Increment counters
     add w6, w6, #1         // i++
     add w4, w4, #1         // pos++
-    str w4, [x0, #28]      // store v->pos
+    str w4, [x0, #FM_POS]      // store v->pos
     
     b .fm_loop
 
 .fm_loop_end:
     // Store updated phases
-    str s22, [x0, #32]     // v->carrier_phase
-    str s23, [x0, #36]     // v->mod_phase
+    str s22, [x0, #FM_CARRIER_PHASE]     // v->carrier_phase
+    str s23, [x0, #FM_MOD_PHASE]     // v->mod_phase
 
 .fm_exit:
     ret
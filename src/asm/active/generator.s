@@ -1,3 +1,5 @@
+	.include "offsets.inc"   // struct offsets generated from the C headers
+
 	.text
 	.align 2
 	.globl _generator_mix_buffers_asm
@@ -38,13 +40,24 @@ _generator_process:
 	add x22, x22, #15
 	bic x22, x22, #15      // align to 16 bytes
 
-	// malloc(scratch_size)
-	mov x0, x22
-	bl _malloc
+	// Prefer the preallocated arena in generator_t (g->scratch,
+	// g->scratch_frames) so the realtime path never hits malloc
+	ldr w10, [x24, #G_OFF_SCRATCH_N]    // scratch_frames
+	cmp w10, w21
+	b.lo 1f                // arena too small (or none) -> heap fallback
+	ldr x25, [x24, #G_OFF_SCRATCH]    // x25 = g->scratch
+	cbnz x25, 2f
+1:
+	// buf_alloc(0, scratch_size, 0): cache-line aligned like the arena
+	mov x0, #0
+	mov x1, x22
+	mov w2, #0
+	bl _buf_alloc
 	mov x25, x0            // x25 = Ld base (scratch start)
 	
-	// TEMP: Check if malloc failed
-	cbz x25, .Lgp_epilogue  // if malloc returned NULL, exit immediately
+	// TEMP: Check if the allocation failed
+	cbz x25, .Lgp_epilogue  // if buf_alloc returned NULL, exit immediately
+2:
 
 	// bytes_per_buffer = num_frames * 4
 	lsl x5, x21, #2        // x5 = bytes per buffer
@@ -74,12 +87,11 @@ _generator_process:
 
 	// Register assignments:
 	//   x24 = g (generator*) – set now
-	// Use x10 as pointer to timing/event fields (base = g + 4352)
-	add x10, x24, #0x1000    // x10 = g + 4096
-	add x10, x10, #0x128     // +296 => g + 4392 (event_idx)
+	// Use x10 as pointer to timing/event fields (base = &g->event_idx)
+	add x10, x24, #G_OFF_EVENT_IDX   // x10 = &g->event_idx
 
-	ldr w9, [x24, #12]      // w9 = step_samples (offset 12 bytes)
-	ldr w8, [x10, #8]       // w8 = pos_in_step (event base + 8)
+	ldr w9, [x24, #G_OFF_STEP_SAMPLES]      // w9 = g->mt.step_samples
+	ldr w8, [x10, #(G_OFF_POS_IN_STEP - G_OFF_EVENT_IDX)]       // w8 = pos_in_step
 
 	// TOTAL_STEPS constant
 	mov w13, #32           // for wrap-around comparison
@@ -91,7 +103,7 @@ _generator_process:
 	mov w23, wzr            // frames_done = 0 (will live in w23/x23)
 
 .Lgp_loop:
-	ldr w9, [x24, #12]           // reload step_samples each iteration
+	ldr w9, [x24, #G_OFF_STEP_SAMPLES]           // reload step_samples each iteration
 	cbz w21, .Lgp_after_loop      // frames_rem == 0 ? done
 
 	// ----- DEBUG: dump counters at loop start -----
@@ -119,12 +131,11 @@ _generator_process:
 
 .Lgp_trigger_skip:
 	// Recompute event/state base pointer after external calls may clobber x10
-	add x10, x24, #0x1000
-	add x10, x10, #0x128    // x10 = &g->event_idx
-	ldr w9, [x24, #12]
+	add x10, x24, #G_OFF_EVENT_IDX   // x10 = &g->event_idx
+	ldr w9, [x24, #G_OFF_STEP_SAMPLES]
 
 	// Reload constant step_samples in case caller-saved w9 was clobbered
-	ldr w9, [x24, #12]           // w9 = step_samples (offset 12 bytes)
+	ldr w9, [x24, #G_OFF_STEP_SAMPLES]           // w9 = g->mt.step_samples
 	// frames_to_step_boundary = step_samples - pos_in_step
 	sub w10, w9, w8              // w10 = frames_to_step_boundary  (no slice-shortening)
 	// FM sustain fix: if pos_in_step == 0 and frames_to_step_boundary > 1, decrement by 1 so
@@ -161,54 +172,65 @@ _generator_process:
 	// Call voice processor (preserve x21 across call)
 	stp x21, x22, [sp, #96]     // save frames_rem & x22 inside fixed frame
 
-	// Replace C voice processing with ASM voice processing calls
-	
+	// Voice calls. Only voices flagged in g->active_voices (g+4464, GEN_VOICE_*
+	// bits) are entered. The voices use caller-saved temporaries (kick x9-x11,
+	// snare x13-x16), so every argument is rebuilt from callee-saved state:
+	// x23 = frames_done, w22 = frames_to_process, x25..x28 = scratch bases.
+
 	// Process kick into drum buffers (Ld/Rd)
-	add x0, x24, #56            // kick offset (from generator_t)
-	mov x1, x13                 // Ld
-	mov x2, x14                 // Rd
-	mov w3, w11                 // num_frames
+	ldr w9, [x24, #G_OFF_ACTIVE]          // g->active_voices
+	tbz w9, #0, 1f              // GEN_VOICE_KICK
+	add x0, x24, #G_OFF_KICK    // &g->kick
+	add x1, x25, x23, lsl #2    // Ld
+	add x2, x26, x23, lsl #2    // Rd
+	mov w3, w22                 // num_frames
 	bl _kick_process
-	
-	// Remove debug for now - focus on testing audio output
-	
+1:
 	// Process snare into drum buffers
-	add x0, x24, #96            // snare offset
-	mov x1, x13                 // Ld
-	mov x2, x14                 // Rd
-	mov w3, w11                 // num_frames
+	ldr w9, [x24, #G_OFF_ACTIVE]
+	tbz w9, #1, 1f              // GEN_VOICE_SNARE
+	add x0, x24, #G_OFF_SNARE   // &g->snare
+	add x1, x25, x23, lsl #2    // Ld
+	add x2, x26, x23, lsl #2    // Rd
+	mov w3, w22
 	bl _snare_process
-	
-	// Process melody into synth buffers (Ls/Rs)  
-	add x0, x24, #160           // melody offset
-	mov x1, x15                 // Ls
-	mov x2, x16                 // Rs
-	mov w3, w11                 // num_frames
+1:
+	// Process melody into synth buffers (Ls/Rs)
+	ldr w9, [x24, #G_OFF_ACTIVE]
+	tbz w9, #3, 1f              // GEN_VOICE_MELODY
+	add x0, x24, #G_OFF_MELODY  // &g->mel
+	add x1, x27, x23, lsl #2    // Ls
+	add x2, x28, x23, lsl #2    // Rs
+	mov w3, w22
 	bl _melody_process
-	
+1:
 	// Process FM voices into synth buffers
-	add x0, x24, #180           // mid_fm offset
-	mov x1, x15                 // Ls
-	mov x2, x16                 // Rs
-	mov w3, w11                 // num_frames
+	ldr w9, [x24, #G_OFF_ACTIVE]
+	tbz w9, #4, 1f              // GEN_VOICE_MID_FM
+	add x0, x24, #G_OFF_MID_FM  // &g->mid_fm
+	add x1, x27, x23, lsl #2    // Ls
+	add x2, x28, x23, lsl #2    // Rs
+	mov w3, w22
 	bl _fm_voice_process
-	
-	add x0, x24, #220           // bass_fm offset
-	mov x1, x15                 // Ls
-	mov x2, x16                 // Rs
-	mov w3, w11                 // num_frames
+1:
+	ldr w9, [x24, #G_OFF_ACTIVE]
+	tbz w9, #5, 1f              // GEN_VOICE_BASS_FM
+	add x0, x24, #G_OFF_BASS_FM // &g->bass_fm
+	add x1, x27, x23, lsl #2    // Ls
+	add x2, x28, x23, lsl #2    // Rs
+	mov w3, w22
 	bl _fm_voice_process
+1:
 
 	ldp x21, x22, [sp, #96]     // restore w21, x22 (sp unchanged)
 
 	// Recompute event/state base pointer after _generator_process_voices (x10 may be clobbered)
-	add x10, x24, #0x1000
-	add x10, x10, #0x128    // x10 = &g->event_idx
+	add x10, x24, #G_OFF_EVENT_IDX   // x10 = &g->event_idx
 
 	// Restore w11 from x22 after helper
 	mov w11, w22               // restore frames_to_process
 	// Reload pos_in_step since w8 is caller-clobbered
-	ldr w8, [x10, #8]
+	ldr w8, [x10, #(G_OFF_POS_IN_STEP - G_OFF_EVENT_IDX)]
 
     // ----- TRACE1: after voice processing -----
 .if 0
@@ -242,6 +264,13 @@ _generator_process:
 	// Just call the mixing function (debug later)
 	bl _generator_mix_buffers_asm
 
+	// The mixer uses x0-x8 and the voices x9: reload pos_in_step and
+	// step_samples before the counters are advanced below.
+	add x10, x24, #G_OFF_EVENT_IDX   // x10 = &g->event_idx
+	ldr w8, [x10, #(G_OFF_POS_IN_STEP - G_OFF_EVENT_IDX)]           // pos_in_step
+	ldr w9, [x24, #G_OFF_STEP_SAMPLES]          // step_samples
+	mov w13, #32                // TOTAL_STEPS (x13 is clobbered by snare)
+
 	// Re-enable debug check but only for first slice
 	.if 0
 		cbnz w23, .Lskip_output_check    // only when frames_done == 0
@@ -361,9 +390,8 @@ _generator_process:
 	// Advance counters
 	add w8, w8, w11              // pos_in_step += frames_to_process
     // write back updated pos_in_step to struct
-    add x10, x24, #0x1000
-    add x10, x10, #0x128   // correct base for event/state block (g + 4392)
-    str w8, [x10, #8]
+    add x10, x24, #G_OFF_EVENT_IDX   // x10 = &g->event_idx
+    str w8, [x10, #(G_OFF_POS_IN_STEP - G_OFF_EVENT_IDX)]
 	sub w21, w21, w11            // frames_rem  -= frames_to_process
 	add w23, w23, w11            // frames_done += frames_to_process
 
@@ -374,25 +402,30 @@ _generator_process:
 	// Boundary reached – reset pos_in_step and advance step
 	mov w8, wzr
 	// Recompute event/state base pointer again (x10 may be clobbered by helpers)
-	add x10, x24, #0x1000
-	add x10, x10, #0x128   // x10 = &g->event_idx
-	str w8, [x10, #8]       // write back pos_in_step = 0 to generator struct
-	ldr w12, [x10, #4]        // w12 = step (event base + 4)
+	add x10, x24, #G_OFF_EVENT_IDX   // x10 = &g->event_idx
+	str w8, [x10, #(G_OFF_POS_IN_STEP - G_OFF_EVENT_IDX)]       // write back pos_in_step = 0 to generator struct
+	ldr w12, [x10, #(G_OFF_STEP - G_OFF_EVENT_IDX)]        // w12 = step
 	add w12, w12, #1
 	cmp w12, w13
 	b.lt 3f
 	mov w12, wzr
-	str wzr, [x10]            // event_idx reset
-3:	str w12, [x10, #4]
+	// event_idx reset: the default arrangement (MAIN from event 0, looped)
+	// only; generator_arrange sections play on the C generator_process
+	str wzr, [x10]
+3:	str w12, [x10, #(G_OFF_STEP - G_OFF_EVENT_IDX)]
 	b .Lgp_loop
 
 .Lgp_after_loop:
 	// Store updated pos_in_step back
-	str w8, [x10, #8]
+	str w8, [x10, #(G_OFF_POS_IN_STEP - G_OFF_EVENT_IDX)]
 
-	// Deallocate scratch (free)
+	// Deallocate scratch (buf_free) unless it is the generator's own arena
+	ldr x9, [x24, #G_OFF_SCRATCH]     // g->scratch
+	cmp x9, x25
+	b.eq 1f
 	mov x0, x25
-	bl _free
+	bl _buf_free
+1:
 
 	// TEMP: Skip delay & limiter to test if they're clearing audio
 	b .Lgp_epilogue
@@ -406,9 +439,8 @@ _generator_process:
 	// Prepare arguments for delay_process_block
 	// x24 = g (preserved), x19 = L buffer, x20 = R buffer, w23 = total num_frames
 
-	// x0 = &g->delay  (offset 4408 bytes)
-	add x0, x24, #4096        // base offset
-	add x0, x0, #312          // 4096 + 312 = 4408
+	// x0 = &g->delay
+	add x0, x24, #G_OFF_DELAY
 	mov x1, x19               // L
 	mov x2, x20               // R
 	mov w3, w23               // n = num_frames
@@ -420,9 +452,8 @@ _generator_process:
 
     #ifndef SKIP_LIMITER
     // Prepare arguments for limiter_process
-    // x0 = &g->limiter (offset 4424 bytes)
-    add x0, x24, #4096        // base offset
-    add x0, x0, #328          // 4096 + 328 = 4424
+    // x0 = &g->limiter
+    add x0, x24, #G_OFF_LIMITER
     mov x1, x19               // L
     mov x2, x20               // R
     mov w3, w23               // n = num_frames
@@ -794,6 +825,8 @@ _generator_rotate_pattern_asm:
  *
  * Converts the event queue building loop from C to assembly for ultimate performance.
  * This is the final orchestration step - building the complete musical timeline.
+ * The store does not grow from here: eq_reserve(q, n) first, pushes past
+ * q->cap are dropped.
  *
  * Event generation rules:
  * - Drums: kick/snare/hat based on euclidean patterns
@@ -819,7 +852,7 @@ _generator_build_events_asm:
 	stp x27, x28, [sp, #64]
 	
 	// Initialize event queue: q->count = 0
-	str wzr, [x0, #4096]        // q->count = 0 (events array is 4096 bytes)
+	str wzr, [x0, #EQ_OFF_COUNT] // q->count = 0
 	
 	// Register assignments for loop
 	mov x19, x0                 // x19 = q (event queue)
@@ -959,25 +992,29 @@ _generator_build_events_asm:
 	.globl _generator_eq_push_helper_asm
 _generator_eq_push_helper_asm:
 	// Load current count
-	ldr w12, [x19, #4096]       // w12 = q->count
+	ldr w12, [x19, #EQ_OFF_COUNT] // w12 = q->count
 	
-	// Check if count < MAX_EVENTS (512)
-	cmp w12, #512
-	b.ge .Leq_push_ret          // Skip if queue full
+	// Check if count < cap (the caller eq_reserve()s: no growth from asm)
+	ldr w13, [x19, #EQ_OFF_CAP]
+	cmp w12, w13
+	b.hs .Leq_push_ret          // Skip if queue full
 	
 	// Calculate event address: &q->events[count]
-	mov w13, #8                 // sizeof(event_t) = 8 bytes
+	ldr x15, [x19, #EQ_OFF_EVENTS] // x15 = q->events
+	mov w13, #EV_SIZE            // sizeof(event_t)
 	mul w14, w12, w13           // w14 = count * sizeof(event_t)
-	add x15, x19, w14, uxtw     // x15 = &q->events[count]
+	add x15, x15, w14, uxtw     // x15 = &q->events[count]
 	
-	// Store event: {time, type, aux, padding}
-	str w6, [x15]               // event.time = time
-	strb w10, [x15, #4]         // event.type = type
-	strb w11, [x15, #5]         // event.aux = aux
+	// Store event: {time, type, aux, note, preset}
+	str w6, [x15, #EV_OFF_TIME]  // event.time = time
+	strb w10, [x15, #EV_OFF_TYPE] // event.type = type
+	strb w11, [x15, #EV_OFF_AUX]  // event.aux = aux
+	strb wzr, [x15, #EV_OFF_NOTE]   // note/preset: chosen by the C planner
+	strb wzr, [x15, #EV_OFF_PRESET]
 	
 	// Increment count
 	add w12, w12, #1
-	str w12, [x19, #4096]       // q->count++
+	str w12, [x19, #EQ_OFF_COUNT] // q->count++
 	
 .Leq_push_ret:
 	ret
@@ -17,12 +17,8 @@
 //   float    env_coef   @ 16
 //   rng_t    rng        @ 24 (state 64-bit)
 
-// --- Struct Offsets ---
-.equ H_POS,        0
-.equ H_LEN,        4
-.equ H_ENV,       12
-.equ H_ENV_COEF,  16
-.equ H_RNG_STATE, 24
+// --- Struct Offsets (H_*, generated from hat.h) ---
+	.include "offsets.inc"
 
 // --- Constants ---
 H_AMP_const:
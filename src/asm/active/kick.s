@@ -6,15 +6,8 @@
 AMP_const:
     .float 0.9            // overall amplitude (reduced from 1.2 - was too loud)
 
-// Offsets inside kick_t struct (see kick.h)
-.equ K_SR,         0     // float sr
-.equ K_POS,        4     // uint32 pos
-.equ K_LEN,        8     // uint32 len
-.equ K_ENV,        12    // float env
-.equ K_ENV_COEF,   16    // float env_coef
-.equ K_Y_PREV,     28    // float y_prev (sin(theta[n-1]))
-.equ K_Y_PREV2,    32    // float y_prev2 (sin(theta[n-2]))
-.equ K_K1,         36    // float k1 = 2*cos(delta)
+// kick_t offsets (K_*) are generated from kick.h
+	.include "offsets.inc"
 
 // void kick_process(kick_t *k, float *L, float *R, uint32_t n)
 // x0 = kick*, x1 = L*, x2 = R*, w3 = n
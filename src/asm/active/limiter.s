@@ -10,6 +10,7 @@
 	.text
 	.align 2
 	.globl _limiter_process
+	.include "offsets.inc"   // L_* offsets of limiter_t
 
 limiter_consts:
 	.float 20.0
@@ -35,11 +36,11 @@ _limiter_process:
 	mov w22, w3              // n
 	
 	// Load limiter parameters
-	ldr s0, [x19]            // attack_coeff
-	ldr s1, [x19, #4]        // release_coeff
-	ldr s2, [x19, #8]        // envelope
-	ldr s3, [x19, #12]       // threshold
-	ldr s4, [x19, #16]       // knee_width
+	ldr s0, [x19, #L_ATTACK]      // attack_coeff
+	ldr s1, [x19, #L_RELEASE]     // release_coeff
+	ldr s2, [x19, #L_ENVELOPE]    // envelope
+	ldr s3, [x19, #L_THRESHOLD]   // threshold
+	ldr s4, [x19, #L_KNEE]        // knee_width
 	
 	// Store parameters on stack for reloading after function calls
 	str s0, [sp, #48]        // attack_coeff
@@ -171,7 +172,7 @@ loop:
 Lstore_env:
 	// Store final envelope
 	ldr s2, [sp, #64]
-	str s2, [x19, #8]
+	str s2, [x19, #L_ENVELOPE]
 	
 	// Fallthrough
 	done:
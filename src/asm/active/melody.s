@@ -1,6 +1,7 @@
 	.text
 	.align 2
 	.globl _melody_process
+	.include "offsets.inc"   // M_* offsets of melody_t
 
 // Simplified melody implementation avoiding libm calls
 // Uses polynomial approximation for exponential decay
@@ -11,7 +12,7 @@ melody_constants:
     .float 2.0                        // [12] TWO
     .float 1.0                        // [16] ONE
     .float 1.2                        // [20] DRIVE_GAIN
-    .float 1.5                        // [24] SOFT_A
+    .float 0.0                        // [24] SOFT_A (see note below)
     .float 0.5                        // [28] SOFT_B
 
 _melody_process:
@@ -29,11 +30,11 @@ _melody_process:
     mov w22, w3      // n
 
     // Load melody struct members
-    ldr s0, [x19]        // phase
-    ldr w20, [x19, #4]   // pos
-    ldr w21, [x19, #8]   // len
-    ldr s1, [x19, #12]   // sr
-    ldr s2, [x19, #16]   // freq
+    ldr s0, [x19, #M_PHASE]   // phase
+    ldr w20, [x19, #M_POS]   // pos
+    ldr w21, [x19, #M_LEN]   // len
+    ldr s1, [x19, #M_SR]    // sr
+    ldr s2, [x19, #M_FREQ]  // freq
 
     // Early exit checks
     cmp w20, w21
@@ -84,7 +85,11 @@ Lloop:
     // Apply drive: driven = 1.2 * raw
     fmul s8, s15, s7     // driven
 
-    // Soft clipping: soft = 1.5*driven - 0.5*driven^3
+    // Soft clipping: soft = SOFT_A*driven - 0.5*driven^3
+    // SOFT_A used to be 1.5, but the negative-wrap check below zeroed s16
+    // after the first sample, so only the first sample of each call got the
+    // linear term and the output depended on how the caller sliced blocks.
+    // 0.0 keeps the shipped timbre and makes any block partition identical.
     fmul s9, s8, s8      // driven^2
     fmul s9, s9, s8      // driven^3
     fmul s18, s16, s8    // 1.5*driven
@@ -116,16 +121,15 @@ Lloop:
     b Lloop
 
 .check_negative_wrap:
-    fmov s16, wzr        // 0.0
-    fcmp s0, s16
+    fcmp s0, #0.0
     b.ge Lloop
     fadd s0, s0, s10     // phase += TAU if phase < 0
     b Lloop
 
 Lend:
     // Store back state
-    str s0, [x19]        // phase
-    str w20, [x19, #4]   // pos
+    str s0, [x19, #M_PHASE]   // phase
+    str w20, [x19, #M_POS]   // pos
 
 Ldone:
     // Epilogue
@@ -18,12 +18,8 @@
 //   <padding>           @ 20
 //   uint64_t rng.state  @ 24
 
-// --- Struct Offsets ---
-.equ S_POS,        0
-.equ S_LEN,        4
-.equ S_ENV,       12
-.equ S_ENV_COEF,  16
-.equ S_RNG_STATE, 24
+// --- Struct Offsets (S_*, generated from snare.h) ---
+	.include "offsets.inc"
 
 // --- Constants ---
 AMP_const:
@@ -183,170 +183,322 @@ ascii_font:
 // w3: character (char c)
 // w4: color (uint32_t)
 // w5: alpha (int, 0-255)
+//
+// The font already stores one byte per glyph row (MSB = leftmost column), so
+// each row expands to eight 32-bit lane masks with one cmtst and two widening
+// moves, and the row is written with two bsl-selected 4-pixel stores.  The
+// glyph is clipped once: rows against the bottom edge, and glyphs crossing
+// the right edge take a scalar path so no store leaves the scanline.
+// Leaf function: scratch lives in x9-x15 and v16-v21 only, which none of the
+// visual asm callers keep live across the call.
 //==============================================================================
 .global _draw_ascii_char_asm
 _draw_ascii_char_asm:
-    stp x29, x30, [sp, #-96]!
-    mov x29, sp
-    
-    // Save callee-saved registers with proper non-overlapping offsets
-    stp x19, x20, [sp, #16]    // 16-31
-    stp x21, x22, [sp, #32]    // 32-47  
-    stp x23, x24, [sp, #48]    // 48-63
-    stp x25, x26, [sp, #64]    // 64-79
-    stp x27, x28, [sp, #80]    // 80-95
-    
-    // Store parameters in callee-saved registers
-    mov x19, x0               // pixels buffer
-    mov w20, w1               // x position
-    mov w21, w2               // y position  
-    mov w22, w3               // character
-    mov w23, w4               // color
-    mov w24, w5               // alpha
-    
-    // Bounds check: character range 0-255 (now support full range)
-    cmp w22, #0
+    // Bounds check: character range 0-255
+    cmp w3, #0
     b.lt .Ldac_return         // if c < 0, return
-    cmp w22, #255
+    cmp w3, #255
     b.gt .Ldac_return         // if c > 255, return
     
-    // Bounds check: position within screen
-    cmp w20, #0
+    // Bounds check: glyph origin within screen
+    cmp w1, #0
     b.lt .Ldac_return
-    ldr w25, =800             // VIS_WIDTH
-    cmp w20, w25
+    cmp w1, #800              // VIS_WIDTH
     b.ge .Ldac_return
-    
-    cmp w21, #0
+    cmp w2, #0
     b.lt .Ldac_return
-    ldr w25, =600             // VIS_HEIGHT  
-    cmp w21, w25
+    cmp w2, #600              // VIS_HEIGHT
     b.ge .Ldac_return
     
-    // Get character bitmap from new 8x8 font
-    // Each character uses 2 uint32 values (64 bits)
-    // Font layout: char_index * 8 bytes = char_index * 2 words
-    lsl w25, w22, #3          // char_index * 8 (bytes per char)
-    adr x26, ascii_font       // Get font base address
-    add x26, x26, x25         // Point to character data
-    
-    // Load character bitmap (2 words = 8 bytes)
-    ldp w27, w28, [x26]       // w27 = first 4 bytes, w28 = last 4 bytes
-    
-    // OPTIMIZATION: Fast path for alpha==255 (90-95% of calls)
-    cmp w24, #255
-    b.eq .Ldac_alpha_opaque
+    // Glyph rows: char_index * 8 bytes, row 0 first
+    adr x9, ascii_font
+    add x9, x9, w3, uxtw #3
+    ldr x10, [x9]
+    cbz x10, .Ldac_return     // Blank glyph (space, most of the font): nothing to draw
     
-    // Alpha blending path for alpha < 255  
-    // Extract RGB components from color for alpha blending
-    ubfx w25, w23, #16, #8    // r = (color >> 16) & 0xFF
-    ubfx w26, w23, #8, #8     // g = (color >> 8) & 0xFF  
-    ubfx w27, w23, #0, #8     // b = color & 0xFF
+    // Fast path for alpha==255 (90-95% of calls)
+    orr w11, w4, #0xFF000000  // final color = color | 0xFF000000
+    cmp w5, #255
+    b.eq .Ldac_clip
     
     // Apply alpha: component = (component * alpha) / 255
-    mul w25, w25, w24         // r * alpha
-    mov w0, #255
-    udiv w25, w25, w0         // r = (r * alpha) / 255
-    
-    mul w26, w26, w24         // g * alpha  
-    udiv w26, w26, w0         // g = (g * alpha) / 255
-    
-    mul w27, w27, w24         // b * alpha
-    udiv w27, w27, w0         // b = (b * alpha) / 255
-    
-    // Reconstruct final color: 0xFF000000 | (r << 16) | (g << 8) | b
-    mov w28, #0xFF            
-    lsl w28, w28, #24         // Alpha = 0xFF000000
-    lsl w25, w25, #16         // r << 16
-    lsl w26, w26, #8          // g << 8
-    orr w28, w28, w25         // Add red
-    orr w28, w28, w26         // Add green  
-    orr w28, w28, w27         // Add blue - final color in w28
-    b .Ldac_render_bitmap
-    
-.Ldac_alpha_opaque:
-    // Fast path: alpha==255, use color directly  
-    orr w28, w23, #0xFF000000 // final color = color | 0xFF000000
-    
-.Ldac_render_bitmap:
-    
-    // Now render the 8x8 character
-    // Reload character bitmap
-    lsl w25, w22, #3          // char_index * 8
-    adr x26, ascii_font       // Get font base address
-    add x26, x26, x25
-    ldp w6, w7, [x26]         // w6 = rows 0-3, w7 = rows 4-7
-    
-    // Render each row of the 8x8 character
-    mov w0, #0                // row counter
+    // v / 255 == (v * 0x8081) >> 23 for every v <= 255 * 255, no udiv needed
+    mov w12, #0x8081
+    ubfx w13, w4, #16, #8     // r
+    mul w13, w13, w5
+    mul w13, w13, w12
+    lsr w13, w13, #23
+    ubfx w14, w4, #8, #8      // g
+    mul w14, w14, w5
+    mul w14, w14, w12
+    lsr w14, w14, #23
+    ubfx w15, w4, #0, #8      // b
+    mul w15, w15, w5
+    mul w15, w15, w12
+    lsr w15, w15, #23
+    mov w11, #0xFF000000      // 0xFF000000 | (r << 16) | (g << 8) | b
+    orr w11, w11, w13, lsl #16
+    orr w11, w11, w14, lsl #8
+    orr w11, w11, w15
+    
+.Ldac_clip:
+    // Rows on screen: min(8, VIS_HEIGHT - y)
+    mov w12, #600
+    sub w12, w12, w2
+    mov w13, #8
+    cmp w12, w13
+    csel w12, w12, w13, lt
+    
+    // Mark the tiles the glyph touches in the current dirty map (if any):
+    // at most two tile columns and two tile rows
+    adrp x14, _vis_dirty_tiles@PAGE
+    ldr x14, [x14, _vis_dirty_tiles@PAGEOFF]
+    cbz x14, .Ldac_marked
+    mov w3, #1
+    lsr w4, w1, #5            // first tile column
+    lsl w10, w3, w4
+    add w4, w1, #7
+    mov w5, #799
+    cmp w4, w5
+    csel w4, w4, w5, lt       // last column on screen
+    lsr w4, w4, #5            // last tile column
+    lsl w4, w3, w4
+    orr w10, w10, w4
+    lsr w4, w2, #5            // first tile row
+    ldr w5, [x14, w4, uxtw #2]
+    orr w5, w5, w10
+    str w5, [x14, w4, uxtw #2]
+    add w4, w2, w12
+    sub w4, w4, #1
+    lsr w4, w4, #5            // last tile row
+    ldr w5, [x14, w4, uxtw #2]
+    orr w5, w5, w10
+    str w5, [x14, w4, uxtw #2]
+    
+.Ldac_marked:
+    // x13 = &pixels[y * 800 + x]
+    mov w13, #800
+    madd w13, w2, w13, w1
+    add x13, x0, w13, uxtw #2
+    
+    cmp w1, #792              // Glyph crosses the right edge?
+    b.gt .Ldac_clipped
+    
+    dup v16.4s, w11           // color in every lane
+    adr x14, .Ldac_column_bits
+    ldr d17, [x14]            // 0x80, 0x40, ... 0x01: bit of each column
+    
 .Ldac_row_loop:
-    cmp w0, #8
-    b.ge .Ldac_return
+    ldrb w14, [x9], #1        // row bitmap byte
+    cbz w14, .Ldac_next_row
     
-    // Get row data - need to extract correct byte from w6 or w7
-    cmp w0, #4
-    b.ge .Ldac_upper_rows
+    dup v18.8b, w14
+    cmtst v18.8b, v18.8b, v17.8b  // 0xFF for every lit column
+    sxtl v18.8h, v18.8b
+    sxtl2 v19.4s, v18.8h      // columns 4-7
+    sxtl v18.4s, v18.4h       // columns 0-3
     
-    // Lower rows (0-3): extract from w6
-    lsl w2, w0, #3            // row * 8
-    lsr w1, w6, w2            // shift by row*8 bits
-    and w1, w1, #0xFF         // mask to get byte
-    b .Ldac_process_row
+    ld1 {v20.4s, v21.4s}, [x13]
+    bsl v18.16b, v16.16b, v20.16b // lit ? color : pixel
+    bsl v19.16b, v16.16b, v21.16b
+    st1 {v18.4s, v19.4s}, [x13]
     
-.Ldac_upper_rows:
-    // Upper rows (4-7): extract from w7  
-    sub w2, w0, #4            // row - 4
-    lsl w2, w2, #3            // (row-4) * 8
-    lsr w1, w7, w2            // shift by (row-4)*8 bits
-    and w1, w1, #0xFF         // mask to get byte
+.Ldac_next_row:
+    add x13, x13, #3200       // next scanline (800 * 4 bytes)
+    subs w12, w12, #1
+    b.ne .Ldac_row_loop
+    ret
     
-.Ldac_process_row:
-    // w1 now contains the row bitmap byte
-    mov w2, #0                // column counter
+.Ldac_clipped:
+    // Right-edge glyph: only the VIS_WIDTH - x columns still on screen
+    mov w15, #800
+    sub w15, w15, w1
     
-.Ldac_col_loop:
-    cmp w2, #8
-    b.ge .Ldac_next_row
+.Ldac_clip_row:
+    ldrb w14, [x9], #1        // row bitmap byte
+    mov w10, #0               // column
     
-    // Check if pixel should be drawn
+.Ldac_clip_col:
     mov w3, #7
-    sub w3, w3, w2            // bit position (7-col for MSB first)
-    lsr w4, w1, w3            // shift pixel bit to position 0
-    and w4, w4, #1            // mask to get single bit
-    
-    cbz w4, .Ldac_next_col    // skip if pixel is 0
-    
-    // Calculate pixel position
-    add w5, w20, w2           // pixel_x = char_x + col
-    add w6, w21, w0           // pixel_y = char_y + row
-    
-    // OPTIMIZATION: Skip redundant per-pixel bounds checks
-    // Caller already guarantees character is fully on-screen
+    sub w3, w3, w10           // bit position (7-col for MSB first)
+    lsr w4, w14, w3
+    tbz w4, #0, .Ldac_clip_next
+    str w11, [x13, w10, uxtw #2]
     
-    // Calculate pixel offset: y * width + x
-    ldr w25, =800             // width
-    mul w6, w6, w25           // y * width
-    add w6, w6, w5            // + x
-    lsl w6, w6, #2            // * 4 (bytes per pixel)
+.Ldac_clip_next:
+    add w10, w10, #1
+    cmp w10, w15
+    b.lt .Ldac_clip_col
     
-    // Set pixel
-    str w28, [x19, x6]        // pixels[offset] = color
-    
-.Ldac_next_col:
-    add w2, w2, #1
-    b .Ldac_col_loop
-    
-.Ldac_next_row:
-    add w0, w0, #1
-    b .Ldac_row_loop
+    add x13, x13, #3200
+    subs w12, w12, #1
+    b.ne .Ldac_clip_row
     
 .Ldac_return:
-    // Restore callee-saved registers  
-    ldp x27, x28, [sp, #80]
-    ldp x25, x26, [sp, #64]
-    ldp x23, x24, [sp, #48]
-    ldp x21, x22, [sp, #32]
-    ldp x19, x20, [sp, #16]
-    
-    ldp x29, x30, [sp], #96
     ret
+
+//==============================================================================
+// void draw_ascii_run_asm(uint32_t *pixels, int x, int y, const char *s, int n, uint32_t color)
+//
+// Draw n glyphs of s side by side (8 px apart) on one text row, opaque.
+// Same per-glyph rules as draw_ascii_char_asm (origin on screen, c >= 0),
+// but the row is clipped once and the color, masks and scanline address are
+// set up once per run instead of once per glyph.
+// x0: pixels buffer
+// w1: x position of s[0]
+// w2: y position
+// x3: glyph string (need not be NUL terminated)
+// w4: glyph count
+// w5: color (uint32_t)
+//==============================================================================
+.global _draw_ascii_run_asm
+_draw_ascii_run_asm:
+    // Clip the whole run vertically
+    cmp w4, #0
+    b.le .Ldar_return
+    cmp w2, #0
+    b.lt .Ldar_return
+    cmp w2, #600              // VIS_HEIGHT
+    b.ge .Ldar_return
+    
+    // Rows on screen: min(8, VIS_HEIGHT - y)
+    mov w12, #600
+    sub w12, w12, w2
+    mov w13, #8
+    cmp w12, w13
+    csel w12, w12, w13, lt
+    
+    // Mark the tile columns the run spans in the current dirty map (if any)
+    adrp x14, _vis_dirty_tiles@PAGE
+    ldr x14, [x14, _vis_dirty_tiles@PAGEOFF]
+    cbz x14, .Ldar_marked
+    add w9, w1, w4, lsl #3
+    sub w9, w9, #1            // last pixel column of the run
+    mov w10, #799
+    cmp w9, w10
+    csel w9, w9, w10, lt
+    cmp w1, #0
+    csel w10, w1, wzr, gt     // first pixel column on screen
+    cmp w10, w9
+    b.gt .Ldar_return         // Run is entirely off screen
+    lsr w9, w9, #5
+    lsr w10, w10, #5
+    mov w13, #2
+    lsl w13, w13, w9
+    sub w13, w13, #1          // tiles 0..last
+    mov w15, #1
+    lsl w15, w15, w10
+    sub w15, w15, #1          // tiles 0..first-1
+    bic w13, w13, w15
+    lsr w9, w2, #5            // first tile row
+    ldr w10, [x14, w9, uxtw #2]
+    orr w10, w10, w13
+    str w10, [x14, w9, uxtw #2]
+    add w9, w2, w12
+    sub w9, w9, #1
+    lsr w9, w9, #5            // last tile row
+    ldr w10, [x14, w9, uxtw #2]
+    orr w10, w10, w13
+    str w10, [x14, w9, uxtw #2]
+    
+.Ldar_marked:
+    // x7 = &pixels[y * 800], start of the scanline
+    mov w13, #800
+    mul w13, w2, w13
+    add x7, x0, w13, uxtw #2
+    
+    orr w11, w5, #0xFF000000  // opaque color
+    dup v16.4s, w11
+    adr x14, .Ldac_column_bits
+    ldr d17, [x14]
+    adr x8, ascii_font
+    mov w6, w1                // glyph x
+    
+.Ldar_glyph_loop:
+    cmp w6, #800
+    b.ge .Ldar_return         // Rest of the run is past the right edge
+    
+    ldrsb w9, [x3], #1        // c = *s++
+    tbnz w9, #31, .Ldar_next_glyph // c < 0
+    cmp w6, #0
+    b.lt .Ldar_next_glyph     // Origin left of the screen
+    
+    add x9, x8, w9, uxtw #3   // glyph rows
+    ldr x10, [x9]
+    cbz x10, .Ldar_next_glyph // Blank glyph
+    
+    add x13, x7, w6, uxtw #2  // &pixels[y * 800 + x]
+    mov w15, w12              // rows left
+    cmp w6, #792
+    b.gt .Ldar_clipped
+    
+.Ldar_row_loop:
+    ldrb w14, [x9], #1        // row bitmap byte
+    cbz w14, .Ldar_next_row
+    
+    dup v18.8b, w14
+    cmtst v18.8b, v18.8b, v17.8b  // 0xFF for every lit column
+    sxtl v18.8h, v18.8b
+    sxtl2 v19.4s, v18.8h
+    sxtl v18.4s, v18.4h
+    
+    ld1 {v20.4s, v21.4s}, [x13]
+    bsl v18.16b, v16.16b, v20.16b
+    bsl v19.16b, v16.16b, v21.16b
+    st1 {v18.4s, v19.4s}, [x13]
+    
+.Ldar_next_row:
+    add x13, x13, #3200
+    subs w15, w15, #1
+    b.ne .Ldar_row_loop
+    
+.Ldar_next_glyph:
+    add w6, w6, #8
+    subs w4, w4, #1
+    b.ne .Ldar_glyph_loop
+    
+.Ldar_return:
+    ret
+    
+.Ldar_clipped:
+    // Glyph crossing the right edge: the last one the run can draw
+    mov w5, #800
+    sub w5, w5, w6            // columns still on screen
+    
+.Ldar_clip_row:
+    ldrb w14, [x9], #1
+    mov w10, #0
+    
+.Ldar_clip_col:
+    mov w1, #7
+    sub w1, w1, w10           // bit position (7-col for MSB first)
+    lsr w2, w14, w1
+    tbz w2, #0, .Ldar_clip_next
+    str w11, [x13, w10, uxtw #2]
+    
+.Ldar_clip_next:
+    add w10, w10, #1
+    cmp w10, w5
+    b.lt .Ldar_clip_col
+    
+    add x13, x13, #3200
+    subs w15, w15, #1
+    b.ne .Ldar_clip_row
+    ret
+
+.align 3
+.Ldac_column_bits:
+    .byte 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01
+
+//==============================================================================
+// uint32_t *vis_dirty_tiles
+//
+// Dirty-tile map of the frame being drawn (frame_tiles_t rows, see
+// src/include/frame_writer.h), or NULL when nobody tracks tiles.  Set by the
+// frame loop before each frame.
+//==============================================================================
+.section __DATA,__data
+.align 3
+.global _vis_dirty_tiles
+_vis_dirty_tiles:
+    .quad 0
@@ -22,6 +22,10 @@
 // - rot_speed: 4 bytes (float)
 // - active: 4 bytes (bool padded to 4)
 // Total: 32 bytes per bass_hit_t
+// Module state [_vis_bass_hits_state, _vis_bass_hits_state_end): swapped per render context by src/vis_ctx.c
+.global _vis_bass_hits_state
+.global _vis_bass_hits_state_end
+_vis_bass_hits_state:
 bass_hits_array:
     .space (16 * 32), 0     // MAX_BASS_HITS * sizeof(bass_hit_t)
 
@@ -30,9 +34,13 @@ bass_hits_initialized:
 
 last_bass_step:
     .space 4, 0             // int
+_vis_bass_hits_state_end:
 
 // OPTIMIZATION: Trig lookup tables (256 entries each, 1KB total)
-// sin/cos values for angles 0 to 2π with linear interpolation
+// sin/cos values for angles 0 to 2π with linear interpolation.  Kept out of
+// __DATA: the state above is rewritten on every context swap, and a table on
+// the same page would be copied into each render process with it.
+.section __TEXT,__const
 .align 4
 sin_lut:
     .float 0.000000, 0.024541, 0.049068, 0.073565, 0.098017, 0.122411, 0.146730, 0.170962
@@ -392,1010 +400,285 @@ _cos_lut_asm:
 .Lconst_0_6:
     .float 0.6
 
-// Draw ASCII hexagon
-// void draw_ascii_hexagon(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame)
-// Input: x0=pixels, w1=cx, w2=cy, w3=size, s0=rotation, w4=color, w5=alpha, w6=frame
-.global _draw_ascii_hexagon_asm
-_draw_ascii_hexagon_asm:
-    stp x29, x30, [sp, #-112]!
-    mov x29, sp
-    stp x19, x20, [sp, #16]
-    stp x21, x22, [sp, #32]
-    stp x23, x24, [sp, #48]
-    stp x25, x26, [sp, #64]
-    stp x27, x28, [sp, #80]
-    
-    // Check size threshold
+// Shape outlines
+// Every bass-hit and boss shape is a closed polygon described by a table:
+//   +0   byte       vertex count (at most POLY_MAX_VERTS)
+//   +1   byte       edge glyph, 0 for shapes drawn as vertices only
+//   +4   12 bytes   base glyph of each vertex
+//   +16  float[2]   unrotated vertex offsets, in units of `size`
+// The rotation costs one LUT lookup per shape, not one sin and one cos
+// per vertex, and edges are stepped in integers.
+.equ POLY_COUNT, 0
+.equ POLY_EDGE_CHAR, 1
+.equ POLY_CHARS, 4
+.equ POLY_VERTS, 16
+.equ POLY_MAX_VERTS, 10
+
+// Frame: saved registers, then vertices[POLY_MAX_VERTS][2], edge start and
+// delta, and the cell being drawn
+.equ POLY_SP_VERTS, 112
+.equ POLY_SP_EDGE, 192
+.equ POLY_SP_CELL, 208
+.equ POLY_FRAME, 224
+
+// Draw a polygon outline of ASCII glyphs
+// void draw_ascii_polygon(uint32_t *pixels, int cx, int cy, int size, float rotation,
+//                         uint32_t color, int alpha, int frame, const void *shape)
+// Input: x0=pixels, w1=cx, w2=cy, w3=size, s0=rotation, w4=color, w5=alpha, w6=frame, x7=shape table
+// Each vertex gets its glyph at `alpha`.  Each edge then gets the edge glyph
+// at max(alpha - 50, 0) every 1/steps of the way, steps = (|dx| + |dy|) / 12,
+// endpoints excluded.
+.global _draw_ascii_polygon_asm
+_draw_ascii_polygon_asm:
     cmp w3, #8
-    b.lt .Lhex_done         // return if size < 8
-    
-    // Save all parameters to dedicated registers (no more w1-w6 reuse)
-    mov x19, x0             // pixels pointer  
-    mov w20, w1             // cx
-    mov w21, w2             // cy  
-    mov w22, w3             // size
-    str s0, [sp, #96]       // rotation (on stack)
-    mov w23, w4             // color
-    mov w24, w5             // alpha
-    mov w25, w6             // frame
-    
-    // Loop counter in dedicated register
-    mov w26, #0             // i = 0 (dedicated loop counter)
-    
-    // for (int i = 0; i < 6; i++)
-.Lhex_loop:
-    cmp w26, #6
-    b.ge .Lhex_done
-    
-    // float angle = rotation + i * M_PI / 3.0f
-    scvtf s1, w26           // Convert i to float
-    adr x0, .Lconst_pi_3    // M_PI / 3.0f ≈ 1.047198
-    ldr s2, [x0]
-    fmul s1, s1, s2         // i * (M_PI / 3.0f)
-    ldr s0, [sp, #96]       // Load rotation
-    fadd s0, s0, s1         // angle = rotation + i * (M_PI / 3.0f)
-    
-    // int x = cx + (int)(cosf(angle) * size * 0.7f)  
-    // OPTIMIZATION: Use lookup table instead of libm cosf
-    bl _cos_lut_asm         // s0 = cos(angle) from LUT
-    scvtf s1, w22           // Convert size to float
-    fmul s0, s0, s1         // cos(angle) * size
-    adr x0, .Lconst_0_7     
-    ldr s1, [x0]            // 0.7f
-    fmul s0, s0, s1         // cos(angle) * size * 0.7f
-    fcvtns w27, s0          // Convert to int, store in w27
-    add w27, w20, w27       // x = cx + result
-    
-    // int y = cy + (int)(sinf(angle) * size * 0.7f)  
-    // Recalculate angle since cosf modified s0
-    scvtf s1, w26           // Convert i to float
-    adr x0, .Lconst_pi_3    
-    ldr s2, [x0]
-    fmul s1, s1, s2         // i * (M_PI / 3.0f)
-    ldr s0, [sp, #96]       // Load rotation
-    fadd s0, s0, s1         // angle = rotation + i * (M_PI / 3.0f)
-    
-    // OPTIMIZATION: Use lookup table instead of libm sinf
-    bl _sin_lut_asm         // s0 = sin(angle) from LUT
-    scvtf s1, w22           // Convert size to float
-    fmul s0, s0, s1         // sin(angle) * size
-    adr x0, .Lconst_0_7
-    ldr s1, [x0]            // 0.7f
-    fmul s0, s0, s1         // sin(angle) * size * 0.7f
-    fcvtns w28, s0          // Convert to int, store in w28
-    add w28, w21, w28       // y = cy + result
-    
-    // char base_char = hex_chars[i % char_count]
-    mov w0, #6              // char_count = 6
-    udiv w1, w26, w0        // w1 = i / 6
-    msub w0, w1, w0, w26    // w0 = i % 6
-    adr x1, .Lhex_chars
-    ldrb w0, [x1, w0, uxtw] // Load hex_chars[i % 6]
-    
-    // char glitched_char = get_glitched_shape_char(base_char, x, y, frame)
-    // w0 already has base_char
-    mov w1, w27             // x  
-    mov w2, w28             // y
-    mov w3, w25             // frame
-    bl _get_glitched_shape_char
-    // Result in w0 = glitched_char
-    
-    // draw_ascii_char(pixels, x, y, glitched_char, color, alpha)
-    // w0 already has glitched_char, need to set up all parameters
-    mov w3, w0              // glitched_char
-    mov x0, x19             // pixels
-    mov w1, w27             // x
-    mov w2, w28             // y
-    mov w4, w23             // color
-    mov w5, w24             // alpha
-    bl _draw_ascii_char_asm
-    
-    // Increment loop counter
-    add w26, w26, #1        // i++
-    b .Lhex_loop
-    
-.Lhex_done:
-    ldp x27, x28, [sp, #80]
-    ldp x25, x26, [sp, #64]
-    ldp x23, x24, [sp, #48]
-    ldp x21, x22, [sp, #32]
-    ldp x19, x20, [sp, #16]
-    ldp x29, x30, [sp], #112
-    ret
+    b.lt .Lpoly_ret         // return if size < 8
 
-// Draw ASCII square  
-// void draw_ascii_square(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame)
-// Input: x0=pixels, w1=cx, w2=cy, w3=size, s0=rotation, w4=color, w5=alpha, w6=frame
-.global _draw_ascii_square_asm
-_draw_ascii_square_asm:
-    stp x29, x30, [sp, #-160]!
+    stp x29, x30, [sp, #-POLY_FRAME]!
     mov x29, sp
     stp x19, x20, [sp, #16]
     stp x21, x22, [sp, #32]
     stp x23, x24, [sp, #48]
     stp x25, x26, [sp, #64]
     stp x27, x28, [sp, #80]
-    
-    // Check size threshold
-    cmp w3, #8
-    b.lt .Lsquare_done      // return if size < 8
-    
-    // Save all parameters to dedicated registers
-    mov x19, x0             // pixels pointer  
+    stp d8, d9, [sp, #96]
+
+    mov x19, x0             // pixels
     mov w20, w1             // cx
-    mov w21, w2             // cy  
-    mov w22, w3             // size (half)
-    str s0, [sp, #96]       // rotation (on stack)
+    mov w21, w2             // cy
     mov w23, w4             // color
     mov w24, w5             // alpha
     mov w25, w6             // frame
-    
-    // Calculate initial corners (before rotation)
-    // corners[4][2] = {{cx-half, cy-half}, {cx+half, cy-half}, {cx+half, cy+half}, {cx-half, cy+half}}
-    sub w0, w20, w22        // cx - half
-    sub w1, w21, w22        // cy - half
-    stp w0, w1, [sp, #104]  // Store corner 0: top-left
-    
-    add w0, w20, w22        // cx + half  
-    sub w1, w21, w22        // cy - half
-    stp w0, w1, [sp, #112]  // Store corner 1: top-right
-    
-    add w0, w20, w22        // cx + half
-    add w1, w21, w22        // cy + half  
-    stp w0, w1, [sp, #120]  // Store corner 2: bottom-right
-    
-    sub w0, w20, w22        // cx - half
-    add w1, w21, w22        // cy + half
-    stp w0, w1, [sp, #128]  // Store corner 3: bottom-left
-    
-    // Apply rotation to corners and draw them
-    mov w26, #0             // i = 0 (corner index)
-    
-.Lsquare_corner_loop:
-    cmp w26, #4
-    b.ge .Lsquare_edges     // Done with corners, now draw edges
-    
-    // Load corner coordinates
-    mov w0, #8              // 8 bytes per corner (2 ints)
-    mul w0, w26, w0         // i * 8
-    add w0, w0, #104        // offset to corners array
-    add x1, sp, w0, uxtw    // address of corners[i]
-    ldp w27, w28, [x1]      // Load corners[i][0], corners[i][1]
-    
-    // Calculate dx = corners[i][0] - cx, dy = corners[i][1] - cy
-    sub w0, w27, w20        // dx = corners[i][0] - cx
-    sub w1, w28, w21        // dy = corners[i][1] - cy
-    scvtf s0, w0            // dx as float
-    scvtf s1, w1            // dy as float
-    
-    // Rotate: rotated_x = dx * cos(rotation) - dy * sin(rotation)
-    //         rotated_y = dx * sin(rotation) + dy * cos(rotation)
-    ldr s2, [sp, #96]       // Load rotation
-    
-    // Calculate cos(rotation)
-    fmov s3, s2             // Copy rotation for cos call
-    bl _cos_lut_asm         // s0 = cos(rotation) from LUT
-    fmov s4, s0             // Save cos result in s4
-    
-    // Calculate sin(rotation)  
-    ldr s2, [sp, #96]       // Reload rotation
-    fmov s0, s2             // Set up for sin call
-    bl _sin_lut_asm         // s0 = sin(rotation) from LUT
-    fmov s5, s0             // Save sin result in s5
-    
-    // Now compute rotated coordinates
-    // rotated_x = dx * cos(rotation) - dy * sin(rotation)
-    fmul s6, s0, s4         // dx * cos(rotation)  -- wait, s0 is sin result, need to reload dx
-    // Let me reload dx, dy
-    sub w0, w27, w20        // dx = corners[i][0] - cx
-    sub w1, w28, w21        // dy = corners[i][1] - cy  
-    scvtf s0, w0            // dx as float
-    scvtf s1, w1            // dy as float
-    
-    fmul s6, s0, s4         // dx * cos(rotation)
-    fmul s7, s1, s5         // dy * sin(rotation)
-    fsub s6, s6, s7         // rotated_x = dx * cos - dy * sin
-    
-    // rotated_y = dx * sin(rotation) + dy * cos(rotation)
-    fmul s7, s0, s5         // dx * sin(rotation)
-    fmul s8, s1, s4         // dy * cos(rotation)
-    fadd s7, s7, s8         // rotated_y = dx * sin + dy * cos
-    
-    // Convert back to integers and add center
-    fcvtns w0, s6           // rotated_x as int
-    fcvtns w1, s7           // rotated_y as int
-    add w27, w20, w0        // final_x = cx + rotated_x
-    add w28, w21, w1        // final_y = cy + rotated_y
-    
-    // Store rotated corner back
-    mov w0, #8              // 8 bytes per corner
-    mul w0, w26, w0         // i * 8
-    add w0, w0, #104        // offset to corners array
-    add x1, sp, w0, uxtw    // address of corners[i]
-    stp w27, w28, [x1]      // Store rotated coordinates
-    
-    // Get character: base_char = square_chars[i % char_count]
-    mov w0, #6              // char_count = 6
-    udiv w1, w26, w0        // w1 = i / 6
-    msub w0, w1, w0, w26    // w0 = i % 6
-    adr x1, .Lsquare_chars
-    ldrb w0, [x1, w0, uxtw] // Load square_chars[i % 6]
-    
-    // char glitched_char = get_glitched_shape_char(base_char, x, y, frame)
-    // w0 already has base_char
-    mov w1, w27             // x  
-    mov w2, w28             // y
-    mov w3, w25             // frame
+    mov x26, x7             // shape table
+    ldrb w22, [x26, #POLY_COUNT]
+
+    // LUT index of the rotation, as in _sin_lut_asm / _cos_lut_asm
+    adr x9, .Lconst_2pi_inv
+    ldr s1, [x9]
+    fmul s1, s0, s1         // rotation / (2π)
+    adr x9, .Lconst_256
+    ldr s2, [x9]
+    fmul s1, s1, s2         // * 256
+    fcvtms w9, s1
+    and w9, w9, #255
+    adrp x10, sin_lut@PAGE
+    add x10, x10, sin_lut@PAGEOFF
+    ldr s4, [x10, w9, uxtw #2]
+    adrp x10, cos_lut@PAGE
+    add x10, x10, cos_lut@PAGEOFF
+    ldr s5, [x10, w9, uxtw #2]
+    scvtf s6, w3
+    fmul s8, s5, s6         // size * cos(rotation)
+    fmul s9, s4, s6         // size * sin(rotation)
+
+    // Vertices: rotate, place, draw
+    mov w27, #0             // i
+.Lpoly_vertex_loop:
+    cmp w27, w22
+    b.ge .Lpoly_edges
+
+    add x9, x26, #POLY_VERTS
+    add x9, x9, w27, uxtw #3
+    ldp s0, s1, [x9]        // (vx, vy)
+    fmul s2, s0, s8
+    fmsub s2, s1, s9, s2    // vx * size*cos - vy * size*sin
+    fmul s3, s0, s9
+    fmadd s3, s1, s8, s3    // vx * size*sin + vy * size*cos
+    fcvtns w1, s2
+    fcvtns w2, s3
+    add w1, w20, w1         // x = cx + rotated x
+    add w2, w21, w2         // y = cy + rotated y
+    add x9, sp, #POLY_SP_VERTS
+    add x9, x9, w27, uxtw #3
+    stp w1, w2, [x9]        // vertices[i]
+
+    // draw_ascii_char(pixels, x, y, get_glitched_shape_char(chars[i], x, y, frame), color, alpha)
+    add x9, x26, #POLY_CHARS
+    ldrb w0, [x9, w27, uxtw]
+    mov w3, w25
     bl _get_glitched_shape_char
-    // Result in w0 = glitched_char
-    
-    // draw_ascii_char(pixels, x, y, glitched_char, color, alpha)
-    mov w3, w0              // glitched_char
-    mov x0, x19             // pixels
-    mov w1, w27             // x
-    mov w2, w28             // y
-    mov w4, w23             // color
-    mov w5, w24             // alpha
+    mov w3, w0
+    add x9, sp, #POLY_SP_VERTS
+    add x9, x9, w27, uxtw #3
+    ldp w1, w2, [x9]
+    mov x0, x19
+    mov w4, w23
+    mov w5, w24
     bl _draw_ascii_char_asm
-    
-    // Increment corner index
-    add w26, w26, #1        // i++
-    b .Lsquare_corner_loop
-    
-.Lsquare_edges:
-    // Draw square edges connecting corners
-    mov w26, #0             // i = 0 (edge index)
-    
-.Lsquare_edge_loop:
-    cmp w26, #4
-    b.ge .Lsquare_done      // Done with all edges
-    
-    // Calculate next corner index: next = (i + 1) % 4
-    add w0, w26, #1         // i + 1
-    mov w1, #4              // 4 corners
-    udiv w2, w0, w1         // (i + 1) / 4
-    msub w27, w2, w1, w0    // next = (i + 1) % 4
-    
-    // Load current corner coordinates
-    mov w0, #8              // 8 bytes per corner
-    mul w0, w26, w0         // i * 8
-    add w0, w0, #104        // offset to corners array
-    add x1, sp, w0, uxtw    // address of corners[i]
-    ldp w1, w2, [x1]        // Load corners[i][0], corners[i][1]
-    
-    // Load next corner coordinates  
-    mov w0, #8              // 8 bytes per corner
-    mul w0, w27, w0         // next * 8
-    add w0, w0, #104        // offset to corners array
-    add x3, sp, w0, uxtw    // address of corners[next]
-    ldp w3, w4, [x3]        // Load corners[next][0], corners[next][1]
-    
-    // Calculate steps = (abs(next_x - curr_x) + abs(next_y - curr_y)) / 12
-    sub w5, w3, w1          // next_x - curr_x
-    cmp w5, #0
-    cneg w5, w5, mi         // abs(next_x - curr_x)
-    
-    sub w6, w4, w2          // next_y - curr_y  
-    cmp w6, #0
-    cneg w6, w6, mi         // abs(next_y - curr_y)
-    
-    add w5, w5, w6          // sum of distances
+
+    add w27, w27, #1
+    b .Lpoly_vertex_loop
+
+.Lpoly_edges:
+    ldrb w26, [x26, #POLY_EDGE_CHAR]
+    cbz w26, .Lpoly_done
+    subs w24, w24, #50
+    csel w24, w24, wzr, gt  // edge alpha = max(alpha - 50, 0)
+
+    mov w20, #0             // edge i: vertices[i] -> vertices[(i + 1) % count]
+.Lpoly_edge_loop:
+    cmp w20, w22
+    b.ge .Lpoly_done
+
+    add w9, w20, #1
+    cmp w9, w22
+    csel w9, w9, wzr, lt
+    add x10, sp, #POLY_SP_VERTS
+    add x11, x10, w20, uxtw #3
+    add x12, x10, w9, uxtw #3
+    ldp w1, w2, [x11]
+    ldp w3, w4, [x12]
+    sub w3, w3, w1          // dx
+    sub w4, w4, w2          // dy
+    stp w1, w2, [sp, #POLY_SP_EDGE]
+    stp w3, w4, [sp, #POLY_SP_EDGE + 8]
+    cmp w3, #0
+    cneg w5, w3, mi
+    cmp w4, #0
+    cneg w6, w4, mi
+    add w5, w5, w6
     mov w6, #12
-    udiv w28, w5, w6        // steps = distance / 12
-    
-    // Save corner coordinates for edge drawing
-    str w1, [sp, #136]      // curr_x
-    str w2, [sp, #140]      // curr_y (4-byte aligned)  
-    str w3, [sp, #144]      // next_x
-    str w4, [sp, #148]      // next_y
-    
-    // Draw line between corners
-    mov w27, #1             // step = 1 (start from 1, not 0)
-    
-.Lsquare_line_loop:
-    cmp w27, w28            // step < steps?
-    b.ge .Lsquare_next_edge
-    
-    // Calculate t = (float)step / steps
-    scvtf s0, w27           // step as float
-    scvtf s1, w28           // steps as float
-    fdiv s2, s0, s1         // t = step / steps
-    
-    // Calculate line coordinates
-    // line_x = curr_x + (int)(t * (next_x - curr_x))
-    ldr w0, [sp, #136]      // curr_x
-    ldr w1, [sp, #144]      // next_x
-    sub w1, w1, w0          // next_x - curr_x
-    scvtf s0, w1            // (next_x - curr_x) as float
-    fmul s0, s2, s0         // t * (next_x - curr_x)
-    fcvtns w1, s0           // convert to int
-    add w1, w0, w1          // line_x = curr_x + result
-    
-    // line_y = curr_y + (int)(t * (next_y - curr_y))
-    ldr w0, [sp, #140]      // curr_y
-    ldr w2, [sp, #148]      // next_y
-    sub w2, w2, w0          // next_y - curr_y
-    scvtf s0, w2            // (next_y - curr_y) as float
-    fmul s0, s2, s0         // t * (next_y - curr_y)
-    fcvtns w2, s0           // convert to int
-    add w2, w0, w2          // line_y = curr_y + result
-    
-    // char line_char = get_glitched_shape_char('-', line_x, line_y, frame)
-    mov w0, #'-'            // base character for lines
-    // w1 already has line_x
-    // w2 already has line_y  
-    mov w3, w25             // frame
+    udiv w21, w5, w6        // steps = (|dx| + |dy|) / 12
+
+    mov w28, #1             // step
+.Lpoly_step_loop:
+    cmp w28, w21
+    b.ge .Lpoly_next_edge
+
+    // start + step * d / steps, rounded half away from zero:
+    // (2 * step * d +- steps) / (2 * steps)
+    ldp w3, w4, [sp, #POLY_SP_EDGE + 8]
+    lsl w12, w21, #1
+    mul w5, w28, w3
+    lsl w5, w5, #1
+    cmp w3, #0
+    cneg w6, w21, lt
+    add w5, w5, w6
+    sdiv w5, w5, w12
+    mul w7, w28, w4
+    lsl w7, w7, #1
+    cmp w4, #0
+    cneg w6, w21, lt
+    add w7, w7, w6
+    sdiv w7, w7, w12
+    ldp w1, w2, [sp, #POLY_SP_EDGE]
+    add w1, w1, w5
+    add w2, w2, w7
+    stp w1, w2, [sp, #POLY_SP_CELL]
+
+    mov w0, w26
+    mov w3, w25
     bl _get_glitched_shape_char
-    // Result in w0 = glitched_char
-    
-    // draw_ascii_char(pixels, line_x, line_y, glitched_char, color, alpha - 50)
-    mov w3, w0              // glitched_char
-    mov x0, x19             // pixels
-    // w1 already has line_x
-    // w2 already has line_y
-    mov w4, w23             // color
-    sub w5, w24, #50        // alpha - 50
-    cmp w5, #0              // Ensure alpha doesn't go negative
-    csel w5, w5, wzr, ge    // max(alpha - 50, 0)
+    mov w3, w0
+    ldp w1, w2, [sp, #POLY_SP_CELL]
+    mov x0, x19
+    mov w4, w23
+    mov w5, w24
     bl _draw_ascii_char_asm
-    
-    // Increment step
-    add w27, w27, #1        // step++
-    b .Lsquare_line_loop
-    
-.Lsquare_next_edge:
-    // Increment edge index
-    add w26, w26, #1        // i++
-    b .Lsquare_edge_loop
-    
-.Lsquare_done:
+
+    add w28, w28, #1
+    b .Lpoly_step_loop
+
+.Lpoly_next_edge:
+    add w20, w20, #1
+    b .Lpoly_edge_loop
+
+.Lpoly_done:
+    ldp d8, d9, [sp, #96]
     ldp x27, x28, [sp, #80]
     ldp x25, x26, [sp, #64]
     ldp x23, x24, [sp, #48]
     ldp x21, x22, [sp, #32]
     ldp x19, x20, [sp, #16]
-    ldp x29, x30, [sp], #160
+    ldp x29, x30, [sp], #POLY_FRAME
+.Lpoly_ret:
     ret
 
-// Draw ASCII triangle
-// void draw_ascii_triangle(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame)
+// The five shapes
+// void draw_ascii_<shape>(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame)
 // Input: x0=pixels, w1=cx, w2=cy, w3=size, s0=rotation, w4=color, w5=alpha, w6=frame
 .global _draw_ascii_triangle_asm
 _draw_ascii_triangle_asm:
-    stp x29, x30, [sp, #-144]!
-    mov x29, sp
-    stp x19, x20, [sp, #16]
-    stp x21, x22, [sp, #32]
-    stp x23, x24, [sp, #48]
-    stp x25, x26, [sp, #64]
-    stp x27, x28, [sp, #80]
-    
-    // Check size threshold
-    cmp w3, #8
-    b.lt .Ltriangle_done    // return if size < 8
-    
-    // Save all parameters to dedicated registers
-    mov x19, x0             // pixels pointer  
-    mov w20, w1             // cx
-    mov w21, w2             // cy  
-    mov w22, w3             // size
-    str s0, [sp, #96]       // rotation (on stack)
-    mov w23, w4             // color
-    mov w24, w5             // alpha
-    mov w25, w6             // frame
-    
-    // Loop counter in dedicated register
-    mov w26, #0             // i = 0 (vertex index, 0-2)
-    
-    // for (int i = 0; i < 3; i++)
-.Ltriangle_vertex_loop:
-    cmp w26, #3
-    b.ge .Ltriangle_done
-    
-    // float angle = rotation + i * 2.0f * M_PI / 3.0f
-    scvtf s1, w26           // Convert i to float
-    adr x0, .Lconst_2pi_3   // 2.0f * M_PI / 3.0f ≈ 2.094395
-    ldr s2, [x0]
-    fmul s1, s1, s2         // i * (2.0f * M_PI / 3.0f)
-    ldr s0, [sp, #96]       // Load rotation
-    fadd s0, s0, s1         // angle = rotation + i * (2.0f * M_PI / 3.0f)
-    
-    // int x = cx + (int)(cosf(angle) * size * 0.8f)
-    bl _cos_lut_asm         // s0 = cos(angle) from LUT
-    scvtf s1, w22           // Convert size to float
-    fmul s0, s0, s1         // cos(angle) * size
-    adr x0, .Lconst_0_8     
-    ldr s1, [x0]            // 0.8f
-    fmul s0, s0, s1         // cos(angle) * size * 0.8f
-    fcvtns w27, s0          // Convert to int, store in w27
-    add w27, w20, w27       // x = cx + result
-    
-    // int y = cy + (int)(sinf(angle) * size * 0.8f)  
-    // Recalculate angle since cosf modified s0
-    scvtf s1, w26           // Convert i to float
-    adr x0, .Lconst_2pi_3    
-    ldr s2, [x0]
-    fmul s1, s1, s2         // i * (2.0f * M_PI / 3.0f)
-    ldr s0, [sp, #96]       // Load rotation
-    fadd s0, s0, s1         // angle = rotation + i * (2.0f * M_PI / 3.0f)
-    
-    bl _sin_lut_asm         // s0 = sin(angle) from LUT
-    scvtf s1, w22           // Convert size to float
-    fmul s0, s0, s1         // sin(angle) * size
-    adr x0, .Lconst_0_8
-    ldr s1, [x0]            // 0.8f
-    fmul s0, s0, s1         // sin(angle) * size * 0.8f
-    fcvtns w28, s0          // Convert to int, store in w28
-    add w28, w21, w28       // y = cy + result
-    
-    // Store current vertex coordinates for line drawing
-    str w27, [sp, #100]     // Store current x
-    str w28, [sp, #104]     // Store current y
-    
-    // char base_char = triangle_chars[i % char_count]
-    mov w0, #5              // char_count = 5
-    udiv w1, w26, w0        // w1 = i / 5
-    msub w0, w1, w0, w26    // w0 = i % 5
-    adr x1, .Ltriangle_chars
-    ldrb w0, [x1, w0, uxtw] // Load triangle_chars[i % 5]
-    
-    // char glitched_char = get_glitched_shape_char(base_char, x, y, frame)
-    // w0 already has base_char
-    mov w1, w27             // x  
-    mov w2, w28             // y
-    mov w3, w25             // frame
-    bl _get_glitched_shape_char
-    // Result in w0 = glitched_char
-    
-    // draw_ascii_char(pixels, x, y, glitched_char, color, alpha)
-    mov w3, w0              // glitched_char
-    mov x0, x19             // pixels
-    mov w1, w27             // x
-    mov w2, w28             // y
-    mov w4, w23             // color
-    mov w5, w24             // alpha
-    bl _draw_ascii_char_asm
-    
-    // Calculate next vertex for line drawing
-    // float next_angle = rotation + ((i + 1) % 3) * 2.0f * M_PI / 3.0f
-    add w0, w26, #1         // i + 1
-    mov w1, #3              // 3 vertices
-    udiv w2, w0, w1         // (i + 1) / 3
-    msub w0, w2, w1, w0     // next_i = (i + 1) % 3
-    
-    scvtf s1, w0            // Convert next_i to float
-    adr x1, .Lconst_2pi_3   
-    ldr s2, [x1]
-    fmul s1, s1, s2         // next_i * (2.0f * M_PI / 3.0f)
-    ldr s0, [sp, #96]       // Load rotation
-    fadd s0, s0, s1         // next_angle = rotation + next_i * (2.0f * M_PI / 3.0f)
-    
-    // int next_x = cx + (int)(cosf(next_angle) * size * 0.8f)
-    bl _cos_lut_asm         // s0 = cos(next_angle) from LUT
-    scvtf s1, w22           // Convert size to float
-    fmul s0, s0, s1         // cos(next_angle) * size
-    adr x1, .Lconst_0_8     
-    ldr s1, [x1]            // 0.8f
-    fmul s0, s0, s1         // cos(next_angle) * size * 0.8f
-    fcvtns w0, s0           // Convert to int
-    add w0, w20, w0         // next_x = cx + result
-    str w0, [sp, #108]      // Store next_x
-    
-    // int next_y = cy + (int)(sinf(next_angle) * size * 0.8f)
-    // Recalculate next_angle since cosf modified s0
-    add w0, w26, #1         // i + 1
-    mov w1, #3              // 3 vertices
-    udiv w2, w0, w1         // (i + 1) / 3
-    msub w0, w2, w1, w0     // next_i = (i + 1) % 3
-    
-    scvtf s1, w0            // Convert next_i to float
-    adr x1, .Lconst_2pi_3   
-    ldr s2, [x1]
-    fmul s1, s1, s2         // next_i * (2.0f * M_PI / 3.0f)
-    ldr s0, [sp, #96]       // Load rotation
-    fadd s0, s0, s1         // next_angle
-    
-    bl _sin_lut_asm         // s0 = sin(next_angle) from LUT
-    scvtf s1, w22           // Convert size to float
-    fmul s0, s0, s1         // sin(next_angle) * size
-    adr x1, .Lconst_0_8
-    ldr s1, [x1]            // 0.8f
-    fmul s0, s0, s1         // sin(next_angle) * size * 0.8f
-    fcvtns w0, s0           // Convert to int
-    add w0, w21, w0         // next_y = cy + result
-    
-    // Store next_y properly first
-    str w0, [sp, #112]      // Store next_y
-    
-    // Draw line between current vertex and next vertex
-    // Load coordinates into dedicated registers
-    ldr w1, [sp, #100]      // curr_x
-    ldr w2, [sp, #104]      // curr_y
-    ldr w3, [sp, #108]      // next_x
-    ldr w4, [sp, #112]      // next_y
-    
-    // Store these in a way that won't get corrupted
-    str w1, [sp, #116]      // Store curr_x
-    str w2, [sp, #120]      // Store curr_y  
-    str w3, [sp, #124]      // Store next_x
-    str w4, [sp, #128]      // Store next_y
-    
-    // Calculate steps = abs(next_x - curr_x) + abs(next_y - curr_y)
-    sub w5, w3, w1          // next_x - curr_x
-    cmp w5, #0
-    cneg w5, w5, mi         // abs(next_x - curr_x)
-    
-    sub w6, w4, w2          // next_y - curr_y  
-    cmp w6, #0
-    cneg w6, w6, mi         // abs(next_y - curr_y)
-    
-    add w5, w5, w6          // sum of distances
-    mov w6, #12
-    udiv w0, w5, w6         // steps = distance / 12
-    
-    // Draw line points
-    mov w27, #1             // step = 1 (start from 1, not 0)
-    
-.Ltriangle_line_loop:
-    cmp w27, w0             // step < steps?
-    b.ge .Ltriangle_next_vertex
-    
-    // Calculate t = (float)step / steps
-    scvtf s0, w27           // step as float
-    scvtf s1, w0            // steps as float
-    fdiv s2, s0, s1         // t = step / steps
-    
-    // Calculate line coordinates using stored values
-    // line_x = curr_x + (int)(t * (next_x - curr_x))
-    ldr w1, [sp, #116]      // Reload curr_x
-    ldr w3, [sp, #124]      // Reload next_x
-    sub w5, w3, w1          // next_x - curr_x
-    scvtf s0, w5            // (next_x - curr_x) as float
-    fmul s0, s2, s0         // t * (next_x - curr_x)
-    fcvtns w5, s0           // convert to int
-    add w5, w1, w5          // line_x = curr_x + result
-    
-    // line_y = curr_y + (int)(t * (next_y - curr_y))
-    ldr w2, [sp, #120]      // Reload curr_y
-    ldr w4, [sp, #128]      // Reload next_y
-    sub w6, w4, w2          // next_y - curr_y
-    scvtf s0, w6            // (next_y - curr_y) as float
-    fmul s0, s2, s0         // t * (next_y - curr_y)
-    fcvtns w6, s0           // convert to int
-    add w6, w2, w6          // line_y = curr_y + result
-    
-    // char line_char = get_glitched_shape_char('-', line_x, line_y, frame)
-    mov w0, #'-'            // base character for lines
-    mov w1, w5              // line_x
-    mov w2, w6              // line_y  
-    mov w3, w25             // frame
-    bl _get_glitched_shape_char
-    // Result in w0 = glitched_char
-    
-    // draw_ascii_char(pixels, line_x, line_y, glitched_char, color, alpha - 50)
-    mov w3, w0              // glitched_char
-    mov x0, x19             // pixels
-    mov w1, w5              // line_x
-    mov w2, w6              // line_y
-    mov w4, w23             // color
-    sub w5, w24, #50        // alpha - 50
-    cmp w5, #0              // Ensure alpha doesn't go negative
-    csel w5, w5, wzr, ge    // max(alpha - 50, 0)
-    bl _draw_ascii_char_asm
-    
-    // Increment step
-    add w27, w27, #1        // step++
-    b .Ltriangle_line_loop
-    
-.Ltriangle_next_vertex:
-    // Increment vertex index
-    add w26, w26, #1        // i++
-    b .Ltriangle_vertex_loop
+    adr x7, .Lpoly_triangle
+    b _draw_ascii_polygon_asm
 
-.Ltriangle_done:
-    ldp x27, x28, [sp, #80]
-    ldp x25, x26, [sp, #64]
-    ldp x23, x24, [sp, #48]
-    ldp x21, x22, [sp, #32]
-    ldp x19, x20, [sp, #16]
-    ldp x29, x30, [sp], #144
-    ret
-
-// Draw ASCII diamond
-// void draw_ascii_diamond(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame)
-// Input: x0=pixels, w1=cx, w2=cy, w3=size, s0=rotation, w4=color, w5=alpha, w6=frame
 .global _draw_ascii_diamond_asm
 _draw_ascii_diamond_asm:
-    stp x29, x30, [sp, #-144]!
-    mov x29, sp
-    stp x19, x20, [sp, #16]
-    stp x21, x22, [sp, #32]
-    stp x23, x24, [sp, #48]
-    stp x25, x26, [sp, #64]
-    stp x27, x28, [sp, #80]
-    
-    // Check size threshold
-    cmp w3, #8
-    b.lt .Ldiamond_done     // return if size < 8
-    
-    // Save all parameters to dedicated registers
-    mov x19, x0             // pixels pointer  
-    mov w20, w1             // cx
-    mov w21, w2             // cy  
-    mov w22, w3             // size
-    str s0, [sp, #96]       // rotation (on stack)
-    mov w23, w4             // color
-    mov w24, w5             // alpha
-    mov w25, w6             // frame
-    
-    // Calculate diamond points (4 points: top, right, bottom, left)
-    // points[4][2] = {{cx, cy-size}, {cx+size, cy}, {cx, cy+size}, {cx-size, cy}}
-    mov w0, w20             // cx
-    sub w1, w21, w22        // cy - size
-    stp w0, w1, [sp, #104]  // Store point 0: top
-    
-    add w0, w20, w22        // cx + size  
-    mov w1, w21             // cy
-    stp w0, w1, [sp, #112]  // Store point 1: right
-    
-    mov w0, w20             // cx
-    add w1, w21, w22        // cy + size  
-    stp w0, w1, [sp, #120]  // Store point 2: bottom
-    
-    sub w0, w20, w22        // cx - size
-    mov w1, w21             // cy
-    stp w0, w1, [sp, #128]  // Store point 3: left
-    
-    // Apply rotation to points and draw them
-    mov w26, #0             // i = 0 (point index)
-    
-.Ldiamond_point_loop:
-    cmp w26, #4
-    b.ge .Ldiamond_edges    // Done with points, now draw edges
-    
-    // Load point coordinates
-    mov w0, #8              // 8 bytes per point (2 ints)
-    mul w0, w26, w0         // i * 8
-    add w0, w0, #104        // offset to points array
-    add x1, sp, w0, uxtw    // address of points[i]
-    ldp w27, w28, [x1]      // Load points[i][0], points[i][1]
-    
-    // Calculate dx = points[i][0] - cx, dy = points[i][1] - cy
-    sub w0, w27, w20        // dx = points[i][0] - cx
-    sub w1, w28, w21        // dy = points[i][1] - cy
-    scvtf s0, w0            // dx as float
-    scvtf s1, w1            // dy as float
-    
-    // Rotate: rotated_x = dx * cos(rotation) - dy * sin(rotation)
-    //         rotated_y = dx * sin(rotation) + dy * cos(rotation)
-    ldr s2, [sp, #96]       // Load rotation
-    
-    // Calculate cos(rotation)
-    fmov s3, s2             // Copy rotation for cos call
-    bl _cos_lut_asm         // s0 = cos(rotation) from LUT
-    fmov s4, s0             // Save cos result in s4
-    
-    // Calculate sin(rotation)  
-    ldr s2, [sp, #96]       // Reload rotation
-    fmov s0, s2             // Set up for sin call
-    bl _sin_lut_asm         // s0 = sin(rotation) from LUT
-    fmov s5, s0             // Save sin result in s5
-    
-    // Reload dx, dy
-    sub w0, w27, w20        // dx = points[i][0] - cx
-    sub w1, w28, w21        // dy = points[i][1] - cy  
-    scvtf s0, w0            // dx as float
-    scvtf s1, w1            // dy as float
-    
-    // Now compute rotated coordinates
-    fmul s6, s0, s4         // dx * cos(rotation)
-    fmul s7, s1, s5         // dy * sin(rotation)
-    fsub s6, s6, s7         // rotated_x = dx * cos - dy * sin
-    
-    fmul s7, s0, s5         // dx * sin(rotation)
-    fmul s8, s1, s4         // dy * cos(rotation)
-    fadd s7, s7, s8         // rotated_y = dx * sin + dy * cos
-    
-    // Convert back to integers and add center
-    fcvtns w0, s6           // rotated_x as int
-    fcvtns w1, s7           // rotated_y as int
-    add w27, w20, w0        // final_x = cx + rotated_x
-    add w28, w21, w1        // final_y = cy + rotated_y
-    
-    // Store rotated point back
-    mov w0, #8              // 8 bytes per point
-    mul w0, w26, w0         // i * 8
-    add w0, w0, #104        // offset to points array
-    add x1, sp, w0, uxtw    // address of points[i]
-    stp w27, w28, [x1]      // Store rotated coordinates
-    
-    // Get character: base_char = diamond_chars[i % char_count]
-    mov w0, #5              // char_count = 5
-    udiv w1, w26, w0        // w1 = i / 5
-    msub w0, w1, w0, w26    // w0 = i % 5
-    adr x1, .Ldiamond_chars
-    ldrb w0, [x1, w0, uxtw] // Load diamond_chars[i % 5]
-    
-    // char glitched_char = get_glitched_shape_char(base_char, x, y, frame)
-    // w0 already has base_char
-    mov w1, w27             // x  
-    mov w2, w28             // y
-    mov w3, w25             // frame
-    bl _get_glitched_shape_char
-    // Result in w0 = glitched_char
-    
-    // draw_ascii_char(pixels, x, y, glitched_char, color, alpha)
-    mov w3, w0              // glitched_char
-    mov x0, x19             // pixels
-    mov w1, w27             // x
-    mov w2, w28             // y
-    mov w4, w23             // color
-    mov w5, w24             // alpha
-    bl _draw_ascii_char_asm
-    
-    // Increment point index
-    add w26, w26, #1        // i++
-    b .Ldiamond_point_loop
-    
-.Ldiamond_edges:
-    // Draw diamond edges connecting points
-    mov w26, #0             // i = 0 (edge index)
-    
-.Ldiamond_edge_loop:
-    cmp w26, #4
-    b.ge .Ldiamond_done     // Done with all edges
-    
-    // Calculate next point index: next = (i + 1) % 4
-    add w0, w26, #1         // i + 1
-    mov w1, #4              // 4 points
-    udiv w2, w0, w1         // (i + 1) / 4
-    msub w27, w2, w1, w0    // next = (i + 1) % 4
-    
-    // Load current point coordinates
-    mov w0, #8              // 8 bytes per point
-    mul w0, w26, w0         // i * 8
-    add w0, w0, #104        // offset to points array
-    add x1, sp, w0, uxtw    // address of points[i]
-    ldp w1, w2, [x1]        // Load points[i][0], points[i][1]
-    
-    // Load next point coordinates  
-    mov w0, #8              // 8 bytes per point
-    mul w0, w27, w0         // next * 8
-    add w0, w0, #104        // offset to points array
-    add x3, sp, w0, uxtw    // address of points[next]
-    ldp w3, w4, [x3]        // Load points[next][0], points[next][1]
-    
-    // Calculate steps = (abs(next_x - curr_x) + abs(next_y - curr_y)) / 12
-    sub w5, w3, w1          // next_x - curr_x
-    cmp w5, #0
-    cneg w5, w5, mi         // abs(next_x - curr_x)
-    
-    sub w6, w4, w2          // next_y - curr_y  
-    cmp w6, #0
-    cneg w6, w6, mi         // abs(next_y - curr_y)
-    
-    add w5, w5, w6          // sum of distances
-    mov w6, #12
-    udiv w28, w5, w6        // steps = distance / 12
-    
-    // Save point coordinates for edge drawing
-    str w1, [sp, #136]      // curr_x
-    str w2, [sp, #140]      // curr_y
-    str w3, [sp, #144]      // next_x (note: using unused stack space)
-    str w4, [sp, #148]      // next_y
-    
-    // Draw line between points
-    mov w27, #1             // step = 1 (start from 1, not 0)
-    
-.Ldiamond_line_loop:
-    cmp w27, w28            // step < steps?
-    b.ge .Ldiamond_next_edge
-    
-    // Calculate t = (float)step / steps
-    scvtf s0, w27           // step as float
-    scvtf s1, w28           // steps as float
-    fdiv s2, s0, s1         // t = step / steps
-    
-    // Calculate line coordinates
-    // line_x = curr_x + (int)(t * (next_x - curr_x))
-    ldr w0, [sp, #136]      // curr_x
-    ldr w1, [sp, #144]      // next_x
-    sub w1, w1, w0          // next_x - curr_x
-    scvtf s0, w1            // (next_x - curr_x) as float
-    fmul s0, s2, s0         // t * (next_x - curr_x)
-    fcvtns w1, s0           // convert to int
-    add w1, w0, w1          // line_x = curr_x + result
-    
-    // line_y = curr_y + (int)(t * (next_y - curr_y))
-    ldr w0, [sp, #140]      // curr_y
-    ldr w2, [sp, #148]      // next_y
-    sub w2, w2, w0          // next_y - curr_y
-    scvtf s0, w2            // (next_y - curr_y) as float
-    fmul s0, s2, s0         // t * (next_y - curr_y)
-    fcvtns w2, s0           // convert to int
-    add w2, w0, w2          // line_y = curr_y + result
-    
-    // char line_char = get_glitched_shape_char('=', line_x, line_y, frame)
-    mov w0, #'='            // base character for diamond lines
-    // w1 already has line_x
-    // w2 already has line_y  
-    mov w3, w25             // frame
-    bl _get_glitched_shape_char
-    // Result in w0 = glitched_char
-    
-    // draw_ascii_char(pixels, line_x, line_y, glitched_char, color, alpha - 50)
-    mov w3, w0              // glitched_char
-    mov x0, x19             // pixels
-    // w1 already has line_x
-    // w2 already has line_y
-    mov w4, w23             // color
-    sub w5, w24, #50        // alpha - 50
-    cmp w5, #0              // Ensure alpha doesn't go negative
-    csel w5, w5, wzr, ge    // max(alpha - 50, 0)
-    bl _draw_ascii_char_asm
-    
-    // Increment step
-    add w27, w27, #1        // step++
-    b .Ldiamond_line_loop
-    
-.Ldiamond_next_edge:
-    // Increment edge index
-    add w26, w26, #1        // i++
-    b .Ldiamond_edge_loop
-    
-.Ldiamond_done:
-    ldp x27, x28, [sp, #80]
-    ldp x25, x26, [sp, #64]
-    ldp x23, x24, [sp, #48]
-    ldp x21, x22, [sp, #32]
-    ldp x19, x20, [sp, #16]
-    ldp x29, x30, [sp], #144
-    ret
+    adr x7, .Lpoly_diamond
+    b _draw_ascii_polygon_asm
+
+.global _draw_ascii_hexagon_asm
+_draw_ascii_hexagon_asm:
+    adr x7, .Lpoly_hexagon
+    b _draw_ascii_polygon_asm
 
-// Draw ASCII star
-// void draw_ascii_star(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame)
-// Input: x0=pixels, w1=cx, w2=cy, w3=size, s0=rotation, w4=color, w5=alpha, w6=frame
 .global _draw_ascii_star_asm
 _draw_ascii_star_asm:
-    stp x29, x30, [sp, #-112]!
-    mov x29, sp
-    stp x19, x20, [sp, #16]
-    stp x21, x22, [sp, #32]
-    stp x23, x24, [sp, #48]
-    stp x25, x26, [sp, #64]
-    stp x27, x28, [sp, #80]
-    
-    // Check size threshold
-    cmp w3, #8
-    b.lt .Lstar_done        // return if size < 8
-    
-    // Save all parameters to dedicated registers
-    mov x19, x0             // pixels pointer  
-    mov w20, w1             // cx
-    mov w21, w2             // cy  
-    mov w22, w3             // size
-    str s0, [sp, #96]       // rotation (on stack)
-    mov w23, w4             // color
-    mov w24, w5             // alpha
-    mov w25, w6             // frame
-    
-    // Loop counter in dedicated register
-    mov w26, #0             // i = 0 (point index, 0-9 for 10 points)
-    
-    // for (int i = 0; i < 10; i++) - 5-pointed star with inner/outer points
-.Lstar_point_loop:
-    cmp w26, #10
-    b.ge .Lstar_done
-    
-    // float angle = rotation + i * M_PI / 5.0f
-    scvtf s1, w26           // Convert i to float
-    adr x0, .Lconst_pi_5    // M_PI / 5.0f ≈ 0.628318
-    ldr s2, [x0]
-    fmul s1, s1, s2         // i * (M_PI / 5.0f)
-    ldr s0, [sp, #96]       // Load rotation
-    fadd s0, s0, s1         // angle = rotation + i * (M_PI / 5.0f)
-    
-    // float radius = (i % 2 == 0) ? size * 0.8f : size * 0.4f; // Alternate between outer and inner
-    mov w0, #2
-    udiv w1, w26, w0        // w1 = i / 2
-    msub w0, w1, w0, w26    // w0 = i % 2
-    
-    scvtf s1, w22           // Convert size to float
-    cmp w0, #0              // i % 2 == 0?
-    b.ne .Lstar_inner_radius
-    
-    // Outer radius: size * 0.8f
-    adr x0, .Lconst_0_8     
-    ldr s2, [x0]            // 0.8f
-    fmul s1, s1, s2         // size * 0.8f
-    b .Lstar_calc_pos
-    
-.Lstar_inner_radius:
-    // Inner radius: size * 0.4f
-    adr x0, .Lconst_0_4     
-    ldr s2, [x0]            // 0.4f
-    fmul s1, s1, s2         // size * 0.4f
-    
-.Lstar_calc_pos:
-    // s1 now contains the radius
-    // int x = cx + (int)(cosf(angle) * radius)
-    bl _cos_lut_asm         // s0 = cos(angle) from LUT
-    fmul s0, s0, s1         // cos(angle) * radius
-    fcvtns w27, s0          // Convert to int, store in w27
-    add w27, w20, w27       // x = cx + result
-    
-    // int y = cy + (int)(sinf(angle) * radius)  
-    // Recalculate angle since cosf modified s0
-    scvtf s1, w26           // Convert i to float
-    adr x0, .Lconst_pi_5    
-    ldr s2, [x0]
-    fmul s1, s1, s2         // i * (M_PI / 5.0f)
-    ldr s0, [sp, #96]       // Load rotation
-    fadd s0, s0, s1         // angle = rotation + i * (M_PI / 5.0f)
-    
-    // Recalculate radius
-    mov w0, #2
-    udiv w1, w26, w0        // w1 = i / 2
-    msub w0, w1, w0, w26    // w0 = i % 2
-    
-    scvtf s1, w22           // Convert size to float
-    cmp w0, #0              // i % 2 == 0?
-    b.ne .Lstar_inner_radius2
-    
-    // Outer radius: size * 0.8f
-    adr x0, .Lconst_0_8     
-    ldr s2, [x0]            // 0.8f
-    fmul s1, s1, s2         // size * 0.8f
-    b .Lstar_calc_y
-    
-.Lstar_inner_radius2:
-    // Inner radius: size * 0.4f
-    adr x0, .Lconst_0_4     
-    ldr s2, [x0]            // 0.4f
-    fmul s1, s1, s2         // size * 0.4f
-    
-.Lstar_calc_y:
-    bl _sin_lut_asm         // s0 = sin(angle) from LUT
-    fmul s0, s0, s1         // sin(angle) * radius
-    fcvtns w28, s0          // Convert to int, store in w28
-    add w28, w21, w28       // y = cy + result
-    
-    // char base_char = star_chars[i % char_count]
-    mov w0, #8              // char_count = 8
-    udiv w1, w26, w0        // w1 = i / 8
-    msub w0, w1, w0, w26    // w0 = i % 8
-    adr x1, .Lstar_chars
-    ldrb w0, [x1, w0, uxtw] // Load star_chars[i % 8]
-    
-    // char glitched_char = get_glitched_shape_char(base_char, x, y, frame)
-    // w0 already has base_char
-    mov w1, w27             // x  
-    mov w2, w28             // y
-    mov w3, w25             // frame
-    bl _get_glitched_shape_char
-    // Result in w0 = glitched_char
-    
-    // draw_ascii_char(pixels, x, y, glitched_char, color, alpha)
-    mov w3, w0              // glitched_char
-    mov x0, x19             // pixels
-    mov w1, w27             // x
-    mov w2, w28             // y
-    mov w4, w23             // color
-    mov w5, w24             // alpha
-    bl _draw_ascii_char_asm
-    
-    // Increment loop counter
-    add w26, w26, #1        // i++
-    b .Lstar_point_loop
-    
-.Lstar_done:
-    ldp x27, x28, [sp, #80]
-    ldp x25, x26, [sp, #64]
-    ldp x23, x24, [sp, #48]
-    ldp x21, x22, [sp, #32]
-    ldp x19, x20, [sp, #16]
-    ldp x29, x30, [sp], #112
-    ret
+    adr x7, .Lpoly_star
+    b _draw_ascii_polygon_asm
+
+.global _draw_ascii_square_asm
+_draw_ascii_square_asm:
+    adr x7, .Lpoly_square
+    b _draw_ascii_polygon_asm
+
+// Shape tables (layout above)
+.p2align 2
+// 3 vertices at 0.8 * size, 120° apart
+.Lpoly_triangle:
+    .byte 3, '-', 0, 0
+    .byte '^', 'A', '/'
+    .space 9
+    .float 0.800000, 0.000000
+    .float -0.400000, 0.692820
+    .float -0.400000, -0.692820
+
+// Top, right, bottom, left at size
+.Lpoly_diamond:
+    .byte 4, '=', 0, 0
+    .byte '<', '>', '^', 'v'
+    .space 8
+    .float 0.0, -1.0
+    .float 1.0, 0.0
+    .float 0.0, 1.0
+    .float -1.0, 0.0
+
+// 6 vertices at 0.7 * size, no edges
+.Lpoly_hexagon:
+    .byte 6, 0, 0, 0
+    .byte 'O', '0', '#', '*', '+', 'X'
+    .space 6
+    .float 0.700000, 0.000000
+    .float 0.350000, 0.606218
+    .float -0.350000, 0.606218
+    .float -0.700000, 0.000000
+    .float -0.350000, -0.606218
+    .float 0.350000, -0.606218
+
+// 5-pointed star: 10 vertices 36° apart, alternately 0.8 and 0.4 * size, no edges
+.Lpoly_star:
+    .byte 10, 0, 0, 0
+    .byte '*', '+', 'x', 'X', '^', 'v', '<', '>', '*', '+'
+    .space 2
+    .float 0.800000, 0.000000
+    .float 0.323607, 0.235114
+    .float 0.247214, 0.760845
+    .float -0.123607, 0.380423
+    .float -0.647214, 0.470228
+    .float -0.400000, 0.000000
+    .float -0.647214, -0.470228
+    .float -0.123607, -0.380423
+    .float 0.247214, -0.760845
+    .float 0.323607, -0.235114
+
+// Corners at +-size (size is the half width)
+.Lpoly_square:
+    .byte 4, '-', 0, 0
+    .byte '#', '=', '+', 'H'
+    .space 8
+    .float -1.0, -1.0
+    .float 1.0, -1.0
+    .float 1.0, 1.0
+    .float -1.0, 1.0
 
 // Update all active bass hits
 // void update_bass_hits(float elapsed_ms, float step_sec, float base_hue, uint32_t seed)
@@ -1651,35 +934,8 @@ _draw_bass_hits_asm:
     ldp x29, x30, [sp], #96
     ret
 
-// All character arrays and constants
-.align 1
-.Lhex_chars:
-    .byte 'O', '0', '#', '*', '+', 'X'
-
-.Lsquare_chars:
-    .byte '#', '=', '+', 'H', 'M', 'W'
-
-.Ltriangle_chars:
-    .byte '^', 'A', '/', '\\', '-'
-
-.Ldiamond_chars:
-    .byte '<', '>', '^', 'v', '*'
-
-.Lstar_chars:
-    .byte '*', '+', 'x', 'X', '^', 'v', '<', '>'
-
 // All floating point constants
 .align 4
-.Lconst_pi_3:
-    .float 1.047198         // M_PI / 3.0f
-.Lconst_0_7:
-    .float 0.7
-.Lconst_2pi_3:
-    .float 2.094395         // 2.0f * M_PI / 3.0f
-.Lconst_0_8:
-    .float 0.8
-.Lconst_pi_5:
-    .float 0.628318         // M_PI / 5.0f
 .Lconst_0_15:
     .float 0.15
 .Lconst_1000:
@@ -40,7 +40,19 @@ _set_pixel_asm:
     
     // Store color at calculated offset
     str w3, [x0, w5, uxtw #2] // pixels[offset] = color (4 bytes per pixel)
-    
+
+    // Mark the pixel's tile in vis_dirty_tiles (ascii_renderer.s)
+    adrp x6, _vis_dirty_tiles@PAGE
+    ldr x6, [x6, _vis_dirty_tiles@PAGEOFF]
+    cbz x6, .Lsp_return
+    lsr w4, w2, #5            // tile row
+    ldr w5, [x6, w4, uxtw #2]
+    lsr w7, w1, #5            // tile column
+    mov w8, #1
+    lsl w7, w8, w7
+    orr w5, w5, w7
+    str w5, [x6, w4, uxtw #2]
+
 .Lsp_return:
     ret
 
@@ -3,10 +3,11 @@
 // Glitch System ARM64 Assembly Implementation
 // Based on glitch_system.c - Final visual component!
 
-.section __DATA,__data
+.section __TEXT,__const
 .align 3
 
-// Character arrays for different glitch types
+// Character arrays for different glitch types (read-only, so the pages stay
+// shared between render processes mapping the same binary)
 terrain_glitch_chars:
     .ascii "#=-%*+~^|\\/<>[]{}()\0"
 
@@ -27,14 +28,21 @@ matrix_chars:
 //     float glitch_intensity;       // offset 12
 //     uint32_t glitch_seed;         // offset 16
 // } glitch_config_t;
+.section __DATA,__data
 .align 2
+// Module state [_vis_glitch_state, _vis_glitch_state_end): swapped per render context by src/vis_ctx.c
+.global _vis_glitch_state
+.global _vis_glitch_state_end
+_vis_glitch_state:
 glitch_config:
     .space 20, 0                  // 5 * 4 bytes = 20 bytes
 
 glitch_initialized:
     .word 0                       // bool as 32-bit word
+_vis_glitch_state_end:
 
 // Constants for glitch calculations
+.section __TEXT,__const
 .align 2
 .Lconst_0_1:
     .float 0.1
@@ -39,6 +39,10 @@ particle_chars:
 .section __DATA,__data
 .align 5                        // 32-byte alignment
 
+// Module state [_vis_particles_state, _vis_particles_state_end): swapped per render context by src/vis_ctx.c
+.global _vis_particles_state
+.global _vis_particles_state_end
+_vis_particles_state:
 .global particles_array
 particles_array:
     .space (256 * 32), 0       // 256 particles, 32 bytes each = 8KB
@@ -48,6 +52,7 @@ particles_initialized:
 
 last_step:
     .word -1
+_vis_particles_state_end:
 
 .text  // Return to text section for function definitions
 
@@ -23,11 +23,15 @@
 .section __DATA,__data
 .align 5
 
+// Module state [_vis_terrain_state, _vis_terrain_state_end): swapped per render context by src/vis_ctx.c
+.global _vis_terrain_state
+.global _vis_terrain_state_end
 // Terrain pattern array - 64 tiles * 8 bytes each = 512 bytes
 // terrain_tile_t structure layout:
 // - type: 4 bytes (terrain_type_t enum)
 // - height: 4 bytes (int)
 // Total: 8 bytes per terrain_tile_t
+_vis_terrain_state:
 terrain_pattern:
     .space (64 * 8), 0      // TERRAIN_LENGTH * sizeof(terrain_tile_t)
 
@@ -52,6 +56,7 @@ terrain_audio_level:
 // Initialization flag
 terrain_initialized:
     .space 1, 0             // bool
+_vis_terrain_state_end:
 
 .section __TEXT,__text,regular,pure_instructions
 
@@ -0,0 +1,161 @@
+#include "include/audio_features.h"
+#include "c/include/pcm16.h"
+#include "c/include/digest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+uint64_t audio_features_hash(const void *data, size_t len) {
+    return xxh64(data, len, 0);   // 8 bytes a step; FNV-1a's byte loop was slower than the analysis
+}
+
+// Onsets from the level series: same thresholds as audio_visual_bridge.c's
+// detect_beat_onset, evaluated once per frame
+static void af_detect_onsets(audio_features_t *f) {
+    float max_rms = 0.0f;
+    for (uint32_t i = 0; i < f->frames; i++) if (f->rms[i] > max_rms) max_rms = f->rms[i];
+
+    float last = 0.0f;
+    int last_onset = 0;
+    for (uint32_t i = 0; i < f->frames; i++) {
+        float norm = max_rms > 0.0f ? f->rms[i] / max_rms : 0.0f;
+        float ratio = last > 0.0f ? norm / last : 1.0f;
+        bool onset = ratio > 1.05f && norm > 0.1f && (int)i - last_onset > 3;
+        if (onset) last_onset = (int)i;
+        last = norm;
+        f->onset[i] = onset ? 1.0f : 0.0f;
+    }
+}
+
+bool audio_features_from_pcm(const int16_t *pcm, uint32_t pcm_frames, uint32_t channels,
+                             uint32_t sample_rate, uint32_t fps, uint32_t frames, audio_features_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (channels != 2 || !pcm_frames || !sample_rate || !fps) return false;
+    // one block for the four arrays, freed through out->rms
+    float *buf = malloc((size_t)frames * 4 * sizeof(float) + 1);
+    if (!buf) return false;
+    out->rms = buf;
+    out->onset = buf + frames;
+    out->bass = buf + 2 * (size_t)frames;
+    out->treble = buf + 3 * (size_t)frames;
+    out->fps = fps;
+    out->frames = frames;
+
+    const uint32_t window = sample_rate / AF_WINDOW_DIV;
+    const uint32_t hop = sample_rate / fps;
+    uint64_t energy = 0;     // sum of m^2 (m = l + r) over the window [ws, we)
+    uint32_t ws = 0, we = 0;
+    int32_t box = 0;         // band split's moving sum, carried across hops
+    uint32_t pos = 0;        // next PCM frame through the band split
+    float max_bass = 0.0f, max_treble = 0.0f;
+
+    for (uint32_t i = 0; i < frames; i++) {
+        // Window placement exactly as calculate_audio_level_at_frame
+        uint32_t idx = (uint32_t)((float)i / (float)fps * (float)sample_rate);
+        if (idx >= pcm_frames) idx = pcm_frames - 1;
+        uint32_t start = idx > window / 2 ? idx - window / 2 : 0;
+        uint32_t end = start + window;
+        if (end > pcm_frames) {
+            end = pcm_frames;
+            start = end > window ? end - window : 0;
+        }
+        // Slide: add the frames that entered, drop the ones that left
+        if (start >= we || start < ws || end < we) {
+            energy = pcm16_mono_energy(pcm + 2 * (size_t)start, end - start);
+        } else {
+            energy += pcm16_mono_energy(pcm + 2 * (size_t)we, end - we);
+            energy -= pcm16_mono_energy(pcm + 2 * (size_t)ws, start - ws);
+        }
+        ws = start;
+        we = end;
+        // m^2 / 2^32 is the normalized mono sample ((l + r) / 2 / 32768) squared
+        float sum_squares = (float)((double)energy * (1.0 / 4294967296.0));
+        out->rms[i] = end > start ? sqrtf(sum_squares / (end - start)) : 0.0f;
+
+        uint64_t next = (uint64_t)(i + 1) * hop;
+        uint32_t hop_end = next < pcm_frames ? (uint32_t)next : pcm_frames;
+        // Bass/treble over the frame's own hop of PCM (exact integer energies)
+        uint64_t low_energy = 0, high_energy = 0;
+        uint32_t n = hop_end > pos ? hop_end - pos : 0;
+        pcm16_band_energy(pcm, pos, n, &box, &low_energy, &high_energy);
+        pos += n;
+        // back to normalized mono units: / PCM16_BAND_TAPS / 65536
+        float bass = n ? sqrtf((float)((double)low_energy / n)) / (PCM16_BAND_TAPS * 65536.0f) : 0.0f;
+        float treble = n ? sqrtf((float)((double)high_energy / n)) / (PCM16_BAND_TAPS * 65536.0f) : 0.0f;
+        out->bass[i] = bass;
+        out->treble[i] = treble;
+        if (bass > max_bass) max_bass = bass;
+        if (treble > max_treble) max_treble = treble;
+    }
+    for (uint32_t i = 0; i < frames; i++) {
+        out->bass[i] = max_bass > 0.0f ? out->bass[i] / max_bass : 0.0f;
+        out->treble[i] = max_treble > 0.0f ? out->treble[i] / max_treble : 0.0f;
+    }
+    af_detect_onsets(out);
+    return true;
+}
+
+int audio_features_save(const char *path, const audio_features_t *f, uint64_t wav_hash) {
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Could not create feature cache %s\n", path);
+        return -1;
+    }
+    af_header_t h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, AF_MAGIC, 4);
+    h.version = AF_VERSION;
+    h.wav_hash = wav_hash;
+    h.fps = f->fps;
+    h.frames = f->frames;
+    size_t n = f->frames;
+    bool ok = fwrite(&h, sizeof(h), 1, file) == 1 &&
+              fwrite(f->rms, sizeof(float), n, file) == n &&
+              fwrite(f->onset, sizeof(float), n, file) == n &&
+              fwrite(f->bass, sizeof(float), n, file) == n &&
+              fwrite(f->treble, sizeof(float), n, file) == n;
+    if (fclose(file) != 0) ok = false;
+    return ok ? 0 : -1;
+}
+
+bool audio_features_load(const char *path, uint64_t wav_hash, uint32_t fps, audio_features_t *out) {
+    memset(out, 0, sizeof(*out));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(af_header_t)) { close(fd); return false; }
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const af_header_t *h = (const af_header_t *)map;
+    if (memcmp(h->magic, AF_MAGIC, 4) != 0 || h->version != AF_VERSION ||
+        h->wav_hash != wav_hash || h->fps != fps ||
+        len != sizeof(*h) + (size_t)h->frames * 4 * sizeof(float)) {
+        munmap(map, len);
+        return false;
+    }
+    float *base = (float *)(h + 1);
+    out->fps = h->fps;
+    out->frames = h->frames;
+    out->rms = base;
+    out->onset = base + h->frames;
+    out->bass = base + 2 * (size_t)h->frames;
+    out->treble = base + 3 * (size_t)h->frames;
+    out->map = map;
+    out->map_len = len;
+    return true;
+}
+
+void audio_features_free(audio_features_t *f) {
+    if (!f) return;
+    if (f->map) munmap(f->map, f->map_len);
+    else free(f->rms);
+    memset(f, 0, sizeof(*f));
+}
@@ -1,14 +1,19 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <math.h>
 #include <stdbool.h>
 #include <time.h>
+#include "include/vis_trig.h"
+#include "include/deterministic_prng.h"
 
 // External audio analysis functions (from wav_reader.c)
 extern float get_audio_rms_for_frame(int frame);
 extern float get_max_rms(void);
 extern float get_audio_bpm(void);
+// Band levels from the reader's load-time analysis; false when unavailable
+extern bool get_audio_bands_for_frame(int frame, float *bass, float *treble);
 
 // External ASM visual functions we can trigger
 extern void spawn_explosion_asm(float cx, float cy, float base_hue);
@@ -24,6 +29,7 @@ typedef struct {
     int last_beat_frame;
     int explosion_cooldown;
     int bass_hit_cooldown;
+    bool event_triggers;   // kicks come from the timeline (vis_triggers), not onsets
 } audio_visual_state_t;
 
 static audio_visual_state_t av_state = {0};
@@ -38,6 +44,25 @@ void init_audio_visual_mapping(void) {
     av_state.last_beat_frame = 0;
     av_state.explosion_cooldown = 0;
     av_state.bass_hit_cooldown = 0;
+    av_state.event_triggers = false;
+}
+
+// The mapping state as bytes, for render checkpoints
+size_t audio_visual_state_bytes(void) {
+    return sizeof(av_state);
+}
+
+void audio_visual_state_save(void *dst) {
+    memcpy(dst, &av_state, sizeof(av_state));
+}
+
+void audio_visual_state_load(const void *src) {
+    memcpy(&av_state, src, sizeof(av_state));
+}
+
+// With a timeline the kick bursts are spawned on its events instead
+void set_audio_visual_event_triggers(bool on) {
+    av_state.event_triggers = on;
 }
 
 // Smooth RMS values to avoid visual jitter
@@ -84,8 +109,12 @@ float get_beat_phase(int frame, float bpm) {
 
 // Get bass frequency energy (low frequencies)
 float get_bass_energy(int frame) {
-    // Simplified: use RMS as proxy for bass energy
-    // In a real system, this would use FFT analysis
+    float bass, treble;
+    if (get_audio_bands_for_frame(frame, &bass, &treble)) {
+        av_state.bass_energy = bass;
+        return bass;
+    }
+    // No analysis for this frame: smoothed RMS as a proxy for bass energy
     float rms = get_audio_rms_for_frame(frame);
     float max_rms = get_max_rms();
     float normalized = (max_rms > 0.0f) ? (rms / max_rms) : 0.0f;
@@ -97,7 +126,12 @@ float get_bass_energy(int frame) {
 
 // Get treble frequency energy (high frequencies)  
 float get_treble_energy(int frame) {
-    // Simplified: use inverted bass energy as proxy
+    float band_bass, band_treble;
+    if (get_audio_bands_for_frame(frame, &band_bass, &band_treble)) {
+        av_state.treble_energy = band_treble;
+        return band_treble;
+    }
+    // Fallback proxy: the level above half the bass estimate
     float bass = get_bass_energy(frame);
     float rms = get_audio_rms_for_frame(frame);
     float max_rms = get_max_rms();
@@ -108,17 +142,22 @@ float get_treble_energy(int frame) {
     return fmaxf(0.0f, av_state.treble_energy);
 }
 
+// Chaos positions repeat for ten frames at a time and do not depend on the
+// seed; counter draws keep them independent of which frames ran before
+#define AV_CHAOS_KEY(frame) ((uint32_t)(frame) / 10)
+
 // 💥 NUCLEAR PARTICLE MAYHEM 💥
 void update_audio_reactive_particles(int frame, float base_hue) {
     float audio_level = get_smoothed_audio_level(frame);
     
     // 🔥 BEAT EXPLOSION FRENZY - Multiple explosions per beat!
-    if (detect_beat_onset(frame)) {
+    if (!av_state.event_triggers && detect_beat_onset(frame)) {
         int explosion_count = (int)(audio_level * 15) + 5; // 5-20 explosions per beat!
         for (int i = 0; i < explosion_count; i++) {
-            float cx = rand() % 800; // Entire screen width
-            float cy = rand() % 600; // Entire screen height
-            float chaos_hue = fmod(base_hue + (i * 0.08f) + (rand() % 100 / 100.0f), 1.0f);
+            uint32_t n = (uint32_t)i * 3;
+            float cx = prng_at_range(0, PRNG_STREAM_AV_BEAT, AV_CHAOS_KEY(frame), n, 800); // Entire screen width
+            float cy = prng_at_range(0, PRNG_STREAM_AV_BEAT, AV_CHAOS_KEY(frame), n + 1, 600); // Entire screen height
+            float chaos_hue = fmod(base_hue + (i * 0.08f) + prng_at_range(0, PRNG_STREAM_AV_BEAT, AV_CHAOS_KEY(frame), n + 2, 100) / 100.0f, 1.0f);
             spawn_explosion_asm(cx, cy, chaos_hue);
         }
     }
@@ -127,7 +166,7 @@ void update_audio_reactive_particles(int frame, float base_hue) {
     if (frame % (int)fmax(1, 6 - audio_level * 5) == 0) {
         for (int i = 0; i < 6; i++) {
             float x = (i * 133) % 800; // Distributed across screen
-            float y = 100 + (rand() % 400);
+            float y = 100 + prng_at_range(0, PRNG_STREAM_AV_WAVE, AV_CHAOS_KEY(frame), i, 400);
             float hue = fmod(frame * 0.03f + i * 0.16f, 1.0f);
             spawn_explosion_asm(x, y, hue);
         }
@@ -138,8 +177,8 @@ void update_audio_reactive_particles(int frame, float base_hue) {
         for (int i = 0; i < 8; i++) {
             float angle = (frame * 0.1f) + (i * 0.785f); // 8 spokes
             float radius = 150 + (audio_level * 100);
-            float cx = 400 + cos(angle) * radius;
-            float cy = 300 + sin(angle) * radius;
+            float cx = 400 + vis_cosf(angle) * radius;
+            float cy = 300 + vis_sinf(angle) * radius;
             if (cx >= 0 && cx < 800 && cy >= 0 && cy < 600) {
                 spawn_explosion_asm(cx, cy, i / 8.0f); // Perfect rainbow
             }
@@ -157,7 +196,7 @@ void update_audio_reactive_bass_hits(int frame, float base_hue) {
         int shape_count = (int)(bass_energy * 12) + 2; // 2-14 shapes
         for (int i = 0; i < shape_count; i++) {
             float cx = (i * 80 + frame * 2) % 800; // Moving across screen
-            float cy = 100 + (rand() % 400);
+            float cy = 100 + prng_at_range(0, PRNG_STREAM_AV_SHAPES, AV_CHAOS_KEY(frame), i, 400);
             int shape_type = (frame + i) % 3; // Cycling through all shapes
             float shape_hue = fmod(base_hue + (i * 0.12f), 1.0f);
             spawn_bass_hit_asm(cx, cy, shape_type, shape_hue);
@@ -183,8 +222,8 @@ void update_audio_reactive_bass_hits(int frame, float base_hue) {
             float radius = 80 + ring * 60 + bass_energy * 50;
             for (int i = 0; i < 6; i++) {
                 float angle = i * 1.047f + frame * 0.05f; // 6 shapes per ring
-                float cx = 400 + cos(angle) * radius;
-                float cy = 300 + sin(angle) * radius;
+                float cx = 400 + vis_cosf(angle) * radius;
+                float cy = 300 + vis_sinf(angle) * radius;
                 if (cx >= 0 && cx < 800 && cy >= 0 && cy < 600) {
                     spawn_bass_hit_asm(cx, cy, ring % 3, ring * 0.25f);
                 }
@@ -209,7 +248,7 @@ float get_audio_driven_glitch_intensity(int frame) {
     float beat_explosion = (beat_phase < 0.15f) ? 1.0f : 0.0f; // Massive beat spikes
     
     // 🌊 Oscillating chaos waves
-    float chaos_wave = sin(frame * 0.1f) * 0.3f + 0.3f;
+    float chaos_wave = vis_sinf(frame * 0.1f) * 0.3f + 0.3f;
     
     float total_chaos = base_chaos + audio_chaos + beat_explosion + chaos_wave;
     return fmaxf(0.0f, fminf(3.0f, total_chaos)); // Allow up to 3x normal intensity!
@@ -227,12 +266,12 @@ float get_audio_driven_hue_shift(int frame) {
     float base_rotation = fmod(time_sec * speed_multiplier * 0.02f, 1.0f);
     
     // 💫 AUDIO-REACTIVE COLOR JUMPS
-    float bass_jump = bass * 0.3f * sin(time_sec * 8.0f);
-    float treble_flicker = get_treble_energy(frame) * 0.2f * sin(time_sec * 20.0f);
+    float bass_jump = bass * 0.3f * vis_sinf(time_sec * 8.0f);
+    float treble_flicker = get_treble_energy(frame) * 0.2f * vis_sinf(time_sec * 20.0f);
     
     // 🌊 CHAOS WAVE MODULATION
-    float chaos_wave1 = sin(time_sec * 3.0f) * 0.15f;
-    float chaos_wave2 = cos(time_sec * 7.0f) * 0.1f;
+    float chaos_wave1 = vis_sinf(time_sec * 3.0f) * 0.15f;
+    float chaos_wave2 = vis_cosf(time_sec * 7.0f) * 0.1f;
     
     float total_hue = base_rotation + bass_jump + treble_flicker + chaos_wave1 + chaos_wave2;
     return fmod(total_hue, 1.0f);
@@ -240,9 +279,6 @@ float get_audio_driven_hue_shift(int frame) {
 
 // 🌋 NUCLEAR CHAOS MODE - EVERYTHING AT MAXIMUM! 🌋
 void update_audio_visual_effects(int frame, float base_hue) {
-    // Seed random for consistent chaos across frames
-    srand(frame / 10);
-    
     // Update chaos particle effects
     update_audio_reactive_particles(frame, base_hue);
     
@@ -269,8 +305,8 @@ void update_audio_visual_effects(int frame, float base_hue) {
         for (int i = 0; i < 12; i++) {
             float angle = i * 0.524f + frame * 0.05f; // 12 spokes
             float radius = 200 + audio_level * 150;
-            float x = 400 + cos(angle) * radius;
-            float y = 300 + sin(angle) * radius;
+            float x = 400 + vis_cosf(angle) * radius;
+            float y = 300 + vis_sinf(angle) * radius;
             if (x >= 0 && x < 800 && y >= 0 && y < 600) {
                 spawn_bass_hit_asm(x, y, i % 3, i / 12.0f);
             }
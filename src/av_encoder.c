@@ -0,0 +1,292 @@
+#include "include/av_encoder.h"
+#include "c/include/pcm16.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/mathematics.h>
+#include <libavutil/opt.h>
+
+#define AV_AUDIO_BITRATE 128000   // ffmpeg's AAC default
+
+struct av_encoder {
+    AVFormatContext *oc;
+    AVCodecContext *venc, *aenc;    // aenc NULL for a silent render
+    AVStream *vst, *ast;
+    AVBufferPool *pool;             // YUV planes of the frames x264 still holds
+    AVFrame *aframe;
+    AVPacket *pkt;
+    frame_writer_t *fw;
+    int fps;
+    int64_t next_pts;               // video frames sent
+
+    const int16_t *pcm;
+    uint32_t pcm_frames, sample_rate;
+    int channels;
+    int64_t audio_pos;              // PCM frames sent
+
+    bool header_written;
+    int error;                      // sticky: first failure
+};
+
+static void av_error(const char *what, int err) {
+    char buf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(err, buf, sizeof(buf));
+    fprintf(stderr, "av_encoder: %s: %s\n", what, buf);
+}
+
+// Send `frame` (NULL flushes) and mux every packet the encoder has ready
+static int encode(av_encoder_t *e, AVCodecContext *enc, AVStream *st, AVFrame *frame) {
+    int rc = avcodec_send_frame(enc, frame);
+    if (rc < 0) {
+        av_error("send frame", rc);
+        return -1;
+    }
+    for (;;) {
+        rc = avcodec_receive_packet(enc, e->pkt);
+        if (rc == AVERROR(EAGAIN) || rc == AVERROR_EOF) return 0;
+        if (rc < 0) {
+            av_error("encode", rc);
+            return -1;
+        }
+        av_packet_rescale_ts(e->pkt, enc->time_base, st->time_base);
+        e->pkt->stream_index = st->index;
+        rc = av_interleaved_write_frame(e->oc, e->pkt);   // takes the packet's data
+        if (rc < 0) {
+            av_error("write packet", rc);
+            return -1;
+        }
+    }
+}
+
+// AAC frames of PCM up to frame `until`; with `flush` the short tail too
+static int feed_audio(av_encoder_t *e, int64_t until, bool flush) {
+    int size = e->aenc->frame_size;
+    while (e->audio_pos + size <= until || (flush && e->audio_pos < until)) {
+        int n = until - e->audio_pos < size ? (int)(until - e->audio_pos) : size;
+        int rc = av_frame_make_writable(e->aframe);
+        if (rc < 0) {
+            av_error("audio frame", rc);
+            return -1;
+        }
+        // s16 interleaved -> planar float, the conversion ffmpeg's resampler does
+        const int16_t *src = e->pcm + (size_t)e->audio_pos * e->channels;
+        if (e->channels == 2) {
+            pcm16_deinterleave(src, (float *)e->aframe->data[0], (float *)e->aframe->data[1], (uint32_t)n);
+        } else if (e->channels == 1) {
+            pcm16_to_float(src, (float *)e->aframe->data[0], (uint32_t)n);
+        } else {
+            for (int c = 0; c < e->channels; c++) {
+                float *dst = (float *)e->aframe->data[c];
+                for (int i = 0; i < n; i++) dst[i] = src[(size_t)i * e->channels + c] * (1.0f / 32768.0f);
+            }
+        }
+        e->aframe->nb_samples = n;
+        e->aframe->pts = e->audio_pos;
+        e->audio_pos += n;
+        if (encode(e, e->aenc, e->ast, e->aframe) != 0) return -1;
+    }
+    return 0;
+}
+
+// PCM frames that play under the video sent so far (ffmpeg -shortest)
+static int64_t audio_until(const av_encoder_t *e) {
+    int64_t t = av_rescale(e->next_pts, e->sample_rate, e->fps);
+    return t < e->pcm_frames ? t : e->pcm_frames;
+}
+
+int av_encoder_video(av_encoder_t *e, const uint32_t *pixels, const frame_tiles_t *tiles) {
+    if (e->error) return -1;
+    int w = e->venc->width, h = e->venc->height;
+    AVFrame *f = av_frame_alloc();
+    AVBufferRef *buf = f ? av_buffer_pool_get(e->pool) : NULL;
+    if (!buf) {
+        fprintf(stderr, "av_encoder: out of memory\n");
+        av_frame_free(&f);
+        e->error = 1;
+        return -1;
+    }
+    // The frame owns a pooled buffer, so libavcodec keeps a reference
+    // instead of copying it; pack the framebuffer straight into its planes
+    f->buf[0] = buf;
+    f->data[0] = buf->data;
+    f->data[1] = buf->data + (size_t)w * h;
+    f->data[2] = f->data[1] + (size_t)w * h / 4;
+    f->linesize[0] = w;
+    f->linesize[1] = f->linesize[2] = w / 2;
+    f->format = AV_PIX_FMT_YUV420P;
+    f->width = w;
+    f->height = h;
+    f->color_range = AVCOL_RANGE_MPEG;
+    frame_writer_pack_frame(e->fw, pixels, tiles, buf->data);
+    f->pts = e->next_pts++;
+
+    int rc = encode(e, e->venc, e->vst, f);
+    av_frame_free(&f);
+    if (rc == 0 && e->aenc) rc = feed_audio(e, audio_until(e), false);
+    if (rc != 0) e->error = 1;
+    return rc;
+}
+
+static int av_encoder_sink(void *ctx, const uint32_t *pixels, const frame_tiles_t *tiles) {
+    return av_encoder_video((av_encoder_t *)ctx, pixels, tiles);
+}
+
+// Codec parameters into the stream, after avcodec_open2
+static bool add_stream(av_encoder_t *e, AVCodecContext *enc, AVStream **out) {
+    AVStream *st = avformat_new_stream(e->oc, NULL);
+    if (!st) return false;
+    int rc = avcodec_parameters_from_context(st->codecpar, enc);
+    if (rc < 0) {
+        av_error("stream parameters", rc);
+        return false;
+    }
+    st->time_base = enc->time_base;
+    *out = st;
+    return true;
+}
+
+static AVCodecContext *open_video(av_encoder_t *e, int width, int height, const av_encoder_opts_t *opt) {
+    const AVCodec *codec = avcodec_find_encoder_by_name("libx264");
+    if (!codec) {
+        fprintf(stderr, "av_encoder: libavcodec was built without libx264\n");
+        return NULL;
+    }
+    AVCodecContext *c = avcodec_alloc_context3(codec);
+    if (!c) return NULL;
+    c->width = width;
+    c->height = height;
+    c->time_base = (AVRational){1, e->fps};
+    c->framerate = (AVRational){e->fps, 1};
+    c->pix_fmt = AV_PIX_FMT_YUV420P;
+    c->color_range = AVCOL_RANGE_MPEG;
+    c->thread_count = opt->threads;
+    av_opt_set(c->priv_data, "preset", opt->preset ? opt->preset : "medium", 0);
+    if (opt->crf >= 0) av_opt_set_double(c->priv_data, "crf", opt->crf, 0);
+    if (e->oc->oformat->flags & AVFMT_GLOBALHEADER) c->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    int rc = avcodec_open2(c, codec, NULL);
+    if (rc < 0) {
+        av_error("open libx264", rc);
+        avcodec_free_context(&c);
+    }
+    return c;
+}
+
+static AVCodecContext *open_audio(av_encoder_t *e, const av_encoder_opts_t *opt) {
+    const AVCodec *codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+    if (!codec) {
+        fprintf(stderr, "av_encoder: no AAC encoder in libavcodec\n");
+        return NULL;
+    }
+    AVCodecContext *c = avcodec_alloc_context3(codec);
+    if (!c) return NULL;
+    c->sample_fmt = AV_SAMPLE_FMT_FLTP;
+    c->sample_rate = (int)e->sample_rate;
+    av_channel_layout_default(&c->ch_layout, e->channels);
+    c->bit_rate = opt->audio_bitrate > 0 ? opt->audio_bitrate : AV_AUDIO_BITRATE;
+    c->time_base = (AVRational){1, (int)e->sample_rate};
+    if (e->oc->oformat->flags & AVFMT_GLOBALHEADER) c->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    int rc = avcodec_open2(c, codec, NULL);
+    if (rc < 0) {
+        av_error("open aac", rc);
+        avcodec_free_context(&c);
+        return NULL;
+    }
+    e->aframe = av_frame_alloc();
+    if (!e->aframe) return c;   // caught by the caller's aframe check
+    e->aframe->format = c->sample_fmt;
+    e->aframe->sample_rate = c->sample_rate;
+    e->aframe->nb_samples = c->frame_size;
+    av_channel_layout_copy(&e->aframe->ch_layout, &c->ch_layout);
+    if (av_frame_get_buffer(e->aframe, 0) < 0) av_frame_free(&e->aframe);
+    return c;
+}
+
+static void av_encoder_free(av_encoder_t *e) {
+    if (e->fw && e->fw->sink_ctx == e) {
+        e->fw->sink = NULL;
+        e->fw->sink_ctx = NULL;
+    }
+    avcodec_free_context(&e->venc);
+    avcodec_free_context(&e->aenc);
+    av_frame_free(&e->aframe);
+    av_packet_free(&e->pkt);
+    av_buffer_pool_uninit(&e->pool);
+    if (e->oc) {
+        if (e->oc->pb && !(e->oc->oformat->flags & AVFMT_NOFILE)) avio_closep(&e->oc->pb);
+        avformat_free_context(e->oc);
+    }
+    free(e);
+}
+
+av_encoder_t *av_encoder_open(const char *path, frame_writer_t *fw, int fps,
+                              const int16_t *pcm, uint32_t frames, uint32_t sample_rate,
+                              int channels, const av_encoder_opts_t *opt) {
+    static const av_encoder_opts_t defaults = AV_ENCODER_OPTS_DEFAULT;
+    if (!opt) opt = &defaults;
+    if (fw->fmt != FRAME_FMT_Y4M) {
+        fprintf(stderr, "av_encoder: needs a Y4M (YUV 4:2:0) frame writer\n");
+        return NULL;
+    }
+    av_encoder_t *e = calloc(1, sizeof(*e));
+    if (!e) return NULL;
+    e->fw = fw;
+    e->fps = fps;
+    e->pcm = pcm;
+    e->pcm_frames = pcm ? frames : 0;
+    e->sample_rate = sample_rate;
+    e->channels = channels;
+
+    int rc = avformat_alloc_output_context2(&e->oc, NULL, NULL, path);
+    if (rc < 0) {
+        av_error(path, rc);
+        goto fail;
+    }
+    if (!(e->venc = open_video(e, fw->width, fw->height, opt)) || !add_stream(e, e->venc, &e->vst)) goto fail;
+    if (e->pcm_frames) {
+        if (!(e->aenc = open_audio(e, opt)) || !e->aframe || !add_stream(e, e->aenc, &e->ast)) goto fail;
+    }
+    size_t yuv_len = (size_t)fw->width * fw->height * 3 / 2;
+    e->pool = av_buffer_pool_init(yuv_len + AV_INPUT_BUFFER_PADDING_SIZE, NULL);
+    e->pkt = av_packet_alloc();
+    if (!e->pool || !e->pkt) {
+        fprintf(stderr, "av_encoder: out of memory\n");
+        goto fail;
+    }
+    if (!(e->oc->oformat->flags & AVFMT_NOFILE) && (rc = avio_open(&e->oc->pb, path, AVIO_FLAG_WRITE)) < 0) {
+        av_error(path, rc);
+        goto fail;
+    }
+    if ((rc = avformat_write_header(e->oc, NULL)) < 0) {
+        av_error("write header", rc);
+        goto fail;
+    }
+    e->header_written = true;
+    fw->sink = av_encoder_sink;
+    fw->sink_ctx = e;
+    return e;
+
+fail:
+    av_encoder_free(e);
+    return NULL;
+}
+
+int av_encoder_close(av_encoder_t *e) {
+    if (!e) return -1;
+    int rc = e->error ? -1 : 0;
+    if (rc == 0 && e->aenc) rc = feed_audio(e, audio_until(e), true);
+    if (rc == 0) rc = encode(e, e->venc, e->vst, NULL);
+    if (rc == 0 && e->aenc) rc = encode(e, e->aenc, e->ast, NULL);
+    // The trailer is written even after a failure, so the file is closed cleanly
+    if (e->header_written) {
+        int trc = av_write_trailer(e->oc);
+        if (trc < 0) {
+            av_error("write trailer", trc);
+            rc = -1;
+        }
+    }
+    av_encoder_free(e);
+    return rc;
+}
@@ -0,0 +1,430 @@
+// bench_visual – time each visual asm kernel in isolation and guard its art.
+//
+// Every kernel runs over a fixed table of call arguments derived from
+// BENCH_SEED.  Timing repeats the table until a batch takes long enough to
+// measure and reports the best of BENCH_REPS batches as ns/call; MPix/s uses
+// the pixels a call actually changes (measured once against a sentinel
+// fill), not the kernel's bounding box.  Separately, each kernel draws the
+// first BENCH_GOLDEN_CALLS calls of its table into a cleared framebuffer,
+// and the FNV-1a hash of the result is checked against a golden file, so a
+// faster kernel that draws different pixels fails the run.
+//
+// Where the kernel counts them (Linux perf events), the dTLB read misses
+// of one pass over the table are reported twice: on a framebuffer of 4K
+// pages and on one padded to a 2 MB page with BUF_HUGE, as the frame queue
+// ring allocates it; the difference is what huge pages save a kernel.
+//
+// Usage: bench_visual [--check golden.txt | --record golden.txt] [kernel-filter]
+//   make bench_visual          check against golden/bench_visual.txt
+//   make bench_visual_record   rewrite it (on ARM64, from a known-good tree)
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "visual_types.h"
+#include "frame_writer.h"
+#include "vis_color.h"
+#include "vis_terrain.h"
+#include "vis_boss.h"
+#include "buf_alloc.h"
+
+extern uint32_t *vis_dirty_tiles;
+extern void clear_frame_asm(uint32_t *pixels, uint32_t color);
+extern void draw_ascii_char_asm(uint32_t *pixels, int x, int y, char c, uint32_t color, int bg_alpha);
+extern void draw_circle_filled_asm(uint32_t *pixels, int cx, int cy, int radius, uint32_t color);
+extern void draw_ascii_triangle_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
+extern void draw_ascii_diamond_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
+extern void draw_ascii_hexagon_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
+extern void draw_ascii_star_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
+extern void draw_ascii_square_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
+extern void init_terrain_asm(uint32_t seed, float base_hue);
+extern void draw_terrain_enhanced_asm(uint32_t *pixels, int frame, float audio_level);
+extern void init_glitch_system_asm(uint32_t seed, float intensity);
+extern void init_bass_hits_asm(void);
+extern void spawn_bass_hit_asm(float base_hue, uint32_t seed);
+extern void draw_bass_hits_asm(uint32_t *pixels, int frame);
+
+#define BENCH_SEED          0xcafebabeu
+#define BENCH_ARGS          256         // call table entries per kernel
+#define BENCH_GOLDEN_CALLS  64          // calls hashed for the golden check
+#define BENCH_COVER_CALLS   16          // calls measured for MPix/s
+#define BENCH_REPS          3
+#define BENCH_MIN_SEC       0.05        // shortest batch worth timing
+#define BENCH_SENTINEL      0x5A3C96E1u
+#define BENCH_PIXELS        (VIS_WIDTH * VIS_HEIGHT)
+
+typedef struct {
+    int x, y, size, alpha, frame;
+    float rotation, level;
+    uint32_t color;
+    char ch;
+} bench_args_t;
+
+typedef struct {
+    const char *name;
+    void (*setup)(void);                // module state; NULL if stateless
+    void (*call)(uint32_t *pixels, const bench_args_t *a);
+} bench_kernel_t;
+
+static bench_args_t g_args[BENCH_ARGS];
+static frame_tiles_t g_tiles;
+static frame_writer_t g_ppm;
+static int g_null_fd = -1;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// ---- dTLB read misses (-1: not counted on this system) ----
+#ifdef __linux__
+static int tlb_open(void) {
+    struct perf_event_attr a;
+    memset(&a, 0, sizeof(a));
+    a.size = sizeof(a);
+    a.type = PERF_TYPE_HW_CACHE;
+    a.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    a.disabled = 1;
+    a.exclude_kernel = 1;
+    a.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+}
+
+static void tlb_start(int fd) {
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+static uint64_t tlb_stop(int fd) {
+    uint64_t v = 0;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if (read(fd, &v, sizeof(v)) != (ssize_t)sizeof(v)) v = 0;
+    return v;
+}
+#else
+static int tlb_open(void) { return -1; }
+static void tlb_start(int fd) { (void)fd; }
+static uint64_t tlb_stop(int fd) { (void)fd; return 0; }
+#endif
+
+static uint32_t xorshift32(uint32_t *s) {
+    uint32_t x = *s;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return *s = x;
+}
+
+static uint64_t fnv1a(const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < len; i++) h = (h ^ p[i]) * 0x100000001b3ull;
+    return h;
+}
+
+// Arguments spread over the whole frame, a few off the edges to hit clipping
+static void make_args(void) {
+    uint32_t s = BENCH_SEED;
+    for (int i = 0; i < BENCH_ARGS; i++) {
+        bench_args_t *a = &g_args[i];
+        a->x = (int)(xorshift32(&s) % (VIS_WIDTH + 64)) - 32;
+        a->y = (int)(xorshift32(&s) % (VIS_HEIGHT + 64)) - 32;
+        a->size = 8 + (int)(xorshift32(&s) % 72);
+        a->alpha = (i & 3) ? 255 : 128;
+        a->frame = i;
+        a->rotation = (float)(xorshift32(&s) % 6283) / 1000.0f;
+        a->level = (float)(xorshift32(&s) % 1000) / 1000.0f;
+        a->color = 0xFF000000u | (xorshift32(&s) & 0x00FFFFFFu);
+        a->ch = (char)(33 + xorshift32(&s) % 94);
+    }
+}
+
+// ---- Kernels -------------------------------------------------------------
+
+static void call_clear(uint32_t *p, const bench_args_t *a) { clear_frame_asm(p, a->color); }
+static void call_char(uint32_t *p, const bench_args_t *a) { draw_ascii_char_asm(p, a->x, a->y, a->ch, a->color, a->alpha); }
+static void call_circle(uint32_t *p, const bench_args_t *a) { draw_circle_filled_asm(p, a->x, a->y, a->size / 2, a->color); }
+
+#define SHAPE_CALL(shape) \
+    static void call_##shape(uint32_t *p, const bench_args_t *a) { \
+        draw_ascii_##shape##_asm(p, a->x, a->y, a->size, a->rotation, a->color, a->alpha, a->frame); \
+    }
+SHAPE_CALL(triangle)
+SHAPE_CALL(diamond)
+SHAPE_CALL(hexagon)
+SHAPE_CALL(star)
+SHAPE_CALL(square)
+
+static void setup_terrain(void) {
+    srand(BENCH_SEED);
+    init_glitch_system_asm(BENCH_SEED, 0.5f);
+    init_terrain_asm(BENCH_SEED, 0.6f);
+}
+
+static void call_terrain(uint32_t *p, const bench_args_t *a) { draw_terrain_enhanced_asm(p, a->frame, a->level); }
+
+// The same terrain through the precomputed strip (src/vis_terrain.c)
+static vis_terrain_strip_t g_strip;
+
+static void setup_terrain_strip(void) {
+    setup_terrain();
+    vis_terrain_strip_init(&g_strip);
+}
+
+static void call_terrain_strip(uint32_t *p, const bench_args_t *a) { vis_terrain_strip_draw(&g_strip, p, a->frame, a->level); }
+
+// Boss shapes at the boss's sizes, through the kernels and through their
+// sprites (src/vis_boss.c): the two goldens must be equal
+#define BOSS_SHAPE(a) ((a)->frame % 5)
+#define BOSS_SIZE(a)  (12 + (a)->size / 2)
+static vis_boss_sprite_t g_boss[BENCH_ARGS];
+
+static void setup_boss_shapes(void) {
+    init_glitch_system_asm(BENCH_SEED, 0.5f);
+}
+
+static void call_boss_shapes(uint32_t *p, const bench_args_t *a) {
+    vis_boss_shape_draw(p, a->x, a->y, BOSS_SHAPE(a), BOSS_SIZE(a), a->rotation, a->color, a->frame);
+}
+
+static void setup_boss_sprites(void) {
+    uint32_t *scratch = calloc(2 * (size_t)BENCH_PIXELS, sizeof(uint32_t));
+    for (int i = 0; i < BENCH_ARGS; i++) {
+        const bench_args_t *a = &g_args[i];
+        vis_boss_sprite_build(&g_boss[i], BOSS_SHAPE(a), BOSS_SIZE(a), a->rotation, scratch);
+    }
+    free(scratch);
+    init_glitch_system_asm(BENCH_SEED, 0.5f);
+}
+
+static void call_boss_sprites(uint32_t *p, const bench_args_t *a) {
+    vis_boss_sprite_draw(&g_boss[a - g_args], p, a->x, a->y, a->color, a->frame);
+}
+
+// A full set of hits: fixed hues, and shapes and positions from the seed
+// as the step clock passes it (vis_triggers.c)
+static void setup_bass_hits(void) {
+    srand(BENCH_SEED);
+    init_glitch_system_asm(BENCH_SEED, 0.5f);
+    init_bass_hits_asm();
+    for (int i = 0; i < 16; i++)
+        spawn_bass_hit_asm((float)i / 16.0f, BENCH_SEED + (uint32_t)i);
+}
+
+static void call_bass_hits(uint32_t *p, const bench_args_t *a) { draw_bass_hits_asm(p, a->frame); }
+
+// Whole-frame PPM pack and write(2) to /dev/null
+static void call_ppm(uint32_t *p, const bench_args_t *a) {
+    (void)a;
+    if (frame_writer_emit(&g_ppm, g_null_fd, p, NULL) != 0) {
+        fprintf(stderr, "bench_visual: PPM write failed\n");
+        exit(1);
+    }
+}
+
+static const bench_kernel_t g_kernels[] = {
+    { "clear_frame_asm",           NULL,            call_clear },
+    { "draw_ascii_char_asm",       NULL,            call_char },
+    { "draw_circle_filled_asm",    NULL,            call_circle },
+    { "draw_ascii_triangle_asm",   NULL,            call_triangle },
+    { "draw_ascii_diamond_asm",    NULL,            call_diamond },
+    { "draw_ascii_hexagon_asm",    NULL,            call_hexagon },
+    { "draw_ascii_star_asm",       NULL,            call_star },
+    { "draw_ascii_square_asm",     NULL,            call_square },
+    { "draw_terrain_enhanced_asm", setup_terrain,   call_terrain },
+    { "vis_terrain_strip_draw",    setup_terrain_strip, call_terrain_strip },
+    { "boss_shapes_asm",           setup_boss_shapes, call_boss_shapes },
+    { "vis_boss_sprite_draw",      setup_boss_sprites, call_boss_sprites },
+    { "draw_bass_hits_asm",        setup_bass_hits, call_bass_hits },
+    { "frame_writer_emit_ppm",     NULL,            call_ppm },
+};
+
+#define NUM_KERNELS ((int)(sizeof(g_kernels) / sizeof(g_kernels[0])))
+
+// ---- Driver --------------------------------------------------------------
+
+static void reset_frame(uint32_t *pixels, uint32_t fill) {
+    for (int i = 0; i < BENCH_PIXELS; i++) pixels[i] = fill;
+    memset(&g_tiles, 0, sizeof(g_tiles));
+}
+
+// Framebuffer hash after the first BENCH_GOLDEN_CALLS calls; the PPM case
+// hashes the emitted stream of a fixed test pattern instead
+static uint64_t golden_hash(const bench_kernel_t *k, uint32_t *pixels) {
+    if (k->call == call_ppm) {
+        uint32_t s = BENCH_SEED;
+        for (int i = 0; i < BENCH_PIXELS; i++) pixels[i] = xorshift32(&s);
+        char path[] = "/tmp/bench_visual_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) { perror("mkstemp"); exit(1); }
+        unlink(path);
+        if (frame_writer_emit(&g_ppm, fd, pixels, NULL) != 0) { close(fd); return 0; }
+        size_t len = g_ppm.frame_len;
+        uint8_t *buf = malloc(len);
+        uint64_t h = 0;
+        if (buf && pread(fd, buf, len, 0) == (ssize_t)len) h = fnv1a(buf, len);
+        free(buf);
+        close(fd);
+        return h;
+    }
+    if (k->setup) k->setup();
+    reset_frame(pixels, 0);
+    for (int i = 0; i < BENCH_GOLDEN_CALLS; i++) k->call(pixels, &g_args[i]);
+    return fnv1a(pixels, (size_t)BENCH_PIXELS * sizeof(uint32_t));
+}
+
+// Mean pixels one call changes, from single calls over a sentinel fill
+static double pixels_per_call(const bench_kernel_t *k, uint32_t *pixels) {
+    if (k->call == call_ppm) return BENCH_PIXELS;
+    if (k->setup) k->setup();
+    uint64_t changed = 0;
+    for (int i = 0; i < BENCH_COVER_CALLS; i++) {
+        reset_frame(pixels, BENCH_SENTINEL);
+        k->call(pixels, &g_args[i]);
+        for (int p = 0; p < BENCH_PIXELS; p++) changed += pixels[p] != BENCH_SENTINEL;
+    }
+    return (double)changed / BENCH_COVER_CALLS;
+}
+
+// Best ns/call over BENCH_REPS batches of whole argument tables
+static double time_kernel(const bench_kernel_t *k, uint32_t *pixels) {
+    if (k->setup) k->setup();
+    reset_frame(pixels, 0);
+    int tables = 1;
+    for (;;) {
+        double t0 = now_sec();
+        for (int t = 0; t < tables; t++)
+            for (int i = 0; i < BENCH_ARGS; i++) k->call(pixels, &g_args[i]);
+        if (now_sec() - t0 >= BENCH_MIN_SEC || tables >= (1 << 20)) break;
+        tables *= 2;
+    }
+    double best = 1e30;
+    for (int r = 0; r < BENCH_REPS; r++) {
+        double t0 = now_sec();
+        for (int t = 0; t < tables; t++)
+            for (int i = 0; i < BENCH_ARGS; i++) k->call(pixels, &g_args[i]);
+        double dt = now_sec() - t0;
+        if (dt < best) best = dt;
+    }
+    return best * 1e9 / ((double)tables * BENCH_ARGS);
+}
+
+// Mean dTLB read misses per call over one argument table drawn into `pixels`
+static double tlb_per_call(const bench_kernel_t *k, uint32_t *pixels, int tlb) {
+    if (k->call == call_ppm) {
+        uint32_t s = BENCH_SEED;
+        for (int i = 0; i < BENCH_PIXELS; i++) pixels[i] = xorshift32(&s);
+        tlb_start(tlb);
+        k->call(pixels, &g_args[0]);
+        return (double)tlb_stop(tlb);
+    }
+    if (k->setup) k->setup();
+    reset_frame(pixels, 0);
+    tlb_start(tlb);
+    for (int i = 0; i < BENCH_ARGS; i++) k->call(pixels, &g_args[i]);
+    return (double)tlb_stop(tlb) / BENCH_ARGS;
+}
+
+// Golden hash for `name` from `path`; false if the file or entry is missing
+static bool golden_lookup(const char *path, const char *name, uint64_t *hash) {
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+    char line[256], key[128];
+    unsigned long long h;
+    bool found = false;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%127s %llx", key, &h) == 2 && strcmp(key, name) == 0) {
+            *hash = (uint64_t)h;
+            found = true;
+            break;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+int main(int argc, char **argv) {
+    const char *check = NULL, *record = NULL, *filter = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--check") == 0 && i + 1 < argc) check = argv[++i];
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) record = argv[++i];
+        else if (argv[i][0] != '-') filter = argv[i];
+        else {
+            fprintf(stderr, "Usage: %s [--check golden.txt | --record golden.txt] [kernel-filter]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // A frame is just under 2 MB: the huge-page copy is padded to one
+    size_t frame_bytes = (size_t)BENCH_PIXELS * sizeof(uint32_t);
+    uint32_t *pixels = buf_alloc(0, frame_bytes, 0);
+    uint32_t *huge = buf_alloc(0, frame_bytes > BUF_HUGE_PAGE ? frame_bytes : BUF_HUGE_PAGE, BUF_HUGE);
+    g_null_fd = open("/dev/null", O_WRONLY);
+    if (!pixels || !huge || g_null_fd < 0 || !frame_writer_init(&g_ppm, FRAME_FMT_PPM, VIS_WIDTH, VIS_HEIGHT, 60)) {
+        fprintf(stderr, "bench_visual: setup failed\n");
+        return 1;
+    }
+    vis_dirty_tiles = g_tiles.rows;
+    make_args();
+
+    FILE *out = NULL;
+    if (record) {
+        out = fopen(record, "w");
+        if (!out) { perror(record); return 1; }
+        fprintf(out, "# bench_visual goldens: FNV-1a of the framebuffer after %d calls, seed 0x%08x\n",
+                BENCH_GOLDEN_CALLS, BENCH_SEED);
+    }
+
+    int tlb = tlb_open();
+    static const char *huge_kind[] = { "normal pages", "THP advised", "MAP_HUGETLB" };
+    printf("bench_visual: dTLB misses %s, 2M frame on %s\n", tlb >= 0 ? "counted" : "unavailable",
+           huge_kind[buf_alloc_huge(huge)]);
+    int failed = 0, missing = 0;
+    printf("%-26s %12s %10s %12s %10s %10s %18s  %s\n", "kernel", "ns/call", "pix/call", "MPix/s",
+           "dTLB 4K", "dTLB 2M", "hash", "golden");
+    for (int i = 0; i < NUM_KERNELS; i++) {
+        const bench_kernel_t *k = &g_kernels[i];
+        if (filter && !strstr(k->name, filter)) continue;
+        uint64_t hash = golden_hash(k, pixels), want;
+        double pix = pixels_per_call(k, pixels);
+        double ns = time_kernel(k, pixels);
+        char tlb4k[16] = "-", tlb2m[16] = "-";
+        if (tlb >= 0) {
+            snprintf(tlb4k, sizeof(tlb4k), "%.2f", tlb_per_call(k, pixels, tlb));
+            snprintf(tlb2m, sizeof(tlb2m), "%.2f", tlb_per_call(k, huge, tlb));
+        }
+        const char *verdict = "-";
+        if (record) {
+            fprintf(out, "%s %016llx\n", k->name, (unsigned long long)hash);
+            verdict = "recorded";
+        } else if (check) {
+            if (!golden_lookup(check, k->name, &want)) { verdict = "missing"; missing++; }
+            else if (want == hash) verdict = "ok";
+            else { verdict = "MISMATCH"; failed++; }
+        }
+        printf("%-26s %12.1f %10.0f %12.1f %10s %10s   %016llx  %s\n", k->name, ns, pix,
+               ns > 0.0 ? pix * 1e3 / ns : 0.0, tlb4k, tlb2m, (unsigned long long)hash, verdict);
+    }
+
+    fflush(stdout);
+    if (out && fclose(out) != 0) { perror(record); return 1; }
+    if (missing) fprintf(stderr, "bench_visual: %d kernel(s) have no golden in %s (make bench_visual_record)\n", missing, check);
+    if (failed) fprintf(stderr, "bench_visual: %d kernel(s) changed their output\n", failed);
+    frame_writer_free(&g_ppm);
+    close(g_null_fd);
+    if (tlb >= 0) close(tlb);
+    buf_free(pixels);
+    buf_free(huge);
+    return failed ? 1 : 0;
+}
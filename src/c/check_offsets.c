@@ -11,11 +11,15 @@ int main() {
     printf("  mel: %zu\n", offsetof(generator_t, mel));
     printf("  mid_fm: %zu\n", offsetof(generator_t, mid_fm));
     printf("  bass_fm: %zu\n", offsetof(generator_t, bass_fm));
-    printf("  q: %zu\n", offsetof(generator_t, q));
+    printf("  plan: %zu\n", offsetof(generator_t, plan));
     printf("  event_idx: %zu\n", offsetof(generator_t, event_idx));
     printf("  step: %zu\n", offsetof(generator_t, step));
     printf("  pos_in_step: %zu\n", offsetof(generator_t, pos_in_step));
+    printf("  event_end: %zu\n", offsetof(generator_t, event_end));
     printf("  delay: %zu\n", offsetof(generator_t, delay));
     printf("  limiter: %zu\n", offsetof(generator_t, limiter));
+    printf("  scratch: %zu\n", offsetof(generator_t, scratch));
+    printf("  scratch_frames: %zu\n", offsetof(generator_t, scratch_frames));
+    printf("  active_voices: %zu\n", offsetof(generator_t, active_voices));
     return 0;
 }
@@ -0,0 +1,33 @@
+#ifndef BUF_ALLOC_H
+#define BUF_ALLOC_H
+
+#include <stddef.h>
+
+/*
+ * Large working buffers (framebuffer rings, delay lines, the generator's
+ * scratch arena).  Every block starts on at least a BUF_ALIGN boundary, so
+ * the SIMD kernels' full-width loads never straddle a cache line.
+ *
+ * BUF_HUGE asks for 2 MB pages when the block spans one: MAP_HUGETLB
+ * reserved pages first, else a 2 MB-aligned mapping marked
+ * MADV_HUGEPAGE for transparent huge pages.  Smaller blocks, other
+ * systems and NDB_HUGEPAGES=0 in the environment keep normal pages;
+ * buf_alloc_huge says which the block got.
+ *
+ * NULL on failure.  Release with buf_free, never free().
+ */
+#define BUF_ALIGN      64
+#define BUF_HUGE_PAGE  (2u << 20)
+
+#define BUF_ZERO  0x1u   /* zero-filled, as calloc */
+#define BUF_HUGE  0x2u   /* 2 MB pages where the block spans one */
+
+/* align: 0 for BUF_ALIGN, else a power of two (raised to BUF_ALIGN) */
+void *buf_alloc(size_t align, size_t bytes, unsigned flags);
+void buf_free(void *p);
+
+/* How `p` is backed: 0 heap or normal pages, 1 madvise'd (transparent huge
+   pages, the kernel's choice), 2 MAP_HUGETLB */
+int buf_alloc_huge(const void *p);
+
+#endif /* BUF_ALLOC_H */
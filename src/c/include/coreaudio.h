@@ -2,6 +2,8 @@
 #define COREAUDIO_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <time.h>
 
 /*
  * A callback function that the user of this module provides.
@@ -14,16 +16,78 @@
 typedef void (*audio_callback_t)(float* buffer, uint32_t num_frames, void* user_data);
 
 /*
- * Initializes the audio playback system.
+ * Playback backends behind this header (pick one with AUDIO_BACKEND=):
+ *   coreaudio  AudioQueue, macOS default
+ *   sdl        SDL2 audio, default elsewhere
+ *   alsa       libasound; PipeWire and PulseAudio hosts serve it through
+ *              their ALSA plugin ("default" device)
  *
- * sr:         The desired sample rate (e.g., 44100).
- * buffer_size: The number of frames per buffer chunk.
+ * Latency is roughly period_frames * periods / sample_rate.  A backend may
+ * grant other values than asked for; audio_get_stats reports what it got.
+ */
+#define AUDIO_MAX_PERIODS 16
+
+typedef struct {
+    uint32_t    sample_rate;
+    uint32_t    period_frames;  /* frames per callback */
+    uint32_t    periods;        /* periods queued ahead of the hardware, 2..AUDIO_MAX_PERIODS */
+    const char* device;         /* backend device name, NULL for the default */
+} audio_config_t;
+
+#define AUDIO_CONFIG_DEFAULT { 44100, 512, 3, NULL }
+
+typedef struct {
+    uint32_t sample_rate;       /* as granted by the backend */
+    uint32_t period_frames;
+    uint32_t periods;           /* 0 when the backend does not expose it */
+    uint64_t callbacks;
+    uint64_t xruns;             /* underruns recovered; only ALSA detects them */
+} audio_stats_t;
+
+/*
+ * Opens the playback device.  Xruns are also tallied in the "audio.xruns"
+ * prof counter (prof.h) while profiling runs.
+ *
+ * cfg:        Requested rate, period size and count.
  * callback:   The function to call to generate audio.
  * user_data:  A pointer that will be passed to the callback.
  *
  * returns: 0 on success, non-zero on failure.
  */
-int audio_init(uint32_t sr, uint32_t buffer_size, audio_callback_t callback, void* user_data);
+int audio_open(const audio_config_t* cfg, audio_callback_t callback, void* user_data);
+
+/* Snapshot of the granted configuration and the counters (any thread) */
+void audio_get_stats(audio_stats_t* stats);
+
+/*
+ * Initializes the audio playback system with three periods.
+ *
+ * sr:         The desired sample rate (e.g., 44100).
+ * buffer_size: The number of frames per buffer chunk.
+ */
+static inline int audio_init(uint32_t sr, uint32_t buffer_size, audio_callback_t callback, void* user_data)
+{
+    audio_config_t cfg = { sr, buffer_size, 3, NULL };
+    return audio_open(&cfg, callback, user_data);
+}
+
+/* The host clock blocks are stamped on (CLOCK_MONOTONIC, ns); video
+   schedules against the same clock */
+static inline uint64_t audio_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * From inside the callback: when the first frame of the block being
+ * rendered will be heard, on audio_clock_ns.  0 while the backend can't
+ * tell (buffers primed before audio_start, a device not yet running).
+ * ALSA measures it (snd_pcm_delay); CoreAudio and SDL estimate it from the
+ * buffers queued ahead of the one being filled.
+ */
+uint64_t audio_block_pts(void);
 
 /* Starts the audio playback. The program should enter a run loop after this. */
 void audio_start(void);
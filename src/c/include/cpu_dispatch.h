@@ -0,0 +1,72 @@
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Run-time kernel selection.  The compile-time paths (simd4.h's NEON /
+ * SSE2 / scalar, the asm knobs) stay what the build targets; kernels that
+ * also have wider variants built with __attribute__((target)) pick one on
+ * first use, so one x86-64 or ARM64 binary runs the widest path the node
+ * has.  Every variant of a kernel gives bit-identical output.
+ *
+ * The ISA levels of one family are ordered: a CPU at AVX2 also runs the
+ * SSE4.2 and SSE2 kernels.  A kernel built for levels {scalar, SSE2, AVX2}
+ * on an AVX-512 node runs its AVX2 variant.
+ *
+ * The level can be capped for testing with --kernels NAME (segment,
+ * generate_frames, realtime) or NDB_KERNELS=NAME in the environment; it
+ * must be set before the first kernel call, as kernels resolve once.
+ */
+
+typedef enum {
+    CPU_ISA_SCALAR,
+    CPU_ISA_SSE2,      /* x86-64 baseline */
+    CPU_ISA_SSE42,     /* SSSE3 + SSE4.1 + SSE4.2 */
+    CPU_ISA_AVX2,
+    CPU_ISA_AVX512,    /* F + BW + DQ + VL */
+    CPU_ISA_NEON,      /* ARM64 baseline */
+    CPU_ISA_SVE,
+    CPU_ISA_SVE2,
+    CPU_ISA_COUNT
+} cpu_isa_t;
+
+#define CPU_ISA_BIT(isa) (1u << (isa))
+
+/*
+ * SVE variants are written against arm_sve.h under a target attribute,
+ * which GCC 14 and clang 18 allow in a baseline ARMv8 build (older ones
+ * only when the whole build targets SVE).  They are length-agnostic, so
+ * one binary fills Neoverse V1's 256-bit vectors and V2's 128-bit ones,
+ * and their predicated loads and stores do the tails the NEON kernels
+ * finish in scalar loops.  They stick to base SVE so V1 (no SVE2) runs
+ * them too.
+ */
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_SVE) || \
+    (defined(__clang__) ? __clang_major__ >= 18 : __GNUC__ >= 14))
+#define CPU_SVE_KERNELS 1
+#ifdef __clang__
+#define CPU_TARGET_SVE __attribute__((target("sve")))
+#else
+#define CPU_TARGET_SVE __attribute__((target("+sve")))
+#endif
+#endif
+
+/* Widest level this CPU runs, capped by the override if one is set */
+cpu_isa_t cpu_isa(void);
+
+/* Widest level of `have` (CPU_ISA_BITs of the variants a kernel was built
+   with) that cpu_isa() covers; scalar when none is */
+cpu_isa_t cpu_isa_best(uint32_t have);
+
+/* cpu_isa_best, resolved once into *cache (initially -1); safe to race */
+cpu_isa_t cpu_isa_resolve(int *cache, uint32_t have);
+
+/* Cap the level at `name` (cpu_isa_name's, or "auto" to lift the cap).
+   -1 when the name is unknown or this CPU doesn't run it. */
+int cpu_isa_set(const char *name);
+
+const char *cpu_isa_name(cpu_isa_t isa);
+
+#endif /* CPU_DISPATCH_H */
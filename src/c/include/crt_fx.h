@@ -4,9 +4,16 @@
 #include <stdint.h>
 #include "rand.h"
 
+/* Byte order of one framebuffer pixel, most significant byte first */
+typedef enum {
+    CRT_FX_RGBA,            /* 0xRRGGBBAA: the realtime raster */
+    CRT_FX_ARGB             /* 0xAARRGGBB: generate_frames */
+} crt_fx_layout_t;
+
 typedef struct {
     /* persistence (ghost trails) */
     uint32_t *prev_frame;
+    uint32_t *scratch;      /* two rows for the chroma and bleed passes */
     float persistence;      /* 0.3 (heavy) to 0.9 (minimal) */
     
     /* scanlines */
@@ -29,10 +36,27 @@ typedef struct {
     
     /* RNG for effects */
     rng_t rng;
+
+    /* channel masks of the pixel layout */
+    uint32_t r_mask, b_mask, a_mask;
 } crt_fx_t;
 
 void crt_fx_init(crt_fx_t *fx, uint64_t seed, int w, int h);
 void crt_fx_apply(crt_fx_t *fx, uint32_t *fb, int w, int h, int frame);
+
+/* crt_fx_apply in two parts.  The row effects (persistence, scanlines,
+   chroma, bleed) of rows [y0, y1), with `scratch` two rows of w for the
+   caller alone: they touch only their own rows of fb and prev_frame, so
+   disjoint bands of a frame may run at once.  Then, after every row, the
+   noise pixels, which draw from fx->rng in order. */
+void crt_fx_apply_rows(const crt_fx_t *fx, uint32_t *fb, int w, int y0, int y1, int frame, uint32_t *scratch);
+void crt_fx_noise(crt_fx_t *fx, uint32_t *fb, int w, int h);
+
+/* Pixel layout of the buffers crt_fx_apply sees; CRT_FX_RGBA after init */
+void crt_fx_set_layout(crt_fx_t *fx, crt_fx_layout_t layout);
+
+/* Advance the noise RNG as if `frames` frames had been applied */
+void crt_fx_skip(crt_fx_t *fx, int frames);
 void crt_fx_cleanup(crt_fx_t *fx);
 
 #endif /* CRT_FX_H */ 
\ No newline at end of file
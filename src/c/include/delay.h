@@ -5,7 +5,8 @@
 #include <string.h>
 
 typedef struct {
-    float32_t *buf;      /* interleaved stereo buffer, length = size*2 */
+    float32_t *buf;      /* stereo ring, size*2 floats: planar L|R in delay.c,
+                            interleaved pairs in delay.s */
     uint32_t size;   /* delay in samples */
     uint32_t idx;    /* write/read index */
 } delay_t;
@@ -0,0 +1,65 @@
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Reproducibility digests shared by segment --digest (PCM) and
+ * generate_frames --digest (framebuffers).
+ *
+ * The rendered stream is hashed while it is generated (XXH64, seed 0) and
+ * written as a small text manifest, one line per part:
+ *
+ *   ndb-digest 1 xxh64 <header>          e.g. "audio 44100 2", "video 800 600 60"
+ *   <tag> <index> <hash>                 a = one second of PCM, f = one frame
+ *   total <parts> <bytes> <hash>         XXH64 of the part hashes (little endian)
+ *
+ * Two renders agree when their manifests are identical; the first differing
+ * part line is where they diverge (a bisect needs no WAV, PPM or MP4).  The
+ * PCM parts hash exactly the bytes of the WAV data chunk, so a WAV on disk
+ * can be checked against the same manifest.
+ */
+
+typedef struct {
+    uint64_t v[4];
+    uint64_t len;            /* bytes hashed so far */
+    uint8_t mem[32];         /* input not yet folded into v[] */
+    uint32_t mem_len;
+    uint64_t seed;
+} xxh64_state_t;
+
+void xxh64_reset(xxh64_state_t *s, uint64_t seed);
+void xxh64_update(xxh64_state_t *s, const void *data, size_t len);
+uint64_t xxh64_digest(const xxh64_state_t *s);
+uint64_t xxh64(const void *data, size_t len, uint64_t seed);
+
+typedef struct {
+    FILE *out;
+    char tag;
+    uint64_t part_bytes;     /* > 0: a part every part_bytes; 0: digest_part_end */
+    uint64_t in_part;        /* bytes in the open part */
+    uint64_t bytes;          /* all bytes hashed */
+    uint32_t index;          /* index printed for the open part */
+    uint32_t parts;
+    xxh64_state_t part, total;
+} digest_t;
+
+/* Create `path` and write the header line; 0 on success, -1 on error.
+   Parts are numbered from `first_index` (a --range slice keeps the frame
+   numbers of the full render). */
+int digest_open(digest_t *d, const char *path, const char *header, char tag,
+                uint32_t first_index, uint64_t part_bytes);
+/* Carry on a manifest whose state `d` holds (from a checkpoint, out
+   ignored): `path` is cut back to its first `offset` bytes, where that
+   state left it.  0 on success, -1 on error. */
+int digest_resume(digest_t *d, const char *path, long offset);
+void digest_update(digest_t *d, const void *data, size_t len);
+/* End the open part (no-op when empty), e.g. after one whole framebuffer */
+void digest_part_end(digest_t *d);
+/* End the last part, write the total line and close; returns the total
+   hash in *total (may be NULL).  0 on success, -1 on a write error. */
+int digest_close(digest_t *d, uint64_t *total);
+
+#endif /* DIGEST_H */
@@ -9,4 +9,26 @@
  */
 void euclid_pattern(int pulses, int steps, uint8_t *out);
 
+/* The same rhythm as a bitmask (bit i = out[i], steps 1..32), rotated so
+ * its first pulse lands on step `anchor`; anchor < 0 keeps it unrotated.
+ * Header-only so seed planning needs no euclid object (or euclid.s).
+ */
+static inline uint32_t euclid_mask(int pulses, int steps, int anchor)
+{
+    uint32_t m = 0;
+    int bucket = 0;
+    for (int i = 0; i < steps; ++i) {
+        bucket += pulses;
+        if (bucket >= steps) {
+            bucket -= steps;
+            m |= 1u << i;
+        }
+    }
+    if (anchor < 0 || !m) return m;
+    int rot = ((anchor - __builtin_ctz(m)) % steps + steps) % steps;
+    uint32_t all = steps == 32 ? ~0u : (1u << steps) - 1;
+    if (rot) m = ((m << rot) | (m >> (steps - rot))) & all;
+    return m;
+}
+
 #endif /* EUCLID_H */ 
\ No newline at end of file
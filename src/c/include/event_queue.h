@@ -2,6 +2,7 @@
 #define EVENT_QUEUE_H
 
 #include <stdint.h>
+#include <stdlib.h>
 
 /* Event types for the segment composer */
 typedef enum {
@@ -18,20 +19,42 @@ typedef struct {
     uint32_t time;   /* sample index at which to trigger */
     uint8_t  type;   /* event_type_t */
     uint8_t  aux;    /* optional small parameter (e.g. preset/freq index) */
+    uint8_t  note;   /* pitched voices: generator_plan_t.pitch index, chosen at plan time */
+    uint8_t  preset; /* EVT_FM_BASS: bass patch, chosen at plan time */
 } event_t;
 
-#define MAX_EVENTS 512  /* adjust if needed */
+/* Growable event store: one heap block that doubles as it fills, so a
+   schedule has no upper size and eq_push never drops an event silently
+   (it returns -1 when the block cannot grow).  A composition keeps every
+   pattern's events in one store and refers to them by slice; see
+   generator_plan_t.  Release with eq_free. */
+#define EQ_INITIAL_CAP 256
 
 typedef struct {
-    event_t events[MAX_EVENTS];
+    event_t *events;
     uint32_t count;
+    uint32_t cap;
 } event_queue_t;
 
-static inline void eq_init(event_queue_t *q){ q->count = 0; }
-static inline void eq_push(event_queue_t *q, uint32_t time, uint8_t type, uint8_t aux){
-    if(q->count < MAX_EVENTS){
-        q->events[q->count++] = (event_t){time, type, aux};
-    }
+static inline void eq_init(event_queue_t *q){ q->events = NULL; q->count = q->cap = 0; }
+static inline void eq_free(event_queue_t *q){ free(q->events); eq_init(q); }
+
+/* Room for `n` events in total; 0 on success */
+static inline int eq_reserve(event_queue_t *q, uint32_t n){
+    if(n <= q->cap) return 0;
+    uint32_t cap = q->cap ? q->cap : EQ_INITIAL_CAP;
+    while(cap < n) cap *= 2;
+    event_t *e = realloc(q->events, (size_t)cap * sizeof(event_t));
+    if(!e) return -1;
+    q->events = e;
+    q->cap = cap;
+    return 0;
+}
+
+static inline int eq_push(event_queue_t *q, uint32_t time, uint8_t type, uint8_t aux){
+    if(q->count == q->cap && eq_reserve(q, q->count + 1) != 0) return -1;
+    q->events[q->count++] = (event_t){time, type, aux, 0, 0};
+    return 0;
 }
 
 #endif /* EVENT_QUEUE_H */ 
\ No newline at end of file
@@ -1 +1,11 @@
- 
\ No newline at end of file
+// fast_math_asm.h – hand-written AArch64 versions of the fast_math_neon.h
+// kernels (src/asm/active/exp4_ps_asm.s, sin4_ps_asm.s).  Same maths, same
+// register-in/register-out calling convention as the inline intrinsics.
+#pragma once
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+
+float32x4_t exp4_ps_asm(float32x4_t x);
+float32x4_t sin4_ps_asm(float32x4_t x);
+#endif /* __ARM_NEON */
@@ -24,4 +24,39 @@ void fm_voice_init(fm_voice_t *v, float32_t sr);
 void fm_voice_trigger(fm_voice_t *v, float32_t carrier_freq, float32_t duration_sec, float32_t ratio, float32_t index, float32_t amp, float32_t decay);
 void fm_voice_process(fm_voice_t *v, float32_t *L, float32_t *R, uint32_t n);
 
+/* C kernels behind fm_voice_process when FM_VOICE_ASM is off:
+ *   _poly  – port of fm_voice.s, 1/(1+decay*t) envelope (default)
+ *   _exp   – exp(-decay*t) envelope and float phases (fm_voice_neon.c)
+ *   _recur – env *= exp(-decay/sr) recurrence and Q32 phase accumulators
+ * Build with FM_ENV_EXP or FM_ENV_RECURRENCE to pick the latter two. */
+void fm_voice_process_poly(fm_voice_t *v, float32_t *L, float32_t *R, uint32_t n);
+void fm_voice_process_exp(fm_voice_t *v, float32_t *L, float32_t *R, uint32_t n);
+void fm_voice_process_recur(fm_voice_t *v, float32_t *L, float32_t *R, uint32_t n);
+
+/* Four voices in lockstep, lane l rendering n[l] samples of v[l] into
+ * L[l]/R[l] (n[l] == 0: lane idle, v[l] unused); n[l] must not exceed the
+ * voice's remaining len - pos.  Bit-identical to fm_voice_process_poly on
+ * each voice alone, so only C builds on the default kernel have it. */
+void fm_voice_process_poly_x4(fm_voice_t *const v[4], float32_t *const L[4], float32_t *const R[4], const uint32_t n[4]);
+
+/* Polyphonic pool: FM_POOL_VOICES voices sharing one bus, so a note no
+ * longer cuts the one still ringing.  A trigger takes a silent voice, or
+ * steals the one furthest into its envelope (largest pos, lowest index on
+ * a tie).  pos/len mirror fm_voice_t for the voice registry: len - pos is
+ * the longest remaining note.  The poly kernel renders the voices one per
+ * lane (fm_voice_process_poly_x4); the other kernels voice by voice, with
+ * the same sum order (bus + v[0] + v[1] + ...). */
+#define FM_POOL_VOICES 4
+
+typedef struct {
+    fm_voice_t v[FM_POOL_VOICES];
+    uint32_t len;
+    uint32_t pos;
+} fm_pool_t;
+
+void fm_pool_init(fm_pool_t *p, float32_t sr);
+void fm_pool_trigger(fm_pool_t *p, float32_t carrier_freq, float32_t duration_sec, float32_t ratio, float32_t index, float32_t amp, float32_t decay);
+/* n <= len - pos, as for a single voice */
+void fm_pool_process(fm_pool_t *p, float32_t *L, float32_t *R, uint32_t n);
+
 #endif /* FM_VOICE_H */ 
\ No newline at end of file
@@ -18,14 +18,71 @@
 #include "delay.h"
 #include "limiter.h"
 #include "event_queue.h"
+#include "generator_plan.h"
 
+/* Upper bound for the delay line: two beats at the slowest tempo (50 bpm) */
 #define MAX_DELAY_SAMPLES 106000
 
+/* active_voices bits: set on trigger, cleared once the voice has finished */
+#define GEN_VOICE_KICK       (1u << 0)
+#define GEN_VOICE_SNARE      (1u << 1)
+#define GEN_VOICE_HAT        (1u << 2)
+#define GEN_VOICE_MELODY     (1u << 3)
+#define GEN_VOICE_MID_FM     (1u << 4)
+#define GEN_VOICE_BASS_FM    (1u << 5)
+#define GEN_VOICE_MID_SIMPLE (1u << 6)
+#define GEN_VOICE_MID_POOL   (1u << 7)
+#define GEN_VOICE_BASS_POOL  (1u << 8)
+
+/* generator_init_opts flags */
+#define GEN_INIT_NO_DELAY 0x1u   /* skip delay storage (event/timing consumers) */
+#define GEN_INIT_EUCLID   0x2u   /* Euclidean drum patterns (PLAN_RHYTHM_EUCLID) */
+#define GEN_INIT_NOISE_V2 0x4u   /* snare/hat noise from the four-lane engine (noise4.h) */
+#define GEN_INIT_LIVE_HITS 0x8u  /* no one-shot cache: synthesise every kick */
+#define GEN_INIT_FM_POOL  0x10u  /* mid/bass FM notes overlap in fm_pool_t (C generator only) */
+
+/* Cache line that generator_t's hot block starts on */
+#define GENERATOR_CACHE_LINE 64
+
+/* Hot fields first: the block loop's clock, voice mask, scratch arena and
+   every voice/effect state sit in the leading cache lines, in the order
+   generator_process touches them.  What only triggers read (key, pattern
+   RNG, visual flags) follows, and the event schedule lives out of line, so rendering a block no longer drags it through L1D.  Embedders
+   that heap-allocate a generator_t need GENERATOR_CACHE_LINE alignment
+   (buf_alloc with _Alignof(generator_t)). */
 typedef struct {
+    /* ---- hot: per block ---- */
+    _Alignas(GENERATOR_CACHE_LINE) uint32_t event_idx;
+    uint32_t step;
+    uint32_t pos_in_step; /* samples into current step */
+    uint32_t event_end;   /* one past the playing pattern's last event */
+    uint16_t section;     /* plan->sections index playing */
+    uint16_t section_rep; /* plays of it completed */
+
+    /* GEN_VOICE_* mask of voices that may be sounding (G_OFF_ACTIVE, read by generator.s) */
+    uint32_t active_voices;
+    /* Clock ticks per rendered sample: 1 at SR, 2 or 4 for a draft render
+       (generator_init_rate).  step/pos_in_step and every event time stay
+       in SR ticks, so a draft keeps the full-rate schedule exactly. */
+    uint32_t rate_div;
+
     music_time_t mt;
-    music_globals_t music;
-    rng_t rng;
 
+    /* Optional Ld/Rd/Ls/Rs scratch arena for generator_process.  When it holds
+       at least num_frames the hot path uses it instead of malloc'ing per call.
+       (generator.s reads it via G_OFF_SCRATCH in the generated offsets.inc.) */
+    float32_t *scratch;
+    uint32_t scratch_frames;   /* capacity in frames (4 floats per frame) */
+    bool scratch_owned;        /* allocated by generator_reserve_scratch */
+
+    /* One-shot cache: kick_trigger resets every bit of the kick's state, so
+       each hit is the same samples.  The first hit renders into kick_shot
+       (allocated by generator_init) and later ones are mixed from it. */
+    float32_t *kick_shot;
+    uint32_t kick_shot_len;    /* samples cached, 0 until the first hit */
+    uint32_t kick_shot_cap;
+
+    /* ---- hot: per sample ---- */
     kick_t kick;
     snare_t snare;
     hat_t hat;
@@ -33,25 +90,124 @@ typedef struct {
     fm_voice_t mid_fm;
     fm_voice_t bass_fm;
     simple_voice_t mid_simple;
-
-    event_queue_t q;
-    uint32_t event_idx;
-    uint32_t step;
-    uint32_t pos_in_step; /* samples into current step */
-
     delay_t delay;
     limiter_t limiter;
-    
-    float32_t delay_buf[MAX_DELAY_SAMPLES * 2];
+    /* GEN_INIT_FM_POOL: these play the FM notes and mid_fm/bass_fm stay silent */
+    fm_pool_t mid_pool;
+    fm_pool_t bass_pool;
+
+    /* ---- cold: per trigger / per seed ---- */
+    music_globals_t music;
+    rng_t rng;
+    /* Notes come from the events (planned) until the pattern wraps with no
+       generator_rewind; later plays draw from rng here, as they always did */
+    bool live_notes;
+    bool fm_pool;      /* GEN_INIT_FM_POOL */
+    bool held;         /* generator_hold: no events, no pattern past the wrap */
 
     /* visual event flags */
     bool saw_hit;      /* set when saw melody triggers */
     bool bass_hit;     /* set when bass triggers */
 
+    /* debug: number of MID events fired (per generator, so seeds can render in parallel) */
+    uint32_t mid_trigger_count;
+
+    /* Seed's patterns and arrangement, heap copy made by generator_init
+       (never NULL); event_idx..event_end is a slice of plan->q */
+    generator_plan_t *plan;
 } generator_t;
 
+/* Floats of scratch needed for blocks of up to n frames (Ld, Rd, Ls, Rs) */
+#define GENERATOR_SCRATCH_FLOATS(n) ((n) * 4u)
+
+/* generator_init heap-allocates a tempo-sized delay line and the event
+   schedule; release them with generator_free before re-initialising or
+   discarding the generator. */
 void generator_init(generator_t *g, uint64_t seed);
+void generator_init_opts(generator_t *g, uint64_t seed, uint32_t flags);
+/* generator_init_opts rendering at SR / rate_div (1, 2 or 4: 44.1, 22.05 or
+   11.025 kHz) for drafts at a half or a quarter of the synthesis cost.  An
+   event due at SR tick t sounds at the first draft sample at or after
+   t / rate_div, so draft audio never drifts from full-rate visuals or
+   timelines.  Other divisors, and the generator.s build, render at SR. */
+void generator_init_rate(generator_t *g, uint64_t seed, uint32_t flags, uint32_t rate_div);
+#define GEN_RATE_DIV_MAX 4u
+
+/* Rendered samples per second */
+static inline uint32_t generator_sample_rate(const generator_t *g)
+{
+    return SR / g->rate_div;
+}
+/* Rendered samples covering SR ticks [0, ticks): ceil(ticks / rate_div) */
+static inline uint64_t generator_ticks_to_frames(const generator_t *g, uint64_t ticks)
+{
+    return (ticks + g->rate_div - 1) / g->rate_div;
+}
+void generator_free(generator_t *g);
+/* Delay length in samples for a given tempo (clamped to MAX_DELAY_SAMPLES) */
+uint32_t generator_delay_samples(const music_time_t *mt);
+/* Exact pattern period in frames: generator_process wraps step/event_idx
+   back to step 0 every TOTAL_STEPS * step_samples frames (this can differ
+   from the rounded mt.seg_frames by a few samples). */
+uint32_t generator_loop_frames(const music_time_t *mt);
+/* Replace the one-pattern loop with generator_plan_arrange(bars), from
+   the top; call right after generator_init.  0 on success. */
+int generator_arrange(generator_t *g, uint32_t bars);
 void generator_process(generator_t *g, float32_t *L, float32_t *R, uint32_t num_frames);
+
+/* Generators rendered in lockstep by generator_process_lanes */
+#define GEN_LANES 4
+/* Render `lanes` (<= GEN_LANES) generators side by side: lane l writes
+   frames[l] frames into L[l]/R[l] (0 skips the lane), exactly what
+   generator_process(g[l], L[l], R[l], frames[l]) writes.  Spans are cut at
+   every lane's events so voices with a lane kernel (voice_registry.h) run
+   one seed per SIMD lane.  Falls back to one generator_process per lane
+   in the generator.s build. */
+void generator_process_lanes(generator_t *const g[], uint32_t lanes, float32_t *const L[],
+                             float32_t *const R[], const uint32_t frames[]);
+
+/* Stems written by generator_process_stems, in voice_stem_t order */
+#define GEN_STEMS 4
+extern const char *const generator_stem_names[GEN_STEMS];   /* "drums", "melody", "mid", "bass" */
+/* generator_process that also keeps each voice group apart: stem s gets
+   its voices' frames in L[s]/R[s] (overwritten) and mixL/mixR the sum,
+   drums + ((melody + mid) + bass), which is generator_process's mix.  One
+   pass for all stems; the generator.s build leaves the stems silent. */
+void generator_process_stems(generator_t *g, float32_t *const L[GEN_STEMS], float32_t *const R[GEN_STEMS],
+                             float32_t *mixL, float32_t *mixR, uint32_t num_frames);
+
+/* Loop snapshot for extended renders: the random streams consumed by
+   triggers and noise voices, captured right after generator_init. */
+typedef struct {
+    rng_t pattern;   /* note choices of free-running loops */
+    rng_t snare;
+    rng_t hat;
+    noise4_t snare4;   /* noise v2 lanes */
+    noise4_t hat4;
+} generator_loop_t;
+void generator_loop_mark(const generator_t *g, generator_loop_t *mark);
+/* Restart the pattern clock at step 0 and restore the marked random
+   streams, leaving voices and the delay ring sounding: the next loop
+   replays the same notes while the previous loop's tails ring into it. */
+void generator_rewind(generator_t *g, const generator_loop_t *mark);
+/* generator_rewind with the clock `ticks` (< rate_div) past the loop start:
+   a draft render's seam that falls between two of its samples */
+void generator_rewind_at(generator_t *g, const generator_loop_t *mark, uint32_t ticks);
+
+/* Let the sounding notes ring out: no further event fires, and the clock
+   wraps without entering a pattern (C generator_process only).  With
+   generator_ring_frames more frames rendered, the mix is exact silence. */
+void generator_hold(generator_t *g);
+/* Frames until every mixed voice has played out (0: silent now) */
+uint32_t generator_ring_frames(const generator_t *g);
+
+/* Scratch arena management.  generator_init clears the arena fields, so call
+   generator_release_scratch before re-initialising an owned arena. */
+int  generator_reserve_scratch(generator_t *g, uint32_t max_frames);   /* 0 on success */
+void generator_set_scratch(generator_t *g, float32_t *storage, uint32_t max_frames); /* caller-owned, 16-byte aligned */
+void generator_release_scratch(generator_t *g);
+/* generator_init + generator_reserve_scratch: process blocks <= max_frames allocation-free */
+int  generator_init_max_block(generator_t *g, uint64_t seed, uint32_t max_frames);
 void generator_process_voices(generator_t *g, float32_t *Ld, float32_t *Rd,
                               float32_t *Ls, float32_t *Rs, uint32_t num_frames);
 
@@ -76,6 +232,10 @@ void generator_build_events_asm(event_queue_t *q, rng_t *rng,
                                uint32_t step_samples);
 
 void generator_trigger_step(generator_t *g);
+/* Right after kick_trigger: render the hit into kick_shot unless it holds it */
+void generator_cache_kick(generator_t *g);
+/* Clear active_voices bits of voices whose envelope has run out */
+void generator_sweep_voices(generator_t *g);
 
 extern volatile float g_block_rms;
 
@@ -0,0 +1,134 @@
+#ifndef GENERATOR_PLAN_H
+#define GENERATOR_PLAN_H
+
+#include <stdint.h>
+#include "music_time.h"
+#include "music_defs.h"
+#include "rand.h"
+#include "event_queue.h"
+
+/*
+ * Seed-derived composition without any DSP state: tempo, key/scale and
+ * the full event schedule.  generator_init builds on the same plan, so
+ * everything here matches what the renderer will play.
+ *
+ * The schedule is stored as pattern-repeat: every distinct TOTAL_STEPS
+ * (2-bar) pattern is kept once, as a slice of `q` with times relative to
+ * the pattern start, and `sections` say which pattern plays how many
+ * times in a row.  A 64-bar arrangement is a few hundred events and a
+ * couple of dozen sections, never 64 bars of materialised events.
+ */
+#define PLAN_MAX_PATTERNS 4
+#define PLAN_MAX_SECTIONS 32
+#define PLAN_MAX_ARRANGE_BARS 64   /* longer renders loop the arrangement */
+
+/* Pattern indices: generator_plan builds MAIN, generator_plan_arrange the rest */
+enum {
+    PLAN_PAT_MAIN = 0,   /* the seed's loop, as every seed has always played */
+    PLAN_PAT_SPARSE,     /* intro/breakdown: hat, melody and mid only */
+    PLAN_PAT_DRUMS,      /* kick, snare, hat and bass without the melodic voices */
+    PLAN_PAT_FILL,       /* MAIN with a snare run and straight hats into the next section */
+};
+
+typedef struct {
+    uint32_t first;   /* first event in q */
+    uint32_t count;
+    rng_t rng_after;  /* plan rng after this pattern's note draws */
+} plan_pattern_t;
+
+typedef struct {
+    uint8_t pattern;   /* PLAN_PAT_* */
+    uint8_t repeats;   /* consecutive plays, 0 = forever */
+} plan_section_t;
+
+/* Pitch table: every frequency a trigger can play, one band per octave
+   offset the voices use, indexed by scale degree.  Indices are PITCH_NOTE. */
+enum {
+    PITCH_BASS = 0,   /* root / 4 (FM bass) */
+    PITCH_ROOT,       /* melody low notes */
+    PITCH_UP,         /* one octave up: melody and mid */
+    PITCH_UP2,        /* two octaves up: melody accents */
+    PITCH_BANDS
+};
+#define PITCH_MAX_DEGREES 8
+#define PITCH_NOTE(band, deg_idx) ((uint8_t)((band) * PITCH_MAX_DEGREES + (deg_idx)))
+
+typedef struct {
+    uint64_t seed;
+    music_time_t mt;
+    music_globals_t music;
+    event_queue_t q;   /* every pattern's events (heap, generator_plan_free) */
+    float pitch[PITCH_BANDS * PITCH_MAX_DEGREES];   /* Hz, by event_t.note */
+
+    plan_pattern_t patterns[PLAN_MAX_PATTERNS];
+    uint8_t pattern_count;
+    plan_section_t sections[PLAN_MAX_SECTIONS];
+    uint8_t section_count;
+
+    uint8_t rhythm;   /* PLAN_RHYTHM_* the patterns were built with */
+
+    /* pattern variation drawn from the seed */
+    uint8_t kick_hits;
+    uint8_t snare_hits;
+    uint8_t hat_hits;
+
+    /* RNG state after planning.  Each pattern's note choices are drawn
+       from a copy of it, as every loop replays them from here. */
+    rng_t rng;
+} generator_plan_t;
+
+/* The seed's per-run variation: the draws generator_plan starts with
+   (drum hit counts, tempo, key and scale), without the event schedule.
+   Inline and allocation-free for the trait index; *rng is left where the
+   planner goes on drawing. */
+typedef struct {
+    uint8_t kick_hits;
+    uint8_t snare_hits;
+    uint8_t hat_hits;
+    music_time_t mt;
+    music_globals_t music;
+} plan_variation_t;
+
+static inline void generator_plan_variation(rng_t *rng, plan_variation_t *v)
+{
+    v->kick_hits  = (uint8_t)(2 + (rng_next_u32(rng) % 3));
+    v->snare_hits = (uint8_t)(1 + (rng_next_u32(rng) % 3));
+    v->hat_hits   = (uint8_t)(4 + (rng_next_u32(rng) % 5));
+    float bpm = 50.0f + (rng_next_float(rng) * 70.0f);
+    music_time_init(&v->mt, bpm);
+    music_globals_init(&v->music, rng);
+}
+
+/* generator_plan_opts rhythm flags */
+#define PLAN_RHYTHM_EUCLID 0x1u   /* Euclid(kick/snare/hat_hits) masks, not the classic bytes */
+
+/* Deterministically derive the plan for `seed`: the MAIN pattern, looped
+   forever by one section (~microseconds, one small allocation).
+   0 on success, -1 if the event store could not be allocated. */
+int generator_plan(uint64_t seed, generator_plan_t *plan);
+int generator_plan_opts(uint64_t seed, uint32_t rhythm, generator_plan_t *plan);
+
+/* Arrange `bars` bars (rounded up to whole patterns, capped at
+   PLAN_MAX_ARRANGE_BARS) as seed-derived sections: intro, main runs,
+   fills and breakdowns.  Draws from its own stream, so tempo, key and
+   note choices match the unarranged plan.  0 on success. */
+int generator_plan_arrange(generator_plan_t *plan, uint32_t bars);
+
+/* Bars the plan's sections cover; 0 when the last section loops forever */
+uint32_t generator_plan_bars(const generator_plan_t *plan);
+
+/* Samples the MAIN loop's last notes ring past its end (TOTAL_STEPS *
+   step_samples), at SR: the end of the latest-ending mixed note, from the
+   event times and the voices' fixed note lengths.  Every note of a type
+   has the same length, so this is exact with or without FM pools; voices
+   stop dead at their length, so past it the mix is exact silence. */
+uint32_t generator_plan_tail(const generator_plan_t *plan);
+
+void generator_plan_free(generator_plan_t *plan);
+
+/* Draw `e`'s note (and bass patch) from `rng`: the planner's choice for
+   every loop that starts from the plan rng, and the generator's for
+   free-running loops past the first (see generator_t.live_notes) */
+void generator_plan_note(const music_globals_t *m, rng_t *rng, event_t *e);
+
+#endif /* GENERATOR_PLAN_H */
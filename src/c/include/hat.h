@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "rand.h"
+#include "noise4.h"
 
 typedef struct {
     uint32_t pos;
@@ -11,10 +12,16 @@ typedef struct {
     float32_t env;
     float32_t env_coef;
     rng_t rng;
+    uint32_t noise_version;  /* NOISE_V1: rng; NOISE_V2: noise4 */
+    noise4_t noise4;
 } hat_t;
 
 void hat_init(hat_t *h, float32_t sr, uint64_t seed);
+/* hat_init with the noise engine picked: NOISE_V1 or NOISE_V2 */
+void hat_init_noise(hat_t *h, float32_t sr, uint64_t seed, uint32_t version);
 void hat_trigger(hat_t *h);
 void hat_process(hat_t *h, float32_t *L, float32_t *R, uint32_t n);
+/* NOISE_V2 voices: always C (the .s port renders v1 only) */
+void hat_process_v2(hat_t *h, float32_t *L, float32_t *R, uint32_t n);
 
 #endif /* HAT_H */ 
\ No newline at end of file
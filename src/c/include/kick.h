@@ -2,6 +2,7 @@
 #define KICK_H
 
 #include <stdint.h>
+#include "music_time.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,4 +25,28 @@ static inline void limiter_init(limiter_t *l, float32_t sr, float32_t attack_ms,
 
 void limiter_process(limiter_t *l, float32_t *L, float32_t *R, uint32_t n);
 
+/* ---- Lookahead limiter (limiter_lookahead.c) ----------------------------
+ * Block-based peak limiter with two blocks of latency: each block's gain
+ * ramp is chosen knowing the peak of the block after it, so the gain is
+ * already down when a transient arrives (no overshoot, no per-sample
+ * envelope pumping).  Blocks whose peak and ramp stay at unity gain are
+ * passed through untouched.  Output is delayed by limiter_la_latency()
+ * frames; push that many frames of silence to drain the tail. */
+#define LIMITER_LA_MAX_BLOCK 128
+
+typedef struct {
+    float32_t threshold;      /* linear */
+    float32_t release_block;  /* release coefficient per block */
+    float32_t gain;           /* gain at the end of the last processed block */
+    uint32_t block;           /* frames per block (multiple of 4) */
+    uint32_t fill;            /* frames of the filling block received so far */
+    uint32_t cur;             /* ring index of the filling block */
+    float32_t peak[3];        /* per-block peak, indexed like ring */
+    float32_t ring[3][2][LIMITER_LA_MAX_BLOCK];
+} limiter_la_t;
+
+void limiter_la_init(limiter_la_t *l, float32_t sr, float32_t lookahead_ms, float32_t release_ms, float32_t threshold_db);
+void limiter_la_process(limiter_la_t *l, float32_t *L, float32_t *R, uint32_t n);
+static inline uint32_t limiter_la_latency(const limiter_la_t *l) { return 2u * l->block; }
+
 #endif /* LIMITER_H */ 
\ No newline at end of file
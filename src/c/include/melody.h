@@ -15,5 +15,9 @@ typedef struct {
 void melody_init(melody_t *m, float32_t sr);
 void melody_trigger(melody_t *m, float32_t freq, float32_t dur_sec);
 void melody_process(melody_t *m, float32_t *L, float32_t *R, uint32_t n);
+/* Four voices in lockstep: lane l renders n[l] samples of m[l] (0: idle,
+   m[l] unused), at most its remaining len - pos; bit-identical to
+   melody_process on each.  C build only (not with MELODY_ASM). */
+void melody_process_x4(melody_t *const m[4], float32_t *const L[4], float32_t *const R[4], const uint32_t n[4]);
 
 #endif /* MELODY_H */ 
\ No newline at end of file
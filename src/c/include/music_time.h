@@ -11,6 +11,12 @@
 #define STEPS_PER_BAR (4u * STEPS_PER_BEAT)
 #define TOTAL_STEPS   (BARS_PER_SEG * STEPS_PER_BAR)
 
+/* Fixed note lengths (seconds), shared by the voices and the planner's
+   tail estimate (generator_plan_tail) */
+#define KICK_DUR_SEC   0.5f   /* every hit, whatever the trigger */
+#define SNARE_DUR_SEC  0.1f
+#define MELODY_MAX_SEC 2.0f   /* longest melody note */
+
 typedef struct {
     float bpm;
     float beat_sec;
@@ -0,0 +1,230 @@
+#ifndef NOISE4_H
+#define NOISE4_H
+
+/*
+ * noise4.h – noise v2: four-lane SplitMix64 white noise for the noise voices.
+ *
+ * v1 (rand.h rng_float_mono) is one serial SplitMix64 stream, every sample
+ * waiting on the state add before it.  v2 runs four streams side by side:
+ * sample i of the voice comes from lane (i % 4), and lane k is seeded with
+ * the k-th output of the voice seed's v1 stream, so the schedule follows
+ * from the seed alone.  The 64-bit mix runs two lanes per register (SSE2
+ * and NEON have no 64x64 multiply, it is built from 32x32->64 products;
+ * WebAssembly SIMD has i64x2.mul),
+ * the float map is v1's, and the decay envelope is kept per lane, stepping
+ * by coef^4 per use, so four samples go out per vector.  Output is
+ * bit-identical on every backend and independent of block sizes; it is a
+ * different sequence from v1, so a series pins the version it renders with.
+ *
+ * Header-only like rand.h: the voices are linked standalone all over.
+ */
+
+#include <stdint.h>
+#include "rand.h"
+#include "simd4.h"
+
+#define NOISE_V1 1
+#define NOISE_V2 2
+
+#define NOISE4_LANES 4
+
+typedef struct {
+    uint64_t lane[NOISE4_LANES];   /* SplitMix64 states */
+    float env[NOISE4_LANES];       /* envelope of each lane's next sample */
+    float coef4;                   /* per-lane envelope step, coef^4 */
+    uint32_t next;                 /* lane the next sample comes from */
+} noise4_t;
+
+static inline void noise4_seed(noise4_t *n, uint64_t seed)
+{
+    rng_t r = rng_seed(seed);
+    for(int k = 0; k < NOISE4_LANES; k++){
+        n->lane[k] = rng_next_u64(&r);
+        n->env[k] = 0.0f;
+    }
+    n->coef4 = 0.0f;
+    n->next = 0;
+}
+
+/* Envelope restart: the next sample gets env*coef (as env *= coef does
+   before v1's first sample), the one after env*coef^2, ... */
+static inline void noise4_start(noise4_t *n, float env, float coef)
+{
+    for(int k = 0; k < NOISE4_LANES; k++){
+        env *= coef;
+        n->env[(n->next + k) & 3] = env;
+    }
+    n->coef4 = (coef * coef) * (coef * coef);
+}
+
+/* The streams alone (generator_rewind: tails keep their envelope) */
+static inline void noise4_restore_lanes(noise4_t *n, const noise4_t *mark)
+{
+    for(int k = 0; k < NOISE4_LANES; k++) n->lane[k] = mark->lane[k];
+    n->next = mark->next;
+}
+
+#define NOISE4_GOLDEN 0x9E3779B97F4A7C15ULL
+#define NOISE4_MUL1   0xBF58476D1CE4E5B9ULL
+#define NOISE4_MUL2   0x94D049BB133111EBULL
+
+/* Sample from lane `next`: rng_float_mono on that lane */
+static inline float noise4_next(noise4_t *n)
+{
+    uint64_t z = (n->lane[n->next] += NOISE4_GOLDEN);
+    n->next = (n->next + 1) & 3;
+    z = (z ^ (z >> 30)) * NOISE4_MUL1;
+    z = (z ^ (z >> 27)) * NOISE4_MUL2;
+    return (float)(((uint32_t)(z ^ (z >> 31))) >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+/* `quads` groups of one sample per lane, lane 0 first, into out */
+#if SIMD4_SSE2
+static inline __m128i noise4_mul64(__m128i a, uint64_t b)
+{
+    const __m128i blo = _mm_set1_epi64x((int64_t)(b & 0xFFFFFFFFu));
+    const __m128i bhi = _mm_set1_epi64x((int64_t)(b >> 32));
+    __m128i cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), blo), _mm_mul_epu32(a, bhi));
+    return _mm_add_epi64(_mm_mul_epu32(a, blo), _mm_slli_epi64(cross, 32));
+}
+
+static inline __m128i noise4_mix(__m128i z)
+{
+    z = noise4_mul64(_mm_xor_si128(z, _mm_srli_epi64(z, 30)), NOISE4_MUL1);
+    z = noise4_mul64(_mm_xor_si128(z, _mm_srli_epi64(z, 27)), NOISE4_MUL2);
+    return _mm_xor_si128(z, _mm_srli_epi64(z, 31));
+}
+
+static inline void noise4_quads(noise4_t *n, float *out, uint32_t quads)
+{
+    const __m128i golden = _mm_set1_epi64x((int64_t)NOISE4_GOLDEN);
+    const __m128 scale = _mm_set1_ps(2.0f / 16777216.0f), one = _mm_set1_ps(1.0f);
+    __m128i s01 = _mm_loadu_si128((const __m128i *)&n->lane[0]);
+    __m128i s23 = _mm_loadu_si128((const __m128i *)&n->lane[2]);
+    for(uint32_t q = 0; q < quads; q++){
+        s01 = _mm_add_epi64(s01, golden);
+        s23 = _mm_add_epi64(s23, golden);
+        /* low halves of the four lanes, in lane order */
+        __m128 lo = _mm_shuffle_ps(_mm_castsi128_ps(noise4_mix(s01)), _mm_castsi128_ps(noise4_mix(s23)),
+                                   _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 u = _mm_cvtepi32_ps(_mm_srli_epi32(_mm_castps_si128(lo), 8));
+        _mm_storeu_ps(out + 4 * q, _mm_sub_ps(_mm_mul_ps(u, scale), one));
+    }
+    _mm_storeu_si128((__m128i *)&n->lane[0], s01);
+    _mm_storeu_si128((__m128i *)&n->lane[2], s23);
+}
+#elif SIMD4_NEON
+static inline uint64x2_t noise4_mul64(uint64x2_t a, uint64_t b)
+{
+    uint32x2_t alo = vmovn_u64(a), ahi = vshrn_n_u64(a, 32);
+    uint32x2_t blo = vdup_n_u32((uint32_t)b), bhi = vdup_n_u32((uint32_t)(b >> 32));
+    uint32x2_t cross = vadd_u32(vmul_u32(ahi, blo), vmul_u32(alo, bhi));
+    return vaddq_u64(vmull_u32(alo, blo), vshll_n_u32(cross, 32));
+}
+
+static inline uint64x2_t noise4_mix(uint64x2_t z)
+{
+    z = noise4_mul64(veorq_u64(z, vshrq_n_u64(z, 30)), NOISE4_MUL1);
+    z = noise4_mul64(veorq_u64(z, vshrq_n_u64(z, 27)), NOISE4_MUL2);
+    return veorq_u64(z, vshrq_n_u64(z, 31));
+}
+
+static inline void noise4_quads(noise4_t *n, float *out, uint32_t quads)
+{
+    const uint64x2_t golden = vdupq_n_u64(NOISE4_GOLDEN);
+    const float32x4_t scale = vdupq_n_f32(2.0f / 16777216.0f), one = vdupq_n_f32(1.0f);
+    uint64x2_t s01 = vld1q_u64(&n->lane[0]), s23 = vld1q_u64(&n->lane[2]);
+    for(uint32_t q = 0; q < quads; q++){
+        s01 = vaddq_u64(s01, golden);
+        s23 = vaddq_u64(s23, golden);
+        uint32x4_t lo = vcombine_u32(vmovn_u64(noise4_mix(s01)), vmovn_u64(noise4_mix(s23)));
+        float32x4_t u = vcvtq_f32_u32(vshrq_n_u32(lo, 8));
+        vst1q_f32(out + 4 * q, vsubq_f32(vmulq_f32(u, scale), one));
+    }
+    vst1q_u64(&n->lane[0], s01);
+    vst1q_u64(&n->lane[2], s23);
+}
+#elif SIMD4_WASM
+static inline v128_t noise4_mix(v128_t z)
+{
+    z = wasm_i64x2_mul(wasm_v128_xor(z, wasm_u64x2_shr(z, 30)), wasm_i64x2_splat((int64_t)NOISE4_MUL1));
+    z = wasm_i64x2_mul(wasm_v128_xor(z, wasm_u64x2_shr(z, 27)), wasm_i64x2_splat((int64_t)NOISE4_MUL2));
+    return wasm_v128_xor(z, wasm_u64x2_shr(z, 31));
+}
+
+static inline void noise4_quads(noise4_t *n, float *out, uint32_t quads)
+{
+    const v128_t golden = wasm_i64x2_splat((int64_t)NOISE4_GOLDEN);
+    const v128_t scale = wasm_f32x4_splat(2.0f / 16777216.0f), one = wasm_f32x4_splat(1.0f);
+    v128_t s01 = wasm_v128_load(&n->lane[0]), s23 = wasm_v128_load(&n->lane[2]);
+    for(uint32_t q = 0; q < quads; q++){
+        s01 = wasm_i64x2_add(s01, golden);
+        s23 = wasm_i64x2_add(s23, golden);
+        v128_t lo = wasm_i32x4_shuffle(noise4_mix(s01), noise4_mix(s23), 0, 2, 4, 6);
+        v128_t u = wasm_f32x4_convert_u32x4(wasm_u32x4_shr(lo, 8));
+        wasm_v128_store(out + 4 * q, wasm_f32x4_sub(wasm_f32x4_mul(u, scale), one));
+    }
+    wasm_v128_store(&n->lane[0], s01);
+    wasm_v128_store(&n->lane[2], s23);
+}
+#else
+static inline void noise4_quads(noise4_t *n, float *out, uint32_t quads)
+{
+    uint64_t s[NOISE4_LANES];
+    for(int k = 0; k < NOISE4_LANES; k++) s[k] = n->lane[k];
+    for(uint32_t q = 0; q < quads; q++)
+        for(int k = 0; k < NOISE4_LANES; k++){
+            uint64_t z = (s[k] += NOISE4_GOLDEN);
+            z = (z ^ (z >> 30)) * NOISE4_MUL1;
+            z = (z ^ (z >> 27)) * NOISE4_MUL2;
+            out[4 * q + k] = (float)(((uint32_t)(z ^ (z >> 31))) >> 8) * (2.0f / 16777216.0f) - 1.0f;
+        }
+    for(int k = 0; k < NOISE4_LANES; k++) n->lane[k] = s[k];
+}
+#endif
+
+/* Fill out[count] with noise in [-1,1), continuing the lane schedule */
+static inline void noise4_block(noise4_t *n, float *out, uint32_t count)
+{
+    uint32_t i = 0;
+    while(i < count && n->next) out[i++] = noise4_next(n);
+    uint32_t quads = (count - i) / 4;
+    noise4_quads(n, out + i, quads);
+    i += quads * 4;
+    while(i < count) out[i++] = noise4_next(n);
+}
+
+/* Decaying burst: L[i] += (noise * env) * amp and R likewise, with each
+   lane's envelope stepped after use (v1's env *= coef, four lanes apart) */
+static inline void noise4_decay_add(noise4_t *n, float *L, float *R, uint32_t count, float amp)
+{
+    float buf[64];
+    const v4f a = v4_set1(amp), c4 = v4_set1(n->coef4);
+    while(count){
+        uint32_t m = count < 64 ? count : 64;
+        uint32_t k0 = n->next;
+        float e[NOISE4_LANES];
+        for(int k = 0; k < NOISE4_LANES; k++) e[k] = n->env[(k0 + k) & 3];
+        noise4_block(n, buf, m);
+
+        v4f ev = v4_load(e);
+        uint32_t i = 0;
+        for(; i + 4 <= m; i += 4){
+            v4f s = v4_mul(v4_mul(v4_load(buf + i), ev), a);
+            v4_store(L + i, v4_add(v4_load(L + i), s));
+            v4_store(R + i, v4_add(v4_load(R + i), s));
+            ev = v4_mul(ev, c4);
+        }
+        v4_store(e, ev);
+        for(uint32_t k = 0; i < m; i++, k++){
+            float s = (buf[i] * e[k]) * amp;
+            L[i] += s;
+            R[i] += s;
+            e[k] *= n->coef4;
+        }
+        for(int k = 0; k < NOISE4_LANES; k++) n->env[(k0 + k) & 3] = e[k];
+        L += m; R += m; count -= m;
+    }
+}
+
+#endif /* NOISE4_H */
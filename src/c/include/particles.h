@@ -3,20 +3,29 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "rt_frame.h"
 
-#define MAX_PARTICLES 256
+/* Burst particles for the loudest sections: 20 per saw hit, up to 90 frames each */
+#define MAX_PARTICLES 2560
 
+/* Struct-of-arrays store: live particles are packed into [0, count) so the
+   integrator runs four lanes at a time over contiguous floats */
 typedef struct {
-    float x,y;
-    float vx,vy;
-    int life;
-    int max_life;
-    uint32_t color;
-    uint8_t glyph; /* index into glyph set */
-} particle_t;
+    float x[MAX_PARTICLES], y[MAX_PARTICLES];
+    float vx[MAX_PARTICLES], vy[MAX_PARTICLES];
+    int32_t life[MAX_PARTICLES];
+    int32_t max_life[MAX_PARTICLES];
+    uint32_t color[MAX_PARTICLES];
+    uint8_t glyph[MAX_PARTICLES]; /* index into glyph set */
+    int count;
+} particles_t;
 
 void particles_init(void);
 void particles_spawn_burst(float x,float y,int count,uint32_t color);
-void particles_update_and_draw(uint32_t *fb,int w,int h);
+/* Move, age and cull the particles one frame; their glyphs as one run
+   into dl */
+void particles_update(int w,int h,rt_dlist_t *dl);
+/* Glyphs of a run, clipped to rows [y0, y1) of a frame w wide */
+void particles_draw_glyphs(uint32_t *fb,int w,int y0,int y1,const rt_glyph_t *g,int n);
 
 #endif /* PARTICLES_H */ 
\ No newline at end of file
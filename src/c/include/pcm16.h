@@ -0,0 +1,69 @@
+#ifndef PCM16_H
+#define PCM16_H
+
+#include <stdint.h>
+#include "cpu_dispatch.h"
+
+/*
+ * PCM I/O kernels shared by the renderers, the realtime callback and the
+ * WAV readers on the visual side: (de)interleave, int16 <-> float with
+ * saturation, and sums of squares for RMS levels.
+ *
+ * Every path (scalar, SSE2, AVX2, NEON, SVE; cpu_dispatch.h picks one at
+ * run time) gives identical output.  The sums keep four
+ * lane accumulators (sample i goes to lane i % 4, lanes added pairwise,
+ * then the tail in order) on every path, so a level computed on ARM64
+ * matches the one computed on x86-64 bit for bit.
+ *
+ * Plain `float` in the prototypes: the visual build includes this header
+ * without the audio build's -Dfloat32_t=float.
+ */
+
+typedef void (*pcm16_interleave_fn)(const float *L, const float *R, int16_t *out, uint32_t frames);
+typedef void (*pcm16_deinterleave_fn)(const int16_t *in, float *L, float *R, uint32_t frames);
+
+/* Float → 16-bit PCM: clamps each sample to [-1, 1], scales by 32767,
+   truncates toward zero (same rounding as the old `(int16_t)(x*32767)`
+   loops for in-range input) and interleaves L/R. */
+void pcm16_interleave(const float *L, const float *R, int16_t *out, uint32_t frames);
+
+/* Interleaved stereo int16 → planar float in [-1, 1) (s / 32768) */
+void pcm16_deinterleave(const int16_t *in, float *L, float *R, uint32_t frames);
+
+/* `n` int16 samples → float (s / 32768), layout unchanged */
+void pcm16_to_float(const int16_t *in, float *out, uint32_t n);
+
+/* Sum of (s / 32768)^2 over `n` samples, any layout */
+float pcm16_sumsq(const int16_t *in, uint32_t n);
+
+/* Interleaved stereo folded to mono, m = (l + r) / 2 on the normalized
+   samples: sum of m^2 over `frames` frames */
+float pcm16_mono_sumsq(const int16_t *in, uint32_t frames);
+
+/* Integer energy of the same fold: sum of (l + r)^2 over `frames` frames,
+   exact (pcm16_mono_sumsq ~= this / 2^32) and so independent of the
+   summation order, which lets a sliding window add and subtract runs */
+uint64_t pcm16_mono_energy(const int16_t *in, uint32_t frames);
+
+/* Two-band split of the same fold m = l + r, for frames [start, start + frames):
+     low[n]  = m[n - PCM16_BAND_TAPS + 1] + ... + m[n]   (moving sum, ~150 Hz at 44.1 kHz)
+     high[n] = PCM16_BAND_TAPS * m[n - PCM16_BAND_TAPS / 2] - low[n]
+   Frames before 0 count as silence.  *box carries low[] between calls
+   (start at 0 with *box = 0, then call again for the next run); the
+   exact sums of low^2 and high^2 are added to the two energy totals. */
+#define PCM16_BAND_TAPS 128
+void pcm16_band_energy(const int16_t *in, uint32_t start, uint32_t frames, int32_t *box,
+                       uint64_t *low_energy, uint64_t *high_energy);
+
+/* Planar float L/R → interleaved stereo float, no conversion */
+void pcm_interleave_f32(const float *L, const float *R, float *out, uint32_t frames);
+
+/* Sum of x^2 over `n` floats */
+float pcm_sumsq_f32(const float *in, uint32_t n);
+
+/* The `isa` variant of pcm16_interleave / pcm16_deinterleave, NULL when
+   the build has none or this CPU can't run it (bench_audio times each) */
+pcm16_interleave_fn pcm16_interleave_variant(cpu_isa_t isa);
+pcm16_deinterleave_fn pcm16_deinterleave_variant(cpu_isa_t isa);
+
+#endif /* PCM16_H */
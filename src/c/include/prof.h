@@ -0,0 +1,118 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif !defined(__aarch64__)
+#include <time.h>
+#endif
+
+/*
+ * Stage profiler shared by the audio engine and generate_frames.
+ *
+ * A stage is a named span of code timed with the CPU's free-running counter
+ * (TSC on x86-64, cntvct_el0 on ARM64).  Every sample lands in a per-stage
+ * log-linear histogram (p50/p99 within ~6%); with a trace file each sample is
+ * also kept as a Chrome trace_event ("ph":"X") in a per-thread buffer.
+ *
+ * The PROF_* macros compile to nothing unless PROF_ENABLE is defined
+ * (make PROF=1), so uninstrumented builds carry no timer reads at all.
+ * In an instrumented build nothing is recorded until prof_start().
+ *
+ *   PROF_SCOPE(tag, "name")    times the rest of the enclosing block
+ *   PROF_BEGIN(tag, "name") ... PROF_END(tag)   times a statement range
+ *
+ * Counters (prof_counter/prof_count) tally events that have no duration,
+ * such as audio xruns; they are plain functions, live in every build and
+ * are reported next to the stages.
+ */
+
+#define PROF_MAX_STAGES   64
+#define PROF_MAX_COUNTERS 16
+
+static inline uint64_t prof_ticks(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t t;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(t));
+    return t;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* Start recording.  `path` ending in ".csv" gets the per-stage summary,
+   any other path a Chrome trace (chrome://tracing, Perfetto); NULL keeps
+   only the summary.  False if profiling is already running. */
+bool prof_start(const char *path);
+
+/* Print the p50/p99 table to stderr, write the file and stop; 0 on success */
+int prof_finish(void);
+
+bool prof_running(void);
+
+/* Id of the stage called `name`, registering it on first use; -1 when the
+   table is full */
+int prof_stage(const char *name);
+
+/* One sample of `stage` from t0 to t1 (prof_ticks values) */
+void prof_record(int stage, uint64_t t0, uint64_t t1);
+
+/* Id of the counter called `name`, registering it on first use; -1 when
+   the table is full.  Register outside realtime code (takes a spinlock). */
+int prof_counter(const char *name);
+
+/* Add `n` to a counter while profiling runs: one relaxed atomic, safe from
+   any thread including an audio callback */
+void prof_count(int counter, uint64_t n);
+
+/* Write the stages and counters so far as JSON to `path` (through
+   <path>.tmp and a rename, so a reader never sees half a file) while
+   profiling goes on; 0 on success.  Per stage: count, sum, p50/p99/max
+   and cumulative counts at fixed bounds (le_us), for a metrics scraper. */
+int prof_snapshot(const char *path);
+
+/* Stage id cached in *slot by the macros below */
+static inline int prof_stage_cached(int *slot, const char *name)
+{
+    int id = __atomic_load_n(slot, __ATOMIC_RELAXED);
+    if(id < 0){
+        id = prof_stage(name);
+        __atomic_store_n(slot, id, __ATOMIC_RELAXED);
+    }
+    return id;
+}
+
+typedef struct {
+    int stage;
+    uint64_t t0;
+} prof_scope_t;
+
+static inline void prof_scope_end(prof_scope_t *s)
+{
+    prof_record(s->stage, s->t0, prof_ticks());
+}
+
+#ifdef PROF_ENABLE
+#define PROF_BEGIN(tag, name) \
+    static int prof_id_##tag = -1; \
+    const int prof_stage_##tag = prof_stage_cached(&prof_id_##tag, name); \
+    const uint64_t prof_t0_##tag = prof_ticks()
+#define PROF_END(tag) prof_record(prof_stage_##tag, prof_t0_##tag, prof_ticks())
+#define PROF_SCOPE(tag, name) \
+    static int prof_id_##tag = -1; \
+    prof_scope_t prof_scope_##tag __attribute__((cleanup(prof_scope_end))) = \
+        { prof_stage_cached(&prof_id_##tag, name), prof_ticks() }
+#else
+#define PROF_BEGIN(tag, name) do { } while(0)
+#define PROF_END(tag) do { } while(0)
+#define PROF_SCOPE(tag, name) do { } while(0)
+#endif
+
+#endif /* PROF_H */
@@ -3,10 +3,23 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/* Rows [y0, y1) of the calling thread's row window: every primitive (the
+ * clear included) also clips to it, so a band worker (rt_frame.h) draws the
+ * same pixels as a whole-frame draw within its band.  The whole frame until
+ * set; raster_set_rows(0, INT_MAX) restores it. */
+void raster_set_rows(int y0, int y1);
+
 void raster_clear(uint32_t *fb, int w, int h, uint32_t color_rgba);
+/* Pixels x0..x1 (inclusive) of row y, clipped once */
+void raster_hspan(uint32_t *fb, int w, int h, int y, int x0, int x1, uint32_t color_rgba);
+/* Ring r - thickness <= dist <= r, as spans */
 void raster_circle(uint32_t *fb, int w, int h, int cx, int cy, int r, uint32_t color_rgba, int thickness);
+/* The same ring with coverage-blended edges (solid interior as spans) */
+void raster_ring_aa(uint32_t *fb, int w, int h, int cx, int cy, int r, uint32_t color_rgba, int thickness);
 void raster_fill_circle(uint32_t *fb, int w, int h, int cx, int cy, int r, uint32_t color_rgba);
 void raster_line(uint32_t *fb, int w, int h, int x0, int y0, int x1, int y1, uint32_t color_rgba);
+/* Line `width` px across with square caps, filled as spans */
+void raster_thick_line(uint32_t *fb, int w, int h, int x0, int y0, int x1, int y1, int width, uint32_t color_rgba);
 void raster_poly(uint32_t *fb, int w, int h, const int *vx, const int *vy, int n, uint32_t color_rgba, bool fill, int thickness);
 void raster_blit_rgba(const uint32_t *src, int src_w, int src_h, uint32_t *dst_fb, int dst_w, int dst_h, int dx, int dy);
 void raster_blit_rgba_alpha(const uint32_t *src, int src_w, int src_h, uint32_t *dst_fb, int dst_w, int dst_h, int dx, int dy);
@@ -0,0 +1,91 @@
+#ifndef RT_ENGINE_H
+#define RT_ENGINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "generator.h"
+
+/*
+ * Realtime playback engine: one generator driven from an audio callback
+ * (coreaudio.h's audio_callback_t, served by CoreAudio, SDL or ALSA).
+ *
+ * Everything the callback touches is allocated by rt_engine_init, so the
+ * audio thread never mallocs, locks or prints (the realtime objects build
+ * with -DREALTIME_MODE).  Rendering runs in RT_MAX_BLOCK sub-blocks, so a
+ * backend may ask for any number of frames.  What the visuals need (block
+ * level, melody and bass hits) leaves the audio thread only through a
+ * single-producer/single-consumer ring the video loop drains each frame;
+ * the generator itself is never read from another thread.
+ *
+ * Next to the ring, the engine keeps the audio clock: the first frame of
+ * the latest block and when the backend says it will be heard, so the video
+ * thread can tell which events are audible at a given time (rt_sync.h).
+ */
+#define RT_MAX_BLOCK  1024
+#define RT_EVENT_RING 256   /* power of two; ~3 s of events at 512-frame callbacks */
+
+typedef enum {
+    RT_EV_LEVEL = 0,   /* once per callback: value = block RMS */
+    RT_EV_SAW,         /* melody triggered in the block */
+    RT_EV_BASS,        /* FM bass triggered in the block */
+} rt_event_type_t;
+
+typedef struct {
+    uint64_t frame;    /* audio frames rendered before the (sub-)block */
+    float    value;
+    uint16_t type;     /* rt_event_type_t */
+    uint16_t step;     /* pattern step at the end of the (sub-)block */
+} rt_event_t;
+
+/* Lock-free SPSC ring: head is written only by the audio thread, tail only
+   by the video thread, each on its own cache line.  Acquire/release on the
+   indices orders the slot contents; a full ring drops the new event. */
+typedef struct {
+    _Alignas(GENERATOR_CACHE_LINE) uint32_t head;
+    _Alignas(GENERATOR_CACHE_LINE) uint32_t tail;
+    _Alignas(GENERATOR_CACHE_LINE) uint32_t dropped;   /* audio thread; read relaxed */
+    rt_event_t ev[RT_EVENT_RING];
+} rt_event_ring_t;
+
+/* Frame `frame` of the output is heard at pts_ns (audio_clock_ns), as of
+   the latest timestamped block.  A seqlock: the audio thread rewrites it
+   once per callback (seq odd while it does), readers retry on a change. */
+typedef struct {
+    _Alignas(GENERATOR_CACHE_LINE) uint32_t seq;
+    uint64_t frame;
+    uint64_t pts_ns;
+} rt_clock_t;
+
+typedef struct {
+    generator_t gen;
+    float32_t L[RT_MAX_BLOCK], R[RT_MAX_BLOCK];
+    _Alignas(16) float32_t scratch[GENERATOR_SCRATCH_FLOATS(RT_MAX_BLOCK)];
+    uint64_t frames;       /* rendered so far (audio thread) */
+    uint32_t callbacks;    /* relaxed atomic, for diagnostics */
+    rt_event_ring_t ring;
+    rt_clock_t clock;
+} rt_engine_t;
+
+/* Set up `e` for `seed` (not realtime safe: allocates the delay ring and
+   schedule).  Heap-allocated engines need GENERATOR_CACHE_LINE alignment.
+   0 on success. */
+int  rt_engine_init(rt_engine_t *e, uint64_t seed);
+void rt_engine_free(rt_engine_t *e);
+
+/* audio_callback_t: fill `out` with num_frames interleaved stereo frames.
+   `user` is the rt_engine_t. */
+void rt_engine_render(float *out, uint32_t num_frames, void *user);
+
+/* rt_engine_render of a block whose first frame is heard at pts_ns
+   (audio_block_pts); 0 leaves the clock as it was */
+void rt_engine_render_at(rt_engine_t *e, float *out, uint32_t num_frames, uint64_t pts_ns);
+
+/* Any thread: the latest clock stamp.  False until a timestamped block. */
+bool rt_engine_clock(rt_engine_t *e, uint64_t *frame, uint64_t *pts_ns);
+
+/* Video thread: move up to `max` pending events into `out`, oldest first.
+   Returns how many. */
+size_t rt_engine_poll(rt_engine_t *e, rt_event_t *out, size_t max);
+
+#endif /* RT_ENGINE_H */
@@ -0,0 +1,119 @@
+#ifndef RT_FRAME_H
+#define RT_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "crt_fx.h"
+
+/*
+ * Tile-parallel frame renderer for the realtime player.
+ *
+ * The frame logic (shapes, particles, spawns; everything that advances
+ * state or draws from rand()) runs once per frame on the calling thread and
+ * records what it would draw into a display list: clears, circles, rings,
+ * the terrain strip, shape outlines and runs of particle glyphs, in drawing
+ * order, each with the rows it can touch.  The list is then read-only.
+ *
+ * rt_bands_render splits the framebuffer into horizontal bands.  Workers
+ * (and the calling thread) claim bands from a shared counter, so a worker
+ * whose bands were cheap takes over the rest of the queue; each one replays
+ * the list clipped to its band (raster_set_rows), skipping records outside
+ * it, then runs crt_fx's row effects over the band while it is in cache.
+ * The caller waits for every band, adds the CRT noise pixels (one RNG
+ * stream, so serially) and only then returns the frame for presentation.
+ * Every band draws the pixels a whole-frame draw does, so the frame is the
+ * same for any thread count or band height.
+ */
+
+#define RT_DL_MAX_CMDS   64
+#define RT_DL_MAX_VERTS  128     /* MAX_SHAPES outlines of up to 10 vertices */
+#define RT_DL_MAX_GLYPHS 2560    /* MAX_PARTICLES */
+#define RT_BANDS_MAX_THREADS 16
+
+typedef enum {
+    RT_CMD_CLEAR,            /* color */
+    RT_CMD_FILL_CIRCLE,      /* x, y, r, color */
+    RT_CMD_RING_AA,          /* x, y, r, thickness, color */
+    RT_CMD_TERRAIN,          /* terrain_draw of frame x */
+    RT_CMD_OUTLINE,          /* n vertices from first, thickness, color */
+    RT_CMD_GLYPHS            /* n glyphs from first */
+} rt_cmd_type_t;
+
+typedef struct {
+    uint8_t type;            /* rt_cmd_type_t */
+    int x, y, r, thickness;
+    int first, n;
+    uint32_t color;
+    int top, bottom;         /* rows the record can touch, inclusive */
+} rt_cmd_t;
+
+/* One 5x7 particle glyph, top-left at (x, y), color already faded */
+typedef struct {
+    int16_t x, y;
+    uint8_t glyph;
+    uint32_t color;
+} rt_glyph_t;
+
+typedef struct {
+    int w, h;
+    int ncmds, nverts, nglyphs;
+    rt_cmd_t cmds[RT_DL_MAX_CMDS];
+    int vx[RT_DL_MAX_VERTS], vy[RT_DL_MAX_VERTS];
+    rt_glyph_t glyphs[RT_DL_MAX_GLYPHS];
+} rt_dlist_t;
+
+/* Start an empty list for a w x h frame.  Records past the capacities are
+   dropped. */
+void rt_dl_begin(rt_dlist_t *dl, int w, int h);
+void rt_dl_clear(rt_dlist_t *dl, uint32_t color);
+void rt_dl_fill_circle(rt_dlist_t *dl, int cx, int cy, int r, uint32_t color);
+void rt_dl_ring_aa(rt_dlist_t *dl, int cx, int cy, int r, uint32_t color, int thickness);
+/* terrain_draw(fb, w, h, frame); it draws rows top..h-1 */
+void rt_dl_terrain(rt_dlist_t *dl, int frame, int top);
+/* raster_poly outline */
+void rt_dl_outline(rt_dlist_t *dl, const int *vx, const int *vy, int n, uint32_t color, int thickness);
+/* Room for a run of glyphs, *n at most; rt_dl_glyphs_end records the ones
+   written */
+rt_glyph_t *rt_dl_glyphs_begin(rt_dlist_t *dl, int *n);
+void rt_dl_glyphs_end(rt_dlist_t *dl, int used);
+
+/* Draw rows [y0, y1) of the list into fb (stride dl->w) */
+void rt_dl_draw(const rt_dlist_t *dl, uint32_t *fb, int y0, int y1);
+
+/* Worker pool */
+typedef struct rt_worker rt_worker_t;
+
+typedef struct {
+    int threads;                     /* workers, the calling thread included */
+    int w, h;
+    int band_rows, bands;
+    uint32_t *scratch;               /* two rows per thread for crt_fx */
+    size_t scratch_stride;
+    pthread_t tids[RT_BANDS_MAX_THREADS];
+    rt_worker_t *workers;
+
+    /* The frame in flight; a new generation wakes the workers */
+    pthread_mutex_t lock;
+    pthread_cond_t wake, done_cv;
+    uint32_t generation;
+    int running;                     /* workers still in the frame */
+    bool quit;
+    const rt_dlist_t *dl;
+    uint32_t *fb;
+    const crt_fx_t *fx;
+    int frame;
+    int next_band;                   /* atomic: bands claimed so far */
+} rt_bands_t;
+
+/* Pool of `threads` (1..RT_BANDS_MAX_THREADS; 1 renders on the caller
+   alone) for w x h frames.  0 on success. */
+int  rt_bands_init(rt_bands_t *b, int threads, int w, int h);
+void rt_bands_free(rt_bands_t *b);
+
+/* The list into fb, then crt_fx_apply's effects (fx may be NULL): the same
+   pixels as drawing the list and calling crt_fx_apply on one thread.
+   Returns once every band is done. */
+void rt_bands_render(rt_bands_t *b, const rt_dlist_t *dl, uint32_t *fb, crt_fx_t *fx, int frame);
+
+#endif /* RT_FRAME_H */
@@ -0,0 +1,62 @@
+#ifndef RT_SYNC_H
+#define RT_SYNC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "rt_engine.h"
+
+/*
+ * Audio-clocked frame scheduler for the realtime player.
+ *
+ * The engine renders a few periods ahead of the DAC, so the newest events
+ * in its ring have not been heard yet.  Each callback stamps the engine's
+ * clock with when its first frame will be heard; the scheduler follows
+ * that clock (smoothed, snapping after an xrun) to map a host time to the
+ * audio frame audible then.  Per video frame, given when the frame will be
+ * on screen (video_frame_lead_ns), rt_sync_frame:
+ *   - hands out only the events heard by then, keeping the rest queued, so
+ *     the level and hits drawn are the ones audible as the frame shows;
+ *   - says how many animation ticks (1/fps each) the frame advances: 1
+ *     normally, more when video has fallen a whole frame or more behind
+ *     the audio (the ticks between are stepped, not drawn), 0 when it has
+ *     run a frame ahead (the last frame stays up).  Errors under a frame
+ *     are left alone, so jitter in the estimates never becomes judder.
+ * Until a block is timestamped every event goes out at once and each
+ * frame is one tick, as without the scheduler.
+ */
+#define RT_SYNC_MAX_CATCHUP 4          /* ticks one frame may drop; further behind resyncs */
+#define RT_SYNC_SNAP_NS     50000000ll /* a stamp this far off the clock replaces it */
+
+typedef struct {
+    uint32_t sample_rate;
+    int fps;                     /* ticks per second; 0 = one per frame, no drops */
+
+    /* Audio clock: anchor_frame is heard at anchor_ns */
+    bool anchored;
+    uint64_t anchor_frame, anchor_ns;
+    uint64_t stamp_frame;        /* the engine's stamp last folded in */
+
+    /* Animation: tick t is due when audio frame base + t * sample_rate / fps is heard */
+    bool started;
+    uint64_t base;
+    int64_t tick;
+
+    rt_event_t pending[RT_EVENT_RING];   /* polled, not yet heard */
+    size_t npending;
+
+    /* Diagnostics */
+    uint64_t dropped, held;      /* ticks skipped, frames held */
+    float error_ms;              /* audio ahead of the frame shown (+), after correction */
+    int prof_dropped, prof_held; /* "av.dropped", "av.held" prof counters */
+} rt_sync_t;
+
+/* Schedule for audio at sample_rate and fps animation ticks per second */
+void rt_sync_init(rt_sync_t *s, uint32_t sample_rate, int fps);
+
+/* Video thread, once per frame: drain the engine and move the events heard
+   by shown_ns (audio_clock_ns) into out, oldest first, *n of them (max at
+   least RT_EVENT_RING).  Returns the ticks the frame advances. */
+int rt_sync_frame(rt_sync_t *s, rt_engine_t *e, uint64_t shown_ns, rt_event_t *out, size_t max, size_t *n);
+
+#endif /* RT_SYNC_H */
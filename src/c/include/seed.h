@@ -0,0 +1,37 @@
+#ifndef SEED_H
+#define SEED_H
+
+#include <stdint.h>
+
+/*
+ * One seed derivation for every binary (segment, seed_farm, realtime,
+ * export_timeline, generate_frames, notdeafbeef) and for batch_steps.py.
+ *
+ * A seed string is parsed once into its value, up to 256 bits: "0x" hex of
+ * 1..64 digits (a transaction hash), plain decimal that fits 64 bits, or
+ * unprefixed hex (a hash pasted without its 0x).  Both streams come from
+ * that value:
+ *
+ *   audio   64-bit generator seed (rng_t): the value itself when it fits
+ *           64 bits, so every short seed renders as before; else XXH64 of
+ *           the 32 big-endian bytes.  (strtoull used to saturate every
+ *           longer hash to 0xffffffffffffffff.)
+ *   visual  32-bit prng_t seed: XOR of the value's eight big-endian 32-bit
+ *           words, 0 mapped to 0xDEADBEEF (hash_transaction_to_seed's fold
+ *           for hex of up to 8 digits or of a multiple of 8 digits)
+ */
+
+typedef struct {
+    uint8_t value[32];      /* big endian, right aligned: "0x1" -> value[31] = 1 */
+    uint64_t audio;
+    uint32_t visual;
+} ndb_seed_t;
+
+/* 0 on success, -1 (out untouched) when `str` is not a seed */
+int ndb_seed_parse(const char *str, ndb_seed_t *out);
+/* From a 32-byte big-endian value (blockchain/seed.s SEED_BYTES order) */
+void ndb_seed_from_bytes(const uint8_t value[32], ndb_seed_t *out);
+/* A 64-bit value, as the tools' built-in defaults (0xCAFEBABE) */
+void ndb_seed_from_u64(uint64_t value, ndb_seed_t *out);
+
+#endif /* SEED_H */
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "rt_frame.h"
 
 #define MAX_SHAPES 8
 
@@ -25,6 +26,8 @@ typedef struct {
 
 void shapes_init(void);
 void shapes_spawn(shape_type_t type, uint32_t color);
-void shapes_update_and_draw(uint32_t *fb, int w, int h);
+/* Grow, fade and turn the shapes one frame; outlines of the live ones
+   into dl */
+void shapes_update(int w, int h, rt_dlist_t *dl);
 
 #endif /* SHAPES_H */ 
\ No newline at end of file
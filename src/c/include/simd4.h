@@ -0,0 +1,183 @@
+#ifndef SIMD4_H
+#define SIMD4_H
+
+/*
+ * simd4.h – minimal 4-lane float vector layer for the C DSP kernels.
+ *
+ * Backends: NEON (AArch64), SSE2 (x86-64 baseline), WebAssembly SIMD128
+ * (the browser build, make wasm) and a plain-C lane loop.  Every helper
+ * is built only from IEEE add/sub/mul/div, compares and selects, so all
+ * the backends give bit-identical results, and scalar tails run through
+ * the same code on a padded vector.  Callers must not let the compiler
+ * contract a*b+c into FMA (the NEON path uses explicit vmulq/vaddq; C
+ * call sites build with -ffp-contract=off and, for clang, add
+ * `#pragma STDC FP_CONTRACT OFF`, which GCC would warn about).
+ */
+
+#include <stdint.h>
+
+#if defined(__ARM_NEON) && !defined(SIMD4_SCALAR)
+  /* arm_neon.h typedefs float32_t; drop the -Dfloat32_t=float helper */
+  #ifdef float32_t
+  #undef float32_t
+  #endif
+  #include <arm_neon.h>
+  #define SIMD4_NEON 1
+  typedef float32x4_t v4f;
+  typedef uint32x4_t  v4m;   /* lane mask */
+#elif defined(__SSE2__) && !defined(SIMD4_SCALAR)
+  #include <emmintrin.h>
+  #define SIMD4_SSE2 1
+  typedef __m128 v4f;
+  typedef __m128 v4m;
+#elif defined(__wasm_simd128__) && !defined(SIMD4_SCALAR)
+  #include <wasm_simd128.h>
+  #define SIMD4_WASM 1
+  typedef v128_t v4f;
+  typedef v128_t v4m;
+#else
+  #define SIMD4_C 1
+  typedef struct { float v[4]; } v4f;
+  typedef struct { uint32_t v[4]; } v4m;
+#endif
+
+#define SIMD4_TAU     6.28318530717958647692f
+#define SIMD4_PI      3.14159265358979323846f
+#define SIMD4_INV_PI  0.31830988618379067154f
+
+/* ---- basic ops -------------------------------------------------------- */
+#if SIMD4_NEON
+static inline v4f v4_set1(float x)                 { return vdupq_n_f32(x); }
+static inline v4f v4_load(const float *p)          { return vld1q_f32(p); }
+static inline void v4_store(float *p, v4f a)       { vst1q_f32(p, a); }
+static inline v4f v4_add(v4f a, v4f b)             { return vaddq_f32(a, b); }
+static inline v4f v4_sub(v4f a, v4f b)             { return vsubq_f32(a, b); }
+static inline v4f v4_mul(v4f a, v4f b)             { return vmulq_f32(a, b); }
+static inline v4f v4_div(v4f a, v4f b)             { return vdivq_f32(a, b); }
+static inline v4f v4_abs(v4f a)                    { return vabsq_f32(a); }
+static inline v4f v4_max(v4f a, v4f b)             { return vmaxq_f32(a, b); }
+static inline v4m v4_lt(v4f a, v4f b)              { return vcltq_f32(a, b); }
+static inline v4m v4_gt(v4f a, v4f b)              { return vcgtq_f32(a, b); }
+static inline v4f v4_select(v4m m, v4f a, v4f b)   { return vbslq_f32(m, a, b); }
+#elif SIMD4_SSE2
+static inline v4f v4_set1(float x)                 { return _mm_set1_ps(x); }
+static inline v4f v4_load(const float *p)          { return _mm_loadu_ps(p); }
+static inline void v4_store(float *p, v4f a)       { _mm_storeu_ps(p, a); }
+static inline v4f v4_add(v4f a, v4f b)             { return _mm_add_ps(a, b); }
+static inline v4f v4_sub(v4f a, v4f b)             { return _mm_sub_ps(a, b); }
+static inline v4f v4_mul(v4f a, v4f b)             { return _mm_mul_ps(a, b); }
+static inline v4f v4_div(v4f a, v4f b)             { return _mm_div_ps(a, b); }
+static inline v4f v4_abs(v4f a)                    { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline v4f v4_max(v4f a, v4f b)             { return _mm_max_ps(a, b); }
+static inline v4m v4_lt(v4f a, v4f b)              { return _mm_cmplt_ps(a, b); }
+static inline v4m v4_gt(v4f a, v4f b)              { return _mm_cmpgt_ps(a, b); }
+static inline v4f v4_select(v4m m, v4f a, v4f b)   { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+#elif SIMD4_WASM
+static inline v4f v4_set1(float x)                 { return wasm_f32x4_splat(x); }
+static inline v4f v4_load(const float *p)          { return wasm_v128_load(p); }
+static inline void v4_store(float *p, v4f a)       { wasm_v128_store(p, a); }
+static inline v4f v4_add(v4f a, v4f b)             { return wasm_f32x4_add(a, b); }
+static inline v4f v4_sub(v4f a, v4f b)             { return wasm_f32x4_sub(a, b); }
+static inline v4f v4_mul(v4f a, v4f b)             { return wasm_f32x4_mul(a, b); }
+static inline v4f v4_div(v4f a, v4f b)             { return wasm_f32x4_div(a, b); }
+static inline v4f v4_abs(v4f a)                    { return wasm_f32x4_abs(a); }
+/* a > b ? a : b, as the C lanes do (f32x4.max would propagate NaN) */
+static inline v4f v4_max(v4f a, v4f b)             { return wasm_v128_bitselect(a, b, wasm_f32x4_gt(a, b)); }
+static inline v4m v4_lt(v4f a, v4f b)              { return wasm_f32x4_lt(a, b); }
+static inline v4m v4_gt(v4f a, v4f b)              { return wasm_f32x4_gt(a, b); }
+static inline v4f v4_select(v4m m, v4f a, v4f b)   { return wasm_v128_bitselect(a, b, m); }
+#else
+#define V4_LANES(expr) do { for (int k_ = 0; k_ < 4; ++k_) { expr; } } while (0)
+static inline v4f v4_set1(float x)                 { v4f r; V4_LANES(r.v[k_] = x); return r; }
+static inline v4f v4_load(const float *p)          { v4f r; V4_LANES(r.v[k_] = p[k_]); return r; }
+static inline void v4_store(float *p, v4f a)       { V4_LANES(p[k_] = a.v[k_]); }
+static inline v4f v4_add(v4f a, v4f b)             { v4f r; V4_LANES(r.v[k_] = a.v[k_] + b.v[k_]); return r; }
+static inline v4f v4_sub(v4f a, v4f b)             { v4f r; V4_LANES(r.v[k_] = a.v[k_] - b.v[k_]); return r; }
+static inline v4f v4_mul(v4f a, v4f b)             { v4f r; V4_LANES(r.v[k_] = a.v[k_] * b.v[k_]); return r; }
+static inline v4f v4_div(v4f a, v4f b)             { v4f r; V4_LANES(r.v[k_] = a.v[k_] / b.v[k_]); return r; }
+static inline v4f v4_abs(v4f a)                    { v4f r; V4_LANES(r.v[k_] = a.v[k_] < 0.0f ? -a.v[k_] : a.v[k_]); return r; }
+static inline v4f v4_max(v4f a, v4f b)             { v4f r; V4_LANES(r.v[k_] = a.v[k_] > b.v[k_] ? a.v[k_] : b.v[k_]); return r; }
+static inline v4m v4_lt(v4f a, v4f b)              { v4m r; V4_LANES(r.v[k_] = a.v[k_] < b.v[k_] ? ~0u : 0u); return r; }
+static inline v4m v4_gt(v4f a, v4f b)              { v4m r; V4_LANES(r.v[k_] = a.v[k_] > b.v[k_] ? ~0u : 0u); return r; }
+static inline v4f v4_select(v4m m, v4f a, v4f b)   { v4f r; V4_LANES(r.v[k_] = m.v[k_] ? a.v[k_] : b.v[k_]); return r; }
+#endif
+
+/* Largest lane (NaN-free input assumed) */
+static inline float v4_hmax(v4f a)
+{
+    float l[4];
+    v4_store(l, a);
+    float m = l[0] > l[1] ? l[0] : l[1];
+    float n = l[2] > l[3] ? l[2] : l[3];
+    return m > n ? m : n;
+}
+
+/* Round to nearest (ties-to-even) for |x| < 2^22 via the 1.5*2^23 trick;
+   exact on every backend and independent of libm. */
+static inline v4f v4_round(v4f x)
+{
+    const v4f magic = v4_set1(12582912.0f);
+    return v4_sub(v4_add(x, magic), magic);
+}
+
+static inline v4f v4_floor(v4f x)
+{
+    v4f r = v4_round(x);
+    return v4_select(v4_gt(r, x), v4_sub(r, v4_set1(1.0f)), r);
+}
+
+/* ---- deterministic transcendental approximations ---------------------- */
+
+/* sin(x) for |x| < 2^21: reduce by multiples of π to [-π/2, π/2], then a
+   degree-9 odd polynomial (max error ~2e-7). */
+static inline v4f v4_sin(v4f x)
+{
+    v4f n = v4_round(v4_mul(x, v4_set1(SIMD4_INV_PI)));
+    /* two-part π for the reduction keeps phases near 2π accurate */
+    x = v4_sub(x, v4_mul(n, v4_set1(3.140625f)));
+    x = v4_sub(x, v4_mul(n, v4_set1(9.67653589793e-4f)));
+    /* odd multiple of π flips the sign */
+    v4f half = v4_mul(n, v4_set1(0.5f));
+    v4m odd  = v4_gt(v4_abs(v4_sub(half, v4_floor(half))), v4_set1(0.25f));
+    x = v4_select(odd, v4_sub(v4_set1(0.0f), x), x);
+
+    v4f z = v4_mul(x, x);
+    v4f p = v4_set1(2.7557314297e-6f);
+    p = v4_add(v4_mul(p, z), v4_set1(-1.9841270114e-4f));
+    p = v4_add(v4_mul(p, z), v4_set1(8.3333337670e-3f));
+    p = v4_add(v4_mul(p, z), v4_set1(-1.6666664611e-1f));
+    return v4_add(x, v4_mul(v4_mul(x, z), p));
+}
+
+/* exp(x) clamped to [-87, 88]: 2^n * P(r) with a Cephes degree-5 core. */
+static inline v4f v4_exp(v4f x)
+{
+    x = v4_select(v4_gt(x, v4_set1(88.0f)), v4_set1(88.0f), x);
+    x = v4_select(v4_lt(x, v4_set1(-87.0f)), v4_set1(-87.0f), x);
+
+    v4f n = v4_floor(v4_add(v4_mul(x, v4_set1(1.44269504088896341f)), v4_set1(0.5f)));
+    x = v4_sub(x, v4_mul(n, v4_set1(0.693359375f)));
+    x = v4_sub(x, v4_mul(n, v4_set1(-2.12194440e-4f)));
+
+    v4f z = v4_mul(x, x);
+    v4f p = v4_set1(1.9875691500e-4f);
+    p = v4_add(v4_mul(p, x), v4_set1(1.3981999507e-3f));
+    p = v4_add(v4_mul(p, x), v4_set1(8.3333519073e-3f));
+    p = v4_add(v4_mul(p, x), v4_set1(4.1665795894e-2f));
+    p = v4_add(v4_mul(p, x), v4_set1(1.6666665459e-1f));
+    p = v4_add(v4_mul(p, x), v4_set1(5.0000001201e-1f));
+    p = v4_add(v4_add(v4_mul(p, z), x), v4_set1(1.0f));
+
+    /* scale by 2^n: n is an exact small integer, build the exponent bits */
+    float nf[4], pf[4];
+    v4_store(nf, n);
+    v4_store(pf, p);
+    for (int k = 0; k < 4; ++k) {
+        union { uint32_t u; float f; } s;
+        s.u = (uint32_t)((int32_t)nf[k] + 127) << 23;
+        pf[k] *= s.f;
+    }
+    return v4_load(pf);
+}
+
+#endif /* SIMD4_H */
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "rand.h"
+#include "noise4.h"
 
 typedef struct {
     uint32_t pos;
@@ -11,10 +12,16 @@ typedef struct {
     float32_t env;        /* current envelope value */
     float32_t env_coef;   /* per-sample decay coefficient */
     rng_t rng;
+    uint32_t noise_version;  /* NOISE_V1: rng; NOISE_V2: noise4 */
+    noise4_t noise4;
 } snare_t;
 
 void snare_init(snare_t *s, float32_t sr, uint64_t seed);
+/* snare_init with the noise engine picked: NOISE_V1 or NOISE_V2 */
+void snare_init_noise(snare_t *s, float32_t sr, uint64_t seed, uint32_t version);
 void snare_trigger(snare_t *s);
 void snare_process(snare_t *s, float32_t *L, float32_t *R, uint32_t n);
+/* NOISE_V2 voices: always C (the .s port renders v1 only) */
+void snare_process_v2(snare_t *s, float32_t *L, float32_t *R, uint32_t n);
 
 #endif /* SNARE_H */ 
\ No newline at end of file
@@ -19,5 +19,7 @@ typedef struct {
 
 void terrain_init(uint64_t seed);
 void terrain_draw(uint32_t *fb, int w, int h, int frame);
+/* First row terrain_draw can touch in a frame h rows high */
+int terrain_top(int h);
 
 #endif /* TERRAIN_H */ 
\ No newline at end of file
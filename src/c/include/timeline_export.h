@@ -0,0 +1,32 @@
+#ifndef TIMELINE_EXPORT_H
+#define TIMELINE_EXPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "generator_plan.h"
+
+/*
+ * Write the JSON timeline sidecar (seed, tempo, step/beat grid, events)
+ * for a seed plan.  Only reads `p`, so it is safe to call from several
+ * threads at once.
+ * Returns 0 on success, -1 if `path` could not be opened.
+ */
+int timeline_export_json(const generator_plan_t *p, const char *path);
+
+/*
+ * Write the binary timeline sidecar (tl_bin_header_t + steps, beats and
+ * packed events, see src/include/timeline.h) that timeline_load maps
+ * without parsing.  The JSON writer above is kept as a debug export.
+ * Same threading and return conventions as timeline_export_json.
+ */
+int timeline_export_bin(const generator_plan_t *p, const char *path);
+
+/*
+ * The same binary image assembled in `buf` (e.g. for the notdeafbeef
+ * driver, which never writes the sidecar).  Returns the image size; the
+ * buffer is only written when `cap` is at least that, so a NULL/0 call
+ * sizes it first.
+ */
+size_t timeline_export_bin_mem(const generator_plan_t *p, void *buf, size_t cap);
+
+#endif /* TIMELINE_EXPORT_H */
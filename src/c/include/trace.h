@@ -0,0 +1,82 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Binary event trace for the audio engine's hot paths (step triggers,
+ * voice triggers), in place of printf.
+ *
+ * TRACE_LEVEL is fixed at compile time (make TRACE=1 or TRACE=2).  At 0,
+ * the default, TRACE() expands to nothing and no trace code is linked in.
+ *   1  every event the schedule fires and each voice trigger
+ *   2  also step ends and block diagnostics
+ *
+ * Records go to one fixed-size ring shared by every thread: a writer claims
+ * a slot with one atomic add and fills it, so no lock, no allocation and
+ * no syscall is ever taken.  When the ring wraps, the oldest records are
+ * overwritten.  At exit the ring is written to $NDB_TRACE (default
+ * ndb_trace.bin) for bin/trace_dump to print.
+ */
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL 0
+#endif
+
+#define TRACE_RING_BITS 16              /* 64K records, 2.5 MB */
+#define TRACE_ARGS      6
+#define TRACE_MAGIC     "NDBTRACE"
+#define TRACE_VERSION   1u
+
+typedef enum {
+    TRACE_NONE = 0,
+    TRACE_EVENT,        /* type, aux, step, pos */
+    TRACE_MID,          /* step, aux, pos */
+    TRACE_STEP_END,     /* event_idx, step, pos */
+    TRACE_KICK,         /* len, env_coef, y_prev2, k1 */
+    TRACE_HAT,          /* len, env_coef */
+    TRACE_MELODY,       /* freq, dur, len */
+    TRACE_FM,           /* carrier, dur, ratio, index, amp, len */
+    TRACE_KICK_BLOCK,   /* frames, peak of the first 100 */
+    TRACE_KINDS
+} trace_kind_t;
+
+/* One record; the file is a trace_file_hdr_t and then `count` of these,
+   oldest first.  Arguments are u32, or floats stored by bit pattern. */
+typedef struct {
+    uint64_t ticks;                 /* prof_ticks() */
+    uint32_t seq;                   /* claim order + 1; 0 while being written */
+    uint16_t kind;                  /* trace_kind_t */
+    uint16_t thread;                /* writer, in order of first record */
+    uint32_t arg[TRACE_ARGS];
+} trace_rec_t;
+
+typedef struct {
+    char magic[8];                  /* TRACE_MAGIC */
+    uint32_t version;               /* TRACE_VERSION */
+    uint32_t count;                 /* records that follow */
+    uint64_t emitted;               /* records claimed, counting those lost to wrap */
+    uint64_t ticks_per_sec;         /* 0 when unknown */
+} trace_file_hdr_t;
+
+static inline uint32_t trace_f32(float x)
+{
+    uint32_t u;
+    memcpy(&u, &x, sizeof u);
+    return u;
+}
+
+#if TRACE_LEVEL > 0
+void trace_emit(trace_kind_t kind, uint32_t a0, uint32_t a1, uint32_t a2,
+                uint32_t a3, uint32_t a4, uint32_t a5);
+/* Write the ring now (it is also written at exit); 0 on success */
+int trace_flush(const char *path);
+
+#define TRACE(level, kind, a0, a1, a2, a3, a4, a5) \
+    do{ if((level) <= TRACE_LEVEL) trace_emit((kind), (a0), (a1), (a2), (a3), (a4), (a5)); }while(0)
+#else
+#define TRACE(level, kind, a0, a1, a2, a3, a4, a5) ((void)0)
+#endif
+
+#endif /* TRACE_H */
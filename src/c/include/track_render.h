@@ -0,0 +1,63 @@
+#ifndef TRACK_RENDER_H
+#define TRACK_RENDER_H
+
+#include <stdint.h>
+#include "wav_writer.h"
+
+/*
+ * Offline track renderer shared by segment and the notdeafbeef driver:
+ * one seed in, an opened wav_stream_t (file or memory) out, SEG_BLOCK
+ * frames at a time.  Uses static generators and block buffers, so one
+ * call renders at a time per process (seed_farm has its own per-worker
+ * loop for parallel renders).
+ */
+typedef struct {
+    int limit;          /* lookahead limiter ahead of the int16 conversion */
+    uint32_t repeat;    /* >= 1 whole loops in one pass */
+    uint32_t bars;      /* > 0: continuous mode, overrides repeat */
+    int arrange;        /* with bars: generator_arrange sections, no loop tag */
+    int euclid;         /* Euclidean drum patterns from the seed's hit counts */
+    int noise_v2;       /* four-lane noise engine (GEN_INIT_NOISE_V2); v1 otherwise */
+    int verbose;        /* debug prints and the RMS diagnostic */
+    uint32_t rate_div;  /* draft at SR / rate_div (2 or 4; 0 or 1 full rate):
+                           open the WAV at that rate, frames in info count it */
+    int fm_pool;        /* overlapping mid/bass FM notes (GEN_INIT_FM_POOL) */
+    int tail;           /* after the last loop, ring out to silence (generator_hold) */
+} track_opts_t;
+
+typedef struct {
+    uint32_t total_frames;              /* tail included */
+    uint32_t tail_frames;               /* --tail: frames after the last loop */
+    uint32_t seg_frames;                /* one loop */
+    uint32_t loop_start, loop_end;      /* seamless region, end 0 if none */
+    float bpm;
+    float root_freq;
+} track_info_t;
+
+/* Render `seed` into `wav` (already opened; not closed here).
+   Returns 0 on success, -1 on an append error. */
+int track_render(uint64_t seed, wav_stream_t *wav, const track_opts_t *opt, track_info_t *info);
+
+/* The lengths and loop tag track_render would report in `info`, without
+   rendering (to size a wav_stream_open_buf image).  opt->tail's ring-out
+   is only known by rendering: tail_frames stays 0.  0, or -1 with
+   opt->tail. */
+int track_measure(uint64_t seed, const track_opts_t *opt, track_info_t *info);
+
+/* track_render with every voice group in its own WAV as well:
+   stems[s] (GEN_STEMS of them, opened like `wav`; names in
+   generator_stem_names, generator.h) gets stem s and
+   `wav` the mix, all from one generator pass.  The stems sum to the mix
+   and carry its loop tag.  No limiter (-1 with opt->limit): stems of a
+   limited mix would not add up to it. */
+int track_render_stems(uint64_t seed, wav_stream_t *wav, wav_stream_t *const stems[],
+                       const track_opts_t *opt, track_info_t *info);
+
+/* Up to GEN_LANES seeds at once through generator_process_lanes, one seed
+   per SIMD lane in the voices that have lane kernels; each wavs[l] gets
+   the same bytes track_render would write.  rc[l] is each track's result,
+   info may be NULL; -1 if any track failed. */
+int track_render_lanes(const uint64_t seeds[], wav_stream_t *const wavs[], uint32_t lanes,
+                       const track_opts_t *opt, track_info_t info[], int rc[]);
+
+#endif /* TRACK_RENDER_H */
@@ -8,23 +8,71 @@
  * This is intentionally minimal for Stage-1 scaffolding.
  */
 
-/* Initialise window & renderer.
+/* How frames reach the streaming texture */
+typedef enum {
+    VIDEO_PRESENT_LOCK,   /* draw straight into SDL_LockTexture memory (zero copy);
+                             falls back to COPY if the texture's pitch isn't width*4 */
+    VIDEO_PRESENT_COPY    /* draw into a software framebuffer, SDL_UpdateTexture at frame end */
+} video_present_t;
+
+typedef struct {
+    int width, height;    /* window size (pixels) */
+    int fps;              /* target frame-rate (logical). 0 = uncapped. */
+    bool vsync;           /* true = present on vblank and pace by it; false = timer */
+    video_present_t present;
+    bool render_ahead;    /* video_run draws on its own thread into two software
+                             buffers, one frame ahead of presentation */
+} video_config_t;
+
+#define VIDEO_CONFIG_DEFAULT { 800, 600, 30, true, VIDEO_PRESENT_LOCK, false }
+
+/* Initialise window & renderer.  Returns 0 on success, non-zero on failure. */
+int  video_open(const video_config_t *cfg);
+
+/* video_open with the default present mode and no render-ahead.
  * width/height → window size (pixels)
  * fps          → target frame-rate (logical). 0 = uncapped.
  * vsync        → true  = let SDL use VSYNC; false = immediate.
- * Returns 0 on success, non-zero on failure.
  */
 int  video_init(int width, int height, int fps, bool vsync);
 
-/* Begin a new frame. Handles frame pacing, event polling, clears the screen.
+/* Begin a new frame: event polling, and in LOCK mode mapping the texture.
  * Returns false when the user has requested to quit (e.g. window close).
+ * The framebuffer's contents are undefined until drawn: clear it.
  */
 bool video_frame_begin(void);
 
-/* End the frame: present back-buffer. */
+/* End the frame: upload (COPY) or unmap (LOCK), present and pace.  With
+ * vsync the present lands on the vblank fps asks for: frames are shown for
+ * refresh / fps vblanks, fewer when a frame ran late. */
 void video_frame_end(void);
 
-/* Accessors for software framebuffer */
+/* End the frame without presenting it */
+void video_frame_drop(void);
+
+/* Present the frame being drawn shifted by (dx, dy) pixels, the uncovered
+ * edge black (screen shake without touching the framebuffer).  Call from
+ * the draw callback; every frame starts at (0, 0). */
+void video_frame_offset(int dx, int dy);
+
+/* From the draw callback: how long from now (ns) until the frame being
+ * drawn is expected on screen.  Counts the draw itself (a running estimate
+ * that follows slow frames at once and fast ones slowly), the wait for the
+ * vblank it lands on (or none, on the timer) and, with render_ahead, the
+ * frame presented before it; not the compositor or the panel. */
+uint64_t video_frame_lead_ns(void);
+
+/* Per-frame draw callback for video_run: draw a whole frame into fb (stride
+ * w) and return false to drop it instead of presenting */
+typedef bool (*video_draw_fn)(uint32_t *fb, int w, int h, void *user);
+
+/* Run frames until the window is closed.  With render_ahead, draw runs on a
+ * render thread (and is the only caller of anything it touches) while this
+ * thread presents the previous frame; otherwise it is begin/draw/end here. */
+int  video_run(video_draw_fn draw, void *user);
+
+/* Accessors for the framebuffer of the current frame (in LOCK mode it moves
+ * from frame to frame: fetch it after video_frame_begin) */
 uint32_t* video_get_framebuffer(void);
 int video_get_width(void);
 int video_get_height(void);
@@ -32,4 +80,4 @@ int video_get_height(void);
 /* Shutdown & free resources. */
 void video_shutdown(void);
 
-#endif /* VIDEO_H */ 
\ No newline at end of file
+#endif /* VIDEO_H */
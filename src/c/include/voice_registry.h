@@ -0,0 +1,85 @@
+#ifndef VOICE_REGISTRY_H
+#define VOICE_REGISTRY_H
+
+#include <stddef.h>
+#include "generator.h"
+
+/*
+ * Table of the generator's voices.  generator_init, generator_trigger_step,
+ * generator_sweep_voices and the C generator_process walk it instead of
+ * naming each voice, so a new timbre is one state field in generator_t plus
+ * one entry in voice_registry.c (generator.s keeps its own fixed voice list
+ * through offsets.inc and needs no change).
+ *
+ * process_block contract:
+ *   - L/R are one bus (drums or synths) at the span start; the voice adds
+ *     its samples, never overwrites.  Bus bases are BUF_ALIGN aligned
+ *     scratch, so a span starting on a multiple of 4 frames is 16-byte
+ *     aligned; later spans start anywhere, so kernels use unaligned 4-wide
+ *     loads (v4_load) and finish the n % 4 tail in scalar code.
+ *   - 0 < n <= len - pos: the caller clamps to what the voice has left and
+ *     never calls a silent voice (bit clear in active_voices, or pos >= len).
+ *   - Touches only its own state and its bus; voices on different buses
+ *     share nothing and may render concurrently.
+ *   - Output must not depend on how the span is cut (the C renderer and
+ *     generator.s partition differently and produce the same samples).
+ */
+
+typedef enum {
+    VOICE_BUS_DRUMS = 0,    /* Ld/Rd */
+    VOICE_BUS_SYNTH,        /* Ls/Rs */
+} voice_bus_t;
+
+/* generator_process_stems output a voice adds into; the synth bus is
+   melody + mid + bass */
+typedef enum {
+    VOICE_STEM_DRUMS = 0,
+    VOICE_STEM_MELODY,
+    VOICE_STEM_MID,
+    VOICE_STEM_BASS,
+    VOICE_STEM_COUNT
+} voice_stem_t;
+
+typedef struct {
+    const char *name;
+    const char *stage;          /* profiler stage, "voice.<name>" */
+    uint32_t bit;               /* GEN_VOICE_* */
+    uint8_t bus;                /* voice_bus_t */
+    uint8_t stem;               /* voice_stem_t */
+    uint8_t event;              /* EVT_* this voice answers */
+    uint16_t pos_off, len_off;  /* offsetof(generator_t, <voice>.pos / .len) */
+
+    /* Reset state at generator_init; `seed` and `noise` (NOISE_V1/V2) for
+       the noise voices.  NULL: stays as generator_init's memset left it. */
+    void (*init)(generator_t *g, uint64_t seed, uint32_t noise);
+    /* Start a note for `e`; false leaves the event to the next entry with
+       the same event type (EVT_MID picks its voice by aux) */
+    bool (*trigger)(generator_t *g, const event_t *e);
+    /* See the contract above.  NULL: triggered and swept but not mixed, as
+       generator.s leaves hat and mid_simple out of the mix. */
+    void (*process_block)(generator_t *g, float32_t *L, float32_t *R, uint32_t n);
+    /* The same for GEN_LANES generators in lockstep (generator_process_lanes):
+       lane l renders n[l] samples of g[l]'s voice into L[l]/R[l], n[l] == 0
+       for an idle lane; each lane must match process_block on its own.
+       NULL: the lanes take process_block one by one. */
+    void (*process_lanes)(generator_t *const g[GEN_LANES], float32_t *const L[GEN_LANES],
+                          float32_t *const R[GEN_LANES], const uint32_t n[GEN_LANES]);
+} voice_desc_t;
+
+/* Every voice, in mix order (summation order is part of the output) */
+extern const voice_desc_t voice_registry[];
+extern const uint32_t voice_registry_count;
+
+/* Samples `v` has left to play, 0 when silent */
+static inline uint32_t voice_remaining(const generator_t *g, const voice_desc_t *v)
+{
+    const uint8_t *base = (const uint8_t *)g;
+    uint32_t pos = *(const uint32_t *)(base + v->pos_off);
+    uint32_t len = *(const uint32_t *)(base + v->len_off);
+    return pos < len ? len - pos : 0u;
+}
+
+/* Hand `e` to the first voice that takes it and mark that voice active */
+void voice_registry_trigger(generator_t *g, const event_t *e);
+
+#endif /* VOICE_REGISTRY_H */
@@ -2,6 +2,7 @@
 #define WAV_WRITER_H
 
 #include <stdint.h>
+#include <stdio.h>
 
 /*
  * Write a little-endian 16-bit PCM WAV file.
@@ -17,4 +18,58 @@ void write_wav(const char *path,
                uint16_t num_channels,
                uint32_t sample_rate);
 
+/*
+ * Streaming variant: open writes a header with zero sizes, append writes
+ * interleaved blocks as they are rendered, close patches the RIFF/data
+ * sizes.  Output goes through a WAV_STREAM_BUF_BYTES page-aligned stdio
+ * buffer, so memory use is fixed and independent of the track length.
+ * open/append/close return 0 on success, -1 on I/O error.
+ */
+#define WAV_STREAM_BUF_BYTES (1u << 20)
+
+typedef struct {
+    FILE *f;
+    void *buf;              /* stdio buffer, freed on close */
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint32_t frames;        /* frames appended so far */
+    uint32_t loop_start, loop_end;   /* see wav_stream_set_loop */
+    int has_loop;
+    int in_memory;          /* wav_stream_open_mem: no file, image in mem */
+    int is_null;            /* wav_stream_open_null: nothing stored */
+    int fixed_mem;          /* wav_stream_open_buf: mem is the caller's, never grown */
+    uint8_t *mem;
+    size_t mem_len, mem_cap;
+    /* Observer of every appended block (segment --digest); set after open,
+       a nonzero return fails the append */
+    int (*tap)(void *ctx, const int16_t *samples, uint32_t frames, uint16_t channels);
+    void *tap_ctx;
+} wav_stream_t;
+
+int wav_stream_open(wav_stream_t *w, const char *path, uint16_t num_channels, uint32_t sample_rate);
+/*
+ * Memory variant: the same byte stream is assembled in a heap buffer
+ * (sized for `frames_hint` frames, grown as needed) instead of a file.
+ * After close, w->mem/w->mem_len hold the complete WAV image and the
+ * caller owns w->mem (free it).
+ */
+int wav_stream_open_mem(wav_stream_t *w, uint16_t num_channels, uint32_t sample_rate,
+                        uint32_t frames_hint);
+/* Caller-buffer variant: the image is assembled in buf[0, cap), which
+ * the caller keeps owning (no growth: an append past cap fails).  Size it
+ * with wav_image_bytes; after close w->mem_len is the image's length. */
+int wav_stream_open_buf(wav_stream_t *w, uint16_t num_channels, uint32_t sample_rate,
+                        void *buf, size_t cap);
+/* Bytes of a closed image of `frames` frames, with or without a loop tag */
+size_t wav_image_bytes(uint32_t frames, uint16_t num_channels, int has_loop);
+/* Null variant: nothing is stored, appends only count frames and feed the
+ * tap; close always succeeds.  For a render whose only output is the tap. */
+int wav_stream_open_null(wav_stream_t *w, uint16_t num_channels, uint32_t sample_rate);
+int wav_stream_append(wav_stream_t *w, const int16_t *samples, uint32_t frames);
+int wav_stream_close(wav_stream_t *w);
+/* Record a seamless loop region [start_frame, end_frame) for the stream.
+ * close appends it as a RIFF "smpl" chunk after the data, so players and
+ * the visualiser can loop the exact point instead of guessing. */
+void wav_stream_set_loop(wav_stream_t *w, uint32_t start_frame, uint32_t end_frame);
+
 #endif /* WAV_WRITER_H */ 
\ No newline at end of file
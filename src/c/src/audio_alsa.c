@@ -0,0 +1,197 @@
+/* audio_alsa.c - coreaudio.h playback API on ALSA (libasound)
+ *
+ * Selected with AUDIO_BACKEND=alsa.  A playback thread calls the user
+ * callback one period at a time and writes the interleaved float frames
+ * with snd_pcm_writei, so the period size and count asked for in
+ * audio_config_t are exactly what the hardware buffer holds.  On PipeWire
+ * or PulseAudio hosts the "default" device goes through their ALSA plugin.
+ *
+ * An underrun (-EPIPE) or suspend is recovered with snd_pcm_recover and
+ * counted; the counter is read by audio_get_stats and mirrored into the
+ * "audio.xruns" prof counter.
+ */
+#include "coreaudio.h"
+#include "prof.h"
+#include <alsa/asoundlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    snd_pcm_t*        pcm;
+    pthread_t         thread;
+    bool              started;       /* thread created */
+    bool              running;       /* atomic: cleared by audio_stop or a dead device */
+    float*            buffer;        /* one period, interleaved stereo */
+    audio_callback_t  user_callback;
+    void*             user_data;
+    uint32_t          sample_rate;
+    uint32_t          period_frames;
+    uint32_t          periods;
+    uint64_t          callbacks;     /* relaxed atomics */
+    uint64_t          xruns;
+    uint64_t          block_pts;     /* audio_block_pts of the callback in progress */
+    int               prof_xruns;    /* prof counter id */
+} audio_state_t;
+
+static audio_state_t g_audio_state;
+
+static int alsa_fail(const char* what, int err)
+{
+    fprintf(stderr, "ALSA %s failed: %s\n", what, snd_strerror(err));
+    return 1;
+}
+
+static int alsa_set_hw_params(audio_state_t* state, const audio_config_t* cfg)
+{
+    snd_pcm_hw_params_t* hw;
+    snd_pcm_hw_params_alloca(&hw);
+    int err = snd_pcm_hw_params_any(state->pcm, hw);
+    if(err < 0) return alsa_fail("hw_params_any", err);
+    if((err = snd_pcm_hw_params_set_access(state->pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0)
+        return alsa_fail("set_access", err);
+    if((err = snd_pcm_hw_params_set_format(state->pcm, hw, SND_PCM_FORMAT_FLOAT)) < 0)
+        return alsa_fail("set_format (float32)", err);
+    if((err = snd_pcm_hw_params_set_channels(state->pcm, hw, 2)) < 0)
+        return alsa_fail("set_channels", err);
+
+    unsigned int rate = cfg->sample_rate;
+    if((err = snd_pcm_hw_params_set_rate_near(state->pcm, hw, &rate, NULL)) < 0)
+        return alsa_fail("set_rate", err);
+    snd_pcm_uframes_t period = cfg->period_frames;
+    if((err = snd_pcm_hw_params_set_period_size_near(state->pcm, hw, &period, NULL)) < 0)
+        return alsa_fail("set_period_size", err);
+    unsigned int periods = cfg->periods < 2 ? 2 : cfg->periods > AUDIO_MAX_PERIODS ? AUDIO_MAX_PERIODS : cfg->periods;
+    if((err = snd_pcm_hw_params_set_periods_near(state->pcm, hw, &periods, NULL)) < 0)
+        return alsa_fail("set_periods", err);
+    if((err = snd_pcm_hw_params(state->pcm, hw)) < 0)
+        return alsa_fail("hw_params", err);
+
+    state->sample_rate = rate;
+    state->period_frames = (uint32_t)period;
+    state->periods = periods;
+    return 0;
+}
+
+/* Start only once the whole buffer is queued, wake the writer per period */
+static int alsa_set_sw_params(audio_state_t* state)
+{
+    snd_pcm_sw_params_t* sw;
+    snd_pcm_sw_params_alloca(&sw);
+    int err = snd_pcm_sw_params_current(state->pcm, sw);
+    if(err < 0) return alsa_fail("sw_params_current", err);
+    snd_pcm_uframes_t buffer = (snd_pcm_uframes_t)state->period_frames * state->periods;
+    if((err = snd_pcm_sw_params_set_start_threshold(state->pcm, sw, buffer)) < 0)
+        return alsa_fail("set_start_threshold", err);
+    if((err = snd_pcm_sw_params_set_avail_min(state->pcm, sw, state->period_frames)) < 0)
+        return alsa_fail("set_avail_min", err);
+    if((err = snd_pcm_sw_params(state->pcm, sw)) < 0)
+        return alsa_fail("sw_params", err);
+    return 0;
+}
+
+static void alsa_count_xrun(audio_state_t* state)
+{
+    __atomic_fetch_add(&state->xruns, 1, __ATOMIC_RELAXED);
+    prof_count(state->prof_xruns, 1);
+}
+
+static void* alsa_playback_thread(void* arg)
+{
+    audio_state_t* state = (audio_state_t*)arg;
+
+    /* Best effort: SCHED_FIFO needs rtkit or CAP_SYS_NICE, run normal otherwise */
+    struct sched_param sp = { .sched_priority = sched_get_priority_min(SCHED_FIFO) + 10 };
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+
+    while(__atomic_load_n(&state->running, __ATOMIC_ACQUIRE)) {
+        /* The delay is what is queued ahead of the next frame written: it
+           is heard that long from now (only meaningful while running) */
+        snd_pcm_sframes_t delay;
+        state->block_pts = 0;
+        if(snd_pcm_state(state->pcm) == SND_PCM_STATE_RUNNING && snd_pcm_delay(state->pcm, &delay) == 0 && delay >= 0)
+            state->block_pts = audio_clock_ns() + (uint64_t)delay * 1000000000ull / state->sample_rate;
+        state->user_callback(state->buffer, state->period_frames, state->user_data);
+        __atomic_fetch_add(&state->callbacks, 1, __ATOMIC_RELAXED);
+
+        const float* p = state->buffer;
+        snd_pcm_uframes_t left = state->period_frames;
+        while(left > 0) {
+            snd_pcm_sframes_t n = snd_pcm_writei(state->pcm, p, left);
+            if(n == -EAGAIN) continue;
+            if(n < 0) {
+                if(n == -EPIPE || n == -ESTRPIPE) alsa_count_xrun(state);
+                if(snd_pcm_recover(state->pcm, (int)n, 1) < 0) {
+                    __atomic_store_n(&state->running, false, __ATOMIC_RELEASE);
+                    break;
+                }
+                continue;
+            }
+            p += 2 * (size_t)n;
+            left -= (snd_pcm_uframes_t)n;
+        }
+    }
+    return NULL;
+}
+
+int audio_open(const audio_config_t* cfg, audio_callback_t callback, void* user_data)
+{
+    audio_state_t* state = &g_audio_state;
+    const char* device = cfg->device ? cfg->device : "default";
+    int err = snd_pcm_open(&state->pcm, device, SND_PCM_STREAM_PLAYBACK, 0);
+    if(err < 0) return alsa_fail(device, err);
+
+    if(alsa_set_hw_params(state, cfg) != 0 || alsa_set_sw_params(state) != 0) {
+        snd_pcm_close(state->pcm);
+        return 1;
+    }
+    state->buffer = calloc((size_t)state->period_frames * 2, sizeof(float));
+    if(!state->buffer) {
+        snd_pcm_close(state->pcm);
+        return 1;
+    }
+    state->user_callback = callback;
+    state->user_data = user_data;
+    state->callbacks = state->xruns = 0;
+    state->prof_xruns = prof_counter("audio.xruns");
+    return 0;
+}
+
+void audio_get_stats(audio_stats_t* stats)
+{
+    stats->sample_rate   = g_audio_state.sample_rate;
+    stats->period_frames = g_audio_state.period_frames;
+    stats->periods       = g_audio_state.periods;
+    stats->callbacks     = __atomic_load_n(&g_audio_state.callbacks, __ATOMIC_RELAXED);
+    stats->xruns         = __atomic_load_n(&g_audio_state.xruns, __ATOMIC_RELAXED);
+}
+
+uint64_t audio_block_pts(void)
+{
+    return g_audio_state.block_pts;
+}
+
+void audio_start(void)
+{
+    __atomic_store_n(&g_audio_state.running, true, __ATOMIC_RELEASE);
+    if(pthread_create(&g_audio_state.thread, NULL, alsa_playback_thread, &g_audio_state) != 0) {
+        fprintf(stderr, "ALSA playback thread failed to start\n");
+        g_audio_state.running = false;
+        return;
+    }
+    g_audio_state.started = true;
+}
+
+void audio_stop(void)
+{
+    __atomic_store_n(&g_audio_state.running, false, __ATOMIC_RELEASE);
+    if(g_audio_state.started)
+        pthread_join(g_audio_state.thread, NULL);
+    g_audio_state.started = false;
+    snd_pcm_drop(g_audio_state.pcm);
+    snd_pcm_close(g_audio_state.pcm);
+    free(g_audio_state.buffer);
+    g_audio_state.buffer = NULL;
+}
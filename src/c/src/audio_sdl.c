@@ -0,0 +1,89 @@
+/* audio_sdl.c - coreaudio.h playback API on SDL2 audio
+ *
+ * Same contract as coreaudio.c: the user callback fills interleaved
+ * stereo float frames from SDL's audio thread.  Selected with
+ * AUDIO_BACKEND=sdl (the default off macOS).  SDL sizes its own queue, so
+ * only the period (SDL's "samples") is configurable, and underruns are
+ * not reported.
+ */
+#include "coreaudio.h"
+#include <SDL.h>
+#include <stdio.h>
+
+typedef struct {
+    SDL_AudioDeviceID dev;
+    audio_callback_t  user_callback;
+    void*             user_data;
+    uint32_t          sample_rate;
+    uint32_t          period_frames;
+    uint64_t          callbacks;   /* relaxed atomic */
+    uint64_t          block_pts;   /* audio_block_pts of the callback in progress */
+} audio_state_t;
+
+static audio_state_t g_audio_state;
+
+static void audio_sdl_callback(void *userdata, Uint8 *stream, int len)
+{
+    audio_state_t* state = (audio_state_t*)userdata;
+    uint32_t frames = (uint32_t)len / (2 * sizeof(float));
+    /* SDL says nothing about latency: assume the callback fills the period
+       behind the one the device is playing */
+    state->block_pts = state->sample_rate
+        ? audio_clock_ns() + (uint64_t)state->period_frames * 1000000000ull / state->sample_rate : 0;
+    state->user_callback((float*)stream, frames, state->user_data);
+    __atomic_fetch_add(&state->callbacks, 1, __ATOMIC_RELAXED);
+}
+
+int audio_open(const audio_config_t* cfg, audio_callback_t callback, void* user_data)
+{
+    if(SDL_InitSubSystem(SDL_INIT_AUDIO) != 0){
+        fprintf(stderr, "SDL audio init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+    g_audio_state.user_callback = callback;
+    g_audio_state.user_data = user_data;
+    g_audio_state.callbacks = 0;
+
+    SDL_AudioSpec want, have;
+    SDL_zero(want);
+    want.freq     = (int)cfg->sample_rate;
+    want.format   = AUDIO_F32SYS;
+    want.channels = 2;
+    want.samples  = (Uint16)cfg->period_frames;
+    want.callback = audio_sdl_callback;
+    want.userdata = &g_audio_state;
+    /* The driver may pick another period: the callback takes any size */
+    g_audio_state.dev = SDL_OpenAudioDevice(NULL, 0, &want, &have, SDL_AUDIO_ALLOW_SAMPLES_CHANGE);
+    if(!g_audio_state.dev){
+        fprintf(stderr, "SDL_OpenAudioDevice failed: %s\n", SDL_GetError());
+        return 1;
+    }
+    g_audio_state.sample_rate = (uint32_t)have.freq;
+    g_audio_state.period_frames = have.samples;
+    return 0;
+}
+
+void audio_get_stats(audio_stats_t* stats)
+{
+    stats->sample_rate   = g_audio_state.sample_rate;
+    stats->period_frames = g_audio_state.period_frames;
+    stats->periods       = 0;
+    stats->callbacks     = __atomic_load_n(&g_audio_state.callbacks, __ATOMIC_RELAXED);
+    stats->xruns         = 0;
+}
+
+uint64_t audio_block_pts(void)
+{
+    return g_audio_state.block_pts;
+}
+
+void audio_start(void)
+{
+    SDL_PauseAudioDevice(g_audio_state.dev, 0);
+}
+
+void audio_stop(void)
+{
+    SDL_CloseAudioDevice(g_audio_state.dev);
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
@@ -0,0 +1,506 @@
+/*
+ * bench_audio – throughput of the voices and DSP kernels.
+ *
+ * Times every voice's *_process, delay_process_block, both limiters and the
+ * 4-lane exp/sin kernels at several block sizes and prints samples/sec,
+ * cycles/sample and L1D and dTLB read misses/sample.  Each kernel is listed once per implementation this build
+ * links: the voices and effects resolve to either the C file or the .s file
+ * (see VOICE_ASM in the Makefile), the FM voice also exposes its C kernels
+ * side by side, and the math kernels compare libm, simd4.h, fast_math_neon.h
+ * (NEON-C) and the exp4_ps_asm/sin4_ps_asm routines.  Build the C-only and
+ * asm variants (e.g. make bench_audio VOICE_ASM="KICK_ASM") and diff the
+ * tables to compare a voice across implementations.  generator_process is
+ * timed as a whole too (one seed, all voices, from its own scratch arena),
+ * which is where the generator_t layout shows up in the miss column.  The
+ * PCM16 conversions are listed once per run-time level this CPU runs
+ * (cpu_dispatch.h: scalar, SSE2 and AVX2, or NEON and SVE), so the wide
+ * variants sit next to the NEON / SSE2 numbers in one table.
+ *
+ * Voices are re-armed from a snapshot of their triggered state whenever a
+ * note ends, so every timed sample is an active one.  Cycles come from the
+ * wall time and a core clock estimated with a chain of dependent adds
+ * (one per cycle on every core we render on); --ghz overrides it.  Misses
+ * come from Linux perf events (user space only) and print as "-" where
+ * there are none, e.g. macOS or a VM without a PMU.  State, rings and
+ * blocks come from buf_alloc, cache-line aligned as the renderers' are.
+ *
+ * Usage: bench_audio [--samples N] [--ghz F] [kernel-filter]
+ */
+#include "simd4.h"
+#include "fast_math_neon.h"
+#include "fast_math_asm.h"
+#include "kick.h"
+#include "snare.h"
+#include "hat.h"
+#include "melody.h"
+#include "fm_voice.h"
+#include "fm_presets.h"
+#include "simple_voice.h"
+#include "delay.h"
+#include "limiter.h"
+#include "generator.h"
+#include "pcm16.h"
+#include "cpu_dispatch.h"
+#include "buf_alloc.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define BENCH_SR      44100.0f
+#define BENCH_BUF     8192          /* frames; a multiple of every block size */
+#define BENCH_REPS    3             /* best of */
+#define BENCH_DELAY   22050         /* one beat at 120 BPM */
+#define BENCH_SEED    0xcafebabeull /* generator_process case */
+
+static const uint32_t g_blocks[] = {16, 64, 256, 1024};
+
+#if defined(SIMD4_NEON)
+#define SIMD4_NAME "NEON"
+#elif defined(SIMD4_SSE2)
+#define SIMD4_NAME "SSE2"
+#else
+#define SIMD4_NAME "C"
+#endif
+
+typedef void (*bench_fn)(void *state, float32_t *L, float32_t *R, uint32_t n);
+
+typedef enum {
+    INPUT_SILENCE,      /* voices add into the buffers */
+    INPUT_AUDIO,        /* +-1.5 sine pair for the effects */
+    INPUT_EXP_ARG,      /* [-12, 0] */
+    INPUT_SIN_ARG,      /* [-pi, pi] */
+} bench_input_t;
+
+typedef struct {
+    const char *kernel;
+    const char *impl;
+    bench_fn fn;
+    void *state;
+    size_t size;
+    bench_input_t input;
+    size_t pos_off, len_off;    /* note position/length; len_off 0 = never ends */
+} bench_case_t;
+
+static volatile float32_t g_sink;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Core clock in GHz from a chain of dependent adds */
+static double estimate_ghz(void)
+{
+    const uint64_t iters = 1u << 24;
+    double best = 1e30;
+    for(int r = 0; r < BENCH_REPS; r++){
+        uint64_t x = 0;
+        double t0 = now_sec();
+        for(uint64_t i = 0; i < iters; i++){
+            x += i; __asm__ volatile("" : "+r"(x));
+            x += i; __asm__ volatile("" : "+r"(x));
+            x += i; __asm__ volatile("" : "+r"(x));
+            x += i; __asm__ volatile("" : "+r"(x));
+            x += i; __asm__ volatile("" : "+r"(x));
+            x += i; __asm__ volatile("" : "+r"(x));
+            x += i; __asm__ volatile("" : "+r"(x));
+            x += i; __asm__ volatile("" : "+r"(x));
+        }
+        double dt = now_sec() - t0;
+        g_sink = (float32_t)x;
+        if(dt < best) best = dt;
+    }
+    return (double)iters * 8.0 / best * 1e-9;
+}
+
+/* ---- L1D and dTLB read misses ----------------------------------------- */
+
+typedef enum { MISS_L1D, MISS_DTLB } miss_event_t;
+
+#ifdef __linux__
+static int miss_open(miss_event_t ev)
+{
+    struct perf_event_attr a;
+    memset(&a, 0, sizeof a);
+    a.size = sizeof a;
+    a.type = PERF_TYPE_HW_CACHE;
+    a.config = (ev == MISS_DTLB ? PERF_COUNT_HW_CACHE_DTLB : PERF_COUNT_HW_CACHE_L1D) |
+               (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    a.disabled = 1;
+    a.exclude_kernel = 1;
+    a.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &a, 0, -1, -1, 0);
+}
+
+static void miss_start(int fd)
+{
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+static uint64_t miss_stop(int fd)
+{
+    uint64_t v = 0;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    if(read(fd, &v, sizeof v) != (ssize_t)sizeof v) v = 0;
+    return v;
+}
+#else
+static int miss_open(miss_event_t ev) { (void)ev; return -1; }
+static void miss_start(int fd) { (void)fd; }
+static uint64_t miss_stop(int fd) { (void)fd; return 0; }
+#endif
+
+/* ---- Kernel adapters ---------------------------------------------------- */
+
+#define ADAPTER(name, fn, type) \
+    static void run_##name(void *s, float32_t *L, float32_t *R, uint32_t n) \
+    { fn((type *)s, L, R, n); }
+
+ADAPTER(kick, kick_process, kick_t)
+ADAPTER(snare, snare_process, snare_t)
+ADAPTER(hat, hat_process, hat_t)
+ADAPTER(melody, melody_process, melody_t)
+ADAPTER(simple_voice, simple_voice_process, simple_voice_t)
+ADAPTER(fm_voice, fm_voice_process, fm_voice_t)
+ADAPTER(limiter, limiter_process, limiter_t)
+ADAPTER(limiter_la, limiter_la_process, limiter_la_t)
+#ifndef FM_VOICE_ASM
+ADAPTER(fm_voice_poly, fm_voice_process_poly, fm_voice_t)
+#endif
+ADAPTER(fm_voice_exp, fm_voice_process_exp, fm_voice_t)
+ADAPTER(fm_voice_recur, fm_voice_process_recur, fm_voice_t)
+ADAPTER(generator, generator_process, generator_t)
+
+static void run_delay(void *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    delay_process_block((delay_t *)s, L, R, n, 0.45f);
+}
+
+/* Math kernels read L and write R; n is a multiple of 4 */
+static void run_expf(void *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    (void)s;
+    for(uint32_t i = 0; i < n; i++) R[i] = expf(L[i]);
+}
+
+static void run_sinf(void *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    (void)s;
+    for(uint32_t i = 0; i < n; i++) R[i] = sinf(L[i]);
+}
+
+static void run_v4_exp(void *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    (void)s;
+    for(uint32_t i = 0; i < n; i += 4) v4_store(R + i, v4_exp(v4_load(L + i)));
+}
+
+static void run_v4_sin(void *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    (void)s;
+    for(uint32_t i = 0; i < n; i += 4) v4_store(R + i, v4_sin(v4_load(L + i)));
+}
+
+#ifdef __ARM_NEON
+static void run_exp4_ps(void *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    (void)s;
+    for(uint32_t i = 0; i < n; i += 4) vst1q_f32(R + i, exp4_ps(vld1q_f32(L + i)));
+}
+
+static void run_sin4_ps(void *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    (void)s;
+    for(uint32_t i = 0; i < n; i += 4) vst1q_f32(R + i, sin4_ps(vld1q_f32(L + i)));
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(BENCH_USE_ASM)
+static void run_exp4_ps_asm(void *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    (void)s;
+    for(uint32_t i = 0; i < n; i += 4) vst1q_f32(R + i, exp4_ps_asm(vld1q_f32(L + i)));
+}
+
+static void run_sin4_ps_asm(void *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    (void)s;
+    for(uint32_t i = 0; i < n; i += 4) vst1q_f32(R + i, sin4_ps_asm(vld1q_f32(L + i)));
+}
+#endif
+
+/* PCM16 conversions at one level: out to / back from g_pcm */
+typedef struct {
+    pcm16_interleave_fn to_pcm;
+    pcm16_deinterleave_fn from_pcm;
+} pcm16_case_t;
+
+static int16_t g_pcm[2 * 1024];     /* the largest block */
+
+static void run_pcm16_interleave(void *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    ((pcm16_case_t *)s)->to_pcm(L, R, g_pcm, n);
+}
+
+static void run_pcm16_deinterleave(void *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    ((pcm16_case_t *)s)->from_pcm(g_pcm, L, R, n);
+}
+
+/* ---- Driver ------------------------------------------------------------- */
+
+static void fill_input(bench_input_t input, float32_t *L, float32_t *R)
+{
+    for(uint32_t i = 0; i < BENCH_BUF; i++){
+        float32_t u = (float32_t)i / BENCH_BUF;
+        switch(input){
+            case INPUT_AUDIO:
+                L[i] = 1.5f * sinf(SIMD4_TAU * 220.0f * (float32_t)i / BENCH_SR);
+                R[i] = 1.5f * sinf(SIMD4_TAU * 331.0f * (float32_t)i / BENCH_SR);
+                break;
+            case INPUT_EXP_ARG:
+                L[i] = -12.0f * u; R[i] = 0.0f;
+                break;
+            case INPUT_SIN_ARG:
+                L[i] = (2.0f * u - 1.0f) * SIMD4_PI; R[i] = 0.0f;
+                break;
+            default:
+                L[i] = R[i] = 0.0f;
+                break;
+        }
+    }
+}
+
+static uint32_t field_u32(const void *state, size_t off)
+{
+    uint32_t v;
+    memcpy(&v, (const char *)state + off, sizeof v);
+    return v;
+}
+
+/* Best-of-BENCH_REPS seconds for `samples` frames in blocks of `block`;
+   `misses` gets the L1D and `tlb_misses` the dTLB read misses of that run
+   for the counters that opened (fd >= 0) */
+static double time_case(const bench_case_t *c, void *work, float32_t *L, float32_t *R,
+                        uint32_t block, uint64_t samples, int l1d, uint64_t *misses,
+                        int tlb, uint64_t *tlb_misses)
+{
+    double best = 1e30;
+    for(int r = 0; r < BENCH_REPS; r++){
+        if(c->size) memcpy(work, c->state, c->size);
+        fill_input(c->input, L, R);
+        uint32_t off = 0;
+        if(l1d >= 0) miss_start(l1d);
+        if(tlb >= 0) miss_start(tlb);
+        double t0 = now_sec();
+        for(uint64_t done = 0; done < samples; done += block){
+            if(c->len_off && field_u32(work, c->pos_off) >= field_u32(work, c->len_off))
+                memcpy(work, c->state, c->size);
+            c->fn(work, L + off, R + off, block);
+            off += block;
+            if(off == BENCH_BUF) off = 0;
+        }
+        double dt = now_sec() - t0;
+        uint64_t m = l1d >= 0 ? miss_stop(l1d) : 0;
+        uint64_t t = tlb >= 0 ? miss_stop(tlb) : 0;
+        if(dt < best){
+            best = dt;
+            *misses = m;
+            *tlb_misses = t;
+        }
+        g_sink = L[0] + R[BENCH_BUF - 1];
+    }
+    return best;
+}
+
+#define CASE(k, i, f, st, in) \
+    { k, i, f, &st, sizeof(st), in, 0, 0 }
+#define MATH_CASE(k, i, f, in) \
+    { k, i, f, NULL, 0, in, 0, 0 }
+#define VOICE_CASE(k, i, f, st) \
+    { k, i, f, &st, sizeof(st), INPUT_SILENCE, offsetof(__typeof__(st), pos), offsetof(__typeof__(st), len) }
+#define GEN_CASE(k, i, f, st) \
+    { k, i, f, &st, sizeof(st), INPUT_SILENCE, 0, 0 }
+/* fn NULL (not listed) where the build or CPU lacks the level */
+#define PCM16_CASES(isa) \
+    CASE("pcm16_interleave", cpu_isa_name(isa), pcm[isa].to_pcm ? run_pcm16_interleave : NULL, pcm[isa], INPUT_AUDIO), \
+    CASE("pcm16_deinterleave", cpu_isa_name(isa), pcm[isa].from_pcm ? run_pcm16_deinterleave : NULL, pcm[isa], INPUT_AUDIO)
+
+int main(int argc, char **argv)
+{
+    uint64_t samples = 1u << 20;
+    double ghz = 0.0;
+    const char *filter = NULL;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--samples") == 0 && i + 1 < argc) samples = strtoull(argv[++i], NULL, 0);
+        else if(strcmp(argv[i], "--ghz") == 0 && i + 1 < argc) ghz = strtod(argv[++i], NULL);
+        else if(argv[i][0] != '-') filter = argv[i];
+        else {
+            fprintf(stderr, "usage: %s [--samples N] [--ghz F] [kernel-filter]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Triggered states; the trigger helpers log to stdout, so set them up
+       before the table starts */
+    kick_t kick;    kick_init(&kick, BENCH_SR); kick_trigger(&kick);
+    snare_t snare;  snare_init(&snare, BENCH_SR, 0xcafebabeull); snare_trigger(&snare);
+    hat_t hat;      hat_init(&hat, BENCH_SR, 0xdeadbeefull); hat_trigger(&hat);
+    melody_t mel;   melody_init(&mel, BENCH_SR); melody_trigger(&mel, 440.0f, 0.5f);
+    simple_voice_t sv; simple_voice_init(&sv, BENCH_SR);
+    simple_voice_trigger(&sv, 330.0f, 0.25f, SIMPLE_SINE, 0.2f, 6.0f);
+    fm_voice_t fm;  fm_voice_init(&fm, BENCH_SR);
+    fm_voice_trigger(&fm, 220.0f, 0.5f, FM_PRESET_BELLS.ratio, FM_PRESET_BELLS.index,
+                     FM_PRESET_BELLS.amp, FM_PRESET_BELLS.decay);
+    delay_t delay;
+    float32_t *ring = buf_alloc(0, sizeof(float32_t) * BENCH_DELAY * 2, 0);
+    if(!ring){ fprintf(stderr, "bench_audio: out of memory\n"); return 1; }
+    delay_init(&delay, ring, BENCH_DELAY);
+    limiter_t lim;  limiter_init(&lim, BENCH_SR, 1.0f, 50.0f, -1.0f);
+    limiter_la_t la; limiter_la_init(&la, BENCH_SR, 1.5f, 50.0f, -1.0f);
+    generator_t gen;
+    if(generator_init_max_block(&gen, BENCH_SEED, g_blocks[sizeof g_blocks / sizeof g_blocks[0] - 1]) != 0){
+        fprintf(stderr, "bench_audio: out of memory\n");
+        return 1;
+    }
+    pcm16_case_t pcm[CPU_ISA_COUNT];
+    for(int k = 0; k < CPU_ISA_COUNT; k++)
+        pcm[k] = (pcm16_case_t){ pcm16_interleave_variant((cpu_isa_t)k), pcm16_deinterleave_variant((cpu_isa_t)k) };
+    fflush(stdout);
+
+#ifdef KICK_ASM
+    const char *kick_impl = "asm";
+#else
+    const char *kick_impl = "C";
+#endif
+#ifdef SNARE_ASM
+    const char *snare_impl = "asm";
+#else
+    const char *snare_impl = "C";
+#endif
+#ifdef HAT_ASM
+    const char *hat_impl = "asm";
+#else
+    const char *hat_impl = "C";
+#endif
+#ifdef MELODY_ASM
+    const char *mel_impl = "asm";
+#else
+    const char *mel_impl = "C";
+#endif
+#if defined(FM_VOICE_ASM)
+    const char *fm_impl = "asm";
+#elif defined(FM_ENV_RECURRENCE)
+    const char *fm_impl = "C recur";
+#else
+    const char *fm_impl = "C poly";
+#endif
+#ifdef DELAY_ASM
+    const char *delay_impl = "asm";
+#else
+    const char *delay_impl = "C/" SIMD4_NAME;
+#endif
+#ifdef BENCH_USE_ASM
+    const char *lim_impl = "asm";      /* limiter.s is in every asm build */
+#else
+    const char *lim_impl = "C";
+#endif
+#ifdef GENERATOR_ASM
+    const char *gen_impl = "asm";
+#else
+    const char *gen_impl = "C";
+#endif
+#ifdef __ARM_NEON
+    const char *fm_exp_impl = "NEON-C";
+#else
+    const char *fm_exp_impl = "C";
+#endif
+
+    const bench_case_t cases[] = {
+        VOICE_CASE("kick_process",         kick_impl,  run_kick,  kick),
+        VOICE_CASE("snare_process",        snare_impl, run_snare, snare),
+        VOICE_CASE("hat_process",          hat_impl,   run_hat,   hat),
+        VOICE_CASE("melody_process",       mel_impl,   run_melody, mel),
+        VOICE_CASE("simple_voice_process", "C/" SIMD4_NAME, run_simple_voice, sv),
+        VOICE_CASE("fm_voice_process",     fm_impl,    run_fm_voice, fm),
+#ifndef FM_VOICE_ASM
+        VOICE_CASE("fm_voice_process_poly", "C",       run_fm_voice_poly, fm),
+#endif
+        VOICE_CASE("fm_voice_process_exp", fm_exp_impl, run_fm_voice_exp, fm),
+        VOICE_CASE("fm_voice_process_recur", "C/" SIMD4_NAME, run_fm_voice_recur, fm),
+        CASE("delay_process_block",  delay_impl, run_delay,   delay, INPUT_AUDIO),
+        CASE("limiter_process",      lim_impl,   run_limiter, lim,   INPUT_AUDIO),
+        CASE("limiter_la_process",   "C/" SIMD4_NAME, run_limiter_la, la, INPUT_AUDIO),
+        GEN_CASE("generator_process", gen_impl, run_generator, gen),
+        MATH_CASE("exp", "libm expf",           run_expf,          INPUT_EXP_ARG),
+        MATH_CASE("exp", "v4_exp/" SIMD4_NAME,  run_v4_exp,        INPUT_EXP_ARG),
+#ifdef __ARM_NEON
+        MATH_CASE("exp", "NEON-C exp4_ps",      run_exp4_ps,       INPUT_EXP_ARG),
+#endif
+#if defined(__ARM_NEON) && defined(BENCH_USE_ASM)
+        MATH_CASE("exp", "asm exp4_ps_asm",     run_exp4_ps_asm,   INPUT_EXP_ARG),
+#endif
+        MATH_CASE("sin", "libm sinf",           run_sinf,          INPUT_SIN_ARG),
+        MATH_CASE("sin", "v4_sin/" SIMD4_NAME,  run_v4_sin,        INPUT_SIN_ARG),
+#ifdef __ARM_NEON
+        MATH_CASE("sin", "NEON-C sin4_ps",      run_sin4_ps,       INPUT_SIN_ARG),
+#endif
+#if defined(__ARM_NEON) && defined(BENCH_USE_ASM)
+        MATH_CASE("sin", "asm sin4_ps_asm",     run_sin4_ps_asm,   INPUT_SIN_ARG),
+#endif
+        PCM16_CASES(CPU_ISA_SCALAR),
+        PCM16_CASES(CPU_ISA_SSE2),
+        PCM16_CASES(CPU_ISA_AVX2),
+        PCM16_CASES(CPU_ISA_NEON),
+        PCM16_CASES(CPU_ISA_SVE),
+    };
+
+    size_t work_size = 0;
+    for(size_t i = 0; i < sizeof cases / sizeof cases[0]; i++)
+        if(cases[i].size > work_size) work_size = cases[i].size;
+    /* Case state is copied here before each run; keep generator_t's alignment */
+    void *work = buf_alloc(_Alignof(generator_t), work_size, 0);
+    float32_t *L = buf_alloc(0, sizeof(float32_t) * BENCH_BUF, 0);
+    float32_t *R = buf_alloc(0, sizeof(float32_t) * BENCH_BUF, 0);
+    if(!work || !L || !R){ fprintf(stderr, "bench_audio: out of memory\n"); return 1; }
+
+    if(ghz <= 0.0) ghz = estimate_ghz();
+    int l1d = miss_open(MISS_L1D), tlb = miss_open(MISS_DTLB);
+    printf("bench_audio: %llu samples per case, best of %d, clock %.2f GHz, L1D misses %s, dTLB misses %s\n",
+           (unsigned long long)samples, BENCH_REPS, ghz, l1d >= 0 ? "counted" : "unavailable",
+           tlb >= 0 ? "counted" : "unavailable");
+    printf("%-24s %-18s %6s %12s %10s %12s %12s %12s\n", "kernel", "impl", "block", "Msamples/s", "ns/sample",
+           "cycles/sample", "L1D miss/smp", "dTLB miss/smp");
+    for(size_t i = 0; i < sizeof cases / sizeof cases[0]; i++){
+        const bench_case_t *c = &cases[i];
+        if(!c->fn || (filter && !strstr(c->kernel, filter))) continue;
+        for(size_t b = 0; b < sizeof g_blocks / sizeof g_blocks[0]; b++){
+            uint64_t frames = (samples + g_blocks[b] - 1) / g_blocks[b] * g_blocks[b];
+            uint64_t misses = 0, tlb_misses = 0;
+            double dt = time_case(c, work, L, R, g_blocks[b], frames, l1d, &misses, tlb, &tlb_misses);
+            double ns = dt * 1e9 / (double)frames;
+            char miss[32] = "-", tlb_miss[32] = "-";
+            if(l1d >= 0) snprintf(miss, sizeof miss, "%.4f", (double)misses / (double)frames);
+            if(tlb >= 0) snprintf(tlb_miss, sizeof tlb_miss, "%.4f", (double)tlb_misses / (double)frames);
+            printf("%-24s %-18s %6u %12.2f %10.3f %12.2f %12s %12s\n", c->kernel, c->impl, g_blocks[b],
+                   (double)frames / dt * 1e-6, ns, ns * ghz, miss, tlb_miss);
+        }
+    }
+    if(l1d >= 0) close(l1d);
+    if(tlb >= 0) close(tlb);
+    generator_free(&gen);
+    buf_free(work); buf_free(L); buf_free(R); buf_free(ring);
+    return 0;
+}
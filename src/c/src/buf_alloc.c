@@ -0,0 +1,109 @@
+#include "buf_alloc.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+/* Sits just before the pointer handed out, inside the alignment prefix */
+typedef struct {
+    void *base;         /* what aligned_alloc or mmap returned */
+    size_t map_len;     /* mmap length, 0 for the heap */
+    int huge;           /* buf_alloc_huge */
+} buf_hdr_t;
+
+static buf_hdr_t *hdr_of(const void *p)
+{
+    return (buf_hdr_t *)((uintptr_t)p - sizeof(buf_hdr_t));
+}
+
+#if defined(__linux__)
+/* NDB_HUGEPAGES=0 turns BUF_HUGE off (A/B runs, hosts where THP khugepaged
+   stalls hurt more than the TLB misses) */
+static int huge_enabled(void)
+{
+    static int enabled = -1;
+    if(enabled < 0){
+        const char *e = getenv("NDB_HUGEPAGES");
+        enabled = !(e && e[0] == '0');
+    }
+    return enabled;
+}
+
+/* `len` (a BUF_HUGE_PAGE multiple) of zeroed memory on 2 MB pages if the
+   kernel has any; NULL to fall back to the heap */
+static void *map_huge(size_t len, int *huge)
+{
+#ifdef MAP_HUGETLB
+    void *reserved = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(reserved != MAP_FAILED){
+        *huge = 2;
+        return reserved;
+    }
+#endif
+    /* No reserved pages: over-map by a page, trim to a 2 MB-aligned range
+       and let transparent huge pages back it */
+    uint8_t *raw = mmap(NULL, len + BUF_HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(raw == MAP_FAILED) return NULL;
+    uint8_t *p = (uint8_t *)(((uintptr_t)raw + BUF_HUGE_PAGE - 1) & ~(uintptr_t)(BUF_HUGE_PAGE - 1));
+    if(p > raw) munmap(raw, (size_t)(p - raw));
+    if(raw + BUF_HUGE_PAGE > p) munmap(p + len, (size_t)(raw + BUF_HUGE_PAGE - p));
+    *huge = 0;
+#ifdef MADV_HUGEPAGE
+    if(madvise(p, len, MADV_HUGEPAGE) == 0) *huge = 1;
+#endif
+    return p;
+}
+#endif
+
+void *buf_alloc(size_t align, size_t bytes, unsigned flags)
+{
+    if(align < BUF_ALIGN) align = BUF_ALIGN;
+    if(align & (align - 1)) return NULL;
+    /* One alignment unit in front holds the header */
+    size_t prefix = align;
+    if(bytes > SIZE_MAX - 2 * prefix - BUF_HUGE_PAGE) return NULL;
+    size_t total = (prefix + bytes + align - 1) & ~(align - 1);
+    uint8_t *base = NULL;
+    size_t map_len = 0;
+    int huge = 0;
+
+#if defined(__linux__)
+    if((flags & BUF_HUGE) && bytes >= BUF_HUGE_PAGE && align <= BUF_HUGE_PAGE && huge_enabled()){
+        size_t len = (total + BUF_HUGE_PAGE - 1) & ~(size_t)(BUF_HUGE_PAGE - 1);
+        base = map_huge(len, &huge);
+        if(base) map_len = len;     /* fresh anonymous pages are already zero */
+    }
+#endif
+    if(!base){
+        base = aligned_alloc(align, total);
+        if(!base) return NULL;
+        if(flags & BUF_ZERO) memset(base + prefix, 0, bytes);
+    }
+
+    uint8_t *p = base + prefix;
+    buf_hdr_t *h = hdr_of(p);
+    h->base = base;
+    h->map_len = map_len;
+    h->huge = huge;
+    return p;
+}
+
+void buf_free(void *p)
+{
+    if(!p) return;
+    buf_hdr_t *h = hdr_of(p);
+#if defined(__linux__)
+    if(h->map_len){
+        munmap(h->base, h->map_len);
+        return;
+    }
+#endif
+    free(h->base);
+}
+
+int buf_alloc_huge(const void *p)
+{
+    return p ? hdr_of(p)->huge : 0;
+}
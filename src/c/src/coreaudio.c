@@ -1,16 +1,19 @@
 #include "coreaudio.h"
 #include <AudioToolbox/AudioToolbox.h>
+#include <stdbool.h>
 #include <stdio.h>
 
-#define NUM_BUFFERS 3
-
 typedef struct {
     AudioQueueRef                queue;
-    AudioQueueBufferRef          buffers[NUM_BUFFERS];
+    AudioQueueBufferRef          buffers[AUDIO_MAX_PERIODS];
+    uint32_t                     num_buffers;
     AudioStreamBasicDescription  format;
     audio_callback_t             user_callback;
     void*                        user_data;
     uint32_t                     buffer_size_frames;
+    uint64_t                     callbacks;   /* relaxed atomic */
+    bool                         started;     /* priming is done: buffers play as queued */
+    uint64_t                     block_pts;   /* audio_block_pts of the callback in progress */
 } audio_state_t;
 
 static audio_state_t g_audio_state;
@@ -18,18 +21,30 @@ static audio_state_t g_audio_state;
 static void audio_queue_callback(void *inUserData, AudioQueueRef inAQ, AudioQueueBufferRef inBuffer)
 {
     audio_state_t* state = (audio_state_t*)inUserData;
+    /* The buffer just returned goes behind the other num_buffers - 1 */
+    state->block_pts = 0;
+    if (state->started && state->format.mSampleRate > 0)
+        state->block_pts = audio_clock_ns() + (uint64_t)((state->num_buffers - 1) * state->buffer_size_frames
+                                                         * 1e9 / state->format.mSampleRate);
     if (state->user_callback) {
         state->user_callback((float*)inBuffer->mAudioData, state->buffer_size_frames, state->user_data);
     }
+    __atomic_fetch_add(&state->callbacks, 1, __ATOMIC_RELAXED);
     inBuffer->mAudioDataByteSize = state->buffer_size_frames * state->format.mBytesPerFrame;
     AudioQueueEnqueueBuffer(state->queue, inBuffer, 0, NULL);
 }
 
-int audio_init(uint32_t sr, uint32_t buffer_size, audio_callback_t callback, void* user_data)
+int audio_open(const audio_config_t* cfg, audio_callback_t callback, void* user_data)
 {
+    uint32_t sr = cfg->sample_rate;
+    uint32_t buffer_size = cfg->period_frames;
+    uint32_t periods = cfg->periods < 2 ? 2 : cfg->periods > AUDIO_MAX_PERIODS ? AUDIO_MAX_PERIODS : cfg->periods;
     g_audio_state.user_callback = callback;
     g_audio_state.user_data = user_data;
     g_audio_state.buffer_size_frames = buffer_size;
+    g_audio_state.num_buffers = periods;
+    g_audio_state.callbacks = 0;
+    g_audio_state.started = false;
 
     g_audio_state.format.mSampleRate       = sr;
     g_audio_state.format.mFormatID         = kAudioFormatLinearPCM;
@@ -44,7 +59,7 @@ int audio_init(uint32_t sr, uint32_t buffer_size, audio_callback_t callback, voi
     if(status != noErr) { fprintf(stderr, "AudioQueueNewOutput failed\n"); return 1; }
 
     uint32_t buffer_size_bytes = buffer_size * g_audio_state.format.mBytesPerFrame;
-    for (int i = 0; i < NUM_BUFFERS; ++i) {
+    for (uint32_t i = 0; i < periods; ++i) {
         status = AudioQueueAllocateBuffer(g_audio_state.queue, buffer_size_bytes, &g_audio_state.buffers[i]);
         if(status != noErr) { fprintf(stderr, "AudioQueueAllocateBuffer failed\n"); return 1; }
         // Prime the buffer
@@ -53,8 +68,23 @@ int audio_init(uint32_t sr, uint32_t buffer_size, audio_callback_t callback, voi
     return 0;
 }
 
+void audio_get_stats(audio_stats_t* stats)
+{
+    stats->sample_rate   = (uint32_t)g_audio_state.format.mSampleRate;
+    stats->period_frames = g_audio_state.buffer_size_frames;
+    stats->periods       = g_audio_state.num_buffers;
+    stats->callbacks     = __atomic_load_n(&g_audio_state.callbacks, __ATOMIC_RELAXED);
+    stats->xruns         = 0;   /* AudioQueue renders late buffers without telling us */
+}
+
+uint64_t audio_block_pts(void)
+{
+    return g_audio_state.block_pts;
+}
+
 void audio_start(void)
 {
+    g_audio_state.started = true;
     AudioQueueStart(g_audio_state.queue, NULL);
 }
 
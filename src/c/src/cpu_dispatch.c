@@ -0,0 +1,120 @@
+#include "cpu_dispatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
+static const char *const isa_names[CPU_ISA_COUNT] = {
+    "scalar", "sse2", "sse4.2", "avx2", "avx512", "neon", "sve", "sve2"
+};
+
+static int detected = -1;   /* cpu_detect(), once */
+static int cap = -1;        /* cpu_isa_set / NDB_KERNELS; -1: none */
+
+static cpu_isa_t cpu_detect(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+       __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl"))
+        return CPU_ISA_AVX512;
+    if(__builtin_cpu_supports("avx2")) return CPU_ISA_AVX2;
+    if(__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("sse4.2"))
+        return CPU_ISA_SSE42;
+    if(__builtin_cpu_supports("sse2")) return CPU_ISA_SSE2;
+    return CPU_ISA_SCALAR;
+#elif defined(__aarch64__)
+#if defined(__linux__) && defined(HWCAP2_SVE2)
+    if(getauxval(AT_HWCAP2) & HWCAP2_SVE2) return CPU_ISA_SVE2;
+#endif
+#if defined(__linux__) && defined(HWCAP_SVE)
+    if(getauxval(AT_HWCAP) & HWCAP_SVE) return CPU_ISA_SVE;
+#endif
+    return CPU_ISA_NEON;
+#elif defined(__ARM_NEON)
+    return CPU_ISA_NEON;
+#else
+    return CPU_ISA_SCALAR;
+#endif
+}
+
+/* 0 scalar, 1 x86, 2 ARM */
+static int isa_family(int isa)
+{
+    return isa == CPU_ISA_SCALAR ? 0 : isa <= CPU_ISA_AVX512 ? 1 : 2;
+}
+
+/* A CPU at level `top` runs `isa` */
+static int isa_covers(int top, int isa)
+{
+    return isa == CPU_ISA_SCALAR || (isa_family(isa) == isa_family(top) && isa <= top);
+}
+
+static int isa_lookup(const char *name)
+{
+    for(int k = 0; k < CPU_ISA_COUNT; k++)
+        if(strcmp(name, isa_names[k]) == 0) return k;
+    return -1;
+}
+
+static int cpu_detected(void)
+{
+    int d = __atomic_load_n(&detected, __ATOMIC_RELAXED);
+    if(d >= 0) return d;
+    d = (int)cpu_detect();
+    /* the environment caps like --kernels, unless that came first */
+    const char *env = getenv("NDB_KERNELS");
+    if(env && *env && __atomic_load_n(&cap, __ATOMIC_RELAXED) < 0 && strcmp(env, "auto") != 0){
+        int k = isa_lookup(env);
+        if(k >= 0 && isa_covers(d, k)) __atomic_store_n(&cap, k, __ATOMIC_RELAXED);
+        else fprintf(stderr, "NDB_KERNELS=%s: %s, using %s\n", env,
+                     k < 0 ? "unknown" : "not supported here", isa_names[d]);
+    }
+    __atomic_store_n(&detected, d, __ATOMIC_RELAXED);
+    return d;
+}
+
+cpu_isa_t cpu_isa(void)
+{
+    int d = cpu_detected();
+    int c = __atomic_load_n(&cap, __ATOMIC_RELAXED);
+    return (cpu_isa_t)(c >= 0 ? c : d);
+}
+
+cpu_isa_t cpu_isa_best(uint32_t have)
+{
+    int top = (int)cpu_isa();
+    for(int k = top; k > CPU_ISA_SCALAR; k--)
+        if((have & CPU_ISA_BIT(k)) && isa_covers(top, k)) return (cpu_isa_t)k;
+    return CPU_ISA_SCALAR;
+}
+
+cpu_isa_t cpu_isa_resolve(int *cache, uint32_t have)
+{
+    int k = __atomic_load_n(cache, __ATOMIC_RELAXED);
+    if(k < 0){
+        k = (int)cpu_isa_best(have);
+        __atomic_store_n(cache, k, __ATOMIC_RELAXED);
+    }
+    return (cpu_isa_t)k;
+}
+
+int cpu_isa_set(const char *name)
+{
+    int d = cpu_detected();
+    if(strcmp(name, "auto") == 0){
+        __atomic_store_n(&cap, -1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    int k = isa_lookup(name);
+    if(k < 0 || !isa_covers(d, k)) return -1;
+    __atomic_store_n(&cap, k, __ATOMIC_RELAXED);
+    return 0;
+}
+
+const char *cpu_isa_name(cpu_isa_t isa)
+{
+    return (unsigned)isa < CPU_ISA_COUNT ? isa_names[isa] : "?";
+}
@@ -1,16 +1,28 @@
 #include "crt_fx.h"
+#include "simd4.h"
+#include "buf_alloc.h"
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
+
+/*
+ * All effects work on 8-bit channels in integer arithmetic, one row at a
+ * time: persistence, scanline, chroma shift and bleed run back to back on
+ * a row while it is in L1, so the frame and the persistence buffer are each
+ * read and written once per frame.  The blend and scanline kernels treat
+ * the four bytes of a pixel alike, so they serve RGBA and ARGB; only the
+ * chroma shift and the forced-opaque alpha look at the layout masks.
+ */
 
 void crt_fx_init(crt_fx_t *fx, uint64_t seed, int w, int h)
 {
-    /* allocate persistence buffer */
-    fx->prev_frame = (uint32_t*)calloc(w * h, sizeof(uint32_t));
-    
+    /* allocate persistence buffer and two rows of scratch */
+    fx->prev_frame = buf_alloc(0, (size_t)w * h * sizeof(uint32_t), BUF_ZERO);
+    fx->scratch = buf_alloc(0, (size_t)2 * w * sizeof(uint32_t), BUF_ZERO);
+    crt_fx_set_layout(fx, CRT_FX_RGBA);
+
     /* seed-based randomization of effect levels */
     fx->rng = rng_seed(seed ^ 0xDE5A7ULL);
-    
+
     fx->persistence = 0.3f + rng_next_float(&fx->rng) * 0.6f;
     fx->scanline_alpha = (int)(rng_next_float(&fx->rng) * 200.0f);
     fx->chroma_shift = (int)(rng_next_float(&fx->rng) * 5.0f);
@@ -20,109 +32,206 @@ void crt_fx_init(crt_fx_t *fx, uint64_t seed, int w, int h)
     fx->color_bleed = rng_next_float(&fx->rng) * 0.3f;
 }
 
+void crt_fx_set_layout(crt_fx_t *fx, crt_fx_layout_t layout)
+{
+    if(layout == CRT_FX_ARGB){
+        fx->r_mask = 0x00FF0000; fx->b_mask = 0x000000FF; fx->a_mask = 0xFF000000;
+    } else {
+        fx->r_mask = 0xFF000000; fx->b_mask = 0x0000FF00; fx->a_mask = 0x000000FF;
+    }
+}
+
+void crt_fx_skip(crt_fx_t *fx, int frames)
+{
+    /* crt_fx_apply draws 3 values per noise pixel; SplitMix64 advances
+       its state by a constant per draw */
+    fx->rng.state += 0x9E3779B97F4A7C15ULL * (uint64_t)frames * (uint64_t)(3 * fx->noise_pixels);
+}
+
 void crt_fx_cleanup(crt_fx_t *fx)
 {
-    free(fx->prev_frame);
+    buf_free(fx->prev_frame);
+    buf_free(fx->scratch);
 }
 
-/* blend two pixels with alpha */
-static inline uint32_t blend_alpha(uint32_t dst, uint32_t src, float alpha)
+/* Blend weight of `alpha` in 1/256 steps, kept where both factors fit a byte */
+static inline int blend_weight(float alpha)
 {
-    uint8_t dr = (dst >> 24) & 0xFF;
-    uint8_t dg = (dst >> 16) & 0xFF;
-    uint8_t db = (dst >> 8) & 0xFF;
-    
-    uint8_t sr = (src >> 24) & 0xFF;
-    uint8_t sg = (src >> 16) & 0xFF;
-    uint8_t sb = (src >> 8) & 0xFF;
-    
-    uint8_t r = (uint8_t)(dr * (1.0f - alpha) + sr * alpha);
-    uint8_t g = (uint8_t)(dg * (1.0f - alpha) + sg * alpha);
-    uint8_t b = (uint8_t)(db * (1.0f - alpha) + sb * alpha);
-    
-    return (r << 24) | (g << 16) | (b << 8) | 0xFF;
+    int w = (int)(alpha * 256.0f + 0.5f);
+    return w < 1 ? 1 : w > 255 ? 255 : w;
 }
 
-void crt_fx_apply(crt_fx_t *fx, uint32_t *fb, int w, int h, int frame)
+/* ---- row kernels ------------------------------------------------------ */
+
+/* out = (a * (256 - w) + b * w) >> 8 per channel, then `amask` forced on */
+static void mix_row(uint32_t *out, const uint32_t *a, const uint32_t *b, int n, int w, uint32_t amask)
 {
-    /* 1. Persistence (ghost trails) - blend with previous frame */
-    if(fx->persistence > 0.01f){
-        for(int i = 0; i < w*h; i++){
-            fb[i] = blend_alpha(fx->prev_frame[i], fb[i], 1.0f - fx->persistence);
-        }
+    int i = 0;
+#if SIMD4_NEON
+    const uint8x8_t wa = vdup_n_u8((uint8_t)(256 - w)), wb = vdup_n_u8((uint8_t)w);
+    const uint32x4_t am = vdupq_n_u32(amask);
+    for(; i + 4 <= n; i += 4){
+        uint8x16_t va = vreinterpretq_u8_u32(vld1q_u32(a + i));
+        uint8x16_t vb = vreinterpretq_u8_u32(vld1q_u32(b + i));
+        uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(va), wa), vget_low_u8(vb), wb);
+        uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(va), wa), vget_high_u8(vb), wb);
+        uint8x16_t r = vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+        vst1q_u32(out + i, vorrq_u32(vreinterpretq_u32_u8(r), am));
     }
-    
-    /* Save current frame for next time */
-    memcpy(fx->prev_frame, fb, w * h * sizeof(uint32_t));
-    
-    /* 2. Scanlines - darken every other row */
-    if(fx->scanline_alpha > 0){
-        float alpha = fx->scanline_alpha / 255.0f;
-        for(int y = 0; y < h; y += 2){
-            for(int x = 0; x < w; x++){
-                int idx = y * w + x;
-                uint32_t p = fb[idx];
-                uint8_t r = ((p >> 24) & 0xFF) * (1.0f - alpha);
-                uint8_t g = ((p >> 16) & 0xFF) * (1.0f - alpha);
-                uint8_t b = ((p >> 8) & 0xFF) * (1.0f - alpha);
-                fb[idx] = (r << 24) | (g << 16) | (b << 8) | 0xFF;
-            }
-        }
+#elif SIMD4_SSE2
+    const __m128i wa = _mm_set1_epi16((short)(256 - w)), wb = _mm_set1_epi16((short)w);
+    const __m128i zero = _mm_setzero_si128(), am = _mm_set1_epi32((int)amask);
+    for(; i + 4 <= n; i += 4){
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        /* at most 255 * 256: fits an unsigned 16-bit lane */
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+        __m128i r = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+        _mm_storeu_si128((__m128i *)(out + i), _mm_or_si128(r, am));
+    }
+#endif
+    /* two channels per 16-bit field of a 32-bit word */
+    for(; i < n; i++){
+        uint32_t pa = a[i], pb = b[i];
+        uint32_t even = ((pa & 0x00FF00FF) * (uint32_t)(256 - w) + (pb & 0x00FF00FF) * (uint32_t)w) >> 8;
+        uint32_t odd = ((pa >> 8) & 0x00FF00FF) * (uint32_t)(256 - w) + ((pb >> 8) & 0x00FF00FF) * (uint32_t)w;
+        out[i] = (even & 0x00FF00FF) | (odd & 0xFF00FF00) | amask;
+    }
+}
+
+/* row[i] = floor(c * m / 255) per channel, then `amask` forced on.
+   x / 255 == (x + 1 + (x >> 8)) >> 8 for every x up to 255 * 255. */
+static void scale_row(uint32_t *row, int n, int m, uint32_t amask)
+{
+    int i = 0;
+#if SIMD4_NEON
+    const uint8x8_t vm = vdup_n_u8((uint8_t)m);
+    const uint16x8_t one = vdupq_n_u16(1);
+    const uint32x4_t am = vdupq_n_u32(amask);
+    for(; i + 4 <= n; i += 4){
+        uint8x16_t c = vreinterpretq_u8_u32(vld1q_u32(row + i));
+        uint16x8_t lo = vmull_u8(vget_low_u8(c), vm);
+        uint16x8_t hi = vmull_u8(vget_high_u8(c), vm);
+        lo = vaddq_u16(vsraq_n_u16(lo, lo, 8), one);
+        hi = vaddq_u16(vsraq_n_u16(hi, hi, 8), one);
+        uint8x16_t r = vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+        vst1q_u32(row + i, vorrq_u32(vreinterpretq_u32_u8(r), am));
+    }
+#elif SIMD4_SSE2
+    const __m128i vm = _mm_set1_epi16((short)m), one = _mm_set1_epi16(1);
+    const __m128i zero = _mm_setzero_si128(), am = _mm_set1_epi32((int)amask);
+    for(; i + 4 <= n; i += 4){
+        __m128i c = _mm_loadu_si128((const __m128i *)(row + i));
+        __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(c, zero), vm);
+        __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(c, zero), vm);
+        lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), one), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), one), 8);
+        _mm_storeu_si128((__m128i *)(row + i), _mm_or_si128(_mm_packus_epi16(lo, hi), am));
     }
-    
-    /* 3. Chromatic aberration - shift red/blue channels */
-    if(fx->chroma_shift > 0){
-        /* temporary buffer for shifted channels */
-        uint32_t *temp = (uint32_t*)malloc(w * h * sizeof(uint32_t));
-        memcpy(temp, fb, w * h * sizeof(uint32_t));
-        
-        int shift = (frame % 30 < 15) ? fx->chroma_shift : -fx->chroma_shift;
-        
-        /* shift red channel right */
-        for(int y = 0; y < h; y++){
-            for(int x = 0; x < w; x++){
-                int src_x = x - shift;
-                if(src_x >= 0 && src_x < w){
-                    uint8_t r = (temp[y * w + src_x] >> 24) & 0xFF;
-                    fb[y * w + x] = (fb[y * w + x] & 0x00FFFFFF) | (r << 24);
-                }
-            }
+#endif
+    for(; i < n; i++){
+        uint32_t p = row[i];
+        uint32_t even = (p & 0x00FF00FF) * (uint32_t)m;
+        uint32_t odd = ((p >> 8) & 0x00FF00FF) * (uint32_t)m;
+        even = ((even + 0x00010001 + ((even >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+        odd = ((odd + 0x00010001 + ((odd >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+        row[i] = even | (odd << 8) | amask;
+    }
+}
+
+/* One pixel of chroma_row with the source columns bounds-checked */
+static inline uint32_t chroma_px(const uint32_t *src, int w, int x, int shift, uint32_t rm, uint32_t bm)
+{
+    int xr = x - shift, xb = x + shift;
+    uint32_t r = (xr >= 0 && xr < w ? src[xr] : src[x]) & rm;
+    uint32_t b = (xb >= 0 && xb < w ? src[xb] : src[x]) & bm;
+    return (src[x] & ~(rm | bm)) | r | b;
+}
+
+/* Red from src[x - shift], blue from src[x + shift], the rest from src[x];
+   a channel whose source column is off the row stays put */
+static void chroma_row(uint32_t *out, const uint32_t *src, int w, int shift, uint32_t rm, uint32_t bm)
+{
+    uint32_t keep = ~(rm | bm);
+    int s = shift < 0 ? -shift : shift;
+    int lo = s < w ? s : w;
+    int hi = w - s > lo ? w - s : lo;
+    int x = 0;
+    for(; x < lo; x++) out[x] = chroma_px(src, w, x, shift, rm, bm);
+    for(; x < hi; x++){
+        out[x] = (src[x] & keep) | (src[x - shift] & rm) | (src[x + shift] & bm);
+    }
+    for(; x < w; x++) out[x] = chroma_px(src, w, x, shift, rm, bm);
+}
+
+/* Mean of the left and right neighbours per channel, rounded down */
+static void neighbour_mean_row(uint32_t *out, const uint32_t *src, int w)
+{
+    for(int x = 1; x < w - 1; x++){
+        uint32_t l = src[x - 1], r = src[x + 1];
+        out[x] = (l & r) + (((l ^ r) & 0xFEFEFEFE) >> 1);
+    }
+}
+
+void crt_fx_apply_rows(const crt_fx_t *fx, uint32_t *fb, int w, int y0, int y1, int frame, uint32_t *scratch)
+{
+    uint32_t *copy = scratch, *mean = scratch + w;
+    int persist_w = blend_weight(1.0f - fx->persistence);
+    int bleed_w = blend_weight(fx->color_bleed);
+    int shift = (frame % 30 < 15) ? fx->chroma_shift : -fx->chroma_shift;
+
+    for(int y = y0; y < y1; y++){
+        uint32_t *row = fb + y * w;
+        uint32_t *prev = fx->prev_frame + y * w;
+
+        /* 1. Persistence (ghost trails) - blend with previous frame; the
+           result is next frame's previous frame */
+        if(fx->persistence > 0.01f){
+            mix_row(row, prev, row, w, persist_w, fx->a_mask);
         }
-        
-        /* shift blue channel left */
-        for(int y = 0; y < h; y++){
-            for(int x = 0; x < w; x++){
-                int src_x = x + shift;
-                if(src_x >= 0 && src_x < w){
-                    uint8_t b = (temp[y * w + src_x] >> 8) & 0xFF;
-                    fb[y * w + x] = (fb[y * w + x] & 0xFFFF00FF) | (b << 8);
-                }
-            }
+        memcpy(prev, row, w * sizeof(uint32_t));
+
+        /* 2. Scanlines - darken every other row */
+        if(fx->scanline_alpha > 0 && (y & 1) == 0){
+            scale_row(row, w, 255 - fx->scanline_alpha, fx->a_mask);
         }
-        
-        free(temp);
-    }
-    
-    /* 4. Color bleed (horizontal blur) */
-    if(fx->color_bleed > 0.01f){
-        for(int y = 0; y < h; y++){
-            for(int x = 1; x < w-1; x++){
-                int idx = y * w + x;
-                uint32_t left = fb[idx - 1];
-                uint32_t right = fb[idx + 1];
-                fb[idx] = blend_alpha(fb[idx], blend_alpha(left, right, 0.5f), fx->color_bleed);
-            }
+
+        /* 3. Chromatic aberration - red shifted right, blue left */
+        if(fx->chroma_shift > 0){
+            memcpy(copy, row, w * sizeof(uint32_t));
+            chroma_row(row, copy, w, shift, fx->r_mask, fx->b_mask);
+        }
+
+        /* 4. Color bleed (horizontal blur) towards the neighbours' mean */
+        if(fx->color_bleed > 0.01f && w > 2){
+            memcpy(copy, row, w * sizeof(uint32_t));
+            neighbour_mean_row(mean, copy, w);
+            mix_row(row + 1, copy + 1, mean + 1, w - 2, bleed_w, fx->a_mask);
         }
     }
-    
+}
+
+void crt_fx_noise(crt_fx_t *fx, uint32_t *fb, int w, int h)
+{
     /* 5. Random pixel noise */
     for(int i = 0; i < fx->noise_pixels; i++){
         int x = rng_next_u32(&fx->rng) % w;
         int y = rng_next_u32(&fx->rng) % h;
         uint8_t val = rng_next_u32(&fx->rng) & 0xFF;
-        fb[y * w + x] = (val << 24) | (val << 16) | (val << 8) | 0xFF;
+        uint32_t grey = val * 0x01010101u;
+        fb[y * w + x] = (grey & ~fx->a_mask) | fx->a_mask;
     }
-    
+}
+
+void crt_fx_apply(crt_fx_t *fx, uint32_t *fb, int w, int h, int frame)
+{
+    if(!fx->prev_frame || !fx->scratch) return;
+    crt_fx_apply_rows(fx, fb, w, 0, h, frame, fx->scratch);
+    crt_fx_noise(fx, fb, w, h);
+
     /* 6. Jitter (whole screen offset) - handled in main loop */
     /* 7. Frame drops - handled in main loop */
-} 
\ No newline at end of file
+}
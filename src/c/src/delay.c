@@ -1,33 +1,63 @@
 #include "delay.h"
+#include "simd4.h"
+
+#ifdef __clang__
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+#endif
 
 #ifndef DELAY_ASM
-void delay_process_block(delay_t *d, float32_t *L, float32_t *R, uint32_t n, float32_t feedback)
+/* Planar ring: L taps in buf[0..size), R taps in buf[size..2*size).
+ * The block is walked in contiguous runs up to the wrap point, so the inner
+ * loop has no per-sample branch and each run is processed four samples at a
+ * time.  Every ring slot in a run is read before it is written and visited
+ * once, so the vector loop sees exactly the values the scalar loop did.
+ * The cross-feed stays mul+add (no FMA) to keep NEON, SSE2 and scalar
+ * builds bit-identical. */
+static inline void delay_run(float32_t *rl, float32_t *rr, float32_t *L, float32_t *R,
+                             uint32_t n, float32_t feedback)
 {
-    float32_t *buf = d->buf;
-    uint32_t idx = d->idx;
-    const uint32_t size = d->size;
-
-    for(uint32_t i=0;i<n;++i){
-        // Fetch delayed samples
-        float32_t yl = buf[idx*2];
-        float32_t yr = buf[idx*2+1];
-
-        // Cache dry samples before we modify the output buffers
-        float32_t dryL = L[i];
-        float32_t dryR = R[i];
-
+    const v4f fb = v4_set1(feedback);
+    uint32_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        v4f yl = v4_load(rl + i), yr = v4_load(rr + i);
+        v4f dryL = v4_load(L + i), dryR = v4_load(R + i);
         // Write new values into the delay line (cross-feed with feedback)
-        buf[idx*2]   = dryL + yr * feedback;
-        buf[idx*2+1] = dryR + yl * feedback;
-
+        v4_store(rl + i, v4_add(dryL, v4_mul(yr, fb)));
+        v4_store(rr + i, v4_add(dryR, v4_mul(yl, fb)));
         // Add delayed signal to the dry signal instead of overwriting it
+        v4_store(L + i, v4_add(dryL, yl));
+        v4_store(R + i, v4_add(dryR, yr));
+    }
+    for(; i < n; ++i){
+        float32_t yl = rl[i], yr = rr[i];
+        float32_t dryL = L[i], dryR = R[i];
+        rl[i] = dryL + yr * feedback;
+        rr[i] = dryR + yl * feedback;
         L[i] = dryL + yl;
         R[i] = dryR + yr;
+    }
+}
+
+void delay_process_block(delay_t *d, float32_t *L, float32_t *R, uint32_t n, float32_t feedback)
+{
+    float32_t *buf = d->buf;
+    uint32_t idx = d->idx;
+    const uint32_t size = d->size;
+    if(!buf || size == 0) return;   /* generator built without delay storage */
 
-        // Advance circular buffer index
-        idx++;
-        if(idx>=size) idx=0;
+    float32_t *ring_l = buf;
+    float32_t *ring_r = buf + size;
+    uint32_t done = 0;
+    while(done < n){
+        uint32_t run = size - idx;
+        if(run > n - done) run = n - done;
+        delay_run(ring_l + idx, ring_r + idx, L + done, R + done, run, feedback);
+        done += run;
+        idx += run;
+        if(idx >= size) idx = 0;
     }
     d->idx = idx;
 }
-#endif // DELAY_ASM 
\ No newline at end of file
+#endif // DELAY_ASM
@@ -0,0 +1,205 @@
+#include "digest.h"
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+
+/* XXH64 (xxHash, Yann Collet): four 64-bit lanes over 32-byte stripes */
+#define XXH_P1 0x9E3779B185EBCA87ULL
+#define XXH_P2 0xC2B2AE3D27D4EB4FULL
+#define XXH_P3 0x165667B19E3779F9ULL
+#define XXH_P4 0x85EBCA77C2B2AE63ULL
+#define XXH_P5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t xxh_rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+/* Little-endian loads; memcpy compiles to one unaligned load */
+static inline uint64_t xxh_read64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static inline uint32_t xxh_read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_P2;
+    return xxh_rotl(acc, 31) * XXH_P1;
+}
+
+static inline uint64_t xxh_merge(uint64_t acc, uint64_t v)
+{
+    acc ^= xxh_round(0, v);
+    return acc * XXH_P1 + XXH_P4;
+}
+
+static void xxh_stripes(uint64_t v[4], const uint8_t *p, size_t stripes)
+{
+    uint64_t v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3];
+    for(size_t i = 0; i < stripes; i++, p += 32){
+        v0 = xxh_round(v0, xxh_read64(p));
+        v1 = xxh_round(v1, xxh_read64(p + 8));
+        v2 = xxh_round(v2, xxh_read64(p + 16));
+        v3 = xxh_round(v3, xxh_read64(p + 24));
+    }
+    v[0] = v0; v[1] = v1; v[2] = v2; v[3] = v3;
+}
+
+void xxh64_reset(xxh64_state_t *s, uint64_t seed)
+{
+    memset(s, 0, sizeof *s);
+    s->seed = seed;
+    s->v[0] = seed + XXH_P1 + XXH_P2;
+    s->v[1] = seed + XXH_P2;
+    s->v[2] = seed;
+    s->v[3] = seed - XXH_P1;
+}
+
+void xxh64_update(xxh64_state_t *s, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    s->len += len;
+    if(s->mem_len + len < 32){
+        memcpy(s->mem + s->mem_len, p, len);
+        s->mem_len += (uint32_t)len;
+        return;
+    }
+    if(s->mem_len){
+        size_t fill = 32 - s->mem_len;
+        memcpy(s->mem + s->mem_len, p, fill);
+        xxh_stripes(s->v, s->mem, 1);
+        p += fill;
+        len -= fill;
+        s->mem_len = 0;
+    }
+    xxh_stripes(s->v, p, len / 32);
+    p += len & ~(size_t)31;
+    len &= 31;
+    memcpy(s->mem, p, len);
+    s->mem_len = (uint32_t)len;
+}
+
+uint64_t xxh64_digest(const xxh64_state_t *s)
+{
+    uint64_t h;
+    if(s->len >= 32){
+        h = xxh_rotl(s->v[0], 1) + xxh_rotl(s->v[1], 7) + xxh_rotl(s->v[2], 12) + xxh_rotl(s->v[3], 18);
+        for(int i = 0; i < 4; i++)
+            h = xxh_merge(h, s->v[i]);
+    } else {
+        h = s->seed + XXH_P5;
+    }
+    h += s->len;
+
+    const uint8_t *p = s->mem;
+    uint32_t n = s->mem_len;
+    for(; n >= 8; n -= 8, p += 8)
+        h = xxh_rotl(h ^ xxh_round(0, xxh_read64(p)), 27) * XXH_P1 + XXH_P4;
+    if(n >= 4){
+        h = xxh_rotl(h ^ (uint64_t)xxh_read32(p) * XXH_P1, 23) * XXH_P2 + XXH_P3;
+        n -= 4;
+        p += 4;
+    }
+    for(; n; n--, p++)
+        h = xxh_rotl(h ^ *p * XXH_P5, 11) * XXH_P1;
+
+    h ^= h >> 33;
+    h *= XXH_P2;
+    h ^= h >> 29;
+    h *= XXH_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t xxh64(const void *data, size_t len, uint64_t seed)
+{
+    xxh64_state_t s;
+    xxh64_reset(&s, seed);
+    xxh64_update(&s, data, len);
+    return xxh64_digest(&s);
+}
+
+int digest_open(digest_t *d, const char *path, const char *header, char tag,
+                uint32_t first_index, uint64_t part_bytes)
+{
+    memset(d, 0, sizeof *d);
+    d->out = fopen(path, "w");
+    if(!d->out){
+        perror(path);
+        return -1;
+    }
+    d->tag = tag;
+    d->index = first_index;
+    d->part_bytes = part_bytes;
+    xxh64_reset(&d->part, 0);
+    xxh64_reset(&d->total, 0);
+    fprintf(d->out, "ndb-digest 1 xxh64 %s\n", header);
+    return 0;
+}
+
+int digest_resume(digest_t *d, const char *path, long offset)
+{
+    d->out = fopen(path, "r+");
+    if(!d->out){
+        perror(path);
+        return -1;
+    }
+    if(ftruncate(fileno(d->out), offset) != 0 || fseek(d->out, offset, SEEK_SET) != 0){
+        perror(path);
+        fclose(d->out);
+        d->out = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void digest_part_end(digest_t *d)
+{
+    if(!d->in_part) return;
+    uint64_t h = xxh64_digest(&d->part);
+    fprintf(d->out, "%c %u %016" PRIx64 "\n", d->tag, d->index, h);
+    xxh64_update(&d->total, &h, sizeof h);
+    xxh64_reset(&d->part, 0);
+    d->in_part = 0;
+    d->index++;
+    d->parts++;
+}
+
+void digest_update(digest_t *d, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    d->bytes += len;
+    while(len){
+        size_t n = len;
+        if(d->part_bytes && n > d->part_bytes - d->in_part)
+            n = (size_t)(d->part_bytes - d->in_part);
+        xxh64_update(&d->part, p, n);
+        d->in_part += n;
+        p += n;
+        len -= n;
+        if(d->part_bytes && d->in_part == d->part_bytes)
+            digest_part_end(d);
+    }
+}
+
+int digest_close(digest_t *d, uint64_t *total)
+{
+    if(!d->out) return -1;
+    digest_part_end(d);
+    uint64_t h = xxh64_digest(&d->total);
+    fprintf(d->out, "total %u %" PRIu64 " %016" PRIx64 "\n", d->parts, d->bytes, h);
+    int rc = ferror(d->out) ? -1 : 0;
+    if(fclose(d->out) != 0) rc = -1;
+    d->out = NULL;
+    if(total) *total = h;
+    return rc;
+}
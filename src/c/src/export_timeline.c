@@ -2,90 +2,55 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
-#include <inttypes.h>
 
-#include "generator.h"
+#include "generator_plan.h"
 #include "music_time.h"
-#include "event_queue.h"
-
-static const char *event_type_to_string(uint8_t t) {
-    switch ((event_type_t)t) {
-        case EVT_KICK:    return "kick";
-        case EVT_SNARE:   return "snare";
-        case EVT_HAT:     return "hat";
-        case EVT_MELODY:  return "melody";
-        case EVT_MID:     return "mid";
-        case EVT_FM_BASS: return "fm_bass";
-        default:          return "unknown";
-    }
-}
+#include "timeline_export.h"
+#include "seed.h"
 
+/* Usage: export_timeline [--json] [seed] [out]
+   Writes the binary sidecar unless --json is given or `out` ends in .json
+   (the JSON form is a human-readable debug export of the same data). */
 int main(int argc, char **argv) {
     uint64_t seed = 0xCAFEBABEULL;
-    const char *out_path = "timeline.json";
-
-    if (argc >= 2) {
-        // Accept hex like 0xDEADBEEF or decimal
-        seed = strtoull(argv[1], NULL, 0);
+    const char *out_path = NULL;
+    int json = 0;
+
+    int npos = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if (npos == 0) {
+            // Hex like 0xDEADBEEF (up to a 64-digit tx hash) or decimal
+            ndb_seed_t s;
+            if (ndb_seed_parse(argv[i], &s) != 0) {
+                fprintf(stderr, "export_timeline: bad seed '%s'\n", argv[i]);
+                return 1;
+            }
+            seed = s.audio;
+            npos++;
+        } else if (npos == 1) {
+            out_path = argv[i];
+            npos++;
+        }
     }
-    if (argc >= 3) {
-        out_path = argv[2];
+    if (out_path) {
+        size_t n = strlen(out_path);
+        if (n >= 5 && strcmp(out_path + n - 5, ".json") == 0) json = 1;
+    } else {
+        out_path = json ? "timeline.json" : "timeline.tl";
     }
 
-    generator_t g;
-    generator_init(&g, seed);
-
-    FILE *f = fopen(out_path, "wb");
-    if (!f) {
-        fprintf(stderr, "Failed to open %s for writing\n", out_path);
+    /* Only timing + events are needed: no voices or delay line */
+    generator_plan_t plan;
+    if (generator_plan(seed, &plan) != 0 ||
+        (json ? timeline_export_json(&plan, out_path) : timeline_export_bin(&plan, out_path)) != 0) {
+        generator_plan_free(&plan);
         return 1;
     }
 
-    // Header
-    fprintf(f, "{\n");
-    fprintf(f, "  \"seed\": \"0x%016" PRIx64 "\",\n", seed);
-    fprintf(f, "  \"sample_rate\": %u,\n", SR);
-    fprintf(f, "  \"bpm\": %.6f,\n", g.mt.bpm);
-    fprintf(f, "  \"step_samples\": %u,\n", g.mt.step_samples);
-    fprintf(f, "  \"total_samples\": %u,\n", g.mt.seg_frames);
-
-    // Steps array (every 16th note)
-    fprintf(f, "  \"steps\": [");
-    for (uint32_t s = 0; s < TOTAL_STEPS; ++s) {
-        uint32_t t = s * g.mt.step_samples;
-        fprintf(f, "%s%u", (s == 0 ? "" : ","), t);
-    }
-    fprintf(f, "],\n");
-
-    // Beats array (every 4 steps)
-    uint32_t total_beats = TOTAL_STEPS / STEPS_PER_BEAT;
-    fprintf(f, "  \"beats\": [");
-    for (uint32_t b = 0; b < total_beats; ++b) {
-        uint32_t t = (b * STEPS_PER_BEAT) * g.mt.step_samples;
-        fprintf(f, "%s%u", (b == 0 ? "" : ","), t);
-    }
-    fprintf(f, "],\n");
-
-    // Events
-    fprintf(f, "  \"events\": [\n");
-    for (uint32_t i = 0; i < g.q.count; ++i) {
-        const event_t *ev = &g.q.events[i];
-        fprintf(f,
-                "    {\"time\": %u, \"type\": \"%s\", \"aux\": %u}%s\n",
-                ev->time,
-                event_type_to_string(ev->type),
-                (unsigned)ev->aux,
-                (i + 1 < g.q.count ? "," : ""));
-    }
-    fprintf(f, "  ]\n");
-
-    fprintf(f, "}\n");
-    fclose(f);
-
     printf("Exported timeline to %s (bpm=%.3f, steps=%u, events=%u)\n",
-           out_path, g.mt.bpm, TOTAL_STEPS, g.q.count);
+           out_path, plan.mt.bpm, TOTAL_STEPS, plan.q.count);
+    generator_plan_free(&plan);
     return 0;
 }
-
-
-
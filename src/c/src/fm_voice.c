@@ -1,5 +1,13 @@
 #include "fm_voice.h"
-#include <stdio.h>
+#include "trace.h"
+#include "simd4.h"
+#include <math.h>
+
+#ifdef __clang__
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+#endif
 
 void fm_voice_init(fm_voice_t *v, float32_t sr)
 {
@@ -19,10 +27,238 @@ void fm_voice_trigger(fm_voice_t *v, float32_t carrier_freq, float32_t duration_
     v->decay = decay;
     v->len = (uint32_t)(duration_sec * v->sr);
     v->pos = 0;
-#ifndef REALTIME_MODE
-    printf("FM_TRIGGER cf=%.2f dur=%.2f ratio=%.2f idx=%.2f amp=%.2f len=%u\n", carrier_freq, duration_sec, ratio, index, amp, v->len);
+    TRACE(1, TRACE_FM, trace_f32(carrier_freq), trace_f32(duration_sec), trace_f32(ratio),
+          trace_f32(index), trace_f32(amp), v->len);
+}
+
+#ifndef FM_VOICE_ASM
+/* Portable port of fm_voice.s (the shipping voice): 1/(1+decay*t)
+ * envelope, 5th-order sine polynomial on [-pi, pi] with the same one-shot
+ * wraps and clamps, and round-to-nearest phase folding after every sample.
+ * Operation order follows the asm so both builds agree bit for bit. */
+#define FM_ASM_TAU 6.283185307f
+#define FM_ASM_PI  3.14159265f
+
+static inline float32_t fm_poly_wrap(float32_t x)
+{
+    if(x > FM_ASM_PI) x = (x - FM_ASM_PI) - FM_ASM_PI;
+    if(x < -FM_ASM_PI) x = (x + FM_ASM_PI) + FM_ASM_PI;
+    return x;
+}
+
+static inline float32_t fm_poly_sin(float32_t x)
+{
+    float32_t x2 = x * x;
+    float32_t x3 = x2 * x;
+    float32_t x5 = (x2 * x2) * x;
+    return (x - x3 / 6.0f) + x5 / 120.0f;
+}
+
+static inline float32_t fm_clamp(float32_t x, float32_t lim)
+{
+    if(x > lim) x = lim;
+    if(x < -lim) x = -lim;
+    return x;
+}
+
+void fm_voice_process_poly(fm_voice_t *v, float32_t *L, float32_t *R, uint32_t n)
+{
+    if(v->pos >= v->len) return;
+
+    const float32_t sr = v->sr;
+    const float32_t c_inc = (FM_ASM_TAU * v->carrier_freq) / sr;
+    const float32_t m_inc = c_inc * v->ratio;
+    float32_t cp = v->carrier_phase;
+    float32_t mp = v->mod_phase;
+
+    for(uint32_t i = 0; i < n && v->pos < v->len; ++i){
+        float32_t t = (float32_t)v->pos / sr;
+        float32_t env = 1.0f / (1.0f + v->decay * t);
+        float32_t idx = v->index0 * env;
+
+        float32_t mod = fm_clamp(idx * fm_poly_sin(fm_poly_wrap(mp)), 3.0f);
+        float32_t s = fm_poly_sin(fm_poly_wrap(cp + mod));
+        s = fm_clamp(((s * env) * v->amp) * 0.25f, 1.0f);
+        L[i] += s;
+        R[i] += s;
+
+        cp += c_inc;
+        mp += m_inc;
+        cp -= roundf(cp / FM_ASM_TAU) * FM_ASM_TAU;
+        mp -= roundf(mp / FM_ASM_TAU) * FM_ASM_TAU;
+        v->pos++;
+    }
+    v->carrier_phase = cp;
+    v->mod_phase = mp;
+}
+
+/* ---- four voices in lockstep (lane = voice) ----
+ * The poly kernel's per-sample chain (phase, wrap, clamp, fold) resists
+ * vectorising over time but is identical across voices, so four voices of
+ * different seeds run one per lane.  The same IEEE operations in the same
+ * order as fm_voice_process_poly, with the branches as selects, so each lane
+ * is bit-identical to rendering its voice alone. */
+static inline v4f fm_poly_wrap4(v4f x)
+{
+    const v4f pi = v4_set1(FM_ASM_PI), npi = v4_set1(-FM_ASM_PI);
+    x = v4_select(v4_gt(x, pi), v4_sub(v4_sub(x, pi), pi), x);
+    x = v4_select(v4_lt(x, npi), v4_add(v4_add(x, pi), pi), x);
+    return x;
+}
+
+static inline v4f fm_poly_sin4(v4f x)
+{
+    v4f x2 = v4_mul(x, x);
+    v4f x3 = v4_mul(x2, x);
+    v4f x5 = v4_mul(v4_mul(x2, x2), x);
+    return v4_add(v4_sub(x, v4_div(x3, v4_set1(6.0f))), v4_div(x5, v4_set1(120.0f)));
+}
+
+static inline v4f fm_clamp4(v4f x, float32_t lim)
+{
+    x = v4_select(v4_gt(x, v4_set1(lim)), v4_set1(lim), x);
+    x = v4_select(v4_lt(x, v4_set1(-lim)), v4_set1(-lim), x);
+    return x;
+}
+
+/* roundf (ties away from zero) of a small q: floor(|q|), bumped on a
+   fraction >= 0.5, sign restored by a multiply so -0.0 survives */
+static inline v4f fm_roundf4(v4f q)
+{
+    v4f a = v4_abs(q);
+    v4f t = v4_floor(a);
+    t = v4_select(v4_lt(v4_sub(a, t), v4_set1(0.5f)), t, v4_add(t, v4_set1(1.0f)));
+    return v4_select(v4_lt(q, v4_set1(0.0f)), v4_mul(t, v4_set1(-1.0f)), t);
+}
+
+void fm_voice_process_poly_x4(fm_voice_t *const v[4], float32_t *const L[4], float32_t *const R[4], const uint32_t n[4])
+{
+    float32_t sr[4], c_inc[4], m_inc[4], idx0[4], amp[4], decay[4], cp0[4], mp0[4], pos0[4], nf[4];
+    uint32_t max_n = 0;
+    for(int l = 0; l < 4; l++){
+        if(!n[l]){
+            /* idle lane: harmless numbers, never written back */
+            sr[l] = 1.0f; c_inc[l] = m_inc[l] = idx0[l] = amp[l] = decay[l] = 0.0f;
+            cp0[l] = mp0[l] = pos0[l] = nf[l] = 0.0f;
+            continue;
+        }
+        const fm_voice_t *w = v[l];
+        sr[l] = w->sr;
+        c_inc[l] = (FM_ASM_TAU * w->carrier_freq) / w->sr;
+        m_inc[l] = c_inc[l] * w->ratio;
+        idx0[l] = w->index0;
+        amp[l] = w->amp;
+        decay[l] = w->decay;
+        cp0[l] = w->carrier_phase;
+        mp0[l] = w->mod_phase;
+        pos0[l] = (float32_t)w->pos;    /* exact: voices are far shorter than 2^24 */
+        nf[l] = (float32_t)n[l];
+        if(n[l] > max_n) max_n = n[l];
+    }
+    const v4f vsr = v4_load(sr), vc_inc = v4_load(c_inc), vm_inc = v4_load(m_inc);
+    const v4f vidx0 = v4_load(idx0), vamp = v4_load(amp), vdecay = v4_load(decay);
+    const v4f vn = v4_load(nf), one = v4_set1(1.0f), tau = v4_set1(FM_ASM_TAU), quarter = v4_set1(0.25f);
+    v4f cp = v4_load(cp0), mp = v4_load(mp0), pos = v4_load(pos0), k = v4_set1(0.0f);
+
+    for(uint32_t i = 0; i < max_n; ++i){
+        v4f t = v4_div(pos, vsr);
+        v4f env = v4_div(one, v4_add(one, v4_mul(vdecay, t)));
+        v4f idx = v4_mul(vidx0, env);
+
+        v4f mod = fm_clamp4(v4_mul(idx, fm_poly_sin4(fm_poly_wrap4(mp))), 3.0f);
+        v4f s = fm_poly_sin4(fm_poly_wrap4(v4_add(cp, mod)));
+        s = fm_clamp4(v4_mul(v4_mul(v4_mul(s, env), vamp), quarter), 1.0f);
+
+        float32_t out[4];
+        v4_store(out, s);
+        for(int l = 0; l < 4; l++){
+            if(i < n[l]){
+                L[l][i] += out[l];
+                R[l][i] += out[l];
+            }
+        }
+
+        /* lanes past their n keep their state */
+        v4m live = v4_lt(k, vn);
+        v4f ncp = v4_add(cp, vc_inc);
+        v4f nmp = v4_add(mp, vm_inc);
+        ncp = v4_sub(ncp, v4_mul(fm_roundf4(v4_div(ncp, tau)), tau));
+        nmp = v4_sub(nmp, v4_mul(fm_roundf4(v4_div(nmp, tau)), tau));
+        cp = v4_select(live, ncp, cp);
+        mp = v4_select(live, nmp, mp);
+        pos = v4_add(pos, one);
+        k = v4_add(k, one);
+    }
+
+    v4_store(cp0, cp);
+    v4_store(mp0, mp);
+    for(int l = 0; l < 4; l++){
+        if(!n[l]) continue;
+        v[l]->carrier_phase = cp0[l];
+        v[l]->mod_phase = mp0[l];
+        v[l]->pos += n[l];
+    }
+}
+
+/* Build-time kernel choice for the C build:
+ *   default              fm_voice_process_poly  (matches fm_voice.s)
+ *   -DFM_ENV_EXP         fm_voice_process_exp   (exp envelope reference)
+ *   -DFM_ENV_RECURRENCE  fm_voice_process_recur (no transcendentals) */
+void fm_voice_process(fm_voice_t *v, float32_t *L, float32_t *R, uint32_t n)
+{
+#if defined(FM_ENV_RECURRENCE)
+    fm_voice_process_recur(v, L, R, n);
+#elif defined(FM_ENV_EXP)
+    fm_voice_process_exp(v, L, R, n);
+#else
+    fm_voice_process_poly(v, L, R, n);
 #endif
 }
+#endif /* FM_VOICE_ASM – otherwise src/asm/active/fm_voice.s */
 
-/* When NO_C_VOICES=1: Only init/trigger stubs - no C processing fallback
- * ASM implementation required for fm_voice_process */
+/* ---- voice pool ---- */
+
+void fm_pool_init(fm_pool_t *p, float32_t sr)
+{
+    for(int i = 0; i < FM_POOL_VOICES; i++) fm_voice_init(&p->v[i], sr);
+    p->len = p->pos = 0;
+}
+
+void fm_pool_trigger(fm_pool_t *p, float32_t carrier_freq, float32_t duration_sec, float32_t ratio, float32_t index, float32_t amp, float32_t decay)
+{
+    int pick = 0;
+    for(int i = 0; i < FM_POOL_VOICES; i++){
+        const fm_voice_t *w = &p->v[i];
+        if(w->pos >= w->len){ pick = i; break; }
+        if(w->pos > p->v[pick].pos) pick = i;
+    }
+    fm_voice_trigger(&p->v[pick], carrier_freq, duration_sec, ratio, index, amp, decay);
+
+    uint32_t left = 0;
+    for(int i = 0; i < FM_POOL_VOICES; i++){
+        const fm_voice_t *w = &p->v[i];
+        if(w->pos < w->len && w->len - w->pos > left) left = w->len - w->pos;
+    }
+    p->len = left;
+    p->pos = 0;
+}
+
+void fm_pool_process(fm_pool_t *p, float32_t *L, float32_t *R, uint32_t n)
+{
+    uint32_t k[FM_POOL_VOICES];
+    for(int i = 0; i < FM_POOL_VOICES; i++){
+        const fm_voice_t *w = &p->v[i];
+        uint32_t left = w->pos < w->len ? w->len - w->pos : 0;
+        k[i] = left < n ? left : n;
+    }
+#if !defined(FM_VOICE_ASM) && !defined(FM_ENV_EXP) && !defined(FM_ENV_RECURRENCE)
+    _Static_assert(FM_POOL_VOICES == 4, "one voice per fm_voice_process_poly_x4 lane");
+    fm_voice_t *v[4] = { &p->v[0], &p->v[1], &p->v[2], &p->v[3] };
+    float32_t *const Ls[4] = { L, L, L, L }, *const Rs[4] = { R, R, R, R };
+    fm_voice_process_poly_x4(v, Ls, Rs, k);
+#else
+    for(int i = 0; i < FM_POOL_VOICES; i++)
+        if(k[i]) fm_voice_process(&p->v[i], L, R, k[i]);
+#endif
+    p->pos += n;
+}
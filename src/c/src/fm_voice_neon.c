@@ -1,7 +1,8 @@
+#ifdef __ARM_NEON
+/* arm_neon.h typedefs float32_t; drop the -Dfloat32_t=float helper */
 #ifdef float32_t
 #undef float32_t
 #endif
-#ifdef __ARM_NEON
 #include <arm_neon.h>
 #endif
 #include <math.h>
@@ -27,7 +28,7 @@
 // while laying the groundwork for 4.2c where we replace those calls with
 // polynomial/vector approximations.
 
-void fm_voice_process(fm_voice_t *v, float32_t *L, float32_t *R, uint32_t n)
+void fm_voice_process_exp(fm_voice_t *v, float32_t *L, float32_t *R, uint32_t n)
 {
     if (!v || n==0) return;
     const float32_t sr=v->sr;
@@ -93,4 +94,4 @@ void fm_voice_process(fm_voice_t *v, float32_t *L, float32_t *R, uint32_t n)
     }
     v->carrier_phase=cp;
     v->mod_phase=mp;
-} 
\ No newline at end of file
+} 
@@ -0,0 +1,77 @@
+#include "simd4.h"
+#include "fm_voice.h"
+#include <math.h>
+
+#ifdef __clang__
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+#endif
+
+/*
+ * Recurrence FM kernel (FM_ENV_RECURRENCE).
+ *
+ * Same voice as fm_voice_process_exp() – sin(cp + idx*sin(mp)) * env * amp
+ * with env = exp(-decay*t) – but without a transcendental in the sample
+ * loop:
+ *   - the envelope advances by env *= exp(-decay/sr), like kick_t.env_coef;
+ *     it is re-anchored to the absolute position once per call so drift
+ *     stays bounded by one block,
+ *   - both phases live in Q32 accumulators (2^32 == one turn), so wrapping
+ *     is plain integer overflow instead of fmodf/compare, and the sines run
+ *     through the simd4 polynomial.
+ * fm_kernel_report measures the difference against the exp kernel.
+ */
+
+#define FM_Q32_TURN 4294967296.0
+
+static inline uint32_t fm_turns_to_q32(double turns)
+{
+    turns -= floor(turns);
+    return (uint32_t)(uint64_t)(turns * FM_Q32_TURN);
+}
+
+void fm_voice_process_recur(fm_voice_t *v, float32_t *L, float32_t *R, uint32_t n)
+{
+    if (!v || n == 0 || v->pos >= v->len) return;
+    uint32_t left = v->len - v->pos;
+    if (n > left) n = left;
+
+    const float32_t sr = v->sr;
+    const float32_t coef = expf(-v->decay / sr);
+    float32_t env = expf(-v->decay * ((float32_t)v->pos / sr));
+
+    uint32_t cq = fm_turns_to_q32((double)v->carrier_phase / (double)SIMD4_TAU);
+    uint32_t mq = fm_turns_to_q32((double)v->mod_phase / (double)SIMD4_TAU);
+    const uint32_t c_inc = fm_turns_to_q32((double)v->carrier_freq / sr);
+    const uint32_t m_inc = fm_turns_to_q32((double)v->carrier_freq * v->ratio / sr);
+
+    /* signed Q32 -> radians in [-pi, pi) */
+    const float32_t q_to_rad = (float32_t)(SIMD4_TAU / FM_Q32_TURN);
+    const v4f index0 = v4_set1(v->index0), amp = v4_set1(v->amp);
+
+    for (uint32_t i = 0; i < n; i += 4) {
+        uint32_t lanes = n - i < 4 ? n - i : 4;
+        float c4[4] = {0}, m4[4] = {0}, e4[4] = {0};
+        for (uint32_t k = 0; k < lanes; ++k) {
+            c4[k] = (float32_t)(int32_t)cq * q_to_rad;
+            m4[k] = (float32_t)(int32_t)mq * q_to_rad;
+            e4[k] = env;
+            cq += c_inc;
+            mq += m_inc;
+            env *= coef;
+        }
+        v4f e   = v4_load(e4);
+        v4f idx = v4_mul(index0, e);
+        v4f arg = v4_add(v4_load(c4), v4_mul(idx, v4_sin(v4_load(m4))));
+        float out[4];
+        v4_store(out, v4_mul(v4_mul(v4_sin(arg), e), amp));
+        for (uint32_t k = 0; k < lanes; ++k) {
+            L[i + k] += out[k];
+            R[i + k] += out[k];
+        }
+    }
+    v->pos += n;
+    v->carrier_phase = (float32_t)((double)cq * (SIMD4_TAU / FM_Q32_TURN));
+    v->mod_phase     = (float32_t)((double)mq * (SIMD4_TAU / FM_Q32_TURN));
+}
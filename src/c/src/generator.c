@@ -1,68 +1,540 @@
 #include "generator.h"
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <stdio.h>
 #include "fm_presets.h"
 #include "euclid.h"
-
-/* Helper for RNG float */
-#define RNG_FLOAT(rng) ( (rng_next_u32(rng) >> 8) * (1.0f/16777216.0f) )
+#include "prof.h"
+#include "buf_alloc.h"
+#include "voice_registry.h"
 
 /* Global RMS for real-time visual feedback */
 volatile float g_block_rms = 0.0f;
 
+uint32_t generator_delay_samples(const music_time_t *mt)
+{
+    /* Two beats: the ring is sized by the seed's tempo instead of a fixed
+       worst case, so fast seeds need a fraction of the old 848 KB. */
+    uint32_t n = 2u * STEPS_PER_BEAT * mt->step_samples;
+    if(n > MAX_DELAY_SAMPLES) n = MAX_DELAY_SAMPLES;
+    if(n == 0) n = 1;
+    return n;
+}
+
+uint32_t generator_loop_frames(const music_time_t *mt)
+{
+    return TOTAL_STEPS * mt->step_samples;
+}
+
+/* Schedule of a generator whose plan allocation failed: one empty section */
+static const generator_plan_t no_plan = { .section_count = 1 };
+
+/* Point the event window at the current section's pattern, from its start */
+static void generator_enter_pattern(generator_t *g)
+{
+    const plan_pattern_t *pat = &g->plan->patterns[g->plan->sections[g->section].pattern];
+    g->event_idx = pat->first;
+    g->event_end = pat->first + pat->count;
+}
+
+/* Pattern wrap: one more play of the section, or on to the next one
+   (the last section repeats forever once its count is used up) */
+static void generator_advance_pattern(generator_t *g)
+{
+    const generator_plan_t *p = g->plan;
+    if(!g->live_notes){
+        /* free-running: continue the stream the planned notes came from */
+        g->rng = p->patterns[p->sections[g->section].pattern].rng_after;
+        g->live_notes = true;
+    }
+    uint8_t repeats = p->sections[g->section].repeats;
+    if(repeats && ++g->section_rep >= repeats){
+        g->section_rep = 0;
+        if(g->section + 1u < p->section_count){
+            g->section++;
+        } else {
+            /* arrangement done: loop it from the top */
+            g->section = 0;
+        }
+    }
+    generator_enter_pattern(g);
+}
+
 void generator_init(generator_t *g, uint64_t seed)
+{
+    generator_init_opts(g, seed, 0);
+}
+
+void generator_init_opts(generator_t *g, uint64_t seed, uint32_t flags)
+{
+    generator_init_rate(g, seed, flags, 1);
+}
+
+void generator_init_rate(generator_t *g, uint64_t seed, uint32_t flags, uint32_t rate_div)
 {
     memset(g, 0, sizeof(generator_t));
-    g->rng = rng_seed(seed);
+#ifdef GENERATOR_ASM
+    if(rate_div != 1){
+        fprintf(stderr, "generator_init: generator.s renders at %u Hz only\n", SR);
+        rate_div = 1;
+    }
+#endif
+    if(rate_div != 1 && rate_div != 2 && rate_div != GEN_RATE_DIV_MAX){
+        fprintf(stderr, "generator_init: rate divisor %u unsupported, rendering at %u Hz\n", rate_div, SR);
+        rate_div = 1;
+    }
+    g->rate_div = rate_div;
 
-    /* ---- Derive per-run musical variation from seed ---- */
-    uint8_t kick_hits  = 2 + (rng_next_u32(&g->rng) % 3);
-    uint8_t snare_hits = 1 + (rng_next_u32(&g->rng) % 3);
-    uint8_t hat_hits   = 4 + (rng_next_u32(&g->rng) % 5);
-    
-    float bpm = 50.0f + (RNG_FLOAT(&g->rng) * 70.0f);
-    music_time_init(&g->mt, bpm);
-    music_globals_init(&g->music, &g->rng);
+    /* ---- Seed-derived timing, key and event schedule ---- */
+    generator_plan_t local, *plan = malloc(sizeof(*plan));
+    generator_plan_t *p = plan ? plan : &local;
+    int rc = generator_plan_opts(seed, (flags & GEN_INIT_EUCLID) ? PLAN_RHYTHM_EUCLID : 0, p);
+    g->mt = p->mt;
+    g->music = p->music;
+    g->rng = p->rng;
+    if(plan && rc == 0){
+        g->plan = plan;
+    } else {
+        fprintf(stderr, "generator_init: event schedule alloc failed, running silent\n");
+        generator_plan_free(p);
+        free(plan);
+        g->plan = (generator_plan_t *)&no_plan;   /* never written: generator_arrange refuses it */
+    }
+    generator_enter_pattern(g);
 
     /* ---- Init voices ---- */
-    kick_init(&g->kick, SR);
-    snare_init(&g->snare, SR, seed ^ 0xABCDEF);
-    hat_init(&g->hat, SR,   seed ^ 0x123456);
-    melody_init(&g->mel, SR);
-    fm_voice_init(&g->mid_fm, SR);
-    fm_voice_init(&g->bass_fm, SR);
-
-    /* ---- Init delay ---- */
-    delay_init(&g->delay, g->delay_buf, MAX_DELAY_SAMPLES);
-
-    /* ---- Create simple event sequence ---- */
-    eq_init(&g->q);
-    
-    /* Simple patterns based on variations */
-    uint8_t kick_pattern = (kick_hits >= 3) ? 0x91 : 0x11;  // kick on 1, and maybe 5
-    uint8_t snare_pattern = (snare_hits >= 2) ? 0x44 : 0x04; // snare on 3, maybe 7
-    uint8_t hat_pattern = 0xAA;  // hat on off-beats
-    uint8_t melody_pattern = 0xAA; // melody on even beats
-    uint8_t mid_fm_pattern = 0x88;  // mid FM on beats 4 and 8 
-    uint8_t bass_fm_pattern = 0x11; // bass FM on beats 1 and 5
-
-    for(uint32_t step = 0; step < TOTAL_STEPS; step++) {
-        uint32_t t = step * g->mt.step_samples;
-        
-        if(kick_pattern & (1 << (step % 8)))
-            eq_push(&g->q, t, EVT_KICK, 127);
-        if(snare_pattern & (1 << (step % 8)))
-            eq_push(&g->q, t, EVT_SNARE, 100);
-        if(hat_pattern & (1 << (step % 8)))
-            eq_push(&g->q, t, EVT_HAT, 80);
-        if(melody_pattern & (1 << (step % 8)))
-            eq_push(&g->q, t, EVT_MELODY, 100);
-        if(mid_fm_pattern & (1 << (step % 8)))
-            eq_push(&g->q, t, EVT_MID, 100);
-        if(bass_fm_pattern & (1 << (step % 8)))
-            eq_push(&g->q, t, EVT_FM_BASS, 80);
-    }
-}
-
-/* generator_process is implemented in ASM - src/asm/active/generator.s */
+    uint32_t noise = (flags & GEN_INIT_NOISE_V2) ? NOISE_V2 : NOISE_V1;
+#ifdef GENERATOR_ASM
+    if(noise == NOISE_V2){
+        fprintf(stderr, "generator_init: generator.s renders noise v1 only\n");
+        noise = NOISE_V1;
+    }
+#endif
+    g->fm_pool = (flags & GEN_INIT_FM_POOL) != 0;
+#ifdef GENERATOR_ASM
+    if(g->fm_pool){
+        fprintf(stderr, "generator_init: generator.s renders one voice per FM part\n");
+        g->fm_pool = false;
+    }
+#endif
+    for(uint32_t i = 0; i < voice_registry_count; i++)
+        if(voice_registry[i].init) voice_registry[i].init(g, seed, noise);
+
+#ifndef GENERATOR_ASM
+    /* ---- One-shot kick storage (generator.s renders the kick live) ---- */
+    if(!(flags & GEN_INIT_LIVE_HITS)){
+        uint32_t cap = (uint32_t)((float32_t)generator_sample_rate(g) * KICK_DUR_SEC);
+        g->kick_shot = malloc((size_t)cap * sizeof(float32_t));
+        if(g->kick_shot) g->kick_shot_cap = cap;
+    }
+#endif
+
+    /* ---- Init delay (zeroed, cache-line aligned ring) ---- */
+    if(!(flags & GEN_INIT_NO_DELAY)){
+        uint32_t delay_samples = (uint32_t)generator_ticks_to_frames(g, generator_delay_samples(&g->mt));
+        g->delay.buf = buf_alloc(0, (size_t)delay_samples * 2 * sizeof(float32_t), BUF_ZERO);
+        if(g->delay.buf){
+            g->delay.size = delay_samples;
+        } else {
+            fprintf(stderr, "generator_init: delay alloc failed, running dry\n");
+        }
+    }
+}
+
+void generator_free(generator_t *g)
+{
+    if(g->plan && g->plan != &no_plan){
+        generator_plan_free(g->plan);
+        free(g->plan);
+    }
+    g->plan = (generator_plan_t *)&no_plan;
+    free(g->kick_shot);
+    g->kick_shot = NULL;
+    g->kick_shot_len = g->kick_shot_cap = 0;
+    buf_free(g->delay.buf);
+    g->delay.buf = NULL;
+    g->delay.size = 0;
+    g->delay.idx = 0;
+    generator_release_scratch(g);
+}
+
+void generator_loop_mark(const generator_t *g, generator_loop_t *mark)
+{
+    mark->pattern = g->rng;
+    mark->snare = g->snare.rng;
+    mark->hat = g->hat.rng;
+    mark->snare4 = g->snare.noise4;
+    mark->hat4 = g->hat.noise4;
+}
+
+void generator_rewind(generator_t *g, const generator_loop_t *mark)
+{
+    generator_rewind_at(g, mark, 0);
+}
+
+void generator_rewind_at(generator_t *g, const generator_loop_t *mark, uint32_t ticks)
+{
+    g->rng = mark->pattern;
+    g->snare.rng = mark->snare;
+    g->hat.rng = mark->hat;
+    noise4_restore_lanes(&g->snare.noise4, &mark->snare4);
+    noise4_restore_lanes(&g->hat.noise4, &mark->hat4);
+    g->live_notes = false;
+    g->step = 0;
+    g->pos_in_step = ticks;
+    generator_enter_pattern(g);
+}
+
+int generator_arrange(generator_t *g, uint32_t bars)
+{
+    if(g->plan == &no_plan || generator_plan_arrange(g->plan, bars) != 0) return -1;
+    g->step = 0;
+    g->pos_in_step = 0;
+    g->section = 0;
+    g->section_rep = 0;
+    g->rng = g->plan->rng;
+    g->live_notes = false;
+    generator_enter_pattern(g);
+    return 0;
+}
+
+int generator_reserve_scratch(generator_t *g, uint32_t max_frames)
+{
+    if(g->scratch && g->scratch_frames >= max_frames) return 0;
+    generator_release_scratch(g);
+    /* Cache-line aligned for the SIMD clear/mix helpers */
+    float32_t *p = buf_alloc(0, (size_t)GENERATOR_SCRATCH_FLOATS(max_frames) * sizeof(float32_t), 0);
+    if(!p) return -1;
+    g->scratch = p;
+    g->scratch_frames = max_frames;
+    g->scratch_owned = true;
+    return 0;
+}
+
+void generator_set_scratch(generator_t *g, float32_t *storage, uint32_t max_frames)
+{
+    generator_release_scratch(g);
+    g->scratch = storage;
+    g->scratch_frames = storage ? max_frames : 0;
+    g->scratch_owned = false;
+}
+
+void generator_release_scratch(generator_t *g)
+{
+    if(g->scratch_owned) buf_free(g->scratch);
+    g->scratch = NULL;
+    g->scratch_frames = 0;
+    g->scratch_owned = false;
+}
+
+void generator_cache_kick(generator_t *g)
+{
+    if(g->kick_shot_len || g->kick.len > g->kick_shot_cap) return;
+    /* Render through kick_process itself, onto -0.0f so that adding to it
+       keeps every sample's bits (signed zeros included) */
+    kick_t k = g->kick;
+    float32_t R[256];
+    for(uint32_t i = 0; i < k.len; i++) g->kick_shot[i] = -0.0f;
+    for(uint32_t done = 0; done < k.len; done += 256){
+        uint32_t n = k.len - done < 256 ? k.len - done : 256;
+        kick_process(&k, g->kick_shot + done, R, n);
+    }
+    g->kick_shot_len = k.len;
+}
+
+int generator_init_max_block(generator_t *g, uint64_t seed, uint32_t max_frames)
+{
+    generator_init(g, seed);
+    return generator_reserve_scratch(g, max_frames);
+}
+
+void generator_hold(generator_t *g)
+{
+    g->held = true;
+    g->event_idx = g->event_end;
+}
+
+uint32_t generator_ring_frames(const generator_t *g)
+{
+    uint32_t ring = 0;
+    for(uint32_t i = 0; i < voice_registry_count; i++){
+        const voice_desc_t *v = &voice_registry[i];
+        if(!(g->active_voices & v->bit) || !v->process_block) continue;
+        uint32_t n = voice_remaining(g, v);
+        if(n > ring) ring = n;
+    }
+    return ring;
+}
+
+#ifndef GENERATOR_ASM
+/* ------------------------------------------------------------------
+ * Event-scheduled block renderer (C generator_process).
+ *
+ * Instead of walking step by step like generator.s, each iteration fires
+ * the events due at the current position, then renders every sounding
+ * voice in one call per voice up to the next event (or loop wrap).
+ * Voices are partition independent, so this matches the step-sliced asm
+ * loop sample for sample.  Voices come from voice_registry (voice_registry.h) and only
+ * those in g->active_voices are entered: sparse seeds spend most spans
+ * with one or two voices sounding.  Bus layout and voice set mirror
+ * generator.s: kick+snare -> drum bus, melody+mid_fm+bass_fm -> synth bus,
+ * then L = drums + synths.  (generator.s does not render hat/mid_simple and
+ * skips delay/limiter; keep parity so both paths produce the same art.)
+ * ------------------------------------------------------------------ */
+
+/* Sample position (within the looping pattern) of the next scheduled event */
+static uint32_t generator_next_event_time(const generator_t *g, uint32_t loop_len)
+{
+    if(g->event_idx < g->event_end) return g->plan->q.events[g->event_idx].time;
+    return loop_len; /* nothing left: run to the wrap */
+}
+
+/* Fire everything due now (generator_trigger_step ignores mid-step calls)
+   and return the frames until the next event or the wrap, at most `left`.
+   The clock counts SR ticks, rate_div per frame: a draft span ends on the
+   first frame at or after the event. */
+static uint32_t generator_fire_span(generator_t *g, uint32_t left)
+{
+    generator_trigger_step(g);
+
+    const uint32_t step_samples = g->mt.step_samples;
+    uint32_t cur = g->step * step_samples + g->pos_in_step;
+    uint32_t next = generator_next_event_time(g, TOTAL_STEPS * step_samples);
+    if(next <= cur) next = (g->step + 1) * step_samples; /* safety: always advance */
+    uint32_t span = (uint32_t)generator_ticks_to_frames(g, next - cur);
+    return span < left ? span : left;
+}
+
+/* Drop finished voices and move the step clock over `span` frames.  A
+   draft frame can overshoot the wrap by under rate_div ticks; the clock
+   keeps them so the next loop stays on the SR grid. */
+static void generator_end_span(generator_t *g, uint32_t span)
+{
+    generator_sweep_voices(g);
+
+    const uint32_t step_samples = g->mt.step_samples;
+    const uint32_t loop_len = TOTAL_STEPS * step_samples;
+    uint32_t cur = g->step * step_samples + g->pos_in_step + span * g->rate_div;
+    if(cur >= loop_len){
+        cur -= loop_len;
+        g->step = cur / step_samples;
+        g->pos_in_step = cur - g->step * step_samples;
+        if(!g->held) generator_advance_pattern(g);
+    } else {
+        g->step = cur / step_samples;
+        g->pos_in_step = cur - g->step * step_samples;
+    }
+}
+
+/* Zeroed Ld/Rd/Ls/Rs for num_frames: the generator's arena when large
+   enough, else one heap block (*heap set; buf_free it after) */
+static float32_t *generator_buses(generator_t *g, uint32_t num_frames, bool *heap)
+{
+    float32_t *scratch = g->scratch;
+    *heap = false;
+    if(!scratch || g->scratch_frames < num_frames){
+        scratch = buf_alloc(0, (size_t)GENERATOR_SCRATCH_FLOATS(num_frames) * sizeof(float32_t), 0);
+        if(!scratch) return NULL;
+        *heap = true;
+    }
+    memset(scratch, 0, (size_t)GENERATOR_SCRATCH_FLOATS(num_frames) * sizeof(float32_t));
+    return scratch;
+}
+
+/* L = drums + synths */
+static void generator_mix_buses(const float32_t *scratch, float32_t *L, float32_t *R, uint32_t num_frames)
+{
+    const float32_t *Ld = scratch;
+    const float32_t *Rd = Ld + num_frames;
+    const float32_t *Ls = Rd + num_frames;
+    const float32_t *Rs = Ls + num_frames;
+    for(uint32_t i = 0; i < num_frames; i++){
+        L[i] = Ld[i] + Ls[i];
+        R[i] = Rd[i] + Rs[i];
+    }
+}
+
+#ifdef PROF_ENABLE
+/* Profiler stage of each registry entry, "voice.<name>" */
+static int voice_prof_id[32] = { [0 ... 31] = -1 };
+#define VOICE_PROF_BEGIN() const uint64_t voice_t0 = prof_ticks()
+#define VOICE_PROF_END(i) \
+    prof_record(prof_stage_cached(&voice_prof_id[i], voice_registry[i].stage), voice_t0, prof_ticks())
+#else
+#define VOICE_PROF_BEGIN() do { } while(0)
+#define VOICE_PROF_END(i) do { } while(0)
+#endif
+
+/* The span loop: each voice adds into out_L/out_R[stems ? v->stem : v->bus]
+   (zeroed by the caller) */
+static void generator_render(generator_t *g, float32_t *const out_L[], float32_t *const out_R[],
+                             bool stems, uint32_t num_frames)
+{
+    uint32_t done = 0;
+    while(done < num_frames){
+        uint32_t span = generator_fire_span(g, num_frames - done);
+
+        /* One call per sounding voice for the whole span */
+        for(uint32_t i = 0; i < voice_registry_count; i++){
+            const voice_desc_t *v = &voice_registry[i];
+            if(!(g->active_voices & v->bit) || !v->process_block) continue;
+            uint32_t n = voice_remaining(g, v);
+            if(n == 0) continue;
+            if(n > span) n = span;
+            uint32_t out = stems ? v->stem : v->bus;
+            VOICE_PROF_BEGIN();
+            v->process_block(g, out_L[out] + done, out_R[out] + done, n);
+            VOICE_PROF_END(i);
+        }
+        generator_end_span(g, span);
+        done += span;
+    }
+}
+
+void generator_process(generator_t *g, float32_t *L, float32_t *R, uint32_t num_frames)
+{
+    if(num_frames == 0) return;
+    PROF_SCOPE(gen, "generator_process");
+
+    bool heap;
+    float32_t *scratch = generator_buses(g, num_frames, &heap);
+    if(!scratch) return;
+    float32_t *Ld = scratch;
+    float32_t *Rd = Ld + num_frames;
+    float32_t *Ls = Rd + num_frames;
+    float32_t *Rs = Ls + num_frames;
+
+    float32_t *bus_L[2] = { Ld, Ls };
+    float32_t *bus_R[2] = { Rd, Rs };
+    generator_render(g, bus_L, bus_R, false, num_frames);
+
+    generator_mix_buses(scratch, L, R, num_frames);
+    if(heap) buf_free(scratch);
+}
+
+/* A voice's samples added into a zeroed stem are the samples it would add
+   into the bus, and stems sum in the bus's voice order, so the mix is
+   bit-exact (-ffp-contract=off keeps the adds unfused).  The FM pools'
+   lanes add into the bus one after another, so a pool render's mix can
+   differ from generator_process in the last bit. */
+void generator_process_stems(generator_t *g, float32_t *const L[GEN_STEMS], float32_t *const R[GEN_STEMS],
+                             float32_t *mixL, float32_t *mixR, uint32_t num_frames)
+{
+    if(num_frames == 0) return;
+    PROF_SCOPE(gen, "generator_process_stems");
+
+    for(uint32_t s = 0; s < GEN_STEMS; s++){
+        memset(L[s], 0, (size_t)num_frames * sizeof(float32_t));
+        memset(R[s], 0, (size_t)num_frames * sizeof(float32_t));
+    }
+    generator_render(g, L, R, true, num_frames);
+
+    for(uint32_t i = 0; i < num_frames; i++){
+        float32_t sl = L[VOICE_STEM_MELODY][i] + L[VOICE_STEM_MID][i];
+        float32_t sr = R[VOICE_STEM_MELODY][i] + R[VOICE_STEM_MID][i];
+        sl += L[VOICE_STEM_BASS][i];
+        sr += R[VOICE_STEM_BASS][i];
+        mixL[i] = L[VOICE_STEM_DRUMS][i] + sl;
+        mixR[i] = R[VOICE_STEM_DRUMS][i] + sr;
+    }
+}
+
+/* ------------------------------------------------------------------
+ * Lockstep renderer: the same loop over several generators at once.
+ *
+ * Every lane's span ends where any lane's does (the nearest event or wrap
+ * among them), which only cuts spans finer: triggers landing mid-step are
+ * no-ops and voices are partition independent, so each lane still gets
+ * generator_process's samples.  Within a span a voice with a lane kernel
+ * renders all its sounding lanes in one call, one seed per SIMD lane;
+ * other voices, and a voice sounding in a single lane, go lane by lane.
+ * ------------------------------------------------------------------ */
+void generator_process_lanes(generator_t *const g[], uint32_t lanes, float32_t *const L[],
+                             float32_t *const R[], const uint32_t frames[])
+{
+    PROF_SCOPE(gen, "generator_process_lanes");
+    if(lanes > GEN_LANES) lanes = GEN_LANES;
+
+    float32_t *scratch[GEN_LANES] = {NULL};
+    bool heap[GEN_LANES] = {false};
+    uint32_t done[GEN_LANES] = {0}, left[GEN_LANES] = {0};
+    for(uint32_t l = 0; l < lanes; l++){
+        if(!frames[l]) continue;
+        scratch[l] = generator_buses(g[l], frames[l], &heap[l]);
+        if(scratch[l]) left[l] = frames[l];
+    }
+
+    generator_t *lane_g[GEN_LANES] = {NULL};
+    for(uint32_t l = 0; l < lanes; l++) lane_g[l] = g[l];
+
+    for(;;){
+        uint32_t span = UINT32_MAX;
+        for(uint32_t l = 0; l < lanes; l++){
+            if(done[l] == left[l]) continue;
+            uint32_t s = generator_fire_span(g[l], left[l] - done[l]);
+            if(s < span) span = s;
+        }
+        if(span == UINT32_MAX) break;   /* every lane finished */
+
+        float32_t *bus_L[2][GEN_LANES] = {{NULL}}, *bus_R[2][GEN_LANES] = {{NULL}};
+        for(uint32_t l = 0; l < lanes; l++){
+            if(done[l] == left[l]) continue;
+            uint32_t f = frames[l];
+            bus_L[VOICE_BUS_DRUMS][l] = scratch[l] + done[l];
+            bus_R[VOICE_BUS_DRUMS][l] = scratch[l] + f + done[l];
+            bus_L[VOICE_BUS_SYNTH][l] = scratch[l] + 2 * f + done[l];
+            bus_R[VOICE_BUS_SYNTH][l] = scratch[l] + 3 * f + done[l];
+        }
+        for(uint32_t i = 0; i < voice_registry_count; i++){
+            const voice_desc_t *v = &voice_registry[i];
+            if(!v->process_block) continue;
+            uint32_t n[GEN_LANES] = {0}, sounding = 0;
+            for(uint32_t l = 0; l < lanes; l++){
+                if(done[l] == left[l] || !(g[l]->active_voices & v->bit)) continue;
+                uint32_t r = voice_remaining(g[l], v);
+                n[l] = r < span ? r : span;
+                if(n[l]) sounding++;
+            }
+            if(!sounding) continue;
+            VOICE_PROF_BEGIN();
+            if(v->process_lanes && sounding > 1){
+                v->process_lanes(lane_g, bus_L[v->bus], bus_R[v->bus], n);
+            } else {
+                for(uint32_t l = 0; l < lanes; l++)
+                    if(n[l]) v->process_block(g[l], bus_L[v->bus][l], bus_R[v->bus][l], n[l]);
+            }
+            VOICE_PROF_END(i);
+        }
+        for(uint32_t l = 0; l < lanes; l++){
+            if(done[l] == left[l]) continue;
+            generator_end_span(g[l], span);
+            done[l] += span;
+        }
+    }
+
+    for(uint32_t l = 0; l < lanes; l++){
+        if(!scratch[l]) continue;
+        generator_mix_buses(scratch[l], L[l], R[l], frames[l]);
+        if(heap[l]) buf_free(scratch[l]);
+    }
+}
+#else
+void generator_process_lanes(generator_t *const g[], uint32_t lanes, float32_t *const L[],
+                             float32_t *const R[], const uint32_t frames[])
+{
+    for(uint32_t l = 0; l < lanes && l < GEN_LANES; l++)
+        if(frames[l]) generator_process(g[l], L[l], R[l], frames[l]);
+}
+
+void generator_process_stems(generator_t *g, float32_t *const L[GEN_STEMS], float32_t *const R[GEN_STEMS],
+                             float32_t *mixL, float32_t *mixR, uint32_t num_frames)
+{
+    /* generator.s mixes its buses internally: no stems to hand out */
+    for(uint32_t s = 0; s < GEN_STEMS; s++){
+        memset(L[s], 0, (size_t)num_frames * sizeof(float32_t));
+        memset(R[s], 0, (size_t)num_frames * sizeof(float32_t));
+    }
+    generator_process(g, mixL, mixR, num_frames);
+}
+#endif /* GENERATOR_ASM – otherwise src/asm/active/generator.s */
@@ -1,22 +1,116 @@
-/* generator_offsets.c - Generate ASM constants for struct offsets */
+/* generator_offsets.c - Generate ASM constants for struct offsets
+ *
+ * Never linked: `make include/offsets.inc` compiles this file with -S and
+ * keeps the .equ lines, so every .s file that touches a C struct reads its
+ * field offsets from the same headers the C code is built against.  A field
+ * can be moved or a hot member reordered without editing any assembly.
+ */
 #include <stddef.h>
 #include "generator.h"
 
+/* %c prints the bare immediate (no '#' on AArch64, no '$' on x86) */
 #define OFF(sym, type, member) \
-    asm(".equ " #sym ", %0" :: "i"(offsetof(type, member)));
+    __asm__(".equ " #sym ", %c0" :: "i"(offsetof(type, member)));
+#define SIZE(sym, type) \
+    __asm__(".equ " #sym ", %c0" :: "i"(sizeof(type)));
+
+/* generator.s addresses generator_t fields as g + imm12 (add/ldrb reach),
+   which the hot block keeps them inside */
+#define G_IMM12 0x1000
+#define IN_IMM12(member) \
+    _Static_assert(offsetof(generator_t, member) + sizeof(((generator_t *)0)->member) <= G_IMM12, \
+                   #member " is out of generator.s' g + imm12 reach");
+
+IN_IMM12(event_idx)
+IN_IMM12(mt)
+IN_IMM12(active_voices)
+IN_IMM12(scratch)
+IN_IMM12(scratch_frames)
+IN_IMM12(bass_fm)
+IN_IMM12(delay)
+IN_IMM12(limiter)
 
 void generator_offsets(void) {
+    /* generator_t */
+    OFF(G_OFF_STEP_SAMPLES, generator_t, mt.step_samples)
     OFF(G_OFF_KICK       , generator_t, kick)
     OFF(G_OFF_SNARE      , generator_t, snare)
     OFF(G_OFF_HAT        , generator_t, hat)
     OFF(G_OFF_MELODY     , generator_t, mel)
     OFF(G_OFF_MID_FM     , generator_t, mid_fm)
     OFF(G_OFF_BASS_FM    , generator_t, bass_fm)
-    OFF(G_OFF_EVQ        , generator_t, q)
-    OFF(G_OFF_EV_COUNT   , generator_t, q.count)
+    OFF(G_OFF_PLAN       , generator_t, plan)         /* generator_plan_t * */
     OFF(G_OFF_EVENT_IDX  , generator_t, event_idx)
+    OFF(G_OFF_EVENT_END  , generator_t, event_end)
     OFF(G_OFF_STEP       , generator_t, step)
     OFF(G_OFF_POS_IN_STEP, generator_t, pos_in_step)
     OFF(G_OFF_DELAY      , generator_t, delay)
     OFF(G_OFF_LIMITER    , generator_t, limiter)
+    OFF(G_OFF_SCRATCH    , generator_t, scratch)
+    OFF(G_OFF_SCRATCH_N  , generator_t, scratch_frames)
+    OFF(G_OFF_ACTIVE     , generator_t, active_voices)
+
+    /* event_queue_t / event_t */
+    OFF(EQ_OFF_EVENTS    , event_queue_t, events)
+    OFF(EQ_OFF_COUNT     , event_queue_t, count)
+    OFF(EQ_OFF_CAP       , event_queue_t, cap)
+    OFF(EV_OFF_TIME      , event_t, time)
+    OFF(EV_OFF_TYPE      , event_t, type)
+    OFF(EV_OFF_AUX       , event_t, aux)
+    OFF(EV_OFF_NOTE      , event_t, note)
+    OFF(EV_OFF_PRESET    , event_t, preset)
+    SIZE(EV_SIZE         , event_t)
+
+    /* kick_t */
+    OFF(K_SR             , kick_t, sr)
+    OFF(K_POS            , kick_t, pos)
+    OFF(K_LEN            , kick_t, len)
+    OFF(K_ENV            , kick_t, env)
+    OFF(K_ENV_COEF       , kick_t, env_coef)
+    OFF(K_Y_PREV         , kick_t, y_prev)
+    OFF(K_Y_PREV2        , kick_t, y_prev2)
+    OFF(K_K1             , kick_t, k1)
+
+    /* snare_t / hat_t */
+    OFF(S_POS            , snare_t, pos)
+    OFF(S_LEN            , snare_t, len)
+    OFF(S_ENV            , snare_t, env)
+    OFF(S_ENV_COEF       , snare_t, env_coef)
+    OFF(S_RNG_STATE      , snare_t, rng.state)
+    OFF(H_POS            , hat_t, pos)
+    OFF(H_LEN            , hat_t, len)
+    OFF(H_ENV            , hat_t, env)
+    OFF(H_ENV_COEF       , hat_t, env_coef)
+    OFF(H_RNG_STATE      , hat_t, rng.state)
+
+    /* melody_t */
+    OFF(M_PHASE          , melody_t, osc.phase)
+    OFF(M_POS            , melody_t, pos)
+    OFF(M_LEN            , melody_t, len)
+    OFF(M_SR             , melody_t, sr)
+    OFF(M_FREQ           , melody_t, freq)
+
+    /* fm_voice_t */
+    OFF(FM_SR            , fm_voice_t, sr)
+    OFF(FM_CARRIER_FREQ  , fm_voice_t, carrier_freq)
+    OFF(FM_RATIO         , fm_voice_t, ratio)
+    OFF(FM_INDEX0        , fm_voice_t, index0)
+    OFF(FM_AMP           , fm_voice_t, amp)
+    OFF(FM_DECAY         , fm_voice_t, decay)
+    OFF(FM_LEN           , fm_voice_t, len)
+    OFF(FM_POS           , fm_voice_t, pos)
+    OFF(FM_CARRIER_PHASE , fm_voice_t, carrier_phase)
+    OFF(FM_MOD_PHASE     , fm_voice_t, mod_phase)
+
+    /* delay_t */
+    OFF(D_BUF            , delay_t, buf)
+    OFF(D_SIZE           , delay_t, size)
+    OFF(D_IDX            , delay_t, idx)
+
+    /* limiter_t */
+    OFF(L_ATTACK         , limiter_t, attack_coeff)
+    OFF(L_RELEASE        , limiter_t, release_coeff)
+    OFF(L_ENVELOPE       , limiter_t, envelope)
+    OFF(L_THRESHOLD      , limiter_t, threshold)
+    OFF(L_KNEE           , limiter_t, knee_width)
 }
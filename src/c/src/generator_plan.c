@@ -0,0 +1,288 @@
+#include "generator_plan.h"
+#include "euclid.h"
+#include <math.h>
+#include <string.h>
+
+/* Arrangement draws come from their own stream so p->rng, and with it
+   every note choice at trigger time, is the same with or without one */
+#define PLAN_ARRANGE_SALT 0xA55A5EC7104EULL
+
+/* Per-voice step masks of one pattern, indexed by event_type_t
+   (bit n fires on every step % 8 == n) */
+typedef struct {
+    uint8_t m[EVT_COUNT];
+} plan_masks_t;
+
+/* Velocity (aux) of each voice's hits */
+static const uint8_t plan_aux[EVT_COUNT] = {
+    [EVT_KICK] = 127, [EVT_SNARE] = 100, [EVT_HAT] = 80,
+    [EVT_MELODY] = 100, [EVT_MID] = 100, [EVT_FM_BASS] = 80,
+};
+
+/* PLAN_RHYTHM_EUCLID: Euclid(pulses, 8) with the first pulse on `anchor`
+   (-1: as the bucket spreads it).  PLAN_HITS_* take the seed's counts. */
+enum { PLAN_HITS_KICK = -1, PLAN_HITS_SNARE = -2, PLAN_HITS_HAT = -3 };
+static const struct { int8_t pulses, anchor; } plan_euclid[EVT_COUNT] = {
+    [EVT_KICK]    = { PLAN_HITS_KICK,   0 },   /* downbeat */
+    [EVT_SNARE]   = { PLAN_HITS_SNARE,  2 },   /* backbeat */
+    [EVT_HAT]     = { PLAN_HITS_HAT,   -1 },   /* 4 hits: the off-beats */
+    [EVT_MELODY]  = { 4, -1 },                 /* 0xAA */
+    [EVT_MID]     = { 2, -1 },                 /* 0x88 */
+    [EVT_FM_BASS] = { 2,  0 },                 /* 0x11 */
+};
+
+void generator_plan_note(const music_globals_t *m, rng_t *rng, event_t *e)
+{
+    uint32_t len = m->scale_len;
+    switch(e->type) {
+        case EVT_MELODY:
+            switch(e->aux) {
+                case 0:
+                case 2:
+                    e->note = PITCH_NOTE(PITCH_UP2, 0);
+                    break;
+                case 1:
+                    e->note = PITCH_NOTE(PITCH_UP, rng_next_u32(rng) % (len - 1) + 1);
+                    break;
+                case 3:
+                    e->note = PITCH_NOTE(PITCH_ROOT, rng_next_u32(rng) % (len - 1) + 1);
+                    break;
+                default:
+                    e->note = PITCH_NOTE(PITCH_ROOT, 0);   /* the root */
+                    break;
+            }
+            break;
+        case EVT_MID:
+            e->note = PITCH_NOTE(PITCH_UP, rng_next_u32(rng) % len);
+            break;
+        case EVT_FM_BASS:
+            e->note = PITCH_NOTE(PITCH_BASS, rng_next_u32(rng) % len);
+            e->preset = (uint8_t)(rng_next_u32(rng) % 3);
+            break;
+        default:
+            break;
+    }
+}
+
+/* Notes for the pattern's events from `first` on, in play order, drawn
+   from the loop's starting RNG state: what generator_trigger_step used
+   to draw per hit on every play that follows a rewind */
+static void plan_choose_notes(generator_plan_t *p, plan_pattern_t *pat)
+{
+    rng_t rng = p->rng;
+    for(uint32_t i = pat->first; i < p->q.count; i++)
+        generator_plan_note(&p->music, &rng, &p->q.events[i]);
+    pat->rng_after = rng;
+}
+
+/* Same expressions the trigger path evaluated per hit, so table lookups
+   give bit-identical frequencies */
+static void plan_pitch_table(generator_plan_t *p)
+{
+    float root = p->music.root_freq;
+    for(uint32_t d = 0; d < p->music.scale_len && d < PITCH_MAX_DEGREES; d++) {
+        int deg = p->music.scale_degrees[d];
+        p->pitch[PITCH_NOTE(PITCH_BASS, d)] = root / 4.0f * powf(2.0f, deg / 12.0f);
+        p->pitch[PITCH_NOTE(PITCH_ROOT, d)] = root * powf(2.0f, deg / 12.0f);
+        p->pitch[PITCH_NOTE(PITCH_UP, d)]   = root * powf(2.0f, deg / 12.0f + 1.0f);
+        p->pitch[PITCH_NOTE(PITCH_UP2, d)]  = root * powf(2.0f, deg / 12.0f + 2.0f);
+    }
+}
+
+/* Append one TOTAL_STEPS pattern to q; times are relative to its start.
+   The masks become one voice set per step, so emission walks only the
+   steps that fire and, within a step, only the voices that hit (both by
+   ctz), in event_type_t order as the renderer expects. */
+static int plan_add_pattern(generator_plan_t *p, const plan_masks_t *m)
+{
+    if(p->pattern_count == PLAN_MAX_PATTERNS) return -1;
+    plan_pattern_t *pat = &p->patterns[p->pattern_count];
+    pat->first = p->q.count;
+
+    uint8_t voices[8] = {0};   /* voices hitting on step % 8 */
+    uint32_t n = 0;
+    for(uint32_t v = 0; v < EVT_COUNT; v++) {
+        for(uint32_t bits = m->m[v]; bits; bits &= bits - 1)
+            voices[__builtin_ctz(bits)] |= (uint8_t)(1u << v);
+        n += (uint32_t)__builtin_popcount(m->m[v]);
+    }
+    uint32_t live = 0;   /* steps of the pattern with any hit */
+    for(uint32_t step = 0; step < TOTAL_STEPS; step++)
+        if(voices[step % 8]) live |= 1u << step;
+
+    if(eq_reserve(&p->q, p->q.count + n * (TOTAL_STEPS / 8)) != 0) return -1;
+    for(; live; live &= live - 1) {
+        uint32_t step = (uint32_t)__builtin_ctz(live);
+        uint32_t t = step * p->mt.step_samples;
+        for(uint32_t vs = voices[step % 8]; vs; vs &= vs - 1) {
+            uint8_t type = (uint8_t)__builtin_ctz(vs);
+            p->q.events[p->q.count++] = (event_t){t, type, plan_aux[type], 0, 0};
+        }
+    }
+    plan_choose_notes(p, pat);
+    pat->count = p->q.count - pat->first;
+    p->pattern_count++;
+    return 0;
+}
+
+static plan_masks_t plan_main_masks(const generator_plan_t *p)
+{
+    plan_masks_t m;
+    if(p->rhythm & PLAN_RHYTHM_EUCLID) {
+        for(int v = 0; v < EVT_COUNT; v++) {
+            int pulses = plan_euclid[v].pulses;
+            if(pulses == PLAN_HITS_KICK) pulses = p->kick_hits;
+            else if(pulses == PLAN_HITS_SNARE) pulses = p->snare_hits;
+            else if(pulses == PLAN_HITS_HAT) pulses = p->hat_hits;
+            m.m[v] = (uint8_t)euclid_mask(pulses, 8, plan_euclid[v].anchor);
+        }
+        return m;
+    }
+    /* Classic patterns based on variations (every seed's historical sound) */
+    m.m[EVT_KICK] = (p->kick_hits >= 3) ? 0x91 : 0x11;   // kick on 1, and maybe 5
+    m.m[EVT_SNARE] = (p->snare_hits >= 2) ? 0x44 : 0x04; // snare on 3, maybe 7
+    m.m[EVT_HAT] = 0xAA;      // hat on off-beats
+    m.m[EVT_MELODY] = 0xAA;   // melody on even beats
+    m.m[EVT_MID] = 0x88;      // mid FM on beats 4 and 8
+    m.m[EVT_FM_BASS] = 0x11;  // bass FM on beats 1 and 5
+    return m;
+}
+
+int generator_plan(uint64_t seed, generator_plan_t *p)
+{
+    return generator_plan_opts(seed, 0, p);
+}
+
+int generator_plan_opts(uint64_t seed, uint32_t rhythm, generator_plan_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->seed = seed;
+    p->rhythm = (uint8_t)rhythm;
+    p->rng = rng_seed(seed);
+
+    /* ---- Derive per-run musical variation from seed ---- */
+    plan_variation_t v;
+    generator_plan_variation(&p->rng, &v);
+    p->kick_hits  = v.kick_hits;
+    p->snare_hits = v.snare_hits;
+    p->hat_hits   = v.hat_hits;
+    p->mt = v.mt;
+    p->music = v.music;
+    plan_pitch_table(p);
+
+    /* ---- Create simple event sequence: MAIN, looped forever ---- */
+    eq_init(&p->q);
+    plan_masks_t m = plan_main_masks(p);
+    if(plan_add_pattern(p, &m) != 0) return -1;
+    p->sections[0] = (plan_section_t){PLAN_PAT_MAIN, 0};
+    p->section_count = 1;
+    return 0;
+}
+
+static void plan_add_section(generator_plan_t *p, uint8_t pattern, uint8_t repeats)
+{
+    /* Out of sections: the last one runs on, the arrangement stays whole */
+    if(p->section_count == PLAN_MAX_SECTIONS) {
+        p->sections[p->section_count - 1].repeats += repeats;
+        return;
+    }
+    p->sections[p->section_count++] = (plan_section_t){pattern, repeats};
+}
+
+int generator_plan_arrange(generator_plan_t *p, uint32_t bars)
+{
+    if(bars > PLAN_MAX_ARRANGE_BARS) bars = PLAN_MAX_ARRANGE_BARS;
+    uint32_t plays = (bars + BARS_PER_SEG - 1) / BARS_PER_SEG;
+    if(plays < 2) return 0;   /* one pattern: nothing to arrange */
+
+    /* Rebuild from MAIN so a second call starts clean */
+    p->q.count = p->patterns[PLAN_PAT_MAIN].count;
+    p->pattern_count = 1;
+    p->section_count = 0;
+
+    plan_masks_t main = plan_main_masks(p);
+    plan_masks_t sparse = main, drums = main, fill = main;
+    sparse.m[EVT_KICK] = sparse.m[EVT_SNARE] = 0;
+    sparse.m[EVT_FM_BASS] = 0x01;
+    drums.m[EVT_MELODY] = drums.m[EVT_MID] = 0;
+    fill.m[EVT_SNARE] |= 0xA0;
+    fill.m[EVT_HAT] = 0xFF;
+    if(plan_add_pattern(p, &sparse) != 0 || plan_add_pattern(p, &drums) != 0 ||
+       plan_add_pattern(p, &fill) != 0) {
+        /* back to the plain loop rather than half an arrangement */
+        p->q.count = p->patterns[PLAN_PAT_MAIN].count;
+        p->pattern_count = 1;
+        p->sections[0] = (plan_section_t){PLAN_PAT_MAIN, 0};
+        p->section_count = 1;
+        return -1;
+    }
+
+    rng_t rng = rng_seed(p->seed ^ PLAN_ARRANGE_SALT);
+    uint32_t left = plays;
+    if(plays >= 4) {
+        plan_add_section(p, PLAN_PAT_SPARSE, 1);
+        left--;
+    }
+    while(left) {
+        uint32_t run = 2 + rng_next_u32(&rng) % 3;
+        if(run > left) run = left;
+        plan_add_section(p, PLAN_PAT_MAIN, (uint8_t)run);
+        left -= run;
+        if(!left) break;
+        plan_add_section(p, PLAN_PAT_FILL, 1);
+        left--;
+        if(!left) break;
+        uint32_t bridge = 1 + rng_next_u32(&rng) % 2;
+        if(bridge > left) bridge = left;
+        plan_add_section(p, (rng_next_u32(&rng) & 1) ? PLAN_PAT_DRUMS : PLAN_PAT_SPARSE, (uint8_t)bridge);
+        left -= bridge;
+    }
+    return 0;
+}
+
+uint32_t generator_plan_bars(const generator_plan_t *p)
+{
+    uint32_t plays = 0;
+    for(uint8_t i = 0; i < p->section_count; i++) {
+        if(!p->sections[i].repeats) return 0;
+        plays += p->sections[i].repeats;
+    }
+    return plays * BARS_PER_SEG;
+}
+
+/* Samples a note of `e` plays at SR, as the voice's trigger computes it;
+   0 for the voices left out of the mix (hat, mid simple waves) */
+static uint32_t plan_note_len(const music_time_t *mt, const event_t *e)
+{
+    const float sr = (float)SR;
+    switch((event_type_t)e->type){
+        case EVT_KICK:    return (uint32_t)(sr * KICK_DUR_SEC);
+        case EVT_SNARE:   return (uint32_t)(SNARE_DUR_SEC * sr);
+        case EVT_MELODY: {
+            uint32_t len = (uint32_t)(mt->beat_sec * sr);
+            uint32_t max = (uint32_t)(MELODY_MAX_SEC * sr);
+            return len > max ? max : len;
+        }
+        case EVT_MID:     return e->aux >= 3 ? (uint32_t)((mt->step_sec + (1.0f/ sr)) * sr) : 0;
+        case EVT_FM_BASS: return (uint32_t)((mt->beat_sec * 2) * sr);
+        default:          return 0;
+    }
+}
+
+uint32_t generator_plan_tail(const generator_plan_t *plan)
+{
+    const plan_pattern_t *pat = &plan->patterns[PLAN_PAT_MAIN];
+    const uint32_t loop = TOTAL_STEPS * plan->mt.step_samples;
+    uint32_t end = loop;
+    for(uint32_t i = 0; i < pat->count; i++){
+        const event_t *e = &plan->q.events[pat->first + i];
+        uint32_t note_end = e->time + plan_note_len(&plan->mt, e);
+        if(note_end > end) end = note_end;
+    }
+    return end - loop;
+}
+
+void generator_plan_free(generator_plan_t *p)
+{
+    eq_free(&p->q);
+}
@@ -1,16 +1,30 @@
 #include "hat.h"
 #include <math.h>
-#include <stdio.h>
+#include "trace.h"
+
+#ifdef __clang__
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+#endif
 
 #define HAT_DECAY_RATE 120.0f
 #define HAT_DUR_SEC 0.05f
+#define HAT_AMP 0.15f
 
 void hat_init(hat_t *h, float32_t sr, uint64_t seed)
+{
+    hat_init_noise(h, sr, seed, NOISE_V1);
+}
+
+void hat_init_noise(hat_t *h, float32_t sr, uint64_t seed, uint32_t version)
 {
     h->pos=0; h->len=0; h->sr=sr;
     h->env = 0.0f;
     h->env_coef = 0.0f;
     h->rng = rng_seed(seed);
+    h->noise_version = version;
+    noise4_seed(&h->noise4, seed);
 }
 
 void hat_trigger(hat_t *h)
@@ -19,12 +33,36 @@ void hat_trigger(hat_t *h)
     h->len = (uint32_t)(HAT_DUR_SEC * h->sr);
     h->env = 1.0f;
     h->env_coef = expf(-HAT_DECAY_RATE / h->sr);
-    
-#ifndef REALTIME_MODE
-    printf("*** HAT_TRIGGER: len=%u env_coef=%f ***\n", 
-           h->len, h->env_coef);
-    fflush(stdout);
-#endif
+    if(h->noise_version == NOISE_V2) noise4_start(&h->noise4, h->env, h->env_coef);
+    TRACE(1, TRACE_HAT, h->len, trace_f32(h->env_coef), 0, 0, 0, 0);
 }
 
-/* NO hat_process - ASM implementation required */
+/* Noise v2: the same burst from the four-lane engine (noise4.h) */
+void hat_process_v2(hat_t *h, float32_t *L, float32_t *R, uint32_t n)
+{
+    if(h->pos >= h->len || n == 0) return;
+    uint32_t m = h->len - h->pos;
+    if(m > n) m = n;
+    noise4_decay_add(&h->noise4, L, R, m, HAT_AMP);
+    h->pos += m;
+}
+
+#ifndef HAT_ASM
+/* Portable port of hat.s: envelope recurrence + SplitMix64 noise. */
+void hat_process(hat_t *h, float32_t *L, float32_t *R, uint32_t n)
+{
+    uint32_t pos = h->pos;
+    if(pos >= h->len || n == 0) return;
+
+    float32_t env = h->env;
+    const float32_t coef = h->env_coef;
+    for(uint32_t i = 0; i < n && pos < h->len; ++i, ++pos){
+        env *= coef;
+        float32_t sample = (rng_float_mono(&h->rng) * env) * HAT_AMP;
+        L[i] += sample;
+        R[i] += sample;
+    }
+    h->env = env;
+    h->pos = pos;
+}
+#endif /* HAT_ASM – otherwise src/asm/active/hat.s */
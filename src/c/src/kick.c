@@ -1,7 +1,7 @@
 #include "kick.h"
 #include <math.h>
 #include <assert.h>
-#include <stdio.h>
+#include "trace.h"
 
 #define KICK_BASE_FREQ 70.0f
 #define TAU (2.0f * M_PI)
@@ -24,19 +24,44 @@ void kick_trigger(kick_t *k)
 {
     k->pos = 0;
     k->env = 1.0f;
-    k->len = (uint32_t)(k->sr * 0.5f);  // 500ms duration
+    k->len = (uint32_t)(k->sr * KICK_DUR_SEC);  // 500ms duration
     k->env_coef = powf(0.001f, 1.0f / k->len);  // -60dB envelope
 
     /* Reset sine recurrence state */
     float32_t delta = TAU * KICK_BASE_FREQ / k->sr;
     k->y_prev  = 0.0f;            /* sin(0) */
     k->y_prev2 = -sinf(delta);    /* y[-1] = -sin(Δ) */
-    
-#ifndef REALTIME_MODE
-    printf("*** KICK_TRIGGER: len=%u env_coef=%f y_prev2=%f k1=%f ***\n", 
-           k->len, k->env_coef, k->y_prev2, k->k1);
-    fflush(stdout);
-#endif
+    TRACE(1, TRACE_KICK, k->len, trace_f32(k->env_coef), trace_f32(k->y_prev2), trace_f32(k->k1), 0, 0);
 }
 
-/* NO kick_process - ASM implementation required */
+#ifndef KICK_ASM
+/* Portable port of kick.s: same recurrence, same operation order, so it
+   matches the ARM64 build sample for sample. */
+#define KICK_AMP 0.9f
+
+void kick_process(kick_t *k, float32_t *L, float32_t *R, uint32_t n)
+{
+    uint32_t pos = k->pos;
+    if(pos >= k->len || n == 0) return;
+
+    float32_t env = k->env;
+    const float32_t coef = k->env_coef;
+    float32_t y1 = k->y_prev;
+    float32_t y2 = k->y_prev2;
+    const float32_t k1 = k->k1;
+
+    for(uint32_t i = 0; i < n && pos < k->len; ++i, ++pos){
+        env *= coef;
+        float32_t y = k1 * y1 - y2;
+        float32_t sample = (env * y) * KICK_AMP;
+        L[i] += sample;
+        R[i] += sample;
+        y2 = y1;
+        y1 = y;
+    }
+    k->env = env;
+    k->y_prev = y1;
+    k->y_prev2 = y2;
+    k->pos = pos;
+}
+#endif /* KICK_ASM – otherwise src/asm/active/kick.s */
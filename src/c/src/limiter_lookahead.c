@@ -0,0 +1,106 @@
+#include "limiter.h"
+#include "simd4.h"
+#include <string.h>
+
+#ifdef __clang__
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+#endif
+
+/* Ring of three blocks: `cur` is being filled from the input while the block
+ * two behind it (already gain-processed) is emitted sample for sample; the
+ * block in between waits until the peak of the one after it is known. */
+
+void limiter_la_init(limiter_la_t *l, float32_t sr, float32_t lookahead_ms, float32_t release_ms, float32_t threshold_db)
+{
+    memset(l, 0, sizeof *l);
+    /* half the lookahead per block, in whole vectors */
+    uint32_t block = (uint32_t)(lookahead_ms * sr / 2000.0f) & ~3u;
+    if(block < 4) block = 4;
+    if(block > LIMITER_LA_MAX_BLOCK) block = LIMITER_LA_MAX_BLOCK;
+    l->block = block;
+
+    /* per-sample release coefficient raised to the block length by repeated
+       multiplication, so every platform gets the same value */
+    float32_t rel = expf(-1.0f / (release_ms * sr / 1000.0f));
+    float32_t rb = 1.0f;
+    for(uint32_t i = 0; i < block; ++i) rb *= rel;
+    l->release_block = rb;
+
+    l->threshold = powf(10.0f, threshold_db / 20.0f);
+    l->gain = 1.0f;
+}
+
+static float32_t limiter_la_block_peak(const float32_t *L, const float32_t *R, uint32_t n)
+{
+    v4f m = v4_set1(0.0f);
+    for(uint32_t i = 0; i < n; i += 4)
+        m = v4_max(m, v4_max(v4_abs(v4_load(L + i)), v4_abs(v4_load(R + i))));
+    return v4_hmax(m);
+}
+
+static inline float32_t limiter_la_required(const limiter_la_t *l, float32_t peak)
+{
+    return peak > l->threshold ? l->threshold / peak : 1.0f;
+}
+
+/* Apply the gain ramp to the waiting block once the next block's peak is in */
+static void limiter_la_gain_block(limiter_la_t *l, uint32_t b, uint32_t next)
+{
+    float32_t need = limiter_la_required(l, l->peak[b]);
+    float32_t ahead = limiter_la_required(l, l->peak[next]);
+    float32_t target = need < ahead ? need : ahead;
+
+    float32_t g0 = l->gain;
+    float32_t g1 = target < g0 ? target                               /* attack */
+                               : target + (g0 - target) * l->release_block; /* release */
+    if(g1 > 0.9999f) g1 = 1.0f;           /* settle: -0.001 dB is inaudible */
+    l->gain = g1;
+    if(g0 == 1.0f && g1 == 1.0f) return;   /* untouched block */
+
+    /* linear ramp g0 -> g1 across the block; both ends are <= need */
+    const uint32_t n = l->block;
+    const float32_t step = (g1 - g0) / (float32_t)n;
+    float32_t *L = l->ring[b][0], *R = l->ring[b][1];
+    const v4f vg0 = v4_set1(g0), vstep = v4_set1(step);
+    for(uint32_t i = 0; i < n; i += 4){
+        float k[4] = {(float)(i + 1), (float)(i + 2), (float)(i + 3), (float)(i + 4)};
+        v4f g = v4_add(vg0, v4_mul(vstep, v4_load(k)));
+        v4_store(L + i, v4_mul(v4_load(L + i), g));
+        v4_store(R + i, v4_mul(v4_load(R + i), g));
+    }
+}
+
+void limiter_la_process(limiter_la_t *l, float32_t *L, float32_t *R, uint32_t n)
+{
+    const uint32_t block = l->block;
+    uint32_t done = 0;
+    while(done < n){
+        uint32_t cur = l->cur;
+        uint32_t out = (cur + 1) % 3;   /* two blocks behind: ready to emit */
+        uint32_t len = block - l->fill;
+        if(len > n - done) len = n - done;
+
+        /* swap: emit processed samples, take new input into the filling block */
+        float32_t *in_l = l->ring[cur][0] + l->fill, *in_r = l->ring[cur][1] + l->fill;
+        float32_t *out_l = l->ring[out][0] + l->fill, *out_r = l->ring[out][1] + l->fill;
+        for(uint32_t i = 0; i < len; ++i){
+            float32_t xl = L[done + i], xr = R[done + i];
+            L[done + i] = out_l[i];
+            R[done + i] = out_r[i];
+            in_l[i] = xl;
+            in_r[i] = xr;
+        }
+        l->fill += len;
+        done += len;
+
+        if(l->fill == block){
+            uint32_t wait = (cur + 2) % 3;
+            l->peak[cur] = limiter_la_block_peak(l->ring[cur][0], l->ring[cur][1], block);
+            limiter_la_gain_block(l, wait, cur);
+            l->cur = out;               /* emitted block's storage is reused */
+            l->fill = 0;
+        }
+    }
+}
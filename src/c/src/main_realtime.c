@@ -1,169 +1,319 @@
 #include "coreaudio.h"
-#include "generator.h"
+#include "rt_engine.h"
 #include "video.h"
 #include "raster.h"
 #include "terrain.h"
 #include "particles.h"
 #include "shapes.h"
 #include "crt_fx.h"
+#include "rt_frame.h"
+#include "rt_sync.h"
+#include "prof.h"
+#include "seed.h"
+#include "cpu_dispatch.h"
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h> // for sleep
-#include <stdlib.h> // for strtoull
+#include <stdlib.h>
 #include <stdbool.h>
 #include <math.h>
 
-static generator_t g_generator;
-static volatile int callback_count = 0;
+/* Generator, block buffers and event ring: the audio callback allocates nothing */
+static rt_engine_t g_engine;
 
-// Static buffers to avoid VLA stack overflow in real-time callback
-static float L_buffer[1024], R_buffer[1024];
+/* Visual state the frame callback carries from frame to frame */
+typedef struct {
+    crt_fx_t crt_fx;
+    float angle;
+    int frame;
+    float level;          /* RMS of the block heard as the frame shows, 0..1 */
+    uint16_t step;
+    bool saw_hit, bass_hit;   /* heard, not yet spawned (a held frame spawns nothing) */
+    rt_sync_t sync;       /* audio-clocked ticks and events */
+    rt_dlist_t dl;        /* this frame's draws, replayed per band */
+    rt_bands_t bands;
+} rt_view_t;
 
-void audio_render_callback(float* buffer, uint32_t num_frames, void* user_data)
+/* Particles on saw hits, shapes on bass hits (drawn or dropped frame alike) */
+static void spawn_hits(int vw, int vh, bool saw_hit, bool bass_hit)
 {
-    callback_count++;  // Atomic increment to track calls
-    
-    // Safety check - prevent buffer overflow
-    if(num_frames > 1024) num_frames = 1024;
-    
-    generator_process(&g_generator, L_buffer, R_buffer, num_frames);
-    for(uint32_t i=0; i<num_frames; ++i){
-        buffer[i*2]   = L_buffer[i];
-        buffer[i*2+1] = R_buffer[i];
+    /* spawn particles on saw hits */
+    if(saw_hit){
+        float cx = vw * 0.3f + (rand() % (int)(vw * 0.4f));
+        float cy = vh * 0.2f + (rand() % (int)(vh * 0.3f));
+        /* color with slight hue variation from base */
+        float hue = (float)(rand() % 360) / 360.0f;
+        uint8_t r = (uint8_t)(127 + 127 * cosf(hue * 2 * M_PI));
+        uint8_t g = (uint8_t)(127 + 127 * cosf((hue + 0.33f) * 2 * M_PI));
+        uint8_t b = (uint8_t)(127 + 127 * cosf((hue + 0.66f) * 2 * M_PI));
+        uint32_t color = (r << 24) | (g << 16) | (b << 8) | 0xFF;
+        particles_spawn_burst(cx, cy, 20, color);
+    }
+
+    /* spawn bass shapes on bass hits */
+    if(bass_hit){
+        shape_type_t types[] = {SHAPE_TRIANGLE, SHAPE_DIAMOND, SHAPE_HEXAGON, SHAPE_STAR, SHAPE_SQUARE};
+        shape_type_t type = types[rand() % 5];
+        /* color variation */
+        float hue = (float)(rand() % 360) / 360.0f;
+        uint8_t r = (uint8_t)(200 + 55 * cosf(hue * 2 * M_PI));
+        uint8_t g = (uint8_t)(200 + 55 * cosf((hue + 0.33f) * 2 * M_PI));
+        uint8_t b = (uint8_t)(200 + 55 * cosf((hue + 0.66f) * 2 * M_PI));
+        uint32_t color = (r << 24) | (g << 16) | (b << 8) | 0xFF;
+        shapes_spawn(type, color);
     }
 }
 
+/* One animation tick into the display list: the frame logic (positions,
+ * spawns, particle and shape steps) for v->frame */
+static void record_tick(rt_view_t *v, int vw, int vh)
+{
+    rt_dlist_t *dl = &v->dl;
+    rt_dl_begin(dl, vw, vh);
+
+    /* clear */
+    rt_dl_clear(dl, 0x000000FF); /* black, alpha 255 */
+
+    int radius = 30 + (int)(80.0f * v->level);
+    int cx = vw/2 + (int)(cosf(v->angle)* (vw/4));
+    int cy = vh/2 + (int)(sinf(v->angle)* (vh/4));
+    /* filled circle background */
+    rt_dl_fill_circle(dl, cx, cy, radius, 0x005500FF);
+    /* outlined ring, antialiased edges */
+    rt_dl_ring_aa(dl, cx, cy, radius+10, 0x00FF00FF, 4);
+
+    /* draw scrolling floor */
+    rt_dl_terrain(dl, v->frame, terrain_top(vh));
+
+    /* bass hit shapes (behind floor) */
+    shapes_update(vw, vh, dl);
+
+    spawn_hits(vw, vh, v->saw_hit, v->bass_hit);
+    v->saw_hit = v->bass_hit = false;
+
+    particles_update(vw, vh, dl);
+}
+
+/* One frame into fb (undefined on entry in the zero-copy mode, so it is
+ * cleared first).  video_run calls it on this thread, or with --render-ahead
+ * on the render thread, which is then the only consumer of the event ring.
+ * The scheduler (rt_sync.h) hands over the events heard by the time the
+ * frame will be on screen and the animation ticks it advances: a frame
+ * that has fallen behind the audio steps the ticks in between without
+ * drawing them, one that has run ahead is held (not drawn, the last frame
+ * stays up a frame longer).  A dropped frame (crt_fx frame drops) is decided up front and
+ * not drawn either: it only spawns and advances the clock.  A drawn frame
+ * is recorded into the display list here and drawn band by band on the
+ * --threads pool (rt_frame.h). */
+static bool draw_frame(uint32_t *fb, int vw, int vh, void *user)
+{
+    rt_view_t *v = (rt_view_t *)user;
+    audio_stats_t ast;
+
+    /* What is heard as this frame shows */
+    rt_event_t evs[RT_EVENT_RING];
+    size_t nev;
+    uint64_t shown = audio_clock_ns() + video_frame_lead_ns();
+    int ticks = rt_sync_frame(&v->sync, &g_engine, shown, evs, RT_EVENT_RING, &nev);
+    for(size_t i = 0; i < nev; i++){
+        switch(evs[i].type){
+            case RT_EV_LEVEL: v->level = evs[i].value; break;
+            case RT_EV_SAW:   v->saw_hit = true; break;
+            case RT_EV_BASS:  v->bass_hit = true; break;
+        }
+        v->step = evs[i].step;
+    }
+    if(ticks == 0){
+        /* A frame ahead of the audio: the last one stays up a frame longer */
+        if(v->sync.fps > 0) usleep((useconds_t)(1000000 / v->sync.fps));
+        return false;
+    }
+
+    /* Debug: Show callback count and generator state every 60 frames */
+    if(v->frame % 60 == 0) {
+        audio_get_stats(&ast);
+        printf("Callbacks: %u, Step: %u, Dropped events: %u, Xruns: %llu, A/V: %+.1f ms (%llu dropped, %llu held)\n",
+               __atomic_load_n(&g_engine.callbacks, __ATOMIC_RELAXED), v->step,
+               __atomic_load_n(&g_engine.ring.dropped, __ATOMIC_RELAXED),
+               (unsigned long long)ast.xruns, v->sync.error_ms,
+               (unsigned long long)v->sync.dropped, (unsigned long long)v->sync.held);
+    }
+
+    /* Ticks video fell behind by: stepped, never drawn */
+    for(int t = 1; t < ticks; t++){
+        record_tick(v, vw, vh);
+        v->angle += 0.02f;
+        v->frame++;
+    }
+
+    /* frame drop effect (skip presenting occasionally) */
+    bool show = v->crt_fx.frame_drop_chance < 0.01f || (rand() % 1000) > (int)(v->crt_fx.frame_drop_chance * 1000);
+    if(!show){
+        spawn_hits(vw, vh, v->saw_hit, v->bass_hit);
+        v->saw_hit = v->bass_hit = false;
+        v->angle += 0.02f;
+        v->frame++;
+        return false;
+    }
+
+    record_tick(v, vw, vh);
+
+    /* draw the list band by band, CRT post-processing included; returns
+       once the whole frame is done */
+    rt_bands_render(&v->bands, &v->dl, fb, &v->crt_fx, v->frame);
+
+    /* jitter effect (screen shake): the frame is presented shifted */
+    if(v->crt_fx.jitter_amount > 0.01f && (rand() % 100) < 30){
+        int jx = (int)(-v->crt_fx.jitter_amount + (rand() % (int)(v->crt_fx.jitter_amount * 2)));
+        int jy = (int)(-v->crt_fx.jitter_amount + (rand() % (int)(v->crt_fx.jitter_amount * 2)));
+        video_frame_offset(jx, jy);
+    }
+
+    v->angle += 0.02f;
+
+    v->frame++;
+
+    return true;
+}
+
+/* audio_callback_t: the engine, told when the block will be heard */
+static void player_render(float *out, uint32_t num_frames, void *user)
+{
+    rt_engine_render_at((rt_engine_t *)user, out, num_frames, audio_block_pts());
+}
+
 int main(int argc, char **argv)
 {
-    uint64_t seed = 0xCAFEBABEULL;
-    if(argc > 1) {
-        seed = strtoull(argv[1], NULL, 0);
+    /* realtime [--period FRAMES] [--periods N] [--device NAME] [--profile out.json|out.csv]
+                [--present lock|copy] [--render-ahead] [--kernels ISA] [--size WxH]
+                [--threads N] [seed]
+       Latency is about period * periods frames; --device names the ALSA
+       PCM (e.g. hw:0, pipewire) and is ignored by the other backends.
+       --present copy draws into a software framebuffer and uploads it
+       (default lock: straight into the mapped texture); --render-ahead
+       draws on a thread of its own, a frame ahead of presentation;
+       --kernels caps the run-time kernel pick (cpu_dispatch.h); --size
+       sets the window (800x600 by default, e.g. 1920x1080 or 3840x2160);
+       --threads draws each frame in bands on N threads (default: one per
+       CPU, 1 draws on the frame's own thread) */
+    ndb_seed_t seed;
+    ndb_seed_from_u64(0xCAFEBABEULL, &seed);
+    audio_config_t acfg = AUDIO_CONFIG_DEFAULT;
+    acfg.sample_rate = SR;
+    const char *profile = NULL;
+    video_config_t vcfg = VIDEO_CONFIG_DEFAULT;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--period") == 0 && i + 1 < argc){
+            long p = strtol(argv[++i], NULL, 10);
+            if(p < 32 || p > 8192){
+                fprintf(stderr, "realtime: --period must be 32..8192 frames\n");
+                return 1;
+            }
+            acfg.period_frames = (uint32_t)p;
+        } else if(strcmp(argv[i], "--periods") == 0 && i + 1 < argc){
+            long n = strtol(argv[++i], NULL, 10);
+            if(n < 2 || n > AUDIO_MAX_PERIODS){
+                fprintf(stderr, "realtime: --periods must be 2..%d\n", AUDIO_MAX_PERIODS);
+                return 1;
+            }
+            acfg.periods = (uint32_t)n;
+        } else if(strcmp(argv[i], "--device") == 0 && i + 1 < argc){
+            acfg.device = argv[++i];
+        } else if(strcmp(argv[i], "--profile") == 0 && i + 1 < argc){
+            profile = argv[++i];
+        } else if(strcmp(argv[i], "--present") == 0 && i + 1 < argc){
+            const char *m = argv[++i];
+            if(strcmp(m, "lock") == 0) vcfg.present = VIDEO_PRESENT_LOCK;
+            else if(strcmp(m, "copy") == 0) vcfg.present = VIDEO_PRESENT_COPY;
+            else {
+                fprintf(stderr, "realtime: --present must be lock or copy\n");
+                return 1;
+            }
+        } else if(strcmp(argv[i], "--render-ahead") == 0){
+            vcfg.render_ahead = true;
+        } else if(strcmp(argv[i], "--kernels") == 0 && i + 1 < argc){
+            if(cpu_isa_set(argv[++i]) != 0){
+                fprintf(stderr, "realtime: --kernels %s: unknown, or not supported by this CPU\n", argv[i]);
+                return 1;
+            }
+        } else if(strcmp(argv[i], "--size") == 0 && i + 1 < argc){
+            int sw, sh;
+            if(sscanf(argv[++i], "%dx%d", &sw, &sh) != 2 || sw < 64 || sh < 64 || sw > 8192 || sh > 8192){
+                fprintf(stderr, "realtime: --size must be WxH, 64..8192 each\n");
+                return 1;
+            }
+            vcfg.width = sw;
+            vcfg.height = sh;
+        } else if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            threads = strtol(argv[++i], NULL, 10);
+            if(threads < 1 || threads > RT_BANDS_MAX_THREADS){
+                fprintf(stderr, "realtime: --threads must be 1..%d\n", RT_BANDS_MAX_THREADS);
+                return 1;
+            }
+        } else if(ndb_seed_parse(argv[i], &seed) != 0){
+            fprintf(stderr, "realtime: bad seed '%s'\n", argv[i]);
+            return 1;
+        }
     }
 
-    generator_init(&g_generator, seed);
-    terrain_init(seed);
+    if(rt_engine_init(&g_engine, seed.audio) != 0){
+        fprintf(stderr, "Engine init failed\n");
+        return 1;
+    }
+    /* visuals take the 32-bit seed generate_frames derives from the same value */
+    terrain_init(seed.visual);
     particles_init();
     shapes_init();
 
     /* init CRT effects */
-    crt_fx_t crt_fx;
-    crt_fx_init(&crt_fx, seed, 800, 600);
+    static rt_view_t view;
+    crt_fx_t *fx = &view.crt_fx;
+    crt_fx_init(fx, seed.visual, vcfg.width, vcfg.height);
+    if(threads < 1) threads = 1;
+    if(threads > RT_BANDS_MAX_THREADS) threads = RT_BANDS_MAX_THREADS;
+    if(rt_bands_init(&view.bands, (int)threads, vcfg.width, vcfg.height) != 0){
+        fprintf(stderr, "Band renderer init failed\n");
+        return 1;
+    }
 
-    if(audio_init(SR, 512, audio_render_callback, NULL) != 0){
+    if(audio_open(&acfg, player_render, &g_engine) != 0){
         fprintf(stderr, "Audio init failed\n");
         return 1;
     }
+    /* xruns land in the "audio.xruns" counter next to the voice stages */
+    if(profile) prof_start(profile);
 
-    printf("Playing with seed 0x%llx. Close the window to quit.\n", (unsigned long long)seed);
+    audio_stats_t ast;
+    audio_get_stats(&ast);
+    /* animation ticks at the video rate, on the clock the device grants */
+    rt_sync_init(&view.sync, ast.sample_rate ? ast.sample_rate : acfg.sample_rate, vcfg.fps);
+    printf("Playing with seed 0x%llx. Close the window to quit.\n", (unsigned long long)seed.audio);
+    printf("Audio: %u Hz, %u frames x %u periods (%.1f ms)\n", ast.sample_rate, ast.period_frames,
+           ast.periods, ast.sample_rate ? 1000.0 * ast.period_frames * (ast.periods ? ast.periods : 1) / ast.sample_rate : 0.0);
 
     /* show CRT effect levels */
     printf("CRT FX: persist=%.2f, scan=%d, chroma=%d, noise=%d\n",
-           crt_fx.persistence, crt_fx.scanline_alpha, crt_fx.chroma_shift, crt_fx.noise_pixels);
+           fx->persistence, fx->scanline_alpha, fx->chroma_shift, fx->noise_pixels);
     printf("        jitter=%.1f, drops=%.2f, bleed=%.2f\n",
-           crt_fx.jitter_amount, crt_fx.frame_drop_chance, crt_fx.color_bleed);
+           fx->jitter_amount, fx->frame_drop_chance, fx->color_bleed);
+    printf("Video: %dx%d, %d draw threads, %d bands of %d rows\n", vcfg.width, vcfg.height,
+           view.bands.threads, view.bands.bands, view.bands.band_rows);
 
     /* --- Start audio & video --- */
     audio_start();
-    if(video_init(800, 600, 30, true) != 0){
+    if(video_open(&vcfg) != 0){
         fprintf(stderr, "Video init failed\n");
         return 1;
     }
 
-    bool running = true;
-    uint32_t *fb = video_get_framebuffer();
-    int vw = video_get_width();
-    int vh = video_get_height();
-    float base_hue = 0.0f;
-    float angle=0.0f;
-    int frame=0;
-    while(running){
-        running = video_frame_begin();
-        /* clear */
-        raster_clear(fb, vw, vh, 0x000000FF); /* black, alpha 255 */
-
-        /* orbiting circle driven by RMS */
-        float level = g_block_rms; /* 0..1 */
-        
-        /* Debug: Show callback count and generator state every 60 frames */
-        if(frame % 60 == 0) {
-            printf("Callbacks: %d, Step: %u, Pos: %u\n", callback_count, g_generator.step, g_generator.pos_in_step);
-        }
-        int radius = 30 + (int)(80.0f * level);
-        int cx = vw/2 + (int)(cosf(angle)* (vw/4));
-        int cy = vh/2 + (int)(sinf(angle)* (vh/4));
-        /* filled circle background */
-        raster_fill_circle(fb, vw, vh, cx, cy, radius, 0x005500FF);
-        /* outlined ring */
-        raster_circle(fb, vw, vh, cx, cy, radius+10, 0x00FF00FF, 4);
-
-        /* draw scrolling floor */
-        terrain_draw(fb, vw, vh, frame);
-
-        /* bass hit shapes (behind floor) */
-        shapes_update_and_draw(fb, vw, vh);
-
-        /* spawn particles on saw hits */
-        if(g_generator.saw_hit){
-            float cx = vw * 0.3f + (rand() % (int)(vw * 0.4f));
-            float cy = vh * 0.2f + (rand() % (int)(vh * 0.3f));
-            /* color with slight hue variation from base */
-            float hue = (float)(rand() % 360) / 360.0f;
-            uint8_t r = (uint8_t)(127 + 127 * cosf(hue * 2 * M_PI));
-            uint8_t g = (uint8_t)(127 + 127 * cosf((hue + 0.33f) * 2 * M_PI));
-            uint8_t b = (uint8_t)(127 + 127 * cosf((hue + 0.66f) * 2 * M_PI));
-            uint32_t color = (r << 24) | (g << 16) | (b << 8) | 0xFF;
-            particles_spawn_burst(cx, cy, 20, color);
-        }
-
-        /* spawn bass shapes on bass hits */
-        if(g_generator.bass_hit){
-            shape_type_t types[] = {SHAPE_TRIANGLE, SHAPE_DIAMOND, SHAPE_HEXAGON, SHAPE_STAR, SHAPE_SQUARE};
-            shape_type_t type = types[rand() % 5];
-            /* color variation */
-            float hue = (float)(rand() % 360) / 360.0f;
-            uint8_t r = (uint8_t)(200 + 55 * cosf(hue * 2 * M_PI));
-            uint8_t g = (uint8_t)(200 + 55 * cosf((hue + 0.33f) * 2 * M_PI));
-            uint8_t b = (uint8_t)(200 + 55 * cosf((hue + 0.66f) * 2 * M_PI));
-            uint32_t color = (r << 24) | (g << 16) | (b << 8) | 0xFF;
-            shapes_spawn(type, color);
-        }
-
-        particles_update_and_draw(fb, vw, vh);
-
-        /* apply CRT post-processing effects */
-        crt_fx_apply(&crt_fx, fb, vw, vh, frame);
-
-        /* jitter effect (screen shake) */
-        if(crt_fx.jitter_amount > 0.01f && (rand() % 100) < 30){
-            int jx = (int)(-crt_fx.jitter_amount + (rand() % (int)(crt_fx.jitter_amount * 2)));
-            int jy = (int)(-crt_fx.jitter_amount + (rand() % (int)(crt_fx.jitter_amount * 2)));
-            /* shift framebuffer content */
-            uint32_t *temp = (uint32_t*)malloc(vw * vh * sizeof(uint32_t));
-            memcpy(temp, fb, vw * vh * sizeof(uint32_t));
-            raster_clear(fb, vw, vh, 0x000000FF);
-            for(int y = 0; y < vh; y++){
-                for(int x = 0; x < vw; x++){
-                    int src_x = x - jx;
-                    int src_y = y - jy;
-                    if(src_x >= 0 && src_x < vw && src_y >= 0 && src_y < vh){
-                        fb[y * vw + x] = temp[src_y * vw + src_x];
-                    }
-                }
-            }
-            free(temp);
-        }
-
-        angle += 0.02f;
-
-        /* frame drop effect (skip presenting occasionally) */
-        if(crt_fx.frame_drop_chance < 0.01f || (rand() % 1000) > (int)(crt_fx.frame_drop_chance * 1000)){
-            video_frame_end();
-        }
-
-        frame++;
-    }
+    int rc = video_run(draw_frame, &view) != 0 ? 1 : 0;
 
     video_shutdown();
-    crt_fx_cleanup(&crt_fx);
+    rt_bands_free(&view.bands);
+    crt_fx_cleanup(fx);
     audio_stop();
-    return 0;
+    if(prof_finish() != 0) rc = 1;
+    rt_engine_free(&g_engine);
+    return rc;
 } 
\ No newline at end of file
@@ -1,8 +1,14 @@
 #include "melody.h"
+#include "music_time.h"
 #include <math.h>
-#include <stdio.h>
+#include "trace.h"
+#include "simd4.h"
 
-#define MELODY_MAX_SEC 2.0f
+#ifdef __clang__
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+#endif
 
 void melody_init(melody_t *m, float32_t sr)
 {
@@ -20,9 +26,103 @@ void melody_trigger(melody_t *m, float32_t freq, float32_t dur_sec)
     if(m->len > (uint32_t)(MELODY_MAX_SEC * m->sr))
         m->len = (uint32_t)(MELODY_MAX_SEC * m->sr);
     m->pos = 0;
-#ifndef REALTIME_MODE
-    printf("*** MELODY_TRIGGER: freq=%.2f dur=%.2f len=%u ***\n", freq, dur_sec, m->len);
-#endif
+    TRACE(1, TRACE_MELODY, trace_f32(freq), trace_f32(dur_sec), m->len, 0, 0, 0);
+}
+
+#ifndef MELODY_ASM
+/* Portable port of melody.s: driven saw through the cubic soft clip with a
+   1/(1+5t) envelope.  SOFT_A is 0 there, so the linear term is kept only to
+   mirror its operation order (and signed zeros). */
+#define MELODY_TAU        6.2831853071795864769f
+#define MELODY_DECAY_RATE 5.0f
+#define MELODY_AMP        0.07f
+#define MELODY_DRIVE      1.2f
+#define MELODY_SOFT_A     0.0f
+#define MELODY_SOFT_B     0.5f
+
+void melody_process(melody_t *m, float32_t *L, float32_t *R, uint32_t n)
+{
+    uint32_t pos = m->pos;
+    if(pos >= m->len || n == 0) return;
+
+    const float32_t sr = m->sr;
+    const float32_t inc = (MELODY_TAU * m->freq) / sr;
+    float32_t phase = m->osc.phase;
+
+    for(uint32_t i = 0; i < n && pos < m->len; ++i, ++pos){
+        float32_t t = (float32_t)pos / sr;
+        float32_t env = 1.0f / (1.0f + MELODY_DECAY_RATE * t);
+        float32_t raw = (phase / MELODY_TAU) * 2.0f - 1.0f;
+        float32_t driven = MELODY_DRIVE * raw;
+        float32_t cube = (driven * driven) * driven;
+        float32_t soft = MELODY_SOFT_A * driven - MELODY_SOFT_B * cube;
+        float32_t sample = (soft * env) * MELODY_AMP;
+        L[i] += sample;
+        R[i] += sample;
+
+        phase += inc;
+        if(phase >= MELODY_TAU) phase -= MELODY_TAU;
+        else if(phase < 0.0f) phase += MELODY_TAU;
+    }
+    m->osc.phase = phase;
+    m->pos = pos;
 }
 
-/* NO melody_process - ASM implementation required */ 
\ No newline at end of file
+/* Four voices in lockstep, one per lane: melody_process's operations in
+   its order, the phase wrap as selects, so every lane matches a solo render */
+void melody_process_x4(melody_t *const m[4], float32_t *const L[4], float32_t *const R[4], const uint32_t n[4])
+{
+    float32_t sr[4], inc[4], ph[4], pos0[4], nf[4];
+    uint32_t max_n = 0;
+    for(int l = 0; l < 4; l++){
+        if(!n[l]){
+            sr[l] = 1.0f; inc[l] = ph[l] = pos0[l] = nf[l] = 0.0f;  /* idle lane */
+            continue;
+        }
+        sr[l] = m[l]->sr;
+        inc[l] = (MELODY_TAU * m[l]->freq) / m[l]->sr;
+        ph[l] = m[l]->osc.phase;
+        pos0[l] = (float32_t)m[l]->pos;
+        nf[l] = (float32_t)n[l];
+        if(n[l] > max_n) max_n = n[l];
+    }
+    const v4f vsr = v4_load(sr), vinc = v4_load(inc), vn = v4_load(nf);
+    const v4f one = v4_set1(1.0f), tau = v4_set1(MELODY_TAU), zero = v4_set1(0.0f);
+    v4f phase = v4_load(ph), pos = v4_load(pos0), k = zero;
+
+    for(uint32_t i = 0; i < max_n; ++i){
+        v4f t = v4_div(pos, vsr);
+        v4f env = v4_div(one, v4_add(one, v4_mul(v4_set1(MELODY_DECAY_RATE), t)));
+        v4f raw = v4_sub(v4_mul(v4_div(phase, tau), v4_set1(2.0f)), one);
+        v4f driven = v4_mul(v4_set1(MELODY_DRIVE), raw);
+        v4f cube = v4_mul(v4_mul(driven, driven), driven);
+        v4f soft = v4_sub(v4_mul(v4_set1(MELODY_SOFT_A), driven), v4_mul(v4_set1(MELODY_SOFT_B), cube));
+        v4f sample = v4_mul(v4_mul(soft, env), v4_set1(MELODY_AMP));
+
+        float32_t out[4];
+        v4_store(out, sample);
+        for(int l = 0; l < 4; l++){
+            if(i < n[l]){
+                L[l][i] += out[l];
+                R[l][i] += out[l];
+            }
+        }
+
+        v4f next = v4_add(phase, vinc);
+        /* >= tau wraps down, else < 0 wraps up */
+        next = v4_select(v4_lt(next, tau),
+                         v4_select(v4_lt(next, zero), v4_add(next, tau), next),
+                         v4_sub(next, tau));
+        phase = v4_select(v4_lt(k, vn), next, phase);
+        pos = v4_add(pos, one);
+        k = v4_add(k, one);
+    }
+
+    v4_store(ph, phase);
+    for(int l = 0; l < 4; l++){
+        if(!n[l]) continue;
+        m[l]->osc.phase = ph[l];
+        m[l]->pos += n[l];
+    }
+}
+#endif /* MELODY_ASM – otherwise src/asm/active/melody.s */ 
\ No newline at end of file
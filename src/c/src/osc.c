@@ -1,17 +1,48 @@
 #include "osc.h"
-#include <math.h>
+#include "simd4.h"
+
+#ifdef __clang__
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+#endif
 
 #define TAU 6.28318530717958647692f
 
+/* The phase accumulator stays serial (one add + wrap per sample, exactly as
+   the scalar loop had it) and fills four lanes at a time; the waveform maths
+   then runs on simd4 vectors.  Tails are padded so every sample goes through
+   the same vector code, which keeps NEON, SSE2 and plain C bit-identical. */
+static inline v4f osc_phase4(float32_t *ph, float32_t inc, uint32_t lanes)
+{
+    float lane[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float32_t p = *ph;
+    for (uint32_t k = 0; k < lanes; ++k) {
+        lane[k] = p;
+        p += inc;
+        if (p >= TAU) p -= TAU;
+    }
+    *ph = p;
+    return v4_load(lane);
+}
+
+static inline void osc_store4(float32_t *out, v4f v, uint32_t lanes)
+{
+    if (lanes == 4) { v4_store(out, v); return; }
+    float lane[4];
+    v4_store(lane, v);
+    for (uint32_t k = 0; k < lanes; ++k) out[k] = lane[k];
+}
+
 #ifndef OSC_SINE_ASM
 void osc_sine_block(osc_t *o, float32_t *out, uint32_t n, float32_t freq, float32_t sr)
 {
     const float32_t phase_inc = TAU * freq / sr;
     float32_t ph = o->phase;
-    for (uint32_t i = 0; i < n; ++i) {
-        out[i] = sinf(ph);
-        ph += phase_inc;
-        if (ph >= TAU) ph -= TAU;
+    for (uint32_t i = 0; i < n; i += 4) {
+        uint32_t lanes = n - i < 4 ? n - i : 4;
+        v4f p = osc_phase4(&ph, phase_inc, lanes);
+        osc_store4(out + i, v4_sin(p), lanes);
     }
     o->phase = ph;
 }
@@ -21,12 +52,12 @@ void osc_sine_block(osc_t *o, float32_t *out, uint32_t n, float32_t freq, float3
 void osc_saw_block(osc_t *o, float32_t *out, uint32_t n, float32_t freq, float32_t sr)
 {
     const float32_t phase_inc = TAU * freq / sr;
+    const v4f tau = v4_set1(TAU), two = v4_set1(2.0f), one = v4_set1(1.0f);
     float32_t ph = o->phase;
-    for (uint32_t i = 0; i < n; ++i) {
-        float32_t frac = ph / TAU; // 0..1
-        out[i] = 2.0f * frac - 1.0f; // -1..1
-        ph += phase_inc;
-        if (ph >= TAU) ph -= TAU;
+    for (uint32_t i = 0; i < n; i += 4) {
+        uint32_t lanes = n - i < 4 ? n - i : 4;
+        v4f frac = v4_div(osc_phase4(&ph, phase_inc, lanes), tau); // 0..1
+        osc_store4(out + i, v4_sub(v4_mul(two, frac), one), lanes); // -1..1
     }
     o->phase = ph;
 }
@@ -34,11 +65,12 @@ void osc_saw_block(osc_t *o, float32_t *out, uint32_t n, float32_t freq, float32
 void osc_square_block(osc_t *o, float32_t *out, uint32_t n, float32_t freq, float32_t sr)
 {
     const float32_t phase_inc = TAU * freq / sr;
+    const v4f half = v4_set1(TAU * 0.5f), one = v4_set1(1.0f), neg = v4_set1(-1.0f);
     float32_t ph = o->phase;
-    for (uint32_t i = 0; i < n; ++i) {
-        out[i] = (ph < TAU * 0.5f) ? 1.0f : -1.0f;
-        ph += phase_inc;
-        if (ph >= TAU) ph -= TAU;
+    for (uint32_t i = 0; i < n; i += 4) {
+        uint32_t lanes = n - i < 4 ? n - i : 4;
+        v4f p = osc_phase4(&ph, phase_inc, lanes);
+        osc_store4(out + i, v4_select(v4_lt(p, half), one, neg), lanes);
     }
     o->phase = ph;
 }
@@ -46,14 +78,14 @@ void osc_square_block(osc_t *o, float32_t *out, uint32_t n, float32_t freq, floa
 void osc_triangle_block(osc_t *o, float32_t *out, uint32_t n, float32_t freq, float32_t sr)
 {
     const float32_t phase_inc = TAU * freq / sr;
+    const v4f tau = v4_set1(TAU), two = v4_set1(2.0f), one = v4_set1(1.0f);
     float32_t ph = o->phase;
-    for (uint32_t i = 0; i < n; ++i) {
-        float32_t frac = ph / TAU; // 0..1
-        float32_t val = 2.0f * fabsf(2.0f * frac - 1.0f) - 1.0f; // triangle -1..1
-        out[i] = val;
-        ph += phase_inc;
-        if (ph >= TAU) ph -= TAU;
+    for (uint32_t i = 0; i < n; i += 4) {
+        uint32_t lanes = n - i < 4 ? n - i : 4;
+        v4f frac = v4_div(osc_phase4(&ph, phase_inc, lanes), tau); // 0..1
+        v4f val = v4_sub(v4_mul(two, v4_abs(v4_sub(v4_mul(two, frac), one))), one); // triangle -1..1
+        osc_store4(out + i, val, lanes);
     }
     o->phase = ph;
 }
-#endif 
\ No newline at end of file
+#endif
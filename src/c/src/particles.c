@@ -1,5 +1,5 @@
 #include "particles.h"
-#include "raster.h"
+#include "simd4.h"
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
@@ -58,7 +58,8 @@ static const uint8_t FONT_5X7[][7] = {
 
 static const char GLYPH_SET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*+-=?";
 
-static void draw_glyph(uint32_t *fb,int w,int h,int x,int y,uint8_t glyph_idx,uint32_t color)
+/* Glyph clipped to columns [0, w) and rows [y0, y1) */
+static void draw_glyph(uint32_t *fb,int w,int y0,int y1,int x,int y,uint8_t glyph_idx,uint32_t color)
 {
     if(glyph_idx >= sizeof(FONT_5X7)/sizeof(FONT_5X7[0])) return;
     const uint8_t *bitmap = FONT_5X7[glyph_idx];
@@ -68,7 +69,7 @@ static void draw_glyph(uint32_t *fb,int w,int h,int x,int y,uint8_t glyph_idx,ui
             if(bits & (1<<(4-col))){
                 int px = x + col;
                 int py = y + row;
-                if((unsigned)px < (unsigned)w && (unsigned)py < (unsigned)h){
+                if((unsigned)px < (unsigned)w && py >= y0 && py < y1){
                     fb[py*w + px] = color;
                 }
             }
@@ -76,57 +77,121 @@ static void draw_glyph(uint32_t *fb,int w,int h,int x,int y,uint8_t glyph_idx,ui
     }
 }
 
-static particle_t g_particles[MAX_PARTICLES];
-static int g_count=0;
+/* Glyph whose 5x7 box is known to be inside the frame; `dst` is its top-left */
+static void draw_glyph_unclipped(uint32_t *dst,int w,uint8_t glyph_idx,uint32_t color)
+{
+    if(glyph_idx >= sizeof(FONT_5X7)/sizeof(FONT_5X7[0])) return;
+    const uint8_t *bitmap = FONT_5X7[glyph_idx];
+    for(int row=0;row<7;row++, dst += w){
+        uint8_t bits = bitmap[row];
+        if(bits & 0x10) dst[0] = color;
+        if(bits & 0x08) dst[1] = color;
+        if(bits & 0x04) dst[2] = color;
+        if(bits & 0x02) dst[3] = color;
+        if(bits & 0x01) dst[4] = color;
+    }
+}
+
+static particles_t g_particles;
+_Static_assert(RT_DL_MAX_GLYPHS >= MAX_PARTICLES, "every live particle fits one glyph run");
 
-void particles_init(void){ g_count=0; }
+void particles_init(void){ g_particles.count=0; }
 
 void particles_spawn_burst(float x,float y,int count,uint32_t color)
 {
+    particles_t *ps = &g_particles;
     if(count<1) return;
     if(count>MAX_PARTICLES) count = MAX_PARTICLES;
     float angle_step = 2.0f * (float)M_PI / (float)count;
     for(int i=0;i<count;i++){
-        if(g_count>=MAX_PARTICLES) break;
+        if(ps->count>=MAX_PARTICLES) break;
         float ang = i * angle_step;
-        particle_t *p = &g_particles[g_count++];
-        p->x = x; p->y=y;
+        int n = ps->count++;
+        ps->x[n] = x; ps->y[n] = y;
         float speed = 2.0f + (rand()%100)/50.0f; /* 2–4 */
-        p->vx = cosf(ang)*speed;
-        p->vy = sinf(ang)*speed;
-        p->life = 30 + (rand()%2)*30 + (rand()%2)*30; /* 30,60,90 */
-        p->max_life = p->life;
-        p->color = color;
-        p->glyph = (uint8_t)(rand() % strlen(GLYPH_SET));
+        ps->vx[n] = cosf(ang)*speed;
+        ps->vy[n] = sinf(ang)*speed;
+        ps->life[n] = 30 + (rand()%2)*30 + (rand()%2)*30; /* 30,60,90 */
+        ps->max_life[n] = ps->life[n];
+        ps->color[n] = color;
+        ps->glyph[n] = (uint8_t)(rand() % strlen(GLYPH_SET));
     }
 }
 
-void particles_update_and_draw(uint32_t *fb,int w,int h)
+/* Move every particle one frame: position by velocity, then gravity */
+static void particles_integrate(particles_t *ps)
 {
-    for(int i=0;i<g_count;){
-        particle_t *p = &g_particles[i];
-        /* update */
-        p->x += p->vx;
-        p->y += p->vy;
-        p->vy += 0.1f; /* gravity */
-        p->life--;
-        if(p->life<=0 || p->x<0 || p->x>=w || p->y>=h){
-            /* remove by swap with last */
-            g_particles[i] = g_particles[--g_count];
-            continue;
+    const v4f gravity = v4_set1(0.1f);
+    int n = ps->count, i = 0;
+    for(; i + 4 <= n; i += 4){
+        v4f vy = v4_load(ps->vy + i);
+        v4_store(ps->x + i, v4_add(v4_load(ps->x + i), v4_load(ps->vx + i)));
+        v4_store(ps->y + i, v4_add(v4_load(ps->y + i), vy));
+        v4_store(ps->vy + i, v4_add(vy, gravity));
+    }
+    for(; i < n; i++){
+        ps->x[i] += ps->vx[i];
+        ps->y[i] += ps->vy[i];
+        ps->vy[i] += 0.1f;
+    }
+}
+
+/* Age every particle and pack the survivors to the front, in order */
+static void particles_compact(particles_t *ps, int w, int h)
+{
+    int n = ps->count, live = 0;
+    for(int i=0;i<n;i++){
+        int life = ps->life[i] - 1;
+        float x = ps->x[i], y = ps->y[i];
+        if(life<=0 || x<0 || x>=w || y>=h) continue;
+        ps->x[live] = x; ps->y[live] = y;
+        ps->vx[live] = ps->vx[i]; ps->vy[live] = ps->vy[i];
+        ps->life[live] = life;
+        ps->max_life[live] = ps->max_life[i];
+        ps->color[live] = ps->color[i];
+        ps->glyph[live] = ps->glyph[i];
+        live++;
+    }
+    ps->count = live;
+}
+
+/* Color scaled by life/max_life per channel, alpha kept opaque */
+static inline uint32_t fade_color(uint32_t color, int life, int max_life)
+{
+    uint32_t r = ((color >> 24) & 0xFF) * (uint32_t)life / (uint32_t)max_life;
+    uint32_t g = ((color >> 16) & 0xFF) * (uint32_t)life / (uint32_t)max_life;
+    uint32_t b = ((color >> 8) & 0xFF) * (uint32_t)life / (uint32_t)max_life;
+    return (r<<24)|(g<<16)|(b<<8)|0xFF;
+}
+
+void particles_update(int w,int h,rt_dlist_t *dl)
+{
+    particles_t *ps = &g_particles;
+    particles_integrate(ps);
+    particles_compact(ps, w, h);
+
+    int room;
+    rt_glyph_t *run = rt_dl_glyphs_begin(dl, &room);
+    int n = ps->count < room ? ps->count : room;
+    for(int i=0;i<n;i++){
+        run[i].x = (int16_t)((int)ps->x[i] - 2);
+        run[i].y = (int16_t)((int)ps->y[i] - 3);
+        run[i].glyph = ps->glyph[i];
+        run[i].color = fade_color(ps->color[i], ps->life[i], ps->max_life[i]);
+    }
+    rt_dl_glyphs_end(dl, n);
+}
+
+void particles_draw_glyphs(uint32_t *fb,int w,int y0,int y1,const rt_glyph_t *g,int n)
+{
+    /* glyphs fully inside the rows skip the per-pixel clip */
+    for(int i=0;i<n;i++){
+        int x = g[i].x, y = g[i].y;
+        if(y + 7 <= y0 || y >= y1) continue;
+        if(x >= 0 && y >= y0 && x + 5 <= w && y + 7 <= y1){
+            draw_glyph_unclipped(fb + y*w + x, w, g[i].glyph, g[i].color);
+        } else {
+            draw_glyph(fb,w,y0,y1,x,y,g[i].glyph,g[i].color);
         }
-        /* fade alpha based on life */
-        float alpha = (float)p->life / (float)p->max_life;
-        uint32_t r = (p->color >> 24) & 0xFF;
-        uint32_t g = (p->color >> 16) & 0xFF;
-        uint32_t b = (p->color >> 8) & 0xFF;
-        r = (uint32_t)(r * alpha);
-        g = (uint32_t)(g * alpha);
-        b = (uint32_t)(b * alpha);
-        uint32_t faded_color = (r<<24)|(g<<16)|(b<<8)|0xFF;
-        
-        /* draw glyph */
-        draw_glyph(fb,w,h,(int)p->x-2,(int)p->y-3,p->glyph,faded_color);
-        ++i;
     }
-} 
\ No newline at end of file
+}
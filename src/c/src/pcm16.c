@@ -0,0 +1,876 @@
+#include "simd4.h"
+#include "pcm16.h"
+#include "cpu_dispatch.h"
+#include <stddef.h>
+
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+/*
+ * Every kernel is a table by cpu_isa_t: the scalar loop, the build's SIMD
+ * path (NEON or SSE2), and for the element-wise ones an AVX2 or SVE variant
+ * built for that target and picked at run time.  The sums keep their
+ * four-lane order, which a wider register can't add in, so they stop at
+ * SSE2 / NEON.
+ */
+#if SIMD4_NEON
+#define PCM16_SIMD CPU_ISA_NEON
+#ifdef CPU_SVE_KERNELS
+#define PCM16_SVE 1
+#include <arm_sve.h>
+#define PCM16_TARGET_SVE CPU_TARGET_SVE
+#endif
+#elif SIMD4_SSE2
+#define PCM16_SIMD CPU_ISA_SSE2
+#define PCM16_AVX2 1
+#include <immintrin.h>
+#define PCM16_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#ifdef PCM16_SIMD
+#define PCM16_SUM_ISAS  (CPU_ISA_BIT(CPU_ISA_SCALAR) | CPU_ISA_BIT(PCM16_SIMD))
+#else
+#define PCM16_SUM_ISAS  CPU_ISA_BIT(CPU_ISA_SCALAR)
+#endif
+#if defined(PCM16_AVX2)
+#define PCM16_CONV_ISAS (PCM16_SUM_ISAS | CPU_ISA_BIT(CPU_ISA_AVX2))
+#elif defined(PCM16_SVE)
+#define PCM16_CONV_ISAS (PCM16_SUM_ISAS | CPU_ISA_BIT(CPU_ISA_SVE))
+#else
+#define PCM16_CONV_ISAS PCM16_SUM_ISAS
+#endif
+
+static cpu_isa_t pcm16_conv_isa(void)
+{
+    static int isa = -1;
+    return cpu_isa_resolve(&isa, PCM16_CONV_ISAS);
+}
+
+static cpu_isa_t pcm16_sum_isa(void)
+{
+    static int isa = -1;
+    return cpu_isa_resolve(&isa, PCM16_SUM_ISAS);
+}
+
+#define PCM16_SCALE (1.0f / 32768.0f)   /* power of two: s * scale == s / 32768 */
+
+static inline int16_t pcm16_sample(float x)
+{
+    if(x > 1.0f) x = 1.0f;
+    if(x < -1.0f) x = -1.0f;
+    return (int16_t)(x * 32767.0f);
+}
+
+/* Lane accumulators reduced in the one order every path uses */
+static inline float pcm_lanes_sum(const float acc[4])
+{
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+/* ---- float -> int16, interleaved ---- */
+
+static void interleave_tail(const float *L, const float *R, int16_t *out, uint32_t i, uint32_t frames)
+{
+    for(; i < frames; ++i){
+        out[2 * i]     = pcm16_sample(L[i]);
+        out[2 * i + 1] = pcm16_sample(R[i]);
+    }
+}
+
+static void interleave_c(const float *L, const float *R, int16_t *out, uint32_t frames)
+{
+    interleave_tail(L, R, out, 0, frames);
+}
+
+#if SIMD4_NEON
+static void interleave_simd(const float *L, const float *R, int16_t *out, uint32_t frames)
+{
+    uint32_t i = 0;
+    const float32x4_t one = vdupq_n_f32(1.0f), neg = vdupq_n_f32(-1.0f), scale = vdupq_n_f32(32767.0f);
+    for(; i + 4 <= frames; i += 4){
+        float32x4_t l = vmulq_f32(vmaxq_f32(vminq_f32(vld1q_f32(L + i), one), neg), scale);
+        float32x4_t r = vmulq_f32(vmaxq_f32(vminq_f32(vld1q_f32(R + i), one), neg), scale);
+        int16x4x2_t lr = { { vqmovn_s32(vcvtq_s32_f32(l)), vqmovn_s32(vcvtq_s32_f32(r)) } };
+        vst2_s16(out + 2 * i, lr);       /* interleaving store */
+    }
+    interleave_tail(L, R, out, i, frames);
+}
+#elif SIMD4_SSE2
+static void interleave_simd(const float *L, const float *R, int16_t *out, uint32_t frames)
+{
+    uint32_t i = 0;
+    const __m128 one = _mm_set1_ps(1.0f), neg = _mm_set1_ps(-1.0f), scale = _mm_set1_ps(32767.0f);
+    for(; i + 8 <= frames; i += 8){
+        __m128 l0 = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(L + i), one), neg), scale);
+        __m128 l1 = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(L + i + 4), one), neg), scale);
+        __m128 r0 = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(R + i), one), neg), scale);
+        __m128 r1 = _mm_mul_ps(_mm_max_ps(_mm_min_ps(_mm_loadu_ps(R + i + 4), one), neg), scale);
+        /* truncate, saturating narrow to int16, then interleave L/R */
+        __m128i l = _mm_packs_epi32(_mm_cvttps_epi32(l0), _mm_cvttps_epi32(l1));
+        __m128i r = _mm_packs_epi32(_mm_cvttps_epi32(r0), _mm_cvttps_epi32(r1));
+        _mm_storeu_si128((__m128i *)(out + 2 * i), _mm_unpacklo_epi16(l, r));
+        _mm_storeu_si128((__m128i *)(out + 2 * i + 8), _mm_unpackhi_epi16(l, r));
+    }
+    interleave_tail(L, R, out, i, frames);
+}
+#endif
+
+#ifdef PCM16_AVX2
+PCM16_TARGET_AVX2
+static inline __m256i avx2_pcm16_lanes(const float *p)
+{
+    const __m256 one = _mm256_set1_ps(1.0f), neg = _mm256_set1_ps(-1.0f), scale = _mm256_set1_ps(32767.0f);
+    return _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_max_ps(_mm256_min_ps(_mm256_loadu_ps(p), one), neg), scale));
+}
+
+/* 16 frames a step: the SSE2 ops, with the in-lane packs put back in order */
+PCM16_TARGET_AVX2
+static void interleave_avx2(const float *L, const float *R, int16_t *out, uint32_t frames)
+{
+    uint32_t i = 0;
+    for(; i + 16 <= frames; i += 16){
+        __m256i l = _mm256_permute4x64_epi64(_mm256_packs_epi32(avx2_pcm16_lanes(L + i), avx2_pcm16_lanes(L + i + 8)),
+                                             _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i r = _mm256_permute4x64_epi64(_mm256_packs_epi32(avx2_pcm16_lanes(R + i), avx2_pcm16_lanes(R + i + 8)),
+                                             _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i lo = _mm256_unpacklo_epi16(l, r), hi = _mm256_unpackhi_epi16(l, r);
+        _mm256_storeu_si256((__m256i *)(out + 2 * i), _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(out + 2 * i + 16), _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleave_tail(L, R, out, i, frames);
+}
+#endif
+
+#ifdef PCM16_SVE
+/* A vector of frames a step, the last one predicated: trn1 of the int32
+   lanes' low halves is the L/R int16 pairs in order */
+PCM16_TARGET_SVE
+static void interleave_sve(const float *L, const float *R, int16_t *out, uint32_t frames)
+{
+    for(uint64_t i = 0; i < frames; i += svcntw()){
+        svbool_t pw = svwhilelt_b32_u64(i, frames);
+        svfloat32_t l = svmul_n_f32_x(pw, svmax_n_f32_x(pw, svmin_n_f32_x(pw, svld1_f32(pw, L + i), 1.0f), -1.0f), 32767.0f);
+        svfloat32_t r = svmul_n_f32_x(pw, svmax_n_f32_x(pw, svmin_n_f32_x(pw, svld1_f32(pw, R + i), 1.0f), -1.0f), 32767.0f);
+        svint16_t lr = svtrn1_s16(svreinterpret_s16_s32(svcvt_s32_f32_x(pw, l)),
+                                  svreinterpret_s16_s32(svcvt_s32_f32_x(pw, r)));
+        svst1_s16(svwhilelt_b16_u64(2 * i, 2 * (uint64_t)frames), out + 2 * i, lr);
+    }
+}
+#endif
+
+static const pcm16_interleave_fn interleave_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = interleave_c,
+#ifdef PCM16_SIMD
+    [PCM16_SIMD] = interleave_simd,
+#endif
+#ifdef PCM16_AVX2
+    [CPU_ISA_AVX2] = interleave_avx2,
+#endif
+#ifdef PCM16_SVE
+    [CPU_ISA_SVE] = interleave_sve,
+#endif
+};
+
+void pcm16_interleave(const float *L, const float *R, int16_t *out, uint32_t frames)
+{
+    interleave_k[pcm16_conv_isa()](L, R, out, frames);
+}
+
+pcm16_interleave_fn pcm16_interleave_variant(cpu_isa_t isa)
+{
+    if((unsigned)isa >= CPU_ISA_COUNT || cpu_isa_best(CPU_ISA_BIT(isa)) != isa) return NULL;
+    return interleave_k[isa];
+}
+
+/* ---- int16 -> float ---- */
+
+#if SIMD4_SSE2
+/* Sign-extend the low/high four int16 lanes to floats */
+static inline __m128 sse2_s16_lo_ps(__m128i s) { return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16)); }
+static inline __m128 sse2_s16_hi_ps(__m128i s) { return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16)); }
+#endif
+#ifdef PCM16_AVX2
+PCM16_TARGET_AVX2
+static inline __m256 avx2_s16_ps(const int16_t *p)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)p)));
+}
+#endif
+
+static void deinterleave_tail(const int16_t *in, float *L, float *R, uint32_t i, uint32_t frames)
+{
+    for(; i < frames; ++i){
+        L[i] = in[2 * i] * PCM16_SCALE;
+        R[i] = in[2 * i + 1] * PCM16_SCALE;
+    }
+}
+
+static void deinterleave_c(const int16_t *in, float *L, float *R, uint32_t frames)
+{
+    deinterleave_tail(in, L, R, 0, frames);
+}
+
+#if SIMD4_NEON
+static void deinterleave_simd(const int16_t *in, float *L, float *R, uint32_t frames)
+{
+    uint32_t i = 0;
+    const float32x4_t k = vdupq_n_f32(PCM16_SCALE);
+    for(; i + 8 <= frames; i += 8){
+        int16x8x2_t s = vld2q_s16(in + 2 * i);   /* de-interleaving load */
+        vst1q_f32(L + i,     vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s.val[0]))), k));
+        vst1q_f32(L + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_high_s16(s.val[0])), k));
+        vst1q_f32(R + i,     vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s.val[1]))), k));
+        vst1q_f32(R + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_high_s16(s.val[1])), k));
+    }
+    deinterleave_tail(in, L, R, i, frames);
+}
+#elif SIMD4_SSE2
+static void deinterleave_simd(const int16_t *in, float *L, float *R, uint32_t frames)
+{
+    uint32_t i = 0;
+    const __m128 k = _mm_set1_ps(PCM16_SCALE);
+    for(; i + 4 <= frames; i += 4){
+        __m128i s = _mm_loadu_si128((const __m128i *)(in + 2 * i));
+        __m128 lr01 = _mm_mul_ps(sse2_s16_lo_ps(s), k);   /* l0 r0 l1 r1 */
+        __m128 lr23 = _mm_mul_ps(sse2_s16_hi_ps(s), k);   /* l2 r2 l3 r3 */
+        _mm_storeu_ps(L + i, _mm_shuffle_ps(lr01, lr23, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(R + i, _mm_shuffle_ps(lr01, lr23, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    deinterleave_tail(in, L, R, i, frames);
+}
+#endif
+
+#ifdef PCM16_AVX2
+PCM16_TARGET_AVX2
+static void deinterleave_avx2(const int16_t *in, float *L, float *R, uint32_t frames)
+{
+    uint32_t i = 0;
+    const __m256 k = _mm256_set1_ps(PCM16_SCALE);
+    for(; i + 8 <= frames; i += 8){
+        __m256 a = _mm256_mul_ps(avx2_s16_ps(in + 2 * i), k);       /* l0 r0 .. l3 r3 */
+        __m256 b = _mm256_mul_ps(avx2_s16_ps(in + 2 * i + 8), k);   /* l4 r4 .. l7 r7 */
+        /* in-lane shuffles give l0 l1 l4 l5 | l2 l3 l6 l7: swap the middle pairs */
+        __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm256_storeu_ps(L + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0))));
+        _mm256_storeu_ps(R + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+    deinterleave_tail(in, L, R, i, frames);
+}
+#endif
+
+#ifdef PCM16_SVE
+/* Each frame read as one int32 lane: L is its sign-extended low half */
+PCM16_TARGET_SVE
+static void deinterleave_sve(const int16_t *in, float *L, float *R, uint32_t frames)
+{
+    for(uint64_t i = 0; i < frames; i += svcntw()){
+        svbool_t pw = svwhilelt_b32_u64(i, frames);
+        svint32_t lr = svreinterpret_s32_s16(svld1_s16(svwhilelt_b16_u64(2 * i, 2 * (uint64_t)frames), in + 2 * i));
+        svfloat32_t l = svcvt_f32_s32_x(pw, svexth_s32_x(pw, lr));
+        svfloat32_t r = svcvt_f32_s32_x(pw, svasr_n_s32_x(pw, lr, 16));
+        svst1_f32(pw, L + i, svmul_n_f32_x(pw, l, PCM16_SCALE));
+        svst1_f32(pw, R + i, svmul_n_f32_x(pw, r, PCM16_SCALE));
+    }
+}
+#endif
+
+static const pcm16_deinterleave_fn deinterleave_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = deinterleave_c,
+#ifdef PCM16_SIMD
+    [PCM16_SIMD] = deinterleave_simd,
+#endif
+#ifdef PCM16_AVX2
+    [CPU_ISA_AVX2] = deinterleave_avx2,
+#endif
+#ifdef PCM16_SVE
+    [CPU_ISA_SVE] = deinterleave_sve,
+#endif
+};
+
+void pcm16_deinterleave(const int16_t *in, float *L, float *R, uint32_t frames)
+{
+    deinterleave_k[pcm16_conv_isa()](in, L, R, frames);
+}
+
+pcm16_deinterleave_fn pcm16_deinterleave_variant(cpu_isa_t isa)
+{
+    if((unsigned)isa >= CPU_ISA_COUNT || cpu_isa_best(CPU_ISA_BIT(isa)) != isa) return NULL;
+    return deinterleave_k[isa];
+}
+
+static void to_float_c(const int16_t *in, float *out, uint32_t n)
+{
+    for(uint32_t i = 0; i < n; ++i)
+        out[i] = in[i] * PCM16_SCALE;
+}
+
+#if SIMD4_NEON
+static void to_float_simd(const int16_t *in, float *out, uint32_t n)
+{
+    uint32_t i = 0;
+    const float32x4_t k = vdupq_n_f32(PCM16_SCALE);
+    for(; i + 8 <= n; i += 8){
+        int16x8_t s = vld1q_s16(in + i);
+        vst1q_f32(out + i,     vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), k));
+        vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_high_s16(s)), k));
+    }
+    to_float_c(in + i, out + i, n - i);
+}
+#elif SIMD4_SSE2
+static void to_float_simd(const int16_t *in, float *out, uint32_t n)
+{
+    uint32_t i = 0;
+    const __m128 k = _mm_set1_ps(PCM16_SCALE);
+    for(; i + 8 <= n; i += 8){
+        __m128i s = _mm_loadu_si128((const __m128i *)(in + i));
+        _mm_storeu_ps(out + i,     _mm_mul_ps(sse2_s16_lo_ps(s), k));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(sse2_s16_hi_ps(s), k));
+    }
+    to_float_c(in + i, out + i, n - i);
+}
+#endif
+
+#ifdef PCM16_AVX2
+PCM16_TARGET_AVX2
+static void to_float_avx2(const int16_t *in, float *out, uint32_t n)
+{
+    uint32_t i = 0;
+    const __m256 k = _mm256_set1_ps(PCM16_SCALE);
+    for(; i + 16 <= n; i += 16){
+        _mm256_storeu_ps(out + i,     _mm256_mul_ps(avx2_s16_ps(in + i), k));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(avx2_s16_ps(in + i + 8), k));
+    }
+    to_float_c(in + i, out + i, n - i);
+}
+#endif
+
+#ifdef PCM16_SVE
+PCM16_TARGET_SVE
+static void to_float_sve(const int16_t *in, float *out, uint32_t n)
+{
+    for(uint64_t i = 0; i < n; i += svcntw()){
+        svbool_t pw = svwhilelt_b32_u64(i, n);
+        svfloat32_t x = svcvt_f32_s32_x(pw, svld1sh_s32(pw, in + i));   /* sign-extending load */
+        svst1_f32(pw, out + i, svmul_n_f32_x(pw, x, PCM16_SCALE));
+    }
+}
+#endif
+
+typedef void (*pcm16_to_float_fn)(const int16_t *, float *, uint32_t);
+static const pcm16_to_float_fn to_float_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = to_float_c,
+#ifdef PCM16_SIMD
+    [PCM16_SIMD] = to_float_simd,
+#endif
+#ifdef PCM16_AVX2
+    [CPU_ISA_AVX2] = to_float_avx2,
+#endif
+#ifdef PCM16_SVE
+    [CPU_ISA_SVE] = to_float_sve,
+#endif
+};
+
+void pcm16_to_float(const int16_t *in, float *out, uint32_t n)
+{
+    to_float_k[pcm16_conv_isa()](in, out, n);
+}
+
+/* ---- sums of squares: lane i % 4, on every path ---- */
+
+static float sumsq_c(const int16_t *in, uint32_t n)
+{
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    uint32_t i = 0;
+    for(; i + 8 <= n; i += 8){
+        for(int l = 0; l < 8; l++){
+            float x = in[i + l] * PCM16_SCALE;
+            acc[l & 3] += x * x;
+        }
+    }
+    float sum = pcm_lanes_sum(acc);
+    for(; i < n; ++i){
+        float x = in[i] * PCM16_SCALE;
+        sum += x * x;
+    }
+    return sum;
+}
+
+#ifdef PCM16_SIMD
+static float sumsq_simd(const int16_t *in, uint32_t n)
+{
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    uint32_t i = 0;
+#if SIMD4_NEON
+    const float32x4_t k = vdupq_n_f32(PCM16_SCALE);
+    float32x4_t a = vdupq_n_f32(0.0f);
+    for(; i + 8 <= n; i += 8){
+        int16x8_t s = vld1q_s16(in + i);
+        float32x4_t lo = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), k);
+        float32x4_t hi = vmulq_f32(vcvtq_f32_s32(vmovl_high_s16(s)), k);
+        a = vaddq_f32(a, vmulq_f32(lo, lo));
+        a = vaddq_f32(a, vmulq_f32(hi, hi));
+    }
+    vst1q_f32(acc, a);
+#else
+    const __m128 k = _mm_set1_ps(PCM16_SCALE);
+    __m128 a = _mm_setzero_ps();
+    for(; i + 8 <= n; i += 8){
+        __m128i s = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128 lo = _mm_mul_ps(sse2_s16_lo_ps(s), k);
+        __m128 hi = _mm_mul_ps(sse2_s16_hi_ps(s), k);
+        a = _mm_add_ps(a, _mm_mul_ps(lo, lo));
+        a = _mm_add_ps(a, _mm_mul_ps(hi, hi));
+    }
+    _mm_storeu_ps(acc, a);
+#endif
+    float sum = pcm_lanes_sum(acc);
+    for(; i < n; ++i){
+        float x = in[i] * PCM16_SCALE;
+        sum += x * x;
+    }
+    return sum;
+}
+#endif
+
+typedef float (*pcm16_sumsq_fn)(const int16_t *, uint32_t);
+static const pcm16_sumsq_fn sumsq_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = sumsq_c,
+#ifdef PCM16_SIMD
+    [PCM16_SIMD] = sumsq_simd,
+#endif
+};
+
+float pcm16_sumsq(const int16_t *in, uint32_t n)
+{
+    return sumsq_k[pcm16_sum_isa()](in, n);
+}
+
+static float mono_sumsq_tail(const int16_t *in, const float acc[4], uint32_t i, uint32_t frames)
+{
+    float sum = pcm_lanes_sum(acc);
+    for(; i < frames; ++i){
+        float m = (in[2 * i] * PCM16_SCALE + in[2 * i + 1] * PCM16_SCALE) * 0.5f;
+        sum += m * m;
+    }
+    return sum;
+}
+
+static float mono_sumsq_c(const int16_t *in, uint32_t frames)
+{
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    uint32_t i = 0;
+    for(; i + 4 <= frames; i += 4){
+        for(int l = 0; l < 4; l++){
+            float m = (in[2 * (i + l)] * PCM16_SCALE + in[2 * (i + l) + 1] * PCM16_SCALE) * 0.5f;
+            acc[l] += m * m;
+        }
+    }
+    return mono_sumsq_tail(in, acc, i, frames);
+}
+
+#ifdef PCM16_SIMD
+static float mono_sumsq_simd(const int16_t *in, uint32_t frames)
+{
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    uint32_t i = 0;
+#if SIMD4_NEON
+    const float32x4_t k = vdupq_n_f32(PCM16_SCALE), half = vdupq_n_f32(0.5f);
+    float32x4_t a = vdupq_n_f32(0.0f);
+    for(; i + 4 <= frames; i += 4){
+        int16x4x2_t s = vld2_s16(in + 2 * i);
+        float32x4_t l = vmulq_f32(vcvtq_f32_s32(vmovl_s16(s.val[0])), k);
+        float32x4_t r = vmulq_f32(vcvtq_f32_s32(vmovl_s16(s.val[1])), k);
+        float32x4_t m = vmulq_f32(vaddq_f32(l, r), half);
+        a = vaddq_f32(a, vmulq_f32(m, m));
+    }
+    vst1q_f32(acc, a);
+#else
+    const __m128 k = _mm_set1_ps(PCM16_SCALE), half = _mm_set1_ps(0.5f);
+    __m128 a = _mm_setzero_ps();
+    for(; i + 4 <= frames; i += 4){
+        __m128i s = _mm_loadu_si128((const __m128i *)(in + 2 * i));
+        __m128 lr01 = _mm_mul_ps(sse2_s16_lo_ps(s), k);
+        __m128 lr23 = _mm_mul_ps(sse2_s16_hi_ps(s), k);
+        __m128 l = _mm_shuffle_ps(lr01, lr23, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 r = _mm_shuffle_ps(lr01, lr23, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 m = _mm_mul_ps(_mm_add_ps(l, r), half);
+        a = _mm_add_ps(a, _mm_mul_ps(m, m));
+    }
+    _mm_storeu_ps(acc, a);
+#endif
+    return mono_sumsq_tail(in, acc, i, frames);
+}
+#endif
+
+typedef float (*pcm16_mono_sumsq_fn)(const int16_t *, uint32_t);
+static const pcm16_mono_sumsq_fn mono_sumsq_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = mono_sumsq_c,
+#ifdef PCM16_SIMD
+    [PCM16_SIMD] = mono_sumsq_simd,
+#endif
+};
+
+float pcm16_mono_sumsq(const int16_t *in, uint32_t frames)
+{
+    return mono_sumsq_k[pcm16_sum_isa()](in, frames);
+}
+
+/* ---- exact integer energies ---- */
+
+static uint64_t mono_energy_tail(const int16_t *in, uint64_t sum, uint32_t i, uint32_t frames)
+{
+    for(; i < frames; ++i){
+        int64_t m = (int64_t)in[2 * i] + in[2 * i + 1];
+        sum += (uint64_t)(m * m);
+    }
+    return sum;
+}
+
+static uint64_t mono_energy_c(const int16_t *in, uint32_t frames)
+{
+    return mono_energy_tail(in, 0, 0, frames);
+}
+
+#if SIMD4_NEON
+static uint64_t mono_energy_simd(const int16_t *in, uint32_t frames)
+{
+    uint32_t i = 0;
+    int64x2_t a = vdupq_n_s64(0);
+    for(; i + 4 <= frames; i += 4){
+        int16x4x2_t s = vld2_s16(in + 2 * i);
+        int32x4_t m = vaddl_s16(s.val[0], s.val[1]);          /* l + r, 17 bits */
+        a = vaddq_s64(a, vaddq_s64(vmull_s32(vget_low_s32(m), vget_low_s32(m)), vmull_high_s32(m, m)));
+    }
+    uint64_t sum = (uint64_t)vgetq_lane_s64(a, 0) + (uint64_t)vgetq_lane_s64(a, 1);
+    return mono_energy_tail(in, sum, i, frames);
+}
+#elif SIMD4_SSE2
+static uint64_t mono_energy_simd(const int16_t *in, uint32_t frames)
+{
+    uint32_t i = 0;
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i a = _mm_setzero_si128();
+    for(; i + 4 <= frames; i += 4){
+        __m128i m = _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(in + 2 * i)), ones);  /* l + r */
+        __m128i sign = _mm_srai_epi32(m, 31);
+        __m128i u = _mm_sub_epi32(_mm_xor_si128(m, sign), sign);    /* |l + r| <= 65536 */
+        a = _mm_add_epi64(a, _mm_mul_epu32(u, u));                 /* lanes 0, 2 */
+        u = _mm_srli_epi64(u, 32);
+        a = _mm_add_epi64(a, _mm_mul_epu32(u, u));                 /* lanes 1, 3 */
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, a);
+    return mono_energy_tail(in, lanes[0] + lanes[1], i, frames);
+}
+#endif
+
+#ifdef PCM16_AVX2
+/* Signed 32x32->64 products (vpmuldq), so no |x| step */
+PCM16_TARGET_AVX2
+static uint64_t mono_energy_avx2(const int16_t *in, uint32_t frames)
+{
+    uint32_t i = 0;
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i a = _mm256_setzero_si256();
+    for(; i + 8 <= frames; i += 8){
+        __m256i m = _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)(in + 2 * i)), ones);
+        a = _mm256_add_epi64(a, _mm256_mul_epi32(m, m));           /* even lanes */
+        m = _mm256_srli_epi64(m, 32);
+        a = _mm256_add_epi64(a, _mm256_mul_epi32(m, m));           /* odd lanes */
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, a);
+    return mono_energy_tail(in, lanes[0] + lanes[1] + lanes[2] + lanes[3], i, frames);
+}
+#endif
+
+#ifdef PCM16_SVE
+/* Past the end the load gives zero frames, which add nothing */
+PCM16_TARGET_SVE
+static uint64_t mono_energy_sve(const int16_t *in, uint32_t frames)
+{
+    const svbool_t all = svptrue_b8();
+    svint64_t a = svdup_n_s64(0);
+    for(uint64_t i = 0; i < frames; i += svcntw()){
+        svint32_t lr = svreinterpret_s32_s16(svld1_s16(svwhilelt_b16_u64(2 * i, 2 * (uint64_t)frames), in + 2 * i));
+        svint32_t m = svadd_s32_x(all, svexth_s32_x(all, lr), svasr_n_s32_x(all, lr, 16));
+        svint64_t lo = svunpklo_s64(m), hi = svunpkhi_s64(m);
+        a = svmla_s64_x(all, svmla_s64_x(all, a, lo, lo), hi, hi);
+    }
+    return (uint64_t)svaddv_s64(all, a);
+}
+#endif
+
+typedef uint64_t (*pcm16_mono_energy_fn)(const int16_t *, uint32_t);
+static const pcm16_mono_energy_fn mono_energy_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = mono_energy_c,
+#ifdef PCM16_SIMD
+    [PCM16_SIMD] = mono_energy_simd,
+#endif
+#ifdef PCM16_AVX2
+    [CPU_ISA_AVX2] = mono_energy_avx2,
+#endif
+#ifdef PCM16_SVE
+    [CPU_ISA_SVE] = mono_energy_sve,
+#endif
+};
+
+uint64_t pcm16_mono_energy(const int16_t *in, uint32_t frames)
+{
+    return mono_energy_k[pcm16_conv_isa()](in, frames);
+}
+
+static inline int32_t pcm16_fold(const int16_t *in, int64_t i)
+{
+    return i < 0 ? 0 : (int32_t)in[2 * i] + in[2 * i + 1];
+}
+
+enum { BAND_TAPS = PCM16_BAND_TAPS, BAND_SHIFT = 7 };   /* TAPS == 1 << SHIFT */
+_Static_assert(PCM16_BAND_TAPS == 1 << 7, "BAND_SHIFT follows PCM16_BAND_TAPS");
+
+/* Frames [n, end) one at a time */
+static void band_energy_run(const int16_t *in, uint32_t n, uint32_t end, int32_t *box, uint64_t *lo, uint64_t *hi)
+{
+    int32_t b = *box;
+    for(; n < end; ++n){
+        b += pcm16_fold(in, n) - pcm16_fold(in, (int64_t)n - BAND_TAPS);
+        int64_t h = ((int64_t)pcm16_fold(in, (int64_t)n - BAND_TAPS / 2) << BAND_SHIFT) - b;
+        *lo += (uint64_t)((int64_t)b * b);
+        *hi += (uint64_t)(h * h);
+    }
+    *box = b;
+}
+
+static void band_energy_c(const int16_t *in, uint32_t start, uint32_t frames, int32_t *box,
+                          uint64_t *low_energy, uint64_t *high_energy)
+{
+    uint64_t lo = 0, hi = 0;
+    band_energy_run(in, start, start + frames, box, &lo, &hi);
+    *low_energy += lo;
+    *high_energy += hi;
+}
+
+#ifdef PCM16_SIMD
+static void band_energy_simd(const int16_t *in, uint32_t start, uint32_t frames, int32_t *box,
+                             uint64_t *low_energy, uint64_t *high_energy)
+{
+    enum { TAPS = BAND_TAPS, SHIFT = BAND_SHIFT };
+    uint32_t n = start, end = start + frames;
+    uint64_t lo = 0, hi = 0;
+
+    /* Until the oldest tap is inside `in`, one frame at a time */
+    uint32_t head = end < TAPS ? end : TAPS;
+    if(n < head){
+        band_energy_run(in, n, head, box, &lo, &hi);
+        n = head;
+    }
+    int32_t b = *box;
+#if SIMD4_NEON
+    /* |low| <= 2^23 and |high| <= 2^24, so the squares fit int64 lanes */
+    int32x4_t carry = vdupq_n_s32(b), zero = vdupq_n_s32(0);
+    int64x2_t alo = vdupq_n_s64(0), ahi = vdupq_n_s64(0);
+    for(; n + 4 <= end; n += 4){
+        int16x4x2_t now = vld2_s16(in + 2 * (size_t)n);
+        int16x4x2_t old = vld2_s16(in + 2 * (size_t)(n - TAPS));
+        int16x4x2_t mid = vld2_s16(in + 2 * (size_t)(n - TAPS / 2));
+        int32x4_t d = vsubq_s32(vaddl_s16(now.val[0], now.val[1]), vaddl_s16(old.val[0], old.val[1]));
+        d = vaddq_s32(d, vextq_s32(zero, d, 3));          /* in-register prefix sum */
+        d = vaddq_s32(d, vextq_s32(zero, d, 2));
+        int32x4_t low = vaddq_s32(d, carry);
+        carry = vdupq_laneq_s32(low, 3);
+        int32x4_t high = vsubq_s32(vshlq_n_s32(vaddl_s16(mid.val[0], mid.val[1]), SHIFT), low);
+        alo = vaddq_s64(alo, vaddq_s64(vmull_s32(vget_low_s32(low), vget_low_s32(low)), vmull_high_s32(low, low)));
+        ahi = vaddq_s64(ahi, vaddq_s64(vmull_s32(vget_low_s32(high), vget_low_s32(high)), vmull_high_s32(high, high)));
+    }
+    b = vgetq_lane_s32(carry, 0);
+    lo += (uint64_t)vgetq_lane_s64(alo, 0) + (uint64_t)vgetq_lane_s64(alo, 1);
+    hi += (uint64_t)vgetq_lane_s64(ahi, 0) + (uint64_t)vgetq_lane_s64(ahi, 1);
+#else
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i carry = _mm_set1_epi32(b);
+    __m128i alo = _mm_setzero_si128(), ahi = _mm_setzero_si128();
+    for(; n + 4 <= end; n += 4){
+        __m128i now = _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(in + 2 * (size_t)n)), ones);
+        __m128i old = _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(in + 2 * (size_t)(n - TAPS))), ones);
+        __m128i mid = _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(in + 2 * (size_t)(n - TAPS / 2))), ones);
+        __m128i d = _mm_sub_epi32(now, old);
+        d = _mm_add_epi32(d, _mm_slli_si128(d, 4));        /* in-register prefix sum */
+        d = _mm_add_epi32(d, _mm_slli_si128(d, 8));
+        __m128i low = _mm_add_epi32(d, carry);
+        carry = _mm_shuffle_epi32(low, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i high = _mm_sub_epi32(_mm_slli_epi32(mid, SHIFT), low);
+        /* squares as |x| * |x| in the unsigned 32x32->64 multiplier */
+        __m128i s = _mm_srai_epi32(low, 31), u = _mm_sub_epi32(_mm_xor_si128(low, s), s);
+        alo = _mm_add_epi64(alo, _mm_add_epi64(_mm_mul_epu32(u, u), _mm_mul_epu32(_mm_srli_epi64(u, 32), _mm_srli_epi64(u, 32))));
+        s = _mm_srai_epi32(high, 31);
+        u = _mm_sub_epi32(_mm_xor_si128(high, s), s);
+        ahi = _mm_add_epi64(ahi, _mm_add_epi64(_mm_mul_epu32(u, u), _mm_mul_epu32(_mm_srli_epi64(u, 32), _mm_srli_epi64(u, 32))));
+    }
+    b = _mm_cvtsi128_si32(carry);
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, alo);
+    lo += lanes[0] + lanes[1];
+    _mm_storeu_si128((__m128i *)lanes, ahi);
+    hi += lanes[0] + lanes[1];
+#endif
+    *box = b;
+    band_energy_run(in, n, end, box, &lo, &hi);
+    *low_energy += lo;
+    *high_energy += hi;
+}
+#endif
+
+typedef void (*pcm16_band_energy_fn)(const int16_t *, uint32_t, uint32_t, int32_t *, uint64_t *, uint64_t *);
+static const pcm16_band_energy_fn band_energy_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = band_energy_c,
+#ifdef PCM16_SIMD
+    [PCM16_SIMD] = band_energy_simd,
+#endif
+};
+
+void pcm16_band_energy(const int16_t *in, uint32_t start, uint32_t frames, int32_t *box,
+                       uint64_t *low_energy, uint64_t *high_energy)
+{
+    band_energy_k[pcm16_sum_isa()](in, start, frames, box, low_energy, high_energy);
+}
+
+/* ---- float planar <-> interleaved ---- */
+
+static void interleave_f32_tail(const float *L, const float *R, float *out, uint32_t i, uint32_t frames)
+{
+    for(; i < frames; ++i){
+        out[2 * i]     = L[i];
+        out[2 * i + 1] = R[i];
+    }
+}
+
+static void interleave_f32_c(const float *L, const float *R, float *out, uint32_t frames)
+{
+    interleave_f32_tail(L, R, out, 0, frames);
+}
+
+#if SIMD4_NEON
+static void interleave_f32_simd(const float *L, const float *R, float *out, uint32_t frames)
+{
+    uint32_t i = 0;
+    for(; i + 4 <= frames; i += 4){
+        float32x4x2_t lr = { { vld1q_f32(L + i), vld1q_f32(R + i) } };
+        vst2q_f32(out + 2 * i, lr);       /* interleaving store */
+    }
+    interleave_f32_tail(L, R, out, i, frames);
+}
+#elif SIMD4_SSE2
+static void interleave_f32_simd(const float *L, const float *R, float *out, uint32_t frames)
+{
+    uint32_t i = 0;
+    for(; i + 4 <= frames; i += 4){
+        __m128 l = _mm_loadu_ps(L + i), r = _mm_loadu_ps(R + i);
+        _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(l, r));
+    }
+    interleave_f32_tail(L, R, out, i, frames);
+}
+#endif
+
+#ifdef PCM16_AVX2
+PCM16_TARGET_AVX2
+static void interleave_f32_avx2(const float *L, const float *R, float *out, uint32_t frames)
+{
+    uint32_t i = 0;
+    for(; i + 8 <= frames; i += 8){
+        __m256 l = _mm256_loadu_ps(L + i), r = _mm256_loadu_ps(R + i);
+        __m256 lo = _mm256_unpacklo_ps(l, r), hi = _mm256_unpackhi_ps(l, r);   /* frames 0-1 4-5, 2-3 6-7 */
+        _mm256_storeu_ps(out + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(out + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    interleave_f32_tail(L, R, out, i, frames);
+}
+#endif
+
+#ifdef PCM16_SVE
+PCM16_TARGET_SVE
+static void interleave_f32_sve(const float *L, const float *R, float *out, uint32_t frames)
+{
+    for(uint64_t i = 0; i < frames; i += svcntw()){
+        svbool_t pw = svwhilelt_b32_u64(i, frames);
+        svst2_f32(pw, out + 2 * i, svcreate2_f32(svld1_f32(pw, L + i), svld1_f32(pw, R + i)));
+    }
+}
+#endif
+
+typedef void (*pcm_interleave_f32_fn)(const float *, const float *, float *, uint32_t);
+static const pcm_interleave_f32_fn interleave_f32_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = interleave_f32_c,
+#ifdef PCM16_SIMD
+    [PCM16_SIMD] = interleave_f32_simd,
+#endif
+#ifdef PCM16_AVX2
+    [CPU_ISA_AVX2] = interleave_f32_avx2,
+#endif
+#ifdef PCM16_SVE
+    [CPU_ISA_SVE] = interleave_f32_sve,
+#endif
+};
+
+void pcm_interleave_f32(const float *L, const float *R, float *out, uint32_t frames)
+{
+    interleave_f32_k[pcm16_conv_isa()](L, R, out, frames);
+}
+
+static float sumsq_f32_tail(const float *in, const float acc[4], uint32_t i, uint32_t n)
+{
+    float sum = pcm_lanes_sum(acc);
+    for(; i < n; ++i)
+        sum += in[i] * in[i];
+    return sum;
+}
+
+static float sumsq_f32_c(const float *in, uint32_t n)
+{
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    uint32_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        for(int l = 0; l < 4; l++)
+            acc[l] += in[i + l] * in[i + l];
+    }
+    return sumsq_f32_tail(in, acc, i, n);
+}
+
+#ifdef PCM16_SIMD
+static float sumsq_f32_simd(const float *in, uint32_t n)
+{
+    float acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    uint32_t i = 0;
+#if SIMD4_NEON
+    float32x4_t a = vdupq_n_f32(0.0f);
+    for(; i + 4 <= n; i += 4){
+        float32x4_t x = vld1q_f32(in + i);
+        a = vaddq_f32(a, vmulq_f32(x, x));
+    }
+    vst1q_f32(acc, a);
+#else
+    __m128 a = _mm_setzero_ps();
+    for(; i + 4 <= n; i += 4){
+        __m128 x = _mm_loadu_ps(in + i);
+        a = _mm_add_ps(a, _mm_mul_ps(x, x));
+    }
+    _mm_storeu_ps(acc, a);
+#endif
+    return sumsq_f32_tail(in, acc, i, n);
+}
+#endif
+
+typedef float (*pcm_sumsq_f32_fn)(const float *, uint32_t);
+static const pcm_sumsq_f32_fn sumsq_f32_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = sumsq_f32_c,
+#ifdef PCM16_SIMD
+    [PCM16_SIMD] = sumsq_f32_simd,
+#endif
+};
+
+float pcm_sumsq_f32(const float *in, uint32_t n)
+{
+    return sumsq_f32_k[pcm16_sum_isa()](in, n);
+}
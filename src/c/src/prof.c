@@ -0,0 +1,354 @@
+#include "prof.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Histogram buckets: values below 8 ticks get a bucket each, larger ones
+ * 8 buckets per power of two (relative width 1/8).  Counters are updated
+ * with relaxed atomics, so any thread may record; trace events go to a
+ * buffer owned by the recording thread.
+ */
+#define PROF_SUB_BITS   3
+#define PROF_SUB        (1 << PROF_SUB_BITS)
+#define PROF_BUCKETS    ((64 - PROF_SUB_BITS + 1) * PROF_SUB)
+#define PROF_NAME_MAX   32
+#define PROF_TRACE_MAX  (1u << 20)      /* events kept per thread */
+#define PROF_THREADS    64
+
+typedef struct {
+    char name[PROF_NAME_MAX];
+    uint64_t count, total, max;
+    uint32_t buckets[PROF_BUCKETS];
+} prof_stage_stats_t;
+
+typedef struct {
+    char name[PROF_NAME_MAX];
+    uint64_t value;
+} prof_counter_stats_t;
+
+typedef struct {
+    uint64_t t0, t1;
+    int stage;
+} prof_event_t;
+
+typedef struct {
+    prof_event_t *events;
+    uint32_t count, cap, dropped;
+    int tid;
+} prof_trace_t;
+
+static prof_stage_stats_t g_stages[PROF_MAX_STAGES];
+static int g_num_stages;
+static prof_counter_stats_t g_counters[PROF_MAX_COUNTERS];
+static int g_num_counters;
+static int g_lock;                     /* spinlock: stage table, thread list */
+static bool g_running;
+static char *g_path;
+static bool g_trace;
+static uint64_t g_tick0, g_ns0;
+static prof_trace_t *g_threads[PROF_THREADS];
+static int g_num_threads;
+static __thread prof_trace_t *t_trace;
+
+static void prof_lock(void)
+{
+    while(__atomic_exchange_n(&g_lock, 1, __ATOMIC_ACQUIRE)) { }
+}
+
+static void prof_unlock(void)
+{
+    __atomic_store_n(&g_lock, 0, __ATOMIC_RELEASE);
+}
+
+static uint64_t prof_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int bucket_of(uint64_t v)
+{
+    if(v < PROF_SUB) return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    int sub = (int)(v >> (e - PROF_SUB_BITS)) & (PROF_SUB - 1);
+    return (e - PROF_SUB_BITS + 1) * PROF_SUB + sub;
+}
+
+/* Midpoint of a bucket, in ticks */
+static double bucket_mid(int b)
+{
+    if(b < PROF_SUB) return b;
+    int e = b / PROF_SUB + PROF_SUB_BITS - 1;
+    double lo = (double)(PROF_SUB + b % PROF_SUB) * (double)(1ull << (e - PROF_SUB_BITS));
+    return lo + (double)(1ull << (e - PROF_SUB_BITS)) * 0.5;
+}
+
+bool prof_start(const char *path)
+{
+    if(g_running) return false;
+    /* keep the names: stage ids cached at call sites stay valid */
+    for(int i = 0; i < g_num_stages; i++){
+        prof_stage_stats_t *s = &g_stages[i];
+        s->count = s->total = s->max = 0;
+        memset(s->buckets, 0, sizeof(s->buckets));
+    }
+    for(int i = 0; i < g_num_counters; i++)
+        g_counters[i].value = 0;
+    free(g_path);
+    g_path = path ? strdup(path) : NULL;
+    size_t len = path ? strlen(path) : 0;
+    g_trace = path && !(len >= 4 && strcmp(path + len - 4, ".csv") == 0);
+    g_ns0 = prof_now_ns();
+    g_tick0 = prof_ticks();
+    __atomic_store_n(&g_running, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool prof_running(void)
+{
+    return __atomic_load_n(&g_running, __ATOMIC_RELAXED);
+}
+
+int prof_stage(const char *name)
+{
+    prof_lock();
+    int id = -1;
+    for(int i = 0; i < g_num_stages; i++){
+        if(strcmp(g_stages[i].name, name) == 0){ id = i; break; }
+    }
+    if(id < 0 && g_num_stages < PROF_MAX_STAGES){
+        id = g_num_stages++;
+        snprintf(g_stages[id].name, PROF_NAME_MAX, "%s", name);
+    }
+    prof_unlock();
+    return id;
+}
+
+int prof_counter(const char *name)
+{
+    prof_lock();
+    int id = -1;
+    for(int i = 0; i < g_num_counters; i++){
+        if(strcmp(g_counters[i].name, name) == 0){ id = i; break; }
+    }
+    if(id < 0 && g_num_counters < PROF_MAX_COUNTERS){
+        id = g_num_counters++;
+        snprintf(g_counters[id].name, PROF_NAME_MAX, "%s", name);
+    }
+    prof_unlock();
+    return id;
+}
+
+void prof_count(int counter, uint64_t n)
+{
+    if(counter < 0 || !__atomic_load_n(&g_running, __ATOMIC_RELAXED)) return;
+    __atomic_fetch_add(&g_counters[counter].value, n, __ATOMIC_RELAXED);
+}
+
+static prof_trace_t *thread_trace(void)
+{
+    if(t_trace) return t_trace;
+    prof_trace_t *t = calloc(1, sizeof(*t));
+    if(!t) return NULL;
+    prof_lock();
+    if(g_num_threads < PROF_THREADS){
+        t->tid = g_num_threads;
+        g_threads[g_num_threads++] = t;
+    } else {
+        free(t);
+        t = NULL;
+    }
+    prof_unlock();
+    t_trace = t;
+    return t;
+}
+
+void prof_record(int stage, uint64_t t0, uint64_t t1)
+{
+    if(stage < 0 || !__atomic_load_n(&g_running, __ATOMIC_RELAXED)) return;
+    prof_stage_stats_t *s = &g_stages[stage];
+    uint64_t d = t1 - t0;
+    __atomic_fetch_add(&s->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s->total, d, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s->buckets[bucket_of(d)], 1, __ATOMIC_RELAXED);
+    uint64_t m = __atomic_load_n(&s->max, __ATOMIC_RELAXED);
+    while(d > m && !__atomic_compare_exchange_n(&s->max, &m, d, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { }
+
+    if(!g_trace) return;
+    prof_trace_t *t = thread_trace();
+    if(!t) return;
+    if(t->count == t->cap){
+        uint32_t cap = t->cap ? t->cap * 2 : 4096;
+        prof_event_t *ev = cap <= PROF_TRACE_MAX ? realloc(t->events, cap * sizeof(*ev)) : NULL;
+        if(!ev){ t->dropped++; return; }
+        t->events = ev;
+        t->cap = cap;
+    }
+    t->events[t->count].t0 = t0;
+    t->events[t->count].t1 = t1;
+    t->events[t->count].stage = stage;
+    t->count++;
+}
+
+/* Value below which `q` of the samples fall, in ticks */
+static double stage_quantile(const prof_stage_stats_t *s, double q)
+{
+    uint64_t want = (uint64_t)(q * (double)s->count + 0.5);
+    if(want < 1) want = 1;
+    uint64_t seen = 0;
+    for(int b = 0; b < PROF_BUCKETS; b++){
+        seen += s->buckets[b];
+        if(seen >= want){
+            double v = bucket_mid(b);
+            return v < (double)s->max ? v : (double)s->max;
+        }
+    }
+    return (double)s->max;
+}
+
+static int write_csv(FILE *f, double us_per_tick)
+{
+    fprintf(f, "stage,count,total_ms,mean_us,p50_us,p99_us,max_us\n");
+    for(int i = 0; i < g_num_stages; i++){
+        const prof_stage_stats_t *s = &g_stages[i];
+        if(!s->count) continue;
+        fprintf(f, "%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n", s->name, (unsigned long long)s->count,
+                s->total * us_per_tick / 1000.0, s->total * us_per_tick / s->count,
+                stage_quantile(s, 0.50) * us_per_tick, stage_quantile(s, 0.99) * us_per_tick,
+                s->max * us_per_tick);
+    }
+    /* counters: the count column alone */
+    for(int i = 0; i < g_num_counters; i++)
+        fprintf(f, "%s,%llu,,,,,\n", g_counters[i].name, (unsigned long long)g_counters[i].value);
+    return ferror(f) ? -1 : 0;
+}
+
+/* Histogram bounds of a snapshot, in microseconds */
+static const double k_snapshot_le_us[] = {
+    10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000
+};
+#define PROF_SNAPSHOT_LE (int)(sizeof(k_snapshot_le_us) / sizeof(k_snapshot_le_us[0]))
+
+int prof_snapshot(const char *path)
+{
+    if(!g_running) return -1;
+    uint64_t ticks = prof_ticks() - g_tick0;
+    uint64_t ns = prof_now_ns() - g_ns0;
+    double us_per_tick = ticks ? (double)ns / (double)ticks / 1000.0 : 0.0;
+
+    char tmp[1024];
+    if(snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+    FILE *f = fopen(tmp, "w");
+    if(!f){
+        perror(tmp);
+        return -1;
+    }
+    fprintf(f, "{\"pid\":%d,\"elapsed_s\":%.3f,\"le_us\":[", (int)getpid(), ns / 1e9);
+    for(int i = 0; i < PROF_SNAPSHOT_LE; i++)
+        fprintf(f, "%s%g", i ? "," : "", k_snapshot_le_us[i]);
+    fprintf(f, "],\n\"stages\":{");
+    /* live counters, read relaxed: a sample in flight may be half counted */
+    bool first = true;
+    for(int i = 0; i < g_num_stages; i++){
+        const prof_stage_stats_t *s = &g_stages[i];
+        uint64_t count = __atomic_load_n(&s->count, __ATOMIC_RELAXED);
+        if(!count) continue;
+        uint64_t total = __atomic_load_n(&s->total, __ATOMIC_RELAXED);
+        fprintf(f, "%s\n\"%s\":{\"count\":%llu,\"sum_us\":%.3f,\"p50_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f,\"le\":[",
+                first ? "" : ",", s->name, (unsigned long long)count, total * us_per_tick,
+                stage_quantile(s, 0.50) * us_per_tick, stage_quantile(s, 0.99) * us_per_tick,
+                __atomic_load_n(&s->max, __ATOMIC_RELAXED) * us_per_tick);
+        uint64_t seen = 0;
+        int b = 0;
+        for(int j = 0; j < PROF_SNAPSHOT_LE; j++){
+            for(; b < PROF_BUCKETS && bucket_mid(b) * us_per_tick <= k_snapshot_le_us[j]; b++)
+                seen += __atomic_load_n(&s->buckets[b], __ATOMIC_RELAXED);
+            fprintf(f, "%s%llu", j ? "," : "", (unsigned long long)seen);
+        }
+        fprintf(f, "]}");
+        first = false;
+    }
+    fprintf(f, "},\n\"counters\":{");
+    for(int i = 0; i < g_num_counters; i++)
+        fprintf(f, "%s\"%s\":%llu", i ? "," : "", g_counters[i].name,
+                (unsigned long long)__atomic_load_n(&g_counters[i].value, __ATOMIC_RELAXED));
+    fprintf(f, "}}\n");
+    int rc = ferror(f) ? -1 : 0;
+    if(fclose(f) != 0) rc = -1;
+    if(rc == 0 && rename(tmp, path) != 0) rc = -1;
+    if(rc != 0) unlink(tmp);
+    return rc;
+}
+
+static int write_trace(FILE *f, double us_per_tick, uint64_t end_ticks)
+{
+    int pid = (int)getpid();
+    bool first = true;
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for(int t = 0; t < g_num_threads; t++){
+        const prof_trace_t *tr = g_threads[t];
+        for(uint32_t e = 0; e < tr->count; e++){
+            const prof_event_t *ev = &tr->events[e];
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    first ? "" : ",\n", g_stages[ev->stage].name, pid, tr->tid,
+                    (double)(int64_t)(ev->t0 - g_tick0) * us_per_tick, (double)(ev->t1 - ev->t0) * us_per_tick);
+            first = false;
+        }
+    }
+    /* counters as one "C" sample each at the end of the run */
+    for(int i = 0; i < g_num_counters; i++){
+        fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"C\",\"pid\":%d,\"ts\":%.3f,\"args\":{\"value\":%llu}}",
+                first ? "" : ",\n", g_counters[i].name, pid, (double)end_ticks * us_per_tick,
+                (unsigned long long)g_counters[i].value);
+        first = false;
+    }
+    fprintf(f, "\n]}\n");
+    return ferror(f) ? -1 : 0;
+}
+
+int prof_finish(void)
+{
+    if(!g_running) return 0;
+    __atomic_store_n(&g_running, false, __ATOMIC_RELEASE);
+    uint64_t ticks = prof_ticks() - g_tick0;
+    uint64_t ns = prof_now_ns() - g_ns0;
+    double us_per_tick = ticks ? (double)ns / (double)ticks / 1000.0 : 0.0;
+
+    bool header = false;
+    for(int i = 0; i < g_num_stages; i++){
+        const prof_stage_stats_t *s = &g_stages[i];
+        if(!s->count) continue;
+        if(!header){
+            fprintf(stderr, "%-24s %10s %12s %10s %10s %10s\n", "stage", "count", "total ms", "mean us", "p50 us", "p99 us");
+            header = true;
+        }
+        fprintf(stderr, "%-24s %10llu %12.2f %10.2f %10.2f %10.2f\n", s->name, (unsigned long long)s->count,
+                s->total * us_per_tick / 1000.0, s->total * us_per_tick / s->count,
+                stage_quantile(s, 0.50) * us_per_tick, stage_quantile(s, 0.99) * us_per_tick);
+    }
+    for(int i = 0; i < g_num_counters; i++)
+        fprintf(stderr, "%-24s %10llu\n", g_counters[i].name, (unsigned long long)g_counters[i].value);
+
+    int rc = 0;
+    if(g_path){
+        FILE *f = fopen(g_path, "w");
+        if(!f){
+            perror(g_path);
+            rc = -1;
+        } else {
+            rc = g_trace ? write_trace(f, us_per_tick, ticks) : write_csv(f, us_per_tick);
+            if(fclose(f) != 0) rc = -1;
+        }
+    }
+    uint32_t dropped = 0;
+    for(int t = 0; t < g_num_threads; t++){
+        dropped += g_threads[t]->dropped;
+        g_threads[t]->count = g_threads[t]->dropped = 0;
+    }
+    if(dropped) fprintf(stderr, "prof: %u trace events dropped (%u per thread max)\n", dropped, PROF_TRACE_MAX);
+    return rc;
+}
@@ -1,48 +1,203 @@
 #include "raster.h"
+#include "simd4.h"
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* Row window of this thread (raster_set_rows); [0, INT_MAX) is the frame */
+static _Thread_local int g_row0 = 0, g_row1 = 0x7fffffff;
+
+void raster_set_rows(int y0, int y1)
+{
+    g_row0 = y0 < 0 ? 0 : y0;
+    g_row1 = y1;
+}
+
+/* Rows [*lo, *hi) a primitive may touch in a frame of h rows */
+static inline void clip_rows(int h, int *lo, int *hi)
+{
+    *lo = g_row0;
+    *hi = g_row1 < h ? g_row1 : h;
+}
+
+static inline bool row_in(int y, int lo, int hi)
+{
+    return y >= lo && y < hi;
+}
+
+/* memset for 32-bit pixels, four per store */
+static inline void fill32(uint32_t *p, uint32_t col, int n)
+{
+    int i = 0;
+#if SIMD4_NEON
+    const uint32x4_t v = vdupq_n_u32(col);
+    for(; i + 8 <= n; i += 8){ vst1q_u32(p + i, v); vst1q_u32(p + i + 4, v); }
+    for(; i + 4 <= n; i += 4) vst1q_u32(p + i, v);
+#elif SIMD4_SSE2
+    const __m128i v = _mm_set1_epi32((int)col);
+    for(; i + 8 <= n; i += 8){ _mm_storeu_si128((__m128i *)(p + i), v); _mm_storeu_si128((__m128i *)(p + i + 4), v); }
+    for(; i + 4 <= n; i += 4) _mm_storeu_si128((__m128i *)(p + i), v);
+#endif
+    for(; i < n; i++) p[i] = col;
+}
+
 void raster_clear(uint32_t *fb, int w, int h, uint32_t color)
 {
-    for(int i=0;i<w*h;i++) fb[i]=color;
+    int lo, hi;
+    clip_rows(h, &lo, &hi);
+    if(lo < hi) fill32(fb + (size_t)lo*w, color, (hi - lo)*w);
+}
+
+void raster_hspan(uint32_t *fb,int w,int h,int y,int x0,int x1,uint32_t col)
+{
+    int lo, hi;
+    clip_rows(h, &lo, &hi);
+    if(!row_in(y, lo, hi)) return;
+    if(x0 < 0) x0 = 0;
+    if(x1 >= w) x1 = w-1;
+    if(x0 <= x1) fill32(fb + y*w + x0, col, x1 - x0 + 1);
 }
 
-static inline void plot(uint32_t *fb,int w,int h,int x,int y,uint32_t col){
-    if((unsigned)x<(unsigned)w && (unsigned)y<(unsigned)h) fb[y*w+x]=col;
+static inline void plot(uint32_t *fb,int w,int lo,int hi,int x,int y,uint32_t col){
+    if((unsigned)x<(unsigned)w && row_in(y, lo, hi)) fb[y*w+x]=col;
+}
+
+/*
+ * Circles as horizontal spans, one clip per span.  Row extents are walked
+ * from row to row instead of solved per row (or tested per pixel): the
+ * outer edge x_out(y) = max{x : x^2 <= r^2 - y^2} only shrinks as |y|
+ * grows, so rows 0..r cost O(r) compares in total.  Same pixels as the
+ * x^2 + y^2 tests they replace.
+ */
+
+/* Largest x >= 0 with x*x <= lim (lim >= 0), walking down from `x` */
+static inline int edge_down(int x, int lim)
+{
+    while(x > 0 && x*x > lim) x--;
+    return x;
+}
+
+/* Smallest x >= 0 with x*x >= lim, walking down from `x` (>= the answer) */
+static inline int edge_in(int x, int lim)
+{
+    while(x > 0 && (x-1)*(x-1) >= lim) x--;
+    return x;
 }
 
 void raster_circle(uint32_t *fb,int w,int h,int cx,int cy,int r,uint32_t col,int thickness)
 {
     if(thickness<=0) thickness=1;
-    int r_out=r;
+    if(r < 0) return;
     int r_in=r-thickness;
-    int r_out2=r_out*r_out;
+    int r_out2=r*r;
     int r_in2=r_in*r_in;
-    for(int y=-r_out;y<=r_out;y++){
-        int yy=y+cy;
-        int y2=y*y;
-        for(int x=-r_out;x<=r_out;x++){
-            int xx=x+cx;
-            int dist2 = x*x + y2;
-            if(dist2<=r_out2 && dist2>=r_in2){ plot(fb,w,h,xx,yy,col);}        }
+    /* Ring pixels of row y: r_in2 - y^2 <= x^2 <= r_out2 - y^2 */
+    int xo = r, xi = abs(r_in) + 1;
+    int lo, hi;
+    clip_rows(h, &lo, &hi);
+    for(int y=0;y<=r;y++){
+        int y2 = y*y;
+        xo = edge_down(xo, r_out2 - y2);
+        int lim_in = r_in2 - y2;
+        int inner = lim_in > 0 ? (xi = edge_in(xi, lim_in)) : 0;
+        for(int side = 0; side < 2; side++){
+            if(side && y == 0) break;
+            int yy = side ? cy - y : cy + y;
+            if(!row_in(yy, lo, hi)) continue;
+            if(inner == 0){
+                raster_hspan(fb, w, h, yy, cx - xo, cx + xo, col);
+            } else if(inner <= xo){
+                raster_hspan(fb, w, h, yy, cx - xo, cx - inner, col);
+                raster_hspan(fb, w, h, yy, cx + inner, cx + xo, col);
+            }
+        }
     }
 }
 
 /* Filled circle using simple scanline fill */
 void raster_fill_circle(uint32_t *fb,int w,int h,int cx,int cy,int r,uint32_t col)
 {
+    if(r < 0) return;
     int r2 = r*r;
-    for(int y=-r; y<=r; ++y){
-        int yy = cy + y;
-        if((unsigned)yy >= (unsigned)h) continue;
-        int x_extent = (int)sqrtf((float)(r2 - y*y));
-        int x_min = cx - x_extent;
-        int x_max = cx + x_extent;
-        if(x_min < 0) x_min = 0;
-        if(x_max >= w) x_max = w-1;
-        for(int x = x_min; x <= x_max; ++x){
-            fb[yy*w + x] = col;
+    int x = r;
+    for(int y=0; y<=r; ++y){
+        x = edge_down(x, r2 - y*y);
+        raster_hspan(fb, w, h, cy + y, cx - x, cx + x, col);
+        if(y) raster_hspan(fb, w, h, cy - y, cx - x, cx + x, col);
+    }
+}
+
+/* fb = fb + (col - fb) * cov, per byte, cov in 0..256 */
+static inline void blend(uint32_t *p, uint32_t col, int cov)
+{
+    uint32_t d = *p;
+    uint32_t rb = d & 0x00FF00FFu, ag = (d >> 8) & 0x00FF00FFu;
+    uint32_t srb = col & 0x00FF00FFu, sag = (col >> 8) & 0x00FF00FFu;
+    rb = (rb + (((srb - rb) * (uint32_t)cov) >> 8)) & 0x00FF00FFu;
+    ag = (ag + (((sag - ag) * (uint32_t)cov) >> 8)) & 0x00FF00FFu;
+    *p = rb | ag << 8;
+}
+
+/* Coverage of the pixel at distance d from the centre by the band [a, b] */
+static inline int ring_cov(float d, float a, float b)
+{
+    float c = fminf(b - d, d - a) + 0.5f;
+    if(c >= 1.0f) return 256;
+    if(c <= 0.0f) return 0;
+    return (int)(c * 256.0f);
+}
+
+/* Blend |x| in [lo, hi] on row yy (both sides) by coverage */
+static void ring_fringe(uint32_t *fb,int w,int cx,int yy,int y,int lo,int hi,float a,float b,uint32_t col)
+{
+    for(int x = lo; x <= hi; x++){
+        int cov = ring_cov(sqrtf((float)(x*x + y*y)), a, b);
+        if(cov == 0) continue;
+        int xs[2] = { cx + x, cx - x };
+        for(int k = 0; k < (x ? 2 : 1); k++){
+            if((unsigned)xs[k] >= (unsigned)w) continue;
+            uint32_t *p = fb + yy*w + xs[k];
+            if(cov == 256) *p = col; else blend(p, col, cov);
+        }
+    }
+}
+
+void raster_ring_aa(uint32_t *fb,int w,int h,int cx,int cy,int r,uint32_t col,int thickness)
+{
+    if(thickness<=0) thickness=1;
+    if(r <= 0) return;
+    /* Band [a, b] around the same pixels raster_circle draws */
+    float b = (float)r, a = (float)(r - thickness);
+    if(a < 0.0f) a = -1.0f;
+    float bo2 = (b + 0.5f)*(b + 0.5f), bi2 = (b - 0.5f)*(b - 0.5f);
+    float ai2 = a > -0.5f ? (a + 0.5f)*(a + 0.5f) : 0.0f, ao2 = a > 0.5f ? (a - 0.5f)*(a - 0.5f) : 0.0f;
+    int lo, hi;
+    clip_rows(h, &lo, &hi);
+    for(int y = 0; (float)(y*y) < bo2; y++){
+        float y2 = (float)(y*y);
+        /* |x| ranges: fringe [f_lo, f_hi], fully covered [s_lo, s_hi] */
+        int f_hi = (int)sqrtf(bo2 - y2);
+        int f_lo = ao2 > y2 ? (int)ceilf(sqrtf(ao2 - y2)) : 0;
+        int s_hi = bi2 >= y2 ? (int)floorf(sqrtf(bi2 - y2)) : -1;
+        int s_lo = ai2 > y2 ? (int)ceilf(sqrtf(ai2 - y2)) : 0;
+        if(s_lo < f_lo) s_lo = f_lo;
+        if(s_hi > f_hi) s_hi = f_hi;
+        for(int side = 0; side < 2; side++){
+            if(side && y == 0) break;
+            int yy = side ? cy - y : cy + y;
+            if(!row_in(yy, lo, hi)) continue;
+            if(s_lo > s_hi){
+                ring_fringe(fb, w, cx, yy, y, f_lo, f_hi, a, b, col);
+                continue;
+            }
+            ring_fringe(fb, w, cx, yy, y, f_lo, s_lo - 1, a, b, col);
+            ring_fringe(fb, w, cx, yy, y, s_hi + 1, f_hi, a, b, col);
+            if(s_lo == 0){
+                raster_hspan(fb, w, h, yy, cx - s_hi, cx + s_hi, col);
+            } else {
+                raster_hspan(fb, w, h, yy, cx - s_hi, cx - s_lo, col);
+                raster_hspan(fb, w, h, yy, cx + s_lo, cx + s_hi, col);
+            }
         }
     }
 }
@@ -53,9 +208,11 @@ void raster_line(uint32_t *fb,int w,int h,int x0,int y0,int x1,int y1,uint32_t c
     int dx =  abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
     int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
     int err = dx + dy, e2; /* error value e_xy */
+    int lo, hi;
+    clip_rows(h, &lo, &hi);
 
     while(true){
-        plot(fb, w, h, x0, y0, col);
+        plot(fb, w, lo, hi, x0, y0, col);
         if(x0 == x1 && y0 == y1) break;
         e2 = 2*err;
         if(e2 >= dy){ err += dy; x0 += sx; }
@@ -63,70 +220,182 @@ void raster_line(uint32_t *fb,int w,int h,int x0,int y0,int x1,int y1,uint32_t c
     }
 }
 
-/* Simple polygon: if fill==true, use scanline fill; otherwise draw outline with raster_line */
-void raster_poly(uint32_t *fb,int w,int h,const int *vx,const int *vy,int n,uint32_t col,bool fill,int thickness)
+/*
+ * Scanline fill with an active edge table.  Edges are bucketed by their
+ * first scanline; each row adds the edges starting there, drops the ones
+ * that ended, steps every active x by its slope (integer quotient and
+ * remainder, so no division per row) and fills between pairs of crossings.
+ * Crossing rule and x truncation match the per-row intersection test it
+ * replaces: an edge covers rows y_lo < y <= y_hi.
+ */
+#define POLY_MAX_EDGES 32
+
+typedef struct {
+    int y_start;      /* Upper vertex row; first covered row is y_start + 1 */
+    int y_end;        /* Last row */
+    int xa, xb, sign; /* Upper and lower vertex x, sign of xb - xa */
+    int adx, dy, q, r;/* |xb - xa| = q * dy + r */
+    int up;           /* Listed bottom to top: interpolated from the lower vertex */
+    int acc;          /* Remainder of t * adx / dy, t = rows below y_start */
+} poly_edge_t;
+
+/* Crossing at t rows below y_start, fl = floor(t * adx / dy); truncates like
+ * the float interpolation from the edge's first listed vertex did */
+static inline int edge_x(const poly_edge_t *e, int fl)
 {
-    if(n < 2) return;
-    if(!fill){
-        for(int i=0;i<n;i++){
-            int j = (i+1)%n;
-            raster_line(fb,w,h,vx[i],vy[i],vx[j],vy[j],col);
-            if(thickness>1){ /* naive thickness by drawing parallel lines */
-                for(int t=1;t<thickness;t++){
-                    raster_line(fb,w,h,vx[i]+t,vy[i],vx[j]+t,vy[j],col);
-                    raster_line(fb,w,h,vx[i]-t,vy[i],vx[j]-t,vy[j],col);
-                }
-            }
-        }
-        return;
+    if(!e->up) return e->xa + e->sign * fl;
+    int ce = fl + (e->acc != 0);        /* ceil(t * adx / dy) */
+    return e->xb - e->sign * (e->adx - ce);
+}
+
+static void poly_fill(uint32_t *fb,int w,int h,const int *vx,const int *vy,int n,uint32_t col)
+{
+    poly_edge_t edges[POLY_MAX_EDGES];
+    int ne = 0;
+    int y_min = 0x7fffffff, y_max = -0x7fffffff;
+    for(int i=0;i<n && ne < POLY_MAX_EDGES;i++){
+        int j = (i+1)%n;
+        int xa = vx[i], ya = vy[i], xb = vx[j], yb = vy[j];
+        if(ya == yb) continue;
+        poly_edge_t *e = &edges[ne++];
+        e->up = ya > yb;
+        if(e->up){ int t = xa; xa = xb; xb = t; t = ya; ya = yb; yb = t; }
+        e->y_start = ya;
+        e->y_end = yb;
+        e->xa = xa;
+        e->xb = xb;
+        e->sign = xb < xa ? -1 : 1;
+        e->adx = abs(xb - xa);
+        e->dy = yb - ya;
+        e->q = e->adx / e->dy;
+        e->r = e->adx % e->dy;
+        e->acc = 0;
+        if(ya + 1 < y_min) y_min = ya + 1;
+        if(yb > y_max) y_max = yb;
     }
+    if(ne < 2) return;
 
-    /* --- fill --- */
-    /* Determine bounding box */
-    int y_min = vy[0], y_max = vy[0];
-    for(int i=1;i<n;i++){
-        if(vy[i] < y_min) y_min = vy[i];
-        if(vy[i] > y_max) y_max = vy[i];
+    /* Sort edges by first row so the active set grows from the front */
+    for(int i=1;i<ne;i++){
+        poly_edge_t key = edges[i]; int j = i-1;
+        while(j >= 0 && edges[j].y_start > key.y_start){ edges[j+1] = edges[j]; j--; }
+        edges[j+1] = key;
     }
-    if(y_min < 0) y_min = 0;
-    if(y_max >= h) y_max = h-1;
 
-    for(int y=y_min; y<=y_max; ++y){
-        /* Build list of x intersections with edges */
-        int inter[32]; /* assume n<=32 */
-        int count = 0;
-        for(int i=0;i<n;i++){
-            int j = (i+1)%n;
-            int y0 = vy[i], y1 = vy[j];
-            if((y0<y && y1>=y) || (y1<y && y0>=y)){
-                int x0 = vx[i], x1 = vx[j];
-                /* linear interpolation */
-                int x = x0 + (int)((float)(y - y0) * (float)(x1 - x0) / (float)(y1 - y0 + (y1==y0))); /* avoid div0 */
-                if(count < 32){ inter[count++] = x; }
-            }
+    /* Rows above the screen (or the row window) are skipped by stepping
+       edges straight to the first row drawn */
+    int lo, hi;
+    clip_rows(h, &lo, &hi);
+    if(y_max >= hi) y_max = hi-1;
+    if(y_min < lo) y_min = lo;
+    int next = 0, na = 0;
+    poly_edge_t *active[POLY_MAX_EDGES];
+    int fl[POLY_MAX_EDGES];
+    for(int y = y_min; y <= y_max; ++y){
+        while(next < ne && edges[next].y_start < y){
+            poly_edge_t *e = &edges[next++];
+            /* Jump to the row before y once, then step by one */
+            long long num = (long long)(y - 1 - e->y_start) * e->adx;
+            e->acc = (int)(num % e->dy);
+            fl[na] = (int)(num / e->dy);
+            active[na++] = e;
         }
+        int k = 0, count = 0;
+        int inter[POLY_MAX_EDGES];
+        for(int i=0;i<na;i++){
+            poly_edge_t *e = active[i];
+            if(y > e->y_end) continue;
+            int f = fl[i] + e->q;
+            e->acc += e->r;
+            if(e->acc >= e->dy){ e->acc -= e->dy; f++; }
+            fl[k] = f;
+            active[k++] = e;
+            inter[count++] = edge_x(e, f);
+        }
+        na = k;
         if(count < 2) continue;
-        /* sort small array (insertion) */
         for(int i=1;i<count;i++){
             int key=inter[i]; int j=i-1; while(j>=0 && inter[j]>key){ inter[j+1]=inter[j]; j--; } inter[j+1]=key; }
-        for(int i=0;i<count; i+=2){
-            int x_start = inter[i];
-            int x_end   = inter[i+1];
-            if(x_start < 0) x_start = 0;
-            if(x_end >= w) x_end = w-1;
-            for(int x=x_start; x<=x_end; ++x){
-                fb[y*w + x] = col;
-            }
+        for(int i=0;i+1<count; i+=2)
+            raster_hspan(fb, w, h, y, inter[i], inter[i+1], col);
+    }
+}
+
+/*
+ * Convex polygon with float vertices, sampled at pixel centres: row y takes
+ * the pixels whose centres fall between the leftmost and rightmost edge
+ * crossing of y + 0.5.  One span per row.
+ */
+static void convex_fill(uint32_t *fb,int w,int h,const float *px,const float *py,int n,uint32_t col)
+{
+    float fy0 = py[0], fy1 = py[0];
+    for(int i=1;i<n;i++){ fy0 = fminf(fy0, py[i]); fy1 = fmaxf(fy1, py[i]); }
+    int y0 = (int)ceilf(fy0 - 0.5f), y1 = (int)floorf(fy1 - 0.5f);
+    int lo, hi;
+    clip_rows(h, &lo, &hi);
+    if(y0 < lo) y0 = lo;
+    if(y1 >= hi) y1 = hi-1;
+    for(int y=y0; y<=y1; ++y){
+        float sy = (float)y + 0.5f, xl = 1e30f, xr = -1e30f;
+        for(int i=0;i<n;i++){
+            int j = (i+1)%n;
+            float ya = py[i], yb = py[j];
+            if((ya <= sy) == (yb <= sy)) continue;
+            float x = px[i] + (sy - ya) * (px[j] - px[i]) / (yb - ya);
+            xl = fminf(xl, x); xr = fmaxf(xr, x);
+        }
+        if(xl > xr) continue;
+        raster_hspan(fb, w, h, y, (int)ceilf(xl - 0.5f), (int)floorf(xr - 0.5f), col);
+    }
+}
+
+/*
+ * Thick line as a filled quad: the segment widened by `width` across and
+ * extended by width/2 past both ends (square caps, which also close the
+ * joins of a polyline).
+ */
+void raster_thick_line(uint32_t *fb,int w,int h,int x0,int y0,int x1,int y1,int width,uint32_t col)
+{
+    if(width <= 1){ raster_line(fb,w,h,x0,y0,x1,y1,col); return; }
+    float dx = (float)(x1 - x0), dy = (float)(y1 - y0);
+    float len = sqrtf(dx*dx + dy*dy);
+    float hw = 0.5f * (float)width;
+    float ux = len > 0.0f ? dx / len : 1.0f, uy = len > 0.0f ? dy / len : 0.0f;
+    float ax = ux * hw, ay = uy * hw;        /* Along the line */
+    float nx = -ay, ny = ax;                 /* Across */
+    /* Pixel (x, y) covers [x, x+1); centre the quad on pixel centres */
+    float cx0 = (float)x0 + 0.5f - ax, cy0 = (float)y0 + 0.5f - ay;
+    float cx1 = (float)x1 + 0.5f + ax, cy1 = (float)y1 + 0.5f + ay;
+    float px[4] = { cx0 + nx, cx1 + nx, cx1 - nx, cx0 - nx };
+    float py[4] = { cy0 + ny, cy1 + ny, cy1 - ny, cy0 - ny };
+    convex_fill(fb, w, h, px, py, 4, col);
+}
+
+/* Simple polygon: if fill==true, scanline fill; otherwise outline.
+ * Outlines of thickness t are 2t-1 px quads per edge (the stroke weight of
+ * the parallel-line outline they replace), thickness 1 is Bresenham. */
+void raster_poly(uint32_t *fb,int w,int h,const int *vx,const int *vy,int n,uint32_t col,bool fill,int thickness)
+{
+    if(n < 2) return;
+    if(!fill){
+        for(int i=0;i<n;i++){
+            int j = (i+1)%n;
+            if(thickness > 1) raster_thick_line(fb,w,h,vx[i],vy[i],vx[j],vy[j],2*thickness-1,col);
+            else raster_line(fb,w,h,vx[i],vy[i],vx[j],vy[j],col);
         }
+        return;
     }
+    poly_fill(fb, w, h, vx, vy, n, col);
 }
 
 /* Blit helper: copy src_w*src_h pixels at (dx,dy) into dst, no alpha */
 void raster_blit_rgba(const uint32_t *src,int src_w,int src_h,uint32_t *dst,int dst_w,int dst_h,int dx,int dy)
 {
+    int lo, hi;
+    clip_rows(dst_h, &lo, &hi);
     for(int y=0;y<src_h;y++){
         int dst_y = dy + y;
-        if((unsigned)dst_y >= (unsigned)dst_h) continue;
+        if(!row_in(dst_y, lo, hi)) continue;
         const uint32_t *srow = src + y*src_w;
         uint32_t *drow = dst + dst_y*dst_w;
         int copy_w = src_w;
@@ -140,9 +409,11 @@ void raster_blit_rgba(const uint32_t *src,int src_w,int src_h,uint32_t *dst,int
 
 void raster_blit_rgba_alpha(const uint32_t *src,int src_w,int src_h,uint32_t *dst,int dst_w,int dst_h,int dx,int dy)
 {
+    int lo, hi;
+    clip_rows(dst_h, &lo, &hi);
     for(int y=0;y<src_h;y++){
         int dst_y = dy + y;
-        if((unsigned)dst_y >= (unsigned)dst_h) continue;
+        if(!row_in(dst_y, lo, hi)) continue;
         const uint32_t *srow = src + y*src_w;
         uint32_t *drow = dst + dst_y*dst_w;
         for(int x=0; x<src_w; ++x){
@@ -0,0 +1,112 @@
+#include "rt_engine.h"
+#include "pcm16.h"
+#include <math.h>
+#include <string.h>
+
+/* Producer side (audio thread) */
+static void rt_ring_push(rt_event_ring_t *r, const rt_event_t *ev)
+{
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    if(head - tail >= RT_EVENT_RING){
+        __atomic_store_n(&r->dropped, r->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    r->ev[head & (RT_EVENT_RING - 1)] = *ev;
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+}
+
+size_t rt_engine_poll(rt_engine_t *e, rt_event_t *out, size_t max)
+{
+    rt_event_ring_t *r = &e->ring;
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    size_t n = 0;
+    while(tail != head && n < max){
+        out[n++] = r->ev[tail & (RT_EVENT_RING - 1)];
+        tail++;
+    }
+    __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+    return n;
+}
+
+/* Writer side of the clock's seqlock (audio thread) */
+static void rt_clock_stamp(rt_clock_t *c, uint64_t frame, uint64_t pts_ns)
+{
+    uint32_t seq = c->seq;
+    __atomic_store_n(&c->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&c->frame, frame, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->pts_ns, pts_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+bool rt_engine_clock(rt_engine_t *e, uint64_t *frame, uint64_t *pts_ns)
+{
+    rt_clock_t *c = &e->clock;
+    uint32_t s0, s1;
+    do {
+        s0 = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+        *frame = __atomic_load_n(&c->frame, __ATOMIC_RELAXED);
+        *pts_ns = __atomic_load_n(&c->pts_ns, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        s1 = __atomic_load_n(&c->seq, __ATOMIC_RELAXED);
+    } while((s0 & 1) || s0 != s1);
+    return *pts_ns != 0;
+}
+
+int rt_engine_init(rt_engine_t *e, uint64_t seed)
+{
+    memset(&e->ring, 0, sizeof(e->ring));
+    memset(&e->clock, 0, sizeof(e->clock));
+    e->frames = 0;
+    e->callbacks = 0;
+    generator_init(&e->gen, seed);
+    generator_set_scratch(&e->gen, e->scratch, RT_MAX_BLOCK);
+    return e->gen.delay.buf ? 0 : -1;
+}
+
+void rt_engine_free(rt_engine_t *e)
+{
+    generator_free(&e->gen);
+}
+
+void rt_engine_render_at(rt_engine_t *e, float *out, uint32_t num_frames, uint64_t pts_ns)
+{
+    if(pts_ns) rt_clock_stamp(&e->clock, e->frames, pts_ns);
+    rt_engine_render(out, num_frames, e);
+}
+
+void rt_engine_render(float *out, uint32_t num_frames, void *user)
+{
+    rt_engine_t *e = (rt_engine_t *)user;
+    generator_t *g = &e->gen;
+    float sum = 0.0f;
+
+    for(uint32_t done = 0; done < num_frames; ){
+        uint32_t n = num_frames - done < RT_MAX_BLOCK ? num_frames - done : RT_MAX_BLOCK;
+        generator_process(g, e->L, e->R, n);
+        float *dst = out + 2 * (size_t)done;
+        pcm_interleave_f32(e->L, e->R, dst, n);
+        sum += pcm_sumsq_f32(dst, 2 * n);   /* still in cache */
+
+        /* Trigger flags latch in the generator; hand them over and clear */
+        rt_event_t ev = { e->frames + done, 0.0f, RT_EV_SAW, (uint16_t)g->step };
+        if(g->saw_hit){
+            rt_ring_push(&e->ring, &ev);
+            g->saw_hit = false;
+        }
+        if(g->bass_hit){
+            ev.type = RT_EV_BASS;
+            rt_ring_push(&e->ring, &ev);
+            g->bass_hit = false;
+        }
+        done += n;
+    }
+
+    rt_event_t level = { e->frames, num_frames ? sqrtf(sum / (2.0f * num_frames)) : 0.0f,
+                         RT_EV_LEVEL, (uint16_t)g->step };
+    rt_ring_push(&e->ring, &level);
+    e->frames += num_frames;
+    __atomic_fetch_add(&e->callbacks, 1, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,254 @@
+#include "rt_frame.h"
+#include "raster.h"
+#include "terrain.h"
+#include "particles.h"
+#include "buf_alloc.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ---- display list ------------------------------------------------------ */
+
+void rt_dl_begin(rt_dlist_t *dl, int w, int h)
+{
+    dl->w = w;
+    dl->h = h;
+    dl->ncmds = dl->nverts = dl->nglyphs = 0;
+}
+
+static rt_cmd_t *dl_push(rt_dlist_t *dl, rt_cmd_type_t type, int top, int bottom)
+{
+    if(dl->ncmds >= RT_DL_MAX_CMDS) return NULL;
+    rt_cmd_t *c = &dl->cmds[dl->ncmds++];
+    memset(c, 0, sizeof(*c));
+    c->type = (uint8_t)type;
+    c->top = top;
+    c->bottom = bottom;
+    return c;
+}
+
+void rt_dl_clear(rt_dlist_t *dl, uint32_t color)
+{
+    rt_cmd_t *c = dl_push(dl, RT_CMD_CLEAR, 0, dl->h - 1);
+    if(c) c->color = color;
+}
+
+void rt_dl_fill_circle(rt_dlist_t *dl, int cx, int cy, int r, uint32_t color)
+{
+    rt_cmd_t *c = dl_push(dl, RT_CMD_FILL_CIRCLE, cy - r, cy + r);
+    if(!c) return;
+    c->x = cx; c->y = cy; c->r = r;
+    c->color = color;
+}
+
+void rt_dl_ring_aa(rt_dlist_t *dl, int cx, int cy, int r, uint32_t color, int thickness)
+{
+    /* the antialiased fringe reaches half a pixel past r */
+    rt_cmd_t *c = dl_push(dl, RT_CMD_RING_AA, cy - r - 1, cy + r + 1);
+    if(!c) return;
+    c->x = cx; c->y = cy; c->r = r;
+    c->thickness = thickness;
+    c->color = color;
+}
+
+void rt_dl_terrain(rt_dlist_t *dl, int frame, int top)
+{
+    rt_cmd_t *c = dl_push(dl, RT_CMD_TERRAIN, top, dl->h - 1);
+    if(c) c->x = frame;
+}
+
+void rt_dl_outline(rt_dlist_t *dl, const int *vx, const int *vy, int n, uint32_t color, int thickness)
+{
+    if(n < 2 || dl->nverts + n > RT_DL_MAX_VERTS) return;
+    int top = vy[0], bottom = vy[0];
+    for(int i = 1; i < n; i++){
+        if(vy[i] < top) top = vy[i];
+        if(vy[i] > bottom) bottom = vy[i];
+    }
+    /* thick edges are 2t-1 px quads with square caps: within 2t of a vertex */
+    int pad = thickness > 1 ? 2 * thickness + 1 : 0;
+    rt_cmd_t *c = dl_push(dl, RT_CMD_OUTLINE, top - pad, bottom + pad);
+    if(!c) return;
+    c->first = dl->nverts;
+    c->n = n;
+    c->thickness = thickness;
+    c->color = color;
+    memcpy(dl->vx + dl->nverts, vx, n * sizeof(int));
+    memcpy(dl->vy + dl->nverts, vy, n * sizeof(int));
+    dl->nverts += n;
+}
+
+rt_glyph_t *rt_dl_glyphs_begin(rt_dlist_t *dl, int *n)
+{
+    *n = dl->ncmds < RT_DL_MAX_CMDS ? RT_DL_MAX_GLYPHS - dl->nglyphs : 0;
+    return dl->glyphs + dl->nglyphs;
+}
+
+void rt_dl_glyphs_end(rt_dlist_t *dl, int used)
+{
+    if(used <= 0) return;
+    const rt_glyph_t *g = dl->glyphs + dl->nglyphs;
+    int top = g[0].y, bottom = g[0].y;
+    for(int i = 1; i < used; i++){
+        if(g[i].y < top) top = g[i].y;
+        if(g[i].y > bottom) bottom = g[i].y;
+    }
+    rt_cmd_t *c = dl_push(dl, RT_CMD_GLYPHS, top, bottom + 6);
+    if(!c) return;
+    c->first = dl->nglyphs;
+    c->n = used;
+    dl->nglyphs += used;
+}
+
+void rt_dl_draw(const rt_dlist_t *dl, uint32_t *fb, int y0, int y1)
+{
+    int w = dl->w, h = dl->h;
+    if(y0 < 0) y0 = 0;
+    if(y1 > h) y1 = h;
+    raster_set_rows(y0, y1);
+    for(int i = 0; i < dl->ncmds; i++){
+        const rt_cmd_t *c = &dl->cmds[i];
+        if(c->bottom < y0 || c->top >= y1) continue;
+        switch(c->type){
+        case RT_CMD_CLEAR:
+            raster_clear(fb, w, h, c->color);
+            break;
+        case RT_CMD_FILL_CIRCLE:
+            raster_fill_circle(fb, w, h, c->x, c->y, c->r, c->color);
+            break;
+        case RT_CMD_RING_AA:
+            raster_ring_aa(fb, w, h, c->x, c->y, c->r, c->color, c->thickness);
+            break;
+        case RT_CMD_TERRAIN:
+            terrain_draw(fb, w, h, c->x);
+            break;
+        case RT_CMD_OUTLINE:
+            raster_poly(fb, w, h, dl->vx + c->first, dl->vy + c->first, c->n, c->color, false, c->thickness);
+            break;
+        case RT_CMD_GLYPHS:
+            particles_draw_glyphs(fb, w, y0, y1, dl->glyphs + c->first, c->n);
+            break;
+        }
+    }
+    raster_set_rows(0, 0x7fffffff);
+}
+
+/* ---- band workers ------------------------------------------------------ */
+
+struct rt_worker {
+    rt_bands_t *b;
+    int index;
+};
+
+/* Claim bands until the frame has none left: draw, then the CRT rows */
+static void bands_work(rt_bands_t *b, int index)
+{
+    uint32_t *scratch = b->scratch + (size_t)index * b->scratch_stride;
+    for(;;){
+        int band = __atomic_fetch_add(&b->next_band, 1, __ATOMIC_RELAXED);
+        if(band >= b->bands) break;
+        int y0 = band * b->band_rows;
+        int y1 = y0 + b->band_rows < b->h ? y0 + b->band_rows : b->h;
+        rt_dl_draw(b->dl, b->fb, y0, y1);
+        if(b->fx) crt_fx_apply_rows(b->fx, b->fb, b->w, y0, y1, b->frame, scratch);
+    }
+}
+
+static void *bands_worker_main(void *arg)
+{
+    rt_worker_t *wk = (rt_worker_t *)arg;
+    rt_bands_t *b = wk->b;
+    uint32_t seen = 0;
+    pthread_mutex_lock(&b->lock);
+    for(;;){
+        while(!b->quit && b->generation == seen) pthread_cond_wait(&b->wake, &b->lock);
+        if(b->quit) break;
+        seen = b->generation;
+        pthread_mutex_unlock(&b->lock);
+        bands_work(b, wk->index);
+        pthread_mutex_lock(&b->lock);
+        if(--b->running == 0) pthread_cond_signal(&b->done_cv);
+    }
+    pthread_mutex_unlock(&b->lock);
+    return NULL;
+}
+
+int rt_bands_init(rt_bands_t *b, int threads, int w, int h)
+{
+    memset(b, 0, sizeof(*b));
+    if(threads < 1) threads = 1;
+    if(threads > RT_BANDS_MAX_THREADS) threads = RT_BANDS_MAX_THREADS;
+    b->w = w;
+    b->h = h;
+    /* About four bands per thread, whole rows of 8, for the queue to even
+       out; one thread draws the frame as one band */
+    if(threads == 1){
+        b->band_rows = h;
+    } else {
+        int rows = (h + 4 * threads - 1) / (4 * threads);
+        b->band_rows = (rows + 7) & ~7;
+    }
+    if(b->band_rows < 1) b->band_rows = 1;
+    b->bands = (h + b->band_rows - 1) / b->band_rows;
+
+    /* crt_fx scratch rows, each thread's pair on its own cache lines */
+    b->scratch_stride = ((size_t)2 * w + BUF_ALIGN / sizeof(uint32_t) - 1) & ~(BUF_ALIGN / sizeof(uint32_t) - 1);
+    b->scratch = buf_alloc(0, b->scratch_stride * threads * sizeof(uint32_t), BUF_ZERO);
+    if(!b->scratch) return -1;
+    pthread_mutex_init(&b->lock, NULL);
+    pthread_cond_init(&b->wake, NULL);
+    pthread_cond_init(&b->done_cv, NULL);
+
+    b->threads = 1;
+    if(threads > 1){
+        b->workers = calloc((size_t)threads, sizeof(rt_worker_t));
+        if(!b->workers) return 0;
+        for(int t = 1; t < threads; t++){
+            b->workers[t] = (rt_worker_t){ b, t };
+            if(pthread_create(&b->tids[t], NULL, bands_worker_main, &b->workers[t]) != 0) break;
+            b->threads++;
+        }
+    }
+    return 0;
+}
+
+void rt_bands_free(rt_bands_t *b)
+{
+    if(!b->scratch) return;
+    pthread_mutex_lock(&b->lock);
+    b->quit = true;
+    pthread_cond_broadcast(&b->wake);
+    pthread_mutex_unlock(&b->lock);
+    for(int t = 1; t < b->threads; t++) pthread_join(b->tids[t], NULL);
+    pthread_cond_destroy(&b->done_cv);
+    pthread_cond_destroy(&b->wake);
+    pthread_mutex_destroy(&b->lock);
+    free(b->workers);
+    buf_free(b->scratch);
+    b->scratch = NULL;
+}
+
+void rt_bands_render(rt_bands_t *b, const rt_dlist_t *dl, uint32_t *fb, crt_fx_t *fx, int frame)
+{
+    /* crt_fx_apply does nothing without its buffers */
+    if(fx && (!fx->prev_frame || !fx->scratch)) fx = NULL;
+
+    pthread_mutex_lock(&b->lock);
+    b->dl = dl;
+    b->fb = fb;
+    b->fx = fx;
+    b->frame = frame;
+    b->next_band = 0;
+    b->running = b->threads - 1;
+    b->generation++;
+    pthread_cond_broadcast(&b->wake);
+    pthread_mutex_unlock(&b->lock);
+
+    bands_work(b, 0);
+
+    /* Barrier: every band drawn and post-processed before the noise */
+    pthread_mutex_lock(&b->lock);
+    while(b->running > 0) pthread_cond_wait(&b->done_cv, &b->lock);
+    pthread_mutex_unlock(&b->lock);
+
+    if(fx) crt_fx_noise(fx, fb, b->w, b->h);
+}
@@ -0,0 +1,85 @@
+#include "rt_sync.h"
+#include "prof.h"
+#include <math.h>
+#include <string.h>
+
+void rt_sync_init(rt_sync_t *s, uint32_t sample_rate, int fps)
+{
+    memset(s, 0, sizeof(*s));
+    s->sample_rate = sample_rate;
+    s->fps = fps;
+    s->prof_dropped = prof_counter("av.dropped");
+    s->prof_held = prof_counter("av.held");
+}
+
+/* Fold the engine's latest stamp into the clock.  Stamps carry the
+   callback's scheduling jitter (and, off ALSA, the backend's guess), so one
+   that roughly agrees moves the clock an eighth of the way; one that
+   doesn't means the device restarted or ran dry, and is taken as is. */
+static void sync_clock(rt_sync_t *s, rt_engine_t *e)
+{
+    uint64_t frame, pts;
+    if(!rt_engine_clock(e, &frame, &pts)) return;
+    if(s->anchored && frame == s->stamp_frame) return;
+    s->stamp_frame = frame;
+    if(s->anchored){
+        int64_t predicted = (int64_t)s->anchor_ns +
+                            (int64_t)((double)(int64_t)(frame - s->anchor_frame) * 1e9 / s->sample_rate);
+        int64_t diff = (int64_t)pts - predicted;
+        if(diff > -RT_SYNC_SNAP_NS && diff < RT_SYNC_SNAP_NS) pts = (uint64_t)(predicted + diff / 8);
+    }
+    s->anchor_frame = frame;
+    s->anchor_ns = pts;
+    s->anchored = true;
+}
+
+int rt_sync_frame(rt_sync_t *s, rt_engine_t *e, uint64_t shown_ns, rt_event_t *out, size_t max, size_t *n)
+{
+    s->npending += rt_engine_poll(e, s->pending + s->npending, RT_EVENT_RING - s->npending);
+    sync_clock(s, e);
+
+    /* The audio frame being heard as the frame shows */
+    double heard = 0.0;
+    if(s->anchored)
+        heard = (double)s->anchor_frame + (double)(int64_t)(shown_ns - s->anchor_ns) * s->sample_rate / 1e9;
+
+    /* Events heard by then; a queue past half full lets its oldest go early */
+    size_t k = 0;
+    while(k < s->npending && k < max &&
+          (!s->anchored || (double)s->pending[k].frame <= heard || s->npending - k > RT_EVENT_RING / 2)){
+        out[k] = s->pending[k];
+        k++;
+    }
+    s->npending -= k;
+    memmove(s->pending, s->pending + k, s->npending * sizeof(rt_event_t));
+    *n = k;
+
+    if(!s->anchored || s->fps <= 0 || heard < 0.0) return 1;
+    if(!s->started){
+        s->base = (uint64_t)heard;
+        s->tick = -1;
+        s->started = true;
+    }
+
+    /* The tick this frame should show, against the one after the last */
+    double exact = (heard - (double)s->base) * s->fps / s->sample_rate;
+    double err = exact - (double)(s->tick + 1);
+    int ticks = 1;
+    if(err >= 1.0){
+        ticks = 1 + (int)err;
+        s->dropped += (uint64_t)(ticks - 1);
+        prof_count(s->prof_dropped, (uint64_t)(ticks - 1));
+        if(ticks > 1 + RT_SYNC_MAX_CATCHUP){
+            /* A stall (device restart, window drag): jump, don't replay it */
+            s->tick = (int64_t)floor(exact) - 1;
+            ticks = 1;
+        }
+    } else if(err <= -1.0){
+        ticks = 0;
+        s->held++;
+        prof_count(s->prof_held, 1);
+    }
+    s->tick += ticks;
+    s->error_ms = (float)((exact - (double)s->tick) * 1000.0 / s->fps);
+    return ticks;
+}
@@ -0,0 +1,85 @@
+#include "seed.h"
+#include "digest.h"
+#include <string.h>
+
+static int hex_digit(char c)
+{
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* Hex digits right-aligned into the 256-bit big-endian value */
+static int parse_hex(const char *s, size_t n, uint8_t value[32])
+{
+    if(n == 0 || n > 64) return -1;
+    memset(value, 0, 32);
+    for(size_t i = 0; i < n; i++){
+        int d = hex_digit(s[n - 1 - i]);
+        if(d < 0) return -1;
+        value[31 - i / 2] |= (uint8_t)(d << (4 * (i & 1)));
+    }
+    return 0;
+}
+
+/* Decimal, at most UINT64_MAX */
+static int parse_dec(const char *s, size_t n, uint8_t value[32])
+{
+    if(n == 0) return -1;
+    uint64_t v = 0;
+    for(size_t i = 0; i < n; i++){
+        if(s[i] < '0' || s[i] > '9') return -1;
+        uint64_t d = (uint64_t)(s[i] - '0');
+        if(v > (UINT64_MAX - d) / 10) return -1;
+        v = v * 10 + d;
+    }
+    memset(value, 0, 32);
+    for(int i = 0; i < 8; i++)
+        value[31 - i] = (uint8_t)(v >> (8 * i));
+    return 0;
+}
+
+void ndb_seed_from_bytes(const uint8_t value[32], ndb_seed_t *out)
+{
+    memcpy(out->value, value, 32);
+
+    int wide = 0;
+    for(int i = 0; i < 24; i++)
+        wide |= value[i];
+    uint64_t low = 0;
+    for(int i = 24; i < 32; i++)
+        low = low << 8 | value[i];
+    out->audio = wide ? xxh64(value, 32, 0) : low;
+
+    uint32_t v = 0;
+    for(int w = 0; w < 8; w++){
+        const uint8_t *p = value + 4 * w;
+        v ^= (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    }
+    out->visual = v ? v : 0xDEADBEEFu;
+}
+
+void ndb_seed_from_u64(uint64_t value, ndb_seed_t *out)
+{
+    uint8_t bytes[32] = {0};
+    for(int i = 0; i < 8; i++)
+        bytes[31 - i] = (uint8_t)(value >> (8 * i));
+    ndb_seed_from_bytes(bytes, out);
+}
+
+int ndb_seed_parse(const char *str, ndb_seed_t *out)
+{
+    uint8_t value[32];
+    size_t n = strlen(str);
+    int rc;
+    if(n > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+        rc = parse_hex(str + 2, n - 2, value);
+    else if(parse_dec(str, n, value) == 0)
+        rc = 0;
+    else
+        rc = parse_hex(str, n, value);
+    if(rc != 0) return -1;
+    ndb_seed_from_bytes(value, out);
+    return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * seed_farm – render many seeds in parallel.
+ *
+ * Each worker thread owns one generator_t and one block of L/R/PCM buffers,
+ * pulls the next job from a shared index and streams <out.wav> plus the
+ * binary timeline sidecar <out.wav>.tl that generate_frames maps
+ * (--json also writes the <out.wav>.json debug export).
+ *
+ * Usage: seed_farm [-j threads] [-o outdir] [--json] <list.txt|->
+ *   list lines: "<seed> [out.wav]"  ('#' comments and blank lines skipped)
+ */
+#include "wav_writer.h"
+#include "generator.h"
+#include "timeline_export.h"
+#include "pcm16.h"
+#include "seed.h"
+#include "buf_alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define FARM_MAX_SEG_FRAMES 424000 /* matches segment.c */
+#define FARM_BLOCK 4096            /* frames rendered per append */
+#define FARM_PATH_MAX 512
+
+typedef struct {
+    uint64_t seed;
+    char path[FARM_PATH_MAX];
+    int ok;
+} farm_job_t;
+
+typedef struct {
+    farm_job_t *jobs;
+    uint32_t count;
+    uint32_t next;          /* next job index, guarded by lock */
+    uint32_t rejected;      /* list lines never queued: bad seed, path too long */
+    pthread_mutex_t lock;
+} farm_queue_t;
+
+typedef struct {
+    farm_queue_t *q;
+    int json;               /* also write the JSON debug sidecar */
+    generator_t *g;
+    float32_t *L, *R;
+    int16_t *pcm;
+} farm_worker_t;
+
+static farm_job_t *farm_next_job(farm_queue_t *q)
+{
+    farm_job_t *job = NULL;
+    pthread_mutex_lock(&q->lock);
+    if (q->next < q->count) job = &q->jobs[q->next++];
+    pthread_mutex_unlock(&q->lock);
+    return job;
+}
+
+static void farm_render(farm_worker_t *w, farm_job_t *job)
+{
+    /* Sidecar first: it only needs the seed plan */
+    generator_plan_t plan;
+    char side_path[FARM_PATH_MAX + 8];
+    snprintf(side_path, sizeof side_path, "%s.tl", job->path);
+    int side = generator_plan(job->seed, &plan) == 0 ? timeline_export_bin(&plan, side_path) : -1;
+    if (side == 0 && w->json) {
+        snprintf(side_path, sizeof side_path, "%s.json", job->path);
+        side = timeline_export_json(&plan, side_path);
+    }
+    generator_plan_free(&plan);
+    if (side != 0) return;
+
+    generator_t *g = w->g;
+    generator_init(g, job->seed);
+
+    generator_reserve_scratch(g, FARM_BLOCK);
+    uint32_t total_frames = g->mt.seg_frames;
+    if (total_frames > FARM_MAX_SEG_FRAMES) total_frames = FARM_MAX_SEG_FRAMES;
+
+    wav_stream_t wav;
+    int rc = wav_stream_open(&wav, job->path, 2, SR);
+    for (uint32_t done = 0; rc == 0 && done < total_frames; ) {
+        uint32_t n = total_frames - done < FARM_BLOCK ? total_frames - done : FARM_BLOCK;
+        generator_process(g, w->L, w->R, n);
+        pcm16_interleave(w->L, w->R, w->pcm, n);
+        rc = wav_stream_append(&wav, w->pcm, n);
+        done += n;
+    }
+    if (wav.f && wav_stream_close(&wav) != 0) rc = -1;
+    generator_free(g);
+    job->ok = rc == 0;
+}
+
+static void *farm_worker_main(void *arg)
+{
+    farm_worker_t *w = (farm_worker_t *)arg;
+    farm_job_t *job;
+    while ((job = farm_next_job(w->q)) != NULL) {
+        farm_render(w, job);
+    }
+    return NULL;
+}
+
+/* Queue the list's seeds; the ones that can't be rendered are reported
+   and counted in q->rejected.  0, or -1 out of memory. */
+static int farm_load_jobs(FILE *list, const char *outdir, farm_queue_t *q)
+{
+    uint32_t cap = 64;
+    q->jobs = malloc(cap * sizeof(farm_job_t));
+    if (!q->jobs) return -1;
+
+    char line[FARM_PATH_MAX + 128];
+    while (fgets(line, sizeof line, list)) {
+        char seed_str[128], name[FARM_PATH_MAX];
+        int n = sscanf(line, "%127s %511s", seed_str, name);
+        if (n < 1 || seed_str[0] == '#') continue;
+
+        ndb_seed_t s;
+        if (ndb_seed_parse(seed_str, &s) != 0) {
+            fprintf(stderr, "seed_farm: bad seed '%s'\n", seed_str);
+            q->rejected++;
+            continue;
+        }
+        uint64_t seed = s.audio;
+        if (n < 2)
+            snprintf(name, sizeof name, "seed_0x%llx.wav", (unsigned long long)seed);
+        char path[FARM_PATH_MAX];
+        int len = outdir && name[0] != '/' ? snprintf(path, sizeof path, "%s/%s", outdir, name)
+                                           : snprintf(path, sizeof path, "%s", name);
+        if (len < 0 || (size_t)len >= sizeof path) {
+            fprintf(stderr, "seed_farm: output path for '%s' is longer than %d bytes\n", seed_str, FARM_PATH_MAX - 1);
+            q->rejected++;
+            continue;
+        }
+        if (q->count == cap) {
+            cap *= 2;
+            farm_job_t *grown = realloc(q->jobs, cap * sizeof(farm_job_t));
+            if (!grown) return -1;
+            q->jobs = grown;
+        }
+        farm_job_t *job = &q->jobs[q->count++];
+        job->seed = seed;
+        job->ok = 0;
+        memcpy(job->path, path, (size_t)len + 1);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *outdir = NULL;
+    const char *list_path = NULL;
+    int json = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outdir = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else {
+            list_path = argv[i];
+        }
+    }
+    if (!list_path) {
+        fprintf(stderr, "Usage: %s [-j threads] [-o outdir] [--json] <list.txt|->\n", argv[0]);
+        return 1;
+    }
+    if (threads < 1) threads = 1;
+
+    FILE *list = strcmp(list_path, "-") == 0 ? stdin : fopen(list_path, "r");
+    if (!list) { perror(list_path); return 1; }
+
+    farm_queue_t q = {0};
+    pthread_mutex_init(&q.lock, NULL);
+    int rc = farm_load_jobs(list, outdir, &q);
+    if (list != stdin) fclose(list);
+    if (rc != 0) { fprintf(stderr, "seed_farm: out of memory\n"); return 1; }
+    if ((uint32_t)threads > q.count) threads = q.count ? (long)q.count : 1;
+
+    farm_worker_t *workers = calloc((size_t)threads, sizeof(farm_worker_t));
+    pthread_t *tids = calloc((size_t)threads, sizeof(pthread_t));
+    if (!workers || !tids) { fprintf(stderr, "seed_farm: out of memory\n"); return 1; }
+
+    /* Per-worker state lives on the heap; the delay line is per seed */
+    long started = 0;
+    for (long t = 0; t < threads; t++) {
+        farm_worker_t *w = &workers[t];
+        w->q   = &q;
+        w->json = json;
+        w->g   = buf_alloc(_Alignof(generator_t), sizeof(generator_t), 0);
+        w->L   = buf_alloc(0, FARM_BLOCK * sizeof(float32_t), 0);
+        w->R   = buf_alloc(0, FARM_BLOCK * sizeof(float32_t), 0);
+        w->pcm = buf_alloc(0, FARM_BLOCK * 2 * sizeof(int16_t), 0);
+        if (!w->g || !w->L || !w->R || !w->pcm) {
+            fprintf(stderr, "seed_farm: out of memory for worker %ld\n", t);
+            break;
+        }
+        if (pthread_create(&tids[t], NULL, farm_worker_main, w) != 0) {
+            fprintf(stderr, "seed_farm: failed to start worker %ld\n", t);
+            break;
+        }
+        started++;
+    }
+    for (long t = 0; t < started; t++) pthread_join(tids[t], NULL);
+
+    uint32_t ok = 0;
+    for (uint32_t i = 0; i < q.count; i++) {
+        if (q.jobs[i].ok) ok++;
+        else fprintf(stderr, "seed_farm: failed 0x%llx -> %s\n",
+                     (unsigned long long)q.jobs[i].seed, q.jobs[i].path);
+    }
+    fprintf(stderr, "seed_farm: rendered %u/%u seeds on %ld threads (%u rejected)\n",
+            ok, q.count, started, q.rejected);
+
+    for (long t = 0; t < threads; t++) {
+        buf_free(workers[t].g); buf_free(workers[t].L); buf_free(workers[t].R); buf_free(workers[t].pcm);
+    }
+    free(workers); free(tids); free(q.jobs);
+    pthread_mutex_destroy(&q.lock);
+    return ok == q.count && q.rejected == 0 ? 0 : 1;
+}
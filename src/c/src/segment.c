@@ -1,60 +1,350 @@
 #include "wav_writer.h"
 #include "generator.h"
+#include "track_render.h"
+#include "prof.h"
+#include "digest.h"
+#include "seed.h"
+#include "cpu_dispatch.h"
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <string.h>
 
-/* extern counter defined in generator_step.c */
-extern int g_mid_trigger_count;
+/* --digest: the PCM exactly as it goes into the WAV data chunk */
+static int digest_tap(void *ctx, const int16_t *samples, uint32_t frames, uint16_t channels)
+{
+    digest_update((digest_t *)ctx, samples, (size_t)frames * channels * sizeof(int16_t));
+    return 0;
+}
+
+static void report(const char *path, const char *digest_path, const track_info_t *info, uint64_t total)
+{
+    if(path)
+        printf("Wrote %s (%u frames, loop %u frames, %.2f bpm, root %.2f Hz)\n", path, info->total_frames,
+               info->seg_frames, info->bpm, info->root_freq);
+    if(digest_path)
+        printf("Digest %s: %u frames, xxh64 %016" PRIx64 "\n", digest_path, info->total_frames, total);
+    if(info->loop_end)
+        printf("loop_start=%u loop_end=%u\n", info->loop_start, info->loop_end);
+    if(info->tail_frames)
+        printf("tail=%u frames\n", info->tail_frames);
+}
 
-#define MAX_SEG_FRAMES 424000 
-static float L[MAX_SEG_FRAMES], R[MAX_SEG_FRAMES];
-static int16_t pcm[MAX_SEG_FRAMES * 2];
+/* WAV rate for opt->rate_div (--draft): the generator renders SR / rate_div */
+static uint32_t out_rate(const track_opts_t *opt)
+{
+    return SR / (opt->rate_div ? opt->rate_div : 1);
+}
+
+/* --stems: "out.wav" -> "out.<stem>.wav" */
+static void stem_path(char *dst, size_t size, const char *path, const char *stem)
+{
+    size_t n = strlen(path);
+    if(n >= 4 && strcmp(path + n - 4, ".wav") == 0) n -= 4;
+    snprintf(dst, size, "%.*s.%s.wav", (int)n, path, stem);
+}
 
-/* Fallback scalar RMS when assembly version not linked */
-#ifndef GENERATOR_RMS_ASM_PRESENT
-float generator_compute_rms_asm(const float *L, const float *R, uint32_t num_frames)
+/* Render one seed into `path` (see track_render for the modes).  With a
+   `digest_path` the PCM is also hashed into that manifest, one part per
+   second of audio; a NULL `path` then writes no WAV at all.  `stems`
+   writes the voice groups next to `path` from the same pass. */
+static int render_seed(uint64_t seed, const char *path, const char *digest_path, int stems,
+                       const track_opts_t *opt)
 {
-    double sum = 0.0;
-    for(uint32_t i=0;i<num_frames;i++){
-        double sL = L[i];
-        double sR = R[i];
-        sum += sL*sL + sR*sR;
+    uint32_t rate = out_rate(opt);
+    wav_stream_t wav;
+    if(path ? wav_stream_open(&wav, path, 2, rate) != 0 : wav_stream_open_null(&wav, 2, rate) != 0)
+        return -1;
+    wav_stream_t stem_wav[GEN_STEMS];
+    wav_stream_t *stem_ptr[GEN_STEMS];
+    uint32_t opened = 0;
+    for(; stems && opened < GEN_STEMS; opened++){
+        char name[600];
+        stem_path(name, sizeof name, path, generator_stem_names[opened]);
+        if(wav_stream_open(&stem_wav[opened], name, 2, rate) != 0) break;
+        stem_ptr[opened] = &stem_wav[opened];
+    }
+    if(stems && opened < GEN_STEMS){
+        while(opened) wav_stream_close(&stem_wav[--opened]);
+        wav_stream_close(&wav);
+        return -1;
+    }
+    digest_t digest;
+    if(digest_path){
+        char header[64];
+        snprintf(header, sizeof header, "audio %u 2", (unsigned)rate);
+        if(digest_open(&digest, digest_path, header, 'a', 0, (uint64_t)rate * 2 * sizeof(int16_t)) != 0){
+            while(opened) wav_stream_close(&stem_wav[--opened]);
+            wav_stream_close(&wav);
+            return -1;
+        }
+        wav.tap = digest_tap;
+        wav.tap_ctx = &digest;
     }
-    return (float)sqrt(sum / (double)(2*num_frames));
+    track_info_t info;
+    int rc = stems ? track_render_stems(seed, &wav, stem_ptr, opt, &info) : track_render(seed, &wav, opt, &info);
+    while(opened)
+        if(wav_stream_close(&stem_wav[--opened]) != 0) rc = -1;
+    if(wav_stream_close(&wav) != 0) rc = -1;
+    uint64_t total = 0;
+    if(digest_path && digest_close(&digest, &total) != 0) rc = -1;
+
+    if(rc == 0) report(path, digest_path, &info, total);
+    return rc;
+}
+
+/* --lanes: the seeds in `paths` side by side (track_render_lanes); a WAV
+   that fails to open is counted and the rest still render */
+static void render_group(const uint64_t *seeds, char (*paths)[384], uint32_t n, const track_opts_t *opt,
+                         int *rendered, int *failed)
+{
+    wav_stream_t wav[GEN_LANES];
+    wav_stream_t *wavs[GEN_LANES];
+    uint64_t lane_seed[GEN_LANES];
+    const char *lane_path[GEN_LANES];
+    uint32_t lanes = 0;
+    for(uint32_t i = 0; i < n; i++){
+        if(wav_stream_open(&wav[lanes], paths[i], 2, out_rate(opt)) != 0){
+            (*failed)++;
+            continue;
+        }
+        wavs[lanes] = &wav[lanes];
+        lane_seed[lanes] = seeds[i];
+        lane_path[lanes] = paths[i];
+        lanes++;
+    }
+    if(!lanes) return;
+
+    track_info_t info[GEN_LANES];
+    int rc[GEN_LANES];
+    track_render_lanes(lane_seed, wavs, lanes, opt, info, rc);
+    for(uint32_t l = 0; l < lanes; l++){
+        if(wav_stream_close(wavs[l]) != 0) rc[l] = -1;
+        if(rc[l] != 0){
+            (*failed)++;
+            continue;
+        }
+        report(lane_path[l], NULL, &info[l], 0);
+        (*rendered)++;
+    }
+}
+
+/* Batch mode: each line of `list` is "<seed> [out.wav]".
+   Blank lines and lines starting with '#' are skipped; a missing path
+   falls back to the single-seed default name.  With lanes > 1 the seeds
+   render `lanes` at a time in lockstep (same bytes as one by one). */
+static int run_batch(FILE *list, const track_opts_t *opt, uint32_t lanes)
+{
+    char line[512];
+    int rendered = 0, failed = 0;
+    uint64_t group_seed[GEN_LANES];
+    char group_path[GEN_LANES][384];
+    uint32_t grouped = 0;
+    while(fgets(line, sizeof line, list)){
+        char seed_str[128], path[384];
+        int n = sscanf(line, "%127s %383s", seed_str, path);
+        if(n < 1 || seed_str[0] == '#') continue;
+
+        ndb_seed_t s;
+        if(ndb_seed_parse(seed_str, &s) != 0){
+            fprintf(stderr, "segment: bad seed '%s'\n", seed_str);
+            failed++;
+            continue;
+        }
+        if(n < 2)
+            snprintf(path, sizeof path, "seed_0x%llx.wav", (unsigned long long)s.audio);
+
+        if(lanes > 1){
+            group_seed[grouped] = s.audio;
+            memcpy(group_path[grouped], path, sizeof path);
+            if(++grouped == lanes){
+                render_group(group_seed, group_path, grouped, opt, &rendered, &failed);
+                grouped = 0;
+            }
+            continue;
+        }
+        if(render_seed(s.audio, path, NULL, 0, opt) != 0){
+            failed++;
+            continue;
+        }
+        rendered++;
+    }
+    if(grouped) render_group(group_seed, group_path, grouped, opt, &rendered, &failed);
+    fprintf(stderr, "segment: batch rendered %d seeds (%d failed)\n", rendered, failed);
+    return failed ? 1 : 0;
 }
-#endif
 
 int main(int argc, char **argv)
 {
-    uint64_t seed = 0xCAFEBABEULL;
-    if(argc > 1) {
-        seed = strtoull(argv[1], NULL, 0);
+    /* segment [--limit] [--euclid] [--noise v1|v2] [--repeat N | --bars N [--arrange]] [--kernels ISA] [--profile out.json|out.csv] [--digest out.txt] [--draft 2|4] [--fm-pool] [--tail] [--stems] [--verbose] <seed> [out.wav]
+       segment [--limit] [--euclid] [--noise v1|v2] [--repeat N | --bars N [--arrange]] [--kernels ISA] [--profile ...] [--draft 2|4] [--fm-pool] [--tail] [--lanes N] --batch <list|->
+       --arrange plays the --bars as seed-derived sections (intro, fills,
+       breakdowns) instead of one looped pattern; --euclid spreads the
+       seed's kick/snare/hat counts as Euclidean rhythms; --noise v2 takes
+       the snare/hat noise from the four-lane engine (a different, pinned
+       sequence: default v1, every existing render's); --digest writes
+       the PCM's digest manifest (digest.h), and no WAV unless out.wav is given;
+       --kernels caps the run-time kernel pick (cpu_dispatch.h: scalar,
+       sse2, sse4.2, avx2, avx512, neon, sve, sve2 or auto); --verbose
+       adds the RMS and trigger-count diagnostics (per-event logs are a
+       TRACE=1 build, see trace.h); --lanes renders the batch N seeds at a
+       time (1..4), one seed per SIMD lane in the melody and FM voices;
+       --draft 2 or 4 renders a QA preview at 22.05 or 11.025 kHz, every
+       event still on the full-rate schedule (generator_init_rate);
+       --fm-pool plays the mid and bass FM parts on four-voice pools, so a
+       note rings on under the next instead of being restarted;
+       --tail ends the track on the last note's natural end instead of
+       cutting it at the loop length (the file grows by the ring-out);
+       --stems also writes out.drums/.melody/.mid/.bass.wav from the same
+       pass (generator_process_stems; they sum to out.wav, no --limit) */
+    int limit = 0, arrange = 0, euclid = 0, noise_v2 = 0, fm_pool = 0, tail = 0, stems = 0, verbose = 0;
+    const char *profile = NULL, *digest = NULL;
+    uint32_t repeat = 1, bars = 0, lanes = 1, rate_div = 1;
+    const char *batch = NULL;
+    const char *pos[2] = {NULL, NULL};
+    int npos = 0;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--limit") == 0){
+            limit = 1;
+        } else if(strcmp(argv[i], "--repeat") == 0 && i + 1 < argc){
+            long r = strtol(argv[++i], NULL, 10);
+            if(r < 1 || r > 64){
+                fprintf(stderr, "segment: --repeat must be 1..64\n");
+                return 1;
+            }
+            repeat = (uint32_t)r;
+        } else if(strcmp(argv[i], "--bars") == 0 && i + 1 < argc){
+            long b = strtol(argv[++i], NULL, 10);
+            if(b < 1 || b > 256){
+                fprintf(stderr, "segment: --bars must be 1..256\n");
+                return 1;
+            }
+            bars = (uint32_t)b;
+        } else if(strcmp(argv[i], "--arrange") == 0){
+            arrange = 1;
+        } else if(strcmp(argv[i], "--euclid") == 0){
+            euclid = 1;
+        } else if(strcmp(argv[i], "--noise") == 0 && i + 1 < argc){
+            const char *v = argv[++i];
+            if(strcmp(v, "v1") == 0) noise_v2 = 0;
+            else if(strcmp(v, "v2") == 0) noise_v2 = 1;
+            else {
+                fprintf(stderr, "segment: --noise must be v1 or v2\n");
+                return 1;
+            }
+        } else if(strcmp(argv[i], "--kernels") == 0 && i + 1 < argc){
+            if(cpu_isa_set(argv[++i]) != 0){
+                fprintf(stderr, "segment: --kernels %s: unknown, or not supported by this CPU\n", argv[i]);
+                return 1;
+            }
+        } else if(strcmp(argv[i], "--profile") == 0 && i + 1 < argc){
+            profile = argv[++i];
+        } else if(strcmp(argv[i], "--digest") == 0 && i + 1 < argc){
+            digest = argv[++i];
+        } else if(strcmp(argv[i], "--lanes") == 0 && i + 1 < argc){
+            long n = strtol(argv[++i], NULL, 10);
+            if(n < 1 || n > GEN_LANES){
+                fprintf(stderr, "segment: --lanes must be 1..%d\n", GEN_LANES);
+                return 1;
+            }
+            lanes = (uint32_t)n;
+        } else if(strcmp(argv[i], "--draft") == 0 && i + 1 < argc){
+            long d = strtol(argv[++i], NULL, 10);
+            if(d != 1 && d != 2 && d != GEN_RATE_DIV_MAX){
+                fprintf(stderr, "segment: --draft must be 2 (22.05 kHz) or 4 (11.025 kHz)\n");
+                return 1;
+            }
+#ifdef GENERATOR_ASM
+            if(d != 1){
+                fprintf(stderr, "segment: --draft needs the C generator (generator.s renders at %u Hz)\n", SR);
+                return 1;
+            }
+#endif
+            rate_div = (uint32_t)d;
+        } else if(strcmp(argv[i], "--fm-pool") == 0){
+#ifdef GENERATOR_ASM
+            fprintf(stderr, "segment: --fm-pool needs the C generator (generator.s has one voice per FM part)\n");
+            return 1;
+#endif
+            fm_pool = 1;
+        } else if(strcmp(argv[i], "--tail") == 0){
+#ifdef GENERATOR_ASM
+            fprintf(stderr, "segment: --tail needs the C generator (generator.s cannot hold its events)\n");
+            return 1;
+#endif
+            tail = 1;
+        } else if(strcmp(argv[i], "--stems") == 0){
+#ifdef GENERATOR_ASM
+            fprintf(stderr, "segment: --stems needs the C generator (generator.s mixes its buses internally)\n");
+            return 1;
+#endif
+            stems = 1;
+        } else if(strcmp(argv[i], "--verbose") == 0){
+            verbose = 1;
+        } else if(strcmp(argv[i], "--batch") == 0){
+            if(i + 1 >= argc){
+                fprintf(stderr, "Usage: %s [--limit] --batch <list.txt|->\n", argv[0]);
+                return 1;
+            }
+            batch = argv[++i];
+        } else if(npos < 2){
+            pos[npos++] = argv[i];
+        }
     }
-    
-    generator_t g;
-    generator_init(&g, seed);
 
-    uint32_t total_frames = g.mt.seg_frames;
-    if(total_frames > MAX_SEG_FRAMES) total_frames = MAX_SEG_FRAMES;
+    if(arrange && !bars){
+        fprintf(stderr, "segment: --arrange needs --bars\n");
+        return 1;
+    }
+    track_opts_t opt = { limit, repeat, bars, arrange, euclid, noise_v2, 0, rate_div, fm_pool, tail };
 
-    printf("C-DBG before gen_process: step_samples=%u addr=%p\n", g.mt.step_samples, &g.mt.step_samples);
-    generator_process(&g, L, R, total_frames);
-    
-    /* RMS diagnostic to verify audio energy */
-    float rms = generator_compute_rms_asm(L, R, total_frames);
-    printf("C-POST rms=%f\n", rms);
-    printf("DEBUG: MID triggers fired = %d\n", g_mid_trigger_count);
+    if(profile){
+#ifndef PROF_ENABLE
+        fprintf(stderr, "segment: built without PROF=1, --profile records nothing\n");
+#endif
+        prof_start(profile);
+    }
 
-    for(uint32_t i=0;i<total_frames;i++){
-        pcm[2*i]   = (int16_t)(L[i]*32767);
-        pcm[2*i+1] = (int16_t)(R[i]*32767);
+    if(stems && (limit || batch || (digest && !pos[1]))){
+        fprintf(stderr, "segment: --stems takes a single seed and an out.wav, without --limit\n");
+        return 1;
+    }
+    if(lanes > 1 && !batch){
+        fprintf(stderr, "segment: --lanes needs --batch\n");
+        return 1;
+    }
+    if(batch) {
+        if(digest){
+            fprintf(stderr, "segment: --digest takes a single seed, not --batch\n");
+            return 1;
+        }
+        FILE *list = strcmp(batch, "-") == 0 ? stdin : fopen(batch, "r");
+        if(!list) { perror(batch); return 1; }
+        int rc = run_batch(list, &opt, lanes);
+        if(list != stdin) fclose(list);
+        if(prof_finish() != 0) rc = 1;
+        return rc;
     }
 
-    char wavname[128];  // Increased buffer for long transaction hashes
-    sprintf(wavname, "seed_0x%llx.wav", (unsigned long long)seed);
-    write_wav(wavname, pcm, total_frames, 2, SR);
-    printf("Wrote %s (%u frames, %.2f bpm, root %.2f Hz)\n", wavname, total_frames, g.mt.bpm, g.music.root_freq);
+    ndb_seed_t s;
+    ndb_seed_from_u64(0xCAFEBABEULL, &s);
+    if(pos[0] && ndb_seed_parse(pos[0], &s) != 0) {
+        fprintf(stderr, "segment: bad seed '%s'\n", pos[0]);
+        return 1;
+    }
+    uint64_t seed = s.audio;
 
-    return 0;
-} 
\ No newline at end of file
+    char wavname[512];  // Increased buffer for long transaction hashes / caller paths
+    const char *wav_path = wavname;
+    if(digest && !pos[1]) {
+        wav_path = NULL;
+    } else if(pos[1]) {
+        snprintf(wavname, sizeof wavname, "%s", pos[1]);
+    } else {
+        sprintf(wavname, "seed_0x%llx.wav", (unsigned long long)seed);
+    }
+    opt.verbose = verbose;
+    int rc = render_seed(seed, wav_path, digest, stems, &opt) == 0 ? 0 : 1;
+    if(prof_finish() != 0) rc = 1;
+    return rc;
+}
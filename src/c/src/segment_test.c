@@ -1,5 +1,6 @@
 #include "generator.h"
 #include "wav_writer.h"
+#include "seed.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,7 +32,12 @@ int main(int argc, char **argv)
         else if (strcmp(argv[i], "limiter") == 0) enable_limiter = true;
         else if (argv[i][0] == '0' && (argv[i][1] == 'x' || argv[i][1] == 'X')) {
             // Parse hex seed
-            seed = strtoull(argv[i], NULL, 0);
+            ndb_seed_t s;
+            if (ndb_seed_parse(argv[i], &s) != 0) {
+                printf("Invalid seed: %s\n", argv[i]);
+                return 1;
+            }
+            seed = s.audio;
         }
         else {
             printf("Unknown category or invalid seed: %s\n", argv[i]);
@@ -1,10 +1,10 @@
 #include "shapes.h"
-#include "raster.h"
 #include <math.h>
 #include <stdlib.h>
 
 static bass_shape_t g_shapes[MAX_SHAPES];
 static int g_count = 0;
+_Static_assert(RT_DL_MAX_VERTS >= MAX_SHAPES * 10, "every live outline fits the display list");
 
 void shapes_init(void) { g_count = 0; }
 
@@ -20,17 +20,32 @@ void shapes_spawn(shape_type_t type, uint32_t color)
     s->color = color;
 }
 
-static void rotate_point(float *x, float *y, float cx, float cy, float angle)
+/* Rotate about (cx, cy) by the angle whose cosine/sine are (c, s) */
+static void rotate_point(float *x, float *y, float cx, float cy, float c, float s)
 {
     float dx = *x - cx;
     float dy = *y - cy;
-    float rx = dx * cosf(angle) - dy * sinf(angle);
-    float ry = dx * sinf(angle) + dy * cosf(angle);
+    float rx = dx * c - dy * s;
+    float ry = dx * s + dy * c;
     *x = cx + rx;
     *y = cy + ry;
 }
 
-void shapes_update_and_draw(uint32_t *fb, int w, int h)
+/* n vertices at radius r[j & 1] around (cx, cy), starting at the angle
+ * (c, s) and stepping by (cs, ss): one complex multiply per vertex */
+static void regular_points(int *vx, int *vy, int n, int cx, int cy, const float r[2],
+                           float c, float s, float cs, float ss)
+{
+    for(int j=0; j<n; j++){
+        vx[j] = cx + (int)(r[j & 1] * c);
+        vy[j] = cy + (int)(r[j & 1] * s);
+        float nc = c * cs - s * ss;
+        s = c * ss + s * cs;
+        c = nc;
+    }
+}
+
+void shapes_update(int w, int h, rt_dlist_t *dl)
 {
     int cx = w/2;
     int cy = h/2;
@@ -64,17 +79,14 @@ void shapes_update_and_draw(uint32_t *fb, int w, int h)
         
         int vx[10], vy[10];
         int n = 0;
+        /* One sin/cos pair per shape; vertices step by constant angles */
+        float rc = cosf(s->rotation), rs = sinf(s->rotation);
         
         switch(s->type){
         case SHAPE_TRIANGLE:
             n = 3;
-            for(int j=0; j<3; j++){
-                float angle = s->rotation + j * 2.0f * M_PI / 3.0f;
-                float x = cx + size * 0.8f * cosf(angle);
-                float y = cy + size * 0.8f * sinf(angle);
-                vx[j] = (int)x;
-                vy[j] = (int)y;
-            }
+            regular_points(vx, vy, 3, cx, cy, (const float[2]){ size*0.8f, size*0.8f },
+                           rc, rs, -0.5f, 0.86602540f);
             break;
             
         case SHAPE_DIAMOND:
@@ -85,28 +97,21 @@ void shapes_update_and_draw(uint32_t *fb, int w, int h)
             vx[3] = cx - (int)(size*0.6f); vy[3] = cy;
             for(int j=0; j<4; j++){
                 float x = vx[j], y = vy[j];
-                rotate_point(&x, &y, cx, cy, s->rotation);
+                rotate_point(&x, &y, cx, cy, rc, rs);
                 vx[j] = (int)x; vy[j] = (int)y;
             }
             break;
             
         case SHAPE_HEXAGON:
             n = 6;
-            for(int j=0; j<6; j++){
-                float angle = s->rotation + j * M_PI / 3.0f;
-                vx[j] = cx + (int)(size * 0.7f * cosf(angle));
-                vy[j] = cy + (int)(size * 0.7f * sinf(angle));
-            }
+            regular_points(vx, vy, 6, cx, cy, (const float[2]){ size*0.7f, size*0.7f },
+                           rc, rs, 0.5f, 0.86602540f);
             break;
             
         case SHAPE_STAR:
             n = 10;
-            for(int j=0; j<10; j++){
-                float angle = s->rotation + j * M_PI / 5.0f;
-                float r = (j%2==0) ? size*0.8f : size*0.4f;
-                vx[j] = cx + (int)(r * cosf(angle));
-                vy[j] = cy + (int)(r * sinf(angle));
-            }
+            regular_points(vx, vy, 10, cx, cy, (const float[2]){ size*0.8f, size*0.4f },
+                           rc, rs, 0.80901699f, 0.58778525f);
             break;
             
         case SHAPE_SQUARE:
@@ -118,14 +123,14 @@ void shapes_update_and_draw(uint32_t *fb, int w, int h)
             vx[3] = cx - (int)half; vy[3] = cy + (int)half;
             for(int j=0; j<4; j++){
                 float x = vx[j], y = vy[j];
-                rotate_point(&x, &y, cx, cy, s->rotation);
+                rotate_point(&x, &y, cx, cy, rc, rs);
                 vx[j] = (int)x; vy[j] = (int)y;
             }
             break;
         }
         
         /* draw outline only (thickness 3) */
-        raster_poly(fb, w, h, vx, vy, n, col, false, 3);
+        rt_dl_outline(dl, vx, vy, n, col, 3);
         
         ++i;
     }
@@ -1,6 +1,13 @@
 #include "simple_voice.h"
 #include <math.h>
 #include "env.h"
+#include "simd4.h"
+
+#ifdef __clang__
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+#endif
 
 #define TAU 6.2831853071795864769f
 
@@ -45,34 +52,57 @@ static inline float32_t render_sample(simple_voice_t *v)
     return s;
 }
 
+/* Four samples per iteration: the phase accumulator stays serial (same
+   add + wrap as the scalar loop), while the waveform and
+   the exp(-decay*t) envelope run on simd4 vectors.  The envelope is derived
+   from the absolute sample position, not a running product, so output does
+   not depend on how the caller slices blocks. */
 void simple_voice_process(simple_voice_t *v, float32_t *L, float32_t *R, uint32_t n)
 {
     if(v->pos >= v->len) return;
+    uint32_t left = v->len - v->pos;
+    if(n > left) n = left;
+
     float32_t phase = v->osc.phase;
     float32_t inc = TAU * v->freq / v->sr;
-    for(uint32_t i=0;i<n;++i){
-        if(v->pos >= v->len) break;
-        float32_t t = (float32_t)v->pos / v->sr;
-        float32_t env = env_exp_decay(t, v->decay);
-        float32_t sample;
-        float32_t frac = phase / TAU;
+    const v4f tau = v4_set1(TAU), two = v4_set1(2.0f), one = v4_set1(1.0f);
+    const v4f half = v4_set1(0.5f), neg = v4_set1(-1.0f);
+    const v4f sr = v4_set1(v->sr), ndecay = v4_set1(-v->decay), amp = v4_set1(v->amp);
+
+    for(uint32_t i=0;i<n;i+=4){
+        uint32_t lanes = n - i < 4 ? n - i : 4;
+        float ph[4] = {0.0f, 0.0f, 0.0f, 0.0f}, pos[4];
+        for(uint32_t k=0;k<4;++k){
+            pos[k] = (float32_t)(v->pos + i + k);
+            if(k < lanes){
+                ph[k] = phase;
+                phase += inc;
+                if(phase>=TAU) phase -= TAU;
+            }
+        }
+        v4f p = v4_load(ph);
+        v4f frac = v4_div(p, tau);
+        v4f t = v4_div(v4_load(pos), sr);
+        v4f env = v4_exp(v4_mul(ndecay, t));
+        v4f sample;
         switch(v->wave){
             case SIMPLE_TRI:
-                sample = (2.0f * fabsf(2.0f * frac - 1.0f) - 1.0f);
+                sample = v4_sub(v4_mul(two, v4_abs(v4_sub(v4_mul(two, frac), one))), one);
                 break;
             case SIMPLE_SQUARE:
-                sample = (frac < 0.5f)?1.0f:-1.0f;
+                sample = v4_select(v4_lt(frac, half), one, neg);
                 break;
             default:
-                sample = sinf(phase);
+                sample = v4_sin(p);
                 break;
         }
-        sample *= env * v->amp;
-        L[i]+=sample;
-        R[i]+=sample;
-        phase += inc;
-        if(phase>=TAU) phase -= TAU;
-        v->pos++;
+        float out[4];
+        v4_store(out, v4_mul(sample, v4_mul(env, amp)));
+        for(uint32_t k=0;k<lanes;++k){
+            L[i+k]+=out[k];
+            R[i+k]+=out[k];
+        }
     }
+    v->pos += n;
     v->osc.phase = phase;
-} 
\ No newline at end of file
+}
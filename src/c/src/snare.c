@@ -1,10 +1,22 @@
 #include "snare.h"
+#include "music_time.h"
 #include <math.h>
 
+#ifdef __clang__
+#ifdef __clang__
+#pragma STDC FP_CONTRACT OFF
+#endif
+#endif
+
 #define SNARE_DECAY_RATE 35.0f
-#define SNARE_DUR_SEC 0.1f
+#define SNARE_AMP 0.4f
 
 void snare_init(snare_t *s, float32_t sr, uint64_t seed)
+{
+    snare_init_noise(s, sr, seed, NOISE_V1);
+}
+
+void snare_init_noise(snare_t *s, float32_t sr, uint64_t seed, uint32_t version)
 {
     s->len = 0;
     s->pos = 0;
@@ -12,6 +24,8 @@ void snare_init(snare_t *s, float32_t sr, uint64_t seed)
     s->env = 0.0f;
     s->env_coef = 0.0f;
     s->rng = rng_seed(seed);
+    s->noise_version = version;
+    noise4_seed(&s->noise4, seed);
 }
 
 void snare_trigger(snare_t *s)
@@ -20,6 +34,35 @@ void snare_trigger(snare_t *s)
     s->len = (uint32_t)(SNARE_DUR_SEC * s->sr);
     s->env = 1.0f;
     s->env_coef = expf(-SNARE_DECAY_RATE / s->sr);
+    if(s->noise_version == NOISE_V2) noise4_start(&s->noise4, s->env, s->env_coef);
+}
+
+/* Noise v2: the same burst from the four-lane engine (noise4.h) */
+void snare_process_v2(snare_t *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    if(s->pos >= s->len || n == 0) return;
+    uint32_t m = s->len - s->pos;
+    if(m > n) m = n;
+    noise4_decay_add(&s->noise4, L, R, m, SNARE_AMP);
+    s->pos += m;
 }
 
-/* NO snare_process - ASM implementation required */
+#ifndef SNARE_ASM
+/* Portable port of snare.s: envelope recurrence + SplitMix64 noise. */
+void snare_process(snare_t *s, float32_t *L, float32_t *R, uint32_t n)
+{
+    uint32_t pos = s->pos;
+    if(pos >= s->len || n == 0) return;
+
+    float32_t env = s->env;
+    const float32_t coef = s->env_coef;
+    for(uint32_t i = 0; i < n && pos < s->len; ++i, ++pos){
+        env *= coef;
+        float32_t sample = (rng_float_mono(&s->rng) * env) * SNARE_AMP;
+        L[i] += sample;
+        R[i] += sample;
+    }
+    s->env = env;
+    s->pos = pos;
+}
+#endif /* SNARE_ASM – otherwise src/asm/active/snare.s */
@@ -8,6 +8,7 @@ static uint32_t g_tile_slope_up[TILE_SIZE*TILE_SIZE];
 static uint32_t g_tile_slope_down[TILE_SIZE*TILE_SIZE];
 
 static terrain_tile_t g_pattern[TERRAIN_LEN];
+static int g_max_height;    /* tallest column, in tiles */
 
 /* pack rgb8 + alpha 255 into uint32 */
 static inline uint32_t rgba(uint8_t r,uint8_t g,uint8_t b){ return ((uint32_t)r<<24)|((uint32_t)g<<16)|((uint32_t)b<<8)|0xFF; }
@@ -82,6 +83,15 @@ void terrain_init(uint64_t seed)
             }
         }
     }
+    g_max_height = 0;
+    for(i=0;i<TERRAIN_LEN;i++){
+        if(g_pattern[i].height > g_max_height) g_max_height = g_pattern[i].height;
+    }
+}
+
+int terrain_top(int h)
+{
+    return h - g_max_height*TILE_SIZE;
 }
 
 void terrain_draw(uint32_t *fb,int w,int h,int frame)
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "timeline_export.h"
+#include "music_time.h"
+#include "event_queue.h"
+#include "../../include/timeline.h"   /* on-disk binary layout, shared with the reader */
+
+static const char *event_type_to_string(uint8_t t) {
+    switch ((event_type_t)t) {
+        case EVT_KICK:    return "kick";
+        case EVT_SNARE:   return "snare";
+        case EVT_HAT:     return "hat";
+        case EVT_MELODY:  return "melody";
+        case EVT_MID:     return "mid";
+        case EVT_FM_BASS: return "fm_bass";
+        default:          return "unknown";
+    }
+}
+
+int timeline_export_json(const generator_plan_t *p, const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return -1;
+    }
+
+    // Header
+    fprintf(f, "{\n");
+    fprintf(f, "  \"seed\": \"0x%016" PRIx64 "\",\n", p->seed);
+    fprintf(f, "  \"sample_rate\": %u,\n", SR);
+    fprintf(f, "  \"bpm\": %.6f,\n", p->mt.bpm);
+    fprintf(f, "  \"step_samples\": %u,\n", p->mt.step_samples);
+    fprintf(f, "  \"total_samples\": %u,\n", p->mt.seg_frames);
+    fprintf(f, "  \"loop_samples\": %u,\n", TOTAL_STEPS * p->mt.step_samples);
+    fprintf(f, "  \"tail_samples\": %u,\n", generator_plan_tail(p));
+
+    // Steps array (every 16th note)
+    fprintf(f, "  \"steps\": [");
+    for (uint32_t s = 0; s < TOTAL_STEPS; ++s) {
+        uint32_t t = s * p->mt.step_samples;
+        fprintf(f, "%s%u", (s == 0 ? "" : ","), t);
+    }
+    fprintf(f, "],\n");
+
+    // Beats array (every 4 steps)
+    uint32_t total_beats = TOTAL_STEPS / STEPS_PER_BEAT;
+    fprintf(f, "  \"beats\": [");
+    for (uint32_t b = 0; b < total_beats; ++b) {
+        uint32_t t = (b * STEPS_PER_BEAT) * p->mt.step_samples;
+        fprintf(f, "%s%u", (b == 0 ? "" : ","), t);
+    }
+    fprintf(f, "],\n");
+
+    // Events: the MAIN pattern, the loop every seed plays unarranged
+    const plan_pattern_t *pat = &p->patterns[PLAN_PAT_MAIN];
+    fprintf(f, "  \"events\": [\n");
+    for (uint32_t i = 0; i < pat->count; ++i) {
+        const event_t *ev = &p->q.events[pat->first + i];
+        fprintf(f,
+                "    {\"time\": %u, \"type\": \"%s\", \"aux\": %u}%s\n",
+                ev->time,
+                event_type_to_string(ev->type),
+                (unsigned)ev->aux,
+                (i + 1 < pat->count ? "," : ""));
+    }
+    fprintf(f, "  ]\n");
+
+    fprintf(f, "}\n");
+    fclose(f);
+    return 0;
+}
+
+size_t timeline_export_bin_mem(const generator_plan_t *p, void *buf, size_t cap)
+{
+    const uint32_t total_beats = TOTAL_STEPS / STEPS_PER_BEAT;
+    const plan_pattern_t *pat = &p->patterns[PLAN_PAT_MAIN];
+    size_t need = sizeof(tl_bin_header_t) + (TOTAL_STEPS + total_beats) * sizeof(uint32_t)
+                + (size_t)pat->count * sizeof(tl_event_t);
+    if (!buf || cap < need) return need;
+
+    tl_bin_header_t h = {
+        .magic = TL_BIN_MAGIC, .version = TL_BIN_VERSION,
+        .seed = p->seed, .sample_rate = SR, .bpm = p->mt.bpm,
+        .step_samples = p->mt.step_samples, .total_samples = p->mt.seg_frames,
+        .steps_count = TOTAL_STEPS, .beats_count = total_beats,
+        .events_count = pat->count, .tail_samples = generator_plan_tail(p),
+    };
+    uint8_t *out = (uint8_t *)buf;
+    memcpy(out, &h, sizeof h);
+    uint32_t *grid = (uint32_t *)(out + sizeof h);
+    for (uint32_t s = 0; s < TOTAL_STEPS; ++s)
+        grid[s] = s * p->mt.step_samples;
+    for (uint32_t b = 0; b < total_beats; ++b)
+        grid[TOTAL_STEPS + b] = (b * STEPS_PER_BEAT) * p->mt.step_samples;
+    tl_event_t *events = (tl_event_t *)(grid + TOTAL_STEPS + total_beats);
+    const event_t *ev = p->q.events + pat->first;
+    for (uint32_t i = 0; i < pat->count; ++i)
+        events[i] = (tl_event_t){ ev[i].time, ev[i].type, ev[i].aux, {0, 0} };
+    return need;
+}
+
+int timeline_export_bin(const generator_plan_t *p, const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "Failed to open %s for writing\n", path);
+        return -1;
+    }
+
+    /* Whole file is a few KB: assemble it and write once */
+    size_t len = timeline_export_bin_mem(p, NULL, 0);
+    uint32_t *image = malloc(len);
+    int ok = image && timeline_export_bin_mem(p, image, len) == len && fwrite(image, 1, len, f) == len;
+    free(image);
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
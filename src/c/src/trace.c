@@ -0,0 +1,97 @@
+#include "trace.h"
+#include "prof.h"
+
+/*
+ * Compiled to nothing unless TRACE_LEVEL > 0 (make TRACE=N): release
+ * builds link no ring and no exit hook.
+ */
+#if TRACE_LEVEL > 0
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TRACE_RING (1u << TRACE_RING_BITS)
+
+static trace_rec_t g_ring[TRACE_RING];
+static uint64_t g_head;                 /* records claimed */
+static uint32_t g_threads;
+static __thread uint32_t t_thread;      /* 1-based; 0 before the first record */
+static uint64_t g_ticks0;
+static struct timespec g_time0;
+
+void trace_emit(trace_kind_t kind, uint32_t a0, uint32_t a1, uint32_t a2,
+                uint32_t a3, uint32_t a4, uint32_t a5)
+{
+    if(!t_thread) t_thread = __atomic_add_fetch(&g_threads, 1, __ATOMIC_RELAXED);
+    uint64_t n = __atomic_fetch_add(&g_head, 1, __ATOMIC_RELAXED);
+    trace_rec_t *r = &g_ring[n & (TRACE_RING - 1)];
+    __atomic_store_n(&r->seq, 0, __ATOMIC_RELAXED);
+    r->ticks = prof_ticks();
+    r->kind = (uint16_t)kind;
+    r->thread = (uint16_t)t_thread;
+    r->arg[0] = a0; r->arg[1] = a1; r->arg[2] = a2;
+    r->arg[3] = a3; r->arg[4] = a4; r->arg[5] = a5;
+    __atomic_store_n(&r->seq, (uint32_t)n + 1, __ATOMIC_RELEASE);
+}
+
+/* Counter ticks per second, from the span since startup */
+static uint64_t ticks_per_sec(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double sec = (double)(now.tv_sec - g_time0.tv_sec) + (now.tv_nsec - g_time0.tv_nsec) * 1e-9;
+    uint64_t ticks = prof_ticks() - g_ticks0;
+    return sec > 1e-3 ? (uint64_t)((double)ticks / sec) : 0;
+}
+
+int trace_flush(const char *path)
+{
+    uint64_t head = __atomic_load_n(&g_head, __ATOMIC_ACQUIRE);
+    uint64_t first = head > TRACE_RING ? head - TRACE_RING : 0;
+    FILE *f = fopen(path, "wb");
+    if(!f){
+        perror(path);
+        return -1;
+    }
+    trace_file_hdr_t h;
+    memset(&h, 0, sizeof h);
+    memcpy(h.magic, TRACE_MAGIC, sizeof h.magic);
+    h.version = TRACE_VERSION;
+    h.emitted = head;
+    h.ticks_per_sec = ticks_per_sec();
+    fwrite(&h, sizeof h, 1, f);
+
+    /* Records still being written (or already overwritten) don't carry
+       their claim number; skip them */
+    uint32_t count = 0;
+    for(uint64_t n = first; n < head; n++){
+        const trace_rec_t *r = &g_ring[n & (TRACE_RING - 1)];
+        if(__atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) != (uint32_t)n + 1) continue;
+        trace_rec_t copy = *r;
+        if(copy.seq != (uint32_t)n + 1) continue;
+        fwrite(&copy, sizeof copy, 1, f);
+        count++;
+    }
+    h.count = count;
+    int rc = fseek(f, 0, SEEK_SET) == 0 && fwrite(&h, sizeof h, 1, f) == 1 ? 0 : -1;
+    if(fclose(f) != 0) rc = -1;
+    if(rc == 0)
+        fprintf(stderr, "trace: %u of %llu records -> %s\n", count, (unsigned long long)head, path);
+    return rc;
+}
+
+static void trace_at_exit(void)
+{
+    if(!__atomic_load_n(&g_head, __ATOMIC_ACQUIRE)) return;   /* nothing ran */
+    const char *path = getenv("NDB_TRACE");
+    trace_flush(path && *path ? path : "ndb_trace.bin");
+}
+
+__attribute__((constructor))
+static void trace_init(void)
+{
+    g_ticks0 = prof_ticks();
+    clock_gettime(CLOCK_MONOTONIC, &g_time0);
+    atexit(trace_at_exit);
+}
+#endif
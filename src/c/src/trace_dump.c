@@ -0,0 +1,138 @@
+/*
+ * trace_dump – print a trace ring written by a TRACE=N build (trace.h).
+ *
+ * One line per record, oldest first, in the wording the removed printf
+ * calls used, prefixed by the time since the first record and the writing
+ * thread.  --kind limits the output to one record kind (event, mid,
+ * step_end, kick, hat, melody, fm, kick_block); --summary prints only the
+ * count of each kind.
+ *
+ * Usage: trace_dump [--kind K] [--summary] [trace.bin]   (default ndb_trace.bin)
+ */
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const kind_names[TRACE_KINDS] = {
+    [TRACE_NONE] = "none",
+    [TRACE_EVENT] = "event",
+    [TRACE_MID] = "mid",
+    [TRACE_STEP_END] = "step_end",
+    [TRACE_KICK] = "kick",
+    [TRACE_HAT] = "hat",
+    [TRACE_MELODY] = "melody",
+    [TRACE_FM] = "fm",
+    [TRACE_KICK_BLOCK] = "kick_block",
+};
+
+static float arg_f32(const trace_rec_t *r, int i)
+{
+    float x;
+    memcpy(&x, &r->arg[i], sizeof x);
+    return x;
+}
+
+static void print_rec(const trace_rec_t *r)
+{
+    const uint32_t *a = r->arg;
+    switch((trace_kind_t)r->kind){
+    case TRACE_EVENT:
+        printf("TRIGGER type=%u aux=%u step=%u pos=%u\n", a[0], a[1], a[2], a[3]);
+        break;
+    case TRACE_MID:
+        printf("MID TRIGGER step=%u aux=%u pos=%u\n", a[0], a[1], a[2]);
+        break;
+    case TRACE_STEP_END:
+        printf("TRIGGER_STEP END event_idx=%u step=%u pos=%u\n", a[0], a[1], a[2]);
+        break;
+    case TRACE_KICK:
+        printf("KICK_TRIGGER len=%u env_coef=%f y_prev2=%f k1=%f\n", a[0], arg_f32(r, 1),
+               arg_f32(r, 2), arg_f32(r, 3));
+        break;
+    case TRACE_HAT:
+        printf("HAT_TRIGGER len=%u env_coef=%f\n", a[0], arg_f32(r, 1));
+        break;
+    case TRACE_MELODY:
+        printf("MELODY_TRIGGER freq=%.2f dur=%.2f len=%u\n", arg_f32(r, 0), arg_f32(r, 1), a[2]);
+        break;
+    case TRACE_FM:
+        printf("FM_TRIGGER cf=%.2f dur=%.2f ratio=%.2f idx=%.2f amp=%.2f len=%u\n", arg_f32(r, 0),
+               arg_f32(r, 1), arg_f32(r, 2), arg_f32(r, 3), arg_f32(r, 4), a[5]);
+        break;
+    case TRACE_KICK_BLOCK:
+        printf("KICK_BUFFER_%s frames=%u peak=%f\n", arg_f32(r, 1) > 0.001f ? "HAS_AUDIO" : "SILENT",
+               a[0], arg_f32(r, 1));
+        break;
+    default:
+        printf("kind=%u %u %u %u %u %u %u\n", r->kind, a[0], a[1], a[2], a[3], a[4], a[5]);
+        break;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = "ndb_trace.bin";
+    int only = -1, summary = 0;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--kind") == 0 && i + 1 < argc){
+            const char *k = argv[++i];
+            for(int n = 1; n < TRACE_KINDS; n++)
+                if(strcmp(k, kind_names[n]) == 0) only = n;
+            if(only < 0){
+                fprintf(stderr, "trace_dump: unknown kind '%s'\n", k);
+                return 1;
+            }
+        } else if(strcmp(argv[i], "--summary") == 0){
+            summary = 1;
+        } else if(argv[i][0] != '-'){
+            path = argv[i];
+        } else {
+            fprintf(stderr, "usage: %s [--kind K] [--summary] [trace.bin]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    FILE *f = fopen(path, "rb");
+    if(!f){
+        perror(path);
+        return 1;
+    }
+    trace_file_hdr_t h;
+    if(fread(&h, sizeof h, 1, f) != 1 || memcmp(h.magic, TRACE_MAGIC, sizeof h.magic) != 0 ||
+       h.version != TRACE_VERSION){
+        fprintf(stderr, "trace_dump: %s is not a version %u trace\n", path, TRACE_VERSION);
+        fclose(f);
+        return 1;
+    }
+
+    uint64_t counts[TRACE_KINDS + 1] = {0};
+    uint64_t t0 = 0;
+    for(uint32_t i = 0; i < h.count; i++){
+        trace_rec_t r;
+        if(fread(&r, sizeof r, 1, f) != 1){
+            fprintf(stderr, "trace_dump: %s: truncated after %u records\n", path, i);
+            break;
+        }
+        if(i == 0) t0 = r.ticks;
+        counts[r.kind < TRACE_KINDS ? r.kind : TRACE_KINDS]++;
+        if(summary || (only >= 0 && r.kind != only)) continue;
+        if(h.ticks_per_sec)
+            printf("%12.6f ", (double)(r.ticks - t0) / (double)h.ticks_per_sec);
+        else
+            printf("%12llu ", (unsigned long long)(r.ticks - t0));
+        printf("t%-2u ", r.thread);
+        print_rec(&r);
+    }
+    fclose(f);
+
+    if(summary){
+        for(int n = 1; n < TRACE_KINDS; n++)
+            if(counts[n]) printf("%-12s %llu\n", kind_names[n], (unsigned long long)counts[n]);
+        if(counts[TRACE_KINDS]) printf("%-12s %llu\n", "unknown", (unsigned long long)counts[TRACE_KINDS]);
+    }
+    if(h.emitted > h.count)
+        fprintf(stderr, "trace_dump: %llu of %llu records were overwritten or torn\n",
+                (unsigned long long)(h.emitted - h.count), (unsigned long long)h.emitted);
+    return 0;
+}
@@ -0,0 +1,314 @@
+#include "track_render.h"
+#include "generator.h"
+#include "pcm16.h"
+#include "prof.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#define MAX_SEG_FRAMES 424000
+/* Frames per render block: generate -> (limit) -> int16 -> append to WAV */
+#define SEG_BLOCK 4096
+
+/* --limit: lookahead limiter ahead of the int16 conversion (off by default
+   so existing seeds keep rendering bit-identically) */
+#define SEG_LIMIT_LOOKAHEAD_MS 3.0f
+#define SEG_LIMIT_RELEASE_MS   80.0f
+#define SEG_LIMIT_THRESH_DB    -0.3f
+
+/* One track in flight: its generator, block buffers and position */
+typedef struct {
+    generator_t g;
+    float L[SEG_BLOCK], R[SEG_BLOCK];
+    int16_t pcm[SEG_BLOCK * 2];
+    limiter_la_t limiter;
+    generator_loop_t loop;
+    wav_stream_t *wav;
+    wav_stream_t *const *stem_wav;   /* track_render_stems: GEN_STEMS more, else NULL */
+    const track_opts_t *opt;
+    uint32_t seg_frames, total_frames;
+    uint32_t seg_ticks;     /* one loop in SR ticks (seg_frames when rate_div 1) */
+    uint32_t seams;         /* loop boundaries passed */
+    uint32_t loop_start, loop_end;
+    uint32_t skip;          /* limiter latency still to drop */
+    uint32_t in_left, out_left;
+    uint32_t seg_left;      /* frames until the next loop boundary */
+    uint32_t tail_frames;   /* ring-out appended after the last loop */
+    int tail;               /* ring-out still to add */
+    double sum_sq;
+    int rc;
+} track_job_t;
+
+/* Static (each holds a generator_t and block buffers): track_render uses
+   the first, track_render_lanes all of them, one track per job */
+static track_job_t jobs[GEN_LANES];
+/* track_render_stems' per-stem blocks */
+static float stem_L[GEN_STEMS][SEG_BLOCK], stem_R[GEN_STEMS][SEG_BLOCK];
+
+/* Fallback scalar RMS when assembly version not linked */
+#ifndef GENERATOR_RMS_ASM_PRESENT
+float generator_compute_rms_asm(const float *L, const float *R, uint32_t num_frames)
+{
+    double sum = 0.0;
+    for(uint32_t i=0;i<num_frames;i++){
+        double sL = L[i];
+        double sR = R[i];
+        sum += sL*sL + sR*sR;
+    }
+    return (float)sqrt(sum / (double)(2*num_frames));
+}
+#endif
+
+/* Frame at which loop `k` starts: the first at or after SR tick k * seg */
+static uint32_t track_seam(const track_job_t *j, uint32_t k)
+{
+    return (uint32_t)generator_ticks_to_frames(&j->g, (uint64_t)k * j->seg_ticks);
+}
+
+static void track_begin(track_job_t *j, uint64_t seed, wav_stream_t *wav, const track_opts_t *opt)
+{
+    generator_t *g = &j->g;
+    generator_init_rate(g, seed, (opt->euclid ? GEN_INIT_EUCLID : 0) | (opt->noise_v2 ? GEN_INIT_NOISE_V2 : 0) |
+                        (opt->fm_pool ? GEN_INIT_FM_POOL : 0), opt->rate_div ? opt->rate_div : 1);
+    generator_reserve_scratch(g, SEG_BLOCK);   /* else process() mallocs per call */
+    int arranged = opt->bars && opt->arrange && generator_arrange(g, opt->bars) == 0;
+    j->wav = wav;
+    j->stem_wav = NULL;
+    j->opt = opt;
+
+    /* Lengths are fixed in SR ticks; a draft renders the frames covering them */
+    uint64_t total_ticks;
+    if(opt->bars){
+        j->seg_ticks = generator_loop_frames(&g->mt);
+        total_ticks = (uint64_t)opt->bars * STEPS_PER_BAR * g->mt.step_samples;
+    } else {
+        j->seg_ticks = g->mt.seg_frames;
+        if(j->seg_ticks > MAX_SEG_FRAMES) j->seg_ticks = MAX_SEG_FRAMES;
+        total_ticks = (uint64_t)j->seg_ticks * (opt->repeat ? opt->repeat : 1);
+    }
+    j->seg_frames = track_seam(j, 1);
+    j->total_frames = (uint32_t)generator_ticks_to_frames(g, total_ticks);
+    j->seams = 0;
+    generator_loop_mark(g, &j->loop);
+
+    /* From the first seam on, every loop starts with the previous loop's
+       tails, so [seg, last whole loop) repeats without a click. */
+    uint32_t loops = (uint32_t)(total_ticks / j->seg_ticks);
+    j->loop_start = j->loop_end = 0;
+    if(loops >= 2 && !arranged){
+        j->loop_start = track_seam(j, 1);
+        j->loop_end = track_seam(j, loops);
+        wav_stream_set_loop(wav, j->loop_start, j->loop_end);
+    } else if(loops == 1 && opt->tail && !arranged){
+        /* The loop is the whole pattern, the tail after it: tag it so
+           readers need not guess where the ring-out starts */
+        j->loop_end = j->seg_frames;
+        wav_stream_set_loop(wav, 0, j->loop_end);
+    }
+
+    j->skip = 0;
+    if(opt->limit){
+        limiter_la_init(&j->limiter, (float32_t)generator_sample_rate(g), SEG_LIMIT_LOOKAHEAD_MS,
+                        SEG_LIMIT_RELEASE_MS, SEG_LIMIT_THRESH_DB);
+        j->skip = limiter_la_latency(&j->limiter);
+    }
+    j->sum_sq = 0.0;
+    j->in_left = j->out_left = j->total_frames;
+    j->seg_left = j->seg_frames;
+    j->tail_frames = 0;
+    j->tail = opt->tail;
+    j->rc = 0;
+}
+
+static int track_running(const track_job_t *j)
+{
+    return j->out_left > 0 && j->rc == 0;
+}
+
+/* Frames to generate for the next block (0 while draining the limiter) */
+static uint32_t track_want(const track_job_t *j)
+{
+    uint32_t gen = j->in_left < SEG_BLOCK ? j->in_left : SEG_BLOCK;
+    return gen > j->seg_left ? j->seg_left : gen;
+}
+
+/* The block's `gen` frames are in j->L/R: rewind at the seam, limit,
+   convert and append */
+static void track_emit(track_job_t *j, uint32_t gen)
+{
+    const track_opts_t *opt = j->opt;
+    j->in_left -= gen;
+    j->seg_left -= gen;
+    if(j->in_left == 0 && j->tail){
+        /* Last loop done: no new notes; render exactly until the longest
+           sounding one ends (voices stop dead at their length) */
+        j->tail = 0;
+        generator_hold(&j->g);
+        j->tail_frames = generator_ring_frames(&j->g);
+        j->in_left = j->seg_left = j->tail_frames;
+        j->out_left += j->tail_frames;
+        j->total_frames += j->tail_frames;
+    }
+    if(j->seg_left == 0 && j->in_left > 0){
+        /* --bars: clock already wrapped; else seg_frames != step grid.  A
+           draft seam lands up to rate_div - 1 ticks into the loop. */
+        uint32_t at = ++j->seams;
+        uint32_t frame = track_seam(j, at);
+        generator_rewind_at(&j->g, &j->loop, (uint32_t)((uint64_t)frame * j->g.rate_div - (uint64_t)at * j->seg_ticks));
+        j->seg_left = track_seam(j, at + 1) - frame;
+    }
+    if(opt->verbose && gen){
+        float rms = generator_compute_rms_asm(j->L, j->R, gen);
+        j->sum_sq += (double)rms * rms * 2.0 * gen;
+    }
+
+    const float *outL = j->L, *outR = j->R;
+    uint32_t n = gen;
+    if(opt->limit){
+        if(gen < SEG_BLOCK){   /* drain the lookahead with silence */
+            memset(j->L + gen, 0, (SEG_BLOCK - gen) * sizeof(float));
+            memset(j->R + gen, 0, (SEG_BLOCK - gen) * sizeof(float));
+        }
+        PROF_BEGIN(lim, "limiter");
+        limiter_la_process(&j->limiter, j->L, j->R, SEG_BLOCK);
+        PROF_END(lim);
+        n = SEG_BLOCK;
+        uint32_t s = j->skip < n ? j->skip : n;
+        outL += s; outR += s;
+        n -= s;
+        j->skip -= s;
+    }
+    if(n > j->out_left) n = j->out_left;
+
+    PROF_BEGIN(out, "pcm16+write");
+    pcm16_interleave(outL, outR, j->pcm, n);
+    j->rc = wav_stream_append(j->wav, j->pcm, n);
+    /* Stems are never limited (track_render_stems refuses --limit), so
+       outL/outR is j->L/R and the stems line up with it */
+    for(uint32_t s = 0; j->stem_wav && s < GEN_STEMS && j->rc == 0; s++){
+        pcm16_interleave(stem_L[s], stem_R[s], j->pcm, n);
+        j->rc = wav_stream_append(j->stem_wav[s], j->pcm, n);
+    }
+    PROF_END(out);
+    j->out_left -= n;
+}
+
+static int track_end(track_job_t *j, track_info_t *info)
+{
+    if(j->opt->verbose){
+        /* RMS diagnostic to verify audio energy */
+        printf("C-POST rms=%f\n", (float)sqrt(j->sum_sq / (2.0 * j->total_frames)));
+        printf("DEBUG: MID triggers fired = %u\n", j->g.mid_trigger_count);
+    }
+    if(info){
+        info->total_frames = j->total_frames;
+        info->tail_frames = j->tail_frames;
+        info->seg_frames = j->seg_frames;
+        info->loop_start = j->loop_start;
+        info->loop_end = j->loop_end;
+        info->bpm = j->g.mt.bpm;
+        info->root_freq = j->g.music.root_freq;
+    }
+    generator_free(&j->g);
+    return j->rc;
+}
+
+/* Stream one seed into `wav`, SEG_BLOCK frames at a time.
+   With `limit` the limiter latency is compensated: the first latency frames
+   of output are dropped and the tail is drained with silence.
+   `repeat` > 1 renders the extended track in one pass: at every segment
+   boundary the pattern clock and random streams are rewound while voices
+   keep sounding, so every loop plays the same notes and tails carry into
+   the next loop instead of being cut as a file concat does.
+   `bars` > 0 is the continuous mode: any number of bars on the exact step
+   grid (period generator_loop_frames), wrapping like generator_process;
+   with `arrange` the bars play as the seed's sections rather than one
+   pattern.  Multi-loop renders tag the WAV with the seamless loop region
+   (not arranged ones: no two sections need be alike).
+   `tail` replaces the fixed length's cut at the end with the exact
+   ring-out: once the last loop is rendered no event fires and the track
+   stops on the frame its last note ends (a one-loop render is then tagged
+   with loop [0, seg_frames) and the tail after it). */
+int track_render(uint64_t seed, wav_stream_t *wav, const track_opts_t *opt, track_info_t *info)
+{
+    track_job_t *j = &jobs[0];
+    track_begin(j, seed, wav, opt);
+    while(track_running(j)){
+        uint32_t gen = track_want(j);
+        if(gen) generator_process(&j->g, j->L, j->R, gen);
+        track_emit(j, gen);
+    }
+    return track_end(j, info);
+}
+
+int track_measure(uint64_t seed, const track_opts_t *opt, track_info_t *info)
+{
+    if(opt->tail) return -1;
+    wav_stream_t none;
+    wav_stream_open_null(&none, 2, SR);
+    track_job_t *j = &jobs[0];
+    track_begin(j, seed, &none, opt);
+    track_opts_t quiet = *opt;
+    quiet.verbose = 0;
+    j->opt = &quiet;
+    return track_end(j, info);
+}
+
+int track_render_stems(uint64_t seed, wav_stream_t *wav, wav_stream_t *const stems[],
+                       const track_opts_t *opt, track_info_t *info)
+{
+    if(opt->limit) return -1;
+    track_job_t *j = &jobs[0];
+    track_begin(j, seed, wav, opt);
+    j->stem_wav = stems;
+    for(uint32_t s = 0; s < GEN_STEMS; s++)
+        if(wav->loop_end) wav_stream_set_loop(stems[s], wav->loop_start, wav->loop_end);
+
+    float32_t *sL[GEN_STEMS], *sR[GEN_STEMS];
+    for(uint32_t s = 0; s < GEN_STEMS; s++){
+        sL[s] = stem_L[s];
+        sR[s] = stem_R[s];
+    }
+    while(track_running(j)){
+        uint32_t gen = track_want(j);
+        if(gen) generator_process_stems(&j->g, sL, sR, j->L, j->R, gen);
+        track_emit(j, gen);
+    }
+    return track_end(j, info);
+}
+
+int track_render_lanes(const uint64_t seeds[], wav_stream_t *const wavs[], uint32_t lanes,
+                       const track_opts_t *opt, track_info_t info[], int rc[])
+{
+    if(lanes > GEN_LANES) lanes = GEN_LANES;
+    generator_t *g[GEN_LANES];
+    float *L[GEN_LANES], *R[GEN_LANES];
+    for(uint32_t l = 0; l < lanes; l++){
+        track_begin(&jobs[l], seeds[l], wavs[l], opt);
+        g[l] = &jobs[l].g;
+        L[l] = jobs[l].L;
+        R[l] = jobs[l].R;
+    }
+
+    /* Blocks stay SEG_BLOCK-aligned per track; tracks of different lengths
+       drop out as they finish */
+    for(;;){
+        uint32_t gen[GEN_LANES] = {0}, running = 0;
+        for(uint32_t l = 0; l < lanes; l++){
+            if(!track_running(&jobs[l])) continue;
+            gen[l] = track_want(&jobs[l]);
+            running++;
+        }
+        if(!running) break;
+        generator_process_lanes(g, lanes, L, R, gen);
+        for(uint32_t l = 0; l < lanes; l++)
+            if(track_running(&jobs[l])) track_emit(&jobs[l], gen[l]);
+    }
+
+    int failed = 0;
+    for(uint32_t l = 0; l < lanes; l++){
+        rc[l] = track_end(&jobs[l], info ? &info[l] : NULL);
+        if(rc[l] != 0) failed++;
+    }
+    return failed ? -1 : 0;
+}
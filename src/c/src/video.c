@@ -4,90 +4,313 @@
 #endif
 #include <SDL.h>
 #include <stdlib.h>
+#include <string.h>
 
 typedef struct {
     SDL_Window   *win;
     SDL_Renderer *ren;
     SDL_Texture  *tex;
-    uint32_t      fps_interval_ms;
-    uint32_t      last_ticks;
+    video_config_t cfg;
     int           width;
     int           height;
-    uint32_t     *fb;
+    uint32_t     *fb;          /* current frame: locked texture or soft[0] */
+    uint32_t     *soft[2];     /* COPY framebuffer; render-ahead uses both */
+    bool          locked;
+    int           dx, dy;      /* video_frame_offset of the frame being drawn */
+
+    /* Pacing, on the performance counter */
+    uint64_t      freq;
+    uint64_t      last_present;  /* after the last present returned (a vblank with vsync) */
+    uint64_t      refresh;       /* vsync: counts per vblank */
+    int           swap;          /* vsync: vblanks per frame, refresh / fps */
+    uint64_t      interval;      /* timer: counts per frame */
+    uint64_t      deadline;      /* timer: when the next frame is due */
+    uint64_t      draw_t0;       /* the frame being drawn started */
+    uint64_t      draw_est;      /* counts from draw start to present, video_frame_lead_ns */
 } video_state_t;
 
 static video_state_t g;
 
-int video_init(int width, int height, int fps, bool vsync)
+int video_open(const video_config_t *cfg)
 {
     if(SDL_Init(SDL_INIT_VIDEO) != 0){
         SDL_Log("SDL_Init failed: %s", SDL_GetError());
         return 1;
     }
+    g.cfg = *cfg;
 
-    uint32_t flags = SDL_RENDERER_ACCELERATED | (vsync?SDL_RENDERER_PRESENTVSYNC:0);
+    uint32_t flags = SDL_RENDERER_ACCELERATED | (cfg->vsync?SDL_RENDERER_PRESENTVSYNC:0);
     g.win = SDL_CreateWindow("Euclid Visualiser", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                             width, height, SDL_WINDOW_SHOWN);
+                             cfg->width, cfg->height, SDL_WINDOW_SHOWN);
     if(!g.win){ SDL_Log("CreateWindow failed: %s", SDL_GetError()); return 1; }
 
     g.ren = SDL_CreateRenderer(g.win, -1, flags);
     if(!g.ren){ SDL_Log("CreateRenderer failed: %s", SDL_GetError()); return 1; }
 
-    g.width = width; g.height = height;
-    g.fb = (uint32_t*)malloc(width * height * sizeof(uint32_t));
-    if(!g.fb){ SDL_Log("malloc framebuffer failed"); return 1; }
-
+    g.width = cfg->width; g.height = cfg->height;
     g.tex = SDL_CreateTexture(g.ren, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING,
-                              width, height);
+                              g.width, g.height);
     if(!g.tex){ SDL_Log("CreateTexture failed: %s", SDL_GetError()); return 1; }
 
-    g.fps_interval_ms = (fps>0)? (1000u / (uint32_t)fps) : 0u;
-    g.last_ticks = SDL_GetTicks();
+    /* Zero copy needs rows packed at the framebuffer stride */
+    if(g.cfg.present == VIDEO_PRESENT_LOCK && !g.cfg.render_ahead){
+        void *p; int pitch;
+        if(SDL_LockTexture(g.tex, NULL, &p, &pitch) != 0 || pitch != g.width * (int)sizeof(uint32_t)){
+            SDL_Log("Texture pitch isn't packed, presenting by copy");
+            g.cfg.present = VIDEO_PRESENT_COPY;
+        }
+        SDL_UnlockTexture(g.tex);
+    }
+    int nsoft = g.cfg.render_ahead ? 2 : g.cfg.present == VIDEO_PRESENT_COPY ? 1 : 0;
+    for(int i = 0; i < nsoft; i++){
+        g.soft[i] = (uint32_t*)calloc((size_t)g.width * g.height, sizeof(uint32_t));
+        if(!g.soft[i]){ SDL_Log("malloc framebuffer failed"); return 1; }
+    }
+    g.fb = g.soft[0];
+
+    g.freq = SDL_GetPerformanceFrequency();
+    int refresh_hz = 60;
+    SDL_DisplayMode mode;
+    if(SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(g.win), &mode) == 0 && mode.refresh_rate > 0)
+        refresh_hz = mode.refresh_rate;
+    g.refresh = g.freq / (uint64_t)refresh_hz;
+    g.swap = cfg->fps > 0 ? (refresh_hz + cfg->fps / 2) / cfg->fps : 1;
+    if(g.swap < 1) g.swap = 1;
+    g.interval = cfg->fps > 0 ? g.freq / (uint64_t)cfg->fps : 0;
+    g.last_present = g.deadline = SDL_GetPerformanceCounter();
     return 0;
 }
 
-bool video_frame_begin(void)
+int video_init(int width, int height, int fps, bool vsync)
 {
-    /* Frame pacing */
-    if(g.fps_interval_ms){
-        uint32_t now = SDL_GetTicks();
-        uint32_t elapsed = now - g.last_ticks;
-        if(elapsed < g.fps_interval_ms){
-            SDL_Delay(g.fps_interval_ms - elapsed);
-        }
-        g.last_ticks = SDL_GetTicks();
-    }
+    video_config_t cfg = VIDEO_CONFIG_DEFAULT;
+    cfg.width = width; cfg.height = height;
+    cfg.fps = fps; cfg.vsync = vsync;
+    return video_open(&cfg);
+}
 
-    /* Event polling */
+static bool poll_events(void)
+{
     SDL_Event ev;
     while(SDL_PollEvent(&ev)){
         if(ev.type == SDL_QUIT){
             return false; /* request close */
         }
     }
+    return true;
+}
+
+bool video_frame_begin(void)
+{
+    bool running = poll_events();
 
+    if(g.cfg.present == VIDEO_PRESENT_LOCK && !g.locked){
+        void *p; int pitch;
+        if(SDL_LockTexture(g.tex, NULL, &p, &pitch) == 0){
+            g.fb = (uint32_t*)p;
+            g.locked = true;
+        } else {
+            SDL_Log("LockTexture failed: %s", SDL_GetError());
+            return false;
+        }
+    }
     /* nothing else here, draw into framebuffer in caller */
-    return true;
+    g.draw_t0 = SDL_GetPerformanceCounter();
+    return running;
 }
 
-void video_frame_end(void)
+void video_frame_offset(int dx, int dy)
+{
+    g.dx = dx;
+    g.dy = dy;
+}
+
+/* A frame took t0..now to draw (and upload): rise to a slow one at once,
+ * come down an eighth of the way per fast one */
+static void note_draw(uint64_t t0)
+{
+    uint64_t d = SDL_GetPerformanceCounter() - t0;
+    g.draw_est = d > g.draw_est ? d : g.draw_est - (g.draw_est - d) / 8;
+}
+
+uint64_t video_frame_lead_ns(void)
+{
+    uint64_t now = SDL_GetPerformanceCounter();
+    uint64_t last = __atomic_load_n(&g.last_present, __ATOMIC_RELAXED);
+    uint64_t done = now + g.draw_est;
+    uint64_t at = done;
+    if(g.cfg.vsync && g.refresh){
+        /* The first vblank after it is submitted */
+        uint64_t n = done > last ? (done - last + g.refresh - 1) / g.refresh : 1;
+        at = last + (n < 1 ? 1 : n) * g.refresh;
+    }
+    if(g.cfg.render_ahead)
+        at += g.cfg.vsync ? g.refresh * (uint64_t)g.swap : g.interval ? g.interval : g.draw_est;
+    return at > now ? (at - now) * 1000000000ull / g.freq : 0;
+}
+
+/* The texture at (dx, dy): a shifted destination rect over a black clear */
+static void blit(int dx, int dy)
 {
-    /* upload framebuffer to texture & present */
-    SDL_UpdateTexture(g.tex, NULL, g.fb, g.width * sizeof(uint32_t));
+    if(dx == 0 && dy == 0){
+        SDL_RenderCopy(g.ren, g.tex, NULL, NULL);
+        return;
+    }
+    SDL_Rect dst = { dx, dy, g.width, g.height };
+    SDL_SetRenderDrawColor(g.ren, 0, 0, 0, 255);
     SDL_RenderClear(g.ren);
-    SDL_RenderCopy(g.ren, g.tex, NULL, NULL);
+    SDL_RenderCopy(g.ren, g.tex, NULL, &dst);
+}
+
+/* Present the texture, then hold it for as many vblanks as the frame rate
+ * asks for, or (no vsync) wait out the frame on an absolute deadline */
+static void present(int dx, int dy)
+{
+    blit(dx, dy);
     SDL_RenderPresent(g.ren);
+    uint64_t now = SDL_GetPerformanceCounter();
+
+    if(g.cfg.vsync){
+        /* Vblanks this frame already took; a late frame gets shown less */
+        int shown = (int)((now - g.last_present + g.refresh / 2) / g.refresh);
+        for(int k = shown < 1 ? 1 : shown; k < g.swap; k++){
+            blit(dx, dy);
+            SDL_RenderPresent(g.ren);
+        }
+        __atomic_store_n(&g.last_present, SDL_GetPerformanceCounter(), __ATOMIC_RELAXED);
+        return;
+    }
+    __atomic_store_n(&g.last_present, now, __ATOMIC_RELAXED);
+    if(!g.interval) return;
+    g.deadline += g.interval;
+    if(now >= g.deadline){
+        if(now - g.deadline > g.interval) g.deadline = now;   /* fell behind: don't sprint */
+        return;
+    }
+    /* Sleep whole milliseconds short of the deadline, then spin the rest */
+    uint64_t ms = (g.deadline - now) * 1000 / g.freq;
+    if(ms > 1) SDL_Delay((Uint32)(ms - 1));
+    while(SDL_GetPerformanceCounter() < g.deadline) {}
+}
+
+static void upload(const uint32_t *fb)
+{
+    if(g.cfg.present == VIDEO_PRESENT_LOCK){
+        /* Render-ahead: one copy from the finished buffer into the mapping */
+        void *p; int pitch;
+        if(SDL_LockTexture(g.tex, NULL, &p, &pitch) != 0) return;
+        for(int y = 0; y < g.height; y++)
+            memcpy((uint8_t*)p + (size_t)y * pitch, fb + (size_t)y * g.width, (size_t)g.width * sizeof(uint32_t));
+        SDL_UnlockTexture(g.tex);
+    } else {
+        SDL_UpdateTexture(g.tex, NULL, fb, g.width * sizeof(uint32_t));
+    }
+}
+
+void video_frame_end(void)
+{
+    if(g.locked){
+        SDL_UnlockTexture(g.tex);
+        g.locked = false;
+    } else {
+        upload(g.fb);
+    }
+    note_draw(g.draw_t0);
+    present(g.dx, g.dy);
+    g.dx = g.dy = 0;
+}
+
+void video_frame_drop(void)
+{
+    /* The texture keeps the last presented frame */
+    if(g.locked){
+        SDL_UnlockTexture(g.tex);
+        g.locked = false;
+    }
+    g.dx = g.dy = 0;
+}
+
+/* --- render-ahead: soft[i] is drawn on the render thread, then presented here */
+typedef struct {
+    video_draw_fn draw;
+    void         *user;
+    SDL_sem      *free_sem;     /* buffers the render thread may draw into */
+    SDL_sem      *ready_sem;    /* buffers drawn, in order */
+    bool          show[2];
+    int           dx[2], dy[2]; /* each buffer's video_frame_offset */
+    SDL_atomic_t  quit;
+} render_ahead_t;
+
+static int render_thread(void *arg)
+{
+    render_ahead_t *ra = (render_ahead_t*)arg;
+    for(int i = 0; ; i ^= 1){
+        SDL_SemWait(ra->free_sem);
+        if(SDL_AtomicGet(&ra->quit)) break;
+        g.dx = g.dy = 0;    /* only this thread draws, so only it sets them */
+        uint64_t t0 = SDL_GetPerformanceCounter();
+        ra->show[i] = ra->draw(g.soft[i], g.width, g.height, ra->user);
+        if(ra->show[i]) note_draw(t0);
+        ra->dx[i] = g.dx;
+        ra->dy[i] = g.dy;
+        SDL_SemPost(ra->ready_sem);
+    }
+    return 0;
+}
+
+int video_run(video_draw_fn draw, void *user)
+{
+    if(!g.cfg.render_ahead){
+        bool running = true;
+        while(running){
+            running = video_frame_begin();
+            if(!running) break;
+            if(draw(g.fb, g.width, g.height, user)) video_frame_end();
+            else video_frame_drop();
+        }
+        if(g.locked){ SDL_UnlockTexture(g.tex); g.locked = false; }
+        return 0;
+    }
+
+    render_ahead_t ra;
+    memset(&ra, 0, sizeof(ra));
+    ra.draw = draw;
+    ra.user = user;
+    ra.free_sem = SDL_CreateSemaphore(2);
+    ra.ready_sem = SDL_CreateSemaphore(0);
+    SDL_Thread *th = (ra.free_sem && ra.ready_sem) ? SDL_CreateThread(render_thread, "render", &ra) : NULL;
+    if(!th){
+        SDL_Log("render thread failed: %s", SDL_GetError());
+        if(ra.free_sem) SDL_DestroySemaphore(ra.free_sem);
+        if(ra.ready_sem) SDL_DestroySemaphore(ra.ready_sem);
+        return 1;
+    }
+    for(int i = 0; poll_events(); ){
+        /* Keep handling events while the render thread is busy */
+        if(SDL_SemWaitTimeout(ra.ready_sem, 10) != 0) continue;
+        if(ra.show[i]) upload(g.soft[i]);
+        SDL_SemPost(ra.free_sem);   /* uploaded: the thread may redraw it */
+        if(ra.show[i]) present(ra.dx[i], ra.dy[i]);
+        i ^= 1;
+    }
+    SDL_AtomicSet(&ra.quit, 1);
+    SDL_SemPost(ra.free_sem);
+    SDL_WaitThread(th, NULL);
+    SDL_DestroySemaphore(ra.free_sem);
+    SDL_DestroySemaphore(ra.ready_sem);
+    return 0;
 }
 
 void video_shutdown(void)
 {
-    if(g.ren) SDL_DestroyRenderer(g.ren);
     if(g.tex) SDL_DestroyTexture(g.tex);
+    if(g.ren) SDL_DestroyRenderer(g.ren);
     if(g.win) SDL_DestroyWindow(g.win);
-    free(g.fb);
+    free(g.soft[0]);
+    free(g.soft[1]);
     SDL_Quit();
 }
 
 uint32_t* video_get_framebuffer(void){ return g.fb; }
 int video_get_width(void){ return g.width; }
-int video_get_height(void){ return g.height; } 
\ No newline at end of file
+int video_get_height(void){ return g.height; }
@@ -0,0 +1,295 @@
+#include "voice_registry.h"
+#include "fm_presets.h"
+#include "simd4.h"
+
+/* ---- kick: live render, or mixed from the one-shot cache ---- */
+
+static void kick_init_voice(generator_t *g, uint64_t seed, uint32_t noise)
+{
+    (void)seed; (void)noise;
+    kick_init(&g->kick, (float32_t)generator_sample_rate(g));
+}
+
+static bool kick_trigger_voice(generator_t *g, const event_t *e)
+{
+    (void)e;
+    kick_trigger(&g->kick);
+    generator_cache_kick(g);
+    return true;
+}
+
+/* Cached one-shot into a bus: L and R get the same samples */
+static void mix_shot(const float32_t *shot, float32_t *L, float32_t *R, uint32_t n)
+{
+    uint32_t i = 0;
+    for(; i + 4 <= n; i += 4){
+        v4f s = v4_load(shot + i);
+        v4_store(L + i, v4_add(v4_load(L + i), s));
+        v4_store(R + i, v4_add(v4_load(R + i), s));
+    }
+    for(; i < n; i++){
+        L[i] += shot[i];
+        R[i] += shot[i];
+    }
+}
+
+static void kick_block(generator_t *g, float32_t *L, float32_t *R, uint32_t n)
+{
+    if(g->kick_shot_len){
+        mix_shot(g->kick_shot + g->kick.pos, L, R, n);
+        g->kick.pos += n;
+    } else {
+        kick_process(&g->kick, L, R, n);
+    }
+}
+
+/* ---- snare / hat: seeded noise, v1 or v2 engine ---- */
+
+static void snare_init_voice(generator_t *g, uint64_t seed, uint32_t noise)
+{
+    snare_init_noise(&g->snare, (float32_t)generator_sample_rate(g), seed ^ 0xABCDEF, noise);
+}
+
+static bool snare_trigger_voice(generator_t *g, const event_t *e)
+{
+    (void)e;
+    snare_trigger(&g->snare);
+    return true;
+}
+
+static void snare_block(generator_t *g, float32_t *L, float32_t *R, uint32_t n)
+{
+    if(g->snare.noise_version == NOISE_V2) snare_process_v2(&g->snare, L, R, n);
+    else snare_process(&g->snare, L, R, n);
+}
+
+static void hat_init_voice(generator_t *g, uint64_t seed, uint32_t noise)
+{
+    hat_init_noise(&g->hat, (float32_t)generator_sample_rate(g), seed ^ 0x123456, noise);
+}
+
+static bool hat_trigger_voice(generator_t *g, const event_t *e)
+{
+    (void)e;
+    hat_trigger(&g->hat);
+    return true;
+}
+
+/* ---- melody ---- */
+
+static void melody_init_voice(generator_t *g, uint64_t seed, uint32_t noise)
+{
+    (void)seed; (void)noise;
+    melody_init(&g->mel, (float32_t)generator_sample_rate(g));
+}
+
+static bool melody_trigger_voice(generator_t *g, const event_t *e)
+{
+    /* note chosen at plan time (generator_plan_note): a table lookup */
+    float32_t freq = g->plan->pitch[e->note];
+    melody_trigger(&g->mel, freq, g->mt.beat_sec);
+    g->saw_hit = true;
+    return true;
+}
+
+static void melody_block(generator_t *g, float32_t *L, float32_t *R, uint32_t n)
+{
+    melody_process(&g->mel, L, R, n);
+}
+
+#ifndef MELODY_ASM
+static void melody_lanes(generator_t *const g[GEN_LANES], float32_t *const L[GEN_LANES],
+                         float32_t *const R[GEN_LANES], const uint32_t n[GEN_LANES])
+{
+    melody_t *m[GEN_LANES];
+    for(int l = 0; l < GEN_LANES; l++) m[l] = n[l] ? &g[l]->mel : NULL;
+    melody_process_x4(m, L, R, n);
+}
+#define MELODY_LANES melody_lanes
+#else
+#define MELODY_LANES NULL
+#endif
+
+/* ---- mid: aux 0..2 simple waves, 3.. FM presets ---- */
+
+static bool mid_simple_trigger_voice(generator_t *g, const event_t *e)
+{
+    uint8_t idx = e->aux;
+    if(idx >= 3) return false;
+    simple_wave_t w = (idx == 0) ? SIMPLE_TRI : (idx == 1) ? SIMPLE_SINE : SIMPLE_SQUARE;
+    simple_voice_trigger(&g->mid_simple, g->plan->pitch[e->note], g->mt.step_sec, w, 0.2f, 6.0f);
+    return true;
+}
+
+static void mid_fm_init_voice(generator_t *g, uint64_t seed, uint32_t noise)
+{
+    (void)seed; (void)noise;
+    fm_voice_init(&g->mid_fm, (float32_t)generator_sample_rate(g));
+}
+
+/* FM preset for aux 3.. (false: a simple wave's event) */
+static bool mid_fm_params(const event_t *e, fm_params_t *p)
+{
+    uint8_t idx = e->aux;
+    if(idx < 3) return false;
+    fm_params_t mid_presets[4] = {FM_PRESET_BELLS, FM_PRESET_CALM, FM_PRESET_QUANTUM, FM_PRESET_PLUCK};
+    *p = mid_presets[(idx - 3) % 4];
+    return true;
+}
+
+static float32_t mid_fm_duration(const generator_t *g)
+{
+    return g->mt.step_sec + (1.0f/ (float32_t)generator_sample_rate(g));
+}
+
+static bool mid_fm_trigger_voice(generator_t *g, const event_t *e)
+{
+    fm_params_t p;
+    if(g->fm_pool || !mid_fm_params(e, &p)) return false;
+    fm_voice_trigger(&g->mid_fm, g->plan->pitch[e->note], mid_fm_duration(g), p.ratio, p.index, p.amp, p.decay);
+    return true;
+}
+
+static void mid_fm_block(generator_t *g, float32_t *L, float32_t *R, uint32_t n)
+{
+    fm_voice_process(&g->mid_fm, L, R, n);
+}
+
+/* Lane form only where fm_voice_process is the poly kernel */
+#if !defined(FM_VOICE_ASM) && !defined(FM_ENV_EXP) && !defined(FM_ENV_RECURRENCE)
+#define FM_LANES(name, field) \
+    static void name(generator_t *const g[GEN_LANES], float32_t *const L[GEN_LANES], \
+                     float32_t *const R[GEN_LANES], const uint32_t n[GEN_LANES]) \
+    { \
+        fm_voice_t *v[GEN_LANES]; \
+        for(int l = 0; l < GEN_LANES; l++) v[l] = n[l] ? &g[l]->field : NULL; \
+        fm_voice_process_poly_x4(v, L, R, n); \
+    }
+FM_LANES(mid_fm_lanes, mid_fm)
+FM_LANES(bass_fm_lanes, bass_fm)
+#define MID_FM_LANES  mid_fm_lanes
+#define BASS_FM_LANES bass_fm_lanes
+#else
+#define MID_FM_LANES  NULL
+#define BASS_FM_LANES NULL
+#endif
+
+/* ---- FM bass: patch chosen at plan time ---- */
+
+static void bass_fm_init_voice(generator_t *g, uint64_t seed, uint32_t noise)
+{
+    (void)seed; (void)noise;
+    fm_voice_init(&g->bass_fm, (float32_t)generator_sample_rate(g));
+}
+
+static fm_params_t bass_fm_params(const event_t *e)
+{
+    switch(e->preset){
+        default:
+        case 0:
+            return FM_BASS_DEFAULT;
+        case 1:
+            return FM_BASS_QUANTUM;
+        case 2:
+            return FM_BASS_PLUCKY;
+    }
+}
+
+static bool bass_fm_trigger_voice(generator_t *g, const event_t *e)
+{
+    if(g->fm_pool) return false;
+    fm_params_t p = bass_fm_params(e);
+    fm_voice_trigger(&g->bass_fm, g->plan->pitch[e->note], g->mt.beat_sec * 2, p.ratio, p.index, p.amp, p.decay);
+    g->bass_hit = true;
+    return true;
+}
+
+static void bass_fm_block(generator_t *g, float32_t *L, float32_t *R, uint32_t n)
+{
+    fm_voice_process(&g->bass_fm, L, R, n);
+}
+
+/* ---- FM pools (GEN_INIT_FM_POOL): the same notes, overlapping ---- */
+
+static void mid_pool_init_voice(generator_t *g, uint64_t seed, uint32_t noise)
+{
+    (void)seed; (void)noise;
+    fm_pool_init(&g->mid_pool, (float32_t)generator_sample_rate(g));
+}
+
+static bool mid_pool_trigger_voice(generator_t *g, const event_t *e)
+{
+    fm_params_t p;
+    if(!g->fm_pool || !mid_fm_params(e, &p)) return false;
+    fm_pool_trigger(&g->mid_pool, g->plan->pitch[e->note], mid_fm_duration(g), p.ratio, p.index, p.amp, p.decay);
+    return true;
+}
+
+static void mid_pool_block(generator_t *g, float32_t *L, float32_t *R, uint32_t n)
+{
+    fm_pool_process(&g->mid_pool, L, R, n);
+}
+
+static void bass_pool_init_voice(generator_t *g, uint64_t seed, uint32_t noise)
+{
+    (void)seed; (void)noise;
+    fm_pool_init(&g->bass_pool, (float32_t)generator_sample_rate(g));
+}
+
+static bool bass_pool_trigger_voice(generator_t *g, const event_t *e)
+{
+    if(!g->fm_pool) return false;
+    fm_params_t p = bass_fm_params(e);
+    fm_pool_trigger(&g->bass_pool, g->plan->pitch[e->note], g->mt.beat_sec * 2, p.ratio, p.index, p.amp, p.decay);
+    g->bass_hit = true;
+    return true;
+}
+
+static void bass_pool_block(generator_t *g, float32_t *L, float32_t *R, uint32_t n)
+{
+    fm_pool_process(&g->bass_pool, L, R, n);
+}
+
+#define VOICE_FIELDS(field) \
+    (uint16_t)offsetof(generator_t, field.pos), (uint16_t)offsetof(generator_t, field.len)
+
+const voice_desc_t voice_registry[] = {
+    { "kick",       "voice.kick",       GEN_VOICE_KICK,       VOICE_BUS_DRUMS, VOICE_STEM_DRUMS,  EVT_KICK,    VOICE_FIELDS(kick),
+      kick_init_voice,    kick_trigger_voice,       kick_block,    NULL },
+    { "snare",      "voice.snare",      GEN_VOICE_SNARE,      VOICE_BUS_DRUMS, VOICE_STEM_DRUMS,  EVT_SNARE,   VOICE_FIELDS(snare),
+      snare_init_voice,   snare_trigger_voice,      snare_block,   NULL },
+    { "hat",        "voice.hat",        GEN_VOICE_HAT,        VOICE_BUS_DRUMS, VOICE_STEM_DRUMS,  EVT_HAT,     VOICE_FIELDS(hat),
+      hat_init_voice,     hat_trigger_voice,        NULL,          NULL },
+    { "melody",     "voice.melody",     GEN_VOICE_MELODY,     VOICE_BUS_SYNTH, VOICE_STEM_MELODY, EVT_MELODY,  VOICE_FIELDS(mel),
+      melody_init_voice,  melody_trigger_voice,     melody_block,  MELODY_LANES },
+    { "mid_fm",     "voice.mid_fm",     GEN_VOICE_MID_FM,     VOICE_BUS_SYNTH, VOICE_STEM_MID,    EVT_MID,     VOICE_FIELDS(mid_fm),
+      mid_fm_init_voice,  mid_fm_trigger_voice,     mid_fm_block,  MID_FM_LANES },
+    { "mid_pool",   "voice.mid_pool",   GEN_VOICE_MID_POOL,   VOICE_BUS_SYNTH, VOICE_STEM_MID,    EVT_MID,     VOICE_FIELDS(mid_pool),
+      mid_pool_init_voice, mid_pool_trigger_voice,  mid_pool_block, NULL },
+    { "bass_fm",    "voice.bass_fm",    GEN_VOICE_BASS_FM,    VOICE_BUS_SYNTH, VOICE_STEM_BASS,   EVT_FM_BASS, VOICE_FIELDS(bass_fm),
+      bass_fm_init_voice, bass_fm_trigger_voice,    bass_fm_block, BASS_FM_LANES },
+    { "bass_pool",  "voice.bass_pool",  GEN_VOICE_BASS_POOL,  VOICE_BUS_SYNTH, VOICE_STEM_BASS,   EVT_FM_BASS, VOICE_FIELDS(bass_pool),
+      bass_pool_init_voice, bass_pool_trigger_voice, bass_pool_block, NULL },
+    { "mid_simple", "voice.mid_simple", GEN_VOICE_MID_SIMPLE, VOICE_BUS_SYNTH, VOICE_STEM_MID,    EVT_MID,     VOICE_FIELDS(mid_simple),
+      NULL,               mid_simple_trigger_voice, NULL,          NULL },
+};
+const uint32_t voice_registry_count = sizeof voice_registry / sizeof voice_registry[0];
+
+const char *const generator_stem_names[GEN_STEMS] = {
+    [VOICE_STEM_DRUMS] = "drums", [VOICE_STEM_MELODY] = "melody",
+    [VOICE_STEM_MID] = "mid",     [VOICE_STEM_BASS] = "bass",
+};
+
+_Static_assert(sizeof voice_registry / sizeof voice_registry[0] <= 32, "active_voices is a 32-bit mask");
+_Static_assert(VOICE_STEM_COUNT == GEN_STEMS, "generator_process_stems has one output per voice_stem_t");
+
+void voice_registry_trigger(generator_t *g, const event_t *e)
+{
+    for(uint32_t i = 0; i < voice_registry_count; i++){
+        const voice_desc_t *v = &voice_registry[i];
+        if(v->event == e->type && v->trigger(g, e)){
+            g->active_voices |= v->bit;
+            return;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#include "rt_engine.h"
+#include "music_time.h"
+#include "seed.h"
+
+/*
+ * Browser entry points (make wasm -> bin/ndb_audio.wasm, played by
+ * web/ndb_worklet.js).  The realtime engine as the players use it, with
+ * the page writing its seed string and reading interleaved blocks out of
+ * the module's memory; no allocation after ndb_wasm_init.
+ */
+
+#define NDB_WASM_SEED_MAX 80   /* "0x" + 64 hex digits, with room to spare */
+
+static rt_engine_t g_engine;
+static int g_ready;
+static char g_seed[NDB_WASM_SEED_MAX + 1];
+static float g_out[2 * RT_MAX_BLOCK];
+static rt_event_t g_events[RT_EVENT_RING];
+
+/* Where the page writes the NUL-terminated seed before ndb_wasm_init */
+char *ndb_wasm_seed_buf(void)
+{
+    return g_seed;
+}
+
+/* (Re)start the engine on the seed in ndb_wasm_seed_buf().  0 on success,
+   -1 when it does not parse or the delay ring can't be allocated. */
+int ndb_wasm_init(void)
+{
+    ndb_seed_t seed;
+    g_seed[NDB_WASM_SEED_MAX] = '\0';
+    if(ndb_seed_parse(g_seed, &seed) != 0) return -1;
+    if(g_ready){
+        rt_engine_free(&g_engine);
+        g_ready = 0;
+    }
+    if(rt_engine_init(&g_engine, seed.audio) != 0) return -1;
+    g_ready = 1;
+    return 0;
+}
+
+/* Render `frames` (at most ndb_wasm_max_block()) interleaved stereo frames
+   into ndb_wasm_out(); silence before a successful init */
+void ndb_wasm_render(uint32_t frames)
+{
+    if(frames > RT_MAX_BLOCK) frames = RT_MAX_BLOCK;
+    if(!g_ready){
+        for(uint32_t i = 0; i < 2 * frames; i++) g_out[i] = 0.0f;
+        return;
+    }
+    rt_engine_render(g_out, frames, &g_engine);
+}
+
+float *ndb_wasm_out(void)          { return g_out; }
+uint32_t ndb_wasm_max_block(void)  { return RT_MAX_BLOCK; }
+uint32_t ndb_wasm_sample_rate(void){ return SR; }
+
+/* Events since the last call (rt_engine_poll) into ndb_wasm_events();
+   returns how many.  Each is 16 bytes: u64 frame, f32 value, u16 type,
+   u16 step. */
+uint32_t ndb_wasm_poll(void)
+{
+    return g_ready ? (uint32_t)rt_engine_poll(&g_engine, g_events, RT_EVENT_RING) : 0;
+}
+
+rt_event_t *ndb_wasm_events(void)  { return g_events; }
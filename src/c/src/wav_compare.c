@@ -0,0 +1,110 @@
+/*
+ * wav_compare – sample-level comparison of two 16-bit PCM WAV files.
+ *
+ * Used by `make golden_check` to hold the portable C build against WAVs
+ * recorded from the ARM64 assembly build.  Prints frame counts, the share
+ * of identical samples and the largest difference in LSBs; exits non-zero
+ * on a format/length mismatch or when the max difference exceeds the
+ * tolerance.
+ *
+ * Usage: wav_compare <expected.wav> <actual.wav> [max_lsb_diff]   (default 0)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+typedef struct {
+    uint16_t channels;
+    uint32_t sample_rate;
+    uint32_t samples;   /* total interleaved int16 samples */
+    int16_t *data;
+} wav_pcm16_t;
+
+static uint32_t rd_le32(const uint8_t *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint16_t rd_le16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+static int wav_load(const char *path, wav_pcm16_t *w)
+{
+    memset(w, 0, sizeof *w);
+    FILE *f = fopen(path, "rb");
+    if (!f) { perror(path); return -1; }
+
+    uint8_t hdr[12];
+    if (fread(hdr, 1, 12, f) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        fprintf(stderr, "wav_compare: %s is not a RIFF/WAVE file\n", path);
+        fclose(f);
+        return -1;
+    }
+
+    uint16_t bits = 0, format = 0;
+    uint8_t ck[8];
+    while (fread(ck, 1, 8, f) == 8) {
+        uint32_t size = rd_le32(ck + 4);
+        if (!memcmp(ck, "fmt ", 4) && size >= 16) {
+            uint8_t fmt[16];
+            if (fread(fmt, 1, 16, f) != 16) break;
+            format = rd_le16(fmt);
+            w->channels = rd_le16(fmt + 2);
+            w->sample_rate = rd_le32(fmt + 4);
+            bits = rd_le16(fmt + 14);
+            fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        } else if (!memcmp(ck, "data", 4)) {
+            w->samples = size / 2;
+            w->data = malloc((size_t)w->samples * sizeof(int16_t) + 1);
+            if (!w->data || fread(w->data, 2, w->samples, f) != w->samples) break;
+            fclose(f);
+            if (format != 1 || bits != 16) {
+                fprintf(stderr, "wav_compare: %s is not 16-bit PCM\n", path);
+                free(w->data);
+                return -1;
+            }
+            return 0;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    fprintf(stderr, "wav_compare: %s: missing or truncated data chunk\n", path);
+    free(w->data);
+    fclose(f);
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <expected.wav> <actual.wav> [max_lsb_diff]\n", argv[0]);
+        return 2;
+    }
+    long tol = argc > 3 ? strtol(argv[3], NULL, 10) : 0;
+
+    wav_pcm16_t a, b;
+    if (wav_load(argv[1], &a) != 0) return 2;
+    if (wav_load(argv[2], &b) != 0) { free(a.data); return 2; }
+
+    int rc = 0;
+    if (a.channels != b.channels || a.sample_rate != b.sample_rate || a.samples != b.samples) {
+        fprintf(stderr, "wav_compare: format mismatch: %u ch %u Hz %u samples vs %u ch %u Hz %u samples\n",
+                a.channels, a.sample_rate, a.samples, b.channels, b.sample_rate, b.samples);
+        rc = 1;
+    } else {
+        uint32_t same = 0, first = UINT32_MAX;
+        long max_diff = 0;
+        for (uint32_t i = 0; i < a.samples; i++) {
+            long d = labs((long)a.data[i] - (long)b.data[i]);
+            if (d == 0) { same++; continue; }
+            if (first == UINT32_MAX) first = i;
+            if (d > max_diff) max_diff = d;
+        }
+        printf("%s: %u frames, %.4f%% identical, max diff %ld LSB",
+               argv[2], a.samples / (a.channels ? a.channels : 1),
+               a.samples ? 100.0 * same / a.samples : 100.0, max_diff);
+        if (first != UINT32_MAX)
+            printf(", first at frame %u", first / (a.channels ? a.channels : 1));
+        printf("\n");
+        if (max_diff > tol) rc = 1;
+    }
+    free(a.data);
+    free(b.data);
+    return rc;
+}
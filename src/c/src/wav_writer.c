@@ -1,9 +1,66 @@
 #include "wav_writer.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
-static void write_le32(FILE *f, uint32_t v) { fwrite(&v, 4, 1, f); }
-static void write_le16(FILE *f, uint16_t v) { fwrite(&v, 2, 1, f); }
+#define WAV_HEADER_BYTES 44
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+static void put_le16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+
+/* Assemble the canonical 44-byte PCM header */
+static void build_header(uint8_t h[WAV_HEADER_BYTES], uint32_t frames, uint16_t num_channels,
+                         uint32_t sample_rate, uint32_t trailer_bytes)
+{
+    uint16_t bits_per_sample = 16;
+    uint32_t byte_rate = sample_rate * num_channels * bits_per_sample / 8;
+    uint16_t block_align = num_channels * bits_per_sample / 8;
+    uint32_t data_chunk_size = frames * block_align;
+    uint32_t riff_size = 4 + 8 + 16 + 8 + data_chunk_size + trailer_bytes; // WAVE + fmt + data + chunks after data
+
+    memcpy(h, "RIFF", 4);       put_le32(h + 4, riff_size);
+    memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "fmt ", 4);  put_le32(h + 16, 16);   // PCM header size
+    put_le16(h + 20, 1);                                // AudioFormat = PCM
+    put_le16(h + 22, num_channels);
+    put_le32(h + 24, sample_rate);
+    put_le32(h + 28, byte_rate);
+    put_le16(h + 32, block_align);
+    put_le16(h + 34, bits_per_sample);
+    memcpy(h + 36, "data", 4);  put_le32(h + 40, data_chunk_size);
+}
+
+/* ...and emit it in one fwrite */
+static int write_header(FILE *f, uint32_t frames, uint16_t num_channels, uint32_t sample_rate,
+                        uint32_t trailer_bytes)
+{
+    uint8_t h[WAV_HEADER_BYTES];
+    build_header(h, frames, num_channels, sample_rate, trailer_bytes);
+    return fwrite(h, 1, sizeof h, f) == sizeof h ? 0 : -1;
+}
+
+/* Memory streams: grow the image to hold `extra` more bytes */
+static int mem_reserve(wav_stream_t *w, size_t extra)
+{
+    if (w->mem_len + extra <= w->mem_cap) return 0;
+    if (w->fixed_mem) {
+        fprintf(stderr, "wav_stream: image exceeds the caller's %zu bytes\n", w->mem_cap);
+        return -1;
+    }
+    size_t cap = w->mem_cap ? w->mem_cap : WAV_STREAM_BUF_BYTES;
+    while (cap < w->mem_len + extra) cap *= 2;
+    uint8_t *p = realloc(w->mem, cap);
+    if (!p) {
+        fprintf(stderr, "wav_stream: out of memory (%zu bytes)\n", cap);
+        return -1;
+    }
+    w->mem = p;
+    w->mem_cap = cap;
+    return 0;
+}
 
 void write_wav(const char *path,
                const int16_t *samples,
@@ -17,31 +74,155 @@ void write_wav(const char *path,
         return;
     }
 
-    uint16_t bits_per_sample = 16;
-    uint32_t byte_rate = sample_rate * num_channels * bits_per_sample / 8;
-    uint16_t block_align = num_channels * bits_per_sample / 8;
-    uint32_t data_chunk_size = frames * block_align;
-    uint32_t riff_size = 4 + 8 + 16 + 8 + data_chunk_size; // WAVE + fmt + data
-
-    /* RIFF header */
-    fwrite("RIFF", 1, 4, f);
-    write_le32(f, riff_size);
-    fwrite("WAVE", 1, 4, f);
-
-    /* fmt  sub-chunk */
-    fwrite("fmt ", 1, 4, f);
-    write_le32(f, 16);                 // PCM header size
-    write_le16(f, 1);                  // AudioFormat = PCM
-    write_le16(f, num_channels);
-    write_le32(f, sample_rate);
-    write_le32(f, byte_rate);
-    write_le16(f, block_align);
-    write_le16(f, bits_per_sample);
-
-    /* data sub-chunk */
-    fwrite("data", 1, 4, f);
-    write_le32(f, data_chunk_size);
-    fwrite(samples, block_align, frames, f);
+    write_header(f, frames, num_channels, sample_rate, 0);
+    fwrite(samples, (size_t)num_channels * 2, frames, f);
 
     fclose(f);
-} 
\ No newline at end of file
+}
+
+int wav_stream_open(wav_stream_t *w, const char *path, uint16_t num_channels, uint32_t sample_rate)
+{
+    memset(w, 0, sizeof *w);
+    w->f = fopen(path, "wb");
+    if (!w->f) {
+        perror("wav_stream_open: fopen");
+        return -1;
+    }
+    /* Page-aligned stdio buffer: appends land in WAV_STREAM_BUF_BYTES
+       writes instead of one syscall per rendered block */
+    w->buf = aligned_alloc(4096, WAV_STREAM_BUF_BYTES);
+    if (w->buf) setvbuf(w->f, w->buf, _IOFBF, WAV_STREAM_BUF_BYTES);
+    w->channels = num_channels;
+    w->sample_rate = sample_rate;
+    if (write_header(w->f, 0, num_channels, sample_rate, 0) != 0) {   /* sizes patched on close */
+        wav_stream_close(w);
+        return -1;
+    }
+    return 0;
+}
+
+int wav_stream_open_mem(wav_stream_t *w, uint16_t num_channels, uint32_t sample_rate,
+                        uint32_t frames_hint)
+{
+    memset(w, 0, sizeof *w);
+    w->channels = num_channels;
+    w->sample_rate = sample_rate;
+    w->in_memory = 1;
+    if (mem_reserve(w, WAV_HEADER_BYTES + (size_t)frames_hint * num_channels * 2) != 0) return -1;
+    w->mem_len = WAV_HEADER_BYTES;   /* header filled in on close */
+    return 0;
+}
+
+int wav_stream_open_buf(wav_stream_t *w, uint16_t num_channels, uint32_t sample_rate,
+                        void *buf, size_t cap)
+{
+    memset(w, 0, sizeof *w);
+    w->channels = num_channels;
+    w->sample_rate = sample_rate;
+    w->in_memory = 1;
+    w->fixed_mem = 1;
+    w->mem = buf;
+    w->mem_cap = cap;
+    if (!buf || mem_reserve(w, WAV_HEADER_BYTES) != 0) return -1;
+    w->mem_len = WAV_HEADER_BYTES;
+    return 0;
+}
+
+int wav_stream_open_null(wav_stream_t *w, uint16_t num_channels, uint32_t sample_rate)
+{
+    memset(w, 0, sizeof *w);
+    w->channels = num_channels;
+    w->sample_rate = sample_rate;
+    w->is_null = 1;
+    return 0;
+}
+
+int wav_stream_append(wav_stream_t *w, const int16_t *samples, uint32_t frames)
+{
+    if (w->tap && w->tap(w->tap_ctx, samples, frames, w->channels) != 0) return -1;
+    if (w->is_null) {
+        w->frames += frames;
+        return 0;
+    }
+    if (w->in_memory) {
+        size_t bytes = (size_t)frames * w->channels * 2;
+        if (mem_reserve(w, bytes) != 0) return -1;
+        memcpy(w->mem + w->mem_len, samples, bytes);
+        w->mem_len += bytes;
+        w->frames += frames;
+        return 0;
+    }
+    if (!w->f) return -1;
+    if (fwrite(samples, (size_t)w->channels * 2, frames, w->f) != frames) {
+        perror("wav_stream_append: fwrite");
+        return -1;
+    }
+    w->frames += frames;
+    return 0;
+}
+
+void wav_stream_set_loop(wav_stream_t *w, uint32_t start_frame, uint32_t end_frame)
+{
+    w->has_loop = end_frame > start_frame;
+    w->loop_start = start_frame;
+    w->loop_end = end_frame;
+}
+
+/* "smpl" chunk with one forward loop: 36 bytes of sampler fields, then
+   one 24-byte loop record (end is inclusive, in sample frames). */
+#define WAV_SMPL_BYTES (8 + 36 + 24)
+
+static void build_smpl(uint8_t c[WAV_SMPL_BYTES], uint32_t sample_rate, uint32_t start, uint32_t end_incl)
+{
+    memset(c, 0, WAV_SMPL_BYTES);
+    memcpy(c, "smpl", 4);   put_le32(c + 4, 36 + 24);
+    put_le32(c + 16, sample_rate ? 1000000000u / sample_rate : 0);   // sample period, ns
+    put_le32(c + 20, 60);                                          // MIDI unity note
+    put_le32(c + 36, 1);                                           // one loop
+    put_le32(c + 52, start);                                       // cue id 0, type 0 = forward
+    put_le32(c + 56, end_incl);
+}
+
+static int write_smpl(FILE *f, uint32_t sample_rate, uint32_t start, uint32_t end_incl)
+{
+    uint8_t c[WAV_SMPL_BYTES];
+    build_smpl(c, sample_rate, start, end_incl);
+    return fwrite(c, 1, sizeof c, f) == sizeof c ? 0 : -1;
+}
+
+size_t wav_image_bytes(uint32_t frames, uint16_t num_channels, int has_loop)
+{
+    return WAV_HEADER_BYTES + (size_t)frames * num_channels * 2 + (has_loop ? WAV_SMPL_BYTES : 0);
+}
+
+int wav_stream_close(wav_stream_t *w)
+{
+    if (w->in_memory) {
+        if (!w->mem) return -1;
+        uint32_t trailer = 0;
+        if (w->has_loop && w->loop_end <= w->frames) {
+            if (mem_reserve(w, WAV_SMPL_BYTES) != 0) return -1;
+            build_smpl(w->mem + w->mem_len, w->sample_rate, w->loop_start, w->loop_end - 1);
+            w->mem_len += WAV_SMPL_BYTES;
+            trailer = WAV_SMPL_BYTES;
+        }
+        build_header(w->mem, w->frames, w->channels, w->sample_rate, trailer);
+        return 0;   /* w->mem now holds the finished file; the caller frees it */
+    }
+    if (w->is_null) return 0;
+    if (!w->f) return -1;
+    int rc = 0;
+    uint32_t trailer = 0;
+    if (w->has_loop && w->loop_end <= w->frames) {
+        if (write_smpl(w->f, w->sample_rate, w->loop_start, w->loop_end - 1) != 0) rc = -1;
+        trailer = WAV_SMPL_BYTES;
+    }
+    if (fseek(w->f, 0, SEEK_SET) != 0 ||
+        write_header(w->f, w->frames, w->channels, w->sample_rate, trailer) != 0)
+        rc = -1;
+    if (fclose(w->f) != 0) rc = -1;
+    free(w->buf);   /* only after fclose has flushed it */
+    w->f = NULL;
+    w->buf = NULL;
+    return rc;
+}
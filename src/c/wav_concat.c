@@ -1,129 +1,283 @@
+#ifdef __linux__
+#define _GNU_SOURCE   // copy_file_range
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
-// WAV header structure
+// Loop a WAV num_copies times.  The output is one header (the input's fmt
+// chunk and a data chunk) followed by the input's data chunk replicated in
+// the kernel: copy_file_range, which lets filesystems that support it clone
+// the extents (btrfs, XFS) or copy server side (NFS), then sendfile, then
+// plain read/write where neither is available.  No sample passes through
+// user space unless --crossfade asks for one: then each loop seam (the
+// copy's tail over the next copy's head, both `ms` long) is mixed once and
+// written between the replicated interiors, so the output is (num_copies-1)
+// seams shorter.  Chunks other than fmt and data (smpl, LIST) are dropped.
+
+#define COPY_CHUNK (64u << 20)                    // Bytes per copy syscall
+#define RW_BUF_BYTES (1u << 20)                   // read/write fallback buffer
+
+// The input's format and where its samples are
 typedef struct {
-    // RIFF Header
-    char riff_header[4];     // "RIFF"
-    uint32_t wav_size;       // Size of the wav portion of the file
-    char wave_header[4];     // "WAVE"
-    
-    // Format Header
-    char fmt_header[4];      // "fmt "
-    uint32_t fmt_chunk_size; // Size of the format chunk
-    uint16_t audio_format;   // Audio format 1=PCM,6=mulaw,7=alaw, 257=IBM Mu-Law, 258=IBM A-Law, 259=ADPCM
-    uint16_t num_channels;   // Number of channels 1=Mono 2=Stereo
-    uint32_t sample_rate;    // Sampling Frequency in Hz
-    uint32_t byte_rate;      // bytes per second
-    uint16_t sample_alignment; // 2=16-bit mono, 4=16-bit stereo
-    uint16_t bit_depth;      // Number of bits per sample
-    
-    // Data Header
-    char data_header[4];     // "data"
-    uint32_t data_bytes;     // Number of bytes in data
-} wav_header_t;
+    uint8_t fmt[40];                              // fmt chunk body, verbatim
+    uint32_t fmt_bytes;
+    uint16_t audio_format, num_channels, block_align, bit_depth;
+    uint32_t sample_rate;
+    off_t data_offset;
+    uint32_t data_bytes;
+} wav_input_t;
+
+typedef enum { COPY_KERNEL_RANGE, COPY_SENDFILE, COPY_READ_WRITE } copy_mode_t;
+
+static const char *copy_mode_names[] = { "copy_file_range", "sendfile", "read/write" };
+
+static uint32_t le32(const uint8_t *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint16_t le16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+static int read_full(int fd, void *buf, size_t n, off_t off) {
+    uint8_t *p = buf;
+    while (n > 0) {
+        ssize_t r = pread(fd, p, n, off);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        p += r;
+        off += r;
+        n -= (size_t)r;
+    }
+    return 0;
+}
+
+static int write_full(int fd, const void *buf, size_t n) {
+    const uint8_t *p = buf;
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+// Walk the RIFF chunks for fmt and data; the data chunk must be complete
+static int wav_input_open(int fd, wav_input_t *in) {
+    memset(in, 0, sizeof(*in));
+    uint8_t h[12];
+    if (read_full(fd, h, sizeof(h), 0) != 0 ||
+        memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0) {
+        printf("Error: Not a valid WAV file\n");
+        return -1;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    off_t off = 12;
+    while (off + 8 <= size) {
+        uint8_t c[8];
+        if (read_full(fd, c, sizeof(c), off) != 0) break;
+        uint32_t bytes = le32(c + 4);
+        if (memcmp(c, "fmt ", 4) == 0 && bytes >= 16) {
+            in->fmt_bytes = bytes < sizeof(in->fmt) ? bytes : (uint32_t)sizeof(in->fmt);
+            if (read_full(fd, in->fmt, in->fmt_bytes, off + 8) != 0) break;
+            in->audio_format = le16(in->fmt);
+            in->num_channels = le16(in->fmt + 2);
+            in->sample_rate = le32(in->fmt + 4);
+            in->block_align = le16(in->fmt + 12);
+            in->bit_depth = le16(in->fmt + 14);
+        } else if (memcmp(c, "data", 4) == 0) {
+            if (!in->fmt_bytes || off + 8 + (off_t)bytes > size) break;
+            in->data_offset = off + 8;
+            in->data_bytes = bytes;
+            return 0;
+        }
+        off += 8 + (off_t)bytes + (bytes & 1);
+    }
+    printf("Error: No complete fmt and data chunks\n");
+    return -1;
+}
+
+// Append in[off, off + n) to out at its file position.  A kernel path that
+// the filesystem pair doesn't support drops *mode to the next one.
+static int copy_range(int in_fd, off_t off, int out_fd, size_t n, copy_mode_t *mode) {
+    while (n > 0) {
+        size_t chunk = n < COPY_CHUNK ? n : COPY_CHUNK;
+        ssize_t done = -1;
+#ifdef __linux__
+        if (*mode == COPY_KERNEL_RANGE) {
+            loff_t in_off = off;
+            done = copy_file_range(in_fd, &in_off, out_fd, NULL, chunk, 0);
+            if (done < 0 && errno != EINTR) {
+                if (errno != ENOSYS && errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP) return -1;
+                *mode = COPY_SENDFILE;
+            }
+        } else if (*mode == COPY_SENDFILE) {
+            off_t in_off = off;
+            done = sendfile(out_fd, in_fd, &in_off, chunk);
+            if (done < 0 && errno != EINTR) {
+                if (errno != ENOSYS && errno != EINVAL) return -1;
+                *mode = COPY_READ_WRITE;
+            }
+        }
+#else
+        *mode = COPY_READ_WRITE;
+#endif
+        if (*mode == COPY_READ_WRITE) {
+            static uint8_t buf[RW_BUF_BYTES];
+            if (chunk > sizeof(buf)) chunk = sizeof(buf);
+            if (read_full(in_fd, buf, chunk, off) != 0 || write_full(out_fd, buf, chunk) != 0) return -1;
+            done = (ssize_t)chunk;
+        }
+        if (done == 0) return -1;        // Input shorter than its data chunk
+        if (done > 0) {
+            off += done;
+            n -= (size_t)done;
+        }
+    }
+    return 0;
+}
+
+// The seam: the last `bytes` of the data faded out over the first `bytes`
+// faded in, linearly, as 16-bit PCM
+static int build_seam(int fd, const wav_input_t *in, uint32_t bytes, uint8_t *seam) {
+    int16_t *tail = malloc(bytes), *head = malloc(bytes);
+    int rc = -1;
+    if (tail && head &&
+        read_full(fd, tail, bytes, in->data_offset + in->data_bytes - bytes) == 0 &&
+        read_full(fd, head, bytes, in->data_offset) == 0) {
+        uint32_t frames = bytes / in->block_align;
+        int16_t *out = (int16_t *)seam;
+        for (uint32_t f = 0; f < frames; f++) {
+            float g = (f + 0.5f) / frames;
+            for (int c = 0; c < in->num_channels; c++) {
+                size_t i = (size_t)f * in->num_channels + c;
+                long s = lrintf(tail[i] * (1.0f - g) + head[i] * g);
+                out[i] = (int16_t)(s > 32767 ? 32767 : s < -32768 ? -32768 : s);
+            }
+        }
+        rc = 0;
+    }
+    free(tail);
+    free(head);
+    return rc;
+}
 
 int main(int argc, char *argv[]) {
-    if (argc < 4) {
-        printf("Usage: %s <input.wav> <output.wav> <num_copies>\n", argv[0]);
+    float crossfade_ms = 0.0f;
+    int argi = 1;
+    if (argi + 1 < argc && strcmp(argv[argi], "--crossfade") == 0) {
+        crossfade_ms = strtof(argv[argi + 1], NULL);
+        argi += 2;
+    }
+    if (argc - argi < 3) {
+        printf("Usage: %s [--crossfade ms] <input.wav> <output.wav> <num_copies>\n", argv[0]);
         printf("Example: %s seed_0xcafebabe.wav concatenated_4x.wav 4\n", argv[0]);
         return 1;
     }
-    
-    const char *input_file = argv[1];
-    const char *output_file = argv[2];
-    int num_copies = atoi(argv[3]);
-    
+
+    const char *input_file = argv[argi];
+    const char *output_file = argv[argi + 1];
+    int num_copies = atoi(argv[argi + 2]);
+
     if (num_copies <= 0) {
         printf("Error: num_copies must be positive\n");
         return 1;
     }
-    
-    // Open input file
-    FILE *input = fopen(input_file, "rb");
-    if (!input) {
+
+    int in_fd = open(input_file, O_RDONLY);
+    if (in_fd < 0) {
         printf("Error: Cannot open input file %s\n", input_file);
         return 1;
     }
-    
-    // Read original WAV header
-    wav_header_t header;
-    if (fread(&header, sizeof(wav_header_t), 1, input) != 1) {
-        printf("Error: Cannot read WAV header\n");
-        fclose(input);
+    wav_input_t in;
+    if (wav_input_open(in_fd, &in) != 0) {
+        close(in_fd);
         return 1;
     }
-    
-    // Verify it's a WAV file
-    if (strncmp(header.riff_header, "RIFF", 4) != 0 || 
-        strncmp(header.wave_header, "WAVE", 4) != 0) {
-        printf("Error: Not a valid WAV file\n");
-        fclose(input);
-        return 1;
+
+    printf("Input WAV: %u Hz, %d channels, %d-bit, %u data bytes\n",
+           in.sample_rate, in.num_channels, in.bit_depth, in.data_bytes);
+
+    // Seam length in whole frames, at most half the loop so seams never meet
+    uint32_t seam_bytes = 0;
+    if (crossfade_ms > 0.0f) {
+        if (in.audio_format != 1 || in.bit_depth != 16 || in.block_align != 2 * in.num_channels) {
+            printf("Error: --crossfade needs 16-bit PCM\n");
+            close(in_fd);
+            return 1;
+        }
+        uint32_t frames = (uint32_t)(crossfade_ms * in.sample_rate / 1000.0f);
+        uint32_t max_frames = in.data_bytes / in.block_align / 2;
+        if (frames > max_frames) frames = max_frames;
+        seam_bytes = frames * in.block_align;
     }
-    
-    printf("Input WAV: %d Hz, %d channels, %d-bit, %u data bytes\n", 
-           header.sample_rate, header.num_channels, header.bit_depth, header.data_bytes);
-    
+
     // Calculate new sizes
-    uint32_t original_data_bytes = header.data_bytes;
-    uint32_t new_data_bytes = original_data_bytes * num_copies;
-    uint32_t new_wav_size = header.wav_size + (original_data_bytes * (num_copies - 1));
-    
-    // Read all audio data from input
-    uint8_t *audio_data = malloc(original_data_bytes);
-    if (!audio_data) {
-        printf("Error: Cannot allocate memory for audio data\n");
-        fclose(input);
+    uint64_t new_data_bytes = (uint64_t)in.data_bytes * num_copies - (uint64_t)seam_bytes * (num_copies - 1);
+    uint32_t header_bytes = 12 + 8 + in.fmt_bytes + 8;
+    if (new_data_bytes + header_bytes - 8 > UINT32_MAX) {
+        printf("Error: %d copies exceed the 4 GB WAV limit\n", num_copies);
+        close(in_fd);
         return 1;
     }
-    
-    if (fread(audio_data, 1, original_data_bytes, input) != original_data_bytes) {
-        printf("Error: Cannot read audio data\n");
-        free(audio_data);
-        fclose(input);
-        return 1;
+
+    uint8_t *seam = NULL;
+    if (seam_bytes && num_copies > 1) {
+        seam = malloc(seam_bytes);
+        if (!seam || build_seam(in_fd, &in, seam_bytes, seam) != 0) {
+            printf("Error: Cannot read the loop seam\n");
+            free(seam);
+            close(in_fd);
+            return 1;
+        }
     }
-    fclose(input);
-    
-    // Open output file
-    FILE *output = fopen(output_file, "wb");
-    if (!output) {
+
+    int out_fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out_fd < 0) {
         printf("Error: Cannot create output file %s\n", output_file);
-        free(audio_data);
+        free(seam);
+        close(in_fd);
         return 1;
     }
-    
-    // Update header for concatenated file
-    header.data_bytes = new_data_bytes;
-    header.wav_size = new_wav_size;
-    
-    // Write updated header
-    if (fwrite(&header, sizeof(wav_header_t), 1, output) != 1) {
-        printf("Error: Cannot write WAV header\n");
-        free(audio_data);
-        fclose(output);
-        return 1;
+
+    // One header: RIFF, the input's fmt chunk, the data chunk's
+    uint8_t header[12 + 8 + sizeof(in.fmt) + 8];
+    uint32_t riff_size = (uint32_t)(new_data_bytes + header_bytes - 8);
+    uint32_t data_size = (uint32_t)new_data_bytes;
+    memcpy(header, "RIFF", 4);
+    memcpy(header + 4, &riff_size, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    memcpy(header + 16, &in.fmt_bytes, 4);
+    memcpy(header + 20, in.fmt, in.fmt_bytes);
+    memcpy(header + 20 + in.fmt_bytes, "data", 4);
+    memcpy(header + 24 + in.fmt_bytes, &data_size, 4);
+    int rc = write_full(out_fd, header, header_bytes);
+
+    // Copy i: the data less the seam overlap on each side it has a neighbour
+    copy_mode_t mode = COPY_KERNEL_RANGE;
+    for (int i = 0; i < num_copies && rc == 0; i++) {
+        uint32_t lead = i > 0 ? seam_bytes : 0;
+        uint32_t trail = i < num_copies - 1 ? seam_bytes : 0;
+        if (lead) rc = write_full(out_fd, seam, seam_bytes);
+        if (rc == 0) rc = copy_range(in_fd, in.data_offset + lead, out_fd, in.data_bytes - lead - trail, &mode);
     }
-    
-    // Write audio data num_copies times
-    for (int i = 0; i < num_copies; i++) {
-        if (fwrite(audio_data, 1, original_data_bytes, output) != original_data_bytes) {
-            printf("Error: Cannot write audio data (copy %d)\n", i + 1);
-            free(audio_data);
-            fclose(output);
-            return 1;
-        }
-        printf("Wrote copy %d/%d\n", i + 1, num_copies);
-    }
-    
-    free(audio_data);
-    fclose(output);
-    
-    printf("Success: Created %s with %d copies (%u total data bytes)\n", 
-           output_file, num_copies, new_data_bytes);
-    
+    if (rc != 0) printf("Error: Cannot write audio data to %s\n", output_file);
+
+    free(seam);
+    close(in_fd);
+    if (close(out_fd) != 0) rc = -1;
+    if (rc != 0) return 1;
+
+    printf("Success: Created %s with %d copies (%llu total data bytes, %s",
+           output_file, num_copies, (unsigned long long)new_data_bytes, copy_mode_names[mode]);
+    if (seam_bytes && num_copies > 1) printf(", %u-frame seams", seam_bytes / in.block_align);
+    printf(")\n");
+
     return 0;
 }
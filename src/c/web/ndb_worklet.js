@@ -0,0 +1,60 @@
+// AudioWorklet side of the browser player: runs bin/ndb_audio.wasm (make
+// wasm) on the audio thread.  The page compiles the module and hands it
+// over in processorOptions with the seed string; every render quantum
+// asks the engine for that many interleaved frames and splits them into
+// the two output channels.  Bass and melody hits go back on the port.
+
+const RT_EV_SAW = 1, RT_EV_BASS = 2;
+
+// STANDALONE_WASM imports a few WASI calls (stderr, getenv, exit) the
+// engine never needs on this path: answer them all with 0
+function stubImports(module) {
+  const imports = {};
+  for (const imp of WebAssembly.Module.imports(module)) {
+    if (imp.kind !== 'function') continue;
+    (imports[imp.module] ||= {})[imp.name] = () => 0;
+  }
+  return imports;
+}
+
+class NdbProcessor extends AudioWorkletProcessor {
+  constructor(options) {
+    super();
+    const { module, seed } = options.processorOptions;
+    this.wasm = new WebAssembly.Instance(module, stubImports(module)).exports;
+    if (this.wasm._initialize) this.wasm._initialize();
+
+    const bytes = new TextEncoder().encode(seed);
+    const buf = new Uint8Array(this.wasm.memory.buffer, this.wasm.ndb_wasm_seed_buf(), bytes.length + 1);
+    buf.set(bytes);
+    buf[bytes.length] = 0;
+    this.ok = this.wasm.ndb_wasm_init() === 0;
+    this.port.postMessage({ type: 'ready', ok: this.ok, sampleRate: this.wasm.ndb_wasm_sample_rate() });
+  }
+
+  process(inputs, outputs) {
+    const [left, right] = outputs[0];
+    const frames = left.length;
+    this.wasm.ndb_wasm_render(frames);
+    // a fresh view each time: memory growth detaches the old buffer
+    const out = new Float32Array(this.wasm.memory.buffer, this.wasm.ndb_wasm_out(), 2 * frames);
+    for (let i = 0; i < frames; i++) {
+      left[i] = out[2 * i];
+      if (right) right[i] = out[2 * i + 1];
+    }
+
+    const n = this.wasm.ndb_wasm_poll();
+    if (n) {
+      const ev = new DataView(this.wasm.memory.buffer, this.wasm.ndb_wasm_events(), 16 * n);
+      for (let k = 0; k < n; k++) {
+        const type = ev.getUint16(16 * k + 12, true);
+        if (type === RT_EV_SAW || type === RT_EV_BASS)
+          this.port.postMessage({ type: type === RT_EV_BASS ? 'bass' : 'melody',
+                                  step: ev.getUint16(16 * k + 14, true) });
+      }
+    }
+    return true;
+  }
+}
+
+registerProcessor('ndb-processor', NdbProcessor);
@@ -0,0 +1,121 @@
+// delta_decode – replay a generate_frames --delta-out archive as video frames.
+//
+// Frames come back bit-exact from the lossless tile-delta stream (see
+// src/include/frame_delta.h), so a re-encode at another bitrate, preset or
+// size reads them instead of re-rendering the token:
+//
+//   ./bin/delta_decode frames.ndfd --y4m | ffmpeg -i - -i audio.wav -c:v libx264 -crf 18 out.mp4
+//   ./bin/delta_decode frames.ndfd --ppm qa/            # qa/frame_NNNN.ppm
+//   ./bin/delta_decode frames.ndfd --raw --start 600 --count 60 > clip.rgb
+//   ./bin/delta_decode frames.ndfd --digest frames.digest   # no frame output
+//
+// --y4m / --raw (RGB24) / --bgra stream to stdout; --ppm writes one file
+// per frame, numbered like generate_frames' own frame_%04d.ppm.  --start
+// decodes from the keyframe before it.  --digest writes the manifest
+// generate_frames --digest would have for the same frames (digest.h), so an
+// archive can be checked against a render without re-rendering it; on its
+// own it replaces the frame output.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "frame_delta.h"
+#include "frame_writer.h"
+#include "c/include/digest.h"
+
+static int usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s <frames.ndfd> [--y4m | --raw | --bgra | --ppm <dir>] [--start N] [--count N] [--digest out.txt]\n", argv0);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) return usage(argv[0]);
+    frame_format_t fmt = FRAME_FMT_Y4M;
+    const char *ppm_dir = NULL, *digest_path = NULL;
+    bool emit = false;   // a frame output was asked for
+    long start = -1, count = -1;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--y4m") == 0) fmt = FRAME_FMT_Y4M, emit = true;
+        else if (strcmp(argv[i], "--raw") == 0) fmt = FRAME_FMT_RGB24, emit = true;
+        else if (strcmp(argv[i], "--bgra") == 0) fmt = FRAME_FMT_BGRA, emit = true;
+        else if (strcmp(argv[i], "--ppm") == 0 && i + 1 < argc) {
+            fmt = FRAME_FMT_PPM;
+            ppm_dir = argv[++i];
+            emit = true;
+        } else if (strcmp(argv[i], "--start") == 0 && i + 1 < argc) start = atol(argv[++i]);
+        else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) count = atol(argv[++i]);
+        else if (strcmp(argv[i], "--digest") == 0 && i + 1 < argc) digest_path = argv[++i];
+        else return usage(argv[0]);
+    }
+    if (!digest_path) emit = true;
+
+    frame_delta_reader_t r;
+    if (!frame_delta_reader_open(&r, argv[1])) return 1;
+    fprintf(stderr, "📼 %s: %ux%u at %u fps, keyframe every %u, from frame %u\n", argv[1],
+            r.hdr.width, r.hdr.height, r.hdr.fps, r.hdr.keyint, r.hdr.first_frame);
+    if (start >= 0 && frame_delta_reader_seek(&r, (uint32_t)start) != 0) {
+        fprintf(stderr, "❌ Frame %ld is not in %s\n", start, argv[1]);
+        frame_delta_reader_close(&r);
+        return 1;
+    }
+
+    frame_writer_t fw;
+    if (!frame_writer_init(&fw, fmt, (int)r.hdr.width, (int)r.hdr.height, (int)r.hdr.fps)) {
+        frame_delta_reader_close(&r);
+        return 1;
+    }
+    digest_t d;
+    if (digest_path) {
+        char header[64];
+        snprintf(header, sizeof(header), "video %u %u %u", r.hdr.width, r.hdr.height, r.hdr.fps);
+        uint32_t first = start >= 0 ? (uint32_t)start : r.hdr.first_frame;
+        if (digest_open(&d, digest_path, header, 'f', first, 0) != 0) {
+            frame_writer_free(&fw);
+            frame_delta_reader_close(&r);
+            return 1;
+        }
+    }
+    const size_t frame_bytes = (size_t)r.hdr.width * r.hdr.height * sizeof(uint32_t);
+    int rc = 0;
+    long decoded = 0;
+    while (count < 0 || decoded < count) {
+        int got = frame_delta_reader_next(&r);
+        if (got == 0) break;
+        if (got < 0) {
+            fprintf(stderr, "❌ %s is corrupt after frame %ld\n", argv[1], decoded);
+            rc = 1;
+            break;
+        }
+        if (digest_path) {
+            digest_update(&d, r.frame, frame_bytes);
+            digest_part_end(&d);
+        }
+        if (!emit) {
+            // digest only
+        } else if (ppm_dir) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/frame_%04u.ppm", ppm_dir, r.number);
+            if (frame_writer_save(&fw, path, r.frame, NULL) != 0) {
+                rc = 1;
+                break;
+            }
+        } else if (frame_writer_emit(&fw, STDOUT_FILENO, r.frame, NULL) != 0) {
+            fprintf(stderr, "❌ Frame output failed (pipe closed?)\n");
+            rc = 1;
+            break;
+        }
+        decoded++;
+    }
+    fprintf(stderr, "🎉 Decoded %ld frames\n", decoded);
+    if (digest_path && digest_close(&d, NULL) != 0) {
+        fprintf(stderr, "❌ Writing %s failed\n", digest_path);
+        rc = 1;
+    }
+    frame_writer_free(&fw);
+    frame_delta_reader_close(&r);
+    return rc;
+}
@@ -0,0 +1,309 @@
+#include "include/frame_delta.h"
+#include "c/include/buf_alloc.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define TILE_PX     (1 << FRAME_TILE_SHIFT)
+#define TILE_WORST  (TILE_PX * TILE_PX * 6 + 16)   // alternating 1-pixel runs
+#define RECORD_HDR  9                               // kind, frame number, payload bytes
+
+typedef struct {
+    int cols, rows;
+    bool track;   // frame small enough for a frame_tiles_t
+} tile_grid_t;
+
+static tile_grid_t tile_grid(int width, int height) {
+    tile_grid_t g;
+    g.cols = (width + TILE_PX - 1) >> FRAME_TILE_SHIFT;
+    g.rows = (height + TILE_PX - 1) >> FRAME_TILE_SHIFT;
+    g.track = g.cols <= 32 && g.rows <= FRAME_TILE_ROWS_MAX;
+    return g;
+}
+
+static bool reserve(uint8_t **buf, size_t *cap, size_t need) {
+    if (need <= *cap) return true;
+    size_t n = *cap ? *cap : 1 << 16;
+    while (n < need) n *= 2;
+    uint8_t *p = realloc(*buf, n);
+    if (!p) return false;
+    *buf = p;
+    *cap = n;
+    return true;
+}
+
+static size_t put_varint(uint8_t *out, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static bool get_varint(const uint8_t **p, const uint8_t *end, uint32_t *v) {
+    uint32_t x = 0;
+    for (int shift = 0; shift < 35 && *p < end; shift += 7) {
+        uint8_t b = *(*p)++;
+        x |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = x;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ---- Writer -------------------------------------------------------------
+
+bool frame_delta_writer_open(frame_delta_writer_t *w, const char *path, int width, int height,
+                             int fps, int keyint, int first_frame) {
+    memset(w, 0, sizeof(*w));
+    w->prev = buf_alloc(0, (size_t)width * height * sizeof(uint32_t), BUF_ZERO);
+    w->f = w->prev ? fopen(path, "wb") : NULL;
+    if (!w->f) {
+        fprintf(stderr, "frame_delta: could not create %s\n", path);
+        buf_free(w->prev);
+        w->prev = NULL;
+        return false;
+    }
+    memcpy(w->hdr.magic, FD_MAGIC, 4);
+    w->hdr.version = FD_VERSION;
+    w->hdr.width = (uint32_t)width;
+    w->hdr.height = (uint32_t)height;
+    w->hdr.fps = (uint32_t)fps;
+    w->hdr.keyint = keyint > 0 ? (uint32_t)keyint : 1;
+    w->hdr.first_frame = (uint32_t)first_frame;
+    fwrite(&w->hdr, sizeof(w->hdr), 1, w->f);
+    w->bytes = sizeof(w->hdr);
+    return true;
+}
+
+static bool tile_equal(const uint32_t *a, const uint32_t *b, int stride, int x0, int x1, int y0, int y1) {
+    for (int y = y0; y < y1; y++) {
+        size_t at = (size_t)y * stride + x0;
+        if (memcmp(a + at, b + at, (size_t)(x1 - x0) * sizeof(uint32_t)) != 0) return false;
+    }
+    return true;
+}
+
+// XOR of the tile against `ref` (NULL: black) as zero-run / literal tokens
+static size_t encode_tile(uint8_t *out, const uint32_t *cur, const uint32_t *ref, int stride,
+                          int x0, int x1, int y0, int y1) {
+    uint32_t lit[TILE_PX * TILE_PX];
+    uint32_t zeros = 0, n = 0;
+    size_t len = 0;
+    for (int y = y0; y < y1; y++) {
+        size_t row = (size_t)y * stride;
+        for (int x = x0; x < x1; x++) {
+            uint32_t d = cur[row + x] ^ (ref ? ref[row + x] : 0);
+            if (d) {
+                lit[n++] = d;
+                continue;
+            }
+            if (n) {
+                len += put_varint(out + len, zeros);
+                len += put_varint(out + len, n);
+                memcpy(out + len, lit, n * sizeof(uint32_t));
+                len += n * sizeof(uint32_t);
+                zeros = n = 0;
+            }
+            zeros++;
+        }
+    }
+    len += put_varint(out + len, zeros);
+    len += put_varint(out + len, n);
+    memcpy(out + len, lit, n * sizeof(uint32_t));
+    return len + n * sizeof(uint32_t);
+}
+
+bool frame_delta_writer_resume(frame_delta_writer_t *w, const char *path, int width, int height,
+                               int fps, int keyint, int first_frame, unsigned frames, uint64_t bytes) {
+    memset(w, 0, sizeof(*w));
+    fd_header_t want = { .version = FD_VERSION, .width = (uint32_t)width, .height = (uint32_t)height,
+                         .fps = (uint32_t)fps, .keyint = keyint > 0 ? (uint32_t)keyint : 1,
+                         .first_frame = (uint32_t)first_frame };
+    memcpy(want.magic, FD_MAGIC, 4);
+    if (frames % want.keyint != 0 || bytes < sizeof(fd_header_t)) return false;
+    w->prev = buf_alloc(0, (size_t)width * height * sizeof(uint32_t), BUF_ZERO);
+    w->f = w->prev ? fopen(path, "r+b") : NULL;
+    if (!w->f || fread(&w->hdr, sizeof(w->hdr), 1, w->f) != 1 || memcmp(&w->hdr, &want, sizeof(want)) != 0 ||
+        ftruncate(fileno(w->f), (off_t)bytes) != 0 || fseeko(w->f, (off_t)bytes, SEEK_SET) != 0) {
+        fprintf(stderr, "frame_delta: could not resume %s\n", path);
+        if (w->f) fclose(w->f);
+        buf_free(w->prev);
+        memset(w, 0, sizeof(*w));
+        return false;
+    }
+    // The previous frame is unknown: every tile is read on the keyframe
+    frame_tiles_mark_all(&w->prev_tiles);
+    w->frames = frames;
+    w->bytes = bytes;
+    return true;
+}
+
+int frame_delta_writer_frame(frame_delta_writer_t *w, const uint32_t *pixels, const frame_tiles_t *tiles) {
+    int width = (int)w->hdr.width, height = (int)w->hdr.height;
+    tile_grid_t g = tile_grid(width, height);
+    bool key = w->frames % w->hdr.keyint == 0;
+    bool track = tiles && g.track;
+    size_t map_len = ((size_t)g.cols * g.rows + 7) / 8;
+
+    if (!reserve(&w->buf, &w->cap, map_len)) return -1;
+    memset(w->buf, 0, map_len);
+    w->len = map_len;
+    for (int ty = 0; ty < g.rows; ty++) {
+        int y0 = ty * TILE_PX, y1 = y0 + TILE_PX < height ? y0 + TILE_PX : height;
+        for (int tx = 0; tx < g.cols; tx++) {
+            int x0 = tx * TILE_PX, x1 = x0 + TILE_PX < width ? x0 + TILE_PX : width;
+            bool dirty = !track || (tiles->rows[ty] >> tx & 1);
+            bool was = !g.track || (w->prev_tiles.rows[ty] >> tx & 1);
+            if (!dirty && !was) continue;   // black in both frames
+            int t = ty * g.cols + tx;
+            bool changed = key ? dirty : !tile_equal(pixels, w->prev, width, x0, x1, y0, y1);
+            if (changed) {
+                if (!reserve(&w->buf, &w->cap, w->len + TILE_WORST)) return -1;
+                w->buf[t >> 3] |= (uint8_t)(1 << (t & 7));
+                w->len += encode_tile(w->buf + w->len, pixels, key ? NULL : w->prev, width, x0, x1, y0, y1);
+            }
+            for (int y = y0; y < y1; y++)
+                memcpy(w->prev + (size_t)y * width + x0, pixels + (size_t)y * width + x0,
+                       (size_t)(x1 - x0) * sizeof(uint32_t));
+        }
+    }
+    if (track) w->prev_tiles = *tiles;
+    else frame_tiles_mark_all(&w->prev_tiles);
+
+    uint8_t rec[RECORD_HDR];
+    uint32_t number = w->hdr.first_frame + w->frames, len = (uint32_t)w->len;
+    rec[0] = key ? FD_KEY : FD_DELTA;
+    memcpy(rec + 1, &number, 4);
+    memcpy(rec + 5, &len, 4);
+    if (fwrite(rec, 1, RECORD_HDR, w->f) != RECORD_HDR || fwrite(w->buf, 1, w->len, w->f) != w->len) return -1;
+    w->frames++;
+    w->bytes += RECORD_HDR + w->len;
+    return 0;
+}
+
+int frame_delta_writer_close(frame_delta_writer_t *w) {
+    int rc = w->f && !ferror(w->f) ? 0 : -1;
+    if (w->f && fclose(w->f) != 0) rc = -1;
+    buf_free(w->prev);
+    free(w->buf);
+    memset(w, 0, sizeof(*w));
+    return rc;
+}
+
+// ---- Reader -------------------------------------------------------------
+
+bool frame_delta_reader_open(frame_delta_reader_t *r, const char *path) {
+    memset(r, 0, sizeof(*r));
+    r->f = fopen(path, "rb");
+    if (!r->f) {
+        fprintf(stderr, "frame_delta: could not open %s\n", path);
+        return false;
+    }
+    if (fread(&r->hdr, sizeof(r->hdr), 1, r->f) != 1 || memcmp(r->hdr.magic, FD_MAGIC, 4) != 0 ||
+        r->hdr.version != FD_VERSION || !r->hdr.width || !r->hdr.height ||
+        r->hdr.width > 16384 || r->hdr.height > 16384) {
+        fprintf(stderr, "frame_delta: %s is not a version %u delta stream\n", path, FD_VERSION);
+        frame_delta_reader_close(r);
+        return false;
+    }
+    r->frame = buf_alloc(0, (size_t)r->hdr.width * r->hdr.height * sizeof(uint32_t), BUF_ZERO);
+    if (!r->frame) {
+        frame_delta_reader_close(r);
+        return false;
+    }
+    return true;
+}
+
+static int read_record_header(frame_delta_reader_t *r, uint8_t *kind, uint32_t *number, uint32_t *len) {
+    uint8_t rec[RECORD_HDR];
+    size_t n = fread(rec, 1, RECORD_HDR, r->f);
+    if (n == 0 && feof(r->f)) return 0;
+    if (n != RECORD_HDR) return -1;
+    *kind = rec[0];
+    memcpy(number, rec + 1, 4);
+    memcpy(len, rec + 5, 4);
+    return 1;
+}
+
+static int decode_payload(frame_delta_reader_t *r, uint8_t kind, uint32_t len) {
+    int width = (int)r->hdr.width, height = (int)r->hdr.height;
+    tile_grid_t g = tile_grid(width, height);
+    size_t map_len = ((size_t)g.cols * g.rows + 7) / 8;
+    if (len < map_len || !reserve(&r->buf, &r->cap, len) || fread(r->buf, 1, len, r->f) != len) return -1;
+    if (kind == FD_KEY) memset(r->frame, 0, (size_t)width * height * sizeof(uint32_t));
+
+    const uint8_t *p = r->buf + map_len, *end = r->buf + len;
+    for (int t = 0; t < g.cols * g.rows; t++) {
+        if (!(r->buf[t >> 3] >> (t & 7) & 1)) continue;
+        int x0 = (t % g.cols) * TILE_PX, y0 = (t / g.cols) * TILE_PX;
+        int x1 = x0 + TILE_PX < width ? x0 + TILE_PX : width;
+        int y1 = y0 + TILE_PX < height ? y0 + TILE_PX : height;
+        int tw = x1 - x0;
+        uint32_t count = (uint32_t)(tw * (y1 - y0)), done = 0;
+        while (done < count) {
+            uint32_t zeros, n;
+            if (!get_varint(&p, end, &zeros) || !get_varint(&p, end, &n)) return -1;
+            if (zeros > count - done || n > count - done - zeros || (size_t)(end - p) < n * sizeof(uint32_t)) return -1;
+            done += zeros;
+            for (uint32_t i = 0; i < n; i++, done++) {
+                uint32_t d;
+                memcpy(&d, p, 4);
+                p += 4;
+                r->frame[(size_t)(y0 + done / tw) * width + x0 + done % tw] ^= d;
+            }
+            if (!zeros && !n) return -1;   // no progress
+        }
+    }
+    return p == end ? 0 : -1;
+}
+
+int frame_delta_reader_next(frame_delta_reader_t *r) {
+    uint8_t kind;
+    uint32_t number, len;
+    int rc = read_record_header(r, &kind, &number, &len);
+    if (rc <= 0) return rc;
+    if (decode_payload(r, kind, len) != 0) return -1;
+    r->number = number;
+    return 1;
+}
+
+int frame_delta_reader_seek(frame_delta_reader_t *r, uint32_t number) {
+    // Scan the record headers for the last keyframe at or before `number`
+    if (fseeko(r->f, (off_t)sizeof(fd_header_t), SEEK_SET) != 0) return -1;
+    off_t key_at = -1, at = (off_t)sizeof(fd_header_t);
+    bool found = false;
+    for (;;) {
+        uint8_t kind;
+        uint32_t n, len;
+        if (read_record_header(r, &kind, &n, &len) <= 0) break;
+        if (n > number) break;
+        if (kind == FD_KEY) key_at = at;
+        if (n == number) found = true;
+        at += RECORD_HDR + (off_t)len;
+        if (fseeko(r->f, at, SEEK_SET) != 0) return -1;
+    }
+    if (!found || key_at < 0 || fseeko(r->f, key_at, SEEK_SET) != 0) return -1;
+    // Decode up to the frame before it
+    for (;;) {
+        off_t here = ftello(r->f);
+        uint8_t kind;
+        uint32_t n, len;
+        if (read_record_header(r, &kind, &n, &len) != 1) return -1;
+        if (n >= number) return fseeko(r->f, here, SEEK_SET);
+        if (decode_payload(r, kind, len) != 0) return -1;
+        r->number = n;
+    }
+}
+
+void frame_delta_reader_close(frame_delta_reader_t *r) {
+    if (r->f) fclose(r->f);
+    buf_free(r->frame);
+    free(r->buf);
+    memset(r, 0, sizeof(*r));
+}
@@ -0,0 +1,98 @@
+#include "include/frame_palette.h"
+#include <string.h>
+
+// Open-addressed color -> index table, twice the palette so probes stay short
+#define PAL_HASH_SIZE 1024
+#define PAL_EMPTY     0xFFFFFFFFu
+
+typedef struct {
+    uint32_t key[PAL_HASH_SIZE];   // 0x00RRGGBB or PAL_EMPTY
+    uint8_t  idx[PAL_HASH_SIZE];
+    int used;
+} pal_hash_t;
+
+static uint32_t pal_slot(uint32_t rgb) {
+    return (rgb * 2654435761u) >> 22;   // Fibonacci hash to 10 bits
+}
+
+// Closest palette entry to `rgb` (squared RGB distance); overflow colors only
+static uint8_t pal_nearest(const frame_palette_t *pal, uint32_t rgb) {
+    int r = rgb >> 16 & 0xFF, g = rgb >> 8 & 0xFF, b = rgb & 0xFF;
+    int best = 0, best_d = 1 << 30;
+    for (int i = 0; i < pal->count; i++) {
+        int dr = r - (int)(pal->rgb[i] >> 16 & 0xFF);
+        int dg = g - (int)(pal->rgb[i] >> 8 & 0xFF);
+        int db = b - (int)(pal->rgb[i] & 0xFF);
+        int d = dr * dr + dg * dg + db * db;
+        if (d < best_d) {
+            best_d = d;
+            best = i;
+        }
+    }
+    return (uint8_t)best;
+}
+
+static uint8_t pal_lookup(pal_hash_t *h, frame_palette_t *pal, uint32_t rgb) {
+    uint32_t s = pal_slot(rgb);
+    while (h->key[s] != PAL_EMPTY) {
+        if (h->key[s] == rgb) return h->idx[s];
+        s = (s + 1) & (PAL_HASH_SIZE - 1);
+    }
+    // New color: next entry, or the nearest one once the palette is full
+    // (CRT noise can bring thousands: past a full table they are not cached)
+    uint8_t idx;
+    if (pal->count < FRAME_PALETTE_MAX) {
+        idx = (uint8_t)pal->count;
+        pal->rgb[pal->count++] = rgb;
+    } else {
+        idx = pal_nearest(pal, rgb);
+        pal->overflow++;
+    }
+    if (h->used < PAL_HASH_SIZE - 1) {
+        h->key[s] = rgb;
+        h->idx[s] = idx;
+        h->used++;
+    }
+    return idx;
+}
+
+void frame_index(const uint32_t *pixels, const frame_tiles_t *tiles, int width, int height,
+                 int scale, uint8_t *out, frame_palette_t *pal) {
+    static pal_hash_t hash;   // writer thread only
+    memset(hash.key, 0xFF, sizeof(hash.key));
+    hash.used = 0;
+    pal->count = 0;
+    pal->overflow = 0;
+    pal_lookup(&hash, pal, 0);   // entry 0: black background
+
+    if (scale < 1) scale = 1;
+    int ow = width / scale, oh = height / scale;
+    bool use_tiles = tiles && width <= 32 << FRAME_TILE_SHIFT && height <= FRAME_TILE_ROWS_MAX << FRAME_TILE_SHIFT;
+    for (int oy = 0; oy < oh; oy++) {
+        int y = oy * scale;
+        const uint32_t *row = pixels + (size_t)y * width;
+        uint32_t mask = use_tiles ? tiles->rows[y >> FRAME_TILE_SHIFT] : 0xFFFFFFFFu;
+        uint8_t *o = out + (size_t)oy * ow;
+        uint32_t last = 0;       // runs of one color skip the hash
+        uint8_t last_idx = 0;
+        for (int ox = 0; ox < ow; ox++) {
+            int x = ox * scale;
+            if (!(mask >> (x >> FRAME_TILE_SHIFT) & 1)) {
+                o[ox] = 0;
+                continue;
+            }
+            uint32_t rgb = row[x] & 0xFFFFFFu;
+            if (rgb != last) {
+                last = rgb;
+                last_idx = pal_lookup(&hash, pal, rgb);
+            }
+            o[ox] = last_idx;
+        }
+    }
+}
+
+int frame_palette_depth(const frame_palette_t *pal) {
+    int depth = 1;
+    while ((1 << depth) < pal->count) depth++;
+    return depth;
+}
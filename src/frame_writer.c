@@ -0,0 +1,802 @@
+#ifdef __linux__
+#define _GNU_SOURCE   /* vmsplice, F_GETPIPE_SZ */
+#endif
+#include "include/frame_writer.h"
+#include "c/include/prof.h"
+#include "c/include/cpu_dispatch.h"
+#include "c/include/buf_alloc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/uio.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#ifdef CPU_SVE_KERNELS
+#include <arm_sve.h>
+#endif
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#define FRAME_WRITER_ALIGN 4096
+
+// ---- RGB24 packing ------------------------------------------------------
+// Little-endian 0xAARRGGBB sits in memory as B,G,R,A; PPM wants R,G,B.
+
+static void pack_rgb24_c(const uint32_t *pixels, uint8_t *out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t p = pixels[i];
+        out[0] = (uint8_t)(p >> 16);
+        out[1] = (uint8_t)(p >> 8);
+        out[2] = (uint8_t)p;
+        out += 3;
+    }
+}
+
+#if defined(__ARM_NEON)
+static void pack_rgb24_neon(const uint32_t *pixels, uint8_t *out, size_t count) {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t bgra = vld4q_u8((const uint8_t *)(pixels + i));
+        uint8x16x3_t rgb = { { bgra.val[2], bgra.val[1], bgra.val[0] } };
+        vst3q_u8(out + i * 3, rgb);
+    }
+    pack_rgb24_c(pixels + i, out + i * 3, count - i);
+}
+
+#ifdef CPU_SVE_KERNELS
+// The same structure load and store, all of the frame including the tail
+CPU_TARGET_SVE
+static void pack_rgb24_sve(const uint32_t *pixels, uint8_t *out, size_t count) {
+    for (uint64_t i = 0; i < count; i += svcntb()) {
+        svbool_t pg = svwhilelt_b8_u64(i, count);
+        svuint8x4_t bgra = svld4_u8(pg, (const uint8_t *)(pixels + i));
+        svst3_u8(pg, out + i * 3, svcreate3_u8(svget4_u8(bgra, 2), svget4_u8(bgra, 1), svget4_u8(bgra, 0)));
+    }
+}
+#endif
+#elif defined(__x86_64__) || defined(__i386__)
+#define FRAME_WRITER_X86 1
+// pshufb is SSSE3, not x86-64 baseline: these are built for their targets
+// and picked at run time, so the default gcc flags still get the shuffle.
+__attribute__((target("ssse3")))
+static void pack_rgb24_ssse3(const uint32_t *pixels, uint8_t *out, size_t count) {
+    const __m128i shuf = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                       -1, -1, -1, -1);
+    size_t i = 0;
+    // Each 16-byte store carries 12 good bytes; the 4-byte overhang lands on
+    // the next group's slot, so stop while a full group still follows.
+    for (; i + 8 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(pixels + i));
+        _mm_storeu_si128((__m128i *)(out + i * 3), _mm_shuffle_epi8(v, shuf));
+    }
+    pack_rgb24_c(pixels + i, out + i * 3, count - i);
+}
+
+// The same shuffle in both 128-bit lanes, then the two 12-byte runs moved
+// together: 24 good bytes of each 32-byte store
+__attribute__((target("avx2")))
+static void pack_rgb24_avx2(const uint32_t *pixels, uint8_t *out, size_t count) {
+    const __m256i shuf = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 8) {
+        __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(pixels + i)), shuf);
+        _mm256_storeu_si256((__m256i *)(out + i * 3), _mm256_permutevar8x32_epi32(v, join));
+    }
+    pack_rgb24_ssse3(pixels + i, out + i * 3, count - i);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(CPU_SVE_KERNELS)
+#define PACK_RGB24_ISAS (CPU_ISA_BIT(CPU_ISA_SCALAR) | CPU_ISA_BIT(CPU_ISA_NEON) | CPU_ISA_BIT(CPU_ISA_SVE))
+#elif defined(__ARM_NEON)
+#define PACK_RGB24_ISAS (CPU_ISA_BIT(CPU_ISA_SCALAR) | CPU_ISA_BIT(CPU_ISA_NEON))
+#elif defined(FRAME_WRITER_X86)
+#define PACK_RGB24_ISAS (CPU_ISA_BIT(CPU_ISA_SCALAR) | CPU_ISA_BIT(CPU_ISA_SSE42) | CPU_ISA_BIT(CPU_ISA_AVX2))
+#else
+#define PACK_RGB24_ISAS CPU_ISA_BIT(CPU_ISA_SCALAR)
+#endif
+
+typedef void (*pack_rgb24_fn)(const uint32_t *, uint8_t *, size_t);
+static const pack_rgb24_fn pack_rgb24_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = pack_rgb24_c,
+#if defined(__ARM_NEON)
+    [CPU_ISA_NEON] = pack_rgb24_neon,
+#ifdef CPU_SVE_KERNELS
+    [CPU_ISA_SVE] = pack_rgb24_sve,
+#endif
+#elif defined(FRAME_WRITER_X86)
+    [CPU_ISA_SSE42] = pack_rgb24_ssse3,
+    [CPU_ISA_AVX2] = pack_rgb24_avx2,
+#endif
+};
+
+void frame_pack_rgb24(const uint32_t *pixels, uint8_t *out, size_t count) {
+    static int isa = -1;
+    pack_rgb24_k[cpu_isa_resolve(&isa, PACK_RGB24_ISAS)](pixels, out, count);
+}
+
+// ---- YUV 4:2:0 ----------------------------------------------------------
+// BT.601 limited range in 8-bit fixed point (the swscale rgb24->yuv420p
+// default).  Every backend evaluates the same integer expressions, so Y4M
+// output is identical on NEON, SVE, SSE2 and plain C:
+//   Y = ((66R + 129G + 25B + 128) >> 8) + 16
+//   U = ((-38R - 74G + 112B + 128) >> 8) + 128
+//   V = ((112R - 94G - 18B + 128) >> 8) + 128
+// with U/V taken from the rounded mean of each 2x2 block.
+
+static inline uint8_t yuv_y(int r, int g, int b) { return (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16); }
+static inline uint8_t yuv_u(int r, int g, int b) { return (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128); }
+static inline uint8_t yuv_v(int r, int g, int b) { return (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128); }
+
+// Columns [x0, x1) of one row pair
+static void yuv420_rows_c(const uint32_t *row0, const uint32_t *row1, int x0, int x1,
+                          uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v) {
+    for (int x = x0; x < x1; x += 2) {
+        uint32_t p[4] = { row0[x], row0[x + 1], row1[x], row1[x + 1] };
+        int rs = 0, gs = 0, bs = 0;
+        for (int k = 0; k < 4; k++) {
+            int r = (p[k] >> 16) & 0xFF, g = (p[k] >> 8) & 0xFF, b = p[k] & 0xFF;
+            uint8_t *yo = k < 2 ? y0 : y1;
+            yo[x + (k & 1)] = yuv_y(r, g, b);
+            rs += r; gs += g; bs += b;
+        }
+        int r = (rs + 2) >> 2, g = (gs + 2) >> 2, b = (bs + 2) >> 2;
+        u[x / 2] = yuv_u(r, g, b);
+        v[x / 2] = yuv_v(r, g, b);
+    }
+}
+
+#if defined(__ARM_NEON)
+static inline uint8x16_t yuv_y_neon16(uint8x16x4_t p) {
+    uint8x8_t lo_r = vget_low_u8(p.val[2]), lo_g = vget_low_u8(p.val[1]), lo_b = vget_low_u8(p.val[0]);
+    uint8x8_t hi_r = vget_high_u8(p.val[2]), hi_g = vget_high_u8(p.val[1]), hi_b = vget_high_u8(p.val[0]);
+    uint16x8_t lo = vmlal_u8(vmlal_u8(vmull_u8(lo_r, vdup_n_u8(66)), lo_g, vdup_n_u8(129)), lo_b, vdup_n_u8(25));
+    uint16x8_t hi = vmlal_u8(vmlal_u8(vmull_u8(hi_r, vdup_n_u8(66)), hi_g, vdup_n_u8(129)), hi_b, vdup_n_u8(25));
+    uint8x8_t ylo = vadd_u8(vshrn_n_u16(vaddq_u16(lo, vdupq_n_u16(128)), 8), vdup_n_u8(16));
+    uint8x8_t yhi = vadd_u8(vshrn_n_u16(vaddq_u16(hi, vdupq_n_u16(128)), 8), vdup_n_u8(16));
+    return vcombine_u8(ylo, yhi);
+}
+
+static inline uint8x8_t yuv_chroma_neon(int16x8_t r, int16x8_t g, int16x8_t b, int16_t cr, int16_t cg, int16_t cb) {
+    int16x8_t acc = vmulq_n_s16(r, cr);
+    acc = vaddq_s16(acc, vmulq_n_s16(g, cg));
+    acc = vaddq_s16(acc, vmulq_n_s16(b, cb));
+    acc = vshrq_n_s16(vaddq_s16(acc, vdupq_n_s16(128)), 8);
+    return vqmovun_s16(vaddq_s16(acc, vdupq_n_s16(128)));
+}
+
+// 2x2 block mean of one channel across 16 columns of a row pair
+static inline int16x8_t yuv_mean_neon(uint8x16_t a, uint8x16_t b) {
+    uint16x8_t sum = vaddq_u16(vpaddlq_u8(a), vpaddlq_u8(b));
+    return vreinterpretq_s16_u16(vshrq_n_u16(vaddq_u16(sum, vdupq_n_u16(2)), 2));
+}
+
+// Columns [x0, x1) of one row pair; u and v point at the chroma row
+static void yuv420_rows_simd(const uint32_t *r0, const uint32_t *r1, int x0, int x1,
+                        uint8_t *y0, uint8_t *y1, uint8_t *uo, uint8_t *vo) {
+    int x = x0;
+    for (; x + 16 <= x1; x += 16) {
+        uint8x16x4_t a = vld4q_u8((const uint8_t *)(r0 + x));
+        uint8x16x4_t b = vld4q_u8((const uint8_t *)(r1 + x));
+        vst1q_u8(y0 + x, yuv_y_neon16(a));
+        vst1q_u8(y1 + x, yuv_y_neon16(b));
+        int16x8_t mr = yuv_mean_neon(a.val[2], b.val[2]);
+        int16x8_t mg = yuv_mean_neon(a.val[1], b.val[1]);
+        int16x8_t mb = yuv_mean_neon(a.val[0], b.val[0]);
+        vst1_u8(uo + x / 2, yuv_chroma_neon(mr, mg, mb, -38, -74, 112));
+        vst1_u8(vo + x / 2, yuv_chroma_neon(mr, mg, mb, 112, -94, -18));
+    }
+    yuv420_rows_c(r0, r1, x, x1, y0, y1, uo, vo);
+}
+
+#ifdef CPU_SVE_KERNELS
+// The NEON kernel's 16-bit arithmetic, widened with unpacks rather than
+// widening multiplies (those are SVE2) and narrowed back by uzp1
+CPU_TARGET_SVE
+static inline svuint16_t yuv_y_sve16(svuint16_t r, svuint16_t g, svuint16_t b) {
+    const svbool_t all = svptrue_b16();
+    svuint16_t acc = svmla_n_u16_x(all, svmla_n_u16_x(all, svmul_n_u16_x(all, r, 66), g, 129), b, 25);
+    return svadd_n_u16_x(all, svlsr_n_u16_x(all, svadd_n_u16_x(all, acc, 128), 8), 16);
+}
+
+CPU_TARGET_SVE
+static inline svuint8_t yuv_y_sve(svuint8x4_t p) {
+    svuint8_t r = svget4_u8(p, 2), g = svget4_u8(p, 1), b = svget4_u8(p, 0);
+    svuint16_t lo = yuv_y_sve16(svunpklo_u16(r), svunpklo_u16(g), svunpklo_u16(b));
+    svuint16_t hi = yuv_y_sve16(svunpkhi_u16(r), svunpkhi_u16(g), svunpkhi_u16(b));
+    return svuzp1_u8(svreinterpret_u8_u16(lo), svreinterpret_u8_u16(hi));
+}
+
+CPU_TARGET_SVE
+static inline svint16_t yuv_chroma_sve(svint16_t r, svint16_t g, svint16_t b, int16_t cr, int16_t cg, int16_t cb) {
+    const svbool_t all = svptrue_b16();
+    svint16_t acc = svmla_n_s16_x(all, svmla_n_s16_x(all, svmul_n_s16_x(all, r, cr), g, cg), b, cb);
+    acc = svasr_n_s16_x(all, svadd_n_s16_x(all, acc, 128), 8);
+    return svadd_n_s16_x(all, acc, 128);    // 16..240: no saturation to do
+}
+
+// 2x2 block mean of one channel: each 16-bit lane holds a column pair
+CPU_TARGET_SVE
+static inline svint16_t yuv_mean_sve(svuint8_t a, svuint8_t b) {
+    const svbool_t all = svptrue_b16();
+    svuint16_t a16 = svreinterpret_u16_u8(a), b16 = svreinterpret_u16_u8(b);
+    svuint16_t sum = svadd_u16_x(all, svadd_u16_x(all, svand_n_u16_x(all, a16, 0xFF), svlsr_n_u16_x(all, a16, 8)),
+                                      svadd_u16_x(all, svand_n_u16_x(all, b16, 0xFF), svlsr_n_u16_x(all, b16, 8)));
+    return svreinterpret_s16_u16(svlsr_n_u16_x(all, svadd_n_u16_x(all, sum, 2), 2));
+}
+
+CPU_TARGET_SVE
+static void yuv420_rows_sve(const uint32_t *r0, const uint32_t *r1, int x0, int x1,
+                            uint8_t *y0, uint8_t *y1, uint8_t *uo, uint8_t *vo) {
+    for (int64_t x = x0; x < x1; x += (int64_t)svcntb()) {
+        svbool_t pb = svwhilelt_b8_s64(x, x1), ph = svwhilelt_b16_s64(x / 2, x1 / 2);
+        svuint8x4_t a = svld4_u8(pb, (const uint8_t *)(r0 + x));
+        svuint8x4_t b = svld4_u8(pb, (const uint8_t *)(r1 + x));
+        svst1_u8(pb, y0 + x, yuv_y_sve(a));
+        svst1_u8(pb, y1 + x, yuv_y_sve(b));
+        svint16_t mr = yuv_mean_sve(svget4_u8(a, 2), svget4_u8(b, 2));
+        svint16_t mg = yuv_mean_sve(svget4_u8(a, 1), svget4_u8(b, 1));
+        svint16_t mb = yuv_mean_sve(svget4_u8(a, 0), svget4_u8(b, 0));
+        svst1b_s16(ph, (int8_t *)(uo + x / 2), yuv_chroma_sve(mr, mg, mb, -38, -74, 112));
+        svst1b_s16(ph, (int8_t *)(vo + x / 2), yuv_chroma_sve(mr, mg, mb, 112, -94, -18));
+    }
+}
+#endif
+#elif defined(__SSE2__)
+// Channels of 8 pixels as 16-bit lanes
+static inline void yuv_split_sse2(const uint32_t *p, __m128i *r, __m128i *g, __m128i *b) {
+    const __m128i lo8 = _mm_set1_epi32(0xFF);
+    __m128i a = _mm_loadu_si128((const __m128i *)p);
+    __m128i c = _mm_loadu_si128((const __m128i *)(p + 4));
+    *r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(a, 16), lo8), _mm_and_si128(_mm_srli_epi32(c, 16), lo8));
+    *g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(a, 8), lo8), _mm_and_si128(_mm_srli_epi32(c, 8), lo8));
+    *b = _mm_packs_epi32(_mm_and_si128(a, lo8), _mm_and_si128(c, lo8));
+}
+
+static inline __m128i yuv_y_sse2(__m128i r, __m128i g, __m128i b) {
+    // Max 220*255 + 128 fits an unsigned 16-bit lane
+    __m128i acc = _mm_mullo_epi16(r, _mm_set1_epi16(66));
+    acc = _mm_add_epi16(acc, _mm_mullo_epi16(g, _mm_set1_epi16(129)));
+    acc = _mm_add_epi16(acc, _mm_mullo_epi16(b, _mm_set1_epi16(25)));
+    acc = _mm_srli_epi16(_mm_add_epi16(acc, _mm_set1_epi16(128)), 8);
+    return _mm_add_epi16(acc, _mm_set1_epi16(16));
+}
+
+static inline __m128i yuv_chroma_sse2(__m128i r, __m128i g, __m128i b, short cr, short cg, short cb) {
+    __m128i acc = _mm_mullo_epi16(r, _mm_set1_epi16(cr));
+    acc = _mm_add_epi16(acc, _mm_mullo_epi16(g, _mm_set1_epi16(cg)));
+    acc = _mm_add_epi16(acc, _mm_mullo_epi16(b, _mm_set1_epi16(cb)));
+    acc = _mm_srai_epi16(_mm_add_epi16(acc, _mm_set1_epi16(128)), 8);
+    return _mm_add_epi16(acc, _mm_set1_epi16(128));
+}
+
+// 2x2 block means for 16 columns: row sums, then adjacent-pair sums
+static inline __m128i yuv_mean_sse2(__m128i a0, __m128i a1, __m128i b0, __m128i b1) {
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i lo = _mm_madd_epi16(_mm_add_epi16(a0, b0), ones);
+    __m128i hi = _mm_madd_epi16(_mm_add_epi16(a1, b1), ones);
+    __m128i sum = _mm_packs_epi32(lo, hi);
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+}
+
+// Columns [x0, x1) of one row pair; u and v point at the chroma row
+static void yuv420_rows_simd(const uint32_t *r0, const uint32_t *r1, int x0, int x1,
+                        uint8_t *y0, uint8_t *y1, uint8_t *uo, uint8_t *vo) {
+    int x = x0;
+    for (; x + 16 <= x1; x += 16) {
+        __m128i ar0, ag0, ab0, ar1, ag1, ab1, br0, bg0, bb0, br1, bg1, bb1;
+        yuv_split_sse2(r0 + x, &ar0, &ag0, &ab0);
+        yuv_split_sse2(r0 + x + 8, &ar1, &ag1, &ab1);
+        yuv_split_sse2(r1 + x, &br0, &bg0, &bb0);
+        yuv_split_sse2(r1 + x + 8, &br1, &bg1, &bb1);
+        _mm_storeu_si128((__m128i *)(y0 + x),
+                         _mm_packus_epi16(yuv_y_sse2(ar0, ag0, ab0), yuv_y_sse2(ar1, ag1, ab1)));
+        _mm_storeu_si128((__m128i *)(y1 + x),
+                         _mm_packus_epi16(yuv_y_sse2(br0, bg0, bb0), yuv_y_sse2(br1, bg1, bb1)));
+        __m128i mr = yuv_mean_sse2(ar0, ar1, br0, br1);
+        __m128i mg = yuv_mean_sse2(ag0, ag1, bg0, bg1);
+        __m128i mb = yuv_mean_sse2(ab0, ab1, bb0, bb1);
+        __m128i cu = yuv_chroma_sse2(mr, mg, mb, -38, -74, 112);
+        __m128i cv = yuv_chroma_sse2(mr, mg, mb, 112, -94, -18);
+        _mm_storel_epi64((__m128i *)(uo + x / 2), _mm_packus_epi16(cu, cu));
+        _mm_storel_epi64((__m128i *)(vo + x / 2), _mm_packus_epi16(cv, cv));
+    }
+    yuv420_rows_c(r0, r1, x, x1, y0, y1, uo, vo);
+}
+#endif
+
+#if defined(__ARM_NEON) && defined(CPU_SVE_KERNELS)
+#define YUV420_ISAS (CPU_ISA_BIT(CPU_ISA_SCALAR) | CPU_ISA_BIT(CPU_ISA_NEON) | CPU_ISA_BIT(CPU_ISA_SVE))
+#elif defined(__ARM_NEON)
+#define YUV420_ISAS (CPU_ISA_BIT(CPU_ISA_SCALAR) | CPU_ISA_BIT(CPU_ISA_NEON))
+#elif defined(__SSE2__)
+#define YUV420_ISAS (CPU_ISA_BIT(CPU_ISA_SCALAR) | CPU_ISA_BIT(CPU_ISA_SSE2))
+#else
+#define YUV420_ISAS CPU_ISA_BIT(CPU_ISA_SCALAR)
+#endif
+
+typedef void (*yuv420_rows_fn)(const uint32_t *, const uint32_t *, int, int, uint8_t *, uint8_t *, uint8_t *, uint8_t *);
+static const yuv420_rows_fn yuv420_rows_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = yuv420_rows_c,
+#if defined(__ARM_NEON)
+    [CPU_ISA_NEON] = yuv420_rows_simd,
+#ifdef CPU_SVE_KERNELS
+    [CPU_ISA_SVE] = yuv420_rows_sve,
+#endif
+#elif defined(__SSE2__)
+    [CPU_ISA_SSE2] = yuv420_rows_simd,
+#endif
+};
+
+static void yuv420_rows(const uint32_t *r0, const uint32_t *r1, int x0, int x1,
+                        uint8_t *y0, uint8_t *y1, uint8_t *uo, uint8_t *vo) {
+    static int isa = -1;
+    yuv420_rows_k[cpu_isa_resolve(&isa, YUV420_ISAS)](r0, r1, x0, x1, y0, y1, uo, vo);
+}
+
+void frame_pack_yuv420(const uint32_t *pixels, int width, int height,
+                       uint8_t *y, uint8_t *u, uint8_t *v) {
+    int cw = width / 2;
+    for (int row = 0; row < height; row += 2) {
+        const uint32_t *r0 = pixels + (size_t)row * width;
+        yuv420_rows(r0, r0 + width, 0, width, y + (size_t)row * width, y + (size_t)(row + 1) * width,
+                    u + (size_t)(row / 2) * cw, v + (size_t)(row / 2) * cw);
+    }
+}
+
+// ---- Dirty tiles --------------------------------------------------------
+
+#define TILE_PX (1 << FRAME_TILE_SHIFT)
+
+static bool tiles_fit(int width, int height) {
+    return width <= 32 * TILE_PX && height <= FRAME_TILE_ROWS_MAX * TILE_PX;
+}
+
+// Tiles in the run of equal bits that starts at tile column c
+static int tile_run(uint32_t mask, int c, int cols) {
+    uint32_t bits = mask >> c;
+    uint32_t other = (bits & 1) ? ~bits : bits;   // first tile that differs
+    int n = other ? __builtin_ctz(other) : 32 - c;
+    return n < cols - c ? n : cols - c;
+}
+
+void frame_tiles_mark_all(frame_tiles_t *t) {
+    memset(t->rows, 0xFF, sizeof(t->rows));
+}
+
+void frame_tiles_clear(frame_tiles_t *t, uint32_t *pixels, int width, int height) {
+    if (!t || !tiles_fit(width, height)) {
+        memset(pixels, 0, (size_t)width * height * sizeof(uint32_t));
+        if (t) frame_tiles_mark_all(t);   // can't track this frame size
+        return;
+    }
+    int cols = (width + TILE_PX - 1) >> FRAME_TILE_SHIFT;
+    int trows = (height + TILE_PX - 1) >> FRAME_TILE_SHIFT;
+    for (int ty = 0; ty < trows; ty++) {
+        uint32_t mask = t->rows[ty];
+        if (!mask) continue;
+        t->rows[ty] = 0;
+        int y1 = (ty + 1) * TILE_PX < height ? (ty + 1) * TILE_PX : height;
+        for (int c = 0; c < cols; ) {
+            int n = tile_run(mask, c, cols);
+            if (mask >> c & 1) {
+                int x0 = c * TILE_PX;
+                int x1 = (c + n) * TILE_PX < width ? (c + n) * TILE_PX : width;
+                for (int y = ty * TILE_PX; y < y1; y++)
+                    memset(pixels + (size_t)y * width + x0, 0, (size_t)(x1 - x0) * sizeof(uint32_t));
+            }
+            c += n;
+        }
+    }
+}
+
+// ---- Writer -------------------------------------------------------------
+
+bool frame_writer_init(frame_writer_t *fw, frame_format_t fmt, int width, int height, int fps) {
+    memset(fw, 0, sizeof(*fw));
+    if (fmt == FRAME_FMT_Y4M && ((width | height) & 1)) {
+        fprintf(stderr, "frame_writer: Y4M 4:2:0 needs even dimensions (%dx%d)\n", width, height);
+        return false;
+    }
+    char header[32] = "";
+    size_t pixels = (size_t)width * height;
+    size_t payload = pixels * 3;
+    switch (fmt) {
+    case FRAME_FMT_PPM:   snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height); break;
+    case FRAME_FMT_RGB24: break;
+    case FRAME_FMT_BGRA:  payload = pixels * 4; break;
+    case FRAME_FMT_Y4M:   strcpy(header, "FRAME\n"); payload = pixels + pixels / 2; break;
+    }
+    fw->fmt = fmt;
+    fw->width = width;
+    fw->height = height;
+    fw->fps = fps;
+    fw->header_len = strlen(header);
+    fw->frame_len = fw->header_len + payload;
+
+    // Pixel data starts on a page boundary; the header sits just before it.
+    // Both buffers share one block, so a full-size pair spans a huge page.
+    size_t bytes = FRAME_WRITER_ALIGN + fw->frame_len;
+    bytes = (bytes + FRAME_WRITER_ALIGN - 1) & ~(size_t)(FRAME_WRITER_ALIGN - 1);
+    uint8_t *p = buf_alloc(FRAME_WRITER_ALIGN, 2 * bytes, BUF_HUGE);
+    if (!p) {
+        fprintf(stderr, "frame_writer: out of memory\n");
+        return false;
+    }
+    for (int b = 0; b < 2; b++) {
+        fw->buf[b] = p + b * bytes + FRAME_WRITER_ALIGN - fw->header_len;
+        memcpy(fw->buf[b], header, fw->header_len);
+    }
+    return true;
+}
+
+void frame_writer_free(frame_writer_t *fw) {
+    if (fw->buf[0]) buf_free(fw->buf[0] + fw->header_len - FRAME_WRITER_ALIGN);
+    fw->buf[0] = fw->buf[1] = NULL;
+    free(fw->scaled);
+    fw->scaled = NULL;
+    fw->src_scale = 1;
+}
+
+bool frame_writer_set_source_scale(frame_writer_t *fw, int scale) {
+    free(fw->scaled);
+    fw->scaled = NULL;
+    fw->src_scale = scale > 1 ? scale : 1;
+    if (fw->src_scale == 1) return true;
+    fw->scaled = malloc((size_t)fw->width * fw->height * sizeof(uint32_t));
+    if (!fw->scaled) fprintf(stderr, "frame_writer: out of memory\n");
+    return fw->scaled != NULL;
+}
+
+// ---- Downscale ----------------------------------------------------------
+
+// Box filter over s x s blocks, two channels per 32-bit lane pair (SWAR):
+// each 16-bit lane holds at most 255 * s * s, so s <= 16.  Inlined into
+// every caller with constant sizes, so the common tier gets its own loop.
+static inline __attribute__((always_inline))
+void downscale_box(const uint32_t *src, const frame_tiles_t *tiles, int sw, int sh, int s, uint32_t *dst) {
+    int dw = sw / s, dh = sh / s;
+    uint32_t area = (uint32_t)(s * s), half = area / 2;
+    bool use_tiles = tiles && tiles_fit(sw, sh);
+    for (int oy = 0; oy < dh; oy++) {
+        int y = oy * s;
+        uint32_t *o = dst + (size_t)oy * dw;
+        // A block can straddle two tile rows when s does not divide 32
+        uint32_t mask = use_tiles ? tiles->rows[y >> FRAME_TILE_SHIFT] | tiles->rows[(y + s - 1) >> FRAME_TILE_SHIFT]
+                                  : 0xFFFFFFFFu;
+        if (!mask) {
+            memset(o, 0, (size_t)dw * sizeof(uint32_t));
+            continue;
+        }
+        for (int ox = 0; ox < dw; ox++) {
+            int x = ox * s;
+            if (!((mask >> (x >> FRAME_TILE_SHIFT) | mask >> ((x + s - 1) >> FRAME_TILE_SHIFT)) & 1)) {
+                o[ox] = 0;
+                continue;
+            }
+            uint32_t rb = 0, ag = 0;   // 0x00RR00BB and 0x00AA00GG sums
+            for (int dy = 0; dy < s; dy++) {
+                const uint32_t *p = src + (size_t)(y + dy) * sw + x;
+                for (int dx = 0; dx < s; dx++) {
+                    rb += p[dx] & 0x00FF00FFu;
+                    ag += p[dx] >> 8 & 0x00FF00FFu;
+                }
+            }
+            uint32_t r = ((rb >> 16) + half) / area, b = ((rb & 0xFFFF) + half) / area;
+            uint32_t a = ((ag >> 16) + half) / area, g = ((ag & 0xFFFF) + half) / area;
+            o[ox] = a << 24 | r << 16 | g << 8 | b;
+        }
+    }
+}
+
+void frame_downscale(const uint32_t *src, const frame_tiles_t *tiles, int src_w, int src_h,
+                     int scale, uint32_t *dst) {
+    if (scale == 2 && src_w == 800 && src_h == 600) downscale_box(src, tiles, 800, 600, 2, dst);   // preview tier
+    else downscale_box(src, tiles, src_w, src_h, scale, dst);
+}
+
+static int write_all(int fd, const uint8_t *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+#ifdef __linux__
+// vmsplice maps our pages into the pipe instead of copying them, so they
+// must stay untouched until the reader drains them.  When the pipe holds
+// less than one frame, finishing frame N+1 means frame N has left the pipe,
+// which is what the two alternating buffers rely on.
+static bool splice_usable(int fd, size_t frame_len) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISFIFO(st.st_mode)) return false;
+    int cap = fcntl(fd, F_GETPIPE_SZ);
+    return cap > 0 && (size_t)cap <= frame_len;
+}
+
+// Bytes handed to the pipe; short only if vmsplice failed
+static size_t splice_all(int fd, const uint8_t *p, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        struct iovec iov = { (void *)(p + sent), len - sent };
+        ssize_t n = vmsplice(fd, &iov, 1, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        sent += (size_t)n;
+    }
+    return sent;
+}
+#endif
+
+static void frame_writer_pack(const frame_writer_t *fw, const uint32_t *pixels, uint8_t *out) {
+    size_t count = (size_t)fw->width * fw->height;
+    switch (fw->fmt) {
+    case FRAME_FMT_PPM:
+    case FRAME_FMT_RGB24:
+        frame_pack_rgb24(pixels, out, count);
+        break;
+    case FRAME_FMT_BGRA:
+        // Already the byte order in memory; copied so vmsplice never sees
+        // a framebuffer the renderer is about to reuse
+        memcpy(out, pixels, count * 4);
+        break;
+    case FRAME_FMT_Y4M:
+        frame_pack_yuv420(pixels, fw->width, fw->height, out, out + count, out + count + count / 4);
+        break;
+    }
+}
+
+// Same bytes as frame_writer_pack, but runs of clean tiles are written as
+// black (RGB 0, or Y 16 / U V 128) straight from the map
+static void frame_writer_pack_tiles(const frame_writer_t *fw, const uint32_t *pixels,
+                                    const frame_tiles_t *tiles, uint8_t *out) {
+    int w = fw->width, h = fw->height;
+    int cols = (w + TILE_PX - 1) >> FRAME_TILE_SHIFT;
+    size_t count = (size_t)w * h;
+    uint8_t *u = out + count, *v = u + count / 4;
+    int step = fw->fmt == FRAME_FMT_Y4M ? 2 : 1;   // 4:2:0 works on row pairs
+
+    for (int y = 0; y < h; y += step) {
+        uint32_t mask = tiles->rows[y >> FRAME_TILE_SHIFT];
+        const uint32_t *row = pixels + (size_t)y * w;
+        for (int c = 0; c < cols; ) {
+            int n = tile_run(mask, c, cols);
+            bool dirty = mask >> c & 1;
+            int x0 = c * TILE_PX;
+            int x1 = (c + n) * TILE_PX < w ? (c + n) * TILE_PX : w;
+            size_t len = (size_t)(x1 - x0);
+            size_t at = (size_t)y * w + x0;
+            switch (fw->fmt) {
+            case FRAME_FMT_PPM:
+            case FRAME_FMT_RGB24:
+                if (dirty) frame_pack_rgb24(row + x0, out + at * 3, len);
+                else memset(out + at * 3, 0, len * 3);
+                break;
+            case FRAME_FMT_BGRA:
+                if (dirty) memcpy(out + at * 4, row + x0, len * 4);
+                else memset(out + at * 4, 0, len * 4);
+                break;
+            case FRAME_FMT_Y4M: {
+                uint8_t *uo = u + (size_t)(y / 2) * (w / 2), *vo = v + (size_t)(y / 2) * (w / 2);
+                if (dirty) {
+                    yuv420_rows(row, row + w, x0, x1, out + (size_t)y * w, out + (size_t)(y + 1) * w, uo, vo);
+                } else {
+                    memset(out + at, 16, len);
+                    memset(out + at + w, 16, len);
+                    memset(uo + x0 / 2, 128, len / 2);
+                    memset(vo + x0 / 2, 128, len / 2);
+                }
+                break;
+            }
+            }
+            c += n;
+        }
+    }
+}
+
+void frame_writer_pack_frame(const frame_writer_t *fw, const uint32_t *pixels,
+                             const frame_tiles_t *tiles, uint8_t *out) {
+    if (tiles && tiles_fit(fw->width, fw->height)) frame_writer_pack_tiles(fw, pixels, tiles, out);
+    else frame_writer_pack(fw, pixels, out);
+}
+
+int frame_writer_emit(frame_writer_t *fw, int fd, const uint32_t *pixels, const frame_tiles_t *tiles) {
+    if (fw->src_scale > 1) {
+        frame_downscale(pixels, tiles, fw->width * fw->src_scale, fw->height * fw->src_scale, fw->src_scale, fw->scaled);
+        pixels = fw->scaled;
+        tiles = NULL;
+    }
+    if (fw->tap && fw->tap(fw->tap_ctx, pixels, tiles) != 0) return -1;
+    if (fw->sink) return fw->sink(fw->sink_ctx, pixels, tiles);
+    if (fw->fmt == FRAME_FMT_Y4M && !fw->started) {
+        char header[96];
+        int n = snprintf(header, sizeof(header),
+                         "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n",
+                         fw->width, fw->height, fw->fps);
+        if (write_all(fd, (const uint8_t *)header, (size_t)n) != 0) return -1;
+        fw->started = true;
+    }
+    uint8_t *buf = fw->buf[fw->cur];
+    fw->cur ^= 1;
+    frame_writer_pack_frame(fw, pixels, tiles, buf + fw->header_len);
+    size_t sent = 0;
+#ifdef __linux__
+    if (splice_usable(fd, fw->frame_len)) sent = splice_all(fd, buf, fw->frame_len);
+#endif
+    // Plain write for files, and for whatever vmsplice left behind
+    return write_all(fd, buf + sent, fw->frame_len - sent);
+}
+
+int frame_writer_save(frame_writer_t *fw, const char *path, const uint32_t *pixels, const frame_tiles_t *tiles) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Could not create %s\n", path);
+        return -1;
+    }
+    fw->started = false;   // each file is a complete stream
+    int rc = frame_writer_emit(fw, fd, pixels, tiles);
+    if (close(fd) != 0) rc = -1;
+    if (rc != 0) fprintf(stderr, "Write failed for %s\n", path);
+    return rc;
+}
+
+// ---- Asynchronous queue -------------------------------------------------
+
+static void *frame_queue_main(void *arg) {
+    frame_queue_t *q = (frame_queue_t *)arg;
+    pthread_mutex_lock(&q->lock);
+    for (;;) {
+        while (q->written == q->submitted && !q->closing)
+            pthread_cond_wait(&q->cond, &q->lock);
+        if (q->written == q->submitted) break;
+        int idx = (int)(q->written % (unsigned)q->depth);
+        bool skip = q->error != 0;   // keep draining so the renderer never blocks
+        pthread_mutex_unlock(&q->lock);
+
+        int rc = 0;
+        if (!skip) {
+            PROF_SCOPE(emit, "frame_emit");
+            const frame_job_t *job = &q->jobs[idx];
+            const frame_tiles_t *tiles = q->tiles ? &q->tiles[idx] : NULL;
+            if (job->fd >= 0) {
+                rc = frame_writer_emit(q->fw, job->fd, q->slots[idx], tiles);
+            } else {
+                rc = frame_writer_save(q->fw, job->path, q->slots[idx], tiles);
+                if (rc == 0) fprintf(stderr, "✅ Generated %s\n", job->path);
+            }
+            // Bytes the frame put on its fd or file; a sink (encoder, GIF, digest) writes its own
+            if (rc == 0) {
+                prof_count(q->frames_counter, 1);
+                if (!q->fw->sink) prof_count(q->bytes_counter, q->fw->frame_len);
+            }
+        }
+
+        pthread_mutex_lock(&q->lock);
+        if (rc != 0 && q->error == 0) q->error = -1;
+        q->written++;
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+bool frame_queue_init(frame_queue_t *q, frame_writer_t *fw, int depth) {
+    memset(q, 0, sizeof(*q));
+    if (depth < 2) depth = 2;
+    q->fw = fw;
+    q->depth = depth;
+    q->frames_counter = prof_counter("frames_out");
+    q->bytes_counter = prof_counter("bytes_out");
+    q->slots = calloc((size_t)depth, sizeof(uint32_t *));
+    q->jobs = calloc((size_t)depth, sizeof(frame_job_t));
+    if (!q->slots || !q->jobs) goto fail;
+
+    // Slots hold the frame as rendered, before any source downscale
+    int sw = fw->width * (fw->src_scale > 1 ? fw->src_scale : 1);
+    int sh = fw->height * (fw->src_scale > 1 ? fw->src_scale : 1);
+    // One ring for every slot, on huge pages where the OS has them: the
+    // draw and write passes sweep whole frames, a 4K-page TLB miss every
+    // 1024 pixels otherwise
+    size_t bytes = (size_t)sw * sh * sizeof(uint32_t);
+    bytes = (bytes + BUF_ALIGN - 1) & ~(size_t)(BUF_ALIGN - 1);
+    uint8_t *ring = buf_alloc(0, (size_t)depth * bytes, BUF_HUGE);
+    if (!ring) goto fail;
+    for (int i = 0; i < depth; i++) q->slots[i] = (uint32_t *)(ring + (size_t)i * bytes);
+    // Fresh buffers hold garbage: every tile starts dirty so the first clear covers it
+    if (tiles_fit(sw, sh)) {
+        q->tiles = malloc((size_t)depth * sizeof(frame_tiles_t));
+        if (!q->tiles) goto fail;
+        for (int i = 0; i < depth; i++) frame_tiles_mark_all(&q->tiles[i]);
+    }
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    if (pthread_create(&q->thread, NULL, frame_queue_main, q) != 0) {
+        pthread_cond_destroy(&q->cond);
+        pthread_mutex_destroy(&q->lock);
+        goto fail;
+    }
+    return true;
+
+fail:
+    fprintf(stderr, "frame_writer: could not start the output queue\n");
+    if (q->slots) buf_free(q->slots[0]);
+    free(q->slots);
+    free(q->tiles);
+    free(q->jobs);
+    q->slots = NULL;
+    q->tiles = NULL;
+    q->jobs = NULL;
+    return false;
+}
+
+uint32_t *frame_queue_acquire(frame_queue_t *q) {
+    pthread_mutex_lock(&q->lock);
+    while (q->submitted - q->written == (unsigned)q->depth && q->error == 0)
+        pthread_cond_wait(&q->cond, &q->lock);
+    uint32_t *slot = q->error ? NULL : q->slots[q->submitted % (unsigned)q->depth];
+    pthread_mutex_unlock(&q->lock);
+    return slot;
+}
+
+frame_tiles_t *frame_queue_tiles(frame_queue_t *q) {
+    // Same slot frame_queue_acquire handed out: `submitted` only moves on submit
+    return q->tiles ? &q->tiles[q->submitted % (unsigned)q->depth] : NULL;
+}
+
+void frame_queue_submit(frame_queue_t *q, int fd, const char *path) {
+    // The slot is ours until `submitted` moves past it; fill the job unlocked
+    frame_job_t *job = &q->jobs[q->submitted % (unsigned)q->depth];
+    job->fd = fd;
+    if (fd < 0) snprintf(job->path, sizeof(job->path), "%s", path);
+    pthread_mutex_lock(&q->lock);
+    q->submitted++;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+}
+
+int frame_queue_drain(frame_queue_t *q) {
+    pthread_mutex_lock(&q->lock);
+    while (q->written != q->submitted)
+        pthread_cond_wait(&q->cond, &q->lock);
+    int rc = q->error;
+    pthread_mutex_unlock(&q->lock);
+    return rc;
+}
+
+int frame_queue_finish(frame_queue_t *q) {
+    if (!q->slots) return -1;
+    pthread_mutex_lock(&q->lock);
+    q->closing = true;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+    pthread_join(q->thread, NULL);
+
+    int rc = q->error;
+    buf_free(q->slots[0]);
+    free(q->slots);
+    free(q->tiles);
+    free(q->jobs);
+    q->slots = NULL;
+    q->tiles = NULL;
+    q->jobs = NULL;
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    return rc;
+}
@@ -0,0 +1,150 @@
+#include "include/gif_writer.h"
+#include <string.h>
+
+#define LZW_MAX_CODES 4096
+#define LZW_HASH_SIZE 5003        // prime above 4096, as the classic compress(1)
+
+// LSB-first code packer feeding 255-byte GIF data sub-blocks
+typedef struct {
+    FILE *f;
+    uint8_t block[255];
+    int len;
+    uint32_t acc;
+    int bits;
+} gif_bits_t;
+
+static void put_le16(FILE *f, int v) {
+    fputc(v & 0xFF, f);
+    fputc(v >> 8 & 0xFF, f);
+}
+
+static void put_byte(gif_bits_t *b, uint8_t v) {
+    b->block[b->len++] = v;
+    if (b->len == 255) {
+        fputc(255, b->f);
+        fwrite(b->block, 1, 255, b->f);
+        b->len = 0;
+    }
+}
+
+static void put_code(gif_bits_t *b, int code, int size) {
+    b->acc |= (uint32_t)code << b->bits;
+    b->bits += size;
+    while (b->bits >= 8) {
+        put_byte(b, b->acc & 0xFF);
+        b->acc >>= 8;
+        b->bits -= 8;
+    }
+}
+
+static void end_codes(gif_bits_t *b) {
+    if (b->bits > 0) put_byte(b, b->acc & 0xFF);
+    if (b->len) {
+        fputc(b->len, b->f);
+        fwrite(b->block, 1, (size_t)b->len, b->f);
+    }
+    fputc(0, b->f);   // block terminator
+}
+
+// LZW over the index stream; the string table is a hash of (prefix, index)
+static void lzw_encode(FILE *f, const uint8_t *in, size_t n, int depth) {
+    static int32_t key[LZW_HASH_SIZE];   // (prefix << 8 | index) + 1, 0 = empty
+    static uint16_t code[LZW_HASH_SIZE];
+    int clear = 1 << depth, stop = clear + 1;
+    int size = depth + 1, next = clear + 2;
+    gif_bits_t b = { .f = f };
+
+    fputc(depth, f);   // LZW minimum code size
+    memset(key, 0, sizeof(key));
+    put_code(&b, clear, size);
+    int prefix = in[0];
+    for (size_t i = 1; i < n; i++) {
+        int c = in[i];
+        int32_t k = (prefix << 8 | c) + 1;
+        uint32_t h = (uint32_t)(c << 4 ^ prefix) % LZW_HASH_SIZE;
+        while (key[h] && key[h] != k) h = (h + 1) % LZW_HASH_SIZE;
+        if (key[h]) {
+            prefix = code[h];
+            continue;
+        }
+        put_code(&b, prefix, size);
+        if (next < LZW_MAX_CODES) {
+            // The decoder widens codes one entry later than it adds them
+            if (next == 1 << size) size++;
+            key[h] = k;
+            code[h] = (uint16_t)next++;
+        } else {
+            put_code(&b, clear, size);
+            memset(key, 0, sizeof(key));
+            size = depth + 1;
+            next = clear + 2;
+        }
+        prefix = c;
+    }
+    put_code(&b, prefix, size);
+    put_code(&b, stop, size);
+    end_codes(&b);
+}
+
+bool gif_writer_open(gif_writer_t *g, const char *path, int width, int height, int fps) {
+    memset(g, 0, sizeof(*g));
+    g->f = fopen(path, "wb");
+    if (!g->f) {
+        fprintf(stderr, "gif_writer: could not create %s\n", path);
+        return false;
+    }
+    g->width = width;
+    g->height = height;
+    g->fps = fps > 0 ? fps : 1;
+    fwrite("GIF89a", 1, 6, g->f);
+    put_le16(g->f, width);
+    put_le16(g->f, height);
+    fputc(0x70, g->f);   // no global color table, 8-bit color resolution
+    fputc(0, g->f);      // background index
+    fputc(0, g->f);      // pixel aspect ratio: square
+    // NETSCAPE2.0 application extension: loop forever
+    fwrite("\x21\xFF\x0BNETSCAPE2.0\x03\x01", 1, 16, g->f);
+    put_le16(g->f, 0);
+    fputc(0, g->f);
+    return true;
+}
+
+int gif_writer_frame(gif_writer_t *g, const uint8_t *indices, const frame_palette_t *pal) {
+    // Delay from the running time, so rounding to centiseconds never drifts
+    unsigned t0 = (g->frames * 100u + g->fps / 2) / g->fps;
+    unsigned t1 = ((g->frames + 1) * 100u + g->fps / 2) / g->fps;
+    g->frames++;
+
+    // Graphic control extension: no disposal, no transparency
+    fwrite("\x21\xF9\x04\x04", 1, 4, g->f);
+    put_le16(g->f, (int)(t1 - t0));
+    fputc(0, g->f);
+    fputc(0, g->f);
+
+    // Image descriptor with a local color table of 2^depth entries
+    int depth = frame_palette_depth(pal);
+    fputc(0x2C, g->f);
+    put_le16(g->f, 0);
+    put_le16(g->f, 0);
+    put_le16(g->f, g->width);
+    put_le16(g->f, g->height);
+    fputc(0x80 | (depth - 1), g->f);
+    for (int i = 0; i < 1 << depth; i++) {
+        uint32_t rgb = i < pal->count ? pal->rgb[i] : 0;
+        fputc(rgb >> 16 & 0xFF, g->f);
+        fputc(rgb >> 8 & 0xFF, g->f);
+        fputc(rgb & 0xFF, g->f);
+    }
+    // LZW needs a minimum code size of 2 even for 2-color frames
+    lzw_encode(g->f, indices, (size_t)g->width * g->height, depth < 2 ? 2 : depth);
+    return ferror(g->f) ? -1 : 0;
+}
+
+int gif_writer_close(gif_writer_t *g) {
+    if (!g->f) return -1;
+    fputc(0x3B, g->f);   // trailer
+    int rc = ferror(g->f) ? -1 : 0;
+    if (fclose(g->f) != 0) rc = -1;
+    g->f = NULL;
+    return rc;
+}
@@ -0,0 +1,62 @@
+#ifndef AUDIO_FEATURES_H
+#define AUDIO_FEATURES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Per-video-frame audio features for the WAV-analysis fallback (no timeline
+ * sidecar).  audio_features_from_pcm builds them for the whole track at
+ * load time in one streaming pass; generate_frames --dump-features also
+ * caches them next to the audio as <audio>.feat, little-endian:
+ *   af_header_t
+ *   float rms[frames], onset[frames], bass[frames], treble[frames]
+ * The header carries an XXH64 hash of the PCM data; a cache whose hash
+ * does not match the WAV it sits next to is ignored.
+ */
+#define AF_MAGIC   "NDAF"
+#define AF_VERSION 3u      /* 2: band-split bass/treble, unscaled rms; 3: XXH64 key */
+
+/* Level window: sample_rate / AF_WINDOW_DIV (~33 ms) */
+#define AF_WINDOW_DIV 30u
+
+typedef struct {
+    char     magic[4];     /* AF_MAGIC */
+    uint32_t version;      /* AF_VERSION */
+    uint64_t wav_hash;     /* audio_features_hash of the PCM samples */
+    uint32_t fps;
+    uint32_t frames;
+} af_header_t;
+
+_Static_assert(sizeof(af_header_t) == 24, "af_header_t is the on-disk header");
+
+typedef struct {
+    uint32_t fps;
+    uint32_t frames;
+    float *rms;      /* mono RMS over the window centred on the frame */
+    float *onset;    /* 1.0 on detected onsets, else 0.0 */
+    float *bass;     /* RMS below ~150 Hz over the frame, 0..1 of the track's peak */
+    float *treble;   /* RMS of the rest over the frame, 0..1 of the track's peak */
+
+    /* loaded caches point into this read-only mapping; built ones own `rms` */
+    void  *map;
+    size_t map_len;
+} audio_features_t;
+
+uint64_t audio_features_hash(const void *data, size_t len);
+
+/* Features of `frames` video frames from interleaved stereo 16-bit PCM.
+   Levels come from exact integer energies: the window slides by adding
+   and dropping runs (SIMD pcm16_mono_energy), and the bands are an
+   integer moving-sum split, so every platform gets the same floats.
+   False for non-stereo input or on allocation failure. */
+bool audio_features_from_pcm(const int16_t *pcm, uint32_t pcm_frames, uint32_t channels,
+                             uint32_t sample_rate, uint32_t fps, uint32_t frames, audio_features_t *out);
+/* 0 on success, -1 on I/O error */
+int  audio_features_save(const char *path, const audio_features_t *f, uint64_t wav_hash);
+/* Map a cache from disk; false if missing, malformed or for another WAV */
+bool audio_features_load(const char *path, uint64_t wav_hash, uint32_t fps, audio_features_t *out);
+void audio_features_free(audio_features_t *f);
+
+#endif /* AUDIO_FEATURES_H */
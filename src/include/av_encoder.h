@@ -0,0 +1,50 @@
+#ifndef AV_ENCODER_H
+#define AV_ENCODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "frame_writer.h"
+
+/*
+ * In-process MP4 encoder (generate_frames --encode, built with LIBAV=1).
+ * libx264 video and AAC audio are muxed straight from the renderer: each
+ * ARGB framebuffer is packed once, as BT.601 limited-range YUV 4:2:0, into
+ * a pooled, refcounted AVFrame (the frame_writer Y4M packer, dirty tiles
+ * included) and handed to libavcodec without a further copy.  PCM is read
+ * from the caller's samples (the mmap'd WAV, or the notdeafbeef driver's
+ * in-memory track) and converted to planar float per AAC frame.  Audio is
+ * interleaved with video as the frames arrive and stops with the last
+ * video frame, as ffmpeg -shortest.
+ *
+ * Same streams as the shipped
+ *   ffmpeg ... -c:v libx264 -c:a aac -pix_fmt yuv420p -shortest
+ * with preset, CRF and encoder threads exposed for throughput tuning.
+ */
+typedef struct {
+    const char *preset;   /* x264 preset, NULL = "medium" (ffmpeg's default) */
+    int crf;              /* < 0: x264 default (23) */
+    int threads;          /* x264 threads, 0 = auto */
+    int audio_bitrate;    /* bits/s, 0 = 128000 */
+} av_encoder_opts_t;
+
+#define AV_ENCODER_OPTS_DEFAULT { NULL, -1, 0, 0 }
+
+typedef struct av_encoder av_encoder_t;
+
+/* Open `path` for `width`x`height` video at `fps` and the interleaved 16-bit
+   PCM in `pcm` (`frames` frames, kept alive until av_encoder_close).
+   `fw` must be a FRAME_FMT_Y4M writer of the same size; on success its sink
+   is set so frame_writer_emit / frame_queue_submit feed the encoder.
+   NULL (with a message on stderr) on failure. */
+av_encoder_t *av_encoder_open(const char *path, frame_writer_t *fw, int fps,
+                              const int16_t *pcm, uint32_t frames, uint32_t sample_rate,
+                              int channels, const av_encoder_opts_t *opt);
+
+/* Encode one framebuffer (the frame_writer sink); 0 on success, -1 on error */
+int av_encoder_video(av_encoder_t *e, const uint32_t *pixels, const frame_tiles_t *tiles);
+
+/* Flush both encoders, write the trailer and free; 0 if the file is complete */
+int av_encoder_close(av_encoder_t *e);
+
+#endif /* AV_ENCODER_H */
@@ -33,15 +33,50 @@ static inline int prng_range(prng_t* rng, int max) {
     return (int)(prng_next(rng) % (uint32_t)max);
 }
 
-// Global PRNG streams for different visual systems
-extern prng_t g_visual_prng;      // Main visual composition
-extern prng_t g_particle_prng;    // Particle system
-extern prng_t g_ship_prng;        // Ship generation
-extern prng_t g_boss_prng;        // Boss generation
-extern prng_t g_projectile_prng;  // Projectile system
-extern prng_t g_effects_prng;     // Visual effects
-
-// Initialize all PRNG streams from base seed
-void init_visual_prng_streams(uint32_t base_seed);
+// Counter-based draws: a pure function of (seed, stream, frame, index), so
+// frame N needs no replay of frames 0..N-1 and every thread or --range
+// worker sees the same value.  Two SplitMix64 finalizer rounds, the first
+// over (seed, stream), the second over that key and (frame, index).
+static inline uint64_t prng_mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint32_t prng_at(uint32_t seed, uint32_t stream, uint32_t frame, uint32_t index) {
+    uint64_t key = prng_mix64(((uint64_t)seed << 32 | stream) + 0x9E3779B97F4A7C15ULL);
+    return (uint32_t)(prng_mix64(key ^ ((uint64_t)frame << 32 | index)) >> 32);
+}
+
+// Float in [0.0, 1.0): the top 24 bits, exact in a float
+static inline float prng_at_float(uint32_t seed, uint32_t stream, uint32_t frame, uint32_t index) {
+    return (float)(prng_at(seed, stream, frame, index) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Int in [0, max): multiply-shift instead of the modulo of prng_range
+static inline int prng_at_range(uint32_t seed, uint32_t stream, uint32_t frame, uint32_t index, int max) {
+    if (max <= 0) return 0;
+    return (int)(((uint64_t)prng_at(seed, stream, frame, index) * (uint32_t)max) >> 32);
+}
+
+// Stream ids for prng_at: one per system so their draws never overlap
+enum {
+    PRNG_STREAM_VISUAL,      // Centerpiece composition
+    PRNG_STREAM_PARTICLE,    // Particle system
+    PRNG_STREAM_PROJECTILE,  // Projectile character and colour
+    PRNG_STREAM_EFFECTS,     // Degradation effects
+    PRNG_STREAM_AV_BEAT,     // audio_visual_bridge: beat explosions
+    PRNG_STREAM_AV_WAVE,     //   constant explosions
+    PRNG_STREAM_AV_SHAPES,   //   bass hit shapes
+    PRNG_STREAM_AV_EVENTS,   // vis_triggers: timeline event hits
+};
+
+// The counter key of one render (one per vis_ctx_t).  Ship and boss
+// designs are drawn once per render from their own prng_t sequences.
+typedef struct {
+    uint32_t seed;
+} prng_streams_t;
+
+void prng_streams_init(prng_streams_t *streams, uint32_t base_seed);
 
 #endif // DETERMINISTIC_PRNG_H
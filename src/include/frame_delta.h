@@ -0,0 +1,82 @@
+#ifndef FRAME_DELTA_H
+#define FRAME_DELTA_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include "frame_writer.h"
+
+/*
+ * Lossless archival frame stream (generate_frames --delta-out, read back by
+ * bin/delta_decode).  Frames are split into the 32x32 dirty tiles; a tile
+ * is stored as the XOR against the same tile of the previous frame
+ * (keyframes: against black), run-length coded as
+ *   { varint zeros, varint n, n x uint32 XOR words } ...
+ * until the tile's pixels are covered.  Unchanged tiles cost one bit, and
+ * a tile that is clean (all black) in both frames is skipped without being
+ * read.  Every `keyint` frames is a keyframe, so playback can start there.
+ * Little-endian:
+ *   fd_header_t
+ *   per frame: uint8 kind (FD_KEY/FD_DELTA), uint32 frame number,
+ *              uint32 payload bytes, payload =
+ *              changed-tile bitmap (tile raster order) + tile data
+ */
+#define FD_MAGIC   "NDFD"
+#define FD_VERSION 1u
+#define FD_KEY     1
+#define FD_DELTA   0
+
+typedef struct {
+    char     magic[4];      /* FD_MAGIC */
+    uint32_t version;       /* FD_VERSION */
+    uint32_t width, height;
+    uint32_t fps;
+    uint32_t keyint;        /* frames between keyframes */
+    uint32_t first_frame;   /* frame number of the first record (--range) */
+} fd_header_t;
+
+_Static_assert(sizeof(fd_header_t) == 28, "fd_header_t is the on-disk header");
+
+typedef struct {
+    FILE *f;
+    fd_header_t hdr;
+    uint32_t *prev;              /* last frame written */
+    frame_tiles_t prev_tiles;    /* its nonblack tiles (all set: unknown) */
+    uint8_t *buf;                /* payload of the frame being coded */
+    size_t cap, len;
+    unsigned frames;
+    uint64_t bytes;              /* file size so far */
+} frame_delta_writer_t;
+
+bool frame_delta_writer_open(frame_delta_writer_t *w, const char *path, int width, int height,
+                             int fps, int keyint, int first_frame);
+/* Carry on a stream `frames` frames and `bytes` bytes in (a checkpoint),
+   cutting off anything written after that.  `frames` must be a multiple
+   of the keyframe interval, so the next frame is a keyframe and needs no
+   previous frame; the header must match the other arguments. */
+bool frame_delta_writer_resume(frame_delta_writer_t *w, const char *path, int width, int height,
+                               int fps, int keyint, int first_frame, unsigned frames, uint64_t bytes);
+/* Append one frame; `tiles` as in frame_writer_emit (NULL: every tile dirty) */
+int  frame_delta_writer_frame(frame_delta_writer_t *w, const uint32_t *pixels, const frame_tiles_t *tiles);
+/* 0 if every frame reached the file */
+int  frame_delta_writer_close(frame_delta_writer_t *w);
+
+typedef struct {
+    FILE *f;
+    fd_header_t hdr;
+    uint32_t *frame;             /* ARGB of the last decoded frame */
+    uint32_t number;             /* its frame number */
+    uint8_t *buf;
+    size_t cap;
+} frame_delta_reader_t;
+
+/* false (with a message on stderr) if `path` is not a delta stream */
+bool frame_delta_reader_open(frame_delta_reader_t *r, const char *path);
+/* Decode the next frame into r->frame: 1, or 0 at the end, -1 if corrupt */
+int  frame_delta_reader_next(frame_delta_reader_t *r);
+/* Position so the next call returns frame `number`, decoding from the
+   keyframe before it; 0 on success, -1 if it is not in the stream */
+int  frame_delta_reader_seek(frame_delta_reader_t *r, uint32_t number);
+void frame_delta_reader_close(frame_delta_reader_t *r);
+
+#endif /* FRAME_DELTA_H */
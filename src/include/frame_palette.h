@@ -0,0 +1,37 @@
+#ifndef FRAME_PALETTE_H
+#define FRAME_PALETTE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "frame_writer.h"
+
+/*
+ * 8-bit palette-indexed frames.
+ * The art is a few dozen HSV-derived glyph colors on black, so a frame
+ * almost always fits a 256-entry palette exactly.  Indexing builds that
+ * palette per frame (entry 0 is always black, so clean tiles are written
+ * as 0 without reading them); colors past the 256th map to the nearest
+ * entry already in the palette.  Consumers work on a quarter of the bytes
+ * and convert through palette LUTs: the GIF preview writer
+ * (src/gif_writer.c, generate_frames --preview).
+ */
+#define FRAME_PALETTE_MAX 256
+
+typedef struct {
+    uint32_t rgb[FRAME_PALETTE_MAX];   /* 0x00RRGGBB */
+    int count;
+    int overflow;                      /* distinct colors that did not fit */
+} frame_palette_t;
+
+/* Index `width`x`height` ARGB `pixels` into `out`, keeping every `scale`th
+   pixel of every `scale`th row (nearest-neighbour downscale, 1 = full size),
+   so `out` holds (width / scale) * (height / scale) bytes.  Tiles clear in
+   `tiles` (NULL: all dirty) are index 0.  Fills `pal` for this frame. */
+void frame_index(const uint32_t *pixels, const frame_tiles_t *tiles, int width, int height,
+                 int scale, uint8_t *out, frame_palette_t *pal);
+
+/* Bits per index the palette needs (1..8) */
+int frame_palette_depth(const frame_palette_t *pal);
+
+#endif /* FRAME_PALETTE_H */
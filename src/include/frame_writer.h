@@ -0,0 +1,162 @@
+#ifndef FRAME_WRITER_H
+#define FRAME_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/*
+ * Whole-frame video output.
+ * The ARGB framebuffer is converted straight into a page-aligned buffer that
+ * already holds the per-frame header, and the frame leaves with one
+ * write(2).  On Linux pipes (generate_frames --pipe-* | ffmpeg) the buffer
+ * is handed over with vmsplice instead; the writer then alternates between
+ * two buffers so pages still referenced by the pipe are never overwritten
+ * while ffmpeg is reading them.
+ *
+ *   PPM    P6 header + RGB24 per frame (image2pipe, and the frame_*.ppm files)
+ *   RGB24  headerless rawvideo, ffmpeg -f rawvideo -pix_fmt rgb24
+ *   BGRA   headerless rawvideo, the framebuffer bytes as they are in memory
+ *   Y4M    YUV4MPEG2 4:2:0 (BT.601 limited range), half the bytes of RGB24
+ */
+typedef enum {
+    FRAME_FMT_PPM,
+    FRAME_FMT_RGB24,
+    FRAME_FMT_BGRA,
+    FRAME_FMT_Y4M
+} frame_format_t;
+
+/*
+ * Dirty-tile map: one bit per 32x32 tile, a 32-bit mask per tile row
+ * (frames up to 1024x1024).  The glyph primitives mark each tile they touch
+ * in the map vis_dirty_tiles points at, so a tile whose bit is clear is
+ * still all black (0) since its buffer was last cleared.  Clearing resets
+ * only the marked tiles, and packing writes clean tiles as constant black
+ * without reading them.  A NULL map means "every tile".
+ */
+#define FRAME_TILE_SHIFT    5
+#define FRAME_TILE_ROWS_MAX 32
+
+typedef struct {
+    uint32_t rows[FRAME_TILE_ROWS_MAX];
+} frame_tiles_t;
+
+typedef struct {
+    uint8_t *buf[2];
+    size_t   header_len;   /* per-frame header: P6 line, "FRAME\n" or none */
+    size_t   frame_len;    /* header + payload */
+    int      width, height, fps;
+    frame_format_t fmt;
+    bool     started;      /* Y4M stream header already sent */
+    int      cur;          /* buffer the next frame packs into */
+
+    /* In-process consumer (generate_frames --encode): when set, emit hands
+       the framebuffer to sink instead of packing it for `fd`, and the sink
+       packs it where it wants with frame_writer_pack_frame */
+    int    (*sink)(void *ctx, const uint32_t *pixels, const frame_tiles_t *tiles);
+    void    *sink_ctx;
+    /* Observer of every frame ahead of the output (generate_frames
+       --delta-out); a nonzero return fails the frame */
+    int    (*tap)(void *ctx, const uint32_t *pixels, const frame_tiles_t *tiles);
+    void    *tap_ctx;
+
+    /* frame_writer_set_source_scale: incoming frames are this many times
+       the writer's size and are box-filtered into `scaled` first */
+    int      src_scale;
+    uint32_t *scaled;
+} frame_writer_t;
+
+/* Map for a buffer whose contents are unknown (fresh allocation) */
+void frame_tiles_mark_all(frame_tiles_t *t);
+
+/* Zero the tiles marked in `t` (the whole frame if NULL) and reset the map */
+void frame_tiles_clear(frame_tiles_t *t, uint32_t *pixels, int width, int height);
+
+/* Pack `count` ARGB pixels (0xAARRGGBB) to R,G,B bytes */
+void frame_pack_rgb24(const uint32_t *pixels, uint8_t *out, size_t count);
+
+/* ARGB -> planar YUV 4:2:0, BT.601 limited range, 2x2 box-filtered chroma.
+   Width and height must be even. */
+void frame_pack_yuv420(const uint32_t *pixels, int width, int height,
+                       uint8_t *y, uint8_t *u, uint8_t *v);
+
+/* Pack one frame's payload in the writer's format into `out`, which holds
+   frame_len - header_len bytes (Y4M: the Y, U and V planes back to back) */
+void frame_writer_pack_frame(const frame_writer_t *fw, const uint32_t *pixels,
+                             const frame_tiles_t *tiles, uint8_t *out);
+
+/* Box-filter ARGB `src` (src_w x src_h) down by `scale` per axis into
+   `dst`; tiles clear in `tiles` come out black without being read.
+   800x600 -> 400x300 has a specialized path. */
+void frame_downscale(const uint32_t *src, const frame_tiles_t *tiles, int src_w, int src_h,
+                     int scale, uint32_t *dst);
+
+/* Y4M needs even dimensions; false (with a message) otherwise */
+bool frame_writer_init(frame_writer_t *fw, frame_format_t fmt, int width, int height, int fps);
+void frame_writer_free(frame_writer_t *fw);
+
+/* Frames handed to emit/save are `scale` times the writer's width and height
+   (the native render raster); everything downstream sees the downscaled
+   frame.  false if the scratch frame can't be allocated. */
+bool frame_writer_set_source_scale(frame_writer_t *fw, int scale);
+
+/* Emit one frame to `fd` in the writer's format; 0 on success, -1 on error.
+   Tiles clear in `tiles` are emitted as black without reading `pixels`. */
+int frame_writer_emit(frame_writer_t *fw, int fd, const uint32_t *pixels, const frame_tiles_t *tiles);
+
+/* Write `pixels` as a standalone file in the writer's format */
+int frame_writer_save(frame_writer_t *fw, const char *path, const uint32_t *pixels, const frame_tiles_t *tiles);
+
+/*
+ * Asynchronous frame output.
+ * A ring of `depth` framebuffers sits between the renderer and a writer
+ * thread that packs and emits them through a frame_writer_t, strictly in
+ * submission order.  frame_queue_acquire blocks while every slot is still
+ * waiting to be written, so a full ffmpeg pipe or a slow disk throttles the
+ * renderer instead of growing memory.
+ */
+#define FRAME_QUEUE_PATH_MAX 256
+
+typedef struct {
+    int  fd;                              /* >= 0: stream to this fd */
+    char path[FRAME_QUEUE_PATH_MAX];      /* otherwise: standalone file */
+} frame_job_t;
+
+typedef struct {
+    frame_writer_t *fw;
+    uint32_t **slots;
+    frame_tiles_t *tiles;                 /* per slot; NULL if the frame is too big */
+    frame_job_t *jobs;
+    int depth;
+
+    unsigned submitted;                   /* frames handed over */
+    unsigned written;                     /* frames the writer finished */
+    bool closing;
+    int error;                            /* sticky: first write failure */
+    int frames_counter, bytes_counter;    /* prof counters "frames_out", "bytes_out" */
+
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    pthread_t thread;
+} frame_queue_t;
+
+bool frame_queue_init(frame_queue_t *q, frame_writer_t *fw, int depth);
+
+/* Next framebuffer to render into; NULL once a write has failed */
+uint32_t *frame_queue_acquire(frame_queue_t *q);
+
+/* Dirty-tile map of the buffer frame_queue_acquire returned (may be NULL) */
+frame_tiles_t *frame_queue_tiles(frame_queue_t *q);
+
+/* Queue the acquired buffer for `fd`, or for `path` when fd < 0 */
+void frame_queue_submit(frame_queue_t *q, int fd, const char *path);
+
+/* Wait until every submitted frame has been written (a checkpoint);
+   0 if they all were */
+int frame_queue_drain(frame_queue_t *q);
+
+/* Drain, join the writer and free the ring; 0 if every frame was written */
+int frame_queue_finish(frame_queue_t *q);
+
+#endif /* FRAME_WRITER_H */
@@ -0,0 +1,75 @@
+#ifndef GENERATE_FRAMES_H
+#define GENERATE_FRAMES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "nft_metadata.h"
+#include "vis_ctx.h"
+#include "timeline.h"
+#include "vis_triggers.h"
+
+/*
+ * generate_frames as a library (compile generate_frames.c with
+ * -DGENERATE_FRAMES_NO_MAIN).  generate_frames_run takes the CLI's argv;
+ * with a frames_source_t the audio (and optionally the timeline) come from
+ * memory instead of argv[1] and its sidecars, and argv[1] is only a label.
+ * In pipe mode frames go to whatever STDOUT_FILENO is on entry; that fd is
+ * closed before returning so an encoder reading it sees EOF.  With
+ * --threads, forked workers return from this call too: compare getpid()
+ * with the caller's pid and _exit with the result in that case.
+ */
+typedef struct {
+    const void *wav;        /* complete WAV image, kept alive until return */
+    size_t wav_len;
+    const void *timeline;   /* binary timeline image, NULL: WAV analysis */
+    size_t timeline_len;
+} frames_source_t;
+
+int generate_frames_run(int argc, char *argv[], const frames_source_t *src);
+
+/*
+ * The frame composition core generate_frames_run draws with, for callers
+ * that run their own frame loop (bin/vis_main).  Frames of one seed are
+ * drawn (or only stepped) in order from 0; the audio signals come from the
+ * timeline sidecar when there is one, else from WAV analysis of the track
+ * loaded with load_wav_file.  Set up as generate_frames_run does: load the
+ * WAV, init_audio_visual_mapping, vis_ctx_init and vis_ctx_bind, then
+ * frames_core_init_scene; frames_core_bind_triggers once the core is
+ * filled in.
+ */
+typedef struct {
+    vis_ctx_t *ctx;
+    const timeline_signals_t *sig;  /* per-frame signals, NULL: tl or WAV */
+    const timeline_t *tl;           /* NULL: WAV analysis */
+    float step_sec;                 /* bass hit step, 60 / frames_core_bpm / 4 */
+    uint32_t seed;                  /* visual seed */
+    vis_triggers_t *triggers;       /* timeline event hits, NULL: onsets and the step clock */
+} frames_core_t;
+
+/* <audio>.tl, else the <audio>.json debug export; the last path tried is left in `path` */
+bool frames_core_load_timeline(const char *audio_path, timeline_t *tl, char *path, size_t path_len);
+
+/* Per-seed designs and the asm modules of the bound context */
+void frames_core_init_scene(vis_ctx_t *ctx, uint32_t seed);
+
+/* Track tempo: the timeline's, else the WAV's, else 120 */
+float frames_core_bpm(const timeline_t *tl);
+
+/* Spawn hits on the timeline's events (core->tl) instead of RMS onsets and
+ * the bass step clock; no-op without a timeline.  `vt` outlives the core. */
+void frames_core_bind_triggers(frames_core_t *core, vis_triggers_t *vt);
+
+/* Step the frame state only (a frame that isn't shown) */
+void frames_core_advance(const frames_core_t *core, int frame);
+
+/* Draw `frame` into `pixels` (already cleared) and step the frame state */
+void frames_core_render(const frames_core_t *core, uint32_t *pixels, int frame);
+
+/* VIS_BUDGET_ADAPTIVE: the measured render time of a frame, to scale the caps */
+void workload_budget_feedback(vis_ctx_t *ctx, double frame_ms);
+
+/* Visual half of the token traits: the ship and boss designs of `seed` */
+void generate_frames_traits(uint32_t seed, nft_traits_t *t);
+
+#endif /* GENERATE_FRAMES_H */
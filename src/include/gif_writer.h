@@ -0,0 +1,32 @@
+#ifndef GIF_WRITER_H
+#define GIF_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "frame_palette.h"
+
+/*
+ * Animated GIF89a writer for marketplace previews, no ffmpeg needed.
+ * Every frame carries its own local color table (the frame_index palette,
+ * at the depth it needs) and is LZW-coded in full, with no transparency
+ * or frame diffs.  Frame delays are in centiseconds, the GIF unit, and are
+ * derived from the running time, so a 15 fps preview alternates 7/6/7 cs
+ * and does not drift.  The animation loops forever.
+ */
+typedef struct {
+    FILE *f;
+    int width, height;
+    int fps;
+    unsigned frames;    /* written so far */
+} gif_writer_t;
+
+/* false (with a message on stderr) if `path` can't be created */
+bool gif_writer_open(gif_writer_t *g, const char *path, int width, int height, int fps);
+
+/* Append a width*height frame of palette indices; 0 on success, -1 on I/O error */
+int gif_writer_frame(gif_writer_t *g, const uint8_t *indices, const frame_palette_t *pal);
+
+/* Write the trailer and close; 0 if the whole file was written */
+int gif_writer_close(gif_writer_t *g);
+
+#endif /* GIF_WRITER_H */
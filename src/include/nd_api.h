@@ -0,0 +1,64 @@
+#ifndef ND_API_H
+#define ND_API_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * In-process pipeline API (libnotdeafbeef.so, `make libnotdeafbeef.so`),
+ * what segment, export_timeline and generate_frames do per seed without a
+ * process per step.  nd_api.py binds it with ctypes for batch_steps.py and
+ * batch_daemon.py.
+ *
+ * Seeds are the strings every binary takes (a tx hash, decimal or hex;
+ * seed.h).  Outputs go into caller buffers: nd_plan gives each buffer's
+ * exact size, so Python can hand in a bytearray or numpy array and the
+ * renderer writes straight into it.  Sizes and counts are >= 0, errors -1.
+ * The renderers keep static state: one call at a time per process.
+ */
+
+#define ND_API_VERSION 1
+
+typedef struct {
+    uint64_t audio_seed;        /* ndb_seed_t.audio */
+    uint32_t visual_seed;       /* ndb_seed_t.visual, batch_steps' "hashed seed" */
+    uint32_t sample_rate;
+    float bpm;
+    float root_freq;
+    uint32_t step_samples;
+    uint32_t seg_frames;        /* one loop */
+    uint32_t event_count;       /* one loop's scheduled notes */
+
+    /* The track of `repeat` loops nd_render_audio renders */
+    uint32_t track_frames;
+    uint32_t loop_start, loop_end;  /* smpl loop tag, end 0 if none */
+    size_t wav_bytes;               /* its WAV image */
+    size_t timeline_bytes;          /* nd_export_timeline's image */
+    uint32_t video_frames;          /* frames at VIS_FPS over the track */
+} nd_plan_t;
+
+int nd_api_version(void);
+
+/* The seed's plan and output sizes for a `repeat`-loop track (0 -> 1).
+   0, or -1 for a bad seed. */
+int nd_plan(const char *seed, uint32_t repeat, nd_plan_t *out);
+
+/* segment --repeat `repeat`: the complete WAV image (loop tag included)
+   into `wav`, `cap` >= plan.wav_bytes.  Bytes written, or -1. */
+int64_t nd_render_audio(const char *seed, uint32_t repeat, void *wav, size_t cap);
+
+/* export_timeline's binary sidecar.  Returns its size; written only when
+   `cap` is large enough (buf may be NULL to ask). */
+int64_t nd_export_timeline(const char *seed, void *buf, size_t cap);
+
+/* generate_frames' frames [first, first + count) of the track `wav` (an
+   nd_render_audio image; `timeline`, may be NULL, an nd_export_timeline
+   image drives the visuals instead of WAV analysis) into `pixels`, count
+   native VIS_WIDTH x VIS_HEIGHT 0xAARRGGBB frames back to back.  A slice
+   steps the frames before `first` without drawing them, so any split of
+   the frames draws the same pixels.  Frames drawn (fewer past the end),
+   or -1. */
+int nd_render_frames(const char *seed, const void *wav, size_t wav_len, const void *timeline,
+                     size_t timeline_len, int first, int count, uint32_t *pixels);
+
+#endif /* ND_API_H */
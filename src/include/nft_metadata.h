@@ -0,0 +1,59 @@
+#ifndef NFT_METADATA_H
+#define NFT_METADATA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Token metadata (<tx>_metadata.json) written from generator and renderer
+ * state rather than by probing the finished files: durations and the frame
+ * count are the numbers the renderer worked with, the audio traits come
+ * from the seed's generator_plan (tempo, key, scale, drum density) and the
+ * visual traits from its ship and boss templates.  Shared by
+ * generate_frames --metadata, notdeafbeef and batch_daemon.py.
+ */
+typedef struct {
+    /* audio: generator_plan of the audio seed */
+    float bpm;
+    float root_freq;
+    int scale;              /* scale_type_t */
+    int kick_hits, snare_hits, hat_hits;
+    float loop_sec;         /* one segment */
+
+    /* visual: the visual seed's ship_template_t / boss_template_t */
+    int ship_parts[4];      /* nose, wings, body, trail pattern */
+    int ship_size;
+    int formation;          /* boss formation, 0-7 */
+    int boss_shapes;        /* components at the roomiest budget */
+} nft_traits_t;
+
+typedef struct {
+    const char *tx_hash;
+    uint32_t visual_seed;
+    uint64_t audio_seed;
+    float audio_sec;
+    int frame_count;
+    int width, height, fps;
+    const char *video_path;     /* size reported when the file exists; NULL: none */
+    const char *audio_name;     /* NULL: no WAV delivered */
+    const char *metadata_name;
+    nft_traits_t traits;
+} nft_metadata_t;
+
+/* Audio half of the traits: generator_plan_variation of the audio seed */
+void nft_audio_traits(uint64_t audio_seed, nft_traits_t *t);
+/* Visual half: the ship and boss template picks of the visual seed (what
+   generate_frames_traits reports), without building the templates */
+void nft_visual_traits(uint32_t visual_seed, nft_traits_t *t);
+
+/* Trait value names, as the JSON writes them: scale_type_t, the boss
+   formation (0-7) and the ship's nose, wings, body and trail patterns */
+extern const char *const NFT_SCALE_NAMES[2];
+extern const char *const NFT_FORMATION_NAMES[8];
+extern const char *const NFT_SHIP_PART_NAMES[4][4];
+
+/* Write the JSON to `path` (through a .part file, renamed when complete);
+   0 on success */
+int nft_metadata_write(const char *path, const nft_metadata_t *m);
+
+#endif /* NFT_METADATA_H */
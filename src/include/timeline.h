@@ -2,14 +2,58 @@
 #define TIMELINE_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 
 typedef struct {
     uint32_t time;   /* samples */
     uint8_t  type;   /* 0..N mapped to strings */
     uint8_t  aux;
+    uint8_t  pad[2]; /* explicit so the binary sidecar can be mapped in place */
 } tl_event_t;
 
+/*
+ * Binary timeline sidecar (<audio>.tl), little-endian:
+ *   tl_bin_header_t
+ *   uint32_t   steps[steps_count]
+ *   uint32_t   beats[beats_count]
+ *   tl_event_t events[events_count]
+ * Written by src/c/src/timeline_export.c; timeline_load maps it and points
+ * the timeline arrays straight into the mapping.
+ */
+#define TL_BIN_MAGIC   "NDTL"
+#define TL_BIN_VERSION 1u
+
+typedef struct {
+    char     magic[4];      /* TL_BIN_MAGIC */
+    uint32_t version;       /* TL_BIN_VERSION */
+    uint64_t seed;
+    uint32_t sample_rate;
+    float    bpm;
+    uint32_t step_samples;
+    uint32_t total_samples;
+    uint32_t steps_count;
+    uint32_t beats_count;
+    uint32_t events_count;
+    uint32_t tail_samples;  /* ring past the loop (steps_count * step_samples)
+                               before exact silence; 0 in older sidecars */
+} tl_bin_header_t;
+
+_Static_assert(sizeof(tl_event_t) == 8, "tl_event_t is the on-disk event record");
+_Static_assert(sizeof(tl_bin_header_t) == 48, "tl_bin_header_t is the on-disk header");
+
+/* tl_event_t.type values with a meaning: kick, snare, hat, melody, mid, fm_bass */
+#define TL_EVENT_TYPES 6
+
+/* Query index built at load time: every type's event times, ascending,
+   each with its position in `events` (so consumers that must add in file
+   order can merge types back).  Type k is [start[k], start[k+1]) of both. */
+typedef struct {
+    uint32_t *times;
+    uint32_t *order;
+    uint32_t  start[TL_EVENT_TYPES + 1];
+} timeline_index_t;
+
 typedef struct {
     /* header */
     uint64_t seed;
@@ -17,6 +61,7 @@ typedef struct {
     float    bpm;
     uint32_t step_samples;
     uint32_t total_samples;
+    uint32_t tail_samples;    /* generator_plan_tail; 0 if the sidecar predates it */
 
     /* arrays (owned) */
     uint32_t *steps;      /* length steps_count */
@@ -25,18 +70,56 @@ typedef struct {
     uint32_t  beats_count;
     tl_event_t *events;   /* length events_count */
     uint32_t    events_count;
+    timeline_index_t index;   /* owned, for mapped sidecars too */
+
+    /* binary sidecar: arrays point into this read-only mapping */
+    void  *map;
+    size_t map_len;
 } timeline_t;
 
-/* Load a minimal JSON written by export_timeline.c.
-   Returns true on success; on success, out will own allocated arrays and must be freed with timeline_free(). */
+/* Load a timeline written by export_timeline.c: the binary sidecar (mapped
+   zero-copy) or the JSON debug export, detected from the file contents.
+   Returns true on success; on success, out owns its arrays (or mapping) and must be freed with timeline_free(). */
 bool timeline_load(const char *path, timeline_t *out);
+/* Same from a binary sidecar image in memory (timeline_export_bin_mem);
+   the arrays are copied, so `data` may be freed afterwards. */
+bool timeline_load_memory(const void *data, size_t len, timeline_t *out);
 void timeline_free(timeline_t *t);
 
+/* Cursor over one event type.  Windows that move forward cost amortized
+   O(1) (the cursor steps over what it passed); a backward or a long
+   forward jump re-seeks by binary search. */
+typedef struct {
+    const timeline_t *t;
+    uint8_t  type;
+    uint32_t pos;    /* first event of the type at or after the last t0 */
+} tl_cursor_t;
+
+void timeline_cursor_init(tl_cursor_t *c, const timeline_t *t, uint8_t type);
+/* Events of the cursor's type with t0 <= time < t1 (samples): returns how
+   many, with *times (and *order, if not NULL) at the first of them in the
+   index arrays. */
+uint32_t timeline_events_in_window(tl_cursor_t *c, uint32_t t0, uint32_t t1,
+                                   const uint32_t **times, const uint32_t **order);
+
 /* Helpers to derive frame-time signals from events (simple exponential decays). */
 float timeline_compute_level(const timeline_t *t, int frame_idx, int fps);
 float timeline_compute_glitch(const timeline_t *t, int frame_idx, int fps);
 float timeline_compute_hue(const timeline_t *t, int frame_idx, int fps);
 
+/* The same three signals precomputed for frames [0, frames): one sweep over
+   the time-sorted events per signal, carrying each decay sum forward with a
+   per-frame factor, so the render loop only does array lookups. */
+typedef struct {
+    float *level;    /* timeline_compute_level per frame */
+    float *glitch;   /* timeline_compute_glitch per frame */
+    float *hue;      /* timeline_compute_hue per frame */
+    int    frames;
+} timeline_signals_t;
+
+bool timeline_signals_build(const timeline_t *t, int frames, int fps, timeline_signals_t *out);
+void timeline_signals_free(timeline_signals_t *s);
+
 #endif /* TIMELINE_H */
 
 
@@ -0,0 +1,54 @@
+#ifndef VIS_BOSS_H
+#define VIS_BOSS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Boss shapes as cached sprites.
+//
+// draw_ascii_<shape>_asm re-derives its outline on every call: a LUT
+// rotation per vertex, then every edge stepped with two divides per glyph,
+// and one glitch-system call per glyph.  In the static boss formations a
+// shape's size and rotation are fixed per seed, so each one is resolved once
+// into its glyph cells (origins relative to the shape centre, base glyph,
+// vertex or edge alpha) and into a sprite: the outline drawn by the asm
+// kernel itself into a scratch frame, kept as a level map of the shape's
+// box (0 untouched, 1 vertex colour, 2 the dimmed edge colour).
+//
+// A frame glitches the cells with vis_glitch_cells.  When none of them
+// changes and the box is on screen, the sprite is blitted with a masked
+// select per pixel (NEON / SSE2, scalar tail), since glyphs overwrite
+// rather than blend; otherwise the cells are drawn one glyph at a time.
+// Either way the pixels and dirty tiles are the kernel's exactly.  A shape
+// whose cells don't reproduce the kernel's outline at build time stays live
+// and goes through the kernel every frame.
+
+#define VIS_BOSS_MAX_CELLS 40                       // Vertices and edge glyphs of one outline
+
+typedef struct {
+    int n;                                          // Cells, in the kernel's drawing order
+    int8_t x[VIS_BOSS_MAX_CELLS], y[VIS_BOSS_MAX_CELLS];  // Glyph origins from the centre
+    char glyph[VIS_BOSS_MAX_CELLS];
+    uint8_t alpha[VIS_BOSS_MAX_CELLS];              // 255 for vertices, edge alpha for edges
+    uint64_t lit;                                   // Bit i: cell i's base glyph isn't blank
+    int x0, y0, w, h;                               // Sprite box from the centre
+    uint8_t *levels;                                // w * h, row-major
+    bool live;                                      // Drawn by the asm kernel every frame
+    int shape, size;
+    float rotation;
+} vis_boss_sprite_t;
+
+// The asm kernel of shape 0-4 (triangle, diamond, hexagon, star, square)
+// at full alpha
+void vis_boss_shape_draw(uint32_t *pixels, int cx, int cy, int shape, int size, float rotation,
+                         uint32_t color, int frame);
+
+// Resolve shape/size/rotation into `sp`.  `scratch` is two cleared
+// VIS_WIDTH x VIS_HEIGHT frames, left cleared.
+void vis_boss_sprite_build(vis_boss_sprite_t *sp, int shape, int size, float rotation, uint32_t *scratch);
+void vis_boss_sprite_free(vis_boss_sprite_t *sp);
+
+// Same pixels as vis_boss_shape_draw(pixels, cx, cy, ..., color, frame)
+void vis_boss_sprite_draw(const vis_boss_sprite_t *sp, uint32_t *pixels, int cx, int cy, uint32_t color, int frame);
+
+#endif // VIS_BOSS_H
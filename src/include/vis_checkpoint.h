@@ -0,0 +1,46 @@
+#ifndef VIS_CHECKPOINT_H
+#define VIS_CHECKPOINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Render checkpoints (generate_frames --checkpoint).
+//
+// A checkpoint holds everything a render needs to carry on at one frame as
+// if it had never stopped: the frame counters, the context's per-frame
+// state (workload budget, live projectiles, the asm modules' blocks with
+// the particles and bass hits), the audio mapping's smoothing state, the
+// CRT trail and where each output file ends.  Everything derived from the
+// seed (ship, boss, sprites, terrain strip) is rebuilt by the normal setup
+// instead of stored.  Little-endian:
+//   char magic[4] "NDCK", uint32 version, uint64 fingerprint
+//   per section: char tag[4], uint32 bytes, payload
+// The fingerprint hashes the command line and the track, so a checkpoint
+// of a different render is never resumed.  A checkpoint replaces the
+// previous one with a rename, so a kill at any point leaves a whole file.
+
+#define VIS_CHECKPOINT_MAGIC   "NDCK"
+#define VIS_CHECKPOINT_VERSION 1u
+
+typedef struct {
+    uint64_t fingerprint;
+    uint8_t *buf;                 // Sections, as in the file after its header
+    size_t len, cap;
+} vis_checkpoint_t;
+
+void vis_checkpoint_init(vis_checkpoint_t *c, uint64_t fingerprint);
+void vis_checkpoint_free(vis_checkpoint_t *c);
+
+// Append a section; false when out of memory
+bool vis_checkpoint_put(vis_checkpoint_t *c, const char tag[4], const void *data, size_t bytes);
+// The payload of section `tag` if it is exactly `bytes` long, else NULL
+const void *vis_checkpoint_get(const vis_checkpoint_t *c, const char tag[4], size_t bytes);
+
+// Write <path>.tmp, fsync it and rename it over `path`; 0 on success
+int  vis_checkpoint_save(const vis_checkpoint_t *c, const char *path);
+// Read `path` into `c`; false (quietly if it doesn't exist) unless it is a
+// whole checkpoint with c's fingerprint
+bool vis_checkpoint_load(vis_checkpoint_t *c, const char *path);
+
+#endif // VIS_CHECKPOINT_H
@@ -0,0 +1,53 @@
+#ifndef VIS_COLOR_H
+#define VIS_COLOR_H
+
+#include <stdint.h>
+#include <math.h>
+
+// HSV -> 0xFFRRGGBB pixels for the C glue.
+// circle_color_asm goes through two asm calls, a stack struct and a six-way
+// branch per colour.  Here hue is quantized to 1/1024 turn and looked up in
+// a table of the fully saturated colours; saturation and value (Q8) are
+// applied with integer math: c = v * (1 - s * (1 - c_saturated)).  Every
+// step is an integer after the quantization, so vis_hsv_pixel and the
+// four-wide vis_hsv_pixels give the same pixels on every platform.
+//
+// Hues are turns (any real, wrapped); s and v are clamped to [0, 1].
+
+#define VIS_HUE_BITS 10
+
+// Saturated colour of each hue step as 0x00RRGGBB (static, read-only)
+extern const uint32_t vis_hue_lut[1 << VIS_HUE_BITS];
+
+// Nearest hue step.  Hues beyond +-2^14 turns (or NaN) map to step 0.
+static inline uint32_t vis_hue_index(float h) {
+    float q = h * (float)(1 << VIS_HUE_BITS);
+    if (!(fabsf(q) < 16777216.0f)) q = 0.0f;
+    return (uint32_t)(int32_t)floorf(q + 0.5f) & ((1u << VIS_HUE_BITS) - 1);
+}
+
+// [0, 1] as 0..256
+static inline uint32_t vis_unit_q8(float x) {
+    x = fminf(fmaxf(x, 0.0f), 1.0f);
+    return (uint32_t)(x * 256.0f + 0.5f);
+}
+
+// One channel: saturated level c8 (0..255) at Q8 saturation s and value v
+static inline uint32_t vis_hsv_channel(uint32_t c8, uint32_t s, uint32_t v) {
+    return (v * (255u * 256u - s * (255u - c8)) + 32768u) >> 16;
+}
+
+static inline uint32_t vis_hsv_pixel(float h, float s, float v) {
+    uint32_t base = vis_hue_lut[vis_hue_index(h)];
+    uint32_t sq = vis_unit_q8(s), vq = vis_unit_q8(v);
+    return 0xFF000000u |
+           vis_hsv_channel(base >> 16, sq, vq) << 16 |
+           vis_hsv_channel((base >> 8) & 0xFF, sq, vq) << 8 |
+           vis_hsv_channel(base & 0xFF, sq, vq);
+}
+
+// n colours at once (NEON / SSE2 four per step, AVX2 / AVX-512 eight / sixteen,
+// picked at run time); out[i] == vis_hsv_pixel(h[i], s[i], v[i])
+void vis_hsv_pixels(const float *h, const float *s, const float *v, uint32_t *out, int n);
+
+#endif // VIS_COLOR_H
@@ -0,0 +1,217 @@
+#ifndef VIS_CTX_H
+#define VIS_CTX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "deterministic_prng.h"
+#include "vis_terrain.h"
+#include "vis_boss.h"
+#include "vis_dlist.h"
+#include "vis_checkpoint.h"
+
+/*
+ * Render context: everything that changes from frame to frame for one
+ * rendering seed.  The C glue (generate_frames.c) keeps its state here
+ * directly, so any number of contexts can run side by side.
+ *
+ * The visual asm modules (terrain, glitch, particles, bass hits) still
+ * address their state through fixed __DATA symbols.  Each module brackets
+ * that state with _vis_<module>_state/_vis_<module>_state_end, and a context
+ * owns a private copy of all four blocks: vis_ctx_bind() parks the blocks of
+ * the previously bound context and loads its own, so contexts can be
+ * interleaved on one thread (multi-seed rendering) without the asm modules
+ * noticing.  Binding is cheap to repeat; it is a no-op for the context that
+ * is already live.
+ */
+
+// Output raster and frame rate.  The asm kernels draw the native
+// VIS_WIDTH x VIS_HEIGHT raster on the VIS_FPS frame clock (their fixed
+// geometry is the fast path), so other formats are derived from it: the
+// output is the native raster box-filtered down by `scale` and every
+// `step`th frame of the native clock, the frames in between only stepping
+// the render state.  Motion and timing therefore match the 60 fps render.
+typedef struct {
+    int width, height, fps;   // Output format
+    int scale;                // Native pixels per output pixel, per axis
+    int step;                 // Native frames per output frame
+} vis_format_t;
+
+// Common formats; vis_format_init accepts any native/N size and VIS_FPS/N rate
+#define VIS_FORMAT_FULL    "800x600@60"
+#define VIS_FORMAT_PREVIEW "400x300@30"
+
+// Parse "WxH@FPS", "WxH", "@FPS" or a tier name ("full", "preview");
+// false (with a message on stderr) for formats the native raster can't make
+bool vis_format_init(vis_format_t *f, const char *spec);
+
+// Workload budget: per-frame caps derived from audio intensity
+typedef struct {
+    int max_projectiles;      // Dynamic cap on active projectiles
+    int max_boss_shapes;      // Dynamic cap on boss formation complexity
+    int min_firing_cooldown;  // Dynamic minimum between shots
+    float complexity_factor;  // 0.0-1.0 based on audio intensity
+    bool draw_ship_boss;      // Ship and boss drawn (and the ship fires) this frame
+} workload_budget_t;
+
+// How update_workload_budget turns audio intensity into caps
+typedef enum {
+    VIS_BUDGET_AUDIO,         // Audio-driven caps sized for 60 fps (default)
+    VIS_BUDGET_MAX,           // Fixed maximum-quality caps for offline renders
+    VIS_BUDGET_ADAPTIVE       // Audio-driven caps scaled by measured frame cost
+} vis_budget_mode_t;
+
+typedef struct {
+    vis_budget_mode_t mode;
+    float target_ms;          // ADAPTIVE: per-frame render time to hold
+    float avg_ms;             // ADAPTIVE: smoothed measured render time
+    float quality;            // ADAPTIVE: 0-1, scales the audio-driven caps
+} vis_budget_policy_t;
+
+// Projectile fired by the ship
+typedef struct {
+    float x, y;           // Position
+    float vx, vy;         // Velocity
+    char character;       // ASCII character ('o', 'x', '-', '0', etc.)
+    uint32_t color;       // Projectile color
+    int life;             // Remaining life frames
+} projectile_t;
+
+#define MAX_PROJECTILES 4096
+
+// Projectile slots with an O(1) free list.  A new projectile takes the
+// lowest free slot (its index seeds the projectile's PRNG draw), found with
+// a two-level bitmap: one bit per slot, plus one bit per fully used 64-slot
+// word.  `live` lists the active slots in slot order, so update and draw
+// walk only those and in the same order a full slot scan would.
+typedef struct {
+    projectile_t slots[MAX_PROJECTILES];
+    uint16_t live[MAX_PROJECTILES];
+    int count;                                // Active projectiles
+    uint64_t used[MAX_PROJECTILES / 64];
+    uint64_t full;                            // Bit w: used[w] is all ones
+} projectile_pool_t;
+
+// Claim the lowest free slot and list it as live; -1 if the pool is full
+int projectile_pool_alloc(projectile_pool_t *pool);
+
+// Return a slot to the free list (the caller drops it from `live`)
+void projectile_pool_release(projectile_pool_t *pool, int slot);
+
+// Ship design resolved from the seed once per render
+#define SHIP_ROW_MAX (5 * 3)
+
+typedef struct {
+    // Nose, wings, body and trail, top to bottom.  Each of the 5 glyphs is
+    // followed by size-1 blanks, so a row is one 8 px glyph run
+    char rows[4][SHIP_ROW_MAX];
+    int row_len;                              // 5 * size
+    int size;                                 // Size multiplier 1-3
+    uint32_t primary_color;                   // Nose and body
+    uint32_t secondary_color;                 // Wings and trail
+    int parts[4];                             // Nose, wings, body, trail pattern indices
+} ship_template_t;
+
+// One boss shape at a fixed offset from the boss centre.  Its hue follows
+// the frame hue: ((boss_hue + hue_offset[0]) + hue_offset[1]), wrapped into
+// [0,1), then + hue_tint.  fixed_hue shapes ignore the frame and use color.
+typedef struct {
+    int shape;            // 0-4: triangle, diamond, hexagon, star, square
+    int size;
+    int dx, dy;
+    float rotation;
+    float hue_offset[2];
+    float hue_tint;
+    float sat, val;
+    bool fixed_hue;
+    uint32_t color;       // fixed_hue only
+} boss_part_t;
+
+#define BOSS_MAX_PARTS 8
+
+typedef struct {
+    int num_components;
+    int num_parts;        // Static formations only
+    boss_part_t parts[BOSS_MAX_PARTS];
+} boss_layout_t;
+
+// Boss formation resolved from the seed.  The component count depends on
+// the frame's workload budget, so both possible layouts are kept.
+typedef struct {
+    int formation;            // 0-7; 3 (spiral) and 7 (pulsing) animate per frame
+    float hue_offset;         // Added to the frame hue for the boss base hue
+    int base_size;
+    float base_rotation;
+    boss_layout_t layout[2];  // [budget.max_boss_shapes > 3]
+} boss_template_t;
+
+// The draws the templates' traits come from, shared with nft_visual_traits
+// so the trait index and a render always agree.  Ship: the first five
+// draws of prng_seed(seed), leaving rng on the palette draws.
+#define SHIP_SIZES { 1, 2, 3 }       // Size multiplier of each size pick
+
+static inline void ship_design_pick(prng_t *rng, int parts[4], int *size_pick) {
+    int nose = prng_range(rng, 4);
+    int body = prng_range(rng, 4);
+    int wing = prng_range(rng, 4);
+    int trail = prng_range(rng, 4);
+    *size_pick = prng_range(rng, 3);
+    parts[0] = nose;
+    parts[1] = wing;
+    parts[2] = body;
+    parts[3] = trail;
+}
+
+// Boss: formation and component count of one budget variant, the first
+// draws of prng_seed(seed + BOSS_SEED_OFFSET)
+#define BOSS_SEED_OFFSET 0x1000
+
+static inline void boss_design_pick(prng_t *rng, int variant, int *formation, int *num_components) {
+    *formation = prng_range(rng, 8);
+    int max_shapes = 3 + variant;
+    *num_components = 3 + prng_range(rng, max_shapes - 2);
+}
+
+// How the bottom terrain is drawn
+typedef enum {
+    VIS_TERRAIN_STRIP,        // Precomputed column ring, see vis_terrain.h (default)
+    VIS_TERRAIN_ASM           // draw_terrain_enhanced_asm, every cell every frame
+} vis_terrain_mode_t;
+
+typedef struct {
+    vis_format_t format;                      // Output size and rate (native after init)
+    workload_budget_t budget;
+    vis_budget_policy_t budget_policy;        // VIS_BUDGET_AUDIO after init
+    projectile_pool_t projectiles;
+    int last_shot_frame;                      // Frame when last shot was fired
+    prng_streams_t prng;
+    ship_template_t ship;                     // Per-seed designs, see *_template_init
+    boss_template_t boss;
+    vis_boss_sprite_t boss_sprites[2][BOSS_MAX_PARTS];  // Per boss.layout part, see boss_sprites_init
+    vis_terrain_mode_t terrain_mode;
+    vis_terrain_strip_t terrain;              // After init_terrain_asm, vis_terrain_strip_init
+    vis_dlist_t dl;                           // This frame's draws, see frames_core_render
+
+    uint8_t *asm_state;                       // Parked asm module blocks, vis_ctx_asm_state_bytes()
+} vis_ctx_t;
+
+// Fresh context for `seed`; false if the asm state copy can't be allocated.
+// The first call must happen before any *_asm init so it can capture the
+// modules' pristine state.
+bool vis_ctx_init(vis_ctx_t *ctx, uint32_t seed);
+void vis_ctx_free(vis_ctx_t *ctx);
+
+// Make `ctx` the context the asm modules operate on
+void vis_ctx_bind(vis_ctx_t *ctx);
+
+// Size of one context's copy of the asm module state
+size_t vis_ctx_asm_state_bytes(void);
+
+// Frame state of `ctx` into checkpoint sections, and back: budget, live
+// projectiles and the asm module blocks (live ones when ctx is bound).
+// Restore expects a context set up for the same seed; false if a section
+// is missing.
+bool vis_ctx_checkpoint(const vis_ctx_t *ctx, vis_checkpoint_t *c);
+bool vis_ctx_restore(vis_ctx_t *ctx, const vis_checkpoint_t *c);
+
+#endif // VIS_CTX_H
@@ -0,0 +1,77 @@
+#ifndef VIS_DLIST_H
+#define VIS_DLIST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "vis_terrain.h"
+#include "vis_boss.h"
+
+// Per-frame display list.
+//
+// The frame logic in generate_frames.c (positions, hues, PRNG draws, trig)
+// no longer calls the pixel writers: it emits typed records into the
+// context's list, and vis_dl_draw executes the list into the frame.  The
+// records are what the asm and C kernels take: the bottom terrain strip,
+// glyph runs (top terrain, ship rows), single glyphs (projectiles), shape
+// outlines drawn by their kernel, cached boss sprites and the bass hit
+// module's own draw.  Text of the runs lives once in the list's text pool.
+//
+// Culling happens on emit: a record whose kernel would draw nothing and
+// mark no dirty tile (a glyph origin off the raster, a run wholly off it,
+// a shape or sprite whose cells all fall outside) is never stored.  The
+// list executes in emission order: glyphs overwrite, so records that
+// overlap must keep their order, and the order generate_frames emits in
+// is already one batch per record type.  Each record carries the box of
+// pixels it can touch for backends that reorder or split the frame.
+
+typedef enum {
+    VIS_DL_TERRAIN,           // Bottom terrain: arg frame, f audio level, ptr strip (NULL: asm)
+    VIS_DL_GLYPH_RUN,         // n glyphs of text at arg, from (x, y) 8 px apart, opaque
+    VIS_DL_GLYPH,             // glyph c at (x, y), alpha 255
+    VIS_DL_SHAPE,             // shape outline through its kernel: shape, arg size, f rotation
+    VIS_DL_SPRITE,            // cached boss sprite ptr centred at (x, y)
+    VIS_DL_BASS_HITS,         // draw_bass_hits_asm of the list's frame
+    VIS_DL_TYPES
+} vis_dl_type_t;
+
+typedef struct {
+    uint8_t type;             // vis_dl_type_t
+    uint8_t shape;            // SHAPE: 0-4
+    char c;                   // GLYPH
+    uint16_t n;               // GLYPH_RUN
+    int16_t x, y;             // Glyph origin, shape or sprite centre
+    int16_t x0, y0, x1, y1;   // Pixels the record can touch, inclusive, unclipped
+    uint32_t color;
+    int32_t arg;
+    float f;
+    const void *ptr;
+} vis_dl_item_t;
+
+typedef struct {
+    int frame;                // Glitch frame of the shapes and sprites
+    vis_dl_item_t *items;
+    int count, cap;
+    char *text;
+    int text_len, text_cap;
+    int culled;               // Records dropped this frame
+} vis_dlist_t;
+
+// Empty the list for `frame` (storage is kept)
+void vis_dl_reset(vis_dlist_t *dl, int frame);
+void vis_dl_free(vis_dlist_t *dl);
+
+// Emitters.  False when the record was culled (or storage ran out).
+bool vis_dl_terrain(vis_dlist_t *dl, const vis_terrain_strip_t *strip, int frame, float audio_level);
+// Copy n glyphs into the text pool; the offset for vis_dl_glyph_run, -1 on failure
+int  vis_dl_text(vis_dlist_t *dl, const char *s, int n);
+bool vis_dl_glyph_run(vis_dlist_t *dl, int x, int y, int text, int n, uint32_t color);
+bool vis_dl_glyph(vis_dlist_t *dl, int x, int y, char c, uint32_t color);
+bool vis_dl_shape(vis_dlist_t *dl, int cx, int cy, int shape, int size, float rotation, uint32_t color);
+bool vis_dl_sprite(vis_dlist_t *dl, const vis_boss_sprite_t *sp, int cx, int cy, uint32_t color);
+bool vis_dl_bass_hits(vis_dlist_t *dl);
+
+// Execute the list into `pixels` (VIS_WIDTH x VIS_HEIGHT, the frame's dirty
+// tile map live), in order
+void vis_dl_draw(const vis_dlist_t *dl, uint32_t *pixels);
+
+#endif // VIS_DLIST_H
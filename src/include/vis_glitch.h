@@ -0,0 +1,51 @@
+#ifndef VIS_GLITCH_H
+#define VIS_GLITCH_H
+
+#include <stdint.h>
+
+// Glitch decisions for a row of cells at once.
+//
+// glitch_system.s answers one character per call: get_glitch_random_asm
+// (an LCG step on a position/frame hash), then a float compare of
+// (r % 10000) / 10000 against a glitch_config rate.  vis_glitch_row makes
+// the same decisions, with the same hash and the live config, for n cells
+// at x0, x0 + dx, ... on row y: the hashes, the modulo (a multiply-high)
+// and the rate compares run four cells per step (NEON / SSE2, scalar tail),
+// and only the cells that hit look up a replacement glyph.  Results match
+// the per-character calls exactly.
+//
+// Terrain cells follow draw_terrain_enhanced_asm: a matrix cascade (whole
+// 8 px columns, 10 frames at a time) overrides the substitution, and blank
+// cells may show digital noise.  Shape cells only substitute.
+
+typedef enum {
+    VIS_GLITCH_TERRAIN,       // terrain_glitch_rate, cascade and digital noise
+    VIS_GLITCH_SHAPE          // shape_glitch_rate
+} vis_glitch_set_t;
+
+// Per-cell result in `mask`
+enum {
+    VIS_GLITCH_KEEP,          // Draw the original glyph (or nothing, for a blank)
+    VIS_GLITCH_SUBST,         // Glitch character substituted
+    VIS_GLITCH_CASCADE,       // Matrix cascade character
+    VIS_GLITCH_NOISE          // Digital noise on a blank cell (drawn dimmed)
+};
+
+// chars[i] is the glyph at (x0 + i * dx, y): ' ' is blank and 0 is no cell
+// (left alone).  Writes the glyph to draw to out[i] and what happened to
+// mask[i]; returns the number of cells that aren't VIS_GLITCH_KEEP.  With
+// the glitch system uninitialized every cell is kept.
+int vis_glitch_row(vis_glitch_set_t set, const char *chars, int n, int x0, int dx, int y, int frame,
+                   uint8_t *mask, char *out);
+
+// The same for n cells at scattered positions (x[i], y[i]), one at a time:
+// shape outlines, whose cells share no row
+int vis_glitch_cells(vis_glitch_set_t set, const char *chars, const int *x, const int *y, int n, int frame,
+                     uint8_t *mask, char *out);
+
+// Keep every glyph while reference outlines are drawn: vis_glitch_hold
+// switches substitution off and returns the state vis_glitch_restore puts back
+uint32_t vis_glitch_hold(void);
+void vis_glitch_restore(uint32_t state);
+
+#endif // VIS_GLITCH_H
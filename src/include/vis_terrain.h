@@ -0,0 +1,50 @@
+#ifndef VIS_TERRAIN_H
+#define VIS_TERRAIN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Bottom terrain as a precomputed strip.
+//
+// draw_terrain_enhanced_asm re-derives every cell of the 27 visible tiles on
+// every frame: tile lookup, pattern choice, then a colour (HSV through two
+// asm calls) and three glitch-system calls per glyph.  Nothing but the
+// scroll offset, the colours and the glitch hashes depends on the frame, so
+// after init_terrain_asm the strip copies the scrolling terrain out of the
+// terrain module once per seed: a ring of 64 tiles x 4 glyph columns (8 px
+// each), every column holding its tile type and the glyphs of its rows.
+//
+// A frame then blits the 108 columns in the window at the scroll offset.
+// Colours come per frame from one batched vis_hsv_pixels call: by screen
+// column for flat tiles, by glyph row for slope-down tiles, one colour for
+// the other types and for noise.  The glitch system is applied on top as an
+// overlay, one vis_glitch_row pass per glyph row.  Glyph choices match the
+// asm kernel exactly; colours are vis_hsv_pixel's (within 2 levels of
+// hsv_to_rgb).
+
+#define VIS_TERRAIN_TILES    64                     // terrain_pattern length
+#define VIS_TERRAIN_TILE_COLS 4                     // 8 px glyph columns per 32 px tile
+#define VIS_TERRAIN_COLS     (VIS_TERRAIN_TILES * VIS_TERRAIN_TILE_COLS)
+#define VIS_TERRAIN_MAX_ROWS 6                      // Tallest tile (a high wall)
+#define VIS_TERRAIN_CELL_ROWS 2                     // Glyph rows drawn per 32 px tile row
+
+typedef struct {
+    uint8_t type;                                   // terrain_type_t; gaps have no rows
+    uint8_t height;                                 // Tile rows, 0..VIS_TERRAIN_MAX_ROWS
+    char glyph[VIS_TERRAIN_MAX_ROWS][VIS_TERRAIN_CELL_ROWS];  // ' ' shows digital noise
+} vis_terrain_column_t;
+
+typedef struct {
+    vis_terrain_column_t cols[VIS_TERRAIN_COLS];
+    float base_hue;
+    bool ready;                                     // Built from an initialized terrain module
+} vis_terrain_strip_t;
+
+// Copy the live terrain module (after init_terrain_asm, with the owning
+// context bound) into `s`; not ready if the module isn't initialized
+void vis_terrain_strip_init(vis_terrain_strip_t *s);
+
+// Same frame as draw_terrain_enhanced_asm(pixels, frame, audio_level)
+void vis_terrain_strip_draw(const vis_terrain_strip_t *s, uint32_t *pixels, int frame, float audio_level);
+
+#endif // VIS_TERRAIN_H
@@ -0,0 +1,51 @@
+#ifndef VIS_TRIG_H
+#define VIS_TRIG_H
+
+#include <stdint.h>
+
+// Deterministic sine/cosine for the C glue.
+// libm sin/cos may differ in the last bit between platforms and library
+// versions, which is enough to move a glyph by a pixel.  These are
+// computed from a fixed table with integer interpolation, so a render is
+// bit-identical everywhere.  (sqrt needs no replacement: IEEE 754 requires
+// it to be correctly rounded.)
+//
+// Angles are binary: a full turn is 2^32, so integer phases wrap for free.
+typedef uint32_t vis_angle_t;
+
+#define VIS_TRIG_TABLE_BITS 10
+#define VIS_ANGLE_PER_RAD   683565275.5764316   // 2^32 / (2*pi)
+
+// sin of each 1/1024 turn in Q16, plus one guard entry
+extern const int32_t vis_sin_table_q16[(1 << VIS_TRIG_TABLE_BITS) + 1];
+
+// Nearest binary angle at or below `rad`
+static inline vis_angle_t vis_angle_from_rad(double rad) {
+    double turns = rad * VIS_ANGLE_PER_RAD;
+    int64_t a = (int64_t)turns;
+    if ((double)a > turns) a--;   // floor
+    return (vis_angle_t)(uint64_t)a;
+}
+
+// sin(a) in Q16 (-65536..65536), linearly interpolated between table entries
+static inline int32_t vis_sin_q16(vis_angle_t a) {
+    uint32_t i = a >> (32 - VIS_TRIG_TABLE_BITS);
+    int32_t frac = (int32_t)((a >> (16 - VIS_TRIG_TABLE_BITS)) & 0xFFFF);
+    int32_t s0 = vis_sin_table_q16[i], s1 = vis_sin_table_q16[i + 1];
+    return s0 + (int32_t)(((int64_t)(s1 - s0) * frac) >> 16);
+}
+
+static inline int32_t vis_cos_q16(vis_angle_t a) {
+    return vis_sin_q16(a + 0x40000000u);
+}
+
+// Float versions taking radians
+static inline float vis_sinf(double rad) {
+    return (float)vis_sin_q16(vis_angle_from_rad(rad)) * (1.0f / 65536.0f);
+}
+
+static inline float vis_cosf(double rad) {
+    return (float)vis_cos_q16(vis_angle_from_rad(rad)) * (1.0f / 65536.0f);
+}
+
+#endif // VIS_TRIG_H
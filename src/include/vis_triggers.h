@@ -0,0 +1,37 @@
+#ifndef VIS_TRIGGERS_H
+#define VIS_TRIGGERS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "timeline.h"
+
+// Visual hits straight from the timeline sidecar's events.
+//
+// Without a sidecar the bridge guesses beats from the WAV's RMS
+// (detect_beat_onset) and bass hits come from update_bass_hits_asm's step
+// clock.  With one, the events say exactly when each voice fired: every
+// frame takes the events since the previous frame and spawns on them, on
+// the frame the event lands in.
+//
+//   kick     explosion burst (what the onset burst was), sized by the level
+//   melody   one explosion
+//   fm_bass  bass hit shape, seeded from the step it sits on
+//
+// Positions and hues are counter draws keyed by the event's sample time,
+// so a frame spawns the same whatever ran before it, and a forward-moving
+// frame loop walks the events with per-type cursors in amortized O(1).
+
+typedef struct {
+    const timeline_t *tl;
+    uint32_t seed;                       // visual seed
+    tl_cursor_t kick, melody, bass;
+} vis_triggers_t;
+
+// False (and nothing to dispatch) without a sample rate to place events by
+bool vis_triggers_init(vis_triggers_t *vt, const timeline_t *tl, uint32_t seed);
+
+// Spawn the hits of the events in frame `frame` at `fps`: those after the
+// previous frame's time, up to and including this one's
+void vis_triggers_frame(vis_triggers_t *vt, int frame, int fps, float level, float base_hue);
+
+#endif // VIS_TRIGGERS_H
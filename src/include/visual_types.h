@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+// Native render raster and clock; other output formats are derived from
+// them at output (vis_format_t in vis_ctx.h)
 #define VIS_FPS 60
 #define WIDTH 800
 #define HEIGHT 600
@@ -0,0 +1,39 @@
+#ifndef WAV_MAP_H
+#define WAV_MAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Read-only, zero-copy view of a 16-bit PCM WAV file.
+ * The file is mmap'd and its RIFF chunks are walked (fmt, data and the
+ * optional smpl loop written by segment --repeat/--bars), so extra chunks
+ * before or after the data are fine.  `samples` points into the mapping;
+ * pages are faulted in on first use and shared between processes rendering
+ * the same file.
+ */
+typedef struct {
+    const int16_t *samples;   /* interleaved, sample_count values */
+    uint32_t sample_count;    /* total samples (frames * channels) */
+    uint32_t frames;
+    uint32_t sample_rate;
+    uint16_t channels;
+    uint16_t bits_per_sample;
+
+    bool     has_loop;        /* smpl chunk found */
+    uint32_t loop_start;      /* frames, end exclusive */
+    uint32_t loop_end;
+
+    void  *map;
+    size_t map_len;
+} wav_map_t;
+
+/* Map `path`; false (with a message on stderr) if it is not 16-bit PCM */
+bool wav_map_open(const char *path, wav_map_t *out);
+/* Same view over a WAV image already in memory (`name` is for messages).
+   Nothing is mapped: `data` must outlive the view. */
+bool wav_map_memory(const void *data, size_t len, const char *name, wav_map_t *out);
+void wav_map_close(wav_map_t *w);
+
+#endif /* WAV_MAP_H */
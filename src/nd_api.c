@@ -0,0 +1,142 @@
+// In-process pipeline API (nd_api.h): the steps batch_steps.py used to run
+// as segment, export_timeline and generate_frames processes, on caller
+// buffers.  Audio goes through track_render into a wav_stream_open_buf
+// image, the timeline through timeline_export_bin_mem and the frames
+// through the frames core bin/vis_main draws with.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "include/nd_api.h"
+#include "include/visual_types.h"
+#include "include/vis_ctx.h"
+#include "include/frame_writer.h"
+#include "include/generate_frames.h"
+#include "generator_plan.h"
+#include "timeline_export.h"
+#include "track_render.h"
+#include "seed.h"
+
+// Audio analysis (simple_wav_reader.c, audio_visual_bridge.c)
+bool load_wav_memory(const void *data, size_t len, const char *name);
+bool analyse_audio_features(void);
+float get_audio_duration(void);
+void cleanup_audio_data(void);
+void init_audio_visual_mapping(void);
+
+extern uint32_t *vis_dirty_tiles;
+
+int nd_api_version(void) {
+    return ND_API_VERSION;
+}
+
+static track_opts_t nd_track_opts(uint32_t repeat) {
+    // segment --repeat N: no limiter, default voices
+    return (track_opts_t){ .repeat = repeat ? repeat : 1 };
+}
+
+int nd_plan(const char *seed, uint32_t repeat, nd_plan_t *out) {
+    ndb_seed_t s;
+    if (!seed || !out || ndb_seed_parse(seed, &s) != 0) return -1;
+    generator_plan_t plan;
+    if (generator_plan(s.audio, &plan) != 0) {
+        generator_plan_free(&plan);
+        return -1;
+    }
+    track_opts_t opt = nd_track_opts(repeat);
+    track_info_t info;
+    int rc = track_measure(s.audio, &opt, &info);
+    if (rc == 0) {
+        memset(out, 0, sizeof(*out));
+        out->audio_seed = s.audio;
+        out->visual_seed = s.visual;
+        out->sample_rate = SR;
+        out->bpm = plan.mt.bpm;
+        out->root_freq = plan.music.root_freq;
+        out->step_samples = plan.mt.step_samples;
+        out->seg_frames = info.seg_frames;
+        out->event_count = plan.patterns[PLAN_PAT_MAIN].count;
+        out->track_frames = info.total_frames;
+        out->loop_start = info.loop_start;
+        out->loop_end = info.loop_end;
+        out->wav_bytes = wav_image_bytes(info.total_frames, 2, info.loop_end != 0);
+        out->timeline_bytes = timeline_export_bin_mem(&plan, NULL, 0);
+        // generate_frames' count: the track's duration at VIS_FPS
+        out->video_frames = (uint32_t)((float)info.total_frames / SR * VIS_FPS);
+    }
+    generator_plan_free(&plan);
+    return rc;
+}
+
+int64_t nd_render_audio(const char *seed, uint32_t repeat, void *wav, size_t cap) {
+    ndb_seed_t s;
+    if (!seed || ndb_seed_parse(seed, &s) != 0) return -1;
+    wav_stream_t w;
+    if (wav_stream_open_buf(&w, 2, SR, wav, cap) != 0) return -1;
+    track_opts_t opt = nd_track_opts(repeat);
+    int rc = track_render(s.audio, &w, &opt, NULL);
+    if (wav_stream_close(&w) != 0) rc = -1;
+    return rc == 0 ? (int64_t)w.mem_len : -1;
+}
+
+int64_t nd_export_timeline(const char *seed, void *buf, size_t cap) {
+    ndb_seed_t s;
+    if (!seed || ndb_seed_parse(seed, &s) != 0) return -1;
+    generator_plan_t plan;
+    if (generator_plan(s.audio, &plan) != 0) {
+        generator_plan_free(&plan);
+        return -1;
+    }
+    size_t len = timeline_export_bin_mem(&plan, buf, buf ? cap : 0);
+    generator_plan_free(&plan);
+    return (int64_t)len;
+}
+
+int nd_render_frames(const char *seed, const void *wav, size_t wav_len, const void *timeline,
+                     size_t timeline_len, int first, int count, uint32_t *pixels) {
+    ndb_seed_t s;
+    if (!seed || ndb_seed_parse(seed, &s) != 0 || !wav || !pixels || first < 0 || count < 0) return -1;
+    if (!load_wav_memory(wav, wav_len, seed) || !analyse_audio_features()) return -1;
+
+    // Set up as generate_frames_run does for an in-memory track
+    init_audio_visual_mapping();
+    vis_ctx_t vis;
+    if (!vis_ctx_init(&vis, s.visual)) {
+        cleanup_audio_data();
+        return -1;
+    }
+    vis_ctx_bind(&vis);
+    timeline_t tl = {0};
+    bool have_timeline = timeline && timeline_load_memory(timeline, timeline_len, &tl);
+    frames_core_init_scene(&vis, s.visual);
+
+    int total = (int)(get_audio_duration() * VIS_FPS);
+    int end = first + count < total ? first + count : total;
+    timeline_signals_t sig = {0};
+    bool have_signals = have_timeline && end > 0 && timeline_signals_build(&tl, end, VIS_FPS, &sig);
+    const timeline_t *tl_src = have_timeline ? &tl : NULL;
+    frames_core_t core = { &vis, have_signals ? &sig : NULL, tl_src,
+                           60.0f / frames_core_bpm(tl_src) / 4.0f, s.visual, NULL };
+    vis_triggers_t triggers;
+    frames_core_bind_triggers(&core, &triggers);
+
+    int drawn = 0;
+    for (int f = 0; f < end; f++) {
+        if (f < first) {
+            frames_core_advance(&core, f);
+            continue;
+        }
+        uint32_t *frame = pixels + (size_t)drawn * VIS_WIDTH * VIS_HEIGHT;
+        frame_tiles_clear(NULL, frame, VIS_WIDTH, VIS_HEIGHT);
+        vis_dirty_tiles = NULL;
+        frames_core_render(&core, frame, f);
+        drawn++;
+    }
+
+    timeline_signals_free(&sig);
+    if (have_timeline) timeline_free(&tl);
+    vis_ctx_free(&vis);
+    cleanup_audio_data();
+    return drawn;
+}
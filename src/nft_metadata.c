@@ -0,0 +1,129 @@
+#include "include/nft_metadata.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "include/vis_ctx.h"
+#include "generator_plan.h"
+
+const char *const NFT_SCALE_NAMES[2] = { "major_pentatonic", "minor_pentatonic" };
+static const char *const NOTE_NAMES[12] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+
+// Pattern names, in ship_parts / boss_layout_build order
+const char *const NFT_SHIP_PART_NAMES[4][4] = {
+    { "classic", "wide", "star", "cross" },      // nose
+    { "simple", "double", "brackets", "curves" }, // wings
+    { "block", "circles", "stars", "lines" },     // body
+    { "waves", "lines", "stars", "dots" },        // trail
+};
+const char *const NFT_FORMATION_NAMES[8] = {
+    "star_burst", "cluster", "wing", "spiral", "grid", "chaos", "layered", "pulsing"
+};
+
+void nft_audio_traits(uint64_t audio_seed, nft_traits_t *t) {
+    rng_t rng = rng_seed(audio_seed);
+    plan_variation_t v;
+    generator_plan_variation(&rng, &v);   /* generator_plan's first draws, no events */
+    t->bpm = v.mt.bpm;
+    t->root_freq = v.music.root_freq;
+    t->scale = (int)v.music.scale_type;
+    t->kick_hits = v.kick_hits;
+    t->snare_hits = v.snare_hits;
+    t->hat_hits = v.hat_hits;
+    t->loop_sec = (float)v.mt.seg_frames / SR;
+}
+
+void nft_visual_traits(uint32_t visual_seed, nft_traits_t *t) {
+    static const int sizes[3] = SHIP_SIZES;
+    prng_t rng;
+    int size_pick, components;
+    prng_seed(&rng, visual_seed);
+    ship_design_pick(&rng, t->ship_parts, &size_pick);
+    t->ship_size = sizes[size_pick];
+    prng_seed(&rng, visual_seed + BOSS_SEED_OFFSET);
+    boss_design_pick(&rng, 1, &t->formation, &components);   /* the roomiest budget */
+    t->boss_shapes = components;
+}
+
+// du -h style size (the field generate_nft.sh always wrote)
+static void human_size(char *buf, size_t cap, long long bytes) {
+    const char *units = "BKMGT";
+    double v = (double)bytes;
+    int u = 0;
+    while (v >= 1024.0 && u < 4) {
+        v /= 1024.0;
+        u++;
+    }
+    if (u == 0) snprintf(buf, cap, "%lld", bytes);
+    else snprintf(buf, cap, v < 10.0 ? "%.1f%c" : "%.0f%c", v, units[u]);
+}
+
+static const char *base_name(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static const char *pick(const char *const *names, int count, int i) {
+    return i >= 0 && i < count ? names[i] : "unknown";
+}
+
+int nft_metadata_write(const char *path, const nft_metadata_t *m) {
+    const nft_traits_t *t = &m->traits;
+    char part[1024];
+    snprintf(part, sizeof(part), "%s.part", path);
+    FILE *f = fopen(part, "w");
+    if (!f) return -1;
+
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    int midi = (int)lroundf(69.0f + 12.0f * log2f(t->root_freq / 440.0f));
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"transaction_hash\": \"%s\",\n", m->tx_hash);
+    fprintf(f, "  \"seed\": \"%s\",\n", m->tx_hash);
+    fprintf(f, "  \"hashed_seed\": %u,\n", m->visual_seed);
+    fprintf(f, "  \"audio_seed\": \"0x%llx\",\n", (unsigned long long)m->audio_seed);
+    fprintf(f, "  \"audio_duration\": %.6f,\n", m->audio_sec);
+    fprintf(f, "  \"video_duration\": %.6f,\n", (double)m->frame_count / m->fps);
+    struct stat st;
+    if (m->video_path && stat(m->video_path, &st) == 0) {
+        char size[32];
+        human_size(size, sizeof(size), (long long)st.st_size);
+        fprintf(f, "  \"video_size\": \"%s\",\n", size);
+    }
+    fprintf(f, "  \"video_resolution\": \"%dx%d\",\n", m->width, m->height);
+    fprintf(f, "  \"frame_rate\": %d,\n", m->fps);
+    fprintf(f, "  \"frame_count\": %d,\n", m->frame_count);
+    fprintf(f, "  \"generated_at\": \"%s\",\n", stamp);
+    fprintf(f, "  \"assembly_version\": \"v1.0\",\n");
+    fprintf(f, "  \"reproducible\": true,\n");
+    fprintf(f, "  \"traits\": {\n");
+    fprintf(f, "    \"bpm\": %.2f,\n", t->bpm);
+    fprintf(f, "    \"root\": \"%s%d\",\n", NOTE_NAMES[(midi % 12 + 12) % 12], midi / 12 - 1);
+    fprintf(f, "    \"root_freq\": %.2f,\n", t->root_freq);
+    fprintf(f, "    \"scale\": \"%s\",\n", pick(NFT_SCALE_NAMES, 2, t->scale));
+    fprintf(f, "    \"kick_hits\": %d,\n", t->kick_hits);
+    fprintf(f, "    \"snare_hits\": %d,\n", t->snare_hits);
+    fprintf(f, "    \"hat_hits\": %d,\n", t->hat_hits);
+    fprintf(f, "    \"loop_duration\": %.6f,\n", t->loop_sec);
+    fprintf(f, "    \"formation\": \"%s\",\n", pick(NFT_FORMATION_NAMES, 8, t->formation));
+    fprintf(f, "    \"boss_shapes\": %d,\n", t->boss_shapes);
+    fprintf(f, "    \"ship\": {\"nose\": \"%s\", \"wings\": \"%s\", \"body\": \"%s\", \"trail\": \"%s\", \"size\": %d}\n",
+            pick(NFT_SHIP_PART_NAMES[0], 4, t->ship_parts[0]), pick(NFT_SHIP_PART_NAMES[1], 4, t->ship_parts[1]),
+            pick(NFT_SHIP_PART_NAMES[2], 4, t->ship_parts[2]), pick(NFT_SHIP_PART_NAMES[3], 4, t->ship_parts[3]),
+            t->ship_size);
+    fprintf(f, "  },\n");
+    fprintf(f, "  \"files\": {\n");
+    if (m->video_path) fprintf(f, "    \"video\": \"%s\",\n", base_name(m->video_path));
+    if (m->audio_name) fprintf(f, "    \"audio\": \"%s\",\n", base_name(m->audio_name));
+    fprintf(f, "    \"metadata\": \"%s\"\n", m->metadata_name ? m->metadata_name : base_name(path));
+    fprintf(f, "  }\n");
+    fprintf(f, "}\n");
+    if (fclose(f) != 0 || rename(part, path) != 0) {
+        remove(part);
+        return -1;
+    }
+    return 0;
+}
@@ -3,8 +3,58 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-/* Minimal, robust-enough JSON scanner for our known format. Avoids dependencies. */
+/* Point `out` at the arrays of a `len`-byte binary timeline image.
+   Returns 1 on success, 0 if it is not a valid v1 binary timeline. */
+static int timeline_view_bin(const void *buf, size_t len, timeline_t *out){
+    if(len < sizeof(tl_bin_header_t)) return 0;
+    const tl_bin_header_t *h = (const tl_bin_header_t*)buf;
+    size_t need = sizeof *h + ((size_t)h->steps_count + h->beats_count) * sizeof(uint32_t)
+                + (size_t)h->events_count * sizeof(tl_event_t);
+    if(memcmp(h->magic, TL_BIN_MAGIC, 4) != 0 || h->version != TL_BIN_VERSION || need != len)
+        return 0;
+
+    out->seed = h->seed;
+    out->sample_rate = h->sample_rate;
+    out->bpm = h->bpm;
+    out->step_samples = h->step_samples;
+    out->total_samples = h->total_samples;
+    out->tail_samples = h->tail_samples;
+    uint32_t *words = (uint32_t*)(h + 1);
+    out->steps = words;                     out->steps_count = h->steps_count;
+    out->beats = words + h->steps_count;    out->beats_count = h->beats_count;
+    out->events = (tl_event_t*)(out->beats + h->beats_count);
+    out->events_count = h->events_count;
+    return 1;
+}
+
+/* Binary sidecar: map the file and point the arrays into it (no parsing,
+   no copies).  Returns 1 on success, 0 if the file is not a valid v1
+   binary timeline (the caller then tries JSON). */
+static int timeline_map_bin(const char *path, timeline_t *out){
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return 0;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(tl_bin_header_t)){ close(fd); return 0; }
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) return 0;
+
+    if(!timeline_view_bin(map, len, out)){
+        munmap(map, len);
+        return 0;
+    }
+    out->map = map;
+    out->map_len = len;
+    return 1;
+}
+
+/* Minimal, robust-enough JSON scanner for our known format (debug export). Avoids dependencies. */
 
 static char *read_file_all(const char *path, size_t *len_out){
     FILE *f = fopen(path, "rb");
@@ -87,8 +137,55 @@ static int parse_header_seed(const char *s, uint64_t *out){
     return 1;
 }
 
+/* ---- query index ------------------------------------------------------ */
+
+/* Bucket the events by type, keeping file order within a type.  Exports
+   are time-sorted, so the buckets already are; an out-of-order (hand
+   edited) JSON gets an insertion sort by time.  Returns 1 on success. */
+static int timeline_build_index(timeline_t *t){
+    timeline_index_t *ix = &t->index;
+    uint32_t fill[TL_EVENT_TYPES] = {0};
+    for(uint32_t i = 0; i < t->events_count; i++)
+        if(t->events[i].type < TL_EVENT_TYPES) fill[t->events[i].type]++;
+    ix->start[0] = 0;
+    for(int k = 0; k < TL_EVENT_TYPES; k++){
+        ix->start[k + 1] = ix->start[k] + fill[k];
+        fill[k] = ix->start[k];
+    }
+    uint32_t n = ix->start[TL_EVENT_TYPES];
+    ix->times = malloc((n ? n : 1) * sizeof(uint32_t));
+    ix->order = malloc((n ? n : 1) * sizeof(uint32_t));
+    if(!ix->times || !ix->order) return 0;
+    for(uint32_t i = 0; i < t->events_count; i++){
+        uint8_t type = t->events[i].type;
+        if(type >= TL_EVENT_TYPES) continue;
+        ix->times[fill[type]] = t->events[i].time;
+        ix->order[fill[type]++] = i;
+    }
+    for(int k = 0; k < TL_EVENT_TYPES; k++){
+        for(uint32_t i = ix->start[k] + 1; i < ix->start[k + 1]; i++){
+            uint32_t tm = ix->times[i], ord = ix->order[i], j = i;
+            for(; j > ix->start[k] && ix->times[j - 1] > tm; j--){
+                ix->times[j] = ix->times[j - 1];
+                ix->order[j] = ix->order[j - 1];
+            }
+            ix->times[j] = tm;
+            ix->order[j] = ord;
+        }
+    }
+    return 1;
+}
+
+/* Loaded arrays in, index built or everything released */
+static bool timeline_finish_load(timeline_t *t){
+    if(timeline_build_index(t)) return true;
+    timeline_free(t);
+    return false;
+}
+
 bool timeline_load(const char *path, timeline_t *out){
     memset(out, 0, sizeof(*out));
+    if(timeline_map_bin(path, out)) return timeline_finish_load(out);
     size_t len = 0; char *txt = read_file_all(path, &len);
     if(!txt) return false;
     if(!parse_header_seed(txt, &out->seed)) { free(txt); return false; }
@@ -96,6 +193,7 @@ bool timeline_load(const char *path, timeline_t *out){
     if(!parse_header_f(txt, "bpm", &out->bpm)) { free(txt); return false; }
     if(!parse_header_u32(txt, "step_samples", &out->step_samples)) { free(txt); return false; }
     if(!parse_header_u32(txt, "total_samples", &out->total_samples)) { free(txt); return false; }
+    if(!parse_header_u32(txt, "tail_samples", &out->tail_samples)) out->tail_samples = 0;  /* optional */
     if(!parse_uint_array(txt, "steps", &out->steps, &out->steps_count)) { free(txt); return false; }
     if(!parse_uint_array(txt, "beats", &out->beats, &out->beats_count)) { free(txt); return false; }
 
@@ -127,40 +225,127 @@ bool timeline_load(const char *path, timeline_t *out){
             uint8_t type = 255;
             if(strcmp(tbuf, "kick")==0) type = 0; else if(strcmp(tbuf, "snare")==0) type = 1; else if(strcmp(tbuf, "hat")==0) type = 2; else if(strcmp(tbuf, "melody")==0) type = 3; else if(strcmp(tbuf, "mid")==0) type = 4; else if(strcmp(tbuf, "fm_bass")==0) type = 5; else type = 254;
             uint8_t aux = (uint8_t)strtoul(auxkey + 7, NULL, 10);
-            events[idx++] = (tl_event_t){ time, type, aux };
+            events[idx++] = (tl_event_t){ time, type, aux, {0, 0} };
         }
         p = obj_end + 1;
     }
     out->events = events; out->events_count = idx;
     free(txt);
-    return true;
+    return timeline_finish_load(out);
+}
+
+bool timeline_load_memory(const void *data, size_t len, timeline_t *out){
+    memset(out, 0, sizeof *out);
+    timeline_t view = {0};
+    if(!data || !timeline_view_bin(data, len, &view)) return false;
+    *out = view;
+    out->steps = malloc((view.steps_count ? view.steps_count : 1) * sizeof(uint32_t));
+    out->beats = malloc((view.beats_count ? view.beats_count : 1) * sizeof(uint32_t));
+    out->events = malloc((view.events_count ? view.events_count : 1) * sizeof(tl_event_t));
+    if(!out->steps || !out->beats || !out->events){
+        timeline_free(out);
+        return false;
+    }
+    memcpy(out->steps, view.steps, view.steps_count * sizeof(uint32_t));
+    memcpy(out->beats, view.beats, view.beats_count * sizeof(uint32_t));
+    memcpy(out->events, view.events, view.events_count * sizeof(tl_event_t));
+    return timeline_finish_load(out);
 }
 
 void timeline_free(timeline_t *t){
     if(!t) return;
+    free(t->index.times);
+    free(t->index.order);
+    memset(&t->index, 0, sizeof t->index);
+    if(t->map){
+        munmap(t->map, t->map_len);
+        memset(t, 0, sizeof *t);
+        return;
+    }
     free(t->steps); t->steps = NULL; t->steps_count = 0;
     free(t->beats); t->beats = NULL; t->beats_count = 0;
     free(t->events); t->events = NULL; t->events_count = 0;
 }
 
+void timeline_cursor_init(tl_cursor_t *c, const timeline_t *t, uint8_t type){
+    c->t = t;
+    c->type = type;
+    c->pos = 0;
+}
+
+/* First i in [lo, hi) with a[i] >= key, else hi */
+static uint32_t tl_lower_bound(const uint32_t *a, uint32_t lo, uint32_t hi, uint32_t key){
+    while(lo < hi){
+        uint32_t mid = lo + (hi - lo) / 2;
+        if(a[mid] < key) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+/* Linear steps before a cursor move falls back to binary search */
+#define TL_CURSOR_STEPS 8
+
+uint32_t timeline_events_in_window(tl_cursor_t *c, uint32_t t0, uint32_t t1,
+                                   const uint32_t **times, const uint32_t **order){
+    const timeline_index_t *ix = &c->t->index;
+    uint32_t base = 0, n = 0;
+    if(c->type < TL_EVENT_TYPES && ix->times){
+        base = ix->start[c->type];
+        n = ix->start[c->type + 1] - base;
+    }
+    const uint32_t *tm = ix->times + base;
+
+    uint32_t p = c->pos < n ? c->pos : n;
+    if(p > 0 && tm[p - 1] >= t0){
+        p = tl_lower_bound(tm, 0, p, t0);                       /* moved back */
+    } else {
+        for(uint32_t k = 0; k < TL_CURSOR_STEPS && p < n && tm[p] < t0; k++) p++;
+        if(p < n && tm[p] < t0) p = tl_lower_bound(tm, p, n, t0);   /* far ahead */
+    }
+    c->pos = p;
+
+    uint32_t e = p;
+    for(uint32_t k = 0; k < TL_CURSOR_STEPS && e < n && tm[e] < t1; k++) e++;
+    if(e < n && tm[e] < t1) e = tl_lower_bound(tm, e, n, t1);
+
+    if(times) *times = tm + p;
+    if(order) *order = ix->order ? ix->order + base + p : NULL;
+    return e - p;
+}
+
 /* Simple derived signals, mapped to 60 FPS. */
 static float exp_env(float dt, float tau){ return expf(-dt / fmaxf(1e-6f, tau)); }
 
+/* acc + amp[k] * exp(-dt/tau) over the events of the `ntypes` types at or
+   before `sec`, added in file order as a scan of `events` would */
+static float tl_decay_add(const timeline_t *t, float acc, int ntypes, const uint8_t type[2],
+                          const float amp[2], float sec, float tau){
+    /* every event with time/sr <= sec is below this sample bound */
+    double lim = (double)sec * t->sample_rate + 2.0;
+    uint32_t t1 = (!t->sample_rate || lim >= 4294967295.0) ? UINT32_MAX : lim < 0.0 ? 0u : (uint32_t)lim;
+    const uint32_t *tm[2], *ord[2];
+    uint32_t n[2] = {0, 0}, i[2] = {0, 0};
+    for(int k = 0; k < ntypes; k++){
+        tl_cursor_t cur;
+        timeline_cursor_init(&cur, t, type[k]);
+        n[k] = timeline_events_in_window(&cur, 0, t1, &tm[k], &ord[k]);
+    }
+    while(i[0] < n[0] || i[1] < n[1]){
+        int k = (i[1] >= n[1] || (i[0] < n[0] && ord[0][i[0]] < ord[1][i[1]])) ? 0 : 1;
+        float esec = (float)tm[k][i[k]++] / (float)t->sample_rate;
+        float dt = sec - esec; if(dt < 0) continue;
+        acc += amp[k] * exp_env(dt, tau);
+    }
+    return acc;
+}
+
 float timeline_compute_level(const timeline_t *t, int frame_idx, int fps){
     if(!t) return 0.0f;
     float sec = (float)frame_idx / (float)fps;
     // Accumulate simple decays from recent kick + snare events
-    float level = 0.0f;
-    for(uint32_t i=0;i<t->events_count;i++){
-        uint8_t type = t->events[i].type;
-        if(type > 5) continue;
-        if(type==0 || type==1){ // kick/snare
-            float esec = (float)t->events[i].time / (float)t->sample_rate;
-            float dt = sec - esec; if(dt < 0) continue;
-            float amp = (type==0)? 1.0f : 0.6f;
-            level += amp * exp_env(dt, 0.2f);
-        }
-    }
+    static const uint8_t types[2] = { 0, 1 };
+    static const float amp[2] = { 1.0f, 0.6f };
+    float level = tl_decay_add(t, 0.0f, 2, types, amp, sec, 0.2f);
     if(level > 1.0f) level = 1.0f;
     return level;
 }
@@ -170,14 +355,9 @@ float timeline_compute_glitch(const timeline_t *t, int frame_idx, int fps){
     float sec = (float)frame_idx / (float)fps;
     float g = 0.2f + 0.3f * sinf(sec * 3.0f);
     // add treble-ish spikes from hat/melody
-    for(uint32_t i=0;i<t->events_count;i++){
-        uint8_t type = t->events[i].type;
-        if(type==2 || type==3){
-            float esec = (float)t->events[i].time / (float)t->sample_rate;
-            float dt = sec - esec; if(dt < 0) continue;
-            g += 0.1f * exp_env(dt, 0.08f);
-        }
-    }
+    static const uint8_t types[2] = { 2, 3 };
+    static const float amp[2] = { 0.1f, 0.1f };
+    g = tl_decay_add(t, g, 2, types, amp, sec, 0.08f);
     if(g < 0.0f) g = 0.0f; if(g > 1.5f) g = 1.5f;
     return g;
 }
@@ -186,17 +366,98 @@ float timeline_compute_hue(const timeline_t *t, int frame_idx, int fps){
     if(!t) return 0.5f;
     float base = fmodf((float)frame_idx / (float)fps * 0.1f, 1.0f);
     // small hue jumps on bass
-    for(uint32_t i=0;i<t->events_count;i++){
-        if(t->events[i].type==5){
-            float esec = (float)t->events[i].time / (float)t->sample_rate;
-            float dt = ((float)frame_idx / (float)fps) - esec; if(dt < 0) continue;
-            base += 0.05f * exp_env(dt, 0.4f);
-        }
-    }
+    static const uint8_t types[2] = { 5, 5 };
+    static const float amp[2] = { 0.05f, 0.05f };
+    base = tl_decay_add(t, base, 1, types, amp, (float)frame_idx / (float)fps, 0.4f);
     base = fmodf(base, 1.0f);
     if(base < 0) base += 1.0f;
     return base;
 }
 
+/* ---- precomputed per-frame signals ------------------------------------ */
+
+typedef struct { float sec; uint8_t type; } tl_hit_t;
+
+static int tl_hit_cmp(const void *a, const void *b){
+    float x = ((const tl_hit_t*)a)->sec, y = ((const tl_hit_t*)b)->sec;
+    return (x > y) - (x < y);
+}
+
+/* sum over hits of `type_amp[type]` * exp(-dt/tau) for every frame, dt >= 0.
+   Between frames the running sum decays by exp(-1/(fps*tau)); each event
+   enters once, with its exact partial decay, so expf runs per event instead
+   of per frame x event. */
+static void tl_decay_sweep(const tl_hit_t *hits, uint32_t n, const float type_amp[6],
+                           float tau, int frames, int fps, double *out){
+    double step = exp(-1.0 / ((double)fps * tau));
+    double acc = 0.0;
+    uint32_t j = 0;
+    for(int f = 0; f < frames; f++){
+        float sec = (float)f / (float)fps;
+        acc *= step;
+        for(; j < n && sec - hits[j].sec >= 0.0f; j++){
+            float amp = hits[j].type < 6 ? type_amp[hits[j].type] : 0.0f;
+            if(amp != 0.0f) acc += amp * exp_env(sec - hits[j].sec, tau);
+        }
+        out[f] = acc;
+    }
+}
+
+bool timeline_signals_build(const timeline_t *t, int frames, int fps, timeline_signals_t *out){
+    memset(out, 0, sizeof(*out));
+    if(!t || frames <= 0 || fps <= 0) return false;
+
+    uint32_t n = t->events_count;
+    tl_hit_t *hits = (tl_hit_t*)malloc((n ? n : 1) * sizeof(tl_hit_t));
+    double *acc = (double*)malloc((size_t)frames * sizeof(double));
+    out->level  = (float*)malloc((size_t)frames * sizeof(float));
+    out->glitch = (float*)malloc((size_t)frames * sizeof(float));
+    out->hue    = (float*)malloc((size_t)frames * sizeof(float));
+    if(!hits || !acc || !out->level || !out->glitch || !out->hue){
+        free(hits); free(acc); timeline_signals_free(out);
+        return false;
+    }
+    for(uint32_t i = 0; i < n; i++){
+        hits[i].sec = (float)t->events[i].time / (float)t->sample_rate;
+        hits[i].type = t->events[i].type;
+    }
+    qsort(hits, n, sizeof(tl_hit_t), tl_hit_cmp);
+
+    /* weights per event type, matching timeline_compute_* */
+    static const float level_amp[6]  = { 1.0f, 0.6f, 0.0f, 0.0f, 0.0f, 0.0f };
+    static const float glitch_amp[6] = { 0.0f, 0.0f, 0.1f, 0.1f, 0.0f, 0.0f };
+    static const float hue_amp[6]    = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.05f };
 
+    tl_decay_sweep(hits, n, level_amp, 0.2f, frames, fps, acc);
+    for(int f = 0; f < frames; f++){
+        float level = (float)acc[f];
+        out->level[f] = level > 1.0f ? 1.0f : level;
+    }
+
+    tl_decay_sweep(hits, n, glitch_amp, 0.08f, frames, fps, acc);
+    for(int f = 0; f < frames; f++){
+        float sec = (float)f / (float)fps;
+        float g = 0.2f + 0.3f * sinf(sec * 3.0f) + (float)acc[f];
+        if(g < 0.0f) g = 0.0f;
+        if(g > 1.5f) g = 1.5f;
+        out->glitch[f] = g;
+    }
+
+    tl_decay_sweep(hits, n, hue_amp, 0.4f, frames, fps, acc);
+    for(int f = 0; f < frames; f++){
+        float base = fmodf((float)f / (float)fps * 0.1f, 1.0f) + (float)acc[f];
+        base = fmodf(base, 1.0f);
+        if(base < 0) base += 1.0f;
+        out->hue[f] = base;
+    }
 
+    out->frames = frames;
+    free(hits); free(acc);
+    return true;
+}
+
+void timeline_signals_free(timeline_signals_t *s){
+    if(!s) return;
+    free(s->level); free(s->glitch); free(s->hue);
+    memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,343 @@
+// trait_index – the traits of many seeds, without rendering any of them.
+//
+// Every trait in a token's metadata is a cheap function of its seed: the
+// audio half is generator_plan's first draws (generator_plan_variation:
+// drum hit counts, tempo, key, scale), the visual half the ship and boss
+// template picks (ship_design_pick / boss_design_pick, vis_ctx.h).  Both
+// are the code the renderers themselves run, so the index always agrees
+// with <tx>_metadata.json.  Nothing is allocated per seed and no event,
+// layout or palette is built; all cores share the work in blocks.
+//
+//   ./bin/trait_index idx/ --range 0 100000000       # seeds 0..99999999
+//   ./bin/trait_index idx/ --list input/seeds.csv    # first column, as batch_steps.py
+//
+// The index is columnar: idx/<trait>.<type> (u8, u32, u64, f32) holds one
+// little-endian value per seed, in candidate order, and idx/index.json
+// lists the columns, their types, the names of enumerated values and how
+// often each value occurs (the rarity table).  --list also writes idx/seed.u256be, each seed's
+// 32-byte big-endian value (seed.h); a --range index is row i = START + i.
+//
+//   numpy: bpm = np.fromfile("idx/bpm.f32", "<f4"); scale = np.fromfile("idx/scale.u8", "u1")
+//          rows = np.nonzero((scale == 1) & (bpm > 100) & (formation == 3))
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nft_metadata.h"
+#include "c/include/seed.h"
+
+#define INDEX_BLOCK (1u << 20)   // rows per pass over the threads
+#define INDEX_MAX_THREADS 256
+#define INDEX_PATH_MAX 1024
+#define INDEX_HIST 16            // u8 columns: values 0-15 are counted
+
+typedef enum { COL_U8, COL_U32, COL_U64, COL_F32 } col_type_t;
+
+typedef enum {
+    COL_AUDIO_SEED, COL_VISUAL_SEED,
+    COL_BPM, COL_ROOT_FREQ, COL_SCALE, COL_KICK, COL_SNARE, COL_HAT, COL_LOOP_SEC,
+    COL_FORMATION, COL_BOSS_SHAPES, COL_SHIP_NOSE, COL_SHIP_WINGS, COL_SHIP_BODY, COL_SHIP_TRAIL,
+    COL_SHIP_SIZE,
+    COL_COUNT
+} col_id_t;
+
+static const struct {
+    const char *name;
+    col_type_t type;
+    const char *const *names;   // value names, NULL: a plain number
+    int name_count;
+} columns[COL_COUNT] = {
+    [COL_AUDIO_SEED]  = { "audio_seed", COL_U64 },
+    [COL_VISUAL_SEED] = { "visual_seed", COL_U32 },
+    [COL_BPM]         = { "bpm", COL_F32 },
+    [COL_ROOT_FREQ]   = { "root_freq", COL_F32 },
+    [COL_SCALE]       = { "scale", COL_U8, NFT_SCALE_NAMES, 2 },
+    [COL_KICK]        = { "kick_hits", COL_U8 },
+    [COL_SNARE]       = { "snare_hits", COL_U8 },
+    [COL_HAT]         = { "hat_hits", COL_U8 },
+    [COL_LOOP_SEC]    = { "loop_duration", COL_F32 },
+    [COL_FORMATION]   = { "formation", COL_U8, NFT_FORMATION_NAMES, 8 },
+    [COL_BOSS_SHAPES] = { "boss_shapes", COL_U8 },
+    [COL_SHIP_NOSE]   = { "ship_nose", COL_U8, NFT_SHIP_PART_NAMES[0], 4 },
+    [COL_SHIP_WINGS]  = { "ship_wings", COL_U8, NFT_SHIP_PART_NAMES[1], 4 },
+    [COL_SHIP_BODY]   = { "ship_body", COL_U8, NFT_SHIP_PART_NAMES[2], 4 },
+    [COL_SHIP_TRAIL]  = { "ship_trail", COL_U8, NFT_SHIP_PART_NAMES[3], 4 },
+    [COL_SHIP_SIZE]   = { "ship_size", COL_U8 },
+};
+
+static const int type_size[] = { [COL_U8] = 1, [COL_U32] = 4, [COL_U64] = 8, [COL_F32] = 4 };
+static const char *const type_ext[] = { [COL_U8] = "u8", [COL_U32] = "u32", [COL_U64] = "u64", [COL_F32] = "f32" };
+
+typedef struct {
+    // Candidates: START + row, or the parsed list
+    uint64_t start;
+    const ndb_seed_t *list;
+    // This block
+    uint64_t base;
+    uint32_t rows;
+    uint8_t *col[COL_COUNT];
+    uint8_t *seed_col;   // --list: the 32-byte values
+} index_job_t;
+
+typedef struct {
+    const index_job_t *job;
+    uint32_t from, to;   // rows of the block
+    uint64_t hist[COL_COUNT][INDEX_HIST];
+} index_worker_t;
+
+static void put_u8(uint8_t *col, uint32_t row, int v) { col[row] = (uint8_t)v; }
+static void put_u32(uint8_t *col, uint32_t row, uint32_t v) { memcpy(col + 4 * (size_t)row, &v, 4); }
+static void put_u64(uint8_t *col, uint32_t row, uint64_t v) { memcpy(col + 8 * (size_t)row, &v, 8); }
+static void put_f32(uint8_t *col, uint32_t row, float v) { memcpy(col + 4 * (size_t)row, &v, 4); }
+
+static void *index_worker(void *arg) {
+    index_worker_t *w = (index_worker_t *)arg;
+    const index_job_t *j = w->job;
+    for (uint32_t r = w->from; r < w->to; r++) {
+        ndb_seed_t seed;
+        if (j->list) seed = j->list[j->base + r];
+        else ndb_seed_from_u64(j->start + j->base + r, &seed);
+        nft_traits_t t;
+        nft_audio_traits(seed.audio, &t);
+        nft_visual_traits(seed.visual, &t);
+
+        put_u64(j->col[COL_AUDIO_SEED], r, seed.audio);
+        put_u32(j->col[COL_VISUAL_SEED], r, seed.visual);
+        put_f32(j->col[COL_BPM], r, t.bpm);
+        put_f32(j->col[COL_ROOT_FREQ], r, t.root_freq);
+        put_f32(j->col[COL_LOOP_SEC], r, t.loop_sec);
+        const int u8s[][2] = {
+            { COL_SCALE, t.scale }, { COL_KICK, t.kick_hits }, { COL_SNARE, t.snare_hits },
+            { COL_HAT, t.hat_hits }, { COL_FORMATION, t.formation }, { COL_BOSS_SHAPES, t.boss_shapes },
+            { COL_SHIP_NOSE, t.ship_parts[0] }, { COL_SHIP_WINGS, t.ship_parts[1] },
+            { COL_SHIP_BODY, t.ship_parts[2] }, { COL_SHIP_TRAIL, t.ship_parts[3] },
+            { COL_SHIP_SIZE, t.ship_size },
+        };
+        for (size_t k = 0; k < sizeof(u8s) / sizeof(u8s[0]); k++) {
+            put_u8(j->col[u8s[k][0]], r, u8s[k][1]);
+            w->hist[u8s[k][0]][u8s[k][1] & (INDEX_HIST - 1)]++;
+        }
+        if (j->seed_col) memcpy(j->seed_col + 32 * (size_t)r, seed.value, 32);
+    }
+    return NULL;
+}
+
+// Seeds from the first column of a CSV or list ('#' comments, blank lines
+// and a header row skipped); NULL on a read or parse error
+static ndb_seed_t *read_seed_list(const char *path, uint64_t *count) {
+    FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "❌ Could not open %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    size_t cap = 1024, n = 0;
+    ndb_seed_t *seeds = malloc(cap * sizeof(*seeds));
+    char line[512];
+    unsigned long lineno = 0;
+    while (seeds && fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *s = line;
+        while (*s == ' ' || *s == '\t') s++;
+        s[strcspn(s, ",\r\n \t")] = '\0';
+        if (*s == '\0' || *s == '#') continue;
+        if (n == cap) {
+            ndb_seed_t *grown = realloc(seeds, 2 * cap * sizeof(*seeds));
+            if (!grown) {
+                free(seeds);
+                seeds = NULL;
+                break;
+            }
+            seeds = grown;
+            cap *= 2;
+        }
+        if (ndb_seed_parse(s, &seeds[n]) == 0) {
+            n++;
+        } else if (lineno > 1) {   // the first line may be a CSV header
+            fprintf(stderr, "❌ %s:%lu: not a seed: %s\n", path, lineno, s);
+            free(seeds);
+            seeds = NULL;
+        }
+    }
+    if (f != stdin) fclose(f);
+    if (!seeds) return NULL;
+    *count = n;
+    return seeds;
+}
+
+static void json_counts(FILE *f, int c, const uint64_t hist[INDEX_HIST], bool last) {
+    fprintf(f, "    \"%s\": {", columns[c].name);
+    bool first = true;
+    for (int v = 0; v < INDEX_HIST; v++) {
+        if (!hist[v]) continue;
+        if (columns[c].names && v < columns[c].name_count) {
+            fprintf(f, "%s\"%s\": %llu", first ? "" : ", ", columns[c].names[v], (unsigned long long)hist[v]);
+        } else {
+            fprintf(f, "%s\"%d\": %llu", first ? "" : ", ", v, (unsigned long long)hist[v]);
+        }
+        first = false;
+    }
+    fprintf(f, "}%s\n", last ? "" : ",");
+}
+
+static int write_manifest(const char *dir, uint64_t rows, const char *list_path, uint64_t start,
+                          const uint64_t hist[COL_COUNT][INDEX_HIST], double sec) {
+    char path[INDEX_PATH_MAX], part[INDEX_PATH_MAX + 8];
+    snprintf(path, sizeof(path), "%s/index.json", dir);
+    snprintf(part, sizeof(part), "%s.part", path);
+    FILE *f = fopen(part, "w");
+    if (!f) return -1;
+    fprintf(f, "{\n  \"format\": \"ndb-trait-index 1\",\n  \"rows\": %llu,\n", (unsigned long long)rows);
+    if (list_path) fprintf(f, "  \"seeds\": {\"list\": \"%s\", \"column\": \"seed.u256be\"},\n", list_path);
+    else fprintf(f, "  \"seeds\": {\"range_start\": %llu},\n", (unsigned long long)start);
+    fprintf(f, "  \"columns\": [\n");
+    for (int c = 0; c < COL_COUNT; c++) {
+        fprintf(f, "    {\"name\": \"%s\", \"file\": \"%s.%s\", \"type\": \"%s\"}%s\n", columns[c].name,
+                columns[c].name, type_ext[columns[c].type], type_ext[columns[c].type], c + 1 < COL_COUNT ? "," : "");
+    }
+    fprintf(f, "  ],\n  \"names\": {\n");
+    int named = 0, named_total = 0;
+    for (int c = 0; c < COL_COUNT; c++) named_total += columns[c].names != NULL;
+    for (int c = 0; c < COL_COUNT; c++) {
+        if (!columns[c].names) continue;
+        fprintf(f, "    \"%s\": [", columns[c].name);
+        for (int v = 0; v < columns[c].name_count; v++) fprintf(f, "%s\"%s\"", v ? ", " : "", columns[c].names[v]);
+        fprintf(f, "]%s\n", ++named < named_total ? "," : "");
+    }
+    fprintf(f, "  },\n  \"counts\": {\n");
+    int last_u8 = 0;
+    for (int c = 0; c < COL_COUNT; c++) {
+        if (columns[c].type == COL_U8) last_u8 = c;
+    }
+    for (int c = 0; c < COL_COUNT; c++) {
+        if (columns[c].type == COL_U8) json_counts(f, c, hist[c], c == last_u8);
+    }
+    fprintf(f, "  },\n  \"elapsed_sec\": %.3f\n}\n", sec);
+    int ok = fclose(f) == 0;
+    return ok && rename(part, path) == 0 ? 0 : -1;
+}
+
+static int usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s <out_dir> (--range START COUNT | --list seeds.csv|-) [-j threads]\n", argv0);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) return usage(argv[0]);
+    const char *dir = argv[1], *list_path = NULL;
+    uint64_t start = 0, rows = 0;
+    bool have_range = false;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--range") == 0 && i + 2 < argc) {
+            start = strtoull(argv[i + 1], NULL, 0);
+            rows = strtoull(argv[i + 2], NULL, 0);
+            have_range = true;
+            i += 2;
+        } else if (strcmp(argv[i], "--list") == 0 && i + 1 < argc) {
+            list_path = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atol(argv[++i]);
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (have_range == (list_path != NULL)) return usage(argv[0]);
+    if (threads < 1) threads = 1;
+    if (threads > INDEX_MAX_THREADS) threads = INDEX_MAX_THREADS;
+
+    ndb_seed_t *list = NULL;
+    if (list_path && !(list = read_seed_list(list_path, &rows))) return 1;
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "❌ Could not create %s\n", dir);
+        return 1;
+    }
+
+    // One output file and one block buffer per column
+    FILE *out[COL_COUNT + 1] = { 0 };
+    index_job_t job = { .start = start, .list = list };
+    char path[INDEX_PATH_MAX];
+    int rc = 1;
+    for (int c = 0; c <= COL_COUNT; c++) {
+        if (c == COL_COUNT && !list) break;
+        if (c < COL_COUNT) snprintf(path, sizeof(path), "%s/%s.%s", dir, columns[c].name, type_ext[columns[c].type]);
+        else snprintf(path, sizeof(path), "%s/seed.u256be", dir);
+        size_t bytes = (size_t)INDEX_BLOCK * (c < COL_COUNT ? type_size[columns[c].type] : 32);
+        uint8_t *buf = malloc(bytes);
+        if (c < COL_COUNT) job.col[c] = buf;
+        else job.seed_col = buf;
+        if (!buf || !(out[c] = fopen(path, "wb"))) {
+            fprintf(stderr, "❌ Could not open %s\n", path);
+            goto done;
+        }
+    }
+
+    fprintf(stderr, "🔎 Indexing %llu seeds on %ld threads\n", (unsigned long long)rows, threads);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    static index_worker_t workers[INDEX_MAX_THREADS];
+    uint64_t hist[COL_COUNT][INDEX_HIST] = { { 0 } };
+    pthread_t tids[INDEX_MAX_THREADS];
+    for (job.base = 0; job.base < rows; job.base += job.rows) {
+        job.rows = rows - job.base < INDEX_BLOCK ? (uint32_t)(rows - job.base) : INDEX_BLOCK;
+        long n = threads < (long)job.rows ? threads : (long)job.rows;
+        for (long t = 0; t < n; t++) {
+            workers[t] = (index_worker_t){ .job = &job, .from = (uint32_t)(job.rows * t / n),
+                                           .to = (uint32_t)(job.rows * (t + 1) / n) };
+            if (pthread_create(&tids[t], NULL, index_worker, &workers[t]) != 0) {
+                fprintf(stderr, "❌ Could not start worker threads\n");
+                for (long k = 0; k < t; k++) pthread_join(tids[k], NULL);
+                goto done;
+            }
+        }
+        for (long t = 0; t < n; t++) {
+            pthread_join(tids[t], NULL);
+            for (int c = 0; c < COL_COUNT; c++) {
+                for (int v = 0; v < INDEX_HIST; v++) hist[c][v] += workers[t].hist[c][v];
+            }
+        }
+        for (int c = 0; c <= COL_COUNT; c++) {
+            if (!out[c]) continue;
+            size_t width = c < COL_COUNT ? (size_t)type_size[columns[c].type] : 32;
+            const uint8_t *buf = c < COL_COUNT ? job.col[c] : job.seed_col;
+            if (fwrite(buf, width, job.rows, out[c]) != job.rows) {
+                fprintf(stderr, "❌ Write failed in %s\n", dir);
+                goto done;
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double sec = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9;
+
+    for (int c = 0; c <= COL_COUNT; c++) {
+        if (out[c] && fclose(out[c]) != 0) {
+            out[c] = NULL;
+            fprintf(stderr, "❌ Write failed in %s\n", dir);
+            goto done;
+        }
+        out[c] = NULL;
+    }
+    if (write_manifest(dir, rows, list_path, start, (const uint64_t (*)[INDEX_HIST])hist, sec) != 0) {
+        fprintf(stderr, "❌ Could not write %s/index.json\n", dir);
+        goto done;
+    }
+    fprintf(stderr, "📇 %s: %llu seeds in %.2fs (%.1fM seeds/s)\n", dir, (unsigned long long)rows, sec,
+            sec > 0 ? (double)rows / sec / 1e6 : 0.0);
+    rc = 0;
+
+done:
+    for (int c = 0; c <= COL_COUNT; c++) {
+        if (out[c]) fclose(out[c]);
+        if (c < COL_COUNT) free(job.col[c]);
+    }
+    free(job.seed_col);
+    free(list);
+    return rc;
+}
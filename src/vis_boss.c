@@ -0,0 +1,260 @@
+#include "include/vis_boss.h"
+#include "include/vis_glitch.h"
+#include "include/visual_types.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+extern void draw_ascii_char_asm(uint32_t *pixels, int x, int y, char c, uint32_t color, int bg_alpha);
+extern void draw_ascii_triangle_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
+extern void draw_ascii_diamond_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
+extern void draw_ascii_hexagon_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
+extern void draw_ascii_star_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
+extern void draw_ascii_square_asm(uint32_t *pixels, int cx, int cy, int size, float rotation, uint32_t color, int alpha, int frame);
+extern float sin_lut_asm(float angle);
+extern float cos_lut_asm(float angle);
+extern uint32_t *vis_dirty_tiles;
+
+#define GLYPH_PX    8                               // draw_ascii_char_asm cell
+#define EDGE_ALPHA  (255 - 50)                      // Edge glyphs of a full-alpha outline
+#define BUILD_X     (VIS_WIDTH / 2)                 // Shape centre in the scratch frames
+#define BUILD_Y     (VIS_HEIGHT / 2)
+#define SHAPE_MIN_SIZE 8                            // Smaller outlines draw nothing
+
+// Outline tables, as laid out in bass_hits.s: vertex glyphs, edge glyph
+// (0 for vertices only) and unrotated vertices in units of size
+typedef struct {
+    int count;
+    char edge;
+    char glyph[10];
+    float v[10][2];
+} outline_t;
+
+static const outline_t outlines[5] = {
+    { 3, '-', { '^', 'A', '/' },
+      { { 0.800000f, 0.000000f }, { -0.400000f, 0.692820f }, { -0.400000f, -0.692820f } } },
+    { 4, '=', { '<', '>', '^', 'v' },
+      { { 0.0f, -1.0f }, { 1.0f, 0.0f }, { 0.0f, 1.0f }, { -1.0f, 0.0f } } },
+    { 6, 0, { 'O', '0', '#', '*', '+', 'X' },
+      { { 0.700000f, 0.000000f }, { 0.350000f, 0.606218f }, { -0.350000f, 0.606218f },
+        { -0.700000f, 0.000000f }, { -0.350000f, -0.606218f }, { 0.350000f, -0.606218f } } },
+    { 10, 0, { '*', '+', 'x', 'X', '^', 'v', '<', '>', '*', '+' },
+      { { 0.800000f, 0.000000f }, { 0.323607f, 0.235114f }, { 0.247214f, 0.760845f },
+        { -0.123607f, 0.380423f }, { -0.647214f, 0.470228f }, { -0.400000f, 0.000000f },
+        { -0.647214f, -0.470228f }, { -0.123607f, -0.380423f }, { 0.247214f, -0.760845f },
+        { 0.323607f, -0.235114f } } },
+    { 4, '-', { '#', '=', '+', 'H' },
+      { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } } },
+};
+
+void vis_boss_shape_draw(uint32_t *pixels, int cx, int cy, int shape, int size, float rotation,
+                         uint32_t color, int frame) {
+    int alpha = 255; // Full opacity for boss shapes
+    switch (shape) {
+    case 0: draw_ascii_triangle_asm(pixels, cx, cy, size, rotation, color, alpha, frame); break;
+    case 1: draw_ascii_diamond_asm(pixels, cx, cy, size, rotation, color, alpha, frame); break;
+    case 2: draw_ascii_hexagon_asm(pixels, cx, cy, size, rotation, color, alpha, frame); break;
+    case 3: draw_ascii_star_asm(pixels, cx, cy, size, rotation, color, alpha, frame); break;
+    case 4: draw_ascii_square_asm(pixels, cx, cy, size, rotation, color, alpha, frame); break;
+    }
+}
+
+// draw_ascii_char_asm's pixel for `color` at `alpha`
+static uint32_t glyph_pixel(uint32_t color, int alpha) {
+    if (alpha == 255) return color | 0xFF000000u;
+    uint32_t a = (uint32_t)alpha, r = (color >> 16 & 0xFF) * a * 0x8081u >> 23;
+    uint32_t g = (color >> 8 & 0xFF) * a * 0x8081u >> 23, b = (color & 0xFF) * a * 0x8081u >> 23;
+    return 0xFF000000u | r << 16 | g << 8 | b;
+}
+
+static bool add_cell(vis_boss_sprite_t *sp, int x, int y, char glyph, int alpha) {
+    if (sp->n == VIS_BOSS_MAX_CELLS || x < INT8_MIN || x > INT8_MAX || y < INT8_MIN || y > INT8_MAX) return false;
+    sp->x[sp->n] = (int8_t)x;
+    sp->y[sp->n] = (int8_t)y;
+    sp->glyph[sp->n] = glyph;
+    sp->alpha[sp->n] = (uint8_t)alpha;
+    sp->n++;
+    return true;
+}
+
+// The kernel's cells around a centre at 0: vertices rotated by one LUT
+// lookup (fused multiply-adds, rounded to nearest even), then each edge's
+// interior steps rounded half away from zero.  False if they don't fit.
+static bool outline_cells(vis_boss_sprite_t *sp) {
+    sp->n = 0;
+    if (sp->shape < 0 || sp->shape > 4) return false;
+    if (sp->size < SHAPE_MIN_SIZE) return true;
+    const outline_t *o = &outlines[sp->shape];
+    float size = (float)sp->size;
+    float c = cos_lut_asm(sp->rotation) * size, s = sin_lut_asm(sp->rotation) * size;
+    int vx[10], vy[10];
+    for (int i = 0; i < o->count; i++) {
+        float x = o->v[i][0], y = o->v[i][1];
+        vx[i] = (int)lrintf(fmaf(-y, s, x * c));
+        vy[i] = (int)lrintf(fmaf(y, c, x * s));
+        if (!add_cell(sp, vx[i], vy[i], o->glyph[i], 255)) return false;
+    }
+    if (!o->edge) return true;
+    for (int i = 0; i < o->count; i++) {
+        int j = i + 1 < o->count ? i + 1 : 0;
+        int dx = vx[j] - vx[i], dy = vy[j] - vy[i];
+        int steps = (abs(dx) + abs(dy)) / 12;
+        for (int k = 1; k < steps; k++) {
+            int x = vx[i] + (2 * k * dx + (dx < 0 ? -steps : steps)) / (2 * steps);
+            int y = vy[i] + (2 * k * dy + (dy < 0 ? -steps : steps)) / (2 * steps);
+            if (!add_cell(sp, x, y, o->edge, EDGE_ALPHA)) return false;
+        }
+    }
+    return true;
+}
+
+void vis_boss_sprite_free(vis_boss_sprite_t *sp) {
+    free(sp->levels);
+    sp->levels = NULL;
+}
+
+void vis_boss_sprite_build(vis_boss_sprite_t *sp, int shape, int size, float rotation, uint32_t *scratch) {
+    vis_boss_sprite_free(sp);
+    memset(sp, 0, sizeof(*sp));
+    sp->shape = shape;
+    sp->size = size;
+    sp->rotation = rotation;
+    sp->live = true;
+    if (!scratch || !outline_cells(sp)) return;
+    if (sp->n == 0) {
+        sp->live = false;
+        return;
+    }
+
+    int x0 = INT8_MAX, y0 = INT8_MAX, x1 = INT8_MIN, y1 = INT8_MIN;
+    for (int i = 0; i < sp->n; i++) {
+        if (sp->x[i] < x0) x0 = sp->x[i];
+        if (sp->y[i] < y0) y0 = sp->y[i];
+        if (sp->x[i] > x1) x1 = sp->x[i];
+        if (sp->y[i] > y1) y1 = sp->y[i];
+    }
+    sp->x0 = x0;
+    sp->y0 = y0;
+    sp->w = x1 + GLYPH_PX - x0;
+    sp->h = y1 + GLYPH_PX - y0;
+
+    // The kernel's outline and the cells', both in white, must match pixel
+    // for pixel; white at the two alphas tells vertex from edge pixels
+    const size_t frame_px = (size_t)VIS_WIDTH * VIS_HEIGHT;
+    uint32_t *ref = scratch, *cells = scratch + frame_px;
+    uint32_t *dirty = vis_dirty_tiles, glitch = vis_glitch_hold();
+    vis_dirty_tiles = NULL;
+    for (int i = 0; i < sp->n; i++) {
+        // Blank glyphs draw nothing and mark no tiles
+        draw_ascii_char_asm(cells, BUILD_X, BUILD_Y, sp->glyph[i], 0xFFFFFF, 255);
+        for (int y = 0; y < GLYPH_PX; y++) {
+            uint32_t *row = cells + (size_t)(BUILD_Y + y) * VIS_WIDTH + BUILD_X;
+            for (int x = 0; x < GLYPH_PX; x++)
+                if (row[x]) sp->lit |= 1ull << i;
+            memset(row, 0, GLYPH_PX * sizeof(uint32_t));
+        }
+    }
+    vis_boss_shape_draw(ref, BUILD_X, BUILD_Y, shape, size, rotation, 0xFFFFFF, 0);
+    for (int i = 0; i < sp->n; i++)
+        draw_ascii_char_asm(cells, BUILD_X + sp->x[i], BUILD_Y + sp->y[i], sp->glyph[i], 0xFFFFFF, sp->alpha[i]);
+    vis_dirty_tiles = dirty;
+    vis_glitch_restore(glitch);
+    bool same = memcmp(ref, cells, frame_px * sizeof(uint32_t)) == 0;
+
+    sp->levels = malloc((size_t)sp->w * sp->h);
+    const uint32_t vertex = glyph_pixel(0xFFFFFF, 255), edge = glyph_pixel(0xFFFFFF, EDGE_ALPHA);
+    for (int y = 0; y < sp->h; y++) {
+        uint32_t *row = cells + (size_t)(BUILD_Y + y0 + y) * VIS_WIDTH + BUILD_X + x0;
+        for (int x = 0; x < sp->w && sp->levels; x++) {
+            uint32_t v = row[x];
+            same &= v == 0 || v == vertex || v == edge;
+            sp->levels[y * sp->w + x] = v == vertex ? 1 : v == edge ? 2 : 0;
+        }
+        memset(row, 0, (size_t)sp->w * sizeof(uint32_t));
+    }
+    if (same) {
+        for (int y = 0; y < sp->h; y++)
+            memset(ref + (size_t)(BUILD_Y + y0 + y) * VIS_WIDTH + BUILD_X + x0, 0, (size_t)sp->w * sizeof(uint32_t));
+    } else {
+        memset(ref, 0, frame_px * sizeof(uint32_t));
+    }
+    sp->live = !same || !sp->levels;
+}
+
+// dst = c1 where the level is 1, c2 where it is 2; other pixels are kept
+static void sprite_blit(const uint8_t *levels, int w, int h, uint32_t *dst, uint32_t c1, uint32_t c2) {
+    for (int y = 0; y < h; y++, levels += w, dst += VIS_WIDTH) {
+        int x = 0;
+#if defined(__ARM_NEON)
+        const uint32x4_t one = vdupq_n_u32(1), two = vdupq_n_u32(2);
+        const uint32x4_t v1 = vdupq_n_u32(c1), v2 = vdupq_n_u32(c2);
+        for (; x + 8 <= w; x += 8) {
+            uint8x8_t l = vld1_u8(levels + x);
+            if (!vget_lane_u64(vreinterpret_u64_u8(l), 0)) continue;
+            uint16x8_t l16 = vmovl_u8(l);
+            uint32x4_t lo = vmovl_u16(vget_low_u16(l16)), hi = vmovl_u16(vget_high_u16(l16));
+            uint32x4_t p0 = vld1q_u32(dst + x), p1 = vld1q_u32(dst + x + 4);
+            p0 = vbslq_u32(vceqq_u32(lo, one), v1, vbslq_u32(vceqq_u32(lo, two), v2, p0));
+            p1 = vbslq_u32(vceqq_u32(hi, one), v1, vbslq_u32(vceqq_u32(hi, two), v2, p1));
+            vst1q_u32(dst + x, p0);
+            vst1q_u32(dst + x + 4, p1);
+        }
+#elif defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+        const __m128i v1 = _mm_set1_epi32((int)c1), v2 = _mm_set1_epi32((int)c2);
+        for (; x + 4 <= w; x += 4) {
+            uint32_t l4;
+            memcpy(&l4, levels + x, sizeof(l4));
+            if (!l4) continue;
+            __m128i l = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)l4), zero), zero);
+            __m128i m1 = _mm_cmpeq_epi32(l, one), m2 = _mm_cmpeq_epi32(l, two);
+            __m128i p = _mm_loadu_si128((const __m128i *)(dst + x));
+            p = _mm_or_si128(_mm_andnot_si128(_mm_or_si128(m1, m2), p),
+                             _mm_or_si128(_mm_and_si128(m1, v1), _mm_and_si128(m2, v2)));
+            _mm_storeu_si128((__m128i *)(dst + x), p);
+        }
+#endif
+        for (; x < w; x++)
+            if (levels[x]) dst[x] = levels[x] == 1 ? c1 : c2;
+    }
+}
+
+// The tiles draw_ascii_char_asm marks for a whole glyph at (x, y)
+static void mark_glyph_tiles(uint32_t *tiles, int x, int y) {
+    uint32_t cols = 1u << (x >> 5) | 1u << ((x + GLYPH_PX - 1) >> 5);
+    tiles[y >> 5] |= cols;
+    tiles[(y + GLYPH_PX - 1) >> 5] |= cols;
+}
+
+void vis_boss_sprite_draw(const vis_boss_sprite_t *sp, uint32_t *pixels, int cx, int cy, uint32_t color, int frame) {
+    if (sp->live) {
+        vis_boss_shape_draw(pixels, cx, cy, sp->shape, sp->size, sp->rotation, color, frame);
+        return;
+    }
+    int n = sp->n, x[VIS_BOSS_MAX_CELLS] = {0}, y[VIS_BOSS_MAX_CELLS] = {0};
+    char glyphs[VIS_BOSS_MAX_CELLS];
+    uint8_t mask[VIS_BOSS_MAX_CELLS];
+    if (n == 0) return;
+    for (int i = 0; i < n; i++) {
+        x[i] = cx + sp->x[i];
+        y[i] = cy + sp->y[i];
+    }
+    int changed = vis_glitch_cells(VIS_GLITCH_SHAPE, sp->glyph, x, y, n, frame, mask, glyphs);
+
+    int bx = cx + sp->x0, by = cy + sp->y0;
+    if (changed == 0 && bx >= 0 && by >= 0 && bx + sp->w <= VIS_WIDTH && by + sp->h <= VIS_HEIGHT) {
+        sprite_blit(sp->levels, sp->w, sp->h, pixels + (size_t)by * VIS_WIDTH + bx,
+                    glyph_pixel(color, 255), glyph_pixel(color, EDGE_ALPHA));
+        if (vis_dirty_tiles)
+            for (int i = 0; i < n; i++)
+                if (sp->lit >> i & 1) mark_glyph_tiles(vis_dirty_tiles, x[i], y[i]);
+        return;
+    }
+    for (int i = 0; i < n; i++)
+        draw_ascii_char_asm(pixels, x[i], y[i], glyphs[i], color, sp->alpha[i]);
+}
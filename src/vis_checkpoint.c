@@ -0,0 +1,135 @@
+#include "include/vis_checkpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define SECTION_HDR 8                               // tag, uint32 bytes
+#define FILE_HDR    16                              // magic, version, fingerprint
+
+void vis_checkpoint_init(vis_checkpoint_t *c, uint64_t fingerprint) {
+    memset(c, 0, sizeof(*c));
+    c->fingerprint = fingerprint;
+}
+
+void vis_checkpoint_free(vis_checkpoint_t *c) {
+    free(c->buf);
+    c->buf = NULL;
+    c->len = c->cap = 0;
+}
+
+bool vis_checkpoint_put(vis_checkpoint_t *c, const char tag[4], const void *data, size_t bytes) {
+    if (bytes > UINT32_MAX) return false;
+    size_t need = c->len + SECTION_HDR + bytes;
+    if (need > c->cap) {
+        size_t cap = c->cap ? c->cap : 4096;
+        while (cap < need) cap *= 2;
+        uint8_t *buf = realloc(c->buf, cap);
+        if (!buf) return false;
+        c->buf = buf;
+        c->cap = cap;
+    }
+    uint32_t n = (uint32_t)bytes;
+    memcpy(c->buf + c->len, tag, 4);
+    memcpy(c->buf + c->len + 4, &n, 4);
+    if (bytes) memcpy(c->buf + c->len + SECTION_HDR, data, bytes);
+    c->len = need;
+    return true;
+}
+
+const void *vis_checkpoint_get(const vis_checkpoint_t *c, const char tag[4], size_t bytes) {
+    size_t off = 0;
+    while (off + SECTION_HDR <= c->len) {
+        uint32_t n;
+        memcpy(&n, c->buf + off + 4, 4);
+        if (off + SECTION_HDR + n > c->len) return NULL;
+        if (memcmp(c->buf + off, tag, 4) == 0) return n == bytes ? c->buf + off + SECTION_HDR : NULL;
+        off += SECTION_HDR + n;
+    }
+    return NULL;
+}
+
+static int write_all(int fd, const void *data, size_t n) {
+    const uint8_t *p = data;
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return -1;
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+int vis_checkpoint_save(const vis_checkpoint_t *c, const char *path) {
+    char tmp[1024];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return -1;
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "checkpoint: could not create %s\n", tmp);
+        return -1;
+    }
+    uint8_t hdr[FILE_HDR];
+    uint32_t version = VIS_CHECKPOINT_VERSION;
+    memcpy(hdr, VIS_CHECKPOINT_MAGIC, 4);
+    memcpy(hdr + 4, &version, 4);
+    memcpy(hdr + 8, &c->fingerprint, 8);
+    int rc = write_all(fd, hdr, sizeof(hdr)) == 0 && write_all(fd, c->buf, c->len) == 0 && fsync(fd) == 0 ? 0 : -1;
+    if (close(fd) != 0) rc = -1;
+    if (rc == 0 && rename(tmp, path) != 0) rc = -1;
+    if (rc != 0) {
+        fprintf(stderr, "checkpoint: could not write %s\n", path);
+        unlink(tmp);
+    }
+    return rc;
+}
+
+bool vis_checkpoint_load(vis_checkpoint_t *c, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t hdr[FILE_HDR];
+    uint32_t version = 0;
+    uint64_t fingerprint = 0;
+    bool ok = fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr) && memcmp(hdr, VIS_CHECKPOINT_MAGIC, 4) == 0;
+    if (ok) {
+        memcpy(&version, hdr + 4, 4);
+        memcpy(&fingerprint, hdr + 8, 8);
+        ok = version == VIS_CHECKPOINT_VERSION && fingerprint == c->fingerprint;
+    }
+    long end = -1;
+    if (ok && fseek(f, 0, SEEK_END) == 0) end = ftell(f);
+    ok = ok && end >= FILE_HDR && fseek(f, FILE_HDR, SEEK_SET) == 0;
+    uint8_t *buf = NULL;
+    size_t len = ok ? (size_t)end - FILE_HDR : 0;
+    if (ok) {
+        buf = malloc(len ? len : 1);
+        ok = buf && fread(buf, 1, len, f) == len;
+    }
+    fclose(f);
+
+    // Every section must be whole
+    size_t off = 0;
+    while (ok && off < len) {
+        uint32_t n;
+        if (off + SECTION_HDR > len) {
+            ok = false;
+            break;
+        }
+        memcpy(&n, buf + off + 4, 4);
+        off += SECTION_HDR + (size_t)n;
+        if (off > len) ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "checkpoint: ignoring %s (%s)\n", path,
+                version && version != VIS_CHECKPOINT_VERSION ? "other version" :
+                fingerprint && fingerprint != c->fingerprint ? "another render" : "damaged");
+        free(buf);
+        return false;
+    }
+    vis_checkpoint_free(c);
+    c->buf = buf;
+    c->len = c->cap = len;
+    return true;
+}
@@ -0,0 +1,367 @@
+#include "include/vis_color.h"
+#include "c/include/cpu_dispatch.h"
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#ifdef CPU_SVE_KERNELS
+#include <arm_sve.h>
+#endif
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Saturated channels are piecewise linear in hue: with x = 6 * hue,
+// r = |x - 3| - 1, g = 2 - |x - 2|, b = 2 - |x - 4|, clamped to [0, 1]
+// (in steps of 1/1024, so x = 6 * i and 1 is 1024), rounded to eight bits.
+// Generated once offline like vis_sin_table_q16, so the table is read-only
+// data shared by every process mapping the binary and nothing is built at
+// startup.
+const uint32_t vis_hue_lut[1 << VIS_HUE_BITS] = {
+    0xFF0000, 0xFF0100, 0xFF0300, 0xFF0400, 0xFF0600, 0xFF0700, 0xFF0900, 0xFF0A00,
+    0xFF0C00, 0xFF0D00, 0xFF0F00, 0xFF1000, 0xFF1200, 0xFF1300, 0xFF1500, 0xFF1600,
+    0xFF1800, 0xFF1900, 0xFF1B00, 0xFF1C00, 0xFF1E00, 0xFF1F00, 0xFF2100, 0xFF2200,
+    0xFF2400, 0xFF2500, 0xFF2700, 0xFF2800, 0xFF2A00, 0xFF2B00, 0xFF2D00, 0xFF2E00,
+    0xFF3000, 0xFF3100, 0xFF3300, 0xFF3400, 0xFF3600, 0xFF3700, 0xFF3900, 0xFF3A00,
+    0xFF3C00, 0xFF3D00, 0xFF3F00, 0xFF4000, 0xFF4200, 0xFF4300, 0xFF4500, 0xFF4600,
+    0xFF4800, 0xFF4900, 0xFF4B00, 0xFF4C00, 0xFF4E00, 0xFF4F00, 0xFF5100, 0xFF5200,
+    0xFF5400, 0xFF5500, 0xFF5700, 0xFF5800, 0xFF5A00, 0xFF5B00, 0xFF5D00, 0xFF5E00,
+    0xFF6000, 0xFF6100, 0xFF6300, 0xFF6400, 0xFF6600, 0xFF6700, 0xFF6900, 0xFF6A00,
+    0xFF6C00, 0xFF6D00, 0xFF6F00, 0xFF7000, 0xFF7200, 0xFF7300, 0xFF7500, 0xFF7600,
+    0xFF7800, 0xFF7900, 0xFF7B00, 0xFF7C00, 0xFF7E00, 0xFF7F00, 0xFF8000, 0xFF8200,
+    0xFF8300, 0xFF8500, 0xFF8600, 0xFF8800, 0xFF8900, 0xFF8B00, 0xFF8C00, 0xFF8E00,
+    0xFF8F00, 0xFF9100, 0xFF9200, 0xFF9400, 0xFF9500, 0xFF9700, 0xFF9800, 0xFF9A00,
+    0xFF9B00, 0xFF9D00, 0xFF9E00, 0xFFA000, 0xFFA100, 0xFFA300, 0xFFA400, 0xFFA600,
+    0xFFA700, 0xFFA900, 0xFFAA00, 0xFFAC00, 0xFFAD00, 0xFFAF00, 0xFFB000, 0xFFB200,
+    0xFFB300, 0xFFB500, 0xFFB600, 0xFFB800, 0xFFB900, 0xFFBB00, 0xFFBC00, 0xFFBE00,
+    0xFFBF00, 0xFFC100, 0xFFC200, 0xFFC400, 0xFFC500, 0xFFC700, 0xFFC800, 0xFFCA00,
+    0xFFCB00, 0xFFCD00, 0xFFCE00, 0xFFD000, 0xFFD100, 0xFFD300, 0xFFD400, 0xFFD600,
+    0xFFD700, 0xFFD900, 0xFFDA00, 0xFFDC00, 0xFFDD00, 0xFFDF00, 0xFFE000, 0xFFE200,
+    0xFFE300, 0xFFE500, 0xFFE600, 0xFFE800, 0xFFE900, 0xFFEB00, 0xFFEC00, 0xFFEE00,
+    0xFFEF00, 0xFFF100, 0xFFF200, 0xFFF400, 0xFFF500, 0xFFF700, 0xFFF800, 0xFFFA00,
+    0xFFFB00, 0xFFFD00, 0xFFFE00, 0xFFFF00, 0xFDFF00, 0xFCFF00, 0xFAFF00, 0xF9FF00,
+    0xF7FF00, 0xF6FF00, 0xF4FF00, 0xF3FF00, 0xF1FF00, 0xF0FF00, 0xEEFF00, 0xEDFF00,
+    0xEBFF00, 0xEAFF00, 0xE8FF00, 0xE7FF00, 0xE5FF00, 0xE4FF00, 0xE2FF00, 0xE1FF00,
+    0xDFFF00, 0xDEFF00, 0xDCFF00, 0xDBFF00, 0xD9FF00, 0xD8FF00, 0xD6FF00, 0xD5FF00,
+    0xD3FF00, 0xD2FF00, 0xD0FF00, 0xCFFF00, 0xCDFF00, 0xCCFF00, 0xCAFF00, 0xC9FF00,
+    0xC7FF00, 0xC6FF00, 0xC4FF00, 0xC3FF00, 0xC1FF00, 0xC0FF00, 0xBEFF00, 0xBDFF00,
+    0xBBFF00, 0xBAFF00, 0xB8FF00, 0xB7FF00, 0xB5FF00, 0xB4FF00, 0xB2FF00, 0xB1FF00,
+    0xAFFF00, 0xAEFF00, 0xACFF00, 0xABFF00, 0xA9FF00, 0xA8FF00, 0xA6FF00, 0xA5FF00,
+    0xA3FF00, 0xA2FF00, 0xA0FF00, 0x9FFF00, 0x9DFF00, 0x9CFF00, 0x9AFF00, 0x99FF00,
+    0x97FF00, 0x96FF00, 0x94FF00, 0x93FF00, 0x91FF00, 0x90FF00, 0x8EFF00, 0x8DFF00,
+    0x8BFF00, 0x8AFF00, 0x88FF00, 0x87FF00, 0x85FF00, 0x84FF00, 0x82FF00, 0x81FF00,
+    0x80FF00, 0x7EFF00, 0x7DFF00, 0x7BFF00, 0x7AFF00, 0x78FF00, 0x77FF00, 0x75FF00,
+    0x74FF00, 0x72FF00, 0x71FF00, 0x6FFF00, 0x6EFF00, 0x6CFF00, 0x6BFF00, 0x69FF00,
+    0x68FF00, 0x66FF00, 0x65FF00, 0x63FF00, 0x62FF00, 0x60FF00, 0x5FFF00, 0x5DFF00,
+    0x5CFF00, 0x5AFF00, 0x59FF00, 0x57FF00, 0x56FF00, 0x54FF00, 0x53FF00, 0x51FF00,
+    0x50FF00, 0x4EFF00, 0x4DFF00, 0x4BFF00, 0x4AFF00, 0x48FF00, 0x47FF00, 0x45FF00,
+    0x44FF00, 0x42FF00, 0x41FF00, 0x3FFF00, 0x3EFF00, 0x3CFF00, 0x3BFF00, 0x39FF00,
+    0x38FF00, 0x36FF00, 0x35FF00, 0x33FF00, 0x32FF00, 0x30FF00, 0x2FFF00, 0x2DFF00,
+    0x2CFF00, 0x2AFF00, 0x29FF00, 0x27FF00, 0x26FF00, 0x24FF00, 0x23FF00, 0x21FF00,
+    0x20FF00, 0x1EFF00, 0x1DFF00, 0x1BFF00, 0x1AFF00, 0x18FF00, 0x17FF00, 0x15FF00,
+    0x14FF00, 0x12FF00, 0x11FF00, 0x0FFF00, 0x0EFF00, 0x0CFF00, 0x0BFF00, 0x09FF00,
+    0x08FF00, 0x06FF00, 0x05FF00, 0x03FF00, 0x02FF00, 0x00FF00, 0x00FF01, 0x00FF02,
+    0x00FF04, 0x00FF05, 0x00FF07, 0x00FF08, 0x00FF0A, 0x00FF0B, 0x00FF0D, 0x00FF0E,
+    0x00FF10, 0x00FF11, 0x00FF13, 0x00FF14, 0x00FF16, 0x00FF17, 0x00FF19, 0x00FF1A,
+    0x00FF1C, 0x00FF1D, 0x00FF1F, 0x00FF20, 0x00FF22, 0x00FF23, 0x00FF25, 0x00FF26,
+    0x00FF28, 0x00FF29, 0x00FF2B, 0x00FF2C, 0x00FF2E, 0x00FF2F, 0x00FF31, 0x00FF32,
+    0x00FF34, 0x00FF35, 0x00FF37, 0x00FF38, 0x00FF3A, 0x00FF3B, 0x00FF3D, 0x00FF3E,
+    0x00FF40, 0x00FF41, 0x00FF43, 0x00FF44, 0x00FF46, 0x00FF47, 0x00FF49, 0x00FF4A,
+    0x00FF4C, 0x00FF4D, 0x00FF4F, 0x00FF50, 0x00FF52, 0x00FF53, 0x00FF55, 0x00FF56,
+    0x00FF58, 0x00FF59, 0x00FF5B, 0x00FF5C, 0x00FF5E, 0x00FF5F, 0x00FF61, 0x00FF62,
+    0x00FF64, 0x00FF65, 0x00FF67, 0x00FF68, 0x00FF6A, 0x00FF6B, 0x00FF6D, 0x00FF6E,
+    0x00FF70, 0x00FF71, 0x00FF73, 0x00FF74, 0x00FF76, 0x00FF77, 0x00FF79, 0x00FF7A,
+    0x00FF7C, 0x00FF7D, 0x00FF7F, 0x00FF80, 0x00FF81, 0x00FF83, 0x00FF84, 0x00FF86,
+    0x00FF87, 0x00FF89, 0x00FF8A, 0x00FF8C, 0x00FF8D, 0x00FF8F, 0x00FF90, 0x00FF92,
+    0x00FF93, 0x00FF95, 0x00FF96, 0x00FF98, 0x00FF99, 0x00FF9B, 0x00FF9C, 0x00FF9E,
+    0x00FF9F, 0x00FFA1, 0x00FFA2, 0x00FFA4, 0x00FFA5, 0x00FFA7, 0x00FFA8, 0x00FFAA,
+    0x00FFAB, 0x00FFAD, 0x00FFAE, 0x00FFB0, 0x00FFB1, 0x00FFB3, 0x00FFB4, 0x00FFB6,
+    0x00FFB7, 0x00FFB9, 0x00FFBA, 0x00FFBC, 0x00FFBD, 0x00FFBF, 0x00FFC0, 0x00FFC2,
+    0x00FFC3, 0x00FFC5, 0x00FFC6, 0x00FFC8, 0x00FFC9, 0x00FFCB, 0x00FFCC, 0x00FFCE,
+    0x00FFCF, 0x00FFD1, 0x00FFD2, 0x00FFD4, 0x00FFD5, 0x00FFD7, 0x00FFD8, 0x00FFDA,
+    0x00FFDB, 0x00FFDD, 0x00FFDE, 0x00FFE0, 0x00FFE1, 0x00FFE3, 0x00FFE4, 0x00FFE6,
+    0x00FFE7, 0x00FFE9, 0x00FFEA, 0x00FFEC, 0x00FFED, 0x00FFEF, 0x00FFF0, 0x00FFF2,
+    0x00FFF3, 0x00FFF5, 0x00FFF6, 0x00FFF8, 0x00FFF9, 0x00FFFB, 0x00FFFC, 0x00FFFE,
+    0x00FFFF, 0x00FEFF, 0x00FCFF, 0x00FBFF, 0x00F9FF, 0x00F8FF, 0x00F6FF, 0x00F5FF,
+    0x00F3FF, 0x00F2FF, 0x00F0FF, 0x00EFFF, 0x00EDFF, 0x00ECFF, 0x00EAFF, 0x00E9FF,
+    0x00E7FF, 0x00E6FF, 0x00E4FF, 0x00E3FF, 0x00E1FF, 0x00E0FF, 0x00DEFF, 0x00DDFF,
+    0x00DBFF, 0x00DAFF, 0x00D8FF, 0x00D7FF, 0x00D5FF, 0x00D4FF, 0x00D2FF, 0x00D1FF,
+    0x00CFFF, 0x00CEFF, 0x00CCFF, 0x00CBFF, 0x00C9FF, 0x00C8FF, 0x00C6FF, 0x00C5FF,
+    0x00C3FF, 0x00C2FF, 0x00C0FF, 0x00BFFF, 0x00BDFF, 0x00BCFF, 0x00BAFF, 0x00B9FF,
+    0x00B7FF, 0x00B6FF, 0x00B4FF, 0x00B3FF, 0x00B1FF, 0x00B0FF, 0x00AEFF, 0x00ADFF,
+    0x00ABFF, 0x00AAFF, 0x00A8FF, 0x00A7FF, 0x00A5FF, 0x00A4FF, 0x00A2FF, 0x00A1FF,
+    0x009FFF, 0x009EFF, 0x009CFF, 0x009BFF, 0x0099FF, 0x0098FF, 0x0096FF, 0x0095FF,
+    0x0093FF, 0x0092FF, 0x0090FF, 0x008FFF, 0x008DFF, 0x008CFF, 0x008AFF, 0x0089FF,
+    0x0087FF, 0x0086FF, 0x0084FF, 0x0083FF, 0x0081FF, 0x0080FF, 0x007FFF, 0x007DFF,
+    0x007CFF, 0x007AFF, 0x0079FF, 0x0077FF, 0x0076FF, 0x0074FF, 0x0073FF, 0x0071FF,
+    0x0070FF, 0x006EFF, 0x006DFF, 0x006BFF, 0x006AFF, 0x0068FF, 0x0067FF, 0x0065FF,
+    0x0064FF, 0x0062FF, 0x0061FF, 0x005FFF, 0x005EFF, 0x005CFF, 0x005BFF, 0x0059FF,
+    0x0058FF, 0x0056FF, 0x0055FF, 0x0053FF, 0x0052FF, 0x0050FF, 0x004FFF, 0x004DFF,
+    0x004CFF, 0x004AFF, 0x0049FF, 0x0047FF, 0x0046FF, 0x0044FF, 0x0043FF, 0x0041FF,
+    0x0040FF, 0x003EFF, 0x003DFF, 0x003BFF, 0x003AFF, 0x0038FF, 0x0037FF, 0x0035FF,
+    0x0034FF, 0x0032FF, 0x0031FF, 0x002FFF, 0x002EFF, 0x002CFF, 0x002BFF, 0x0029FF,
+    0x0028FF, 0x0026FF, 0x0025FF, 0x0023FF, 0x0022FF, 0x0020FF, 0x001FFF, 0x001DFF,
+    0x001CFF, 0x001AFF, 0x0019FF, 0x0017FF, 0x0016FF, 0x0014FF, 0x0013FF, 0x0011FF,
+    0x0010FF, 0x000EFF, 0x000DFF, 0x000BFF, 0x000AFF, 0x0008FF, 0x0007FF, 0x0005FF,
+    0x0004FF, 0x0002FF, 0x0001FF, 0x0000FF, 0x0200FF, 0x0300FF, 0x0500FF, 0x0600FF,
+    0x0800FF, 0x0900FF, 0x0B00FF, 0x0C00FF, 0x0E00FF, 0x0F00FF, 0x1100FF, 0x1200FF,
+    0x1400FF, 0x1500FF, 0x1700FF, 0x1800FF, 0x1A00FF, 0x1B00FF, 0x1D00FF, 0x1E00FF,
+    0x2000FF, 0x2100FF, 0x2300FF, 0x2400FF, 0x2600FF, 0x2700FF, 0x2900FF, 0x2A00FF,
+    0x2C00FF, 0x2D00FF, 0x2F00FF, 0x3000FF, 0x3200FF, 0x3300FF, 0x3500FF, 0x3600FF,
+    0x3800FF, 0x3900FF, 0x3B00FF, 0x3C00FF, 0x3E00FF, 0x3F00FF, 0x4100FF, 0x4200FF,
+    0x4400FF, 0x4500FF, 0x4700FF, 0x4800FF, 0x4A00FF, 0x4B00FF, 0x4D00FF, 0x4E00FF,
+    0x5000FF, 0x5100FF, 0x5300FF, 0x5400FF, 0x5600FF, 0x5700FF, 0x5900FF, 0x5A00FF,
+    0x5C00FF, 0x5D00FF, 0x5F00FF, 0x6000FF, 0x6200FF, 0x6300FF, 0x6500FF, 0x6600FF,
+    0x6800FF, 0x6900FF, 0x6B00FF, 0x6C00FF, 0x6E00FF, 0x6F00FF, 0x7100FF, 0x7200FF,
+    0x7400FF, 0x7500FF, 0x7700FF, 0x7800FF, 0x7A00FF, 0x7B00FF, 0x7D00FF, 0x7E00FF,
+    0x8000FF, 0x8100FF, 0x8200FF, 0x8400FF, 0x8500FF, 0x8700FF, 0x8800FF, 0x8A00FF,
+    0x8B00FF, 0x8D00FF, 0x8E00FF, 0x9000FF, 0x9100FF, 0x9300FF, 0x9400FF, 0x9600FF,
+    0x9700FF, 0x9900FF, 0x9A00FF, 0x9C00FF, 0x9D00FF, 0x9F00FF, 0xA000FF, 0xA200FF,
+    0xA300FF, 0xA500FF, 0xA600FF, 0xA800FF, 0xA900FF, 0xAB00FF, 0xAC00FF, 0xAE00FF,
+    0xAF00FF, 0xB100FF, 0xB200FF, 0xB400FF, 0xB500FF, 0xB700FF, 0xB800FF, 0xBA00FF,
+    0xBB00FF, 0xBD00FF, 0xBE00FF, 0xC000FF, 0xC100FF, 0xC300FF, 0xC400FF, 0xC600FF,
+    0xC700FF, 0xC900FF, 0xCA00FF, 0xCC00FF, 0xCD00FF, 0xCF00FF, 0xD000FF, 0xD200FF,
+    0xD300FF, 0xD500FF, 0xD600FF, 0xD800FF, 0xD900FF, 0xDB00FF, 0xDC00FF, 0xDE00FF,
+    0xDF00FF, 0xE100FF, 0xE200FF, 0xE400FF, 0xE500FF, 0xE700FF, 0xE800FF, 0xEA00FF,
+    0xEB00FF, 0xED00FF, 0xEE00FF, 0xF000FF, 0xF100FF, 0xF300FF, 0xF400FF, 0xF600FF,
+    0xF700FF, 0xF900FF, 0xFA00FF, 0xFC00FF, 0xFD00FF, 0xFF00FF, 0xFF00FE, 0xFF00FD,
+    0xFF00FB, 0xFF00FA, 0xFF00F8, 0xFF00F7, 0xFF00F5, 0xFF00F4, 0xFF00F2, 0xFF00F1,
+    0xFF00EF, 0xFF00EE, 0xFF00EC, 0xFF00EB, 0xFF00E9, 0xFF00E8, 0xFF00E6, 0xFF00E5,
+    0xFF00E3, 0xFF00E2, 0xFF00E0, 0xFF00DF, 0xFF00DD, 0xFF00DC, 0xFF00DA, 0xFF00D9,
+    0xFF00D7, 0xFF00D6, 0xFF00D4, 0xFF00D3, 0xFF00D1, 0xFF00D0, 0xFF00CE, 0xFF00CD,
+    0xFF00CB, 0xFF00CA, 0xFF00C8, 0xFF00C7, 0xFF00C5, 0xFF00C4, 0xFF00C2, 0xFF00C1,
+    0xFF00BF, 0xFF00BE, 0xFF00BC, 0xFF00BB, 0xFF00B9, 0xFF00B8, 0xFF00B6, 0xFF00B5,
+    0xFF00B3, 0xFF00B2, 0xFF00B0, 0xFF00AF, 0xFF00AD, 0xFF00AC, 0xFF00AA, 0xFF00A9,
+    0xFF00A7, 0xFF00A6, 0xFF00A4, 0xFF00A3, 0xFF00A1, 0xFF00A0, 0xFF009E, 0xFF009D,
+    0xFF009B, 0xFF009A, 0xFF0098, 0xFF0097, 0xFF0095, 0xFF0094, 0xFF0092, 0xFF0091,
+    0xFF008F, 0xFF008E, 0xFF008C, 0xFF008B, 0xFF0089, 0xFF0088, 0xFF0086, 0xFF0085,
+    0xFF0083, 0xFF0082, 0xFF0080, 0xFF007F, 0xFF007E, 0xFF007C, 0xFF007B, 0xFF0079,
+    0xFF0078, 0xFF0076, 0xFF0075, 0xFF0073, 0xFF0072, 0xFF0070, 0xFF006F, 0xFF006D,
+    0xFF006C, 0xFF006A, 0xFF0069, 0xFF0067, 0xFF0066, 0xFF0064, 0xFF0063, 0xFF0061,
+    0xFF0060, 0xFF005E, 0xFF005D, 0xFF005B, 0xFF005A, 0xFF0058, 0xFF0057, 0xFF0055,
+    0xFF0054, 0xFF0052, 0xFF0051, 0xFF004F, 0xFF004E, 0xFF004C, 0xFF004B, 0xFF0049,
+    0xFF0048, 0xFF0046, 0xFF0045, 0xFF0043, 0xFF0042, 0xFF0040, 0xFF003F, 0xFF003D,
+    0xFF003C, 0xFF003A, 0xFF0039, 0xFF0037, 0xFF0036, 0xFF0034, 0xFF0033, 0xFF0031,
+    0xFF0030, 0xFF002E, 0xFF002D, 0xFF002B, 0xFF002A, 0xFF0028, 0xFF0027, 0xFF0025,
+    0xFF0024, 0xFF0022, 0xFF0021, 0xFF001F, 0xFF001E, 0xFF001C, 0xFF001B, 0xFF0019,
+    0xFF0018, 0xFF0016, 0xFF0015, 0xFF0013, 0xFF0012, 0xFF0010, 0xFF000F, 0xFF000D,
+    0xFF000C, 0xFF000A, 0xFF0009, 0xFF0007, 0xFF0006, 0xFF0004, 0xFF0003, 0xFF0001,
+};
+
+#if defined(__ARM_NEON)
+static inline uint32x4_t hue_index_neon(float32x4_t h) {
+    float32x4_t q = vmulq_n_f32(h, (float)(1 << VIS_HUE_BITS));
+    uint32x4_t ok = vcaltq_f32(q, vdupq_n_f32(16777216.0f));    // false for NaN too
+    q = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(q), ok));
+    int32x4_t i = vcvtmq_s32_f32(vaddq_f32(q, vdupq_n_f32(0.5f)));
+    return vandq_u32(vreinterpretq_u32_s32(i), vdupq_n_u32((1u << VIS_HUE_BITS) - 1));
+}
+
+static inline uint32x4_t unit_q8_neon(float32x4_t x) {
+    x = vminnmq_f32(vmaxnmq_f32(x, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+    return vcvtq_u32_f32(vaddq_f32(vmulq_n_f32(x, 256.0f), vdupq_n_f32(0.5f)));
+}
+
+static inline uint32x4_t hsv_channel_neon(uint32x4_t c8, uint32x4_t s, uint32x4_t v) {
+    uint32x4_t t = vmlsq_u32(vdupq_n_u32(255u * 256u), s, vsubq_u32(vdupq_n_u32(255), c8));
+    return vshrq_n_u32(vmlaq_u32(vdupq_n_u32(32768), v, t), 16);
+}
+
+static void hsv_pixels_simd(const float *h, const float *s, const float *v, uint32_t *out, int n) {
+    const uint32x4_t lo8 = vdupq_n_u32(0xFF);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32_t idx[4];
+        vst1q_u32(idx, hue_index_neon(vld1q_f32(h + i)));
+        uint32_t lut[4] = { vis_hue_lut[idx[0]], vis_hue_lut[idx[1]], vis_hue_lut[idx[2]], vis_hue_lut[idx[3]] };
+        uint32x4_t base = vld1q_u32(lut);
+        uint32x4_t sq = unit_q8_neon(vld1q_f32(s + i)), vq = unit_q8_neon(vld1q_f32(v + i));
+        uint32x4_t r = hsv_channel_neon(vshrq_n_u32(base, 16), sq, vq);
+        uint32x4_t g = hsv_channel_neon(vandq_u32(vshrq_n_u32(base, 8), lo8), sq, vq);
+        uint32x4_t b = hsv_channel_neon(vandq_u32(base, lo8), sq, vq);
+        uint32x4_t px = vorrq_u32(vorrq_u32(vshlq_n_u32(r, 16), vshlq_n_u32(g, 8)), b);
+        vst1q_u32(out + i, vorrq_u32(px, vdupq_n_u32(0xFF000000u)));
+    }
+    for (; i < n; i++)
+        out[i] = vis_hsv_pixel(h[i], s[i], v[i]);
+}
+
+#ifdef CPU_SVE_KERNELS
+// The NEON steps a vector at a time, with the hue table read by a gather
+// and the last vector predicated rather than finished one pixel at a time
+CPU_TARGET_SVE
+static void hsv_pixels_sve(const float *h, const float *s, const float *v, uint32_t *out, int n) {
+    for (int64_t i = 0; i < n; i += (int64_t)svcntw()) {
+        svbool_t pg = svwhilelt_b32_s64(i, n);
+        svfloat32_t q = svmul_n_f32_x(pg, svld1_f32(pg, h + i), (float)(1 << VIS_HUE_BITS));
+        q = svsel_f32(svaclt_n_f32(pg, q, 16777216.0f), q, svdup_n_f32(0.0f));   // false for NaN too
+        svint32_t t = svcvt_s32_f32_x(pg, svrintm_f32_x(pg, svadd_n_f32_x(pg, q, 0.5f)));
+        svuint32_t idx = svand_n_u32_x(pg, svreinterpret_u32_s32(t), (1u << VIS_HUE_BITS) - 1);
+        svuint32_t base = svld1_gather_u32index_u32(pg, vis_hue_lut, idx);
+
+        svfloat32_t sv = svminnm_n_f32_x(pg, svmaxnm_n_f32_x(pg, svld1_f32(pg, s + i), 0.0f), 1.0f);
+        svfloat32_t vv = svminnm_n_f32_x(pg, svmaxnm_n_f32_x(pg, svld1_f32(pg, v + i), 0.0f), 1.0f);
+        svuint32_t sq = svcvt_u32_f32_x(pg, svadd_n_f32_x(pg, svmul_n_f32_x(pg, sv, 256.0f), 0.5f));
+        svuint32_t vq = svcvt_u32_f32_x(pg, svadd_n_f32_x(pg, svmul_n_f32_x(pg, vv, 256.0f), 0.5f));
+
+        svuint32_t px = svdup_n_u32(0xFF000000u);
+        for (int k = 2; k >= 0; k--) {
+            svuint32_t c8 = svand_n_u32_x(pg, svlsr_n_u32_x(pg, base, 8 * k), 0xFF);
+            svuint32_t tt = svmls_u32_x(pg, svdup_n_u32(255u * 256u), sq, svsubr_n_u32_x(pg, c8, 255));
+            svuint32_t ch = svlsr_n_u32_x(pg, svmla_u32_x(pg, svdup_n_u32(32768), vq, tt), 16);
+            px = svorr_u32_x(pg, px, svlsl_n_u32_x(pg, ch, 8 * k));
+        }
+        svst1_u32(pg, out + i, px);
+    }
+}
+#endif
+#elif defined(__SSE2__)
+// 32-bit lane products (pmulld is SSE4.1): even and odd lanes through pmuludq
+static inline __m128i mullo32_sse2(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i hue_index_sse2(__m128 h) {
+    __m128 q = _mm_mul_ps(h, _mm_set1_ps((float)(1 << VIS_HUE_BITS)));
+    __m128 mag = _mm_andnot_ps(_mm_set1_ps(-0.0f), q);
+    q = _mm_and_ps(q, _mm_cmplt_ps(mag, _mm_set1_ps(16777216.0f)));   // false for NaN too
+    // floor(q + 0.5): truncate, then step down where truncation rounded up
+    __m128 x = _mm_add_ps(q, _mm_set1_ps(0.5f));
+    __m128i t = _mm_cvttps_epi32(x);
+    t = _mm_add_epi32(t, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(t), x)));
+    return _mm_and_si128(t, _mm_set1_epi32((1 << VIS_HUE_BITS) - 1));
+}
+
+static inline __m128i unit_q8_sse2(__m128 x) {
+    // maxps returns its second operand for NaN, as fmaxf(NaN, 0) does
+    x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(256.0f)), _mm_set1_ps(0.5f)));
+}
+
+static inline __m128i hsv_channel_sse2(__m128i c8, __m128i s, __m128i v) {
+    __m128i t = _mm_sub_epi32(_mm_set1_epi32(255 * 256), mullo32_sse2(s, _mm_sub_epi32(_mm_set1_epi32(255), c8)));
+    return _mm_srli_epi32(_mm_add_epi32(mullo32_sse2(v, t), _mm_set1_epi32(32768)), 16);
+}
+
+static void hsv_pixels_simd(const float *h, const float *s, const float *v, uint32_t *out, int n) {
+    const __m128i lo8 = _mm_set1_epi32(0xFF);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32_t idx[4];
+        _mm_storeu_si128((__m128i *)idx, hue_index_sse2(_mm_loadu_ps(h + i)));
+        __m128i base = _mm_setr_epi32((int)vis_hue_lut[idx[0]], (int)vis_hue_lut[idx[1]],
+                                      (int)vis_hue_lut[idx[2]], (int)vis_hue_lut[idx[3]]);
+        __m128i sq = unit_q8_sse2(_mm_loadu_ps(s + i)), vq = unit_q8_sse2(_mm_loadu_ps(v + i));
+        __m128i r = hsv_channel_sse2(_mm_srli_epi32(base, 16), sq, vq);
+        __m128i g = hsv_channel_sse2(_mm_and_si128(_mm_srli_epi32(base, 8), lo8), sq, vq);
+        __m128i b = hsv_channel_sse2(_mm_and_si128(base, lo8), sq, vq);
+        __m128i px = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, 16), _mm_slli_epi32(g, 8)), b);
+        _mm_storeu_si128((__m128i *)(out + i), _mm_or_si128(px, _mm_set1_epi32((int)0xFF000000u)));
+    }
+    for (; i < n; i++)
+        out[i] = vis_hsv_pixel(h[i], s[i], v[i]);
+}
+
+// The SSE2 steps eight and sixteen wide: pmulld for the channel products,
+// and the hue table read by a gather.  Same pixels as every other path.
+__attribute__((target("avx2")))
+static void hsv_pixels_avx2(const float *h, const float *s, const float *v, uint32_t *out, int n) {
+    const __m256i lo8 = _mm256_set1_epi32(0xFF), c255 = _mm256_set1_epi32(255);
+    const __m256i c65280 = _mm256_set1_epi32(255 * 256), half = _mm256_set1_epi32(32768);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 q = _mm256_mul_ps(_mm256_loadu_ps(h + i), _mm256_set1_ps((float)(1 << VIS_HUE_BITS)));
+        __m256 mag = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), q);
+        q = _mm256_and_ps(q, _mm256_cmp_ps(mag, _mm256_set1_ps(16777216.0f), _CMP_LT_OQ));
+        __m256 x = _mm256_add_ps(q, _mm256_set1_ps(0.5f));
+        __m256i t = _mm256_cvttps_epi32(x);
+        t = _mm256_add_epi32(t, _mm256_castps_si256(_mm256_cmp_ps(_mm256_cvtepi32_ps(t), x, _CMP_GT_OQ)));
+        __m256i idx = _mm256_and_si256(t, _mm256_set1_epi32((1 << VIS_HUE_BITS) - 1));
+        __m256i base = _mm256_i32gather_epi32((const int *)vis_hue_lut, idx, 4);
+
+        __m256 sv = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(s + i), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+        __m256 vv = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(v + i), _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+        __m256i sq = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(sv, _mm256_set1_ps(256.0f)), _mm256_set1_ps(0.5f)));
+        __m256i vq = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(vv, _mm256_set1_ps(256.0f)), _mm256_set1_ps(0.5f)));
+
+        __m256i px = _mm256_set1_epi32((int)0xFF000000u);
+        for (int k = 2; k >= 0; k--) {
+            __m256i c8 = _mm256_and_si256(_mm256_srli_epi32(base, 8 * k), lo8);
+            __m256i tt = _mm256_sub_epi32(c65280, _mm256_mullo_epi32(sq, _mm256_sub_epi32(c255, c8)));
+            __m256i ch = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(vq, tt), half), 16);
+            px = _mm256_or_si256(px, _mm256_slli_epi32(ch, 8 * k));
+        }
+        _mm256_storeu_si256((__m256i *)(out + i), px);
+    }
+    hsv_pixels_simd(h + i, s + i, v + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f,avx512dq,avx512bw,avx512vl")))
+static void hsv_pixels_avx512(const float *h, const float *s, const float *v, uint32_t *out, int n) {
+    const __m512i lo8 = _mm512_set1_epi32(0xFF), c255 = _mm512_set1_epi32(255);
+    const __m512i c65280 = _mm512_set1_epi32(255 * 256), half = _mm512_set1_epi32(32768);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 q = _mm512_mul_ps(_mm512_loadu_ps(h + i), _mm512_set1_ps((float)(1 << VIS_HUE_BITS)));
+        __m512 mag = _mm512_abs_ps(q);
+        q = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(mag, _mm512_set1_ps(16777216.0f), _CMP_LT_OQ), q);
+        __m512 x = _mm512_add_ps(q, _mm512_set1_ps(0.5f));
+        __m512i t = _mm512_cvttps_epi32(x);
+        t = _mm512_mask_sub_epi32(t, _mm512_cmp_ps_mask(_mm512_cvtepi32_ps(t), x, _CMP_GT_OQ), t, _mm512_set1_epi32(1));
+        __m512i idx = _mm512_and_si512(t, _mm512_set1_epi32((1 << VIS_HUE_BITS) - 1));
+        __m512i base = _mm512_i32gather_epi32(idx, (const void *)vis_hue_lut, 4);
+
+        __m512 sv = _mm512_min_ps(_mm512_max_ps(_mm512_loadu_ps(s + i), _mm512_setzero_ps()), _mm512_set1_ps(1.0f));
+        __m512 vv = _mm512_min_ps(_mm512_max_ps(_mm512_loadu_ps(v + i), _mm512_setzero_ps()), _mm512_set1_ps(1.0f));
+        __m512i sq = _mm512_cvttps_epi32(_mm512_add_ps(_mm512_mul_ps(sv, _mm512_set1_ps(256.0f)), _mm512_set1_ps(0.5f)));
+        __m512i vq = _mm512_cvttps_epi32(_mm512_add_ps(_mm512_mul_ps(vv, _mm512_set1_ps(256.0f)), _mm512_set1_ps(0.5f)));
+
+        __m512i px = _mm512_set1_epi32((int)0xFF000000u);
+        for (int k = 2; k >= 0; k--) {
+            __m512i c8 = _mm512_and_si512(_mm512_srli_epi32(base, 8 * k), lo8);
+            __m512i tt = _mm512_sub_epi32(c65280, _mm512_mullo_epi32(sq, _mm512_sub_epi32(c255, c8)));
+            __m512i ch = _mm512_srli_epi32(_mm512_add_epi32(_mm512_mullo_epi32(vq, tt), half), 16);
+            px = _mm512_or_si512(px, _mm512_slli_epi32(ch, 8 * k));
+        }
+        _mm512_storeu_si512((void *)(out + i), px);
+    }
+    hsv_pixels_avx2(h + i, s + i, v + i, out + i, n - i);
+}
+#endif
+
+static void hsv_pixels_c(const float *h, const float *s, const float *v, uint32_t *out, int n) {
+    for (int i = 0; i < n; i++)
+        out[i] = vis_hsv_pixel(h[i], s[i], v[i]);
+}
+
+#if defined(__ARM_NEON) && defined(CPU_SVE_KERNELS)
+#define HSV_PIXELS_ISAS (CPU_ISA_BIT(CPU_ISA_SCALAR) | CPU_ISA_BIT(CPU_ISA_NEON) | CPU_ISA_BIT(CPU_ISA_SVE))
+#elif defined(__ARM_NEON)
+#define HSV_PIXELS_ISAS (CPU_ISA_BIT(CPU_ISA_SCALAR) | CPU_ISA_BIT(CPU_ISA_NEON))
+#elif defined(__SSE2__)
+#define HSV_PIXELS_ISAS (CPU_ISA_BIT(CPU_ISA_SCALAR) | CPU_ISA_BIT(CPU_ISA_SSE2) | \
+                         CPU_ISA_BIT(CPU_ISA_AVX2) | CPU_ISA_BIT(CPU_ISA_AVX512))
+#else
+#define HSV_PIXELS_ISAS CPU_ISA_BIT(CPU_ISA_SCALAR)
+#endif
+
+typedef void (*hsv_pixels_fn)(const float *, const float *, const float *, uint32_t *, int);
+static const hsv_pixels_fn hsv_pixels_k[CPU_ISA_COUNT] = {
+    [CPU_ISA_SCALAR] = hsv_pixels_c,
+#if defined(__ARM_NEON)
+    [CPU_ISA_NEON] = hsv_pixels_simd,
+#ifdef CPU_SVE_KERNELS
+    [CPU_ISA_SVE] = hsv_pixels_sve,
+#endif
+#elif defined(__SSE2__)
+    [CPU_ISA_SSE2] = hsv_pixels_simd,
+    [CPU_ISA_AVX2] = hsv_pixels_avx2,
+    [CPU_ISA_AVX512] = hsv_pixels_avx512,
+#endif
+};
+
+void vis_hsv_pixels(const float *h, const float *s, const float *v, uint32_t *out, int n) {
+    static int isa = -1;
+    hsv_pixels_k[cpu_isa_resolve(&isa, HSV_PIXELS_ISAS)](h, s, v, out, n);
+}
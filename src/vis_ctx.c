@@ -0,0 +1,220 @@
+#include "include/vis_ctx.h"
+#include "include/visual_types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// State blocks exported by the visual asm modules
+extern uint8_t vis_terrain_state[], vis_terrain_state_end[];
+extern uint8_t vis_glitch_state[], vis_glitch_state_end[];
+extern uint8_t vis_particles_state[], vis_particles_state_end[];
+extern uint8_t vis_bass_hits_state[], vis_bass_hits_state_end[];
+
+typedef struct {
+    uint8_t *begin, *end;
+} vis_asm_block_t;
+
+#define VIS_ASM_BLOCKS 4
+
+static vis_asm_block_t asm_blocks(int i) {
+    switch (i) {
+    case 0:  return (vis_asm_block_t){ vis_terrain_state, vis_terrain_state_end };
+    case 1:  return (vis_asm_block_t){ vis_glitch_state, vis_glitch_state_end };
+    case 2:  return (vis_asm_block_t){ vis_particles_state, vis_particles_state_end };
+    default: return (vis_asm_block_t){ vis_bass_hits_state, vis_bass_hits_state_end };
+    }
+}
+
+static vis_ctx_t *g_bound = NULL;   // context whose state is live in the modules
+static uint8_t *g_pristine = NULL;  // module state as linked, before any init
+
+size_t vis_ctx_asm_state_bytes(void) {
+    size_t total = 0;
+    for (int i = 0; i < VIS_ASM_BLOCKS; i++) {
+        vis_asm_block_t b = asm_blocks(i);
+        total += (size_t)(b.end - b.begin);
+    }
+    return total;
+}
+
+// Copy the live module blocks to `dst` (save) or from `src` (load)
+static void asm_state_copy(uint8_t *dst, const uint8_t *src) {
+    size_t off = 0;
+    for (int i = 0; i < VIS_ASM_BLOCKS; i++) {
+        vis_asm_block_t b = asm_blocks(i);
+        size_t n = (size_t)(b.end - b.begin);
+        if (dst) memcpy(dst + off, b.begin, n);
+        else memcpy(b.begin, src + off, n);
+        off += n;
+    }
+}
+
+bool vis_ctx_init(vis_ctx_t *ctx, uint32_t seed) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->last_shot_frame = -100;
+    ctx->budget_policy.quality = 1.0f;
+    vis_format_init(&ctx->format, VIS_FORMAT_FULL);
+    prng_streams_init(&ctx->prng, seed);
+
+    size_t bytes = vis_ctx_asm_state_bytes();
+    if (!g_pristine) {
+        g_pristine = malloc(bytes);
+        if (!g_pristine) return false;
+        asm_state_copy(g_pristine, NULL);
+    }
+    ctx->asm_state = malloc(bytes);
+    if (!ctx->asm_state) {
+        fprintf(stderr, "vis_ctx: out of memory\n");
+        return false;
+    }
+    memcpy(ctx->asm_state, g_pristine, bytes);
+    return true;
+}
+
+bool vis_format_init(vis_format_t *f, const char *spec) {
+    if (strcmp(spec, "full") == 0) spec = VIS_FORMAT_FULL;
+    else if (strcmp(spec, "preview") == 0) spec = VIS_FORMAT_PREVIEW;
+    int w = VIS_WIDTH, h = VIS_HEIGHT, fps = VIS_FPS;
+    const char *at = strchr(spec, '@');
+    if (at != spec && sscanf(spec, "%dx%d", &w, &h) != 2) {
+        fprintf(stderr, "vis_format: bad size in \"%s\" (WxH[@FPS])\n", spec);
+        return false;
+    }
+    if (at && sscanf(at + 1, "%d", &fps) != 1) {
+        fprintf(stderr, "vis_format: bad frame rate in \"%s\"\n", spec);
+        return false;
+    }
+    if (w <= 0 || h <= 0 || VIS_WIDTH % w || VIS_HEIGHT % h || VIS_WIDTH / w != VIS_HEIGHT / h || (w | h) & 1) {
+        fprintf(stderr, "vis_format: %dx%d is not %dx%d divided by a whole number (with even sides)\n",
+                w, h, VIS_WIDTH, VIS_HEIGHT);
+        return false;
+    }
+    if (VIS_WIDTH / w > 16) {
+        fprintf(stderr, "vis_format: %dx%d is more than 16x below the native raster\n", w, h);
+        return false;
+    }
+    if (fps <= 0 || VIS_FPS % fps) {
+        fprintf(stderr, "vis_format: %d fps does not divide the %d fps render clock\n", fps, VIS_FPS);
+        return false;
+    }
+    f->width = w;
+    f->height = h;
+    f->fps = fps;
+    f->scale = VIS_WIDTH / w;
+    f->step = VIS_FPS / fps;
+    return true;
+}
+
+void vis_ctx_free(vis_ctx_t *ctx) {
+    if (g_bound == ctx) g_bound = NULL;
+    for (int v = 0; v < 2; v++)
+        for (int i = 0; i < BOSS_MAX_PARTS; i++) vis_boss_sprite_free(&ctx->boss_sprites[v][i]);
+    vis_dl_free(&ctx->dl);
+    free(ctx->asm_state);
+    ctx->asm_state = NULL;
+}
+
+void vis_ctx_bind(vis_ctx_t *ctx) {
+    if (g_bound == ctx) return;
+    if (g_bound) asm_state_copy(g_bound->asm_state, NULL);
+    asm_state_copy(NULL, ctx->asm_state);
+    g_bound = ctx;
+}
+
+// Frame state in a checkpoint.  The projectile pool is stored as its live
+// slots only: the free bitmaps are exactly the complement of them.
+typedef struct {
+    workload_budget_t budget;
+    vis_budget_policy_t budget_policy;
+    int last_shot_frame;
+    int projectiles;
+} ctx_frame_state_t;
+
+typedef struct {
+    uint16_t slot;
+    projectile_t p;
+} ctx_projectile_t;
+
+bool vis_ctx_checkpoint(const vis_ctx_t *ctx, vis_checkpoint_t *c) {
+    ctx_frame_state_t st;
+    memset(&st, 0, sizeof(st));
+    st.budget = ctx->budget;
+    st.budget_policy = ctx->budget_policy;
+    st.last_shot_frame = ctx->last_shot_frame;
+    st.projectiles = ctx->projectiles.count;
+
+    const projectile_pool_t *pool = &ctx->projectiles;
+    ctx_projectile_t *live = malloc(((size_t)pool->count + 1) * sizeof(*live));
+    size_t asm_bytes = vis_ctx_asm_state_bytes();
+    uint8_t *asm_state = malloc(asm_bytes);
+    bool ok = live && asm_state;
+    if (ok) {
+        memset(live, 0, ((size_t)pool->count + 1) * sizeof(*live));
+        for (int n = 0; n < pool->count; n++) {
+            live[n].slot = pool->live[n];
+            live[n].p = pool->slots[pool->live[n]];
+        }
+        if (g_bound == ctx) asm_state_copy(asm_state, NULL);
+        else memcpy(asm_state, ctx->asm_state, asm_bytes);
+        ok = vis_checkpoint_put(c, "CTXF", &st, sizeof(st)) &&
+             vis_checkpoint_put(c, "PROJ", live, (size_t)pool->count * sizeof(*live)) &&
+             vis_checkpoint_put(c, "ASMS", asm_state, asm_bytes);
+    }
+    free(live);
+    free(asm_state);
+    return ok;
+}
+
+bool vis_ctx_restore(vis_ctx_t *ctx, const vis_checkpoint_t *c) {
+    const ctx_frame_state_t *st = vis_checkpoint_get(c, "CTXF", sizeof(*st));
+    if (!st || st->projectiles < 0 || st->projectiles > MAX_PROJECTILES) return false;
+    const ctx_projectile_t *live = vis_checkpoint_get(c, "PROJ", (size_t)st->projectiles * sizeof(*live));
+    size_t asm_bytes = vis_ctx_asm_state_bytes();
+    const uint8_t *asm_state = vis_checkpoint_get(c, "ASMS", asm_bytes);
+    if ((!live && st->projectiles > 0) || !asm_state) return false;
+
+    ctx->budget = st->budget;
+    ctx->budget_policy = st->budget_policy;
+    ctx->last_shot_frame = st->last_shot_frame;
+    projectile_pool_t *pool = &ctx->projectiles;
+    memset(pool, 0, sizeof(*pool));
+    for (int n = 0; n < st->projectiles; n++) {
+        int slot = live[n].slot;
+        if (slot >= MAX_PROJECTILES) return false;
+        pool->slots[slot] = live[n].p;
+        pool->live[n] = (uint16_t)slot;
+        pool->used[slot / 64] |= 1ULL << (slot % 64);
+        if (pool->used[slot / 64] == ~0ULL) pool->full |= 1ULL << (slot / 64);
+    }
+    pool->count = st->projectiles;
+    if (g_bound == ctx) asm_state_copy(NULL, asm_state);
+    else memcpy(ctx->asm_state, asm_state, asm_bytes);
+    return true;
+}
+
+// `full` has one bit per word of `used`, all of them real words
+_Static_assert(MAX_PROJECTILES == 64 * 64, "projectile pool bitmap expects 4096 slots");
+
+int projectile_pool_alloc(projectile_pool_t *pool) {
+    if (pool->full == ~0ULL) return -1;
+    int w = __builtin_ctzll(~pool->full);
+    int bit = __builtin_ctzll(~pool->used[w]);
+    int slot = w * 64 + bit;
+    pool->used[w] |= 1ULL << bit;
+    if (pool->used[w] == ~0ULL) pool->full |= 1ULL << w;
+
+    // Keep `live` in slot order
+    int pos = pool->count;
+    while (pos > 0 && pool->live[pos - 1] > slot) {
+        pool->live[pos] = pool->live[pos - 1];
+        pos--;
+    }
+    pool->live[pos] = (uint16_t)slot;
+    pool->count++;
+    return slot;
+}
+
+void projectile_pool_release(projectile_pool_t *pool, int slot) {
+    pool->used[slot / 64] &= ~(1ULL << (slot % 64));
+    pool->full &= ~(1ULL << (slot / 64));
+}
@@ -0,0 +1,220 @@
+// Per-frame display list (vis_dlist.h): emit with culling, draw in order
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "include/vis_dlist.h"
+#include "include/visual_types.h"
+#include "c/include/prof.h"
+
+extern void draw_terrain_enhanced_asm(uint32_t *pixels, int frame, float audio_level);
+extern void draw_bass_hits_asm(uint32_t *pixels, int frame);
+extern void draw_ascii_char_asm(uint32_t *pixels, int x, int y, char c, uint32_t color, int bg_alpha);
+extern void draw_ascii_run_asm(uint32_t *pixels, int x, int y, const char *s, int n, uint32_t color);
+
+#define GLYPH_PX 8                                  // draw_ascii_char_asm cell
+
+void vis_dl_reset(vis_dlist_t *dl, int frame) {
+    dl->frame = frame;
+    dl->count = 0;
+    dl->text_len = 0;
+    dl->culled = 0;
+}
+
+void vis_dl_free(vis_dlist_t *dl) {
+    free(dl->items);
+    free(dl->text);
+    memset(dl, 0, sizeof(*dl));
+}
+
+static vis_dl_item_t *dl_push(vis_dlist_t *dl, vis_dl_type_t type) {
+    if (dl->count == dl->cap) {
+        int cap = dl->cap ? 2 * dl->cap : 1024;
+        vis_dl_item_t *items = realloc(dl->items, (size_t)cap * sizeof(*items));
+        if (!items) return NULL;
+        dl->items = items;
+        dl->cap = cap;
+    }
+    vis_dl_item_t *it = &dl->items[dl->count++];
+    memset(it, 0, sizeof(*it));
+    it->type = (uint8_t)type;
+    return it;
+}
+
+static void dl_box(vis_dl_item_t *it, int x0, int y0, int x1, int y1) {
+    it->x0 = (int16_t)x0;
+    it->y0 = (int16_t)y0;
+    it->x1 = (int16_t)x1;
+    it->y1 = (int16_t)y1;
+}
+
+// Pixel box wholly off the raster
+static bool off_raster(int x0, int y0, int x1, int y1) {
+    return x1 < 0 || y1 < 0 || x0 >= VIS_WIDTH || y0 >= VIS_HEIGHT;
+}
+
+bool vis_dl_terrain(vis_dlist_t *dl, const vis_terrain_strip_t *strip, int frame, float audio_level) {
+    vis_dl_item_t *it = dl_push(dl, VIS_DL_TERRAIN);
+    if (!it) return false;
+    it->arg = frame;
+    it->f = audio_level;
+    it->ptr = strip;
+    dl_box(it, 0, 0, VIS_WIDTH - 1, VIS_HEIGHT - 1);
+    return true;
+}
+
+int vis_dl_text(vis_dlist_t *dl, const char *s, int n) {
+    if (n < 0) return -1;
+    if (dl->text_len + n > dl->text_cap) {
+        int cap = dl->text_cap ? dl->text_cap : 4096;
+        while (cap < dl->text_len + n) cap *= 2;
+        char *text = realloc(dl->text, (size_t)cap);
+        if (!text) return -1;
+        dl->text = text;
+        dl->text_cap = cap;
+    }
+    memcpy(dl->text + dl->text_len, s, (size_t)n);
+    dl->text_len += n;
+    return dl->text_len - n;
+}
+
+bool vis_dl_glyph_run(vis_dlist_t *dl, int x, int y, int text, int n, uint32_t color) {
+    // draw_ascii_run_asm: nothing (not even a dirty tile) off the rows or
+    // with no column of the run on screen
+    if (text < 0 || n <= 0 || y < 0 || y >= VIS_HEIGHT || x >= VIS_WIDTH || x + n * GLYPH_PX <= 0) {
+        dl->culled++;
+        return false;
+    }
+    vis_dl_item_t *it = dl_push(dl, VIS_DL_GLYPH_RUN);
+    if (!it) return false;
+    it->x = (int16_t)x;
+    it->y = (int16_t)y;
+    it->n = (uint16_t)n;
+    it->arg = text;
+    it->color = color;
+    dl_box(it, x, y, x + n * GLYPH_PX - 1, y + GLYPH_PX - 1);
+    return true;
+}
+
+bool vis_dl_glyph(vis_dlist_t *dl, int x, int y, char c, uint32_t color) {
+    // draw_ascii_char_asm draws only glyphs whose origin is on screen
+    if (x < 0 || x >= VIS_WIDTH || y < 0 || y >= VIS_HEIGHT || (signed char)c < 0) {
+        dl->culled++;
+        return false;
+    }
+    vis_dl_item_t *it = dl_push(dl, VIS_DL_GLYPH);
+    if (!it) return false;
+    it->x = (int16_t)x;
+    it->y = (int16_t)y;
+    it->c = c;
+    it->color = color;
+    dl_box(it, x, y, x + GLYPH_PX - 1, y + GLYPH_PX - 1);
+    return true;
+}
+
+// Cell origins of a size-`size` outline lie within size * sqrt(2) of the
+// centre (the square's corners), rounded; each cell is one glyph
+static void shape_box(int cx, int cy, int size, int box[4]) {
+    int r = (int)ceilf((float)size * 1.4143f) + 1;
+    box[0] = cx - r;
+    box[1] = cy - r;
+    box[2] = cx + r + GLYPH_PX - 1;
+    box[3] = cy + r + GLYPH_PX - 1;
+}
+
+bool vis_dl_shape(vis_dlist_t *dl, int cx, int cy, int shape, int size, float rotation, uint32_t color) {
+    int box[4];
+    shape_box(cx, cy, size, box);
+    if (off_raster(box[0], box[1], box[2], box[3])) {
+        dl->culled++;
+        return false;
+    }
+    vis_dl_item_t *it = dl_push(dl, VIS_DL_SHAPE);
+    if (!it) return false;
+    it->x = (int16_t)cx;
+    it->y = (int16_t)cy;
+    it->shape = (uint8_t)shape;
+    it->arg = size;
+    it->f = rotation;
+    it->color = color;
+    dl_box(it, box[0], box[1], box[2], box[3]);
+    return true;
+}
+
+bool vis_dl_sprite(vis_dlist_t *dl, const vis_boss_sprite_t *sp, int cx, int cy, uint32_t color) {
+    // A cached sprite's box holds every cell's glyph; a live one draws
+    // through the kernel
+    int box[4];
+    if (sp->live) {
+        shape_box(cx, cy, sp->size, box);
+    } else {
+        box[0] = cx + sp->x0;
+        box[1] = cy + sp->y0;
+        box[2] = box[0] + sp->w - 1;
+        box[3] = box[1] + sp->h - 1;
+    }
+    if ((!sp->live && sp->n == 0) || off_raster(box[0], box[1], box[2], box[3])) {
+        dl->culled++;
+        return false;
+    }
+    vis_dl_item_t *it = dl_push(dl, VIS_DL_SPRITE);
+    if (!it) return false;
+    it->x = (int16_t)cx;
+    it->y = (int16_t)cy;
+    it->ptr = sp;
+    it->color = color;
+    dl_box(it, box[0], box[1], box[2], box[3]);
+    return true;
+}
+
+bool vis_dl_bass_hits(vis_dlist_t *dl) {
+    vis_dl_item_t *it = dl_push(dl, VIS_DL_BASS_HITS);
+    if (!it) return false;
+    dl_box(it, 0, 0, VIS_WIDTH - 1, VIS_HEIGHT - 1);
+    return true;
+}
+
+#ifdef PROF_ENABLE
+// One profiler stage per record type, timed per batch of consecutive records
+static const char *const stage_names[VIS_DL_TYPES] = {
+    "dl_terrain", "dl_glyph_runs", "dl_glyphs", "dl_shapes", "dl_sprites", "dl_bass_hits"
+};
+static int stage_ids[VIS_DL_TYPES] = { -1, -1, -1, -1, -1, -1 };
+#endif
+
+static void draw_item(const vis_dlist_t *dl, const vis_dl_item_t *it, uint32_t *pixels) {
+    switch (it->type) {
+    case VIS_DL_TERRAIN:
+        if (it->ptr) vis_terrain_strip_draw(it->ptr, pixels, it->arg, it->f);
+        else draw_terrain_enhanced_asm(pixels, it->arg, it->f);
+        break;
+    case VIS_DL_GLYPH_RUN:
+        draw_ascii_run_asm(pixels, it->x, it->y, dl->text + it->arg, it->n, it->color);
+        break;
+    case VIS_DL_GLYPH:
+        draw_ascii_char_asm(pixels, it->x, it->y, it->c, it->color, 255);
+        break;
+    case VIS_DL_SHAPE:
+        vis_boss_shape_draw(pixels, it->x, it->y, it->shape, it->arg, it->f, it->color, dl->frame);
+        break;
+    case VIS_DL_SPRITE:
+        vis_boss_sprite_draw(it->ptr, pixels, it->x, it->y, it->color, dl->frame);
+        break;
+    case VIS_DL_BASS_HITS:
+        draw_bass_hits_asm(pixels, dl->frame);
+        break;
+    }
+}
+
+void vis_dl_draw(const vis_dlist_t *dl, uint32_t *pixels) {
+    for (int i = 0; i < dl->count; ) {
+        int type = dl->items[i].type;
+#ifdef PROF_ENABLE
+        uint64_t t0 = prof_ticks();
+#endif
+        for (; i < dl->count && dl->items[i].type == type; i++) draw_item(dl, &dl->items[i], pixels);
+#ifdef PROF_ENABLE
+        prof_record(prof_stage_cached(&stage_ids[type], stage_names[type]), t0, prof_ticks());
+#endif
+    }
+}
@@ -0,0 +1,270 @@
+#include "include/vis_glitch.h"
+#include <stdbool.h>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// glitch_config and glitch_initialized, as laid out in glitch_system.s
+extern uint8_t vis_glitch_state[];
+
+typedef struct {
+    float terrain_glitch_rate, shape_glitch_rate, digital_noise_rate, glitch_intensity;
+    uint32_t glitch_seed;
+    uint32_t initialized;
+} glitch_module_t;
+
+static const char terrain_glitch_chars[] = "#=-%*+~^|\\/<>[]{}()";
+static const char shape_glitch_chars[] = "@#*+=-|\\/<>^~`'\".:;!?";
+static const char digital_noise_chars[] = "01234567890123456789abcdefABCDEF!@#$%^&*";
+static const char matrix_chars[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ!@#$%^&*+-=";
+
+// get_glitch_random_asm(x, y, frame) is LCG((x * 73 + y * 37 + frame * 17) ^ seed);
+// `k` carries the y and frame terms
+#define LCG_MUL 1664525u
+#define LCG_ADD 1013904223u
+// r / 10000 == (r * DIV10K_MUL) >> 45 for every 32-bit r
+#define DIV10K_MUL 3518437209u
+
+typedef struct {
+    uint32_t seed;
+    uint32_t k_glyph, k_noise, k_cascade;   // (x, y, frame), (x, y, 3 * frame), (x / 8, 0, frame / 10)
+    uint32_t rate, noise_rate, cascade_chance;   // As remainder thresholds, see glitch_threshold
+} glitch_row_t;
+
+static inline uint32_t glitch_hash(uint32_t x, uint32_t k, uint32_t seed) {
+    return ((x * 73u + k) ^ seed) * LCG_MUL + LCG_ADD;
+}
+
+// The kernel's (r % 10000) / 10000.0f < rate
+static inline bool glitch_rate_hit(uint32_t rem, float rate) {
+    return (float)(int)rem / 10000.0f < rate;
+}
+
+// The quotient only grows with the remainder, so the kernel's test is
+// r % 10000 < t for the first remainder t that misses; found once per row,
+// it turns the per-cell float divide and compare into an integer compare
+static uint32_t glitch_threshold(float rate) {
+    if (!(rate > 0.0f)) return 0;
+    if (rate > 1.0f) return 10000;
+    // Within a step or two of rate * 10000
+    uint32_t t = (uint32_t)(rate * 10000.0f);
+    while (t > 0 && !glitch_rate_hit(t - 1, rate)) t--;
+    while (t < 10000 && glitch_rate_hit(t, rate)) t++;
+    return t;
+}
+
+static inline bool glitch_hit(uint32_t r, uint32_t threshold) {
+    return r % 10000u < threshold;
+}
+
+// Hashes of four cells at x[0..3], and their hits as bits 0-3
+typedef struct {
+    uint32_t r[4], noise_r[4];
+    unsigned hit, noise_hit, cascade_hit;
+} glitch_block_t;
+
+#if defined(__ARM_NEON)
+static inline uint32x4_t glitch_hash_neon(uint32x4_t x, uint32_t k, uint32_t seed) {
+    uint32x4_t h = veorq_u32(vmlaq_n_u32(vdupq_n_u32(k), x, 73u), vdupq_n_u32(seed));
+    return vmlaq_n_u32(vdupq_n_u32(LCG_ADD), h, LCG_MUL);
+}
+
+static inline unsigned glitch_hit_neon(uint32x4_t r, uint32_t threshold) {
+    const uint32_t bit[4] = { 1, 2, 4, 8 };
+    uint64x2_t lo = vmull_n_u32(vget_low_u32(r), DIV10K_MUL), hi = vmull_high_n_u32(r, DIV10K_MUL);
+    uint32x4_t q = vshrq_n_u32(vcombine_u32(vshrn_n_u64(lo, 32), vshrn_n_u64(hi, 32)), 13);
+    uint32x4_t rem = vmlsq_n_u32(r, q, 10000u);
+    return vaddvq_u32(vandq_u32(vcltq_u32(rem, vdupq_n_u32(threshold)), vld1q_u32(bit)));
+}
+
+static void glitch_block(const glitch_row_t *g, bool terrain, uint32_t x0, uint32_t dx, glitch_block_t *b) {
+    const uint32_t lane[4] = { 0, 1, 2, 3 };
+    uint32x4_t x = vmlaq_n_u32(vdupq_n_u32(x0), vld1q_u32(lane), dx);
+    uint32x4_t r = glitch_hash_neon(x, g->k_glyph, g->seed);
+    vst1q_u32(b->r, r);
+    b->hit = glitch_hit_neon(r, g->rate);
+    if (!terrain) return;
+    uint32x4_t nr = glitch_hash_neon(x, g->k_noise, g->seed);
+    vst1q_u32(b->noise_r, nr);
+    b->noise_hit = glitch_hit_neon(nr, g->noise_rate);
+    b->cascade_hit = glitch_hit_neon(glitch_hash_neon(vshrq_n_u32(x, 3), g->k_cascade, g->seed), g->cascade_chance);
+}
+#elif defined(__SSE2__)
+// 32-bit lane products (pmulld is SSE4.1): even and odd lanes through pmuludq
+static inline __m128i mullo32_sse2(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// `x73` is x * 73 per lane
+static inline __m128i glitch_hash_sse2(__m128i x73, uint32_t k, uint32_t seed) {
+    __m128i h = _mm_xor_si128(_mm_add_epi32(x73, _mm_set1_epi32((int)k)), _mm_set1_epi32((int)seed));
+    return _mm_add_epi32(mullo32_sse2(h, _mm_set1_epi32((int)LCG_MUL)), _mm_set1_epi32((int)LCG_ADD));
+}
+
+// Remainders in the 64-bit halves, even and odd lanes apart; only their low
+// words (below 2^14, so the signed compare will do) are tested
+static inline unsigned glitch_hit_sse2(__m128i r, uint32_t threshold) {
+    const __m128i m = _mm_set1_epi32((int)DIV10K_MUL), d = _mm_set1_epi32(10000);
+    const __m128i t = _mm_set1_epi32((int)threshold);
+    __m128i r_odd = _mm_srli_epi64(r, 32);
+    __m128i rem_even = _mm_sub_epi32(r, _mm_mul_epu32(_mm_srli_epi64(_mm_mul_epu32(r, m), 45), d));
+    __m128i rem_odd = _mm_sub_epi32(r_odd, _mm_mul_epu32(_mm_srli_epi64(_mm_mul_epu32(r_odd, m), 45), d));
+    unsigned even = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(rem_even, t))) & 5;
+    unsigned odd = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(rem_odd, t))) & 5;
+    return even | odd << 1;
+}
+
+static void glitch_block(const glitch_row_t *g, bool terrain, uint32_t x0, uint32_t dx, glitch_block_t *b) {
+    // x * 73 steps by dx * 73 a lane
+    uint32_t s = dx * 73u;
+    __m128i x73 = _mm_add_epi32(_mm_set1_epi32((int)(x0 * 73u)), _mm_setr_epi32(0, (int)s, (int)(2 * s), (int)(3 * s)));
+    __m128i r = glitch_hash_sse2(x73, g->k_glyph, g->seed);
+    _mm_storeu_si128((__m128i *)b->r, r);
+    b->hit = glitch_hit_sse2(r, g->rate);
+    if (!terrain) return;
+    __m128i nr = glitch_hash_sse2(x73, g->k_noise, g->seed);
+    _mm_storeu_si128((__m128i *)b->noise_r, nr);
+    b->noise_hit = glitch_hit_sse2(nr, g->noise_rate);
+    __m128i x = _mm_setr_epi32((int)x0, (int)(x0 + dx), (int)(x0 + 2 * dx), (int)(x0 + 3 * dx));
+    __m128i c73 = mullo32_sse2(_mm_srli_epi32(x, 3), _mm_set1_epi32(73));
+    b->cascade_hit = glitch_hit_sse2(glitch_hash_sse2(c73, g->k_cascade, g->seed), g->cascade_chance);
+}
+#else
+static void glitch_block(const glitch_row_t *g, bool terrain, uint32_t x0, uint32_t dx, glitch_block_t *b) {
+    for (int l = 0; l < 4; l++) {
+        uint32_t x = x0 + (uint32_t)l * dx;
+        b->r[l] = glitch_hash(x, g->k_glyph, g->seed);
+        b->hit |= (unsigned)glitch_hit(b->r[l], g->rate) << l;
+        if (!terrain) continue;
+        b->noise_r[l] = glitch_hash(x, g->k_noise, g->seed);
+        b->noise_hit |= (unsigned)glitch_hit(b->noise_r[l], g->noise_rate) << l;
+        b->cascade_hit |= (unsigned)glitch_hit(glitch_hash(x >> 3, g->k_cascade, g->seed), g->cascade_chance) << l;
+    }
+}
+#endif
+
+// One cell from its hashes; only hits index a glyph table
+static inline uint8_t glitch_resolve(bool terrain, char c, uint32_t r, bool hit, uint32_t noise_r, bool noise_hit,
+                                     bool cascade_hit, char *out) {
+    if (c == 0) {
+        *out = 0;
+        return VIS_GLITCH_KEEP;
+    }
+    if (c == ' ') {
+        if (terrain && noise_hit) {
+            *out = digital_noise_chars[(noise_r >> 8) % 39];
+            return VIS_GLITCH_NOISE;
+        }
+        *out = ' ';
+        return VIS_GLITCH_KEEP;
+    }
+    if (terrain && cascade_hit) {
+        *out = matrix_chars[(r >> 8) % 45];
+        return VIS_GLITCH_CASCADE;
+    }
+    if (hit) {
+        *out = terrain ? terrain_glitch_chars[(r >> 8) % 19] : shape_glitch_chars[(r >> 8) % 21];
+        return VIS_GLITCH_SUBST;
+    }
+    *out = c;
+    return VIS_GLITCH_KEEP;
+}
+
+// Hash keys and thresholds of row y, from the live config
+static glitch_row_t glitch_row_init(const glitch_module_t *m, bool terrain, int y, int frame) {
+    uint32_t f = (uint32_t)frame, yk = (uint32_t)y * 37u;
+    return (glitch_row_t){
+        .seed = m->glitch_seed,
+        .k_glyph = yk + f * 17u,
+        .k_noise = yk + f * 3u * 17u,
+        .k_cascade = f / 10u * 17u,
+        .rate = glitch_threshold(terrain ? m->terrain_glitch_rate : m->shape_glitch_rate),
+        .noise_rate = terrain ? glitch_threshold(m->digital_noise_rate) : 0,
+        .cascade_chance = terrain ? glitch_threshold(0.02f * m->glitch_intensity) : 0,
+    };
+}
+
+// One cell at x, hashed one test at a time
+static uint8_t glitch_cell(const glitch_row_t *g, bool terrain, char c, uint32_t x, char *out) {
+    uint32_t r = glitch_hash(x, g->k_glyph, g->seed), noise_r = glitch_hash(x, g->k_noise, g->seed);
+    bool cascade_hit = terrain && glitch_hit(glitch_hash(x >> 3, g->k_cascade, g->seed), g->cascade_chance);
+    return glitch_resolve(terrain, c, r, glitch_hit(r, g->rate), noise_r,
+                          terrain && glitch_hit(noise_r, g->noise_rate), cascade_hit, out);
+}
+
+int vis_glitch_row(vis_glitch_set_t set, const char *chars, int n, int x0, int dx, int y, int frame,
+                   uint8_t *mask, char *out) {
+    const glitch_module_t *m = (const glitch_module_t *)vis_glitch_state;
+    if (!m->initialized) {
+        for (int i = 0; i < n; i++) {
+            out[i] = chars[i];
+            mask[i] = VIS_GLITCH_KEEP;
+        }
+        return 0;
+    }
+
+    bool terrain = set == VIS_GLITCH_TERRAIN;
+    glitch_row_t g = glitch_row_init(m, terrain, y, frame);
+
+    // Cells that miss every test keep their glyph; only the hits are resolved
+    for (int i = 0; i < n; i++) {
+        out[i] = chars[i];
+        mask[i] = VIS_GLITCH_KEEP;
+    }
+    int changed = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        glitch_block_t b = {0};
+        glitch_block(&g, terrain, (uint32_t)x0 + (uint32_t)i * (uint32_t)dx, (uint32_t)dx, &b);
+        for (unsigned any = b.hit | b.noise_hit | b.cascade_hit; any; any &= any - 1) {
+            int l = __builtin_ctz(any);
+            mask[i + l] = glitch_resolve(terrain, chars[i + l], b.r[l], b.hit >> l & 1, b.noise_r[l],
+                                         b.noise_hit >> l & 1, b.cascade_hit >> l & 1, &out[i + l]);
+            changed += mask[i + l] != VIS_GLITCH_KEEP;
+        }
+    }
+    for (; i < n; i++) {
+        mask[i] = glitch_cell(&g, terrain, chars[i], (uint32_t)x0 + (uint32_t)i * (uint32_t)dx, &out[i]);
+        changed += mask[i] != VIS_GLITCH_KEEP;
+    }
+    return changed;
+}
+
+int vis_glitch_cells(vis_glitch_set_t set, const char *chars, const int *x, const int *y, int n, int frame,
+                     uint8_t *mask, char *out) {
+    const glitch_module_t *m = (const glitch_module_t *)vis_glitch_state;
+    if (!m->initialized) {
+        for (int i = 0; i < n; i++) {
+            out[i] = chars[i];
+            mask[i] = VIS_GLITCH_KEEP;
+        }
+        return 0;
+    }
+
+    bool terrain = set == VIS_GLITCH_TERRAIN;
+    glitch_row_t g = glitch_row_init(m, terrain, 0, frame);
+    uint32_t k_glyph = g.k_glyph, k_noise = g.k_noise;
+    int changed = 0;
+    for (int i = 0; i < n; i++) {
+        g.k_glyph = k_glyph + (uint32_t)y[i] * 37u;
+        g.k_noise = k_noise + (uint32_t)y[i] * 37u;
+        mask[i] = glitch_cell(&g, terrain, chars[i], (uint32_t)x[i], &out[i]);
+        changed += mask[i] != VIS_GLITCH_KEEP;
+    }
+    return changed;
+}
+
+uint32_t vis_glitch_hold(void) {
+    glitch_module_t *m = (glitch_module_t *)vis_glitch_state;
+    uint32_t state = m->initialized;
+    m->initialized = 0;
+    return state;
+}
+
+void vis_glitch_restore(uint32_t state) {
+    ((glitch_module_t *)vis_glitch_state)->initialized = state;
+}
@@ -2,58 +2,52 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
-#include <time.h>
-#include <math.h>
+#include <string.h>
 #include "include/visual_types.h"
+#include "include/vis_color.h"
+#include "include/vis_ctx.h"
+#include "include/frame_writer.h"
+#include "include/generate_frames.h"
+#include "seed.h"
 
-// Forward declarations for ASM visual functions
-extern void clear_frame_asm(uint32_t *pixels, uint32_t color);
-extern void init_terrain_asm(uint32_t seed, float base_hue);
-extern void draw_terrain_asm(uint32_t *pixels, int frame);
-extern void init_particles_asm(void);
-extern void update_particles_asm(float elapsed_ms, float step_sec, float base_hue);
-extern void draw_particles_asm(uint32_t *pixels);
-extern void init_glitch_system_asm(uint32_t seed, float intensity);
-extern void update_glitch_intensity_asm(float new_intensity);
-extern void init_bass_hits_asm(void);
-extern void spawn_bass_hit_asm(float cx, float cy, int shape_type, float base_hue);
-extern void draw_bass_hits_asm(uint32_t *pixels, int frame);
-extern uint32_t circle_color_asm(float hue, float saturation, float value);
-extern void draw_circle_filled_asm(uint32_t *pixels, int cx, int cy, int radius, uint32_t color);
-extern void draw_ascii_string_asm(uint32_t *pixels, int x, int y, const char *text, uint32_t color, int bg_alpha);
-
-// C functions that remain (system interface)
-void draw_centerpiece(uint32_t *pixels, centerpiece_t *centerpiece, float time, float level, int frame);
-void init_centerpiece(centerpiece_t *centerpiece, uint32_t seed, int bpm);
-void init_degradation_effects(degradation_t *effects, uint32_t seed);
+// Realtime viewer: the frames generate_frames renders for a track and seed,
+// drawn by the same core (frames_core_render) in a window while the track
+// plays.  The visual clock follows the audio device, and frames the window
+// falls behind on only step the render state, so what is on screen is
+// always the frame a file render would have at that point.
+
+// Audio analysis (simple_wav_reader.c, audio_visual_bridge.c)
 bool load_wav_file(const char *filename);
-float get_audio_rms_for_frame(int frame);
-float get_audio_bpm(void);
-float get_max_rms(void);
-bool is_audio_finished(int frame);
+const int16_t *get_audio_samples(uint32_t *frames, uint32_t *sample_rate, int *channels);
+float get_audio_duration(void);
 void print_audio_info(void);
 void cleanup_audio_data(void);
-void start_audio_playback(void);
-void stop_audio_playback(void);
-
-// Audio-visual mapping functions
 void init_audio_visual_mapping(void);
-float get_smoothed_audio_level(int frame);
-bool detect_beat_onset(int frame);
-float get_bass_energy(int frame);
-float get_treble_energy(int frame);
-void update_audio_visual_effects(int frame, float base_hue);
-float get_audio_driven_glitch_intensity(int frame);
-float get_audio_driven_hue_shift(int frame);
 
-#define FRAME_TIME_MS (1000 / VIS_FPS)
+extern uint32_t *vis_dirty_tiles; // frame_tiles_t rows of the frame being drawn
 
 typedef struct {
     SDL_Window *window;
     SDL_Renderer *renderer;
     SDL_Texture *texture;
-    visual_context_t visual;
+    SDL_AudioDeviceID audio;
+    uint32_t *pixels;
+    frame_tiles_t tiles;          // Dirty tiles of `pixels` since the last clear
     bool running;
+
+    vis_ctx_t vis;
+    bool have_vis;
+    timeline_t tl;
+    bool have_timeline;
+    timeline_signals_t sig;
+    frames_core_t core;
+    vis_triggers_t triggers;
+
+    int total_frames;
+    int next_frame;               // First frame whose state hasn't been stepped yet
+    uint64_t audio_bytes;         // Queued at start, for the playback position
+    uint32_t sample_rate, frame_bytes;
+    uint32_t start_ticks;         // Clock when there is no audio device
 } VisualContext;
 
 static VisualContext ctx = {0};
@@ -71,7 +65,7 @@ static bool init_sdl(void) {
         VIS_WIDTH, VIS_HEIGHT,
         SDL_WINDOW_SHOWN
     );
-    
+
     if (!ctx.window) {
         fprintf(stderr, "SDL_CreateWindow failed: %s\n", SDL_GetError());
         return false;
@@ -83,72 +77,101 @@ static bool init_sdl(void) {
         return false;
     }
 
+    // The frame buffer is ARGB with alpha 0 on the background: copy, don't blend
     ctx.texture = SDL_CreateTexture(
         ctx.renderer,
         SDL_PIXELFORMAT_ARGB8888,
         SDL_TEXTUREACCESS_STREAMING,
         VIS_WIDTH, VIS_HEIGHT
     );
-    
+
     if (!ctx.texture) {
         fprintf(stderr, "SDL_CreateTexture failed: %s\n", SDL_GetError());
         return false;
     }
+    SDL_SetTextureBlendMode(ctx.texture, SDL_BLENDMODE_NONE);
 
-    ctx.visual.pixels = calloc(VIS_WIDTH * VIS_HEIGHT, sizeof(uint32_t));
-    if (!ctx.visual.pixels) {
+    ctx.pixels = calloc(VIS_WIDTH * VIS_HEIGHT, sizeof(uint32_t));
+    if (!ctx.pixels) {
         fprintf(stderr, "Failed to allocate pixel buffer\n");
         return false;
     }
+    memset(&ctx.tiles, 0, sizeof(ctx.tiles));   // calloc'd: every tile is black
+    return true;
+}
+
+// Queue the whole track on the default device; without one the visuals run
+// on the wall clock
+static void start_playback(void) {
+    uint32_t frames, rate;
+    int channels;
+    const int16_t *pcm = get_audio_samples(&frames, &rate, &channels);
+    ctx.sample_rate = rate;
+    ctx.frame_bytes = (uint32_t)channels * sizeof(int16_t);
+
+    SDL_AudioSpec want = {0}, have;
+    want.freq = (int)rate;
+    want.format = AUDIO_S16SYS;
+    want.channels = (Uint8)channels;
+    want.samples = 1024;
+    ctx.audio = pcm && rate ? SDL_OpenAudioDevice(NULL, 0, &want, &have, 0) : 0;
+    if (ctx.audio) {
+        ctx.audio_bytes = (uint64_t)frames * ctx.frame_bytes;
+        if (SDL_QueueAudio(ctx.audio, pcm, (Uint32)ctx.audio_bytes) < 0) {
+            fprintf(stderr, "SDL_QueueAudio failed: %s\n", SDL_GetError());
+            SDL_CloseAudioDevice(ctx.audio);
+            ctx.audio = 0;
+        }
+    }
+    if (!ctx.audio) printf("No audio playback, visuals follow the wall clock\n");
+    ctx.start_ticks = SDL_GetTicks();
+    if (ctx.audio) SDL_PauseAudioDevice(ctx.audio, 0);
+}
 
-    // Load and analyze audio file
-    const char *wav_file = "src/c/seed_0xcafebabe.wav";
-    if (!load_wav_file(wav_file)) {
-        printf("Failed to load audio file: %s\n", wav_file);
-        printf("Falling back to test mode\n");
-        // Fallback to test parameters
-        ctx.visual.bpm = 120;
-    } else {
-        printf("Successfully loaded audio file!\n");
-        print_audio_info();
-        ctx.visual.bpm = (int)get_audio_bpm();
+// Frame the track is at now
+static int playback_frame(void) {
+    if (ctx.audio) {
+        uint64_t played = ctx.audio_bytes - SDL_GetQueuedAudioSize(ctx.audio);
+        return (int)(played / ctx.frame_bytes * VIS_FPS / ctx.sample_rate);
     }
-    
-    // Initialize visual system with real audio parameters
-    ctx.visual.seed = 0xcafebabe;  // Match the WAV file seed
-    ctx.visual.frame = 0;
-    ctx.visual.time = 0.0f;
-    ctx.visual.step_sec = 60.0f / ctx.visual.bpm / 4.0f;  // 16th note duration
-    
-    init_centerpiece(&ctx.visual.centerpiece, ctx.visual.seed, ctx.visual.bpm);
-    init_degradation_effects(&ctx.visual.effects, ctx.visual.seed);
-    
-    // Initialize ASM terrain system
-    init_terrain_asm(ctx.visual.seed, ctx.visual.centerpiece.base_hue);
-    
-    // Initialize ASM particle system
-    init_particles_asm();
-    
-    // Initialize ASM glitch system with medium intensity
-    init_glitch_system_asm(ctx.visual.seed, 0.6f);
-    
-    // Initialize ASM bass hit system
-    init_bass_hits_asm();
-    
-    // Initialize audio-visual mapping
+    return (int)((uint64_t)(SDL_GetTicks() - ctx.start_ticks) * VIS_FPS / 1000);
+}
+
+// Render context and signals for `seed`, as generate_frames sets them up
+static bool init_render(const char *wav_path, uint32_t seed) {
     init_audio_visual_mapping();
-    
-    // Start audio playback
-    start_audio_playback();
+    if (!vis_ctx_init(&ctx.vis, seed)) {
+        fprintf(stderr, "Failed to allocate the render context\n");
+        return false;
+    }
+    ctx.have_vis = true;
+    vis_ctx_bind(&ctx.vis);
+    ctx.vis.budget_policy.mode = VIS_BUDGET_ADAPTIVE;
+    ctx.vis.budget_policy.target_ms = 1000.0f / VIS_FPS;
 
-    ctx.running = true;
+    char sidecar_path[512];
+    ctx.have_timeline = frames_core_load_timeline(wav_path, &ctx.tl, sidecar_path, sizeof(sidecar_path));
+    if (ctx.have_timeline) printf("Using timeline sidecar: %s\n", sidecar_path);
+    else printf("No timeline sidecar found (%s), using WAV analysis\n", sidecar_path);
+    frames_core_init_scene(&ctx.vis, seed);
+
+    ctx.total_frames = (int)(get_audio_duration() * VIS_FPS);
+    bool have_signals = ctx.have_timeline &&
+                        timeline_signals_build(&ctx.tl, ctx.total_frames, VIS_FPS, &ctx.sig);
+    const timeline_t *tl = ctx.have_timeline ? &ctx.tl : NULL;
+    ctx.core = (frames_core_t){ &ctx.vis, have_signals ? &ctx.sig : NULL, tl,
+                                60.0f / frames_core_bpm(tl) / 4.0f, seed, NULL };
+    frames_core_bind_triggers(&ctx.core, &ctx.triggers);
     return true;
 }
 
-static void cleanup_sdl(void) {
-    stop_audio_playback();
+static void cleanup(void) {
+    if (ctx.audio) SDL_CloseAudioDevice(ctx.audio);
     cleanup_audio_data();
-    if (ctx.visual.pixels) free(ctx.visual.pixels);
+    timeline_signals_free(&ctx.sig);
+    if (ctx.have_timeline) timeline_free(&ctx.tl);
+    if (ctx.have_vis) vis_ctx_free(&ctx.vis);
+    if (ctx.pixels) free(ctx.pixels);
     if (ctx.texture) SDL_DestroyTexture(ctx.texture);
     if (ctx.renderer) SDL_DestroyRenderer(ctx.renderer);
     if (ctx.window) SDL_DestroyWindow(ctx.window);
@@ -171,128 +194,78 @@ static void handle_events(void) {
     }
 }
 
+// Catch up to the playback position and draw the frame there
 static void render_frame(void) {
-    // Clear to black using ASM
-    clear_frame_asm(ctx.visual.pixels, 0xFF000000);
-    
-    // Update time and frame
-    ctx.visual.time = ctx.visual.frame / (float)VIS_FPS;
-    
-    // Get enhanced audio analysis
-    float audio_level = get_smoothed_audio_level(ctx.visual.frame);
-    float bass_energy = get_bass_energy(ctx.visual.frame);
-    float treble_energy = get_treble_energy(ctx.visual.frame);
-    
-    // Update dynamic base hue based on audio
-    ctx.visual.centerpiece.base_hue = get_audio_driven_hue_shift(ctx.visual.frame);
-    
-    // Calculate elapsed time in segment (for particle timing) with looping
-    float segment_duration_ms = 9220.0f; // ~9.22 seconds from our audio
-    float elapsed_ms = fmod(ctx.visual.time * 1000.0f, segment_duration_ms);
-    
-    // Update particles using ASM (handles explosions and physics)
-    update_particles_asm(elapsed_ms, ctx.visual.step_sec, ctx.visual.centerpiece.base_hue);
-    
-    // Audio-reactive effects (particle explosions, bass hits)
-    update_audio_visual_effects(ctx.visual.frame, ctx.visual.centerpiece.base_hue);
-    
-    // Update glitch intensity based on audio characteristics
-    float glitch_intensity = get_audio_driven_glitch_intensity(ctx.visual.frame);
-    update_glitch_intensity_asm(glitch_intensity);
-    
-    // Draw orbiting centerpiece (C function with some ASM calls)
-    draw_centerpiece(ctx.visual.pixels, &ctx.visual.centerpiece, ctx.visual.time, audio_level, ctx.visual.frame);
-    
-    // 🚀 CHAOS MODE RENDERING - Multiple layers with audio-reactive speed!
-    float chaos_level = get_smoothed_audio_level(ctx.visual.frame);
-    
-    // 🔯 MULTI-LAYER BASS HITS - Draw multiple times for intensity!
-    for (int layer = 0; layer < (int)(chaos_level * 3) + 1; layer++) {
-        draw_bass_hits_asm(ctx.visual.pixels, ctx.visual.frame + layer * 5);
-    }
-    
-    // 🏔️ HYPER-SPEED TERRAIN - Speed varies with audio!
-    int terrain_speed = (int)(1 + chaos_level * 8); // 1x to 9x speed
-    draw_terrain_asm(ctx.visual.pixels, ctx.visual.frame * terrain_speed);
-    
-    // 💥 PARTICLE STORM - Draw multiple times for particle density!
-    for (int burst = 0; burst < (int)(chaos_level * 4) + 1; burst++) {
-        draw_particles_asm(ctx.visual.pixels);
+    int frame = playback_frame();
+    if (frame >= ctx.total_frames) {
+        ctx.running = false;
+        return;
     }
-    
-    // TODO: Add other visual elements
-    // - Audio-reactive elements
-    // - Post-processing effects
-    
-    // Update texture with pixel buffer
-    SDL_UpdateTexture(ctx.texture, NULL, ctx.visual.pixels, VIS_WIDTH * sizeof(uint32_t));
-    
-    // Render to screen
+    if (frame < ctx.next_frame) return;   // Still on the frame already shown
+
+    // Frames we fell behind on only step the state
+    while (ctx.next_frame < frame) frames_core_advance(&ctx.core, ctx.next_frame++);
+
+    frame_tiles_clear(&ctx.tiles, ctx.pixels, VIS_WIDTH, VIS_HEIGHT);
+    vis_dirty_tiles = ctx.tiles.rows;
+    uint64_t t0 = SDL_GetPerformanceCounter();
+    frames_core_render(&ctx.core, ctx.pixels, frame);
+    workload_budget_feedback(&ctx.vis, (double)(SDL_GetPerformanceCounter() - t0) * 1e3 /
+                                       (double)SDL_GetPerformanceFrequency());
+    ctx.next_frame = frame + 1;
+
+    SDL_UpdateTexture(ctx.texture, NULL, ctx.pixels, VIS_WIDTH * sizeof(uint32_t));
     SDL_RenderClear(ctx.renderer);
     SDL_RenderCopy(ctx.renderer, ctx.texture, NULL, NULL);
     SDL_RenderPresent(ctx.renderer);
-    
-    ctx.visual.frame++;
 }
 
 static void main_loop(void) {
-    uint32_t frame_start;
-    uint32_t frame_time;
-    
     while (ctx.running) {
-        frame_start = SDL_GetTicks();
-        
         handle_events();
-        
-        // TODO: Get audio timing and sync visuals
-        // unsigned int audio_time = get_audio_time_ms();
-        // float rms = get_rms_level(frame_idx);
-        
         render_frame();
-        
-        // Frame rate limiting
-        frame_time = SDL_GetTicks() - frame_start;
-        if (frame_time < FRAME_TIME_MS) {
-            SDL_Delay(FRAME_TIME_MS - frame_time);
-        }
+
+        // Sleep until the next frame is due
+        int ahead = ctx.next_frame - playback_frame();
+        if (ahead > 0) SDL_Delay((Uint32)(ahead * 1000 / VIS_FPS));
     }
 }
 
 int main(int argc, char *argv[]) {
-    printf("🌋 NUCLEAR CHAOS MODE VISUAL SYSTEM 💥\n");
-    printf("Resolution: %dx%d @ %d FPS\n", VIS_WIDTH, VIS_HEIGHT, VIS_FPS);
-    
-    // Check for audio file argument
-    if (argc < 2) {
-        printf("Usage: %s <audio_file.wav>\n", argv[0]);
+    printf("NotDeafBeef realtime visual: %dx%d @ %d FPS\n", VIS_WIDTH, VIS_HEIGHT, VIS_FPS);
+
+    if (argc < 2 || argc > 3) {
+        printf("Usage: %s <audio_file.wav> [seed]\n", argv[0]);
+        printf("  Draws the frames generate_frames renders for the same audio and seed\n");
+        printf("  (default seed 0xCAFEBABE), using <audio>.tl or <audio>.json when present\n");
+        return 1;
+    }
+
+    // Seed argument: the transaction hash, folded to the 32-bit visual seed
+    ndb_seed_t seed;
+    ndb_seed_from_u64(0xCAFEBABE, &seed);
+    if (argc == 3 && ndb_seed_parse(argv[2], &seed) != 0) {
+        fprintf(stderr, "Bad seed: %s\n", argv[2]);
         return 1;
     }
-    
-    // Load audio file for visual analysis
+
     if (!load_wav_file(argv[1])) {
-        printf("Error: Could not load audio file: %s\n", argv[1]);
+        fprintf(stderr, "Error: Could not load audio file: %s\n", argv[1]);
         return 1;
     }
-    
-    printf("Successfully loaded audio file!\n");
     print_audio_info();
-    
-    if (!init_sdl()) {
-        cleanup_sdl();
+
+    if (!init_sdl() || !init_render(argv[1], seed.visual)) {
+        cleanup();
         return 1;
     }
-    
-    printf("SDL2 initialized successfully\n");
-    printf("🔥 CHAOS MODE ACTIVE - PREPARE FOR MADNESS! 🔥\n");
-    printf("Press ESC to exit\n");
-    
-    // Initialize audio-visual mapping
-    init_audio_visual_mapping();
-    
+
+    printf("Seed 0x%08X, %d frames; press ESC to exit\n", seed.visual, ctx.total_frames);
+    ctx.running = true;
+    start_playback();
     main_loop();
-    
-    cleanup_sdl();
-    cleanup_audio_data();
+
+    cleanup();
     printf("Visual system shutdown complete\n");
     return 0;
 }
@@ -0,0 +1,140 @@
+#include "include/vis_terrain.h"
+#include "include/vis_color.h"
+#include "include/vis_glitch.h"
+#include "include/visual_types.h"
+#include <math.h>
+#include <string.h>
+
+extern void draw_ascii_char_asm(uint32_t *pixels, int x, int y, char c, uint32_t color, int bg_alpha);
+
+// Module state block (src/vis_ctx.c), laid out as in terrain.s
+extern uint8_t vis_terrain_state[];
+
+enum { TERRAIN_FLAT, TERRAIN_WALL, TERRAIN_SLOPE_UP, TERRAIN_SLOPE_DOWN, TERRAIN_GAP };
+
+#define TILE_SIZE   32
+#define CHAR_W      8
+#define CHAR_H      12
+#define SCROLL_SPEED 2
+#define WINDOW_COLS (((VIS_WIDTH / TILE_SIZE) + 2) * VIS_TERRAIN_TILE_COLS)
+
+typedef struct {
+    struct { int32_t type, height; } pattern[VIS_TERRAIN_TILES];
+    char tile_flat[TILE_SIZE * TILE_SIZE];
+    char tile_slope_up[TILE_SIZE * TILE_SIZE];
+    char tile_slope_down[TILE_SIZE * TILE_SIZE];
+    float base_hue;
+    float audio_level;
+    uint8_t initialized;
+} terrain_module_t;
+
+void vis_terrain_strip_init(vis_terrain_strip_t *s) {
+    const terrain_module_t *t = (const terrain_module_t *)vis_terrain_state;
+    memset(s, 0, sizeof(*s));
+    if (!t->initialized) return;
+
+    for (int i = 0; i < VIS_TERRAIN_TILES; i++) {
+        int type = t->pattern[i].type, height = t->pattern[i].height;
+        if (type == TERRAIN_GAP || height < 0) height = 0;
+        if (height > VIS_TERRAIN_MAX_ROWS) height = VIS_TERRAIN_MAX_ROWS;
+        for (int px = 0; px < VIS_TERRAIN_TILE_COLS; px++) {
+            vis_terrain_column_t *col = &s->cols[i * VIS_TERRAIN_TILE_COLS + px];
+            col->type = (uint8_t)type;
+            col->height = (uint8_t)height;
+            for (int row = 0; row < height; row++) {
+                // The top row of a slope tile takes the slope pattern
+                const char *pattern = t->tile_flat;
+                if (row == t->pattern[i].height - 1) {
+                    if (type == TERRAIN_SLOPE_UP) pattern = t->tile_slope_up;
+                    else if (type == TERRAIN_SLOPE_DOWN) pattern = t->tile_slope_down;
+                }
+                // The kernel reads glyph (tx / 8, ty / 12) at pattern_y * 4 + pattern_x
+                for (int py = 0; py < VIS_TERRAIN_CELL_ROWS; py++)
+                    col->glyph[row][py] = pattern[py * VIS_TERRAIN_TILE_COLS + px];
+            }
+        }
+    }
+    s->base_hue = t->base_hue;
+    s->ready = true;
+}
+
+void vis_terrain_strip_draw(const vis_terrain_strip_t *s, uint32_t *pixels, int frame, float audio_level) {
+    terrain_module_t *t = (terrain_module_t *)vis_terrain_state;
+    t->audio_level = audio_level;
+    if (!s->ready) return;
+
+    uint32_t f = (uint32_t)frame;
+    int offset = (int)((f * SCROLL_SPEED) & (TILE_SIZE - 1));
+    uint32_t first = (f * SCROLL_SPEED) / TILE_SIZE * VIS_TERRAIN_TILE_COLS;
+
+    // This frame's colours, as get_dynamic_terrain_color: flat by screen
+    // column, slope down by glyph row, then wall, slope up and gap
+    enum { SLOT_DOWN = WINDOW_COLS, SLOT_WALL = SLOT_DOWN + VIS_TERRAIN_MAX_ROWS * VIS_TERRAIN_CELL_ROWS,
+           SLOT_UP, SLOT_GAP, SLOTS };
+    float hue[SLOTS], sat[SLOTS], val[SLOTS];
+    uint32_t color[SLOTS];
+    float b = s->base_hue;
+    for (int k = 0; k < WINDOW_COLS; k++)
+        hue[k] = b + (float)(k * CHAR_W - offset) / (float)VIS_WIDTH * 0.2f;
+    for (int row = 0; row < VIS_TERRAIN_MAX_ROWS; row++)
+        for (int py = 0; py < VIS_TERRAIN_CELL_ROWS; py++) {
+            int y = VIS_HEIGHT - (row + 1) * TILE_SIZE + py * CHAR_H;
+            hue[SLOT_DOWN + row * VIS_TERRAIN_CELL_ROWS + py] = b + 0.8f + (float)y / (float)VIS_HEIGHT * 0.15f;
+        }
+    hue[SLOT_WALL] = b + 0.6f + audio_level * 0.1f;
+    hue[SLOT_UP] = b + 0.3f + (float)frame / 1000.0f * 0.1f;
+    hue[SLOT_GAP] = b + 0.5f;
+    float sv = fminf(0.9f + audio_level * 0.1f, 1.0f), vv = fminf(0.8f + audio_level * 0.2f, 1.0f);
+    for (int i = 0; i < SLOTS; i++) {
+        hue[i] -= floorf(hue[i]);
+        sat[i] = sv;
+        val[i] = vv;
+    }
+    vis_hsv_pixels(hue, sat, val, color, SLOTS);
+
+    // Columns fully on screen, x = k * CHAR_W - offset in [0, VIS_WIDTH - CHAR_W)
+    int k0 = (offset + CHAR_W - 1) / CHAR_W;
+    int k1 = (VIS_WIDTH - CHAR_W + offset + CHAR_W - 1) / CHAR_W;
+    if (k1 > WINDOW_COLS) k1 = WINDOW_COLS;
+    int n = k1 - k0, x0 = k0 * CHAR_W - offset;
+    const vis_terrain_column_t *cols[WINDOW_COLS];
+    for (int k = k0; k < k1; k++)
+        cols[k - k0] = &s->cols[(first + (uint32_t)k) % VIS_TERRAIN_COLS];
+
+    // One glitch pass per glyph row; columns shorter than the row have no cell
+    for (int row = 0; row < VIS_TERRAIN_MAX_ROWS; row++) {
+        for (int py = 0; py < VIS_TERRAIN_CELL_ROWS; py++) {
+            int y = VIS_HEIGHT - (row + 1) * TILE_SIZE + py * CHAR_H;
+            if (y < 0 || y >= VIS_HEIGHT - CHAR_H) continue;
+            char cells[WINDOW_COLS], glyphs[WINDOW_COLS];
+            uint8_t mask[WINDOW_COLS];
+            bool any = false;
+            for (int i = 0; i < n; i++) {
+                cells[i] = row < cols[i]->height ? cols[i]->glyph[row][py] : 0;
+                any |= cells[i] != 0;
+            }
+            if (!any) continue;
+            vis_glitch_row(VIS_GLITCH_TERRAIN, cells, n, x0, CHAR_W, y, frame, mask, glyphs);
+
+            for (int i = 0; i < n; i++) {
+                char c = glyphs[i];
+                if (c == 0 || c == ' ') continue;
+                int x = x0 + i * CHAR_W;
+                if (mask[i] == VIS_GLITCH_NOISE) {
+                    // Noise on blank cells is dimmed, in the gap colour
+                    draw_ascii_char_asm(pixels, x, y, c, color[SLOT_GAP], 128);
+                    continue;
+                }
+                uint32_t cell_color;
+                switch (cols[i]->type) {
+                case TERRAIN_FLAT:       cell_color = color[k0 + i]; break;
+                case TERRAIN_WALL:       cell_color = color[SLOT_WALL]; break;
+                case TERRAIN_SLOPE_UP:   cell_color = color[SLOT_UP]; break;
+                case TERRAIN_SLOPE_DOWN: cell_color = color[SLOT_DOWN + row * VIS_TERRAIN_CELL_ROWS + py]; break;
+                default:                 cell_color = color[SLOT_GAP]; break;
+                }
+                draw_ascii_char_asm(pixels, x, y, c, cell_color, 255);
+            }
+        }
+    }
+}
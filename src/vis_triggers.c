@@ -0,0 +1,68 @@
+#include "include/vis_triggers.h"
+#include "include/deterministic_prng.h"
+#include <math.h>
+
+// Event types, as the sidecar numbers them (timeline.h)
+enum { TL_KICK = 0, TL_MELODY = 3, TL_FM_BASS = 5 };
+
+// From the asm modules (src/asm/visual)
+extern void spawn_explosion_asm(float cx, float cy, float base_hue);
+extern void spawn_bass_hit_asm(float base_hue, uint32_t seed);
+
+bool vis_triggers_init(vis_triggers_t *vt, const timeline_t *tl, uint32_t seed) {
+    vt->tl = tl;
+    vt->seed = seed;
+    if (!tl || !tl->sample_rate) return false;
+    timeline_cursor_init(&vt->kick, tl, TL_KICK);
+    timeline_cursor_init(&vt->melody, tl, TL_MELODY);
+    timeline_cursor_init(&vt->bass, tl, TL_FM_BASS);
+    return true;
+}
+
+// Last sample at or before frame `frame`'s time, +1: the window end
+static uint32_t frame_sample_end(const timeline_t *tl, int frame, int fps) {
+    if (frame < 0) return 0;
+    uint64_t s = (uint64_t)frame * tl->sample_rate / (uint64_t)fps + 1;
+    return s > UINT32_MAX ? UINT32_MAX : (uint32_t)s;
+}
+
+// The onset burst: 5-20 explosions over the whole screen
+static void spawn_kick(uint32_t seed, uint32_t t, float level, float base_hue) {
+    int count = (int)(level * 15) + 5;
+    for (int i = 0; i < count; i++) {
+        uint32_t n = (uint32_t)i * 3;
+        float cx = prng_at_range(seed, PRNG_STREAM_AV_EVENTS, t, n, 800);
+        float cy = prng_at_range(seed, PRNG_STREAM_AV_EVENTS, t, n + 1, 600);
+        float hue = fmodf(base_hue + i * 0.08f + prng_at_range(seed, PRNG_STREAM_AV_EVENTS, t, n + 2, 100) / 100.0f, 1.0f);
+        spawn_explosion_asm(cx, cy, hue);
+    }
+}
+
+// One explosion in the upper half, opposite the base hue
+static void spawn_melody(uint32_t seed, uint32_t t, float base_hue) {
+    float cx = prng_at_range(seed, PRNG_STREAM_AV_EVENTS, t, 64, 800);
+    float cy = 60 + prng_at_range(seed, PRNG_STREAM_AV_EVENTS, t, 65, 240);
+    spawn_explosion_asm(cx, cy, fmodf(base_hue + 0.5f, 1.0f));
+}
+
+void vis_triggers_frame(vis_triggers_t *vt, int frame, int fps, float level, float base_hue) {
+    const timeline_t *tl = vt->tl;
+    if (!tl || !tl->sample_rate || fps <= 0) return;
+    uint32_t t0 = frame_sample_end(tl, frame - 1, fps);
+    uint32_t t1 = frame_sample_end(tl, frame, fps);
+    if (t1 <= t0) return;
+
+    const uint32_t *times;
+    uint32_t n = timeline_events_in_window(&vt->kick, t0, t1, &times, NULL);
+    for (uint32_t i = 0; i < n; i++) spawn_kick(vt->seed, times[i], level, base_hue);
+
+    n = timeline_events_in_window(&vt->melody, t0, t1, &times, NULL);
+    for (uint32_t i = 0; i < n; i++) spawn_melody(vt->seed, times[i], base_hue);
+
+    // The shape follows the step the note is on, as the step clock seeded it
+    n = timeline_events_in_window(&vt->bass, t0, t1, &times, NULL);
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t step = tl->step_samples ? times[i] / tl->step_samples : 0;
+        spawn_bass_hit_asm(base_hue, vt->seed + step);
+    }
+}
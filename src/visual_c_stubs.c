@@ -4,9 +4,10 @@
 #include <stdbool.h>
 #include <math.h>
 #include "include/visual_types.h"
+#include "include/deterministic_prng.h"
+#include "include/vis_color.h"
 
 // External ASM visual functions we can use
-extern uint32_t circle_color_asm(float hue, float saturation, float value);
 extern void draw_circle_filled_asm(uint32_t *pixels, int cx, int cy, int radius, uint32_t color);
 extern void draw_ascii_string_asm(uint32_t *pixels, int x, int y, const char *text, uint32_t color, int bg_alpha);
 
@@ -25,7 +26,7 @@ void draw_centerpiece(uint32_t *pixels, centerpiece_t *centerpiece, float time,
         int orb_radius = 8 + (int)(level * 15);
         
         float hue = fmod(centerpiece->base_hue + i * 0.15f + level * 0.1f, 1.0f);
-        uint32_t color = circle_color_asm(hue, 0.9f, 0.8f + level * 0.2f);
+        uint32_t color = vis_hsv_pixel(hue, 0.9f, 0.8f + level * 0.2f);
         
         draw_circle_filled_asm(pixels, cx, cy, orb_radius, color);
     }
@@ -46,21 +47,19 @@ void init_centerpiece(centerpiece_t *centerpiece, uint32_t seed, int bpm) {
     centerpiece->orbit_speed = 0.5f;
     
     // Vary based on seed
-    srand(seed);
-    centerpiece->base_hue = (rand() % 100) / 100.0f;
-    centerpiece->orbit_speed = 0.3f + (rand() % 50) / 100.0f;
+    centerpiece->base_hue = prng_at_range(seed, PRNG_STREAM_VISUAL, 0, 0, 100) / 100.0f;
+    centerpiece->orbit_speed = 0.3f + prng_at_range(seed, PRNG_STREAM_VISUAL, 0, 1, 50) / 100.0f;
 }
 
 void init_degradation_effects(degradation_t *effects, uint32_t seed) {
     // Simple degradation effects based on seed
-    srand(seed);
-    effects->persistence = 0.8f + (rand() % 20) / 100.0f;
-    effects->scanline_alpha = 50 + (rand() % 100);
-    effects->chroma_shift = rand() % 5;
-    effects->noise_pixels = rand() % 1000;
-    effects->jitter_amount = (rand() % 10) / 100.0f;
+    effects->persistence = 0.8f + prng_at_range(seed, PRNG_STREAM_EFFECTS, 0, 0, 20) / 100.0f;
+    effects->scanline_alpha = 50 + prng_at_range(seed, PRNG_STREAM_EFFECTS, 0, 1, 100);
+    effects->chroma_shift = prng_at_range(seed, PRNG_STREAM_EFFECTS, 0, 2, 5);
+    effects->noise_pixels = prng_at_range(seed, PRNG_STREAM_EFFECTS, 0, 3, 1000);
+    effects->jitter_amount = prng_at_range(seed, PRNG_STREAM_EFFECTS, 0, 4, 10) / 100.0f;
     effects->frame_drop_chance = 0.01f;
-    effects->color_bleed = 0.1f + (rand() % 20) / 100.0f;
+    effects->color_bleed = 0.1f + prng_at_range(seed, PRNG_STREAM_EFFECTS, 0, 5, 20) / 100.0f;
 }
 
 // 🔥 CHAOS MODE STUB - Temporary fallback
@@ -0,0 +1,110 @@
+#include "include/wav_map.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static uint32_t rd_le32(const uint8_t *p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+static uint16_t rd_le16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+// Walk the RIFF chunks of the `len`-byte image at `b`; fills everything
+// but the mapping fields
+static bool wav_parse(const uint8_t *b, size_t len, const char *name, wav_map_t *out) {
+    if (memcmp(b, "RIFF", 4) != 0 || memcmp(b + 8, "WAVE", 4) != 0) {
+        fprintf(stderr, "wav_map: %s is not a RIFF/WAVE file\n", name);
+        return false;
+    }
+
+    // Walk the chunks; sizes are even-padded per RIFF
+    uint16_t format = 0;
+    bool have_fmt = false;
+    const uint8_t *data = NULL;
+    uint32_t data_size = 0;
+    size_t off = 12;
+    while (off + 8 <= len) {
+        const uint8_t *c = b + off;
+        uint32_t size = rd_le32(c + 4);
+        size_t body = off + 8;
+        size_t avail = len - body;
+        if (memcmp(c, "fmt ", 4) == 0 && size >= 16 && avail >= 16) {
+            format = rd_le16(c + 8);
+            out->channels = rd_le16(c + 10);
+            out->sample_rate = rd_le32(c + 12);
+            out->bits_per_sample = rd_le16(c + 22);
+            have_fmt = true;
+        } else if (memcmp(c, "data", 4) == 0) {
+            data = c + 8;
+            // a streamed file whose header was never patched reads as 0 / too long
+            data_size = (size == 0 || size > avail) ? (uint32_t)avail : size;
+            size = data_size;
+        } else if (memcmp(c, "smpl", 4) == 0 && size >= 36 + 24 && avail >= 36 + 24) {
+            if (rd_le32(c + 8 + 28) >= 1) {
+                uint32_t start = rd_le32(c + 8 + 44), end = rd_le32(c + 8 + 48);
+                if (end >= start) {
+                    out->has_loop = true;
+                    out->loop_start = start;
+                    out->loop_end = end + 1;   // smpl stores the last frame inclusive
+                }
+            }
+        }
+        if ((size_t)size > avail) break;
+        off = body + size + (size & 1);
+    }
+
+    if (!have_fmt || !data || format != 1 || out->bits_per_sample != 16 || out->channels == 0) {
+        fprintf(stderr, "wav_map: %s is not 16-bit PCM\n", name);
+        memset(out, 0, sizeof(*out));
+        return false;
+    }
+    out->samples = (const int16_t *)data;
+    out->sample_count = data_size / 2;
+    out->frames = out->sample_count / out->channels;
+    if (out->has_loop && out->loop_end > out->frames) out->has_loop = false;
+    return true;
+}
+
+bool wav_map_open(const char *path, wav_map_t *out) {
+    memset(out, 0, sizeof(*out));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "wav_map: could not open %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 12) {
+        fprintf(stderr, "wav_map: %s is too short\n", path);
+        close(fd);
+        return false;
+    }
+    size_t len = (size_t)st.st_size;
+    void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "wav_map: mmap failed for %s\n", path);
+        return false;
+    }
+    if (!wav_parse((const uint8_t *)map, len, path, out)) {
+        munmap(map, len);
+        return false;
+    }
+    out->map = map;
+    out->map_len = len;
+    return true;
+}
+
+bool wav_map_memory(const void *data, size_t len, const char *name, wav_map_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (!data || len < 12) {
+        fprintf(stderr, "wav_map: %s is too short\n", name);
+        return false;
+    }
+    return wav_parse((const uint8_t *)data, len, name, out);
+}
+
+void wav_map_close(wav_map_t *w) {
+    if (!w) return;
+    if (w->map) munmap(w->map, w->map_len);
+    memset(w, 0, sizeof(*w));
+}
@@ -6,40 +6,28 @@
 #include <math.h>
 #include <SDL.h>
 #include "include/visual_types.h"
-
-// WAV file header structure
-typedef struct {
-    char riff[4];           // "RIFF"
-    uint32_t chunk_size;    // File size - 8
-    char wave[4];           // "WAVE"
-    char fmt[4];            // "fmt "
-    uint32_t fmt_size;      // Format chunk size
-    uint16_t audio_format;  // Audio format (1 = PCM)
-    uint16_t num_channels;  // Number of channels
-    uint32_t sample_rate;   // Sample rate
-    uint32_t byte_rate;     // Byte rate
-    uint16_t block_align;   // Block align
-    uint16_t bits_per_sample; // Bits per sample
-    char data[4];           // "data"
-    uint32_t data_size;     // Data size
-} wav_header_t;
+#include "include/wav_map.h"
+#include "include/audio_features.h"
 
 // Audio analysis data
 typedef struct {
-    int16_t *samples;       // Raw audio samples (stereo interleaved)
+    const int16_t *samples; // Raw audio samples (stereo interleaved), view into `wav`
     uint32_t sample_count;  // Total samples (left + right)
     uint32_t sample_rate;   // Sample rate (44100)
     uint16_t channels;      // Number of channels (2 for stereo)
     uint16_t bits_per_sample; // Bits per sample (16)
     
     // Analysis data
-    float *rms_levels;      // RMS levels per video frame
+    float *rms_levels;      // RMS levels per video frame (features.rms)
+    float max_rms;          // Largest of rms_levels
     uint32_t num_frames;    // Number of video frames
     float duration_sec;     // Total duration in seconds
     float bpm;              // Detected BPM (if available)
 } audio_data_t;
 
 static audio_data_t audio_data = {0};
+static wav_map_t wav = {0};             // mapped file backing audio_data.samples
+static audio_features_t features = {0}; // per-frame analysis, owns rms_levels
 static bool audio_loaded = false;
 static SDL_AudioDeviceID audio_device = 0;
 static uint32_t audio_position = 0; // Current playback position in samples
@@ -74,101 +62,47 @@ static void audio_callback(void *userdata, Uint8 *stream, int len) {
 
 // Load WAV file and extract audio data
 bool load_wav_file(const char *filename) {
-    FILE *file = fopen(filename, "rb");
-    if (!file) {
-        printf("Error: Could not open WAV file: %s\n", filename);
-        return false;
-    }
-    
-    wav_header_t header;
-    size_t read_bytes = fread(&header, sizeof(header), 1, file);
-    if (read_bytes != 1) {
-        printf("Error: Could not read WAV header\n");
-        fclose(file);
-        return false;
-    }
-    
-    // Validate WAV header
-    if (strncmp(header.riff, "RIFF", 4) != 0 || 
-        strncmp(header.wave, "WAVE", 4) != 0 ||
-        strncmp(header.fmt, "fmt ", 4) != 0 ||
-        strncmp(header.data, "data", 4) != 0) {
-        printf("Error: Invalid WAV file format\n");
-        fclose(file);
+    // Map the file and point at its data chunk: no copy of the samples
+    if (!wav_map_open(filename, &wav)) {
+        printf("Error: Could not load WAV file: %s\n", filename);
         return false;
     }
     
     // Store audio parameters
-    audio_data.sample_rate = header.sample_rate;
-    audio_data.channels = header.num_channels;
-    audio_data.bits_per_sample = header.bits_per_sample;
-    audio_data.sample_count = header.data_size / (header.bits_per_sample / 8);
-    audio_data.duration_sec = (float)audio_data.sample_count / header.num_channels / header.sample_rate;
+    audio_data.samples = wav.samples;
+    audio_data.sample_rate = wav.sample_rate;
+    audio_data.channels = wav.channels;
+    audio_data.bits_per_sample = wav.bits_per_sample;
+    audio_data.sample_count = wav.sample_count;
+    audio_data.duration_sec = (float)wav.frames / wav.sample_rate;
     
     printf("WAV Info: %d Hz, %d channels, %d bits, %.2f seconds\n", 
            audio_data.sample_rate, audio_data.channels, 
            audio_data.bits_per_sample, audio_data.duration_sec);
     
     // Only support 16-bit stereo for now
-    if (header.bits_per_sample != 16 || header.num_channels != 2) {
+    if (wav.channels != 2) {
         printf("Error: Only 16-bit stereo WAV files supported\n");
-        fclose(file);
+        wav_map_close(&wav);
         return false;
     }
     
-    // Allocate memory for samples
-    audio_data.samples = malloc(header.data_size);
-    if (!audio_data.samples) {
-        printf("Error: Could not allocate memory for audio samples\n");
-        fclose(file);
-        return false;
-    }
-    
-    // Read audio data
-    read_bytes = fread(audio_data.samples, header.data_size, 1, file);
-    if (read_bytes != 1) {
-        printf("Error: Could not read audio data\n");
-        free(audio_data.samples);
-        fclose(file);
-        return false;
-    }
-    
-    fclose(file);
+    bool has_loop = wav.has_loop;
+    uint32_t smpl_start = wav.loop_start, smpl_end = wav.loop_end;
     
-    // Calculate RMS levels per video frame
-    audio_data.num_frames = (uint32_t)(audio_data.duration_sec * VIS_FPS);
-    audio_data.rms_levels = malloc(audio_data.num_frames * sizeof(float));
-    if (!audio_data.rms_levels) {
+    // Level and bass/treble bands of every video frame in one pass
+    uint32_t num_frames = (uint32_t)(audio_data.duration_sec * VIS_FPS);
+    if (!audio_features_from_pcm(wav.samples, wav.frames, wav.channels, wav.sample_rate, VIS_FPS,
+                                 num_frames, &features)) {
         printf("Error: Could not allocate memory for RMS levels\n");
-        free(audio_data.samples);
+        wav_map_close(&wav);
         return false;
     }
-    
-    // Calculate RMS for each video frame
-    uint32_t samples_per_frame = audio_data.sample_rate / VIS_FPS;
+    audio_data.num_frames = features.frames;
+    audio_data.rms_levels = features.rms;
+    audio_data.max_rms = 0.0f;
     for (uint32_t frame = 0; frame < audio_data.num_frames; frame++) {
-        uint32_t start_sample = frame * samples_per_frame * audio_data.channels;
-        uint32_t end_sample = start_sample + samples_per_frame * audio_data.channels;
-        
-        if (end_sample > audio_data.sample_count) {
-            end_sample = audio_data.sample_count;
-        }
-        
-        // Calculate RMS for this frame
-        float sum_squares = 0.0f;
-        uint32_t sample_count = 0;
-        
-        for (uint32_t i = start_sample; i < end_sample; i++) {
-            float sample = audio_data.samples[i] / 32768.0f; // Normalize to -1.0 to 1.0
-            sum_squares += sample * sample;
-            sample_count++;
-        }
-        
-        if (sample_count > 0) {
-            audio_data.rms_levels[frame] = sqrtf(sum_squares / sample_count);
-        } else {
-            audio_data.rms_levels[frame] = 0.0f;
-        }
+        if (audio_data.rms_levels[frame] > audio_data.max_rms) audio_data.max_rms = audio_data.rms_levels[frame];
     }
     
     // Try to extract BPM from filename (our audio system outputs BPM info)
@@ -177,6 +111,32 @@ bool load_wav_file(const char *filename) {
     printf("Audio analysis complete: %d frames, %.3f avg RMS\n", 
            audio_data.num_frames, audio_data.rms_levels[0]);
     
+    float musical_duration;
+    if (has_loop) {
+        // Exact loop region from the renderer's smpl chunk
+        musical_content_samples = smpl_end * audio_data.channels;
+        loop_point_samples = smpl_start * audio_data.channels;
+        musical_duration = (float)smpl_end / audio_data.sample_rate;
+    } else {
+        // Calculate musical content length based on BPM and structure  
+        // Our audio system generates 8 bars of music, but let's use a more conservative estimate
+        // The delay tail is probably the last 1.5-2 seconds, so loop the first ~7.5 seconds
+        musical_duration = audio_data.duration_sec * 0.8f; // Use 80% of total duration
+        
+        musical_content_samples = (uint32_t)(musical_duration * audio_data.sample_rate * audio_data.channels);
+        
+        // Make sure we don't exceed the actual audio length
+        if (musical_content_samples > audio_data.sample_count) {
+            musical_content_samples = audio_data.sample_count;
+        }
+        
+        loop_point_samples = 0; // Loop back to the very beginning
+    }
+    
+    printf("Musical content: %.2f seconds (%d samples), Full audio: %.2f seconds\n", 
+           musical_duration, musical_content_samples, audio_data.duration_sec);
+    printf("Will loop musical content, letting delay tail ring through naturally\n");
+    
     // Initialize SDL audio for playback
     if (SDL_WasInit(SDL_INIT_AUDIO) == 0) {
         if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
@@ -203,47 +163,41 @@ bool load_wav_file(const char *filename) {
     
     printf("Audio playback initialized: %d Hz, %d channels\n", have.freq, have.channels);
     
-    // Calculate musical content length based on BPM and structure  
-    // Our audio system generates 8 bars of music, but let's use a more conservative estimate
-    // The delay tail is probably the last 1.5-2 seconds, so loop the first ~7.5 seconds
-    float musical_duration = audio_data.duration_sec * 0.8f; // Use 80% of total duration
-    
-    musical_content_samples = (uint32_t)(musical_duration * audio_data.sample_rate * audio_data.channels);
-    
-    // Make sure we don't exceed the actual audio length
-    if (musical_content_samples > audio_data.sample_count) {
-        musical_content_samples = audio_data.sample_count;
-    }
-    
-    loop_point_samples = 0; // Loop back to the very beginning
-    
-    printf("Musical content: %.2f seconds (%d samples), Full audio: %.2f seconds\n", 
-           musical_duration, musical_content_samples, audio_data.duration_sec);
-    printf("Will loop musical content, letting delay tail ring through naturally\n");
-    
     audio_loaded = true;
     return true;
 }
 
-// Get RMS level for a specific frame (with looping)
-float get_audio_rms_for_frame(int frame) {
-    if (!audio_loaded || audio_data.num_frames == 0) {
-        return 0.0f;
-    }
-    
+// Video frame whose analysis plays at `frame`, following the playback loop
+static int looped_frame(int frame) {
     // Calculate how many frames represent the musical content
     float musical_duration = (float)musical_content_samples / audio_data.sample_rate / audio_data.channels;
     int musical_frames = (int)(musical_duration * VIS_FPS);
+    int loop_frame = (int)((float)loop_point_samples / audio_data.sample_rate / audio_data.channels * VIS_FPS);
     
-    if (musical_frames > 0 && musical_frames < (int)audio_data.num_frames) {
-        // Loop only the musical content frames
-        int looped_frame = frame % musical_frames;
-        return audio_data.rms_levels[looped_frame];
-    } else {
-        // Fallback to full audio loop
-        int looped_frame = frame % audio_data.num_frames;
-        return audio_data.rms_levels[looped_frame];
+    if (musical_frames > loop_frame && musical_frames < (int)audio_data.num_frames) {
+        // Loop only the musical content frames, re-entering at the loop point
+        return frame < musical_frames ? frame
+             : loop_frame + (frame - musical_frames) % (musical_frames - loop_frame);
     }
+    // Fallback to full audio loop
+    return frame % audio_data.num_frames;
+}
+
+// Get RMS level for a specific frame (with looping)
+float get_audio_rms_for_frame(int frame) {
+    if (!audio_loaded || audio_data.num_frames == 0) {
+        return 0.0f;
+    }
+    return audio_data.rms_levels[looped_frame(frame)];
+}
+
+// Bass/treble band levels (0..1) for a frame (with looping)
+bool get_audio_bands_for_frame(int frame, float *bass, float *treble) {
+    if (!audio_loaded || audio_data.num_frames == 0 || frame < 0) return false;
+    int f = looped_frame(frame);
+    *bass = features.bass[f];
+    *treble = features.treble[f];
+    return true;
 }
 
 // Get current audio time for frame
@@ -271,14 +225,7 @@ bool is_audio_finished(int frame) {
 // Get max RMS for normalization
 float get_max_rms(void) {
     if (!audio_loaded) return 1.0f;
-    
-    float max_rms = 0.0f;
-    for (uint32_t i = 0; i < audio_data.num_frames; i++) {
-        if (audio_data.rms_levels[i] > max_rms) {
-            max_rms = audio_data.rms_levels[i];
-        }
-    }
-    return max_rms > 0.0f ? max_rms : 1.0f;
+    return audio_data.max_rms > 0.0f ? audio_data.max_rms : 1.0f;
 }
 
 // Start audio playback
@@ -312,8 +259,8 @@ void cleanup_audio_data(void) {
     }
     
     if (audio_loaded) {
-        free(audio_data.samples);
-        free(audio_data.rms_levels);
+        wav_map_close(&wav);
+        audio_features_free(&features);
         memset(&audio_data, 0, sizeof(audio_data));
         audio_loaded = false;
     }
@@ -0,0 +1,85 @@
+#!/bin/bash
+
+# verify_nft.sh - Reproducibility check for a generated NFT
+# Re-renders the audio and every frame of <tx_hash> with --digest and
+# compares the digest manifests generate_nft.sh saved next to the video.
+# Nothing is encoded and no PPM frames are written: the MP4 is not
+# byte-stable across ffmpeg versions, the PCM and the framebuffers are.
+#
+# Usage: ./verify_nft.sh <tx_hash> [output_dir] [--record]
+#   --record  (re)write the reference digests instead of comparing
+# Exit status: 0 identical, 1 divergence (first differing second/frame shown)
+
+set -e
+
+TX_HASH=""
+OUTPUT_DIR="./nft_output"
+RECORD=0
+for arg in "$@"; do
+    case "$arg" in
+        --record) RECORD=1 ;;
+        *) if [ -z "$TX_HASH" ]; then TX_HASH="$arg"; else OUTPUT_DIR="$arg"; fi ;;
+    esac
+done
+if [ -z "$TX_HASH" ]; then
+    echo "Usage: $0 <tx_hash> [output_dir] [--record]" >&2
+    exit 2
+fi
+
+SEED="$TX_HASH"
+SCRIPT_DIR=$(cd "$(dirname "$0")" && pwd)
+AUDIO_DIGEST="$OUTPUT_DIR/${TX_HASH}_audio.digest"
+FRAMES_DIGEST="$OUTPUT_DIR/${TX_HASH}_frames.digest"
+
+[ -x "$SCRIPT_DIR/src/c/bin/segment" ] || make -C "$SCRIPT_DIR/src/c" segment >/dev/null
+[ -x "$SCRIPT_DIR/generate_frames" ] || make -C "$SCRIPT_DIR" generate_frames >/dev/null
+
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/verify_nft.XXXXXX")
+trap 'rm -rf "$WORK"' EXIT
+
+# First differing part line of two manifests, or nothing when identical
+first_divergence() {
+    diff <(sed '$d' "$1") <(sed '$d' "$2") | grep -m1 '^[<>] [af] ' | cut -c3- || true
+}
+
+# Audio: the same render generate_nft.sh ships (--repeat 6).  The WAV is
+# kept in the work dir only because generate_frames reads its input from a file.
+echo "🎵 Hashing audio for $SEED..."
+"$SCRIPT_DIR/src/c/bin/segment" --repeat 6 --digest "$WORK/audio.digest" "$SEED" "$WORK/audio.wav" >/dev/null 2>&1
+
+echo "🖼️  Hashing frames..."
+(cd "$WORK" && "$SCRIPT_DIR/generate_frames" "$WORK/audio.wav" "$SEED" \
+    --digest "$WORK/frames.digest" --digest-only >/dev/null 2>&1)
+
+if [ "$RECORD" = 1 ]; then
+    mkdir -p "$OUTPUT_DIR"
+    cp "$WORK/audio.digest" "$AUDIO_DIGEST"
+    cp "$WORK/frames.digest" "$FRAMES_DIGEST"
+    echo "📋 Recorded $AUDIO_DIGEST and $FRAMES_DIGEST"
+    exit 0
+fi
+
+status=0
+for kind in audio frames; do
+    ref="$OUTPUT_DIR/${TX_HASH}_$kind.digest"
+    if [ ! -f "$ref" ]; then
+        echo "❌ Missing $ref (run generate_nft.sh, or $0 $TX_HASH $OUTPUT_DIR --record)" >&2
+        exit 2
+    fi
+    if cmp -s "$ref" "$WORK/$kind.digest"; then
+        echo "✅ $kind identical: $(tail -n 1 "$ref")"
+        continue
+    fi
+    status=1
+    part=$(first_divergence "$ref" "$WORK/$kind.digest")
+    if [ -n "$part" ]; then
+        set -- $part
+        [ "$1" = a ] && what="second $2 of the audio" || what="frame $2"
+        echo "❌ $kind differs, first at $what"
+    else
+        echo "❌ $kind differs in length or header:"
+        echo "   reference: $(tail -n 1 "$ref")"
+        echo "   now:       $(tail -n 1 "$WORK/$kind.digest")"
+    fi
+done
+exit $status